@@ -531,6 +531,10 @@ struct VideoCodecVP8
     bool                 automaticResizeOn;
     bool                 frameDroppingOn;
     int                  keyFrameInterval;
+    // Encoder threads; 0 picks a count from the cores and the frame size.
+    int                  numberOfThreads;
+    // Token partitions (1, 2, 4 or 8); 0 uses one per encoder thread.
+    int                  numberOfTokenPartitions;
 };
 
 // Unknown specific
@@ -73,19 +73,24 @@ template<typename T>
 void AudioMultiVector<T>::PushBackInterleaved(const T* append_this,
                                               size_t length) {
   assert(length % Channels() == 0);
+  if (Channels() == 1) {
+    // Nothing to de-interleave.
+    channels_[0]->PushBack(append_this, length);
+    return;
+  }
   size_t length_per_channel = length / Channels();
-  T* temp_array = new T[length_per_channel];  // Intermediate storage.
   for (size_t channel = 0; channel < Channels(); ++channel) {
-    // Copy elements to |temp_array|.
+    // Extend the channel and de-interleave directly into the new elements.
+    AudioVector<T>& channel_vector = *channels_[channel];
+    size_t write_index = channel_vector.Size();
+    channel_vector.Extend(length_per_channel);
     // Set |source_ptr| to first element of this channel.
     const T* source_ptr = &append_this[channel];
     for (size_t i = 0; i < length_per_channel; ++i) {
-      temp_array[i] = *source_ptr;
+      channel_vector[write_index + i] = *source_ptr;
       source_ptr += Channels();  // Jump to next element of this channel.
     }
-    channels_[channel]->PushBack(temp_array, length_per_channel);
   }
-  delete [] temp_array;
 }
 
 template<typename T>
@@ -11,6 +11,7 @@
 #include "webrtc/modules/audio_coding/neteq4/audio_vector.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include <algorithm>
 
@@ -18,22 +19,39 @@
 
 namespace webrtc {
 
+template<typename T>
+AudioVector<T>::AudioVector()
+    : capacity_(0),
+      begin_index_(0),
+      end_index_(0) {
+}
+
+template<typename T>
+AudioVector<T>::AudioVector(size_t initial_size)
+    : array_(new T[initial_size]),
+      capacity_(initial_size),
+      begin_index_(0),
+      end_index_(initial_size) {
+  std::fill(array_.get(), array_.get() + initial_size, T(0));
+}
+
 template<typename T>
 void AudioVector<T>::Clear() {
-  vector_.clear();
+  begin_index_ = end_index_ = capacity_ / 2;
 }
 
 template<typename T>
 void AudioVector<T>::CopyFrom(AudioVector<T>* copy_to) const {
-  if (copy_to) {
-    copy_to->vector_.assign(vector_.begin(), vector_.end());
+  if (copy_to && copy_to != this) {
+    copy_to->Clear();
+    copy_to->PushBack(array_.get() + begin_index_, Size());
   }
 }
 
 template<typename T>
 void AudioVector<T>::PushFront(const AudioVector<T>& prepend_this) {
-  vector_.insert(vector_.begin(), prepend_this.vector_.begin(),
-                 prepend_this.vector_.end());
+  InsertAt(prepend_this.array_.get() + prepend_this.begin_index_,
+           prepend_this.Size(), 0);
 }
 
 template<typename T>
@@ -44,75 +62,58 @@ void AudioVector<T>::PushFront(const T* prepend_this, size_t length) {
 
 template<typename T>
 void AudioVector<T>::PushBack(const AudioVector<T>& append_this) {
-  vector_.reserve(vector_.size() + append_this.Size());
-  for (size_t i = 0; i < append_this.Size(); ++i) {
-    vector_.push_back(append_this[i]);
-  }
+  PushBack(append_this.array_.get() + append_this.begin_index_,
+           append_this.Size());
 }
 
 template<typename T>
 void AudioVector<T>::PushBack(const T* append_this, size_t length) {
-  vector_.reserve(vector_.size() + length);
-  for (size_t i = 0; i < length; ++i) {
-    vector_.push_back(append_this[i]);
-  }
+  InsertAt(append_this, length, Size());
 }
 
 template<typename T>
 void AudioVector<T>::PopFront(size_t length) {
-  if (length >= vector_.size()) {
-    // Remove all elements.
-    vector_.clear();
-  } else {
-    typename std::vector<T>::iterator end_range = vector_.begin();
-    end_range += length;
-    // Erase all elements in range vector_.begin() and |end_range| (not
-    // including |end_range|).
-    vector_.erase(vector_.begin(), end_range);
+  begin_index_ += std::min(length, Size());
+  if (Empty()) {
+    // Start over from the middle, to have room in both directions.
+    Clear();
   }
 }
 
 template<typename T>
 void AudioVector<T>::PopBack(size_t length) {
-  // Make sure that new_size is never negative (which causes wrap-around).
-  size_t new_size = vector_.size() - std::min(length, vector_.size());
-  vector_.resize(new_size);
+  // Make sure that the new size is never negative (which causes wrap-around).
+  end_index_ -= std::min(length, Size());
 }
 
 template<typename T>
 void AudioVector<T>::Extend(size_t extra_length) {
-  vector_.insert(vector_.end(), extra_length, 0);
+  InsertZerosAt(extra_length, Size());
 }
 
 template<typename T>
 void AudioVector<T>::InsertAt(const T* insert_this,
                               size_t length,
                               size_t position) {
-  typename std::vector<T>::iterator insert_position = vector_.begin();
-  // Cap the position at the current vector length, to be sure the iterator
-  // does not extend beyond the end of the vector.
-  position = std::min(vector_.size(), position);
-  insert_position += position;
-  // First, insert zeros at the position. This makes the vector longer (and
-  // invalidates the iterator |insert_position|.
-  vector_.insert(insert_position, length, 0);
-  // Write the new values into the vector.
-  for (size_t i = 0; i < length; ++i) {
-    vector_[position + i] = insert_this[i];
-  }
+  if (length == 0)
+    return;
+  // Cap the position at the current vector length.
+  position = std::min(Size(), position);
+  InsertGap(length, position);
+  memcpy(array_.get() + begin_index_ + position, insert_this,
+         length * sizeof(T));
 }
 
 template<typename T>
 void AudioVector<T>::InsertZerosAt(size_t length,
                                    size_t position) {
-  typename std::vector<T>::iterator insert_position = vector_.begin();
-  // Cap the position at the current vector length, to be sure the iterator
-  // does not extend beyond the end of the vector.
-  position = std::min(vector_.size(), position);
-  insert_position += position;
-  // Insert zeros at the position. This makes the vector longer (and
-  // invalidates the iterator |insert_position|.
-  vector_.insert(insert_position, length, 0);
+  if (length == 0)
+    return;
+  // Cap the position at the current vector length.
+  position = std::min(Size(), position);
+  InsertGap(length, position);
+  T* insert_position = array_.get() + begin_index_ + position;
+  std::fill(insert_position, insert_position + length, T(0));
 }
 
 template<typename T>
@@ -120,14 +121,15 @@ void AudioVector<T>::OverwriteAt(const T* insert_this,
                                  size_t length,
                                  size_t position) {
   // Cap the insert position at the current vector length.
-  position = std::min(vector_.size(), position);
+  position = std::min(Size(), position);
   // Extend the vector if needed. (It is valid to overwrite beyond the current
   // end of the vector.)
-  if (position + length > vector_.size()) {
-    Extend(position + length - vector_.size());
+  if (position + length > Size()) {
+    Extend(position + length - Size());
   }
-  for (size_t i = 0; i < length; ++i) {
-    vector_[position + i] = insert_this[i];
+  if (length > 0) {
+    memmove(array_.get() + begin_index_ + position, insert_this,
+            length * sizeof(T));
   }
 }
 
@@ -148,7 +150,7 @@ void AudioVector<T>::CrossFade(const AudioVector<T>& append_this,
   int alpha = 16384;
   for (size_t i = 0; i < fade_length; ++i) {
     alpha -= alpha_step;
-    vector_[position + i] = (alpha * vector_[position + i] +
+    (*this)[position + i] = (alpha * (*this)[position + i] +
         (16384 - alpha) * append_this[i] + 8192) >> 14;
   }
   assert(alpha >= 0);  // Verify that the slope was correct.
@@ -178,7 +180,7 @@ void AudioVector<double>::CrossFade(const AudioVector<double>& append_this,
   int alpha = 16384;
   for (size_t i = 0; i < fade_length; ++i) {
     alpha -= alpha_step;
-    vector_[position + i] = (alpha * vector_[position + i] +
+    (*this)[position + i] = (alpha * (*this)[position + i] +
         (16384 - alpha) * append_this[i]) / 16384;
   }
   assert(alpha >= 0);  // Verify that the slope was correct.
@@ -190,12 +192,59 @@ void AudioVector<double>::CrossFade(const AudioVector<double>& append_this,
 
 template<typename T>
 const T& AudioVector<T>::operator[](size_t index) const {
-  return vector_[index];
+  return array_.get()[begin_index_ + index];
 }
 
 template<typename T>
 T& AudioVector<T>::operator[](size_t index) {
-  return vector_[index];
+  return array_.get()[begin_index_ + index];
+}
+
+template<typename T>
+void AudioVector<T>::InsertGap(size_t length, size_t position) {
+  const size_t size = Size();
+  assert(position <= size);
+  // Move the elements before |position| if they are fewer than the elements
+  // after it.
+  const bool move_front = position < size - position;
+  if ((move_front && begin_index_ < length) ||
+      (!move_front && end_index_ + length > capacity_)) {
+    Recenter(length);
+  }
+  T* data = array_.get() + begin_index_;
+  if (move_front) {
+    memmove(data - length, data, position * sizeof(T));
+    begin_index_ -= length;
+  } else {
+    memmove(data + position + length, data + position,
+            (size - position) * sizeof(T));
+    end_index_ += length;
+  }
+}
+
+template<typename T>
+void AudioVector<T>::Recenter(size_t length) {
+  const size_t size = Size();
+  if (capacity_ < size + 2 * length) {
+    // Leave as much free space as there are elements, so that the following
+    // operations can be done in place.
+    const size_t new_capacity = 2 * (size + length);
+    T* new_array = new T[new_capacity];
+    const size_t new_begin_index = (new_capacity - size) / 2;
+    if (size > 0) {
+      memcpy(new_array + new_begin_index, array_.get() + begin_index_,
+             size * sizeof(T));
+    }
+    array_.reset(new_array);
+    capacity_ = new_capacity;
+    begin_index_ = new_begin_index;
+  } else {
+    const size_t new_begin_index = (capacity_ - size) / 2;
+    memmove(array_.get() + new_begin_index, array_.get() + begin_index_,
+            size * sizeof(T));
+    begin_index_ = new_begin_index;
+  }
+  end_index_ = begin_index_ + size;
 }
 
 // Instantiate the template for a few types.
@@ -12,21 +12,25 @@
 #define WEBRTC_MODULES_AUDIO_CODING_NETEQ4_AUDIO_VECTOR_H_
 
 #include <cstring>  // Access to size_t.
-#include <vector>
 
 #include "webrtc/system_wrappers/interface/constructor_magic.h"
+#include "webrtc/system_wrappers/interface/scoped_ptr.h"
 
 namespace webrtc {
 
+// The elements are kept contiguous in memory, so that a pointer to an element
+// can be handed to the signal processing functions, but they are stored with
+// free space on both sides. This makes PushFront, PopFront, PushBack and
+// PopBack O(1) (amortized), and lets a buffer of constant size, such as the
+// SyncBuffer, slide forward without moving all of its contents every 10 ms.
 template <typename T>
 class AudioVector {
  public:
   // Creates an empty AudioVector.
-  AudioVector() {}
+  AudioVector();
 
   // Creates an AudioVector with an initial size.
-  explicit AudioVector(size_t initial_size)
-      : vector_(initial_size, 0) {}
+  explicit AudioVector(size_t initial_size);
 
   virtual ~AudioVector() {}
 
@@ -86,17 +90,32 @@ class AudioVector {
   virtual void CrossFade(const AudioVector<T>& append_this, size_t fade_length);
 
   // Returns the number of elements in this AudioVector.
-  virtual size_t Size() const { return vector_.size(); }
+  virtual size_t Size() const { return end_index_ - begin_index_; }
 
   // Returns true if this AudioVector is empty.
-  virtual bool Empty() const { return vector_.empty(); }
+  virtual bool Empty() const { return begin_index_ == end_index_; }
 
   // Accesses and modifies an element of AudioVector.
   const T& operator[](size_t index) const;
   T& operator[](size_t index);
 
  private:
-  std::vector<T> vector_;
+  // Makes room for |length| new elements at |position|, by moving whichever
+  // side of |position| is shorter, or by re-centering the contents (and
+  // growing the storage if needed) when there is no room left on that side.
+  // The length of the AudioVector is increased by |length|; the new elements
+  // are not initialized.
+  void InsertGap(size_t length, size_t position);
+
+  // Moves the contents to the middle of the storage, so that there is room for
+  // at least |length| more elements at both ends. The storage is reallocated
+  // if it is too small.
+  void Recenter(size_t length);
+
+  scoped_array<T> array_;
+  size_t capacity_;
+  size_t begin_index_;  // Index in |array_| of the first element.
+  size_t end_index_;  // Index in |array_| one past the last element.
 
   DISALLOW_COPY_AND_ASSIGN(AudioVector);
 };
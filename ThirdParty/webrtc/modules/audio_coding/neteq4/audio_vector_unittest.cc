@@ -14,6 +14,7 @@
 #include <stdlib.h>
 
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "webrtc/typedefs.h"
@@ -405,4 +406,40 @@ TYPED_TEST(AudioVectorTest, CrossFade) {
   }
 }
 
+// Use the vector as a sliding window of constant size, like the SyncBuffer
+// does, and interleave insertions close to both ends. Verify that the contents
+// are kept in order while the storage moves and grows.
+TYPED_TEST(AudioVectorTest, SlidingWindow) {
+  AudioVector<TypeParam> vec;
+  std::vector<TypeParam> reference;
+  TypeParam value = 0;
+  for (int i = 0; i < 200; ++i) {
+    vec.PushBack(this->array_, TestFixture::kLength);
+    reference.insert(reference.end(), this->array_,
+                     this->array_ + TestFixture::kLength);
+    if (i % 7 == 0) {
+      vec.InsertAt(&value, 1, 1);
+      reference.insert(reference.begin() + 1, value);
+      vec.InsertZerosAt(3, vec.Size() - 1);
+      reference.insert(reference.end() - 1, 3, 0);
+    }
+    if (i % 5 == 0) {
+      vec.PushFront(this->array_, 3);
+      reference.insert(reference.begin(), this->array_, this->array_ + 3);
+    }
+    if (reference.size() > 50) {
+      size_t pop_length = reference.size() - 50;
+      vec.PopFront(pop_length);
+      reference.erase(reference.begin(), reference.begin() + pop_length);
+    }
+    ++value;
+    ASSERT_EQ(reference.size(), vec.Size());
+    for (size_t j = 0; j < reference.size(); ++j) {
+      ASSERT_EQ(reference[j], vec[j]);
+    }
+    // The elements must be contiguous in memory.
+    EXPECT_EQ(&vec[0] + vec.Size() - 1, &vec[vec.Size() - 1]);
+  }
+}
+
 }  // namespace webrtc
@@ -68,6 +68,7 @@ NetEqImpl::NetEqImpl(int fs,
       dtmf_tone_generator_(dtmf_tone_generator),
       packet_buffer_(packet_buffer),
       payload_splitter_(payload_splitter),
+      packet_pool_(kMaxPooledPackets),
       timestamp_scaler_(timestamp_scaler),
       vad_(new PostDecodeVad()),
       sync_buffer_(NULL),
@@ -363,20 +364,15 @@ int NetEqImpl::InsertPacketInternal(const WebRtcRTPHeader& rtp_header,
     // Create |packet| within this separate scope, since it should not be used
     // directly once it's been inserted in the packet list. This way, |packet|
     // is not defined outside of this block.
-    Packet* packet = new Packet;
+    Packet* packet = packet_pool_.NewPacket(length_bytes);
     packet->header.markerBit = false;
     packet->header.payloadType = rtp_header.header.payloadType;
     packet->header.sequenceNumber = rtp_header.header.sequenceNumber;
     packet->header.timestamp = rtp_header.header.timestamp;
     packet->header.ssrc = rtp_header.header.ssrc;
     packet->header.numCSRCs = 0;
-    packet->payload_length = length_bytes;
     packet->primary = true;
     packet->waiting_time = 0;
-    packet->payload = new uint8_t[packet->payload_length];
-    if (!packet->payload) {
-      LOG_F(LS_ERROR) << "Payload pointer is NULL.";
-    }
     assert(payload);  // Already checked above.
     memcpy(packet->payload, payload, packet->payload_length);
     // Insert packet in a packet list.
@@ -464,9 +460,7 @@ int NetEqImpl::InsertPacketInternal(const WebRtcRTPHeader& rtp_header,
           return kDtmfInsertError;
         }
       }
-      // TODO(hlundin): Let the destructor of Packet handle the payload.
-      delete [] current_packet->payload;
-      delete current_packet;
+      packet_pool_.DeletePacket(current_packet);
       it = packet_list.erase(it);
     } else {
       ++it;
@@ -591,58 +585,60 @@ int NetEqImpl::GetAudioInternal(size_t max_length, int16_t* output,
   vad_->Update(decoded_buffer_.get(), length, speech_type,
                sid_frame_available, fs_hz_);
 
-  AudioMultiVector<int16_t> algorithm_buffer(sync_buffer_->Channels());
+  // Reuse the algorithm buffer between calls, to avoid reallocating it.
+  AudioMultiVector<int16_t>* algorithm_buffer = algorithm_buffer_.get();
+  algorithm_buffer->Clear();
   switch (operation) {
     case kNormal: {
       DoNormal(decoded_buffer_.get(), length, speech_type, play_dtmf,
-               &algorithm_buffer);
+               algorithm_buffer);
       break;
     }
     case kMerge: {
       DoMerge(decoded_buffer_.get(), length, speech_type, play_dtmf,
-              &algorithm_buffer);
+              algorithm_buffer);
       break;
     }
     case kExpand: {
-      return_value = DoExpand(play_dtmf, &algorithm_buffer);
+      return_value = DoExpand(play_dtmf, algorithm_buffer);
       break;
     }
     case kAccelerate: {
       return_value = DoAccelerate(decoded_buffer_.get(), length, speech_type,
-                                  play_dtmf, &algorithm_buffer);
+                                  play_dtmf, algorithm_buffer);
       break;
     }
     case kPreemptiveExpand: {
       return_value = DoPreemptiveExpand(decoded_buffer_.get(), length,
                                         speech_type, play_dtmf,
-                                        &algorithm_buffer);
+                                        algorithm_buffer);
       break;
     }
     case kRfc3389Cng:
     case kRfc3389CngNoPacket: {
-      return_value = DoRfc3389Cng(&packet_list, play_dtmf, &algorithm_buffer);
+      return_value = DoRfc3389Cng(&packet_list, play_dtmf, algorithm_buffer);
       break;
     }
     case kCodecInternalCng: {
       // This handles the case when there is no transmission and the decoder
       // should produce internal comfort noise.
       // TODO(hlundin): Write test for codec-internal CNG.
-      DoCodecInternalCng(&algorithm_buffer);
+      DoCodecInternalCng(algorithm_buffer);
       break;
     }
     case kDtmf: {
       // TODO(hlundin): Write test for this.
-      return_value = DoDtmf(dtmf_event, &play_dtmf, &algorithm_buffer);
+      return_value = DoDtmf(dtmf_event, &play_dtmf, algorithm_buffer);
       break;
     }
     case kAlternativePlc: {
       // TODO(hlundin): Write test for this.
-      DoAlternativePlc(false, &algorithm_buffer);
+      DoAlternativePlc(false, algorithm_buffer);
       break;
     }
     case kAlternativePlcIncreaseTimestamp: {
       // TODO(hlundin): Write test for this.
-      DoAlternativePlc(true, &algorithm_buffer);
+      DoAlternativePlc(true, algorithm_buffer);
       break;
     }
     case kAudioRepetitionIncreaseTimestamp: {
@@ -655,7 +651,7 @@ int NetEqImpl::GetAudioInternal(size_t max_length, int16_t* output,
       // TODO(hlundin): Write test for this.
       // Copy last |output_size_samples_| from |sync_buffer_| to
       // |algorithm_buffer|.
-      algorithm_buffer.PushBackFromIndex(
+      algorithm_buffer->PushBackFromIndex(
           *sync_buffer_, sync_buffer_->Size() - output_size_samples_);
       expand_->Reset();
       break;
@@ -676,7 +672,7 @@ int NetEqImpl::GetAudioInternal(size_t max_length, int16_t* output,
   }
 
   // Copy from |algorithm_buffer| to |sync_buffer_|.
-  sync_buffer_->PushBack(algorithm_buffer);
+  sync_buffer_->PushBack(*algorithm_buffer);
 
   // Extract data from |sync_buffer_| to |output|.
   int num_output_samples_per_channel = output_size_samples_;
@@ -691,7 +687,7 @@ int NetEqImpl::GetAudioInternal(size_t max_length, int16_t* output,
       num_output_samples_per_channel, output);
   *num_channels = sync_buffer_->Channels();
   LOG(LS_VERBOSE) << "Sync buffer (" << *num_channels << " channel(s)):" <<
-      " insert " << algorithm_buffer.Size() << " samples, extract " <<
+      " insert " << algorithm_buffer->Size() << " samples, extract " <<
       samples_from_sync << " samples";
   if (samples_from_sync != output_size_samples_) {
     LOG_F(LS_ERROR) << "samples_from_sync != output_size_samples_";
@@ -1135,8 +1131,7 @@ int NetEqImpl::DecodeLoop(PacketList* packet_list, Operations* operation,
                                       speech_type);
     }
 
-    delete[] packet->payload;
-    delete packet;
+    packet_pool_.DeletePacket(packet);
     if (decode_length > 0) {
       *decoded_length += decode_length;
       // Update |decoder_frame_length_| with number of samples per channel.
@@ -1716,6 +1711,9 @@ void NetEqImpl::SetSampleRateAndChannels(int fs_hz, size_t channels) {
   }
   sync_buffer_ = new SyncBuffer(channels, kSyncBufferSize * fs_mult_);
 
+  // Create a new algorithm buffer with the right number of channels.
+  algorithm_buffer_.reset(new AudioMultiVector<int16_t>(channels));
+
   // Delete BackgroundNoise object and create a new one.
   if (background_noise_) {
     delete background_noise_;
@@ -17,6 +17,7 @@
 #include "webrtc/modules/audio_coding/neteq4/defines.h"
 #include "webrtc/modules/audio_coding/neteq4/interface/neteq.h"
 #include "webrtc/modules/audio_coding/neteq4/packet.h"  // Declare PacketList.
+#include "webrtc/modules/audio_coding/neteq4/packet_pool.h"
 #include "webrtc/modules/audio_coding/neteq4/random_vector.h"
 #include "webrtc/modules/audio_coding/neteq4/rtcp.h"
 #include "webrtc/modules/audio_coding/neteq4/statistics_calculator.h"
@@ -169,6 +170,8 @@ class NetEqImpl : public webrtc::NetEq {
   static const int kMaxFrameSize = 2880;  // 60 ms @ 48 kHz.
   // TODO(hlundin): Provide a better value for kSyncBufferSize.
   static const int kSyncBufferSize = 2 * kMaxFrameSize;
+  // Number of decoded packets kept for reuse by |packet_pool_|.
+  static const size_t kMaxPooledPackets = 32;
 
   // Inserts a new packet into NetEq. This is used by the InsertPacket method
   // above. Returns 0 on success, otherwise an error code.
@@ -286,10 +289,12 @@ class NetEqImpl : public webrtc::NetEq {
   scoped_ptr<DtmfToneGenerator> dtmf_tone_generator_;
   scoped_ptr<PacketBuffer> packet_buffer_;
   scoped_ptr<PayloadSplitter> payload_splitter_;
+  PacketPool packet_pool_;
   scoped_ptr<TimestampScaler> timestamp_scaler_;
   scoped_ptr<DecisionLogic> decision_logic_;
   scoped_ptr<PostDecodeVad> vad_;
   SyncBuffer* sync_buffer_;
+  scoped_ptr<AudioMultiVector<int16_t> > algorithm_buffer_;
   Expand* expand_;
   RandomVector random_vector_;
   ComfortNoise* comfort_noise_;
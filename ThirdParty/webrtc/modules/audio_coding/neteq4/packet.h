@@ -23,6 +23,9 @@ struct Packet {
   RTPHeader header;
   uint8_t* payload;  // Datagram excluding RTP header and header extension.
   int payload_length;
+  // Number of bytes allocated for |payload|. Only maintained by PacketPool;
+  // 0 means that |payload_length| bytes were allocated.
+  int payload_capacity;
   bool primary;  // Primary, i.e., not redundant payload.
   int waiting_time;
 
@@ -30,6 +33,7 @@ struct Packet {
   Packet()
       : payload(NULL),
         payload_length(0),
+        payload_capacity(0),
         primary(true),
         waiting_time(0) {
   }
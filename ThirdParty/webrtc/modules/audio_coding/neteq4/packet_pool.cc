@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_coding/neteq4/packet_pool.h"
+
+#include <assert.h>
+
+#include <algorithm>  // max
+
+namespace webrtc {
+
+PacketPool::PacketPool(size_t max_pooled_packets)
+    : max_pooled_packets_(max_pooled_packets) {
+  free_packets_.reserve(max_pooled_packets_);
+}
+
+PacketPool::~PacketPool() {
+  std::vector<Packet*>::iterator it = free_packets_.begin();
+  for (; it != free_packets_.end(); ++it) {
+    delete [] (*it)->payload;
+    delete (*it);
+  }
+}
+
+Packet* PacketPool::NewPacket(int payload_length) {
+  assert(payload_length >= 0);
+  Packet* packet = NULL;
+  if (!free_packets_.empty()) {
+    // Take the most recently returned packet; it is the most likely one to
+    // still be in the cache.
+    packet = free_packets_.back();
+    free_packets_.pop_back();
+    uint8_t* payload = packet->payload;
+    int payload_capacity = packet->payload_capacity;
+    *packet = Packet();
+    if (payload_capacity >= payload_length) {
+      packet->payload = payload;
+      packet->payload_capacity = payload_capacity;
+    } else {
+      delete [] payload;
+    }
+  } else {
+    packet = new Packet;
+  }
+  if (!packet->payload) {
+    packet->payload = new uint8_t[payload_length];
+    packet->payload_capacity = payload_length;
+  }
+  packet->payload_length = payload_length;
+  return packet;
+}
+
+void PacketPool::DeletePacket(Packet* packet) {
+  if (!packet) {
+    return;
+  }
+  if (free_packets_.size() >= max_pooled_packets_) {
+    delete [] packet->payload;
+    delete packet;
+    return;
+  }
+  if (packet->payload) {
+    packet->payload_capacity = std::max(packet->payload_capacity,
+                                        packet->payload_length);
+  } else {
+    packet->payload_capacity = 0;
+  }
+  free_packets_.push_back(packet);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,57 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_CODING_NETEQ4_PACKET_POOL_H_
+#define WEBRTC_MODULES_AUDIO_CODING_NETEQ4_PACKET_POOL_H_
+
+#include <vector>
+
+#include "webrtc/modules/audio_coding/neteq4/packet.h"
+#include "webrtc/system_wrappers/interface/constructor_magic.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Recycles Packet objects together with their payload arrays, so that a NetEq
+// instance in steady state does not go to the heap for every RTP packet.
+// Packets and payloads are allocated with plain new and new[]. A packet from
+// the pool may therefore be deleted as usual (e.g., by
+// PacketBuffer::DeleteAllPackets), and a packet allocated elsewhere may be
+// handed to DeletePacket().
+class PacketPool {
+ public:
+  // Creates a pool which keeps at most |max_pooled_packets| unused packets.
+  explicit PacketPool(size_t max_pooled_packets);
+
+  virtual ~PacketPool();
+
+  // Returns a new packet, with a payload array that can hold at least
+  // |payload_length| bytes. The |payload_length| of the packet is set; all
+  // other members have their default values.
+  Packet* NewPacket(int payload_length);
+
+  // Returns |packet| and its payload array to the pool. If the pool is full,
+  // they are deleted instead.
+  void DeletePacket(Packet* packet);
+
+  // Number of unused packets currently held by the pool.
+  size_t size() const { return free_packets_.size(); }
+
+ private:
+  size_t max_pooled_packets_;
+  // Unused packets. Each packet keeps its payload array, which can hold
+  // |payload_capacity| bytes.
+  std::vector<Packet*> free_packets_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacketPool);
+};
+
+}  // namespace webrtc
+#endif  // WEBRTC_MODULES_AUDIO_CODING_NETEQ4_PACKET_POOL_H_
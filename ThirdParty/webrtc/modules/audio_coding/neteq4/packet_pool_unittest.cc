@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Unit tests for PacketPool class.
+
+#include "webrtc/modules/audio_coding/neteq4/packet_pool.h"
+
+#include "gtest/gtest.h"
+#include "webrtc/modules/audio_coding/neteq4/packet.h"
+
+namespace webrtc {
+
+TEST(PacketPool, CreateAndDestroy) {
+  PacketPool pool(10);
+  EXPECT_EQ(0u, pool.size());
+}
+
+TEST(PacketPool, NewPacket) {
+  PacketPool pool(10);
+  Packet* packet = pool.NewPacket(100);
+  ASSERT_TRUE(packet != NULL);
+  ASSERT_TRUE(packet->payload != NULL);
+  EXPECT_EQ(100, packet->payload_length);
+  EXPECT_TRUE(packet->primary);
+  EXPECT_EQ(0, packet->waiting_time);
+  delete [] packet->payload;
+  delete packet;
+}
+
+// A packet which is returned to the pool is handed out again, together with
+// its payload array, as long as the array is large enough.
+TEST(PacketPool, ReusePacketAndPayload) {
+  PacketPool pool(10);
+  Packet* packet = pool.NewPacket(100);
+  const uint8_t* payload = packet->payload;
+  packet->waiting_time = 17;
+  packet->primary = false;
+  pool.DeletePacket(packet);
+  EXPECT_EQ(1u, pool.size());
+
+  Packet* new_packet = pool.NewPacket(50);
+  EXPECT_EQ(packet, new_packet);
+  EXPECT_EQ(payload, new_packet->payload);
+  EXPECT_EQ(50, new_packet->payload_length);
+  EXPECT_EQ(0, new_packet->waiting_time);
+  EXPECT_TRUE(new_packet->primary);
+  EXPECT_EQ(0u, pool.size());
+
+  // The array still holds 100 bytes, although the last payload was shorter.
+  pool.DeletePacket(new_packet);
+  new_packet = pool.NewPacket(100);
+  EXPECT_EQ(payload, new_packet->payload);
+
+  // A larger payload needs a new array.
+  pool.DeletePacket(new_packet);
+  new_packet = pool.NewPacket(101);
+  EXPECT_EQ(packet, new_packet);
+  EXPECT_EQ(101, new_packet->payload_length);
+  pool.DeletePacket(new_packet);
+}
+
+// Packets which were not allocated by the pool can be returned to it.
+TEST(PacketPool, DeleteForeignPacket) {
+  PacketPool pool(10);
+  Packet* packet = new Packet;
+  packet->payload_length = 20;
+  packet->payload = new uint8_t[packet->payload_length];
+  pool.DeletePacket(packet);
+  EXPECT_EQ(1u, pool.size());
+  Packet* new_packet = pool.NewPacket(20);
+  EXPECT_EQ(packet->payload, new_packet->payload);
+  pool.DeletePacket(new_packet);
+}
+
+TEST(PacketPool, MaxPooledPackets) {
+  const size_t kMaxPooledPackets = 3;
+  PacketPool pool(kMaxPooledPackets);
+  Packet* packets[kMaxPooledPackets + 2];
+  for (size_t i = 0; i < kMaxPooledPackets + 2; ++i) {
+    packets[i] = pool.NewPacket(10);
+  }
+  for (size_t i = 0; i < kMaxPooledPackets + 2; ++i) {
+    pool.DeletePacket(packets[i]);
+  }
+  EXPECT_EQ(kMaxPooledPackets, pool.size());
+}
+
+}  // namespace webrtc
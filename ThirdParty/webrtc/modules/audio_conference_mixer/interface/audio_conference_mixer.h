@@ -24,6 +24,7 @@ class Trace;
 class AudioConferenceMixer : public Module
 {
 public:
+    // Default for the number of non-anonymous participants that are mixed.
     enum {kMaximumAmountOfMixedParticipants = 3};
     enum Frequency
     {
@@ -79,6 +80,18 @@ public:
     // downsampling of audio contributing to the mixed audio.
     virtual WebRtc_Word32 SetMinimumMixingFrequency(Frequency freq) = 0;
 
+    // Set the number of non-anonymous participants that are mixed. The
+    // |maxMixedParticipants| participants with the highest energy are picked
+    // every 10 ms. Defaults to kMaximumAmountOfMixedParticipants.
+    virtual WebRtc_Word32 SetMaximumMixedParticipants(
+        const WebRtc_UWord32 maxMixedParticipants) = 0;
+
+    // Enable/disable mix-minus output. When enabled, the uniqueAudioFrames
+    // passed to AudioMixerOutputReceiver::NewMixedAudio() contain, for every
+    // participant contributing to the mix, the mix without that participant.
+    // The id_ of each such AudioFrame is the id_ of the left out participant.
+    virtual WebRtc_Word32 SetMixMinusStatus(const bool enable) = 0;
+
 protected:
     AudioConferenceMixer() {}
 };
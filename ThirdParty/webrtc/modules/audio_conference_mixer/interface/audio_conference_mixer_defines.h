@@ -79,7 +79,8 @@ class AudioMixerOutputReceiver
 public:
     // This callback function provides the mixed audio for this mix iteration.
     // Note that uniqueAudioFrames is an array of AudioFrame pointers with the
-    // size according to the size parameter.
+    // size according to the size parameter. It holds the mix-minus frames, if
+    // enabled through AudioConferenceMixer::SetMixMinusStatus().
     virtual void NewMixedAudio(const WebRtc_Word32 id,
                                const AudioFrame& generalAudioFrame,
                                const AudioFrame** uniqueAudioFrames,
@@ -8,50 +8,54 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+#include <string.h>
+
 #include "audio_conference_mixer_defines.h"
 #include "audio_conference_mixer_impl.h"
 #include "audio_frame_manipulator.h"
 #include "audio_processing.h"
 #include "critical_section_wrapper.h"
-#include "map_wrapper.h"
 #include "modules/utility/interface/audio_frame_operations.h"
 #include "trace.h"
 
 namespace webrtc {
 namespace {
 
-// Mix |frame| into |mixed_frame|, with saturation protection and upmixing.
-// These effects are applied to |frame| itself prior to mixing. Assumes that
-// |mixed_frame| always has at least as many channels as |frame|. Supports
-// stereo at most.
-//
-// TODO(andrew): consider not modifying |frame| here.
-void MixFrames(AudioFrame* mixed_frame, AudioFrame* frame) {
-  assert(mixed_frame->num_channels_ >= frame->num_channels_);
-  // Divide by two to avoid saturation in the mixing.
-  *frame >>= 1;
-  if (mixed_frame->num_channels_ > frame->num_channels_) {
-    // We only support mono-to-stereo.
-    assert(mixed_frame->num_channels_ == 2 &&
-           frame->num_channels_ == 1);
-    AudioFrameOperations::MonoToStereo(frame);
+// Update the speech type and VAD of |mixed_frame| the same way as
+// AudioFrame::operator+= does when |frame| is added to it.
+void UpdateMixedFrameInfo(AudioFrame* mixed_frame, const AudioFrame& frame) {
+  if (mixed_frame->vad_activity_ == AudioFrame::kVadActive ||
+      frame.vad_activity_ == AudioFrame::kVadActive) {
+    mixed_frame->vad_activity_ = AudioFrame::kVadActive;
+  } else if (mixed_frame->vad_activity_ == AudioFrame::kVadUnknown ||
+             frame.vad_activity_ == AudioFrame::kVadUnknown) {
+    mixed_frame->vad_activity_ = AudioFrame::kVadUnknown;
+  }
+  if (mixed_frame->speech_type_ != frame.speech_type_) {
+    mixed_frame->speech_type_ = AudioFrame::kUndefined;
   }
-
-  *mixed_frame += *frame;
 }
 
 // Return the max number of channels from a |list| composed of AudioFrames.
-int MaxNumChannels(const ListWrapper& list) {
-  ListItem* item = list.First();
+int MaxNumChannels(const AudioFrameList& list) {
   int max_num_channels = 1;
-  while (item) {
-    AudioFrame* frame = static_cast<AudioFrame*>(item->GetItem());
-    max_num_channels = std::max(max_num_channels, frame->num_channels_);
-    item = list.Next(item);
+  for (size_t i = 0; i < list.size(); ++i) {
+    max_num_channels = std::max(max_num_channels, list[i]->num_channels_);
   }
   return max_num_channels;
 }
 
+// Orders ParticipantFrames by decreasing energy. On a tie the participant
+// that was mixed in the previous iteration comes first, so that it isn't
+// needlessly ramped out.
+bool HigherEnergy(const ParticipantFrame& lhs, const ParticipantFrame& rhs) {
+  if (lhs.audioFrame->energy_ != rhs.audioFrame->energy_) {
+    return lhs.audioFrame->energy_ > rhs.audioFrame->energy_;
+  }
+  return lhs.wasMixed && !rhs.wasMixed;
+}
+
 void SetParticipantStatistics(ParticipantStatistics* stats,
                               const AudioFrame& frame)
 {
@@ -125,6 +129,16 @@ AudioConferenceMixerImpl::AudioConferenceMixerImpl(int id)
       _scratchMixedParticipants(),
       _scratchVadPositiveParticipantsAmount(0),
       _scratchVadPositiveParticipants(),
+      _scratchFrames(),
+      _scratchFramesUsed(0),
+      _activeList(),
+      _passiveWasMixedList(),
+      _passiveWasNotMixedList(),
+      _mixList(),
+      _rampOutList(),
+      _additionalFramesList(),
+      _mixedParticipants(),
+      _mixMinusFrames(),
       _crit(NULL),
       _cbCrit(NULL),
       _id(id),
@@ -136,16 +150,19 @@ AudioConferenceMixerImpl::AudioConferenceMixerImpl(int id)
       _mixerStatusCb(false),
       _outputFrequency(kDefaultFrequency),
       _sampleSize(0),
-      _audioFramePool(NULL),
       _participantList(),
       _additionalParticipantList(),
+      _maxMixedParticipants(kMaximumAmountOfMixedParticipants),
+      _mixMinus(false),
       _numMixedParticipants(0),
       _timeStamp(0),
       _timeScheduler(kProcessPeriodicityInMs),
       _mixedAudioLevel(),
       _processCalls(0),
       _limiter(NULL)
-{}
+{
+    InitMixKernels(&_mixKernels);
+}
 
 bool AudioConferenceMixerImpl::Init()
 {
@@ -161,11 +178,6 @@ bool AudioConferenceMixerImpl::Init()
     if(_limiter.get() == NULL)
         return false;
 
-    MemoryPool<AudioFrame>::CreateMemoryPool(_audioFramePool,
-                                             DEFAULT_AUDIO_FRAME_POOLSIZE);
-    if(_audioFramePool == NULL)
-        return false;
-
     if(SetOutputFrequency(kDefaultFrequency) == -1)
         return false;
 
@@ -198,8 +210,10 @@ bool AudioConferenceMixerImpl::Init()
 
 AudioConferenceMixerImpl::~AudioConferenceMixerImpl()
 {
-    MemoryPool<AudioFrame>::DeleteMemoryPool(_audioFramePool);
-    assert(_audioFramePool == NULL);
+    for(size_t i = 0; i < _scratchFrames.size(); i++)
+    {
+        delete _scratchFrames[i];
+    }
 }
 
 WebRtc_Word32 AudioConferenceMixerImpl::ChangeUniqueId(const WebRtc_Word32 id)
@@ -226,8 +240,6 @@ WebRtc_Word32 AudioConferenceMixerImpl::TimeUntilNextProcess()
 
 WebRtc_Word32 AudioConferenceMixerImpl::Process()
 {
-    WebRtc_UWord32 remainingParticipantsAllowedToMix =
-        kMaximumAmountOfMixedParticipants;
     {
         CriticalSectionScoped cs(_crit.get());
         assert(_processCalls == 0);
@@ -237,10 +249,13 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
         _timeScheduler.UpdateScheduler();
     }
 
-    ListWrapper mixList;
-    ListWrapper rampOutList;
-    ListWrapper additionalFramesList;
-    MapWrapper mixedParticipantsMap;
+    _scratchFramesUsed = 0;
+    _mixList.clear();
+    _rampOutList.clear();
+    _additionalFramesList.clear();
+    _mixedParticipants.clear();
+    _mixMinusFrames.clear();
+    bool mixMinus = false;
     {
         CriticalSectionScoped cs(_cbCrit.get());
 
@@ -297,29 +312,22 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
             }
         }
 
-        UpdateToMix(mixList, rampOutList, mixedParticipantsMap,
-                    remainingParticipantsAllowedToMix);
-
-        GetAdditionalAudio(additionalFramesList);
-        UpdateMixedStatus(mixedParticipantsMap);
-        _scratchParticipantsToMixAmount = mixedParticipantsMap.Size();
-    }
+        if(_scratchMixedParticipants.size() < _maxMixedParticipants)
+        {
+            _scratchMixedParticipants.resize(_maxMixedParticipants);
+            _scratchVadPositiveParticipants.resize(_maxMixedParticipants);
+        }
+        mixMinus = _mixMinus;
 
-    // Clear mixedParticipantsMap to avoid memory leak warning.
-    // Please note that the mixedParticipantsMap doesn't own any dynamically
-    // allocated memory.
-    while(mixedParticipantsMap.Erase(mixedParticipantsMap.First()) == 0) {}
+        UpdateToMix(_maxMixedParticipants);
 
-    // Get an AudioFrame for mixing from the memory pool.
-    AudioFrame* mixedAudio = NULL;
-    if(_audioFramePool->PopMemory(mixedAudio) == -1)
-    {
-        WEBRTC_TRACE(kTraceMemory, kTraceAudioMixerServer, _id,
-                     "failed PopMemory() call");
-        assert(false);
-        return -1;
+        GetAdditionalAudio();
+        UpdateMixedStatus();
     }
 
+    AudioFrame* mixedAudio = NextScratchFrame();
+    ReserveScratchFrame();
+
     bool timeForMixerCallback = false;
     int retval = 0;
     WebRtc_Word32 audioLevel = 0;
@@ -330,9 +338,9 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
         //                with an API instead of dynamically.
 
         // Find the max channels over all mixing lists.
-        const int num_mixed_channels = std::max(MaxNumChannels(mixList),
-            std::max(MaxNumChannels(additionalFramesList),
-                     MaxNumChannels(rampOutList)));
+        const int num_mixed_channels = std::max(MaxNumChannels(_mixList),
+            std::max(MaxNumChannels(_additionalFramesList),
+                     MaxNumChannels(_rampOutList)));
 
         if (!SetNumLimiterChannels(num_mixed_channels))
             retval = -1;
@@ -343,9 +351,25 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
 
         _timeStamp += _sampleSize;
 
-        MixFromList(*mixedAudio, mixList);
-        MixAnonomouslyFromList(*mixedAudio, additionalFramesList);
-        MixAnonomouslyFromList(*mixedAudio, rampOutList);
+        memset(_mixAccumulator, 0,
+               _sampleSize * num_mixed_channels * sizeof(_mixAccumulator[0]));
+        AccumulateFromList(*mixedAudio, _mixList);
+        AccumulateFromList(*mixedAudio, _additionalFramesList);
+        AccumulateFromList(*mixedAudio, _rampOutList);
+
+        _scratchParticipantsToMixAmount = _mixList.size();
+        for(size_t i = 0; i < _mixList.size(); i++)
+        {
+            SetParticipantStatistics(&_scratchMixedParticipants[i],
+                                     *_mixList[i]);
+        }
+
+        if(mixMinus)
+        {
+            MixMinusFromList(*mixedAudio, _mixList);
+            MixMinusFromList(*mixedAudio, _additionalFramesList);
+            MixMinusFromList(*mixedAudio, _rampOutList);
+        }
 
         if(mixedAudio->samples_per_channel_ == 0)
         {
@@ -353,8 +377,23 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
             mixedAudio->samples_per_channel_ = _sampleSize;
             mixedAudio->Mute();
         }
+        else if(_numMixedParticipants == 1)
+        {
+            // No mixing required here; skip the saturation protection.
+            if(!_mixList.empty())
+            {
+                mixedAudio->CopyFrom(*_mixList.front());
+            } else if(!_additionalFramesList.empty()) {
+                mixedAudio->CopyFrom(*_additionalFramesList.front());
+            } else {
+                mixedAudio->CopyFrom(*_rampOutList.front());
+            }
+        }
         else
         {
+            _mixKernels.Saturate(_mixAccumulator,
+                                 _sampleSize * num_mixed_channels,
+                                 mixedAudio->data_);
             // Only call the limiter if we have something to mix.
             if(!LimitMixedAudio(*mixedAudio))
                 retval = -1;
@@ -366,7 +405,7 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
         if(_mixerStatusCb)
         {
             _scratchVadPositiveParticipantsAmount = 0;
-            UpdateVADPositiveParticipants(mixList);
+            UpdateVADPositiveParticipants();
             if(_amountOf10MsUntilNextCallback-- == 0)
             {
                 _amountOf10MsUntilNextCallback = _amountOf10MsBetweenCallbacks;
@@ -379,12 +418,16 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
         CriticalSectionScoped cs(_cbCrit.get());
         if(_mixReceiver != NULL)
         {
-            const AudioFrame** dummy = NULL;
+            const AudioFrame** uniqueAudioFrames = NULL;
+            if(!_mixMinusFrames.empty())
+            {
+                uniqueAudioFrames = &_mixMinusFrames[0];
+            }
             _mixReceiver->NewMixedAudio(
                 _id,
                 *mixedAudio,
-                dummy,
-                0);
+                uniqueAudioFrames,
+                _mixMinusFrames.size());
         }
 
         if((_mixerStatusCallback != NULL) &&
@@ -392,22 +435,17 @@ WebRtc_Word32 AudioConferenceMixerImpl::Process()
         {
             _mixerStatusCallback->MixedParticipants(
                 _id,
-                _scratchMixedParticipants,
+                &_scratchMixedParticipants[0],
                 _scratchParticipantsToMixAmount);
 
             _mixerStatusCallback->VADPositiveParticipants(
                 _id,
-                _scratchVadPositiveParticipants,
+                &_scratchVadPositiveParticipants[0],
                 _scratchVadPositiveParticipantsAmount);
             _mixerStatusCallback->MixedAudioLevel(_id,audioLevel);
         }
     }
 
-    // Reclaim all outstanding memory.
-    _audioFramePool->PushMemory(mixedAudio);
-    ClearAudioFrameList(mixList);
-    ClearAudioFrameList(rampOutList);
-    ClearAudioFrameList(additionalFramesList);
     {
         CriticalSectionScoped cs(_crit.get());
         _processCalls--;
@@ -573,13 +611,7 @@ WebRtc_Word32 AudioConferenceMixerImpl::SetMixabilityStatus(
             return -1;
         }
 
-        int numMixedNonAnonymous = _participantList.GetSize();
-        if (numMixedNonAnonymous > kMaximumAmountOfMixedParticipants)
-        {
-            numMixedNonAnonymous = kMaximumAmountOfMixedParticipants;
-        }
-        numMixedParticipants = numMixedNonAnonymous +
-                               _additionalParticipantList.GetSize();
+        numMixedParticipants = NumMixedParticipants();
     }
     // A MixerParticipant was added or removed. Make sure the scratch
     // buffer is updated if necessary.
@@ -674,6 +706,44 @@ WebRtc_Word32 AudioConferenceMixerImpl::SetMinimumMixingFrequency(
     }
 }
 
+WebRtc_Word32 AudioConferenceMixerImpl::SetMaximumMixedParticipants(
+    const WebRtc_UWord32 maxMixedParticipants)
+{
+    if(maxMixedParticipants == 0)
+    {
+        WEBRTC_TRACE(kTraceError, kTraceAudioMixerServer, _id,
+                     "at least one participant must be mixed");
+        return -1;
+    }
+    WebRtc_UWord32 numMixedParticipants;
+    {
+        CriticalSectionScoped cs(_cbCrit.get());
+        _maxMixedParticipants = maxMixedParticipants;
+        numMixedParticipants = NumMixedParticipants();
+    }
+    // Note: The scratch buffer may only be updated in Process().
+    CriticalSectionScoped cs(_crit.get());
+    _numMixedParticipants = numMixedParticipants;
+    return 0;
+}
+
+WebRtc_Word32 AudioConferenceMixerImpl::SetMixMinusStatus(const bool enable)
+{
+    CriticalSectionScoped cs(_cbCrit.get());
+    _mixMinus = enable;
+    return 0;
+}
+
+WebRtc_UWord32 AudioConferenceMixerImpl::NumMixedParticipants() const
+{
+    WebRtc_UWord32 numMixedNonAnonymous = _participantList.size();
+    if(numMixedNonAnonymous > _maxMixedParticipants)
+    {
+        numMixedNonAnonymous = _maxMixedParticipants;
+    }
+    return numMixedNonAnonymous + _additionalParticipantList.size();
+}
+
 // Check all AudioFrames that are to be mixed. The highest sampling frequency
 // found is the lowest that can be used without losing information.
 WebRtc_Word32 AudioConferenceMixerImpl::GetLowestMixingFrequency()
@@ -697,76 +767,54 @@ WebRtc_Word32 AudioConferenceMixerImpl::GetLowestMixingFrequency()
 }
 
 WebRtc_Word32 AudioConferenceMixerImpl::GetLowestMixingFrequencyFromList(
-    ListWrapper& mixList)
+    const MixerParticipantList& mixList)
 {
     WebRtc_Word32 highestFreq = 8000;
-    ListItem* item = mixList.First();
-    while(item)
+    for(size_t i = 0; i < mixList.size(); i++)
     {
-        MixerParticipant* participant =
-            static_cast<MixerParticipant*>(item->GetItem());
-        const WebRtc_Word32 neededFrequency = participant->NeededFrequency(_id);
+        const WebRtc_Word32 neededFrequency = mixList[i]->NeededFrequency(_id);
         if(neededFrequency > highestFreq)
         {
             highestFreq = neededFrequency;
         }
-        item = mixList.Next(item);
     }
     return highestFreq;
 }
 
 void AudioConferenceMixerImpl::UpdateToMix(
-    ListWrapper& mixList,
-    ListWrapper& rampOutList,
-    MapWrapper& mixParticipantList,
-    WebRtc_UWord32& maxAudioFrameCounter)
+    WebRtc_UWord32 maxAudioFrameCounter)
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "UpdateToMix(mixList,rampOutList,mixParticipantList,%d)",
-                 maxAudioFrameCounter);
-    const WebRtc_UWord32 mixListStartSize = mixList.GetSize();
-    ListWrapper activeList; // Elements are AudioFrames
-    // Struct needed by the passive lists to keep track of which AudioFrame
-    // belongs to which MixerParticipant.
-    struct ParticipantFramePair
-    {
-        MixerParticipant* participant;
-        AudioFrame* audioFrame;
-    };
-    ListWrapper passiveWasNotMixedList; // Elements are MixerParticipant
-    ListWrapper passiveWasMixedList;    // Elements are MixerParticipant
-    ListItem* item = _participantList.First();
-    while(item)
+                 "UpdateToMix(%d)", maxAudioFrameCounter);
+    _activeList.clear();
+    _passiveWasMixedList.clear();
+    _passiveWasNotMixedList.clear();
+    for(size_t i = 0; i < _participantList.size(); i++)
     {
         // Stop keeping track of passive participants if there are already
         // enough participants available (they wont be mixed anyway).
         bool mustAddToPassiveList = (maxAudioFrameCounter >
-                                    (activeList.GetSize() +
-                                     passiveWasMixedList.GetSize() +
-                                     passiveWasNotMixedList.GetSize()));
-
-        MixerParticipant* participant = static_cast<MixerParticipant*>(
-            item->GetItem());
-        bool wasMixed = false;
-        participant->_mixHistory->WasMixed(wasMixed);
-        AudioFrame* audioFrame = NULL;
-        if(_audioFramePool->PopMemory(audioFrame) == -1)
-        {
-            WEBRTC_TRACE(kTraceMemory, kTraceAudioMixerServer, _id,
-                         "failed PopMemory() call");
-            assert(false);
-            return;
-        }
+                                    (_activeList.size() +
+                                     _passiveWasMixedList.size() +
+                                     _passiveWasNotMixedList.size()));
+
+        ParticipantFrame participantFrame;
+        participantFrame.participant = _participantList[i];
+        participantFrame.participant->_mixHistory->WasMixed(
+            participantFrame.wasMixed);
+        AudioFrame* audioFrame = NextScratchFrame();
         audioFrame->sample_rate_hz_ = _outputFrequency;
+        // The energy is cached in the AudioFrame, which is reused between
+        // mix iterations.
+        audioFrame->energy_ = 0xffffffff;
 
-        if(participant->GetAudioFrame(_id,*audioFrame) != 0)
+        if(participantFrame.participant->GetAudioFrame(_id,*audioFrame) != 0)
         {
             WEBRTC_TRACE(kTraceWarning, kTraceAudioMixerServer, _id,
                          "failed to GetAudioFrame() from participant");
-            _audioFramePool->PushMemory(audioFrame);
-            item = _participantList.Next(item);
             continue;
         }
+        participantFrame.audioFrame = audioFrame;
         // TODO(henrike): this assert triggers in some test cases where SRTP is
         // used which prevents NetEQ from making a VAD. Temporarily disable this
         // assert until the problem is fixed on a higher level.
@@ -779,265 +827,125 @@ void AudioConferenceMixerImpl::UpdateToMix(
 
         if(audioFrame->vad_activity_ == AudioFrame::kVadActive)
         {
-            if(!wasMixed)
-            {
-                RampIn(*audioFrame);
-            }
-
-            if(activeList.GetSize() >= maxAudioFrameCounter)
-            {
-                // There are already more active participants than should be
-                // mixed. Only keep the ones with the highest energy.
-                ListItem* replaceItem = NULL;
-                CalculateEnergy(*audioFrame);
-                WebRtc_UWord32 lowestEnergy = audioFrame->energy_;
-
-                ListItem* activeItem = activeList.First();
-                while(activeItem)
-                {
-                    AudioFrame* replaceFrame = static_cast<AudioFrame*>(
-                        activeItem->GetItem());
-                    CalculateEnergy(*replaceFrame);
-                    if(replaceFrame->energy_ < lowestEnergy)
-                    {
-                        replaceItem = activeItem;
-                        lowestEnergy = replaceFrame->energy_;
-                    }
-                    activeItem = activeList.Next(activeItem);
-                }
-                if(replaceItem != NULL)
-                {
-                    AudioFrame* replaceFrame = static_cast<AudioFrame*>(
-                        replaceItem->GetItem());
-
-                    bool replaceWasMixed = false;
-                    MapItem* replaceParticipant = mixParticipantList.Find(
-                        replaceFrame->id_);
-                    // When a frame is pushed to |activeList| it is also pushed
-                    // to mixParticipantList with the frame's id. This means
-                    // that the Find call above should never fail.
-                    if(replaceParticipant == NULL)
-                    {
-                        assert(false);
-                    } else {
-                        static_cast<MixerParticipant*>(
-                            replaceParticipant->GetItem())->_mixHistory->
-                            WasMixed(replaceWasMixed);
-
-                        mixParticipantList.Erase(replaceFrame->id_);
-                        activeList.Erase(replaceItem);
-
-                        activeList.PushFront(static_cast<void*>(audioFrame));
-                        mixParticipantList.Insert(
-                            audioFrame->id_,
-                            static_cast<void*>(participant));
-                        assert(mixParticipantList.Size() <=
-                               kMaximumAmountOfMixedParticipants);
-
-                        if(replaceWasMixed)
-                        {
-                            RampOut(*replaceFrame);
-                            rampOutList.PushBack(
-                                static_cast<void*>(replaceFrame));
-                            assert(rampOutList.GetSize() <=
-                                   kMaximumAmountOfMixedParticipants);
-                        } else {
-                            _audioFramePool->PushMemory(replaceFrame);
-                        }
-                    }
-                } else {
-                    if(wasMixed)
-                    {
-                        RampOut(*audioFrame);
-                        rampOutList.PushBack(static_cast<void*>(audioFrame));
-                        assert(rampOutList.GetSize() <=
-                               kMaximumAmountOfMixedParticipants);
-                    } else {
-                        _audioFramePool->PushMemory(audioFrame);
-                    }
-                }
-            } else {
-                activeList.PushFront(static_cast<void*>(audioFrame));
-                mixParticipantList.Insert(audioFrame->id_,
-                                          static_cast<void*>(participant));
-                assert(mixParticipantList.Size() <=
-                       kMaximumAmountOfMixedParticipants);
-            }
+            CalculateEnergy(*audioFrame);
+            _activeList.push_back(participantFrame);
+        } else if(participantFrame.wasMixed) {
+            _passiveWasMixedList.push_back(participantFrame);
+        } else if(mustAddToPassiveList) {
+            _passiveWasNotMixedList.push_back(participantFrame);
         } else {
-            if(wasMixed)
+            // Won't be mixed; let the next participant reuse the AudioFrame.
+            continue;
+        }
+        ReserveScratchFrame();
+    }
+
+    if(_activeList.size() > maxAudioFrameCounter)
+    {
+        // There are more active participants than should be mixed. Only keep
+        // the ones with the highest energy. A partial sort is enough since
+        // the order among the kept (and among the dropped) doesn't matter.
+        std::nth_element(_activeList.begin(),
+                         _activeList.begin() + maxAudioFrameCounter,
+                         _activeList.end(),
+                         HigherEnergy);
+        for(size_t i = maxAudioFrameCounter; i < _activeList.size(); i++)
+        {
+            if(_activeList[i].wasMixed)
             {
-                ParticipantFramePair* pair = new ParticipantFramePair;
-                pair->audioFrame  = audioFrame;
-                pair->participant = participant;
-                passiveWasMixedList.PushBack(static_cast<void*>(pair));
-            } else if(mustAddToPassiveList) {
-                RampIn(*audioFrame);
-                ParticipantFramePair* pair = new ParticipantFramePair;
-                pair->audioFrame  = audioFrame;
-                pair->participant = participant;
-                passiveWasNotMixedList.PushBack(static_cast<void*>(pair));
-            } else {
-                _audioFramePool->PushMemory(audioFrame);
+                RampOut(*_activeList[i].audioFrame);
+                _rampOutList.push_back(_activeList[i].audioFrame);
             }
         }
-        item = _participantList.Next(item);
+        _activeList.resize(maxAudioFrameCounter);
     }
-    assert(activeList.GetSize() <= maxAudioFrameCounter);
     // At this point it is known which participants should be mixed. Transfer
-    // this information to this functions output parameters.
-    while(!activeList.Empty())
+    // this information to the mix list.
+    for(size_t i = 0; i < _activeList.size(); i++)
     {
-        ListItem* mixItem = activeList.First();
-        mixList.PushBack(mixItem->GetItem());
-        activeList.Erase(mixItem);
+        if(!_activeList[i].wasMixed)
+        {
+            RampIn(*_activeList[i].audioFrame);
+        }
+        _mixList.push_back(_activeList[i].audioFrame);
+        _mixedParticipants.push_back(_activeList[i].participant);
     }
     // Always mix a constant number of AudioFrames. If there aren't enough
     // active participants mix passive ones. Starting with those that was mixed
     // last iteration.
-    while(!passiveWasMixedList.Empty())
+    for(size_t i = 0; i < _passiveWasMixedList.size() &&
+        _mixList.size() < maxAudioFrameCounter; i++)
     {
-        ListItem* mixItem = passiveWasMixedList.First();
-        ParticipantFramePair* pair = static_cast<ParticipantFramePair*>(
-            mixItem->GetItem());
-        if(mixList.GetSize() <  maxAudioFrameCounter + mixListStartSize)
-        {
-            mixList.PushBack(pair->audioFrame);
-            mixParticipantList.Insert(pair->audioFrame->id_,
-                                      static_cast<void*>(pair->participant));
-            assert(mixParticipantList.Size() <=
-                   kMaximumAmountOfMixedParticipants);
-        }
-        else
-        {
-            _audioFramePool->PushMemory(pair->audioFrame);
-        }
-        delete pair;
-        passiveWasMixedList.Erase(mixItem);
+        _mixList.push_back(_passiveWasMixedList[i].audioFrame);
+        _mixedParticipants.push_back(_passiveWasMixedList[i].participant);
     }
     // And finally the ones that have not been mixed for a while.
-    while(!passiveWasNotMixedList.Empty())
+    for(size_t i = 0; i < _passiveWasNotMixedList.size() &&
+        _mixList.size() < maxAudioFrameCounter; i++)
     {
-        ListItem* mixItem = passiveWasNotMixedList.First();
-        ParticipantFramePair* pair = static_cast<ParticipantFramePair*>(
-            mixItem->GetItem());
-        if(mixList.GetSize() <  maxAudioFrameCounter + mixListStartSize)
-        {
-            mixList.PushBack(pair->audioFrame);
-            mixParticipantList.Insert(pair->audioFrame->id_,
-                                      static_cast<void*>(pair->participant));
-            assert(mixParticipantList.Size() <=
-                   kMaximumAmountOfMixedParticipants);
-        }
-        else
-        {
-            _audioFramePool->PushMemory(pair->audioFrame);
-        }
-        delete pair;
-        passiveWasNotMixedList.Erase(mixItem);
+        RampIn(*_passiveWasNotMixedList[i].audioFrame);
+        _mixList.push_back(_passiveWasNotMixedList[i].audioFrame);
+        _mixedParticipants.push_back(_passiveWasNotMixedList[i].participant);
     }
-    assert(maxAudioFrameCounter + mixListStartSize >= mixList.GetSize());
-    maxAudioFrameCounter += mixListStartSize - mixList.GetSize();
+    assert(_mixList.size() <= maxAudioFrameCounter);
 }
 
-void AudioConferenceMixerImpl::GetAdditionalAudio(
-    ListWrapper& additionalFramesList)
+void AudioConferenceMixerImpl::GetAdditionalAudio()
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "GetAdditionalAudio(additionalFramesList)");
-    ListItem* item = _additionalParticipantList.First();
-    while(item)
+                 "GetAdditionalAudio()");
+    // The GetAudioFrame() callback may remove participants from the list, so
+    // its size is checked on every iteration.
+    for(size_t i = 0; i < _additionalParticipantList.size(); i++)
     {
-        // The GetAudioFrame() callback may remove the current item. Store the
-        // next item just in case that happens.
-        ListItem* nextItem = _additionalParticipantList.Next(item);
-
-        MixerParticipant* participant = static_cast<MixerParticipant*>(
-            item->GetItem());
-        AudioFrame* audioFrame = NULL;
-        if(_audioFramePool->PopMemory(audioFrame) == -1)
-        {
-            WEBRTC_TRACE(kTraceMemory, kTraceAudioMixerServer, _id,
-                         "failed PopMemory() call");
-            assert(false);
-            return;
-        }
+        MixerParticipant* participant = _additionalParticipantList[i];
+        AudioFrame* audioFrame = NextScratchFrame();
         audioFrame->sample_rate_hz_ = _outputFrequency;
+        audioFrame->energy_ = 0xffffffff;
         if(participant->GetAudioFrame(_id, *audioFrame) != 0)
         {
             WEBRTC_TRACE(kTraceWarning, kTraceAudioMixerServer, _id,
                          "failed to GetAudioFrame() from participant");
-            _audioFramePool->PushMemory(audioFrame);
-            item = nextItem;
             continue;
         }
         if(audioFrame->samples_per_channel_ == 0)
         {
             // Empty frame. Don't use it.
-            _audioFramePool->PushMemory(audioFrame);
-            item = nextItem;
             continue;
         }
-        additionalFramesList.PushBack(static_cast<void*>(audioFrame));
-        item = nextItem;
+        ReserveScratchFrame();
+        _additionalFramesList.push_back(audioFrame);
     }
 }
 
-void AudioConferenceMixerImpl::UpdateMixedStatus(
-    MapWrapper& mixedParticipantsMap)
+void AudioConferenceMixerImpl::UpdateMixedStatus()
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "UpdateMixedStatus(mixedParticipantsMap)");
-    assert(mixedParticipantsMap.Size() <= kMaximumAmountOfMixedParticipants);
-
-    // Loop through all participants. If they are in the mix map they
-    // were mixed.
-    ListItem* participantItem = _participantList.First();
-    while(participantItem != NULL)
+                 "UpdateMixedStatus()");
+    assert(_mixedParticipants.size() <= _maxMixedParticipants);
+
+    // Loop through all participants. If they are in the sorted mix list they
+    // were mixed. Only the pointer values are used since a participant may
+    // have been removed during the GetAudioFrame() callbacks.
+    std::sort(_mixedParticipants.begin(), _mixedParticipants.end());
+    for(size_t i = 0; i < _participantList.size(); i++)
     {
-        bool isMixed = false;
-        MixerParticipant* participant =
-            static_cast<MixerParticipant*>(participantItem->GetItem());
-
-        MapItem* mixedItem = mixedParticipantsMap.First();
-        while(mixedItem)
-        {
-            if(participant == mixedItem->GetItem())
-            {
-                isMixed = true;
-                break;
-            }
-            mixedItem = mixedParticipantsMap.Next(mixedItem);
-        }
+        MixerParticipant* participant = _participantList[i];
+        const bool isMixed = std::binary_search(_mixedParticipants.begin(),
+                                                _mixedParticipants.end(),
+                                                participant);
         participant->_mixHistory->SetIsMixed(isMixed);
-        participantItem = _participantList.Next(participantItem);
     }
 }
 
-void AudioConferenceMixerImpl::ClearAudioFrameList(ListWrapper& audioFrameList)
+void AudioConferenceMixerImpl::UpdateVADPositiveParticipants()
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "ClearAudioFrameList(audioFrameList)");
-    ListItem* item = audioFrameList.First();
-    while(item)
-    {
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        _audioFramePool->PushMemory(audioFrame);
-        audioFrameList.Erase(item);
-        item = audioFrameList.First();
-    }
-}
+                 "UpdateVADPositiveParticipants()");
 
-void AudioConferenceMixerImpl::UpdateVADPositiveParticipants(
-    ListWrapper& mixList)
-{
-    WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "UpdateVADPositiveParticipants(mixList)");
-
-    ListItem* item = mixList.First();
-    while(item != NULL)
+    for(size_t i = 0; i < _mixList.size(); i++)
     {
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        CalculateEnergy(*audioFrame);
+        AudioFrame* audioFrame = _mixList[i];
         if(audioFrame->vad_activity_ == AudioFrame::kVadActive)
         {
             _scratchVadPositiveParticipants[
@@ -1048,40 +956,26 @@ void AudioConferenceMixerImpl::UpdateVADPositiveParticipants(
                 _scratchVadPositiveParticipantsAmount].level = 0;
             _scratchVadPositiveParticipantsAmount++;
         }
-        item = mixList.Next(item);
     }
 }
 
 bool AudioConferenceMixerImpl::IsParticipantInList(
     MixerParticipant& participant,
-    ListWrapper& participantList)
+    const MixerParticipantList& participantList) const
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
                  "IsParticipantInList(participant,participantList)");
-    ListItem* item = participantList.First();
-    while(item != NULL)
-    {
-        MixerParticipant* rhsParticipant =
-            static_cast<MixerParticipant*>(item->GetItem());
-        if(&participant == rhsParticipant)
-        {
-            return true;
-        }
-        item = participantList.Next(item);
-    }
-    return false;
+    return std::find(participantList.begin(), participantList.end(),
+                     &participant) != participantList.end();
 }
 
 bool AudioConferenceMixerImpl::AddParticipantToList(
     MixerParticipant& participant,
-    ListWrapper& participantList)
+    MixerParticipantList& participantList)
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
                  "AddParticipantToList(participant, participantList)");
-    if(participantList.PushBack(static_cast<void*>(&participant)) == -1)
-    {
-        return false;
-    }
+    participantList.push_back(&participant);
     // Make sure that the mixed status is correct for new MixerParticipant.
     participant._mixHistory->ResetMixedStatus();
     return true;
@@ -1089,101 +983,105 @@ bool AudioConferenceMixerImpl::AddParticipantToList(
 
 bool AudioConferenceMixerImpl::RemoveParticipantFromList(
     MixerParticipant& participant,
-    ListWrapper& participantList)
+    MixerParticipantList& participantList)
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
                  "RemoveParticipantFromList(participant, participantList)");
-    ListItem* item = participantList.First();
-    while(item)
+    MixerParticipantList::iterator it = std::find(participantList.begin(),
+                                                  participantList.end(),
+                                                  &participant);
+    if(it == participantList.end())
     {
-        if(item->GetItem() == &participant)
-        {
-            participantList.Erase(item);
-            // Participant is no longer mixed, reset to default.
-            participant._mixHistory->ResetMixedStatus();
-            return true;
-        }
-        item = participantList.Next(item);
+        return false;
     }
-    return false;
+    participantList.erase(it);
+    // Participant is no longer mixed, reset to default.
+    participant._mixHistory->ResetMixedStatus();
+    return true;
 }
 
-WebRtc_Word32 AudioConferenceMixerImpl::MixFromList(
-    AudioFrame& mixedAudio,
-    const ListWrapper& audioFrameList)
+AudioFrame* AudioConferenceMixerImpl::NextScratchFrame()
 {
-    WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "MixFromList(mixedAudio, audioFrameList)");
-    WebRtc_UWord32 position = 0;
-    ListItem* item = audioFrameList.First();
-    if(item == NULL)
+    if(_scratchFramesUsed == _scratchFrames.size())
     {
-        return 0;
+        _scratchFrames.push_back(new AudioFrame());
     }
+    return _scratchFrames[_scratchFramesUsed];
+}
 
-    if(_numMixedParticipants == 1)
-    {
-        // No mixing required here; skip the saturation protection.
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        mixedAudio.CopyFrom(*audioFrame);
-        SetParticipantStatistics(&_scratchMixedParticipants[position],
-                                 *audioFrame);
-        return 0;
-    }
+void AudioConferenceMixerImpl::ReserveScratchFrame()
+{
+    assert(_scratchFramesUsed < _scratchFrames.size());
+    _scratchFramesUsed++;
+}
 
-    while(item != NULL)
+void AudioConferenceMixerImpl::AccumulateFromList(
+    AudioFrame& mixedAudio,
+    AudioFrameList& audioFrameList)
+{
+    WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
+                 "AccumulateFromList(mixedAudio, audioFrameList)");
+    const int length = _sampleSize * mixedAudio.num_channels_;
+    size_t numMixed = 0;
+    for(size_t i = 0; i < audioFrameList.size(); i++)
     {
-        if(position >= kMaximumAmountOfMixedParticipants)
+        AudioFrame* audioFrame = audioFrameList[i];
+        if(audioFrame->samples_per_channel_ != _sampleSize)
         {
-            WEBRTC_TRACE(
-                kTraceMemory,
-                kTraceAudioMixerServer,
-                _id,
-                "Trying to mix more than max amount of mixed participants:%d!",
-                kMaximumAmountOfMixedParticipants);
-            // Assert and avoid crash
-            assert(false);
-            position = 0;
+            if(audioFrame->samples_per_channel_ != 0)
+            {
+                WEBRTC_TRACE(kTraceWarning, kTraceAudioMixerServer, _id,
+                             "unable to mix %d samples, expected %d",
+                             audioFrame->samples_per_channel_, _sampleSize);
+            }
+            continue;
         }
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        MixFrames(&mixedAudio, audioFrame);
-
-        SetParticipantStatistics(&_scratchMixedParticipants[position],
-                                 *audioFrame);
-
-        position++;
-        item = audioFrameList.Next(item);
+        if(mixedAudio.num_channels_ > audioFrame->num_channels_)
+        {
+            // We only support mono-to-stereo. The frame is upmixed in place
+            // so that the mix-minus can subtract exactly what was added.
+            assert(mixedAudio.num_channels_ == 2 &&
+                   audioFrame->num_channels_ == 1);
+            if(AudioFrameOperations::MonoToStereo(audioFrame) != 0)
+            {
+                continue;
+            }
+        }
+        _mixKernels.AccumulateHalved(audioFrame->data_, length,
+                                     _mixAccumulator);
+        mixedAudio.samples_per_channel_ = _sampleSize;
+        UpdateMixedFrameInfo(&mixedAudio, *audioFrame);
+        audioFrameList[numMixed++] = audioFrame;
     }
-
-    return 0;
+    audioFrameList.resize(numMixed);
 }
 
-// TODO(andrew): consolidate this function with MixFromList.
-WebRtc_Word32 AudioConferenceMixerImpl::MixAnonomouslyFromList(
-    AudioFrame& mixedAudio,
-    const ListWrapper& audioFrameList)
+void AudioConferenceMixerImpl::MixMinusFromList(
+    const AudioFrame& mixedAudio,
+    const AudioFrameList& audioFrameList)
 {
     WEBRTC_TRACE(kTraceStream, kTraceAudioMixerServer, _id,
-                 "MixAnonomouslyFromList(mixedAudio, audioFrameList)");
-    ListItem* item = audioFrameList.First();
-    if(item == NULL)
-        return 0;
-
-    if(_numMixedParticipants == 1)
+                 "MixMinusFromList(mixedAudio, audioFrameList)");
+    const int length = _sampleSize * mixedAudio.num_channels_;
+    for(size_t i = 0; i < audioFrameList.size(); i++)
     {
-        // No mixing required here; skip the saturation protection.
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        mixedAudio.CopyFrom(*audioFrame);
-        return 0;
+        const AudioFrame* audioFrame = audioFrameList[i];
+        AudioFrame* mixMinusFrame = NextScratchFrame();
+        ReserveScratchFrame();
+        // Only the header is set here; the samples are written below.
+        mixMinusFrame->UpdateFrame(audioFrame->id_, mixedAudio.timestamp_,
+                                   NULL, 0, _outputFrequency,
+                                   mixedAudio.speech_type_,
+                                   mixedAudio.vad_activity_,
+                                   mixedAudio.num_channels_);
+        mixMinusFrame->samples_per_channel_ = _sampleSize;
+        // The mix-minus frames are not passed through the limiter. Since
+        // they are restored to full level directly from the accumulator they
+        // are hard clipped if the remaining participants saturate.
+        _mixKernels.SaturateMixMinus(_mixAccumulator, audioFrame->data_,
+                                     length, mixMinusFrame->data_);
+        _mixMinusFrames.push_back(mixMinusFrame);
     }
-
-    while(item != NULL)
-    {
-        AudioFrame* audioFrame = static_cast<AudioFrame*>(item->GetItem());
-        MixFrames(&mixedAudio, audioFrame);
-        item = audioFrameList.Next(item);
-    }
-    return 0;
 }
 
 bool AudioConferenceMixerImpl::LimitMixedAudio(AudioFrame& mixedAudio)
@@ -11,11 +11,12 @@
 #ifndef WEBRTC_MODULES_AUDIO_CONFERENCE_MIXER_SOURCE_AUDIO_CONFERENCE_MIXER_IMPL_H_
 #define WEBRTC_MODULES_AUDIO_CONFERENCE_MIXER_SOURCE_AUDIO_CONFERENCE_MIXER_IMPL_H_
 
+#include <vector>
+
 #include "audio_conference_mixer.h"
 #include "engine_configurations.h"
 #include "level_indicator.h"
-#include "list_wrapper.h"
-#include "memory_pool.h"
+#include "mix_kernels.h"
 #include "module_common_types.h"
 #include "scoped_ptr.h"
 #include "time_scheduler.h"
@@ -46,6 +47,19 @@ private:
     bool _isMixed;
 };
 
+// An AudioFrame received from a MixerParticipant, along with whether the
+// MixerParticipant was mixed in the previous mix iteration.
+struct ParticipantFrame
+{
+    MixerParticipant* participant;
+    AudioFrame* audioFrame;
+    bool wasMixed;
+};
+
+typedef std::vector<MixerParticipant*> MixerParticipantList;
+typedef std::vector<AudioFrame*> AudioFrameList;
+typedef std::vector<ParticipantFrame> ParticipantFrameList;
+
 class AudioConferenceMixerImpl : public AudioConferenceMixer
 {
 public:
@@ -80,8 +94,10 @@ public:
         MixerParticipant& participant, const bool mixable);
     virtual WebRtc_Word32 AnonymousMixabilityStatus(
         MixerParticipant& participant, bool& mixable);
+    virtual WebRtc_Word32 SetMaximumMixedParticipants(
+        const WebRtc_UWord32 maxMixedParticipants);
+    virtual WebRtc_Word32 SetMixMinusStatus(const bool enable);
 private:
-    enum{DEFAULT_AUDIO_FRAME_POOLSIZE = 50};
 
     // Set/get mix frequency
     WebRtc_Word32 SetOutputFrequency(const Frequency frequency);
@@ -91,74 +107,97 @@ private:
     // has changed.
     bool SetNumLimiterChannels(int numChannels);
 
-    // Fills mixList with the AudioFrames pointers that should be used when
-    // mixing. Fills mixParticipantList with ParticipantStatistics for the
-    // participants who's AudioFrames are inside mixList.
-    // maxAudioFrameCounter both input and output specifies how many more
-    // AudioFrames that are allowed to be mixed.
-    // rampOutList contain AudioFrames corresponding to an audio stream that
+    // Returns the number of participants that will be mixed given the
+    // current participant lists. Must be called with _cbCrit held.
+    WebRtc_UWord32 NumMixedParticipants() const;
+
+    // Fills _mixList with the AudioFrames pointers that should be used when
+    // mixing and _mixedParticipants with the MixerParticipants they belong
+    // to. At most maxAudioFrameCounter AudioFrames are selected, the ones with
+    // the highest energy among the VAD active participants first.
+    // _rampOutList contain AudioFrames corresponding to an audio stream that
     // used to be mixed but shouldn't be mixed any longer. These AudioFrames
     // should be ramped out over this AudioFrame to avoid audio discontinuities.
-    void UpdateToMix(ListWrapper& mixList, ListWrapper& rampOutList,
-                     MapWrapper& mixParticipantList,
-                     WebRtc_UWord32& maxAudioFrameCounter);
+    void UpdateToMix(WebRtc_UWord32 maxAudioFrameCounter);
 
     // Return the lowest mixing frequency that can be used without having to
     // downsample any audio.
     WebRtc_Word32 GetLowestMixingFrequency();
-    WebRtc_Word32 GetLowestMixingFrequencyFromList(ListWrapper& mixList);
-
-    // Return the AudioFrames that should be mixed anonymously.
-    void GetAdditionalAudio(ListWrapper& additionalFramesList);
+    WebRtc_Word32 GetLowestMixingFrequencyFromList(
+        const MixerParticipantList& mixList);
 
-    // Update the MixHistory of all MixerParticipants. mixedParticipantsList
-    // should contain a map of MixerParticipants that have been mixed.
-    void UpdateMixedStatus(MapWrapper& mixedParticipantsList);
+    // Fills _additionalFramesList with the AudioFrames that should be mixed
+    // anonymously.
+    void GetAdditionalAudio();
 
-    // Clears audioFrameList and reclaims all memory associated with it.
-    void ClearAudioFrameList(ListWrapper& audioFrameList);
+    // Update the MixHistory of all MixerParticipants. Only the participants in
+    // _mixedParticipants are marked as mixed.
+    void UpdateMixedStatus();
 
-    // Update the list of MixerParticipants who have a positive VAD. mixList
-    // should be a list of AudioFrames
-    void UpdateVADPositiveParticipants(
-        ListWrapper& mixList);
+    // Update the list of MixerParticipants who have a positive VAD.
+    void UpdateVADPositiveParticipants();
 
     // This function returns true if it finds the MixerParticipant in the
     // specified list of MixerParticipants.
     bool IsParticipantInList(
         MixerParticipant& participant,
-        ListWrapper& participantList);
+        const MixerParticipantList& participantList) const;
 
     // Add/remove the MixerParticipant to the specified
     // MixerParticipant list.
     bool AddParticipantToList(
         MixerParticipant& participant,
-        ListWrapper& participantList);
+        MixerParticipantList& participantList);
     bool RemoveParticipantFromList(
         MixerParticipant& removeParticipant,
-        ListWrapper& participantList);
-
-    // Mix the AudioFrames stored in audioFrameList into mixedAudio.
-    WebRtc_Word32 MixFromList(
-        AudioFrame& mixedAudio,
-        const ListWrapper& audioFrameList);
-    // Mix the AudioFrames stored in audioFrameList into mixedAudio. No
-    // record will be kept of this mix (e.g. the corresponding MixerParticipants
-    // will not be marked as IsMixed()
-    WebRtc_Word32 MixAnonomouslyFromList(AudioFrame& mixedAudio,
-                                         const ListWrapper& audioFrameList);
+        MixerParticipantList& participantList);
+
+    // Returns an AudioFrame from _scratchFrames that isn't used in this
+    // Process() call. The AudioFrame is only reserved by
+    // ReserveScratchFrame().
+    AudioFrame* NextScratchFrame();
+    void ReserveScratchFrame();
+
+    // Add the AudioFrames stored in audioFrameList to _mixAccumulator and
+    // update the speech type and VAD of mixedAudio accordingly. AudioFrames
+    // with fewer channels than mixedAudio are upmixed in place.
+    // AudioFrames that can't be mixed are removed from audioFrameList.
+    void AccumulateFromList(AudioFrame& mixedAudio,
+                            AudioFrameList& audioFrameList);
+
+    // Writes the mix without the AudioFrames in audioFrameList, one AudioFrame
+    // per entry, to _mixMinusFrames.
+    void MixMinusFromList(const AudioFrame& mixedAudio,
+                          const AudioFrameList& audioFrameList);
 
     bool LimitMixedAudio(AudioFrame& mixedAudio);
 
     // Scratch memory
     // Note that the scratch memory may only be touched in the scope of
     // Process().
-    WebRtc_UWord32         _scratchParticipantsToMixAmount;
-    ParticipantStatistics  _scratchMixedParticipants[
-        kMaximumAmountOfMixedParticipants];
-    WebRtc_UWord32         _scratchVadPositiveParticipantsAmount;
-    ParticipantStatistics  _scratchVadPositiveParticipants[
-        kMaximumAmountOfMixedParticipants];
+    WebRtc_UWord32                     _scratchParticipantsToMixAmount;
+    std::vector<ParticipantStatistics> _scratchMixedParticipants;
+    WebRtc_UWord32                     _scratchVadPositiveParticipantsAmount;
+    std::vector<ParticipantStatistics> _scratchVadPositiveParticipants;
+
+    // AudioFrames handed out by NextScratchFrame(). They are reused by every
+    // Process() call, which avoids touching the heap once the mixer has seen
+    // its largest conference.
+    AudioFrameList _scratchFrames;
+    size_t         _scratchFramesUsed;
+
+    ParticipantFrameList  _activeList;
+    ParticipantFrameList  _passiveWasMixedList;
+    ParticipantFrameList  _passiveWasNotMixedList;
+    AudioFrameList        _mixList;
+    AudioFrameList        _rampOutList;
+    AudioFrameList        _additionalFramesList;
+    MixerParticipantList  _mixedParticipants;
+    std::vector<const AudioFrame*> _mixMinusFrames;
+
+    // The mix, with each AudioFrame contributing half of its amplitude.
+    WebRtc_Word32 _mixAccumulator[AudioFrame::kMaxDataSizeSamples];
+    MixKernels    _mixKernels;
 
     scoped_ptr<CriticalSectionWrapper> _crit;
     scoped_ptr<CriticalSectionWrapper> _cbCrit;
@@ -179,12 +218,13 @@ private:
     Frequency _outputFrequency;
     WebRtc_UWord16 _sampleSize;
 
-    // Memory pool to avoid allocating/deallocating AudioFrames
-    MemoryPool<AudioFrame>* _audioFramePool;
-
     // List of all participants. Note all lists are disjunct
-    ListWrapper _participantList;              // May be mixed.
-    ListWrapper _additionalParticipantList;    // Always mixed, anonomously.
+    MixerParticipantList _participantList;           // May be mixed.
+    MixerParticipantList _additionalParticipantList; // Always mixed,
+                                                     // anonomously.
+
+    WebRtc_UWord32 _maxMixedParticipants;
+    bool           _mixMinus;
 
     WebRtc_UWord32 _numMixedParticipants;
 
@@ -0,0 +1,314 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "audio_conference_mixer.h"
+#include "audio_conference_mixer_defines.h"
+#include "gtest/gtest.h"
+#include "mix_kernels.h"
+#include "scoped_ptr.h"
+#include "tick_util.h"
+
+namespace webrtc {
+namespace {
+
+const int kSampleRateHz = 16000;
+const int kSamplesPer10Ms = kSampleRateHz / 100;
+
+// Delivers a mono frame with all samples set to |amplitude|.
+class FakeParticipant : public MixerParticipant {
+ public:
+  FakeParticipant(int id, WebRtc_Word16 amplitude, bool active)
+      : id_(id),
+        amplitude_(amplitude),
+        active_(active) {}
+
+  virtual WebRtc_Word32 GetAudioFrame(const WebRtc_Word32 id,
+                                      AudioFrame& audio_frame) {
+    WebRtc_Word16 samples[kSamplesPer10Ms];
+    for (int i = 0; i < kSamplesPer10Ms; ++i) {
+      samples[i] = amplitude_;
+    }
+    audio_frame.UpdateFrame(id_, 0, samples, kSamplesPer10Ms, kSampleRateHz,
+                            AudioFrame::kNormalSpeech,
+                            active_ ? AudioFrame::kVadActive :
+                                      AudioFrame::kVadPassive,
+                            1);
+    return 0;
+  }
+
+  virtual WebRtc_Word32 NeededFrequency(const WebRtc_Word32 id) {
+    return kSampleRateHz;
+  }
+
+  bool IsMixed() const {
+    bool mixed = false;
+    MixerParticipant::IsMixed(mixed);
+    return mixed;
+  }
+
+ private:
+  int id_;
+  WebRtc_Word16 amplitude_;
+  bool active_;
+};
+
+// Records the last sample of every mix-minus frame, by participant id.
+class MixMinusReceiver : public AudioMixerOutputReceiver {
+ public:
+  virtual void NewMixedAudio(const WebRtc_Word32 id,
+                             const AudioFrame& general_audio_frame,
+                             const AudioFrame** unique_audio_frames,
+                             const WebRtc_UWord32 size) {
+    last_samples_.clear();
+    for (WebRtc_UWord32 i = 0; i < size; ++i) {
+      const AudioFrame* frame = unique_audio_frames[i];
+      ASSERT_EQ(kSamplesPer10Ms, frame->samples_per_channel_);
+      // All samples after the ramp must be equal.
+      for (int j = kSamplesPer10Ms / 2; j < kSamplesPer10Ms; ++j) {
+        ASSERT_EQ(frame->data_[kSamplesPer10Ms - 1], frame->data_[j]);
+      }
+      last_samples_[frame->id_] = frame->data_[kSamplesPer10Ms - 1];
+    }
+  }
+
+  const std::map<int, WebRtc_Word16>& last_samples() const {
+    return last_samples_;
+  }
+
+ private:
+  std::map<int, WebRtc_Word16> last_samples_;
+};
+
+class MixedParticipantsReceiver : public AudioMixerStatusReceiver {
+ public:
+  virtual void MixedParticipants(
+      const WebRtc_Word32 id,
+      const ParticipantStatistics* participant_statistics,
+      const WebRtc_UWord32 size) {
+    mixed_.clear();
+    for (WebRtc_UWord32 i = 0; i < size; ++i) {
+      mixed_.push_back(participant_statistics[i].participant);
+    }
+  }
+  virtual void VADPositiveParticipants(
+      const WebRtc_Word32 id,
+      const ParticipantStatistics* participant_statistics,
+      const WebRtc_UWord32 size) {}
+  virtual void MixedAudioLevel(const WebRtc_Word32 id,
+                               const WebRtc_UWord32 level) {}
+
+  std::vector<int> mixed() const { return mixed_; }
+
+ private:
+  std::vector<int> mixed_;
+};
+
+class AudioConferenceMixerTest : public ::testing::Test {
+ protected:
+  AudioConferenceMixerTest() : mixer_(AudioConferenceMixer::Create(0)) {}
+
+  virtual ~AudioConferenceMixerTest() {
+    for (size_t i = 0; i < participants_.size(); ++i) {
+      mixer_->SetMixabilityStatus(*participants_[i], false);
+      delete participants_[i];
+    }
+  }
+
+  FakeParticipant* AddParticipant(WebRtc_Word16 amplitude, bool active) {
+    FakeParticipant* participant =
+        new FakeParticipant(participants_.size(), amplitude, active);
+    participants_.push_back(participant);
+    EXPECT_EQ(0, mixer_->SetMixabilityStatus(*participant, true));
+    return participant;
+  }
+
+  scoped_ptr<AudioConferenceMixer> mixer_;
+  std::vector<FakeParticipant*> participants_;
+};
+
+TEST_F(AudioConferenceMixerTest, MixesLoudestActiveParticipants) {
+  const int kNumParticipants = 20;
+  const int kMaxMixed = 5;
+  // Interleave quiet and loud participants, and add a passive participant
+  // that is louder than all of them.
+  for (int i = 0; i < kNumParticipants; ++i) {
+    AddParticipant(static_cast<WebRtc_Word16>((i % 2 ? 1000 : 100) + i), true);
+  }
+  FakeParticipant* passive = AddParticipant(10000, false);
+  MixedParticipantsReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixerStatusCallback(receiver, 1));
+  EXPECT_EQ(-1, mixer_->SetMaximumMixedParticipants(0));
+  EXPECT_EQ(0, mixer_->SetMaximumMixedParticipants(kMaxMixed));
+
+  EXPECT_EQ(0, mixer_->Process());
+
+  std::vector<int> mixed = receiver.mixed();
+  std::sort(mixed.begin(), mixed.end());
+  ASSERT_EQ(static_cast<size_t>(kMaxMixed), mixed.size());
+  for (int i = 0; i < kMaxMixed; ++i) {
+    EXPECT_EQ(kNumParticipants - 1 - 2 * (kMaxMixed - 1 - i), mixed[i]);
+  }
+  for (int i = 0; i < kNumParticipants; ++i) {
+    EXPECT_EQ(std::find(mixed.begin(), mixed.end(), i) != mixed.end(),
+              participants_[i]->IsMixed());
+  }
+  EXPECT_FALSE(passive->IsMixed());
+  EXPECT_EQ(0, mixer_->UnRegisterMixerStatusCallback());
+}
+
+// Loud frames have more energy than fits in 32 bits, but must still be
+// ranked by it.
+TEST_F(AudioConferenceMixerTest, MixesLoudestOfLoudParticipants) {
+  const int kNumParticipants = 10;
+  const int kMaxMixed = 3;
+  for (int i = 0; i < kNumParticipants; ++i) {
+    AddParticipant(static_cast<WebRtc_Word16>(20000 + 1000 * i), true);
+  }
+  MixedParticipantsReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixerStatusCallback(receiver, 1));
+  EXPECT_EQ(0, mixer_->SetMaximumMixedParticipants(kMaxMixed));
+
+  EXPECT_EQ(0, mixer_->Process());
+
+  std::vector<int> mixed = receiver.mixed();
+  std::sort(mixed.begin(), mixed.end());
+  ASSERT_EQ(static_cast<size_t>(kMaxMixed), mixed.size());
+  for (int i = 0; i < kMaxMixed; ++i) {
+    EXPECT_EQ(kNumParticipants - kMaxMixed + i, mixed[i]);
+  }
+  EXPECT_EQ(0, mixer_->UnRegisterMixerStatusCallback());
+}
+
+TEST_F(AudioConferenceMixerTest, PassiveParticipantsFillUpTheMix) {
+  AddParticipant(1000, true);
+  FakeParticipant* passive = AddParticipant(100, false);
+  MixedParticipantsReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixerStatusCallback(receiver, 1));
+
+  EXPECT_EQ(0, mixer_->Process());
+
+  EXPECT_EQ(2u, receiver.mixed().size());
+  EXPECT_TRUE(passive->IsMixed());
+  EXPECT_EQ(0, mixer_->UnRegisterMixerStatusCallback());
+}
+
+TEST_F(AudioConferenceMixerTest, MixMinusLeavesOutOwnAudio) {
+  AddParticipant(1000, true);
+  AddParticipant(2000, true);
+  AddParticipant(4000, true);
+  // Not mixed, so it gets no mix-minus frame.
+  AddParticipant(10, true);
+  MixMinusReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixedStreamCallback(receiver));
+  EXPECT_EQ(0, mixer_->SetMixMinusStatus(true));
+
+  EXPECT_EQ(0, mixer_->Process());
+
+  std::map<int, WebRtc_Word16> samples = receiver.last_samples();
+  ASSERT_EQ(3u, samples.size());
+  EXPECT_EQ(2000 + 4000, samples[0]);
+  EXPECT_EQ(1000 + 4000, samples[1]);
+  EXPECT_EQ(1000 + 2000, samples[2]);
+
+  EXPECT_EQ(0, mixer_->SetMixMinusStatus(false));
+  EXPECT_EQ(0, mixer_->Process());
+  EXPECT_TRUE(receiver.last_samples().empty());
+  EXPECT_EQ(0, mixer_->UnRegisterMixedStreamCallback());
+}
+
+TEST_F(AudioConferenceMixerTest, MixMinusSaturates) {
+  AddParticipant(30000, true);
+  AddParticipant(30000, true);
+  AddParticipant(-30000, true);
+  MixMinusReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixedStreamCallback(receiver));
+  EXPECT_EQ(0, mixer_->SetMixMinusStatus(true));
+
+  EXPECT_EQ(0, mixer_->Process());
+
+  std::map<int, WebRtc_Word16> samples = receiver.last_samples();
+  ASSERT_EQ(3u, samples.size());
+  EXPECT_EQ(0, samples[0]);
+  EXPECT_EQ(0, samples[1]);
+  EXPECT_EQ(32767, samples[2]);
+  EXPECT_EQ(0, mixer_->UnRegisterMixedStreamCallback());
+}
+
+// Times a 500 participant conference, which should be handled by one core.
+TEST_F(AudioConferenceMixerTest, FiveHundredParticipants) {
+  const int kNumParticipants = 500;
+  const int kNumIterations = 200;
+  srand(17);
+  for (int i = 0; i < kNumParticipants; ++i) {
+    AddParticipant(static_cast<WebRtc_Word16>(rand() % 16000), i % 4 != 0);
+  }
+  MixMinusReceiver receiver;
+  EXPECT_EQ(0, mixer_->RegisterMixedStreamCallback(receiver));
+  EXPECT_EQ(0, mixer_->SetMixMinusStatus(true));
+
+  const TickTime start = TickTime::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    EXPECT_EQ(0, mixer_->Process());
+  }
+  const WebRtc_Word64 elapsed_us = (TickTime::Now() - start).Microseconds();
+  printf("%d participants: %.1f us per 10 ms mix iteration\n",
+         kNumParticipants, static_cast<double>(elapsed_us) / kNumIterations);
+  EXPECT_EQ(static_cast<size_t>(AudioConferenceMixer::
+                                kMaximumAmountOfMixedParticipants),
+            receiver.last_samples().size());
+  EXPECT_EQ(0, mixer_->UnRegisterMixedStreamCallback());
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+TEST(MixKernelsTest, Sse2MatchesC) {
+  // Not a multiple of the SIMD width, to cover the tail loops.
+  const int kLength = 963;
+  MixKernels c_kernels;
+  MixKernels sse2_kernels;
+  InitMixKernels_C(&c_kernels);
+  InitMixKernels_C(&sse2_kernels);
+  InitMixKernels_SSE2(&sse2_kernels);
+
+  srand(42);
+  std::vector<WebRtc_Word16> samples(kLength);
+  std::vector<WebRtc_Word32> c_accumulator(kLength);
+  std::vector<WebRtc_Word32> sse2_accumulator(kLength);
+  for (int n = 0; n < 8; ++n) {
+    for (int i = 0; i < kLength; ++i) {
+      samples[i] = static_cast<WebRtc_Word16>(rand() % 65536 - 32768);
+    }
+    c_kernels.AccumulateHalved(&samples[0], kLength, &c_accumulator[0]);
+    sse2_kernels.AccumulateHalved(&samples[0], kLength, &sse2_accumulator[0]);
+  }
+  ASSERT_TRUE(c_accumulator == sse2_accumulator);
+
+  std::vector<WebRtc_Word16> c_out(kLength);
+  std::vector<WebRtc_Word16> sse2_out(kLength);
+  c_kernels.Saturate(&c_accumulator[0], kLength, &c_out[0]);
+  sse2_kernels.Saturate(&sse2_accumulator[0], kLength, &sse2_out[0]);
+  EXPECT_TRUE(c_out == sse2_out);
+
+  c_kernels.SaturateMixMinus(&c_accumulator[0], &samples[0], kLength,
+                             &c_out[0]);
+  sse2_kernels.SaturateMixMinus(&sse2_accumulator[0], &samples[0], kLength,
+                                &sse2_out[0]);
+  EXPECT_TRUE(c_out == sse2_out);
+}
+#endif
+
+}  // namespace
+}  // namespace webrtc
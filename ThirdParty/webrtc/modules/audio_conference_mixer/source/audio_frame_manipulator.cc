@@ -45,14 +45,23 @@ void CalculateEnergy(AudioFrame& audioFrame)
     {
         return;
     }
-    audioFrame.energy_ = 0;
+    if(audioFrame.samples_per_channel_ <= 0)
+    {
+        audioFrame.energy_ = 0;
+        return;
+    }
+    // A loud 10 ms frame easily overflows 32 bits, so accumulate with 64 bits
+    // and store the mean. It is at most 32768^2, which keeps loud frames
+    // apart when the mixer ranks participants by it, and never reaches the
+    // 0xffffffff "not calculated" marker.
+    WebRtc_UWord64 energy = 0;
     for(int position = 0; position < audioFrame.samples_per_channel_;
         position++)
     {
-        // TODO(andrew): this can easily overflow.
-        audioFrame.energy_ += audioFrame.data_[position] *
-                              audioFrame.data_[position];
+        energy += audioFrame.data_[position] * audioFrame.data_[position];
     }
+    audioFrame.energy_ = static_cast<WebRtc_UWord32>(
+        energy / audioFrame.samples_per_channel_);
 }
 
 void RampIn(AudioFrame& audioFrame)
@@ -14,7 +14,7 @@
 namespace webrtc {
 class AudioFrame;
 
-// Updates the audioFrame's energy (based on its samples).
+// Updates the audioFrame's energy: the mean square of its samples.
 void CalculateEnergy(AudioFrame& audioFrame);
 
 // Apply linear step function that ramps in/out the audio samples in audioFrame
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "mix_kernels.h"
+
+#include "cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+WebRtc_Word16 SaturateToWord16(WebRtc_Word32 value)
+{
+    if(value > 32767)
+    {
+        return 32767;
+    }
+    if(value < -32768)
+    {
+        return -32768;
+    }
+    return static_cast<WebRtc_Word16>(value);
+}
+
+void AccumulateHalved_C(const WebRtc_Word16* samples,
+                        int length,
+                        WebRtc_Word32* accumulator)
+{
+    for(int i = 0; i < length; i++)
+    {
+        accumulator[i] += samples[i] >> 1;
+    }
+}
+
+void Saturate_C(const WebRtc_Word32* accumulator,
+                int length,
+                WebRtc_Word16* mix)
+{
+    for(int i = 0; i < length; i++)
+    {
+        mix[i] = SaturateToWord16(accumulator[i]);
+    }
+}
+
+void SaturateMixMinus_C(const WebRtc_Word32* accumulator,
+                        const WebRtc_Word16* samples,
+                        int length,
+                        WebRtc_Word16* mixMinus)
+{
+    for(int i = 0; i < length; i++)
+    {
+        mixMinus[i] = SaturateToWord16(
+            2 * (accumulator[i] - (samples[i] >> 1)));
+    }
+}
+
+} // namespace
+
+void InitMixKernels_C(MixKernels* kernels)
+{
+    kernels->AccumulateHalved = AccumulateHalved_C;
+    kernels->Saturate = Saturate_C;
+    kernels->SaturateMixMinus = SaturateMixMinus_C;
+}
+
+void InitMixKernels(MixKernels* kernels)
+{
+    InitMixKernels_C(kernels);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if(WebRtc_GetCPUInfo(kSSE2))
+    {
+        InitMixKernels_SSE2(kernels);
+    }
+#endif
+}
+
+} // namespace webrtc
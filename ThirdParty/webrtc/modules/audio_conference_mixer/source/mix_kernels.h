@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_CONFERENCE_MIXER_SOURCE_MIX_KERNELS_H_
+#define WEBRTC_MODULES_AUDIO_CONFERENCE_MIXER_SOURCE_MIX_KERNELS_H_
+
+#include "typedefs.h"
+
+namespace webrtc {
+
+// Sample loops used by the mixer. The mix is accumulated with 32 bits of
+// precision, so that saturation only happens once, when the mix is written
+// out. Every contribution is halved to leave headroom for the limiter.
+struct MixKernels
+{
+    // accumulator[i] += samples[i] >> 1 for |length| samples.
+    void (*AccumulateHalved)(const WebRtc_Word16* samples,
+                             int length,
+                             WebRtc_Word32* accumulator);
+
+    // mix[i] = saturate(accumulator[i]) for |length| samples.
+    void (*Saturate)(const WebRtc_Word32* accumulator,
+                     int length,
+                     WebRtc_Word16* mix);
+
+    // mixMinus[i] = saturate(2 * (accumulator[i] - (samples[i] >> 1))) for
+    // |length| samples, i.e., the mix without |samples|, at full level.
+    void (*SaturateMixMinus)(const WebRtc_Word32* accumulator,
+                             const WebRtc_Word16* samples,
+                             int length,
+                             WebRtc_Word16* mixMinus);
+};
+
+// Fills |kernels| with the plain C implementations.
+void InitMixKernels_C(MixKernels* kernels);
+
+// Fills |kernels| with the fastest implementations supported by the CPU.
+void InitMixKernels(MixKernels* kernels);
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Replaces the kernels in |kernels| with SSE2 implementations.
+void InitMixKernels_SSE2(MixKernels* kernels);
+#endif
+
+} // namespace webrtc
+
+#endif // WEBRTC_MODULES_AUDIO_CONFERENCE_MIXER_SOURCE_MIX_KERNELS_H_
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "mix_kernels.h"
+
+#include <emmintrin.h>
+
+namespace webrtc {
+namespace {
+
+// The kernels process eight samples per iteration, and finish the last
+// (length % 8) samples one at a time. Unaligned loads and stores are used
+// throughout since AudioFrame data is only guaranteed to be 2-byte aligned.
+
+void AccumulateHalved_SSE2(const WebRtc_Word16* samples,
+                           int length,
+                           WebRtc_Word32* accumulator)
+{
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128i in = _mm_srai_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&samples[i])),
+            1);
+        // Sign extend to 32 bits by placing each sample in the upper half of
+        // a 32-bit lane and shifting it back down.
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+        __m128i* acc = reinterpret_cast<__m128i*>(&accumulator[i]);
+        _mm_storeu_si128(acc, _mm_add_epi32(_mm_loadu_si128(acc), low));
+        _mm_storeu_si128(acc + 1,
+                         _mm_add_epi32(_mm_loadu_si128(acc + 1), high));
+    }
+    for(; i < length; i++)
+    {
+        accumulator[i] += samples[i] >> 1;
+    }
+}
+
+void Saturate_SSE2(const WebRtc_Word32* accumulator,
+                   int length,
+                   WebRtc_Word16* mix)
+{
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128i* acc = reinterpret_cast<const __m128i*>(&accumulator[i]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&mix[i]),
+                         _mm_packs_epi32(_mm_loadu_si128(acc),
+                                         _mm_loadu_si128(acc + 1)));
+    }
+    for(; i < length; i++)
+    {
+        const WebRtc_Word32 value = accumulator[i];
+        mix[i] = static_cast<WebRtc_Word16>(
+            value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+    }
+}
+
+void SaturateMixMinus_SSE2(const WebRtc_Word32* accumulator,
+                           const WebRtc_Word16* samples,
+                           int length,
+                           WebRtc_Word16* mixMinus)
+{
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128i in = _mm_srai_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&samples[i])),
+            1);
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+        const __m128i* acc = reinterpret_cast<const __m128i*>(&accumulator[i]);
+        __m128i restLow = _mm_sub_epi32(_mm_loadu_si128(acc), low);
+        __m128i restHigh = _mm_sub_epi32(_mm_loadu_si128(acc + 1), high);
+        restLow = _mm_add_epi32(restLow, restLow);
+        restHigh = _mm_add_epi32(restHigh, restHigh);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&mixMinus[i]),
+                         _mm_packs_epi32(restLow, restHigh));
+    }
+    for(; i < length; i++)
+    {
+        const WebRtc_Word32 value =
+            2 * (accumulator[i] - (samples[i] >> 1));
+        mixMinus[i] = static_cast<WebRtc_Word16>(
+            value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+    }
+}
+
+} // namespace
+
+void InitMixKernels_SSE2(MixKernels* kernels)
+{
+    kernels->AccumulateHalved = AccumulateHalved_SSE2;
+    kernels->Saturate = Saturate_SSE2;
+    kernels->SaturateMixMinus = SaturateMixMinus_SSE2;
+}
+
+} // namespace webrtc
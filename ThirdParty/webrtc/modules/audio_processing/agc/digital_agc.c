@@ -20,6 +20,7 @@
 #include <stdio.h>
 #endif
 
+#include "cpu_features_wrapper.h"
 #include "gain_control.h"
 
 // To generate the gaintable, copy&paste the following lines to a Matlab window:
@@ -258,6 +259,54 @@ WebRtc_Word32 WebRtcAgc_CalculateGainTable(WebRtc_Word32 *gainTable, // Q16
     return 0;
 }
 
+WebRtcAgc_CalculateEnvelope_t WebRtcAgc_CalculateEnvelope;
+WebRtcAgc_ApplyGains_t WebRtcAgc_ApplyGains;
+
+static void CalculateEnvelope(const WebRtc_Word16 *in, WebRtc_Word16 L,
+                              WebRtc_Word32 *env)
+{
+    WebRtc_Word32 nrg, max_nrg;
+    WebRtc_Word16 k, n;
+
+    // iterate over sub frames
+    for (k = 0; k < 10; k++)
+    {
+        // iterate over samples
+        max_nrg = 0;
+        for (n = 0; n < L; n++)
+        {
+            nrg = WEBRTC_SPL_MUL_16_16(in[k * L + n], in[k * L + n]);
+            if (nrg > max_nrg)
+            {
+                max_nrg = nrg;
+            }
+        }
+        env[k] = max_nrg;
+    }
+}
+
+static void ApplyGains(const WebRtc_Word32 *gains, WebRtc_Word16 L,
+                       WebRtc_Word16 L2, WebRtc_Word16 *out)
+{
+    WebRtc_Word32 tmp32, gain32, delta;
+    WebRtc_Word16 k, n;
+
+    // iterate over subframes
+    for (k = 1; k < 10; k++)
+    {
+        delta = WEBRTC_SPL_LSHIFT_W32(gains[k+1] - gains[k], (4 - L2));
+        gain32 = WEBRTC_SPL_LSHIFT_W32(gains[k], 4);
+        // iterate over samples
+        for (n = 0; n < L; n++)
+        {
+            tmp32 = WEBRTC_SPL_MUL((WebRtc_Word32)out[k * L + n],
+                                   WEBRTC_SPL_RSHIFT_W32(gain32, 4));
+            out[k * L + n] = (WebRtc_Word16)WEBRTC_SPL_RSHIFT_W32(tmp32 , 16);
+            gain32 += delta;
+        }
+    }
+}
+
 WebRtc_Word32 WebRtcAgc_InitDigital(DigitalAgc_t *stt, WebRtc_Word16 agcMode)
 {
 
@@ -282,6 +331,17 @@ WebRtc_Word32 WebRtcAgc_InitDigital(DigitalAgc_t *stt, WebRtc_Word16 agcMode)
     WebRtcAgc_InitVad(&stt->vadNearend);
     WebRtcAgc_InitVad(&stt->vadFarend);
 
+    // Assembly optimization
+    WebRtcAgc_CalculateEnvelope = CalculateEnvelope;
+    WebRtcAgc_ApplyGains = ApplyGains;
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if (WebRtc_GetCPUInfo(kSSE2))
+    {
+        WebRtcAgc_InitDigital_SSE2();
+    }
+#endif
+
     return 0;
 }
 
@@ -310,7 +370,6 @@ WebRtc_Word32 WebRtcAgc_ProcessDigital(DigitalAgc_t *stt, const WebRtc_Word16 *i
 
     WebRtc_Word32 out_tmp, tmp32;
     WebRtc_Word32 env[10];
-    WebRtc_Word32 nrg, max_nrg;
     WebRtc_Word32 cur_level;
     WebRtc_Word32 gain32, delta;
     WebRtc_Word16 logratio;
@@ -407,21 +466,7 @@ WebRtc_Word32 WebRtcAgc_ProcessDigital(DigitalAgc_t *stt, const WebRtc_Word16 *i
     fprintf(stt->logFile, "%5.2f\t%d\t%d\t%d\t", (float)(stt->frameCounter) / 100, logratio, decay, stt->vadNearend.stdLongTerm);
 #endif
     // Find max amplitude per sub frame
-    // iterate over sub frames
-    for (k = 0; k < 10; k++)
-    {
-        // iterate over samples
-        max_nrg = 0;
-        for (n = 0; n < L; n++)
-        {
-            nrg = WEBRTC_SPL_MUL_16_16(out[k * L + n], out[k * L + n]);
-            if (nrg > max_nrg)
-            {
-                max_nrg = nrg;
-            }
-        }
-        env[k] = max_nrg;
-    }
+    WebRtcAgc_CalculateEnvelope(out, L, env);
 
     // Calculate gain per sub frame
     gains[0] = stt->gain;
@@ -608,26 +653,10 @@ WebRtc_Word32 WebRtcAgc_ProcessDigital(DigitalAgc_t *stt, const WebRtc_Word16 *i
         gain32 += delta;
     }
     // iterate over subframes
-    for (k = 1; k < 10; k++)
+    WebRtcAgc_ApplyGains(gains, L, L2, out);
+    if (FS == 32000)
     {
-        delta = WEBRTC_SPL_LSHIFT_W32(gains[k+1] - gains[k], (4 - L2));
-        gain32 = WEBRTC_SPL_LSHIFT_W32(gains[k], 4);
-        // iterate over samples
-        for (n = 0; n < L; n++)
-        {
-            // For lower band
-            tmp32 = WEBRTC_SPL_MUL((WebRtc_Word32)out[k * L + n],
-                                   WEBRTC_SPL_RSHIFT_W32(gain32, 4));
-            out[k * L + n] = (WebRtc_Word16)WEBRTC_SPL_RSHIFT_W32(tmp32 , 16);
-            // For higher band
-            if (FS == 32000)
-            {
-                tmp32 = WEBRTC_SPL_MUL((WebRtc_Word32)out_H[k * L + n],
-                                       WEBRTC_SPL_RSHIFT_W32(gain32, 4));
-                out_H[k * L + n] = (WebRtc_Word16)WEBRTC_SPL_RSHIFT_W32(tmp32 , 16);
-            }
-            gain32 += delta;
-        }
+        WebRtcAgc_ApplyGains(gains, L, L2, out_H);
     }
 
     return 0;
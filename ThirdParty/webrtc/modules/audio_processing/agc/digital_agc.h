@@ -73,4 +73,25 @@ WebRtc_Word32 WebRtcAgc_CalculateGainTable(WebRtc_Word32 *gainTable, // Q16
                                  WebRtc_Word16 targetLevelDbfs,// Q0 (in dB)
                                  WebRtc_UWord8 limiterEnable, WebRtc_Word16 analogTarget);
 
+// Function pointers for the speed-critical parts of WebRtcAgc_ProcessDigital.
+// They are set by WebRtcAgc_InitDigital, to the SSE2 versions when the CPU
+// supports them. The SSE2 versions are bit-exact with the C versions.
+
+// Stores the maximum energy of each of the 10 subframes of |in| in |env|.
+typedef void (*WebRtcAgc_CalculateEnvelope_t)(const WebRtc_Word16 *in,
+                                              WebRtc_Word16 subframeLength,
+                                              WebRtc_Word32 *env);
+extern WebRtcAgc_CalculateEnvelope_t WebRtcAgc_CalculateEnvelope;
+
+// Applies |gains|, interpolated over each subframe, to subframes 1 to 9 of
+// |out|. The first subframe also needs a saturation check and is left to the
+// caller.
+typedef void (*WebRtcAgc_ApplyGains_t)(const WebRtc_Word32 *gains,
+                                       WebRtc_Word16 subframeLength,
+                                       WebRtc_Word16 subframeLengthLog2,
+                                       WebRtc_Word16 *out);
+extern WebRtcAgc_ApplyGains_t WebRtcAgc_ApplyGains;
+
+void WebRtcAgc_InitDigital_SSE2(void);
+
 #endif // WEBRTC_MODULES_AUDIO_PROCESSING_AGC_MAIN_SOURCE_ANALOG_AGC_H_
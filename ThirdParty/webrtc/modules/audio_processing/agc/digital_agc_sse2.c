@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * The digital AGC, SSE2 version of speed-critical functions.
+ */
+
+#include "digital_agc.h"
+
+#include <emmintrin.h>
+
+// Returns the low 32 bits of the products of the 32-bit lanes, like the
+// SSE4.1 _mm_mullo_epi32(). These are the same for signed and unsigned
+// operands.
+static __inline __m128i MulLo32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32),
+                                      _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Returns the largest of the 16-bit lanes of |max| and the smallest of those
+// of |min|.
+static __inline void HorizontalMaxMin(__m128i max, __m128i min,
+                                      WebRtc_Word16 *max_value,
+                                      WebRtc_Word16 *min_value)
+{
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 8));
+    min = _mm_min_epi16(min, _mm_srli_si128(min, 8));
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 4));
+    min = _mm_min_epi16(min, _mm_srli_si128(min, 4));
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 2));
+    min = _mm_min_epi16(min, _mm_srli_si128(min, 2));
+    *max_value = (WebRtc_Word16)_mm_cvtsi128_si32(max);
+    *min_value = (WebRtc_Word16)_mm_cvtsi128_si32(min);
+}
+
+static void CalculateEnvelopeSSE2(const WebRtc_Word16 *in, WebRtc_Word16 L,
+                                  WebRtc_Word32 *env)
+{
+    WebRtc_Word32 max_nrg, min_nrg;
+    WebRtc_Word16 max_value, min_value;
+    WebRtc_Word16 k, n;
+
+    // Subframes are 8 or 16 samples long. The largest energy belongs to
+    // either the largest or the smallest sample, which SSE2 can find on 16-bit
+    // lanes directly.
+    for (k = 0; k < 10; k++)
+    {
+        const WebRtc_Word16 *subframe = &in[k * L];
+        __m128i max = _mm_loadu_si128((const __m128i *)subframe);
+        __m128i min = max;
+        for (n = 8; n < L; n += 8)
+        {
+            const __m128i x = _mm_loadu_si128((const __m128i *)&subframe[n]);
+            max = _mm_max_epi16(max, x);
+            min = _mm_min_epi16(min, x);
+        }
+        HorizontalMaxMin(max, min, &max_value, &min_value);
+        max_nrg = WEBRTC_SPL_MUL_16_16(max_value, max_value);
+        min_nrg = WEBRTC_SPL_MUL_16_16(min_value, min_value);
+        env[k] = max_nrg > min_nrg ? max_nrg : min_nrg;
+    }
+}
+
+static void ApplyGainsSSE2(const WebRtc_Word32 *gains, WebRtc_Word16 L,
+                           WebRtc_Word16 L2, WebRtc_Word16 *out)
+{
+    WebRtc_Word32 gain32, delta;
+    WebRtc_Word16 k, n;
+
+    for (k = 1; k < 10; k++)
+    {
+        delta = WEBRTC_SPL_LSHIFT_W32(gains[k+1] - gains[k], (4 - L2));
+        gain32 = WEBRTC_SPL_LSHIFT_W32(gains[k], 4);
+        {
+            // The interpolated gain of each of the next eight samples. The
+            // sums wrap around like the C version's, but without relying on
+            // signed overflow.
+            const WebRtc_UWord32 g = (WebRtc_UWord32)gain32;
+            const WebRtc_UWord32 d = (WebRtc_UWord32)delta;
+            const __m128i step = _mm_set1_epi32((int)(8 * d));
+            __m128i gain_lo = _mm_setr_epi32((int)g, (int)(g + d),
+                                             (int)(g + 2 * d),
+                                             (int)(g + 3 * d));
+            __m128i gain_hi = _mm_add_epi32(gain_lo,
+                                            _mm_set1_epi32((int)(4 * d)));
+            WebRtc_Word16 *subframe = &out[k * L];
+            for (n = 0; n < L; n += 8)
+            {
+                const __m128i x = _mm_loadu_si128((__m128i *)&subframe[n]);
+                // Sign extend the samples to 32 bits.
+                const __m128i x_lo =
+                    _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+                const __m128i x_hi =
+                    _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+                __m128i y_lo = MulLo32(x_lo, _mm_srai_epi32(gain_lo, 4));
+                __m128i y_hi = MulLo32(x_hi, _mm_srai_epi32(gain_hi, 4));
+                // For the upper band, which the gain doesn't follow, the
+                // product can overflow 32 bits; MulLo32 wraps like the C
+                // multiplication. Any 32-bit value shifted right by 16 fits
+                // in 16 bits, so the saturating pack never saturates and
+                // matches the C cast without masking.
+                y_lo = _mm_srai_epi32(y_lo, 16);
+                y_hi = _mm_srai_epi32(y_hi, 16);
+                _mm_storeu_si128((__m128i *)&subframe[n],
+                                 _mm_packs_epi32(y_lo, y_hi));
+                gain_lo = _mm_add_epi32(gain_lo, step);
+                gain_hi = _mm_add_epi32(gain_hi, step);
+            }
+        }
+    }
+}
+
+void WebRtcAgc_InitDigital_SSE2(void)
+{
+    WebRtcAgc_CalculateEnvelope = CalculateEnvelopeSSE2;
+    WebRtcAgc_ApplyGains = ApplyGainsSSE2;
+}
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "cpu_features_wrapper.h"
+#include "gain_control.h"
+#include "gtest/gtest.h"
+#include "tick_util.h"
+#include "typedefs.h"
+extern "C" {
+#include "digital_agc.h"
+}
+
+namespace webrtc {
+namespace {
+
+const int kNumFrames = 500;
+
+// Speech-like bursts whose level sweeps over 40 dB, so that the compressor,
+// the gate and the limiter all kick in. Full scale samples are included, to
+// cover the extremes of the envelope. The gain only follows the lower band,
+// so the upper band is kept near full scale, where applying a gain above
+// unity overflows and wraps.
+void GenerateInput(int num_frames, std::vector<WebRtc_Word16>* low,
+                   std::vector<WebRtc_Word16>* high) {
+  srand(17);
+  low->resize(num_frames * 160);
+  high->resize(num_frames * 160);
+  for (size_t i = 0; i < low->size(); ++i) {
+    const float t = static_cast<float>(i) / 16000;
+    const float level = pow(10.0f, -2.0f * fabs(sin(2 * 3.14159f * 0.7f * t)));
+    const float burst = sin(2 * 3.14159f * 3 * t) > 0 ? 1.0f : 0.05f;
+    const float tone = sin(2 * 3.14159f * 220 * t) +
+        0.5f * sin(2 * 3.14159f * 660 * t);
+    const float noise = (rand() % 201 - 100) * 0.01f;
+    const float sample = 25000 * level * burst * (tone + noise);
+    (*low)[i] = static_cast<WebRtc_Word16>(
+        sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample));
+    const float high_sample = 30000 * (tone + noise);
+    (*high)[i] = static_cast<WebRtc_Word16>(high_sample > 32767 ? 32767 :
+        (high_sample < -32768 ? -32768 : high_sample));
+  }
+  (*low)[1000] = 32767;
+  (*low)[2000] = -32768;
+}
+
+// Runs the fixed digital AGC over the whole input with the kernels that
+// WebRtcAgc_InitDigital() picks.
+void Process(int sample_rate_hz, const std::vector<WebRtc_Word16>& low,
+             const std::vector<WebRtc_Word16>& high,
+             std::vector<WebRtc_Word16>* out_low,
+             std::vector<WebRtc_Word16>* out_high) {
+  const int frame_length = sample_rate_hz == 8000 ? 80 : 160;
+  DigitalAgc_t agc;
+  ASSERT_EQ(0, WebRtcAgc_InitDigital(&agc, kAgcModeFixedDigital));
+  ASSERT_EQ(0, WebRtcAgc_CalculateGainTable(agc.gainTable, 12, 3, 1, 0));
+  out_low->resize(low.size());
+  out_high->resize(high.size());
+  for (size_t i = 0; i + frame_length <= low.size(); i += frame_length) {
+    ASSERT_EQ(0, WebRtcAgc_ProcessDigital(&agc, &low[i], &high[i],
+                                          &(*out_low)[i], &(*out_high)[i],
+                                          sample_rate_hz, 0));
+  }
+}
+
+class DigitalAgcTest : public ::testing::Test {
+ protected:
+  DigitalAgcTest() : get_cpu_info_(WebRtc_GetCPUInfo) {}
+
+  virtual ~DigitalAgcTest() {
+    WebRtc_GetCPUInfo = get_cpu_info_;
+  }
+
+  bool HasSse2() const {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    return get_cpu_info_(kSSE2) != 0;
+#else
+    return false;
+#endif
+  }
+
+  // Processes the same input with the C kernels and with the SSE2 kernels.
+  void VerifyBitExact(int sample_rate_hz) {
+    std::vector<WebRtc_Word16> low, high;
+    GenerateInput(kNumFrames, &low, &high);
+
+    std::vector<WebRtc_Word16> c_low, c_high;
+    WebRtc_GetCPUInfo = WebRtc_GetCPUInfoNoASM;
+    Process(sample_rate_hz, low, high, &c_low, &c_high);
+
+    std::vector<WebRtc_Word16> sse2_low, sse2_high;
+    WebRtc_GetCPUInfo = get_cpu_info_;
+    Process(sample_rate_hz, low, high, &sse2_low, &sse2_high);
+
+    EXPECT_TRUE(c_low == sse2_low);
+    if (sample_rate_hz == 32000) {
+      EXPECT_TRUE(c_high == sse2_high);
+    }
+    // Make sure the test exercised the gain.
+    EXPECT_FALSE(c_low == low);
+  }
+
+  WebRtc_CPUInfo get_cpu_info_;
+};
+
+TEST_F(DigitalAgcTest, Sse2MatchesCAt8kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(8000);
+}
+
+TEST_F(DigitalAgcTest, Sse2MatchesCAt16kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(16000);
+}
+
+TEST_F(DigitalAgcTest, Sse2MatchesCAt32kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(32000);
+}
+
+TEST_F(DigitalAgcTest, Sse2Timing) {
+  if (!HasSse2()) {
+    return;
+  }
+  const int kNumRuns = 20;
+  std::vector<WebRtc_Word16> low, high;
+  GenerateInput(kNumFrames, &low, &high);
+  std::vector<WebRtc_Word16> out_low, out_high;
+  WebRtc_Word64 elapsed_us[2];
+  for (int sse2 = 0; sse2 < 2; ++sse2) {
+    WebRtc_GetCPUInfo = sse2 ? get_cpu_info_ : WebRtc_GetCPUInfoNoASM;
+    const TickTime start = TickTime::Now();
+    for (int i = 0; i < kNumRuns; ++i) {
+      Process(32000, low, high, &out_low, &out_high);
+    }
+    elapsed_us[sse2] = (TickTime::Now() - start).Microseconds();
+  }
+  printf("Digital AGC, 32 kHz: C %.2f us, SSE2 %.2f us per 10 ms\n",
+         static_cast<double>(elapsed_us[0]) / (kNumRuns * kNumFrames),
+         static_cast<double>(elapsed_us[1]) / (kNumRuns * kNumFrames));
+}
+
+}  // namespace
+}  // namespace webrtc
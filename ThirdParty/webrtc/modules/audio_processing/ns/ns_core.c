@@ -12,12 +12,107 @@
 #include <math.h>
 //#include <stdio.h>
 #include <stdlib.h>
+#include "cpu_features_wrapper.h"
 #include "noise_suppression.h"
 #include "ns_core.h"
 #include "windows_private.h"
 #include "fft4g.h"
 #include "signal_processing_library.h"
 
+WebRtcNs_MagnitudeSpectrum_t WebRtcNs_MagnitudeSpectrum;
+WebRtcNs_PriorSnr_t WebRtcNs_PriorSnr;
+WebRtcNs_WienerFilter_t WebRtcNs_WienerFilter;
+WebRtcNs_ApplyFilter_t WebRtcNs_ApplyFilter;
+
+static void MagnitudeSpectrum(const float* fft,
+                              int magnLen,
+                              float* real,
+                              float* imag,
+                              float* magn) {
+  int i;
+  float fTmp;
+
+  for (i = 1; i < magnLen - 1; i++) {
+    real[i] = fft[2 * i];
+    imag[i] = fft[2 * i + 1];
+    fTmp = real[i] * real[i];
+    fTmp += imag[i] * imag[i];
+    magn[i] = ((float)sqrt(fTmp)) + 1.0f;
+  }
+}
+
+static void PriorSnr(NSinst_t* inst,
+                     const float* magn,
+                     const float* noise,
+                     float* snrLocPost,
+                     float* snrLocPrior,
+                     float* previousEstimateStsa) {
+  int i;
+
+  for (i = 0; i < inst->magnLen; i++) {
+    // post snr
+    snrLocPost[i] = (float)0.0;
+    if (magn[i] > noise[i]) {
+      snrLocPost[i] = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
+    }
+    // previous post snr
+    // previous estimate: based on previous frame with gain filter
+    previousEstimateStsa[i] = inst->magnPrev[i] / (inst->noisePrev[i] + (float)0.0001)
+                              * (inst->smooth[i]);
+    // DD estimate is sum of two terms: current estimate and previous estimate
+    // directed decision update of snrPrior
+    snrLocPrior[i] = DD_PR_SNR * previousEstimateStsa[i] + ((float)1.0 - DD_PR_SNR)
+                     * snrLocPost[i];
+    // post and prior snr needed for step 2
+  }
+}
+
+static void WienerFilter(NSinst_t* inst,
+                         const float* magn,
+                         const float* noise,
+                         const float* previousEstimateStsa,
+                         float* theFilter) {
+  int i;
+  float currentEstimateStsa, snrPrior;
+
+  for (i = 0; i < inst->magnLen; i++) {
+    // post and prior snr
+    currentEstimateStsa = (float)0.0;
+    if (magn[i] > noise[i]) {
+      currentEstimateStsa = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
+    }
+    // DD estimate is sume of two terms: current estimate and previous estimate
+    // directed decision update of snrPrior
+    snrPrior = DD_PR_SNR * previousEstimateStsa[i] + ((float)1.0 - DD_PR_SNR)
+               * currentEstimateStsa;
+    // gain filter
+    theFilter[i] = snrPrior / (inst->overdrive + snrPrior);
+  }
+}
+
+static void ApplyFilter(NSinst_t* inst,
+                        const float* theFilter,
+                        float* real,
+                        float* imag) {
+  int i;
+  float gain;
+
+  for (i = 0; i < inst->magnLen; i++) {
+    gain = theFilter[i];
+    // flooring bottom
+    if (gain < inst->denoiseBound) {
+      gain = inst->denoiseBound;
+    }
+    // flooring top
+    if (gain > (float)1.0) {
+      gain = 1.0;
+    }
+    inst->smooth[i] = gain;
+    real[i] *= gain;
+    imag[i] *= gain;
+  }
+}
+
 // Set Feature Extraction Parameters
 void WebRtcNs_set_feature_extraction_parameters(NSinst_t* inst) {
   //bin size of histogram
@@ -202,6 +297,18 @@ int WebRtcNs_InitCore(NSinst_t* inst, WebRtc_UWord32 fs) {
 
   memset(inst->outBuf, 0, sizeof(float) * 3 * BLOCKL_MAX);
 
+  // Assembly optimization
+  WebRtcNs_MagnitudeSpectrum = MagnitudeSpectrum;
+  WebRtcNs_PriorSnr = PriorSnr;
+  WebRtcNs_WienerFilter = WienerFilter;
+  WebRtcNs_ApplyFilter = ApplyFilter;
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    WebRtcNs_InitCore_SSE2();
+  }
+#endif
+
   inst->initFlag = 1;
   return 0;
 }
@@ -728,7 +835,6 @@ int WebRtcNs_ProcessCore(NSinst_t* inst,
 
   float   energy1, energy2, gain, factor, factor1, factor2;
   float   signalEnergy, sumMagn;
-  float   snrPrior, currentEstimateStsa;
   float   tmpFloat1, tmpFloat2, tmpFloat3, probSpeech, probNonSpeech;
   float   gammaNoiseTmp, gammaNoiseOld;
   float   noiseUpdateTmp, fTmp, dTmp;
@@ -884,14 +990,13 @@ int WebRtcNs_ProcessCore(NSinst_t* inst,
       sum_log_magn = tmpFloat1;
       sum_log_i_log_magn = tmpFloat2 * tmpFloat1;
     }
+    // magnitude spectrum
+    WebRtcNs_MagnitudeSpectrum(winData, inst->magnLen, real, imag, magn);
     for (i = 1; i < inst->magnLen - 1; i++) {
-      real[i] = winData[2 * i];
-      imag[i] = winData[2 * i + 1];
-      // magnitude spectrum
+      // Summed in bin order, so that the totals don't depend on the kernel.
       fTmp = real[i] * real[i];
       fTmp += imag[i] * imag[i];
       signalEnergy += fTmp;
-      magn[i] = ((float)sqrt(fTmp)) + 1.0f;
       sumMagn += magn[i];
       if (inst->blockInd < END_STARTUP_SHORT) {
         inst->initMagnEst[i] += magn[i];
@@ -991,22 +1096,8 @@ int WebRtcNs_ProcessCore(NSinst_t* inst,
     //
 
     // compute DD estimate of prior SNR: needed for new method
-    for (i = 0; i < inst->magnLen; i++) {
-      // post snr
-      snrLocPost[i] = (float)0.0;
-      if (magn[i] > noise[i]) {
-        snrLocPost[i] = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
-      }
-      // previous post snr
-      // previous estimate: based on previous frame with gain filter
-      previousEstimateStsa[i] = inst->magnPrev[i] / (inst->noisePrev[i] + (float)0.0001)
-                                * (inst->smooth[i]);
-      // DD estimate is sum of two terms: current estimate and previous estimate
-      // directed decision update of snrPrior
-      snrLocPrior[i] = DD_PR_SNR * previousEstimateStsa[i] + ((float)1.0 - DD_PR_SNR)
-                       * snrLocPost[i];
-      // post and prior snr needed for step 2
-    } // end of loop over freqs
+    WebRtcNs_PriorSnr(inst, magn, noise, snrLocPost, snrLocPrior,
+                      previousEstimateStsa);
 #ifdef PROCESS_FLOW_1
     for (i = 0; i < inst->magnLen; i++) {
       // gain filter
@@ -1091,25 +1182,16 @@ int WebRtcNs_ProcessCore(NSinst_t* inst,
     //
     // STEP 3: compute dd update of prior snr and post snr based on new noise estimate
     //
-    for (i = 0; i < inst->magnLen; i++) {
-      // post and prior snr
-      currentEstimateStsa = (float)0.0;
-      if (magn[i] > noise[i]) {
-        currentEstimateStsa = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
-      }
-      // DD estimate is sume of two terms: current estimate and previous estimate
-      // directed decision update of snrPrior
-      snrPrior = DD_PR_SNR * previousEstimateStsa[i] + ((float)1.0 - DD_PR_SNR)
-                 * currentEstimateStsa;
-      // gain filter
-      tmpFloat1 = inst->overdrive + snrPrior;
-      tmpFloat2 = (float)snrPrior / tmpFloat1;
-      theFilter[i] = (float)tmpFloat2;
-    } // end of loop over freqs
+    WebRtcNs_WienerFilter(inst, magn, noise, previousEstimateStsa, theFilter);
     // done with step3
 #endif
 #endif
 
+#ifndef PROCESS_FLOW_0
+    if (inst->blockInd >= END_STARTUP_SHORT) {
+      WebRtcNs_ApplyFilter(inst, theFilter, real, imag);
+    } else
+#endif
     for (i = 0; i < inst->magnLen; i++) {
       // flooring bottom
       if (theFilter[i] < inst->denoiseBound) {
@@ -12,6 +12,7 @@
 #define WEBRTC_MODULES_AUDIO_PROCESSING_NS_MAIN_SOURCE_NS_CORE_H_
 
 #include "defines.h"
+#include "typedefs.h"
 
 typedef struct NSParaExtract_t_ {
 
@@ -172,6 +173,50 @@ int WebRtcNs_ProcessCore(NSinst_t* inst,
                          short* outFrameLow,
                          short* outFrameHigh);
 
+/****************************************************************************
+ * Function pointers for the speed-critical parts of WebRtcNs_ProcessCore.
+ * They are set by WebRtcNs_InitCore, to the SSE2 versions when the CPU
+ * supports them. All of them work per frequency bin, so the SSE2 versions
+ * are bit-exact with the C versions.
+ */
+
+// Splits the packed output of the forward FFT into |real| and |imag| and
+// computes the magnitude spectrum, for bins 1 to |magnLen| - 2.
+typedef void (*WebRtcNs_MagnitudeSpectrum_t)(const float* fft,
+                                             int magnLen,
+                                             float* real,
+                                             float* imag,
+                                             float* magn);
+extern WebRtcNs_MagnitudeSpectrum_t WebRtcNs_MagnitudeSpectrum;
+
+// Computes the post SNR and the decision-directed estimate of the prior SNR.
+typedef void (*WebRtcNs_PriorSnr_t)(NSinst_t* inst,
+                                    const float* magn,
+                                    const float* noise,
+                                    float* snrLocPost,
+                                    float* snrLocPrior,
+                                    float* previousEstimateStsa);
+extern WebRtcNs_PriorSnr_t WebRtcNs_PriorSnr;
+
+// Computes the Wiener filter from the updated noise estimate.
+typedef void (*WebRtcNs_WienerFilter_t)(NSinst_t* inst,
+                                        const float* magn,
+                                        const float* noise,
+                                        const float* previousEstimateStsa,
+                                        float* theFilter);
+extern WebRtcNs_WienerFilter_t WebRtcNs_WienerFilter;
+
+// Floors the filter to [denoiseBound, 1], stores it as the smoothed filter
+// and applies it to the spectrum. Not used during startup, where the filter
+// is mixed with the parametric noise model.
+typedef void (*WebRtcNs_ApplyFilter_t)(NSinst_t* inst,
+                                       const float* theFilter,
+                                       float* real,
+                                       float* imag);
+extern WebRtcNs_ApplyFilter_t WebRtcNs_ApplyFilter;
+
+void WebRtcNs_InitCore_SSE2(void);
+
 
 #ifdef __cplusplus
 }
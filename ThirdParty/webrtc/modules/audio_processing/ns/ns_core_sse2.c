@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * The core noise suppression algorithm, SSE2 version of speed-critical
+ * functions. Every operation is done per bin in the same order as in the C
+ * versions, so the results are bit-exact.
+ */
+
+#include "ns_core.h"
+
+#include <emmintrin.h>
+#include <math.h>
+
+static void MagnitudeSpectrumSSE2(const float* fft,
+                                  int magnLen,
+                                  float* real,
+                                  float* imag,
+                                  float* magn) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  int i;
+  float fTmp;
+
+  for (i = 1; i + 4 <= magnLen - 1; i += 4) {
+    const __m128 a = _mm_loadu_ps(&fft[2 * i]);
+    const __m128 b = _mm_loadu_ps(&fft[2 * i + 4]);
+    const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+    _mm_storeu_ps(&real[i], re);
+    _mm_storeu_ps(&imag[i], im);
+    _mm_storeu_ps(&magn[i], _mm_add_ps(_mm_sqrt_ps(power), one));
+  }
+  for (; i < magnLen - 1; i++) {
+    real[i] = fft[2 * i];
+    imag[i] = fft[2 * i + 1];
+    fTmp = real[i] * real[i];
+    fTmp += imag[i] * imag[i];
+    magn[i] = ((float)sqrt(fTmp)) + 1.0f;
+  }
+}
+
+// Returns magn / (noise + 0.0001) - 1 where magn > noise, and 0 elsewhere.
+static __inline __m128 CurrentSnrSSE2(__m128 magn, __m128 noise) {
+  const __m128 snr = _mm_sub_ps(
+      _mm_div_ps(magn, _mm_add_ps(noise, _mm_set1_ps((float)0.0001))),
+      _mm_set1_ps((float)1.0));
+  return _mm_and_ps(_mm_cmpgt_ps(magn, noise), snr);
+}
+
+static void PriorSnrSSE2(NSinst_t* inst,
+                         const float* magn,
+                         const float* noise,
+                         float* snrLocPost,
+                         float* snrLocPrior,
+                         float* previousEstimateStsa) {
+  const __m128 eps = _mm_set1_ps((float)0.0001);
+  const __m128 ddPrSnr = _mm_set1_ps(DD_PR_SNR);
+  const __m128 ddPrSnrComp = _mm_set1_ps((float)1.0 - DD_PR_SNR);
+  int i;
+
+  for (i = 0; i + 4 <= inst->magnLen; i += 4) {
+    const __m128 post = CurrentSnrSSE2(_mm_loadu_ps(&magn[i]),
+                                       _mm_loadu_ps(&noise[i]));
+    const __m128 previous = _mm_mul_ps(
+        _mm_div_ps(_mm_loadu_ps(&inst->magnPrev[i]),
+                   _mm_add_ps(_mm_loadu_ps(&inst->noisePrev[i]), eps)),
+        _mm_loadu_ps(&inst->smooth[i]));
+    _mm_storeu_ps(&snrLocPost[i], post);
+    _mm_storeu_ps(&previousEstimateStsa[i], previous);
+    _mm_storeu_ps(&snrLocPrior[i],
+                  _mm_add_ps(_mm_mul_ps(ddPrSnr, previous),
+                             _mm_mul_ps(ddPrSnrComp, post)));
+  }
+  for (; i < inst->magnLen; i++) {
+    snrLocPost[i] = (float)0.0;
+    if (magn[i] > noise[i]) {
+      snrLocPost[i] = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
+    }
+    previousEstimateStsa[i] = inst->magnPrev[i] /
+        (inst->noisePrev[i] + (float)0.0001) * (inst->smooth[i]);
+    snrLocPrior[i] = DD_PR_SNR * previousEstimateStsa[i] +
+        ((float)1.0 - DD_PR_SNR) * snrLocPost[i];
+  }
+}
+
+static void WienerFilterSSE2(NSinst_t* inst,
+                             const float* magn,
+                             const float* noise,
+                             const float* previousEstimateStsa,
+                             float* theFilter) {
+  const __m128 ddPrSnr = _mm_set1_ps(DD_PR_SNR);
+  const __m128 ddPrSnrComp = _mm_set1_ps((float)1.0 - DD_PR_SNR);
+  const __m128 overdrive = _mm_set1_ps(inst->overdrive);
+  int i;
+  float currentEstimateStsa, snrPrior;
+
+  for (i = 0; i + 4 <= inst->magnLen; i += 4) {
+    const __m128 current = CurrentSnrSSE2(_mm_loadu_ps(&magn[i]),
+                                          _mm_loadu_ps(&noise[i]));
+    const __m128 prior = _mm_add_ps(
+        _mm_mul_ps(ddPrSnr, _mm_loadu_ps(&previousEstimateStsa[i])),
+        _mm_mul_ps(ddPrSnrComp, current));
+    _mm_storeu_ps(&theFilter[i],
+                  _mm_div_ps(prior, _mm_add_ps(overdrive, prior)));
+  }
+  for (; i < inst->magnLen; i++) {
+    currentEstimateStsa = (float)0.0;
+    if (magn[i] > noise[i]) {
+      currentEstimateStsa = magn[i] / (noise[i] + (float)0.0001) - (float)1.0;
+    }
+    snrPrior = DD_PR_SNR * previousEstimateStsa[i] + ((float)1.0 - DD_PR_SNR)
+               * currentEstimateStsa;
+    theFilter[i] = snrPrior / (inst->overdrive + snrPrior);
+  }
+}
+
+static void ApplyFilterSSE2(NSinst_t* inst,
+                            const float* theFilter,
+                            float* real,
+                            float* imag) {
+  const __m128 bound = _mm_set1_ps(inst->denoiseBound);
+  const __m128 one = _mm_set1_ps((float)1.0);
+  int i;
+  float gain;
+
+  for (i = 0; i + 4 <= inst->magnLen; i += 4) {
+    // The operand order makes a NaN pass through both, as in the C version.
+    __m128 filter = _mm_max_ps(bound, _mm_loadu_ps(&theFilter[i]));
+    filter = _mm_min_ps(one, filter);
+    _mm_storeu_ps(&inst->smooth[i], filter);
+    _mm_storeu_ps(&real[i], _mm_mul_ps(_mm_loadu_ps(&real[i]), filter));
+    _mm_storeu_ps(&imag[i], _mm_mul_ps(_mm_loadu_ps(&imag[i]), filter));
+  }
+  for (; i < inst->magnLen; i++) {
+    gain = theFilter[i];
+    if (gain < inst->denoiseBound) {
+      gain = inst->denoiseBound;
+    }
+    if (gain > (float)1.0) {
+      gain = 1.0;
+    }
+    inst->smooth[i] = gain;
+    real[i] *= gain;
+    imag[i] *= gain;
+  }
+}
+
+void WebRtcNs_InitCore_SSE2(void) {
+  WebRtcNs_MagnitudeSpectrum = MagnitudeSpectrumSSE2;
+  WebRtcNs_PriorSnr = PriorSnrSSE2;
+  WebRtcNs_WienerFilter = WienerFilterSSE2;
+  WebRtcNs_ApplyFilter = ApplyFilterSSE2;
+}
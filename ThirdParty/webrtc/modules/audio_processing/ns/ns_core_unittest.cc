@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "cpu_features_wrapper.h"
+#include "gtest/gtest.h"
+#include "noise_suppression.h"
+#include "tick_util.h"
+#include "typedefs.h"
+
+namespace webrtc {
+namespace {
+
+// Long enough to get past the startup phase and through a feature update.
+const int kNumFrames = 700;
+
+// Noisy speech-like input: a few harmonics that come and go, over white
+// noise.
+void GenerateInput(int sample_rate_hz, int num_frames,
+                   std::vector<short>* low, std::vector<short>* high) {
+  const int frame_length = sample_rate_hz == 8000 ? 80 : 160;
+  srand(42);
+  low->resize(num_frames * frame_length);
+  high->resize(num_frames * frame_length);
+  for (size_t i = 0; i < low->size(); ++i) {
+    const float t = static_cast<float>(i) / frame_length / 100;
+    const float envelope = fabs(sin(2 * 3.14159f * 1.3f * t));
+    float speech = 0;
+    for (int h = 1; h <= 4; ++h) {
+      speech += sin(2 * 3.14159f * 180 * h * t) / h;
+    }
+    const float noise = (rand() % 2001 - 1000) * 0.5f;
+    (*low)[i] = static_cast<short>(3000 * envelope * speech + noise);
+    (*high)[i] = static_cast<short>(noise + 500 * envelope * speech);
+  }
+}
+
+// Runs noise suppression over the whole input with the kernels that
+// WebRtcNs_Init() picks, and returns the output of both bands.
+void Process(int sample_rate_hz, const std::vector<short>& low,
+             const std::vector<short>& high, std::vector<short>* out_low,
+             std::vector<short>* out_high) {
+  const int frame_length = sample_rate_hz == 8000 ? 80 : 160;
+  NsHandle* ns = NULL;
+  ASSERT_EQ(0, WebRtcNs_Create(&ns));
+  ASSERT_EQ(0, WebRtcNs_Init(ns, sample_rate_hz));
+  ASSERT_EQ(0, WebRtcNs_set_policy(ns, 2));
+  std::vector<short> in_low(low);
+  std::vector<short> in_high(high);
+  out_low->resize(low.size());
+  out_high->resize(high.size());
+  for (size_t i = 0; i < low.size(); i += frame_length) {
+    ASSERT_EQ(0, WebRtcNs_Process(ns, &in_low[i],
+                                  sample_rate_hz == 32000 ? &in_high[i] : NULL,
+                                  &(*out_low)[i], &(*out_high)[i]));
+  }
+  EXPECT_EQ(0, WebRtcNs_Free(ns));
+}
+
+class NsCoreTest : public ::testing::Test {
+ protected:
+  NsCoreTest() : get_cpu_info_(WebRtc_GetCPUInfo) {}
+
+  virtual ~NsCoreTest() {
+    WebRtc_GetCPUInfo = get_cpu_info_;
+  }
+
+  bool HasSse2() const {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    return get_cpu_info_(kSSE2) != 0;
+#else
+    return false;
+#endif
+  }
+
+  // Processes the same input with the C kernels and with the SSE2 kernels.
+  void VerifyBitExact(int sample_rate_hz) {
+    std::vector<short> low, high;
+    GenerateInput(sample_rate_hz, kNumFrames, &low, &high);
+
+    std::vector<short> c_low, c_high;
+    WebRtc_GetCPUInfo = WebRtc_GetCPUInfoNoASM;
+    Process(sample_rate_hz, low, high, &c_low, &c_high);
+
+    std::vector<short> sse2_low, sse2_high;
+    WebRtc_GetCPUInfo = get_cpu_info_;
+    Process(sample_rate_hz, low, high, &sse2_low, &sse2_high);
+
+    EXPECT_TRUE(c_low == sse2_low);
+    if (sample_rate_hz == 32000) {
+      EXPECT_TRUE(c_high == sse2_high);
+    }
+    // Make sure the test exercised the suppression.
+    EXPECT_FALSE(c_low == low);
+  }
+
+  // Returns the time spent in WebRtcNs_Process() for the input, in us.
+  WebRtc_Word64 TimeProcess(const std::vector<short>& low,
+                            const std::vector<short>& high) {
+    std::vector<short> out_low, out_high;
+    const TickTime start = TickTime::Now();
+    Process(32000, low, high, &out_low, &out_high);
+    return (TickTime::Now() - start).Microseconds();
+  }
+
+  WebRtc_CPUInfo get_cpu_info_;
+};
+
+TEST_F(NsCoreTest, Sse2MatchesCAt8kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(8000);
+}
+
+TEST_F(NsCoreTest, Sse2MatchesCAt16kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(16000);
+}
+
+TEST_F(NsCoreTest, Sse2MatchesCAt32kHz) {
+  if (!HasSse2()) {
+    return;
+  }
+  VerifyBitExact(32000);
+}
+
+TEST_F(NsCoreTest, Sse2Timing) {
+  if (!HasSse2()) {
+    return;
+  }
+  std::vector<short> low, high;
+  GenerateInput(32000, kNumFrames, &low, &high);
+
+  WebRtc_GetCPUInfo = WebRtc_GetCPUInfoNoASM;
+  const WebRtc_Word64 c_us = TimeProcess(low, high);
+  WebRtc_GetCPUInfo = get_cpu_info_;
+  const WebRtc_Word64 sse2_us = TimeProcess(low, high);
+  printf("Noise suppression, 32 kHz: C %.1f us, SSE2 %.1f us per 10 ms\n",
+         static_cast<double>(c_us) / kNumFrames,
+         static_cast<double>(sse2_us) / kNumFrames);
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -9,6 +9,9 @@
  */
 
 #include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
 
 #include "gtest/gtest.h"
 
@@ -18,6 +21,7 @@
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8_common_types.h"
 #include "webrtc/modules/video_coding/main/interface/video_coding.h"
+#include "webrtc/system_wrappers/interface/scoped_ptr.h"
 #include "webrtc/test/testsupport/fileutils.h"
 #include "webrtc/test/testsupport/frame_reader.h"
 #include "webrtc/test/testsupport/frame_writer.h"
@@ -747,4 +751,82 @@ TEST_F(VideoProcessorIntegrationTest, ProcessNoLossTemporalLayers) {
                          process_settings,
                          rc_metrics);
 }
+
+// Encodes and decodes the short foreman clip with |number_of_threads| encoder
+// threads, using all cores when more than one thread is asked for, and returns
+// the total encode and decode time in microseconds.
+static void ProcessWithThreads(int number_of_threads,
+                               int* encode_time_in_us,
+                               int* decode_time_in_us) {
+  *encode_time_in_us = 0;
+  *decode_time_in_us = 0;
+  webrtc::test::TestConfig config;
+  config.input_filename = webrtc::test::ResourcePath("foreman_cif", "yuv");
+  config.output_filename = webrtc::test::OutputPath() +
+      "foreman_cif_threads_video_codecs_test_framework_integrationtests.yuv";
+  config.frame_length_in_bytes = CalcBufferSize(kI420, kCIFWidth, kCIFHeight);
+  config.use_single_core = (number_of_threads == 1);
+  VideoCodec codec_settings;
+  VideoCodingModule::Codec(kVideoCodecVP8, &codec_settings);
+  codec_settings.startBitrate = 500;
+  codec_settings.width = kCIFWidth;
+  codec_settings.height = kCIFHeight;
+  codec_settings.codecSpecific.VP8.numberOfThreads = number_of_threads;
+  config.codec_settings = &codec_settings;
+
+  webrtc::test::FrameReaderImpl frame_reader(config.input_filename,
+                                             config.frame_length_in_bytes);
+  webrtc::test::FrameWriterImpl frame_writer(config.output_filename,
+                                             config.frame_length_in_bytes);
+  webrtc::test::PacketReader packet_reader;
+  webrtc::test::PacketManipulatorImpl packet_manipulator(
+      &packet_reader, config.networking_config, config.verbose);
+  webrtc::test::Stats stats;
+  ASSERT_TRUE(frame_reader.Init());
+  ASSERT_TRUE(frame_writer.Init());
+  // Declared ahead of the processor, which deregisters its callbacks from
+  // both when it is destroyed.
+  scoped_ptr<VideoEncoder> encoder(VP8Encoder::Create());
+  scoped_ptr<VideoDecoder> decoder(VP8Decoder::Create());
+  scoped_ptr<webrtc::test::VideoProcessor> processor(
+      new webrtc::test::VideoProcessorImpl(encoder.get(), decoder.get(),
+                                           &frame_reader, &frame_writer,
+                                           &packet_manipulator, config,
+                                           &stats));
+  ASSERT_TRUE(processor->Init());
+  processor->SetRates(500, 30);
+  int frame_number = 0;
+  while (frame_number < kNbrFramesShort &&
+         processor->ProcessFrame(frame_number)) {
+    ++frame_number;
+  }
+  EXPECT_EQ(kNbrFramesShort, frame_number);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, encoder->Release());
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder->Release());
+  frame_reader.Close();
+  frame_writer.Close();
+
+  for (size_t i = 0; i < stats.stats_.size(); ++i) {
+    *encode_time_in_us += stats.stats_[i].encode_time_in_us;
+    *decode_time_in_us += stats.stats_[i].decode_time_in_us;
+  }
+}
+
+// Compares single threaded throughput with encoding on four threads and as
+// many token partitions. The speed-up depends on the machine, so it is only
+// printed; the run verifies that every frame makes it through.
+TEST(VideoProcessorThreadingTest, ProcessWithMultipleThreads) {
+  const int kThreadCounts[] = {1, 4};
+  for (size_t i = 0; i < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]);
+       ++i) {
+    int encode_time_in_us = 0;
+    int decode_time_in_us = 0;
+    ProcessWithThreads(kThreadCounts[i], &encode_time_in_us,
+                       &decode_time_in_us);
+    printf("%d thread(s): encode %.1f fps, decode %.1f fps\n",
+           kThreadCounts[i],
+           kNbrFramesShort * 1e6 / std::max(encode_time_in_us, 1),
+           kNbrFramesShort * 1e6 / std::max(decode_time_in_us, 1));
+  }
+}
 }  // namespace webrtc
@@ -31,9 +31,54 @@
 #include "webrtc/system_wrappers/interface/trace_event.h"
 
 enum { kVp8ErrorPropagationTh = 30 };
+// libvpx splits the VP8 bitstream into at most eight token partitions, and
+// more threads than partitions gain nothing when decoding.
+enum { kVp8MaxThreads = 8 };
+// Roughly the number of pixels one core encodes in real time.
+enum { kVp8PixelsPerThread = 640 * 360 };
 
 namespace webrtc {
 
+// Picks a thread count for |width|x|height| frames: one thread for every
+// kVp8PixelsPerThread pixels, bounded by the available cores.
+static int NumberOfThreads(int width, int height, int number_of_cores) {
+  int threads = (width * height) / kVp8PixelsPerThread;
+  if (threads > number_of_cores) {
+    threads = number_of_cores;
+  }
+  if (threads > kVp8MaxThreads) {
+    threads = kVp8MaxThreads;
+  }
+  return (threads < 1) ? 1 : threads;
+}
+
+// Maps a token partition count (1, 2, 4 or 8) to its vp8e_token_partitions
+// value. Returns -1 for any other count.
+static int TokenPartitionsFromCount(int count) {
+  switch (count) {
+    case 1:
+      return VP8_ONE_TOKENPARTITION;
+    case 2:
+      return VP8_TWO_TOKENPARTITION;
+    case 4:
+      return VP8_FOUR_TOKENPARTITION;
+    case 8:
+      return VP8_EIGHT_TOKENPARTITION;
+    default:
+      return -1;
+  }
+}
+
+// Uses as many token partitions as there are threads, so that a decoder with
+// the same number of cores can decode the partitions in parallel.
+static int TokenPartitionsForThreads(int threads) {
+  int count = 1;
+  while (count < threads && count < kVp8MaxThreads) {
+    count <<= 1;
+  }
+  return TokenPartitionsFromCount(count);
+}
+
 VP8Encoder* VP8Encoder::Create() {
   return new VP8EncoderImpl();
 }
@@ -223,12 +268,24 @@ int VP8EncoderImpl::InitEncode(const VideoCodec* inst,
   }
   config_->g_lag_in_frames = 0;  // 0- no frame lagging
 
-  // Determining number of threads based on the image size
-  if (codec_.width * codec_.height > 704 * 576 && number_of_cores > 1) {
-    // 2 threads when larger than 4CIF
-    config_->g_threads = 2;
+  // Determining number of threads based on the image size, unless the
+  // caller asked for a specific number.
+  int threads = inst->codecSpecific.VP8.numberOfThreads;
+  if (threads <= 0) {
+    threads = NumberOfThreads(codec_.width, codec_.height, number_of_cores);
+  } else if (threads > number_of_cores) {
+    threads = number_of_cores;
+  }
+  config_->g_threads = threads;
+
+  if (inst->codecSpecific.VP8.numberOfTokenPartitions == 0) {
+    token_partitions_ = TokenPartitionsForThreads(threads);
   } else {
-    config_->g_threads = 1;
+    token_partitions_ = TokenPartitionsFromCount(
+        inst->codecSpecific.VP8.numberOfTokenPartitions);
+    if (token_partitions_ < 0) {
+      return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
+    }
   }
 
   // rate control settings
@@ -283,10 +340,6 @@ int VP8EncoderImpl::InitEncode(const VideoCodec* inst,
 
 int VP8EncoderImpl::InitAndSetControlSettings(const VideoCodec* inst) {
   vpx_codec_flags_t flags = 0;
-  // TODO(holmer): We should make a smarter decision on the number of
-  // partitions. Eight is probably not the optimal number for low resolution
-  // video.
-
 #if WEBRTC_LIBVPX_VERSION >= 971
   flags |= VPX_CODEC_USE_OUTPUT_PARTITION;
 #endif
@@ -595,7 +648,8 @@ VP8DecoderImpl::VP8DecoderImpl()
       ref_frame_(NULL),
       propagation_cnt_(-1),
       latest_keyframe_complete_(false),
-      mfqe_enabled_(false) {
+      mfqe_enabled_(false),
+      number_of_cores_(1) {
   memset(&codec_, 0, sizeof(codec_));
 }
 
@@ -608,7 +662,7 @@ int VP8DecoderImpl::Reset() {
   if (!inited_) {
     return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
   }
-  InitDecode(&codec_, 1);
+  InitDecode(&codec_, number_of_cores_);
   propagation_cnt_ = -1;
   latest_keyframe_complete_ = false;
   mfqe_enabled_ = false;
@@ -629,9 +683,13 @@ int VP8DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
   if (inst->codecType == kVideoCodecVP8) {
     feedback_mode_ = inst->codecSpecific.VP8.feedbackModeOn;
   }
+  if (number_of_cores < 1) {
+    number_of_cores = 1;
+  }
   vpx_codec_dec_cfg_t  cfg;
-  // Setting number of threads to a constant value (1)
-  cfg.threads = 1;
+  // The frame size is only known up front if the receive codec carries it;
+  // otherwise decode on a single thread.
+  cfg.threads = NumberOfThreads(inst->width, inst->height, number_of_cores);
   cfg.h = cfg.w = 0;  // set after decode
 
   vpx_codec_flags_t flags = 0;
@@ -659,6 +717,7 @@ int VP8DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
 
   // Save VideoCodec instance for later; mainly for duplicating the decoder.
   codec_ = *inst;
+  number_of_cores_ = number_of_cores;
   propagation_cnt_ = -1;
   latest_keyframe_complete_ = false;
 
@@ -941,7 +1000,7 @@ VideoDecoder* VP8DecoderImpl::Copy() {
   VP8DecoderImpl *copy = new VP8DecoderImpl;
 
   // Initialize the new decoder
-  if (copy->InitDecode(&codec_, 1) != WEBRTC_VIDEO_CODEC_OK) {
+  if (copy->InitDecode(&codec_, number_of_cores_) != WEBRTC_VIDEO_CODEC_OK) {
     delete copy;
     return NULL;
   }
@@ -230,6 +230,7 @@ class VP8DecoderImpl : public VP8Decoder {
   int propagation_cnt_;
   bool latest_keyframe_complete_;
   bool mfqe_enabled_;
+  int number_of_cores_;
 };  // end of VP8Decoder class
 }  // namespace webrtc
 
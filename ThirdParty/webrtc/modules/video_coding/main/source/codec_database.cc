@@ -100,6 +100,8 @@ bool VCMCodecDataBase::Codec(int list_id,
       settings->codecSpecific.VP8.automaticResizeOn = false;
       settings->codecSpecific.VP8.frameDroppingOn = true;
       settings->codecSpecific.VP8.keyFrameInterval = 3000;
+      settings->codecSpecific.VP8.numberOfThreads = 0;
+      settings->codecSpecific.VP8.numberOfTokenPartitions = 0;
       return true;
     }
 #endif
@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/main/source/frame_index.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "webrtc/system_wrappers/interface/compile_assert.h"
+
+namespace webrtc {
+
+// Frame timestamps advance in steps of the frame interval (3000 at 30 fps), so
+// the low bits alone hash poorly. Fibonacci hashing spreads them over the
+// table.
+static int HashTimestamp(uint32_t timestamp, int bits) {
+  return static_cast<int>((timestamp * 2654435761u) >> (32 - bits));
+}
+
+VCMFrameIndex::VCMFrameIndex()
+    : size_(0) {
+  // Keeps the table at most half full, so probe sequences stay short and
+  // always end on an empty slot.
+  COMPILE_ASSERT(2 * kMaxNumberOfFrames <= kTableSize);
+  Clear();
+}
+
+bool VCMFrameIndex::Insert(uint32_t timestamp, VCMFrameBuffer* frame) {
+  assert(frame != NULL);
+  if (size_ >= kMaxNumberOfFrames) {
+    return false;
+  }
+  const int slot = Slot(timestamp);
+  if (entries_[slot].frame != NULL) {
+    return false;
+  }
+  entries_[slot].timestamp = timestamp;
+  entries_[slot].frame = frame;
+  ++size_;
+  return true;
+}
+
+VCMFrameBuffer* VCMFrameIndex::Find(uint32_t timestamp) const {
+  return entries_[Slot(timestamp)].frame;
+}
+
+bool VCMFrameIndex::Erase(uint32_t timestamp, const VCMFrameBuffer* frame) {
+  int slot = Slot(timestamp);
+  if (entries_[slot].frame == NULL || entries_[slot].frame != frame) {
+    return false;
+  }
+  entries_[slot].frame = NULL;
+  --size_;
+  // Move later entries of the probe sequence back into the hole so that
+  // lookups never stop early on it.
+  int next = (slot + 1) & (kTableSize - 1);
+  while (entries_[next].frame != NULL) {
+    const int home = HashTimestamp(entries_[next].timestamp, kTableSizeBits);
+    // The entry may fill the hole unless its home slot lies cyclically in
+    // (slot, next].
+    const bool stays = (slot <= next) ? (slot < home && home <= next) :
+                                        (slot < home || home <= next);
+    if (!stays) {
+      entries_[slot] = entries_[next];
+      entries_[next].frame = NULL;
+      slot = next;
+    }
+    next = (next + 1) & (kTableSize - 1);
+  }
+  return true;
+}
+
+void VCMFrameIndex::Clear() {
+  memset(entries_, 0, sizeof(entries_));
+  size_ = 0;
+}
+
+int VCMFrameIndex::Slot(uint32_t timestamp) const {
+  int slot = HashTimestamp(timestamp, kTableSizeBits);
+  while (entries_[slot].frame != NULL &&
+         entries_[slot].timestamp != timestamp) {
+    slot = (slot + 1) & (kTableSize - 1);
+  }
+  return slot;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2013 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_VIDEO_CODING_MAIN_SOURCE_FRAME_INDEX_H_
+#define WEBRTC_MODULES_VIDEO_CODING_MAIN_SOURCE_FRAME_INDEX_H_
+
+#include "webrtc/modules/video_coding/main/source/jitter_buffer_common.h"
+#include "webrtc/system_wrappers/interface/constructor_magic.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+class VCMFrameBuffer;
+
+// Maps RTP timestamps to the frames of the jitter buffer. Lookups are O(1):
+// the frames live in an open addressed table sized for kMaxNumberOfFrames
+// entries at a load factor of at most one half.
+class VCMFrameIndex {
+ public:
+  VCMFrameIndex();
+
+  // Adds |frame| under |timestamp|. Returns false if another frame already has
+  // that timestamp or the index is full.
+  bool Insert(uint32_t timestamp, VCMFrameBuffer* frame);
+
+  // Returns the frame with |timestamp|, or NULL if there is none.
+  VCMFrameBuffer* Find(uint32_t timestamp) const;
+
+  // Removes |frame| if it is indexed under |timestamp|. Returns true if it was.
+  bool Erase(uint32_t timestamp, const VCMFrameBuffer* frame);
+
+  void Clear();
+
+  int size() const { return size_; }
+
+ private:
+  enum { kTableSizeBits = 8 };
+  enum { kTableSize = 1 << kTableSizeBits };
+
+  struct Entry {
+    uint32_t timestamp;
+    VCMFrameBuffer* frame;
+  };
+
+  // Returns the slot of |timestamp|, or of the empty slot ending its probe
+  // sequence if it isn't indexed.
+  int Slot(uint32_t timestamp) const;
+
+  Entry entries_[kTableSize];
+  int size_;
+
+  DISALLOW_COPY_AND_ASSIGN(VCMFrameIndex);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_VIDEO_CODING_MAIN_SOURCE_FRAME_INDEX_H_
@@ -41,17 +41,6 @@ class FrameSmallerTimestamp {
   uint32_t timestamp_;
 };
 
-class FrameEqualTimestamp {
- public:
-  explicit FrameEqualTimestamp(uint32_t timestamp) : timestamp_(timestamp) {}
-  bool operator()(VCMFrameBuffer* frame) {
-    return (timestamp_ == frame->TimeStamp());
-  }
-
- private:
-  uint32_t timestamp_;
-};
-
 class CompleteDecodableKeyFrameCriteria {
  public:
   bool operator()(VCMFrameBuffer* frame) {
@@ -73,9 +62,11 @@ VCMJitterBuffer::VCMJitterBuffer(Clock* clock,
       master_(master),
       frame_event_(),
       packet_event_(),
-      max_number_of_frames_(kStartNumberOfFrames),
       frame_buffers_(),
+      free_frames_(),
+      num_free_frames_(0),
       frame_list_(),
+      frame_index_(),
       last_decoded_state_(),
       first_packet_(true),
       num_not_decodable_packets_(0),
@@ -101,20 +92,21 @@ VCMJitterBuffer::VCMJitterBuffer(Clock* clock,
       max_nack_list_size_(0),
       max_packet_age_to_nack_(0),
       waiting_for_key_frame_(false) {
-  memset(frame_buffers_, 0, sizeof(frame_buffers_));
   memset(receive_statistics_, 0, sizeof(receive_statistics_));
 
-  for (int i = 0; i < kStartNumberOfFrames; i++) {
+  // Allocate every frame up front. A freed frame keeps its payload buffer, so
+  // a running jitter buffer reuses memory instead of allocating per frame.
+  for (int i = 0; i < kMaxNumberOfFrames; i++) {
     frame_buffers_[i] = new VCMFrameBuffer();
+    free_frames_[i] = frame_buffers_[i];
   }
+  num_free_frames_ = kMaxNumberOfFrames;
 }
 
 VCMJitterBuffer::~VCMJitterBuffer() {
   Stop();
   for (int i = 0; i < kMaxNumberOfFrames; i++) {
-    if (frame_buffers_[i]) {
-      delete frame_buffers_[i];
-    }
+    delete frame_buffers_[i];
   }
   delete crit_sect_;
 }
@@ -127,7 +119,6 @@ void VCMJitterBuffer::CopyFrom(const VCMJitterBuffer& rhs) {
     receiver_id_ = rhs.receiver_id_;
     running_ = rhs.running_;
     master_ = !rhs.master_;
-    max_number_of_frames_ = rhs.max_number_of_frames_;
     incoming_frame_rate_ = rhs.incoming_frame_rate_;
     incoming_frame_count_ = rhs.incoming_frame_count_;
     time_last_incoming_frame_count_ = rhs.time_last_incoming_frame_count_;
@@ -157,20 +148,16 @@ void VCMJitterBuffer::CopyFrom(const VCMJitterBuffer& rhs) {
     nack_seq_nums_.resize(rhs.nack_seq_nums_.size());
     std::copy(rhs.nack_seq_nums_.begin(), rhs.nack_seq_nums_.end(),
               nack_seq_nums_.begin());
+    ClearFrameList();
+    num_free_frames_ = 0;
     for (int i = 0; i < kMaxNumberOfFrames; i++) {
-      if (frame_buffers_[i] != NULL) {
-        delete frame_buffers_[i];
-        frame_buffers_[i] = NULL;
-      }
-    }
-    frame_list_.clear();
-    for (int i = 0; i < max_number_of_frames_; i++) {
+      delete frame_buffers_[i];
       frame_buffers_[i] = new VCMFrameBuffer(*(rhs.frame_buffers_[i]));
       if (frame_buffers_[i]->Length() > 0) {
-        FrameList::reverse_iterator rit = std::find_if(
-            frame_list_.rbegin(), frame_list_.rend(),
-            FrameSmallerTimestamp(frame_buffers_[i]->TimeStamp()));
-        frame_list_.insert(rit.base(), frame_buffers_[i]);
+        InsertFrameInList(frame_buffers_[i]);
+      }
+      if (frame_buffers_[i]->GetState() == kStateFree) {
+        free_frames_[num_free_frames_++] = frame_buffers_[i];
       }
     }
     rhs.crit_sect_->Leave();
@@ -213,12 +200,12 @@ void VCMJitterBuffer::Stop() {
   crit_sect_->Enter();
   running_ = false;
   last_decoded_state_.Reset();
-  frame_list_.clear();
+  ClearFrameList();
   for (int i = 0; i < kMaxNumberOfFrames; i++) {
-    if (frame_buffers_[i] != NULL) {
-      static_cast<VCMFrameBuffer*>(frame_buffers_[i])->SetState(kStateFree);
-    }
+    frame_buffers_[i]->SetState(kStateFree);
+    free_frames_[i] = frame_buffers_[i];
   }
+  num_free_frames_ = kMaxNumberOfFrames;
 
   crit_sect_->Leave();
   // Make sure we wake up any threads waiting on these events.
@@ -237,8 +224,8 @@ bool VCMJitterBuffer::Running() const {
 void VCMJitterBuffer::Flush() {
   CriticalSectionScoped cs(crit_sect_);
   // Erase all frames from the sorted list and set their state to free.
-  frame_list_.clear();
-  for (int i = 0; i < max_number_of_frames_; i++) {
+  ClearFrameList();
+  for (int i = 0; i < kMaxNumberOfFrames; i++) {
     ReleaseFrameIfNotDecoding(frame_buffers_[i]);
   }
   last_decoded_state_.Reset();  // TODO(mikhal): sync reset.
@@ -487,7 +474,7 @@ VCMEncodedFrame* VCMJitterBuffer::GetCompleteFrameForDecoding(
   }
 
   VCMFrameBuffer* oldest_frame = *it;
-  it = frame_list_.erase(it);
+  it = EraseFrameFromList(it);
 
   // Update jitter estimate.
   const bool retransmitted = (oldest_frame->GetNackCount() > 0);
@@ -555,7 +542,7 @@ VCMEncodedFrame* VCMJitterBuffer::GetFrameForDecoding() {
       oldest_frame->LatestPacketTimeMs();
     waiting_for_completion_.timestamp = oldest_frame->TimeStamp();
   }
-  frame_list_.erase(frame_list_.begin());
+  EraseFrameFromList(frame_list_.begin());
 
   // Look for previous frame loss
   VerifyAndSetPreviousFrameLost(oldest_frame);
@@ -586,7 +573,7 @@ void VCMJitterBuffer::ReleaseFrame(VCMEncodedFrame* frame) {
   CriticalSectionScoped cs(crit_sect_);
   VCMFrameBuffer* frame_buffer = static_cast<VCMFrameBuffer*>(frame);
   if (frame_buffer)
-    frame_buffer->SetState(kStateFree);
+    FreeFrame(frame_buffer);
 }
 
 // Gets frame to use for this timestamp. If no match, get empty frame.
@@ -619,13 +606,9 @@ int VCMJitterBuffer::GetFrame(const VCMPacket& packet,
   }
   num_consecutive_old_packets_ = 0;
 
-  FrameList::iterator it = std::find_if(
-                             frame_list_.begin(),
-                             frame_list_.end(),
-                             FrameEqualTimestamp(packet.timestamp));
-
-  if (it != frame_list_.end()) {
-    frame = *it;
+  VCMFrameBuffer* indexed_frame = frame_index_.Find(packet.timestamp);
+  if (indexed_frame != NULL) {
+    frame = indexed_frame;
     crit_sect_->Leave();
     return VCM_OK;
   }
@@ -729,11 +712,7 @@ VCMFrameBufferEnum VCMJitterBuffer::InsertPacket(VCMEncodedFrame* encoded_frame,
     // belonging to that frame (media or empty).
     if (state == kStateEmpty && first) {
       ret = kFirstPacket;
-      FrameList::reverse_iterator rit = std::find_if(
-          frame_list_.rbegin(),
-          frame_list_.rend(),
-          FrameSmallerTimestamp(frame->TimeStamp()));
-      frame_list_.insert(rit.base(), frame);
+      InsertFrameInList(frame);
     }
   }
   switch (buffer_return) {
@@ -741,7 +720,9 @@ VCMFrameBufferEnum VCMJitterBuffer::InsertPacket(VCMEncodedFrame* encoded_frame,
     case kTimeStampError:
     case kSizeError: {
       if (frame != NULL) {
-        // Will be released when it gets old.
+        // Will be released when it gets old. Until then no packets are
+        // looked up into it.
+        frame_index_.Erase(frame->TimeStamp(), frame);
         frame->Reset();
         frame->SetState(kStateEmpty);
       }
@@ -1083,7 +1064,7 @@ VCMEncodedFrame* VCMJitterBuffer::GetFrameForDecodingNACK() {
     // Ignore retransmitted and empty frames.
     UpdateJitterEstimate(*oldest_frame, false);
   }
-  it = frame_list_.erase(it);
+  it = EraseFrameFromList(it);
 
   // Look for previous frame loss.
   VerifyAndSetPreviousFrameLost(oldest_frame);
@@ -1110,44 +1091,60 @@ VCMEncodedFrame* VCMJitterBuffer::GetFrameForDecodingNACK() {
 // frame list. Must be called from inside the critical section crit_sect_.
 void VCMJitterBuffer::ReleaseFrameIfNotDecoding(VCMFrameBuffer* frame) {
   if (frame != NULL && frame->GetState() != kStateDecoding) {
-    frame->SetState(kStateFree);
+    FreeFrame(frame);
   }
 }
 
-VCMFrameBuffer* VCMJitterBuffer::GetEmptyFrame() {
-  if (!running_) {
-    return NULL;
+// Must be called from inside the critical section crit_sect_.
+void VCMJitterBuffer::FreeFrame(VCMFrameBuffer* frame) {
+  if (frame->GetState() == kStateFree) {
+    // Already in the pool.
+    return;
   }
+  frame->SetState(kStateFree);
+  assert(num_free_frames_ < kMaxNumberOfFrames);
+  free_frames_[num_free_frames_++] = frame;
+}
 
-  crit_sect_->Enter();
+// Must be called from inside the critical section crit_sect_.
+void VCMJitterBuffer::InsertFrameInList(VCMFrameBuffer* frame) {
+  // Frames mostly arrive in order, so search from the newest end.
+  FrameList::reverse_iterator rit = std::find_if(
+      frame_list_.rbegin(),
+      frame_list_.rend(),
+      FrameSmallerTimestamp(frame->TimeStamp()));
+  frame_list_.insert(rit.base(), frame);
+  frame_index_.Insert(frame->TimeStamp(), frame);
+}
 
-  for (int i = 0; i < max_number_of_frames_; ++i) {
-    if (kStateFree == frame_buffers_[i]->GetState()) {
-      // found a free buffer
-      frame_buffers_[i]->SetState(kStateEmpty);
-      crit_sect_->Leave();
-      return frame_buffers_[i];
-    }
-  }
+// Must be called from inside the critical section crit_sect_, before the
+// frame is reset.
+FrameList::iterator VCMJitterBuffer::EraseFrameFromList(
+    FrameList::iterator it) {
+  frame_index_.Erase((*it)->TimeStamp(), *it);
+  return frame_list_.erase(it);
+}
 
-  // Check if we can increase JB size
-  if (max_number_of_frames_ < kMaxNumberOfFrames) {
-    VCMFrameBuffer* ptr_new_buffer = new VCMFrameBuffer();
-    ptr_new_buffer->SetState(kStateEmpty);
-    frame_buffers_[max_number_of_frames_] = ptr_new_buffer;
-    max_number_of_frames_++;
+// Must be called from inside the critical section crit_sect_.
+void VCMJitterBuffer::ClearFrameList() {
+  frame_list_.clear();
+  frame_index_.Clear();
+}
 
-    crit_sect_->Leave();
-    WEBRTC_TRACE(webrtc::kTraceDebug, webrtc::kTraceVideoCoding,
-                 VCMId(vcm_id_, receiver_id_),
-                 "JB(0x%x) FB(0x%x): Jitter buffer  increased to:%d frames",
-                 this, ptr_new_buffer, max_number_of_frames_);
-    return ptr_new_buffer;
+VCMFrameBuffer* VCMJitterBuffer::GetEmptyFrame() {
+  if (!running_) {
+    return NULL;
   }
-  crit_sect_->Leave();
 
-  // We have reached max size, cannot increase JB size
-  return NULL;
+  CriticalSectionScoped cs(crit_sect_);
+  if (num_free_frames_ == 0) {
+    // All frames are in use.
+    return NULL;
+  }
+  VCMFrameBuffer* frame = free_frames_[--num_free_frames_];
+  assert(frame->GetState() == kStateFree);
+  frame->SetState(kStateEmpty);
+  return frame;
 }
 
 // Recycle oldest frames up to a key frame, used if jitter buffer is completely
@@ -1162,8 +1159,9 @@ bool VCMJitterBuffer::RecycleFramesUntilKeyFrame() {
                  VCMId(vcm_id_, receiver_id_),
                  "Jitter buffer drop count:%d, low_seq %d", drop_count_,
                  (*it)->GetLowSeqNum());
-    ReleaseFrameIfNotDecoding(*it);
-    it = frame_list_.erase(it);
+    VCMFrameBuffer* frame = *it;
+    it = EraseFrameFromList(it);
+    ReleaseFrameIfNotDecoding(frame);
     if (it != frame_list_.end() && (*it)->FrameType() == kVideoFrameKey) {
       // Fake the last_decoded_state to match this key frame.
       last_decoded_state_.SetStateOneBack(*it);
@@ -1205,6 +1203,7 @@ VCMFrameBufferEnum VCMJitterBuffer::UpdateFrameState(VCMFrameBuffer* frame) {
   if (last_decoded_state_.IsOldFrame(frame)) {
     // Frame is older than the latest decoded frame, drop it. Will be
     // released by CleanUpOldFrames later.
+    frame_index_.Erase(frame->TimeStamp(), frame);
     frame->Reset();
     frame->SetState(kStateEmpty);
     WEBRTC_TRACE(webrtc::kTraceDebug, webrtc::kTraceVideoCoding,
@@ -1317,8 +1316,8 @@ void VCMJitterBuffer::CleanUpOldFrames() {
       last_decoded_state_.UpdateEmptyFrame(oldest_frame);
     }
     if (last_decoded_state_.IsOldFrame(oldest_frame)) {
-      ReleaseFrameIfNotDecoding(frame_list_.front());
-      frame_list_.erase(frame_list_.begin());
+      EraseFrameFromList(frame_list_.begin());
+      ReleaseFrameIfNotDecoding(oldest_frame);
     } else {
       break;
     }
@@ -1437,7 +1436,6 @@ void VCMJitterBuffer::GetLowHighSequenceNumbers(
   assert(low_seq_num);
   assert(high_seq_num);
   // TODO(mikhal/stefan): Refactor to use last_decoded_state.
-  int i = 0;
   int32_t seq_num = -1;
 
   *high_seq_num = -1;
@@ -1445,12 +1443,14 @@ void VCMJitterBuffer::GetLowHighSequenceNumbers(
   if (!last_decoded_state_.init())
     *low_seq_num = last_decoded_state_.sequence_num();
 
-  // find highest seq numbers
-  for (i = 0; i < max_number_of_frames_; ++i) {
-    seq_num = frame_buffers_[i]->GetHighSeqNum();
+  // Find the highest sequence number. Only frames in |frame_list_| can hold
+  // packets that haven't been handed to the decoder.
+  for (FrameList::const_iterator it = frame_list_.begin();
+       it != frame_list_.end(); ++it) {
+    seq_num = (*it)->GetHighSeqNum();
 
     // Ignore free / empty frames
-    VCMFrameBufferStateEnum state = frame_buffers_[i]->GetState();
+    VCMFrameBufferStateEnum state = (*it)->GetState();
 
     if ((kStateFree != state) &&
         (kStateEmpty != state) &&
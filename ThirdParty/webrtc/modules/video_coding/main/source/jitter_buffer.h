@@ -18,6 +18,7 @@
 #include "webrtc/modules/video_coding/main/interface/video_coding_defines.h"
 #include "webrtc/modules/video_coding/main/source/decoding_state.h"
 #include "webrtc/modules/video_coding/main/source/event.h"
+#include "webrtc/modules/video_coding/main/source/frame_index.h"
 #include "webrtc/modules/video_coding/main/source/inter_frame_delay.h"
 #include "webrtc/modules/video_coding/main/source/jitter_buffer_common.h"
 #include "webrtc/modules/video_coding/main/source/jitter_estimator.h"
@@ -166,8 +167,22 @@ class VCMJitterBuffer {
 
   void ReleaseFrameIfNotDecoding(VCMFrameBuffer* frame);
 
-  // Gets an empty frame, creating a new frame if necessary (i.e. increases
-  // jitter buffer size).
+  // Sets |frame| free and returns it to the pool of free frames.
+  void FreeFrame(VCMFrameBuffer* frame);
+
+  // Inserts |frame| into |frame_list_| in timestamp order and indexes it by
+  // its timestamp.
+  void InsertFrameInList(VCMFrameBuffer* frame);
+
+  // Removes the frame at |it| from |frame_list_| and from the timestamp index.
+  // Returns the iterator following |it|.
+  FrameList::iterator EraseFrameFromList(FrameList::iterator it);
+
+  // Empties |frame_list_| and the timestamp index.
+  void ClearFrameList();
+
+  // Takes a frame from the pool of free frames. Returns NULL if all frames are
+  // in use.
   VCMFrameBuffer* GetEmptyFrame();
 
   // Recycles oldest frames until a key frame is found. Used if jitter buffer is
@@ -226,11 +241,15 @@ class VCMJitterBuffer {
   VCMEvent frame_event_;
   // Event to signal when we have received a packet.
   VCMEvent packet_event_;
-  // Number of allocated frames.
-  int max_number_of_frames_;
-  // Array of pointers to the frames in jitter buffer.
+  // All frames of the jitter buffer, allocated up front.
   VCMFrameBuffer* frame_buffers_[kMaxNumberOfFrames];
+  // Stack of the frames in |frame_buffers_| which are free.
+  VCMFrameBuffer* free_frames_[kMaxNumberOfFrames];
+  int num_free_frames_;
+  // Frames holding packets, sorted by timestamp and indexed by timestamp in
+  // |frame_index_|.
   FrameList frame_list_;
+  VCMFrameIndex frame_index_;
   VCMDecodingState last_decoded_state_;
   bool first_packet_;
 
@@ -16,7 +16,6 @@
 namespace webrtc {
 
 enum { kMaxNumberOfFrames     = 100 };
-enum { kStartNumberOfFrames   = 6 };
 enum { kMaxVideoDelayMs       = 2000 };
 
 enum VCMJitterBufferEnum {
@@ -8,15 +8,18 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdio.h>
 #include <string.h>
 
 #include <list>
+#include <utility>
 
 #include "gtest/gtest.h"
 #include "modules/video_coding/main/source/jitter_buffer.h"
 #include "modules/video_coding/main/source/media_opt_util.h"
 #include "modules/video_coding/main/source/packet.h"
 #include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/tick_util.h"
 
 namespace webrtc {
 
@@ -446,4 +449,55 @@ TEST_F(TestJitterBufferNack, TestNormalOperationWrap) {
     EXPECT_EQ(i * 10, list[i]);
 }
 
+// Benchmarks packet insertion into a jitter buffer which holds many frames
+// while it waits for retransmissions. Every |kLossInterval|th frame loses a
+// packet, which is retransmitted |kRetransmissionDelayFrames| frames later.
+TEST_F(TestJitterBufferNack, InsertPacketsWithRetransmissions) {
+  // StreamGenerator timestamps grow quadratically, so stay clear of a wrap.
+  enum { kNumFrames = 1000 };
+  enum { kPacketsPerFrame = 10 };
+  enum { kLossInterval = 10 };
+  enum { kRetransmissionDelayFrames = 40 };
+  std::list<std::pair<int, VCMPacket> > retransmissions;
+  int num_packets = 0;
+  int num_decoded_frames = 0;
+  const TickTime start_time = TickTime::Now();
+  for (int i = 0; i < kNumFrames; ++i) {
+    stream_generator->GenerateFrame(
+        (i == 0) ? kVideoFrameKey : kVideoFrameDelta, kPacketsPerFrame, 0,
+        clock_->TimeInMilliseconds());
+    for (int j = 0; j < kPacketsPerFrame; ++j) {
+      if (i % kLossInterval == kLossInterval - 1 && j == kPacketsPerFrame / 2) {
+        VCMPacket packet;
+        EXPECT_TRUE(stream_generator->PopPacket(&packet, 0));
+        retransmissions.push_back(
+            std::make_pair(i + kRetransmissionDelayFrames, packet));
+      } else {
+        InsertPacketAndPop(0);
+        ++num_packets;
+      }
+    }
+    while (!retransmissions.empty() && retransmissions.front().first <= i) {
+      VCMPacket packet = retransmissions.front().second;
+      packet.dataPtr = data_buffer_;
+      VCMEncodedFrame* frame;
+      EXPECT_EQ(VCM_OK, jitter_buffer_->GetFrame(packet, frame));
+      jitter_buffer_->InsertPacket(frame, packet);
+      ++num_packets;
+      retransmissions.pop_front();
+    }
+    while (DecodeCompleteFrame()) {
+      ++num_decoded_frames;
+    }
+    clock_->AdvanceTimeMilliseconds(kDefaultFramePeriodMs);
+  }
+  const int64_t elapsed_us = (TickTime::Now() - start_time).Microseconds();
+  printf("Inserted %d packets in %d us (%.0f packets/s)\n", num_packets,
+         static_cast<int>(elapsed_us),
+         num_packets * 1e6 / (elapsed_us > 0 ? elapsed_us : 1));
+  // Only the frames waiting for their retransmission remain.
+  EXPECT_EQ(kNumFrames - kRetransmissionDelayFrames + kLossInterval - 1,
+            num_decoded_frames);
+}
+
 }  // namespace webrtc
@@ -125,13 +125,16 @@ int ViECodecImpl::SetSendCodec(const int video_channel,
                  ViEId(shared_data_->instance_id(), video_channel),
                  "pictureLossIndicationOn: %d, feedbackModeOn: %d, "
                  "complexity: %d, resilience: %d, numberOfTemporalLayers: %u"
-                 "keyFrameInterval %d",
+                 "keyFrameInterval %d, numberOfThreads: %d, "
+                 "numberOfTokenPartitions: %d",
                  video_codec.codecSpecific.VP8.pictureLossIndicationOn,
                  video_codec.codecSpecific.VP8.feedbackModeOn,
                  video_codec.codecSpecific.VP8.complexity,
                  video_codec.codecSpecific.VP8.resilience,
                  video_codec.codecSpecific.VP8.numberOfTemporalLayers,
-                 video_codec.codecSpecific.VP8.keyFrameInterval);
+                 video_codec.codecSpecific.VP8.keyFrameInterval,
+                 video_codec.codecSpecific.VP8.numberOfThreads,
+                 video_codec.codecSpecific.VP8.numberOfTokenPartitions);
   }
   if (!CodecValid(video_codec)) {
     // Error logged.
@@ -28,6 +28,7 @@
 #ifndef TALK_XMLLITE_QNAME_H_
 #define TALK_XMLLITE_QNAME_H_
 
+#include <atomic>
 #include <string>
 
 namespace buzz {
@@ -49,17 +50,26 @@ struct StaticQName {
   bool operator!=(const QName& other) const;
 };
 
+// QName values are interned: every distinct (namespace, local part) pair
+// is stored once in a process-wide table and QName itself is a single
+// reference-counted pointer into it. Copies are a pointer copy plus a
+// reference bump, and equality between two QNames is a pointer compare.
+// Entries are dropped from the table when the last QName using them goes
+// away, so names taken from untrusted input don't accumulate.
 class QName {
  public:
   QName();
   QName(const QName& qname);
   QName(const StaticQName& const_value);
   QName(const std::string& ns, const std::string& local);
+  QName(const std::string& ns, const char* local);
   explicit QName(const std::string& merged_or_local);
   ~QName();
 
-  const std::string& Namespace() const { return namespace_; }
-  const std::string& LocalPart() const { return local_part_; }
+  QName& operator=(const QName& other);
+
+  const std::string& Namespace() const { return data_->ns; }
+  const std::string& LocalPart() const { return data_->local; }
   std::string Merged() const;
   bool IsEmpty() const;
 
@@ -70,21 +80,37 @@ class QName {
     return Compare(other) == 0;
   }
   bool operator==(const QName& other) const {
-    return Compare(other) == 0;
+    return data_ == other.data_;
   }
   bool operator!=(const StaticQName& other) const {
     return Compare(other) != 0;
   }
   bool operator!=(const QName& other) const {
-    return Compare(other) != 0;
+    return data_ != other.data_;
   }
   bool operator<(const QName& other) const {
     return Compare(other) < 0;
   }
 
+  // Number of distinct names currently interned. Exposed for tests.
+  static size_t InternedCount();
+
  private:
-  std::string namespace_;
-  std::string local_part_;
+  struct Data {
+    std::string ns;
+    std::string local;
+    // Only transitions to and from zero happen under the table lock.
+    std::atomic<int> refs;
+  };
+
+  static const Data* Intern(const char* ns, size_t ns_len,
+                            const char* local, size_t local_len);
+  static void AddRef(const Data* data);
+  static void Release(const Data* data);
+
+  const Data* data_;
+
+  friend class QNameTable;
 };
 
 inline bool StaticQName::operator==(const QName& other) const {
@@ -0,0 +1,87 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef TALK_XMLLITE_XMLARENA_H_
+#define TALK_XMLLITE_XMLARENA_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/constructormagic.h"
+
+namespace buzz {
+
+// A bump allocator for the nodes of one XmlElement tree. XmlElement,
+// XmlAttr and XmlText can be placed in an arena with
+//   new (arena) XmlElement(name);
+// and nodes added to an arena element through its Add*/Set* methods land in
+// the same arena. Deleting an arena node runs its destructor but returns no
+// memory; the whole arena is released in one shot when its owner, normally
+// the root element, is deleted.
+//
+// Nodes of an arena tree must not be unlinked and kept beyond the lifetime
+// of the root; copy them with the XmlElement copy constructor instead,
+// which always allocates from the heap.
+class XmlArena {
+ public:
+  static const size_t kDefaultBlockSize = 4096;
+
+  explicit XmlArena(size_t block_size = kDefaultBlockSize);
+  ~XmlArena();
+
+  // The node whose deletion destroys the arena.
+  const void* owner() const { return owner_; }
+  void set_owner(const void* owner) { owner_ = owner; }
+
+  // Total bytes handed out, including per-node headers.
+  size_t allocated() const { return allocated_; }
+
+  // Node allocation used by the class-specific operator new/delete of the
+  // xmllite node types. |arena| may be NULL for a plain heap allocation.
+  static void* AllocateNode(size_t size, XmlArena* arena);
+  static void FreeNode(void* node);
+  // Returns the arena |node| was allocated from, or NULL for heap nodes.
+  static XmlArena* ArenaOf(const void* node);
+
+ private:
+  void* Allocate(size_t size);
+
+  size_t block_size_;
+  std::vector<char*> blocks_;
+  char* next_;
+  char* end_;
+  size_t allocated_;
+  const void* owner_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmlArena);
+};
+
+}  // namespace buzz
+
+#endif  // TALK_XMLLITE_XMLARENA_H_
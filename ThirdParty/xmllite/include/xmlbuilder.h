@@ -41,6 +41,7 @@
 
 namespace buzz {
 
+class XmlArena;
 class XmlElement;
 class XmlParseContext;
 
@@ -51,6 +52,9 @@ public:
 
   static XmlElement * BuildElement(XmlParseContext * pctx,
                                   const char * name, const char ** atts);
+  static XmlElement * BuildElement(XmlParseContext * pctx,
+                                  const char * name, const char ** atts,
+                                  XmlArena * arena);
   virtual void StartElement(XmlParseContext * pctx,
                             const char * name, const char ** atts);
   virtual void EndElement(XmlParseContext * pctx, const char * name);
@@ -61,6 +65,12 @@ public:
 
   void Reset();
 
+  // When set, each top-level element is built in its own XmlArena that is
+  // released together with the element. Callers must not keep pointers to
+  // nodes of such a tree after deleting the root; see xmlarena.h.
+  void set_use_arena(bool use_arena) { use_arena_ = use_arena; }
+  bool use_arena() const { return use_arena_; }
+
   // Take ownership of the built element; second call returns NULL
   XmlElement * CreateElement();
 
@@ -71,6 +81,7 @@ private:
   XmlElement * pelCurrent_;
   talk_base::scoped_ptr<XmlElement> pelRoot_;
   talk_base::scoped_ptr<std::vector<XmlElement*> > pvParents_;
+  bool use_arena_;
 };
 
 }
@@ -33,6 +33,7 @@
 
 #include "base/scoped_ptr.h"
 #include "qname.h"
+#include "xmlarena.h"
 
 namespace buzz {
 
@@ -43,6 +44,21 @@ class XmlAttr;
 
 class XmlChild {
  public:
+  // All nodes are allocated through XmlArena, either from an arena or,
+  // by default, from the heap; see xmlarena.h.
+  static void* operator new(size_t size) {
+    return XmlArena::AllocateNode(size, NULL);
+  }
+  static void* operator new(size_t size, XmlArena* arena) {
+    return XmlArena::AllocateNode(size, arena);
+  }
+  static void operator delete(void* node) {
+    XmlArena::FreeNode(node);
+  }
+  static void operator delete(void* node, XmlArena* arena) {
+    XmlArena::FreeNode(node);
+  }
+
   XmlChild* NextChild() { return next_child_; }
   const XmlChild* NextChild() const { return next_child_; }
 
@@ -107,6 +123,21 @@ class XmlText : public XmlChild {
 
 class XmlAttr {
  public:
+  // All nodes are allocated through XmlArena, either from an arena or,
+  // by default, from the heap; see xmlarena.h.
+  static void* operator new(size_t size) {
+    return XmlArena::AllocateNode(size, NULL);
+  }
+  static void* operator new(size_t size, XmlArena* arena) {
+    return XmlArena::AllocateNode(size, arena);
+  }
+  static void operator delete(void* node) {
+    XmlArena::FreeNode(node);
+  }
+  static void operator delete(void* node, XmlArena* arena) {
+    XmlArena::FreeNode(node);
+  }
+
   XmlAttr* NextAttr() const { return next_attr_; }
   const QName& Name() const { return name_; }
   const std::string& Value() const { return value_; }
@@ -136,6 +167,12 @@ class XmlElement : public XmlChild {
   explicit XmlElement(const QName& name, bool useDefaultNs);
   explicit XmlElement(const XmlElement& elt);
 
+  // Creates an element in |arena|. Attributes, text and children added
+  // through this element's methods are allocated from the same arena. When
+  // |arena| has no owner yet, the new element becomes the owner and deleting
+  // it releases the arena.
+  static XmlElement* Create(const QName& name, XmlArena* arena);
+
   virtual ~XmlElement();
 
   const QName& Name() const { return name_; }
@@ -231,6 +268,8 @@ class XmlElement : public XmlChild {
   std::string Str() const;
 
   bool IsCDATA() const { return cdata_; }
+  // The arena new nodes of this element are allocated from, or NULL.
+  XmlArena* arena() const { return arena_; }
 
  protected:
   virtual bool IsTextImpl() const;
@@ -243,6 +282,7 @@ class XmlElement : public XmlChild {
   XmlAttr* last_attr_;
   XmlChild* first_child_;
   XmlChild* last_child_;
+  XmlArena* arena_;
   bool cdata_;
 };
 
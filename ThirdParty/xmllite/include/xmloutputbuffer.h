@@ -0,0 +1,99 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef TALK_XMLLITE_XMLOUTPUTBUFFER_H_
+#define TALK_XMLLITE_XMLOUTPUTBUFFER_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/constructormagic.h"
+
+namespace buzz {
+
+// A growable output buffer made of a list of fixed-size chunks. Appending
+// never moves bytes that are already buffered, so serializing a large
+// stanza costs one copy of each byte into the buffer, and the chunks can
+// then be handed to the socket as-is with a gather write.
+//
+// Clear() keeps the first chunk around so a buffer reused for every flush
+// normally doesn't allocate at all.
+class XmlOutputBuffer {
+ public:
+  static const size_t kDefaultChunkSize = 4096;
+
+  struct Chunk {
+    const char* data;
+    size_t length;
+  };
+
+  explicit XmlOutputBuffer(size_t chunk_size = kDefaultChunkSize);
+  ~XmlOutputBuffer();
+
+  void Append(const char* data, size_t length);
+  void Append(const std::string& data) { Append(data.data(), data.length()); }
+  void Append(const char* text) { Append(text, strlen(text)); }
+  void Append(char c) { Append(&c, 1); }
+
+  // Total number of buffered bytes.
+  size_t length() const { return length_; }
+  bool empty() const { return length_ == 0; }
+
+  // The buffered bytes, in order, as a list of non-empty chunks.
+  size_t chunk_count() const;
+  Chunk chunk(size_t index) const;
+
+  // Drops the first |length| bytes, e.g. after a partial write.
+  void Consume(size_t length);
+  void Clear();
+
+  // Copies the buffered bytes into a string; mostly for tests and logging.
+  std::string Str() const;
+
+ private:
+  struct Block {
+    char* data;
+    size_t capacity;
+    size_t length;
+  };
+
+  size_t chunk_size_;
+  std::vector<Block> blocks_;
+  // Bytes already consumed from the front of blocks_[0].
+  size_t offset_;
+  size_t length_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmlOutputBuffer);
+};
+
+}  // namespace buzz
+
+#endif  // TALK_XMLLITE_XMLOUTPUTBUFFER_H_
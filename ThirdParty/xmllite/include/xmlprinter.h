@@ -35,6 +35,7 @@ namespace buzz {
 
 class XmlElement;
 class XmlnsStack;
+class XmlOutputBuffer;
 
 class XmlPrinter {
  public:
@@ -42,6 +43,10 @@ class XmlPrinter {
 
   static void PrintXml(std::ostream* pout, const XmlElement* pelt,
                        XmlnsStack* ns_stack);
+
+  // Serializes straight into |out| without building an intermediate string.
+  static void PrintXml(XmlOutputBuffer* out, const XmlElement* pelt,
+                       XmlnsStack* ns_stack);
 };
 
 }  // namespace buzz
@@ -27,69 +27,214 @@
 
 #include "qname.h"
 
+#include <string.h>
+
+#include <unordered_map>
+
+#include "base/basictypes.h"
+#include "base/common.h"
+#include "base/criticalsection.h"
+
 namespace buzz {
 
-QName::QName() {
+// The intern table. Keys point into the strings of the Data they map to, so
+// a lookup never has to build a std::string.
+class QNameTable {
+ public:
+  static QNameTable* Instance() {
+    LIBJINGLE_DEFINE_STATIC_LOCAL(QNameTable, table, ());
+    return &table;
+  }
+
+  QNameTable() {
+    // The empty name is used for every default-constructed QName; hold a
+    // permanent reference so it never leaves the table.
+    empty_ = Intern("", 0, "", 0);
+  }
+
+  const QName::Data* empty() const { return empty_; }
+
+  const QName::Data* Intern(const char* ns, size_t ns_len,
+                            const char* local, size_t local_len) {
+    Key key = { ns, ns_len, local, local_len };
+    talk_base::CritScope cs(&crit_);
+    Map::iterator it = names_.find(key);
+    if (it != names_.end()) {
+      it->second->refs.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+    QName::Data* data = new QName::Data;
+    data->ns.assign(ns, ns_len);
+    data->local.assign(local, local_len);
+    data->refs.store(1, std::memory_order_relaxed);
+    Key stored = { data->ns.data(), ns_len, data->local.data(), local_len };
+    names_[stored] = data;
+    return data;
+  }
+
+  // Drops a reference that may be the last one.
+  void ReleaseLast(QName::Data* data) {
+    talk_base::CritScope cs(&crit_);
+    if (data->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    Key key = { data->ns.data(), data->ns.size(),
+                data->local.data(), data->local.size() };
+    names_.erase(key);
+    delete data;
+  }
+
+  size_t size() {
+    talk_base::CritScope cs(&crit_);
+    return names_.size();
+  }
+
+ private:
+  struct Key {
+    const char* ns;
+    size_t ns_len;
+    const char* local;
+    size_t local_len;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      // FNV-1a over both parts, with a separator so that ("ab", "c") and
+      // ("a", "bc") hash differently.
+      size_t hash = 2166136261u;
+      for (size_t i = 0; i < key.ns_len; ++i)
+        hash = (hash ^ static_cast<unsigned char>(key.ns[i])) * 16777619u;
+      hash = (hash ^ 0xff) * 16777619u;
+      for (size_t i = 0; i < key.local_len; ++i)
+        hash = (hash ^ static_cast<unsigned char>(key.local[i])) * 16777619u;
+      return hash;
+    }
+  };
+
+  struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const {
+      return a.ns_len == b.ns_len && a.local_len == b.local_len &&
+          memcmp(a.local, b.local, a.local_len) == 0 &&
+          memcmp(a.ns, b.ns, a.ns_len) == 0;
+    }
+  };
+
+  typedef std::unordered_map<Key, QName::Data*, KeyHash, KeyEqual> Map;
+
+  talk_base::CriticalSection crit_;
+  Map names_;
+  const QName::Data* empty_;
+
+  DISALLOW_COPY_AND_ASSIGN(QNameTable);
+};
+
+const QName::Data* QName::Intern(const char* ns, size_t ns_len,
+                                 const char* local, size_t local_len) {
+  return QNameTable::Instance()->Intern(ns, ns_len, local, local_len);
+}
+
+void QName::AddRef(const Data* data) {
+  // The caller already holds a reference, so the count can't be zero and
+  // the entry can't be erased concurrently.
+  const_cast<Data*>(data)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void QName::Release(const Data* data) {
+  Data* mutable_data = const_cast<Data*>(data);
+  int refs = mutable_data->refs.load(std::memory_order_relaxed);
+  while (refs > 1) {
+    if (mutable_data->refs.compare_exchange_weak(refs, refs - 1,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  // Possibly the last reference; the table lock serializes this with
+  // lookups that could revive the entry.
+  QNameTable::Instance()->ReleaseLast(mutable_data);
+}
+
+size_t QName::InternedCount() {
+  return QNameTable::Instance()->size();
+}
+
+QName::QName() : data_(QNameTable::Instance()->empty()) {
+  AddRef(data_);
 }
 
-QName::QName(const QName& qname)
-    : namespace_(qname.namespace_),
-      local_part_(qname.local_part_) {
+QName::QName(const QName& qname) : data_(qname.data_) {
+  AddRef(data_);
 }
 
 QName::QName(const StaticQName& const_value)
-    : namespace_(const_value.ns),
-      local_part_(const_value.local) {
+    : data_(Intern(const_value.ns, strlen(const_value.ns),
+                   const_value.local, strlen(const_value.local))) {
 }
 
 QName::QName(const std::string& ns, const std::string& local)
-    : namespace_(ns),
-      local_part_(local) {
+    : data_(Intern(ns.data(), ns.size(), local.data(), local.size())) {
+}
+
+QName::QName(const std::string& ns, const char* local)
+    : data_(Intern(ns.data(), ns.size(), local, strlen(local))) {
 }
 
 QName::QName(const std::string& merged_or_local) {
   size_t i = merged_or_local.rfind(':');
   if (i == std::string::npos) {
-    local_part_ = merged_or_local;
+    data_ = Intern("", 0, merged_or_local.data(), merged_or_local.size());
   } else {
-    namespace_ = merged_or_local.substr(0, i);
-    local_part_ = merged_or_local.substr(i + 1);
+    data_ = Intern(merged_or_local.data(), i,
+                   merged_or_local.data() + i + 1,
+                   merged_or_local.size() - i - 1);
   }
 }
 
 QName::~QName() {
+  Release(data_);
+}
+
+QName& QName::operator=(const QName& other) {
+  if (data_ != other.data_) {
+    AddRef(other.data_);
+    Release(data_);
+    data_ = other.data_;
+  }
+  return *this;
 }
 
 std::string QName::Merged() const {
-  if (namespace_[0] == '\0')
-    return local_part_;
+  if (data_->ns.empty())
+    return data_->local;
 
   std::string result;
-  result.reserve(namespace_.length() + 1 + local_part_.length());
-  result += namespace_;
+  result.reserve(data_->ns.length() + 1 + data_->local.length());
+  result += data_->ns;
   result += ':';
-  result += local_part_;
+  result += data_->local;
   return result;
 }
 
 bool QName::IsEmpty() const {
-  return namespace_.empty() && local_part_.empty();
+  return data_ == QNameTable::Instance()->empty();
 }
 
 int QName::Compare(const StaticQName& other) const {
-  int result = local_part_.compare(other.local);
+  int result = data_->local.compare(other.local);
   if (result != 0)
     return result;
 
-  return namespace_.compare(other.ns);
+  return data_->ns.compare(other.ns);
 }
 
 int QName::Compare(const QName& other) const {
-  int result = local_part_.compare(other.local_part_);
+  if (data_ == other.data_)
+    return 0;
+
+  int result = data_->local.compare(other.data_->local);
   if (result != 0)
     return result;
 
-  return namespace_.compare(other.namespace_);
+  return data_->ns.compare(other.data_->ns);
 }
 
 }  // namespace buzz
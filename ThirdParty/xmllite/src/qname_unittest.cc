@@ -129,3 +129,34 @@ TEST(QNameTest, TestStaticQName) {
   EXPECT_TRUE(name != name2);
   EXPECT_TRUE(name2 != name);
 }
+
+TEST(QNameTest, TestInterning) {
+  size_t initial = QName::InternedCount();
+  {
+    const StaticQName const_name = { "interning-ns", "interning-local" };
+    QName name1("interning-ns", "interning-local");
+    QName name2("interning-ns:interning-local");
+    QName name3 = const_name;
+    EXPECT_EQ(initial + 1, QName::InternedCount());
+    // Equal names share one interned entry.
+    EXPECT_EQ(&name1.LocalPart(), &name2.LocalPart());
+    EXPECT_EQ(&name1.Namespace(), &name3.Namespace());
+
+    QName other("interning-ns", "other-local");
+    EXPECT_EQ(initial + 2, QName::InternedCount());
+    other = name1;
+    EXPECT_EQ(initial + 1, QName::InternedCount());
+    EXPECT_TRUE(other == name1);
+  }
+  // Names drop out of the table with their last reference.
+  EXPECT_EQ(initial, QName::InternedCount());
+}
+
+TEST(QNameTest, TestEmpty) {
+  QName empty;
+  QName empty2("", "");
+  EXPECT_TRUE(empty.IsEmpty());
+  EXPECT_TRUE(empty2.IsEmpty());
+  EXPECT_TRUE(empty == empty2);
+  EXPECT_FALSE(QName("", "a").IsEmpty());
+}
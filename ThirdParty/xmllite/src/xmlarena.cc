@@ -0,0 +1,122 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "xmlarena.h"
+
+#include <new>
+
+#include "base/common.h"
+
+namespace buzz {
+
+namespace {
+
+// Every node, heap or arena, is preceded by a header naming its arena. The
+// header is padded so that the node itself stays maximally aligned.
+union NodeHeader {
+  XmlArena* arena;
+  long double align_;
+};
+
+const size_t kAlignment = sizeof(NodeHeader);
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+NodeHeader* HeaderOf(const void* node) {
+  return reinterpret_cast<NodeHeader*>(
+      const_cast<char*>(static_cast<const char*>(node))) - 1;
+}
+
+}  // namespace
+
+XmlArena::XmlArena(size_t block_size)
+    : block_size_(AlignUp(block_size)),
+      next_(NULL),
+      end_(NULL),
+      allocated_(0),
+      owner_(NULL) {
+}
+
+XmlArena::~XmlArena() {
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    ::operator delete(blocks_[i]);
+  }
+}
+
+void* XmlArena::Allocate(size_t size) {
+  size = AlignUp(size);
+  if (size > static_cast<size_t>(end_ - next_)) {
+    // Oversized requests get a block of their own so the current block can
+    // keep serving small nodes.
+    size_t block = size > block_size_ ? size : block_size_;
+    char* memory = static_cast<char*>(::operator new(block));
+    blocks_.push_back(memory);
+    if (size > block_size_) {
+      allocated_ += size;
+      return memory;
+    }
+    next_ = memory;
+    end_ = memory + block;
+  }
+  void* result = next_;
+  next_ += size;
+  allocated_ += size;
+  return result;
+}
+
+void* XmlArena::AllocateNode(size_t size, XmlArena* arena) {
+  size_t total = sizeof(NodeHeader) + size;
+  NodeHeader* header;
+  if (arena) {
+    header = static_cast<NodeHeader*>(arena->Allocate(total));
+  } else {
+    header = static_cast<NodeHeader*>(::operator new(total));
+  }
+  header->arena = arena;
+  return header + 1;
+}
+
+void XmlArena::FreeNode(void* node) {
+  if (!node)
+    return;
+  NodeHeader* header = HeaderOf(node);
+  XmlArena* arena = header->arena;
+  if (!arena) {
+    ::operator delete(header);
+  } else if (arena->owner_ == node) {
+    delete arena;
+  }
+}
+
+XmlArena* XmlArena::ArenaOf(const void* node) {
+  return HeaderOf(node)->arena;
+}
+
+}  // namespace buzz
@@ -30,15 +30,30 @@
 #include <vector>
 #include <set>
 #include "base/common.h"
+#include "xmlarena.h"
 #include "xmlconstants.h"
 #include "xmlelement.h"
 
 namespace buzz {
 
+namespace {
+
+// Deletes an element that failed to build. If it owns its arena, ownership
+// is dropped first so that the arena stays with whoever supplied it.
+void DiscardElement(XmlElement* element) {
+  XmlArena* arena = element->arena();
+  if (arena && arena->owner() == element)
+    arena->set_owner(NULL);
+  delete element;
+}
+
+}  // namespace
+
 XmlBuilder::XmlBuilder() :
   pelCurrent_(NULL),
   pelRoot_(NULL),
-  pvParents_(new std::vector<XmlElement *>()) {
+  pvParents_(new std::vector<XmlElement *>()),
+  use_arena_(false) {
 }
 
 void
@@ -51,11 +66,18 @@ XmlBuilder::Reset() {
 XmlElement *
 XmlBuilder::BuildElement(XmlParseContext * pctx,
                               const char * name, const char ** atts) {
+  return BuildElement(pctx, name, atts, NULL);
+}
+
+XmlElement *
+XmlBuilder::BuildElement(XmlParseContext * pctx,
+                              const char * name, const char ** atts,
+                              XmlArena * arena) {
   QName tagName(pctx->ResolveQName(name, false));
   if (tagName.IsEmpty())
     return NULL;
 
-  XmlElement * pelNew = new XmlElement(tagName);
+  XmlElement * pelNew = XmlElement::Create(tagName, arena);
 
   if (!*atts)
     return pelNew;
@@ -65,14 +87,14 @@ XmlBuilder::BuildElement(XmlParseContext * pctx,
   while (*atts) {
     QName attName(pctx->ResolveQName(*atts, true));
     if (attName.IsEmpty()) {
-      delete pelNew;
+      DiscardElement(pelNew);
       return NULL;
     }
 
     // verify that namespaced names are unique
     if (!attName.Namespace().empty()) {
       if (seenNonlocalAtts.count(attName)) {
-        delete pelNew;
+        DiscardElement(pelNew);
         return NULL;
       }
       seenNonlocalAtts.insert(attName);
@@ -88,8 +110,19 @@ XmlBuilder::BuildElement(XmlParseContext * pctx,
 void
 XmlBuilder::StartElement(XmlParseContext * pctx,
                               const char * name, const char ** atts) {
-  XmlElement * pelNew = BuildElement(pctx, name, atts);
+  XmlArena * arena = NULL;
+  if (!pelCurrent_) {
+    // The root element takes ownership of a fresh arena.
+    if (use_arena_)
+      arena = new XmlArena();
+  } else {
+    arena = pelCurrent_->arena();
+  }
+
+  XmlElement * pelNew = BuildElement(pctx, name, atts, arena);
   if (pelNew == NULL) {
+    if (!pelCurrent_)
+      delete arena;  // Never owned by the discarded element.
     pctx->RaiseError(XML_ERROR_SYNTAX);
     return;
   }
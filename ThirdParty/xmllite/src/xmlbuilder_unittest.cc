@@ -192,3 +192,34 @@ TEST(XmlBuilderTest, TestAttrCollision3) {
   EXPECT_TRUE(NULL == builder.BuiltElement());
 }
 
+
+TEST(XmlBuilderTest, TestArena) {
+  XmlBuilder builder;
+  builder.set_use_arena(true);
+  XmlParser::ParseXml(&builder,
+      "<iq xmlns='jabber:client' type='get' id='1'>"
+      "<query xmlns='q'>text<item a='b'/></query></iq>");
+  XmlElement* element = builder.BuiltElement();
+  ASSERT_TRUE(element != NULL);
+  ASSERT_TRUE(element->arena() != NULL);
+  EXPECT_EQ(element, element->arena()->owner());
+  EXPECT_EQ(element->arena(), element->FirstElement()->arena());
+  EXPECT_EQ("<iq xmlns=\"jabber:client\" type=\"get\" id=\"1\">"
+            "<query xmlns=\"q\">text<item a=\"b\"/></query></iq>",
+            element->Str());
+
+  // Each top-level element gets a fresh arena.
+  builder.Reset();
+  XmlParser::ParseXml(&builder, "<testing/>");
+  ASSERT_TRUE(builder.BuiltElement() != NULL);
+  EXPECT_EQ(builder.BuiltElement(), builder.BuiltElement()->arena()->owner());
+}
+
+TEST(XmlBuilderTest, TestArenaError) {
+  XmlBuilder builder;
+  builder.set_use_arena(true);
+  XmlParser::ParseXml(&builder, "<testing a='1' a='2'/>");
+  EXPECT_TRUE(builder.BuiltElement() == NULL);
+  XmlParser::ParseXml(&builder, "<root><bad a:b='1'/></root>");
+  EXPECT_TRUE(builder.BuiltElement() == NULL);
+}
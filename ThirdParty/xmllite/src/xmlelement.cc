@@ -77,6 +77,7 @@ XmlElement::XmlElement(const QName& name) :
     last_attr_(NULL),
     first_child_(NULL),
     last_child_(NULL),
+    arena_(NULL),
     cdata_(false) {
 }
 
@@ -87,6 +88,7 @@ XmlElement::XmlElement(const XmlElement& elt) :
     last_attr_(NULL),
     first_child_(NULL),
     last_child_(NULL),
+    arena_(NULL),
     cdata_(false) {
 
   // copy attributes
@@ -125,9 +127,18 @@ XmlElement::XmlElement(const QName& name, bool useDefaultNs) :
   last_attr_(first_attr_),
   first_child_(NULL),
   last_child_(NULL),
+  arena_(NULL),
   cdata_(false) {
 }
 
+XmlElement* XmlElement::Create(const QName& name, XmlArena* arena) {
+  XmlElement* element = new (arena) XmlElement(name);
+  element->arena_ = arena;
+  if (arena && !arena->owner())
+    arena->set_owner(element);
+  return element;
+}
+
 bool XmlElement::IsTextImpl() const {
   return false;
 }
@@ -215,7 +226,7 @@ void XmlElement::SetAttr(const QName& name, const std::string& value) {
       break;
   }
   if (!attr) {
-    attr = new XmlAttr(name, value);
+    attr = new (arena_) XmlAttr(name, value);
     if (last_attr_)
       last_attr_->next_attr_ = attr;
     else
@@ -329,7 +340,7 @@ XmlElement::NextNamed(const StaticQName& name) {
 XmlElement* XmlElement::FindOrAddNamedChild(const QName& name) {
   XmlElement* child = FirstNamed(name);
   if (!child) {
-    child = new XmlElement(name);
+    child = Create(name, arena_);
     AddElement(child);
   }
 
@@ -378,7 +389,7 @@ void XmlElement::AddAttr(const QName& name, const std::string& value) {
   ASSERT(!HasAttr(name));
 
   XmlAttr ** pprev = last_attr_ ? &(last_attr_->next_attr_) : &first_attr_;
-  last_attr_ = (*pprev = new XmlAttr(name, value));
+  last_attr_ = (*pprev = new (arena_) XmlAttr(name, value));
 }
 
 void XmlElement::AddAttr(const QName& name, const std::string& value,
@@ -399,7 +410,7 @@ void XmlElement::AddParsedText(const char* cstr, int len) {
     return;
   }
   XmlChild ** pprev = last_child_ ? &(last_child_->next_child_) : &first_child_;
-  last_child_ = *pprev = new XmlText(cstr, len);
+  last_child_ = *pprev = new (arena_) XmlText(cstr, len);
 }
 
 void XmlElement::AddCDATAText(const char* buf, int len) {
@@ -416,7 +427,7 @@ void XmlElement::AddText(const std::string& text) {
     return;
   }
   XmlChild ** pprev = last_child_ ? &(last_child_->next_child_) : &first_child_;
-  last_child_ = *pprev = new XmlText(text);
+  last_child_ = *pprev = new (arena_) XmlText(text);
 }
 
 void XmlElement::AddText(const std::string& text, int depth) {
@@ -34,6 +34,7 @@
 #include "xmlelement.h"
 
 using buzz::QName;
+using buzz::XmlArena;
 using buzz::XmlAttr;
 using buzz::XmlChild;
 using buzz::XmlElement;
@@ -269,3 +270,39 @@ TEST(XmlElementTest, TestMultithread) {
     delete threads[i];
   }
 }
+
+TEST(XmlElementTest, TestArena) {
+  XmlArena* arena = new XmlArena();
+  XmlElement* root = XmlElement::Create(QName("root"), arena);
+  EXPECT_EQ(root, arena->owner());
+  EXPECT_EQ(arena, root->arena());
+
+  root->AddAttr(QName("a"), "1");
+  root->SetAttr(QName("b"), "2");
+  root->AddText("text");
+  XmlElement* child = root->FindOrAddNamedChild(QName("child"));
+  EXPECT_EQ(arena, child->arena());
+  child->AddAttr(QName("c"), "3");
+  child->AddElement(new XmlElement(QName("heap")));
+  EXPECT_EQ(arena, XmlArena::ArenaOf(child));
+  EXPECT_EQ(arena, XmlArena::ArenaOf(root->FirstAttr()));
+  EXPECT_TRUE(XmlArena::ArenaOf(child->FirstElement()) == NULL);
+  EXPECT_LT(0U, arena->allocated());
+
+  EXPECT_EQ("<root a=\"1\" b=\"2\">text<child c=\"3\"><heap/></child></root>",
+            root->Str());
+
+  // Copies always live on the heap and survive the arena.
+  XmlElement* copy = new XmlElement(*root);
+  EXPECT_TRUE(copy->arena() == NULL);
+  EXPECT_TRUE(XmlArena::ArenaOf(copy->FirstElement()) == NULL);
+
+  // Removing an arena node runs its destructor but keeps the arena alive.
+  root->ClearChildren();
+  EXPECT_EQ("<root a=\"1\" b=\"2\"/>", root->Str());
+
+  delete root;  // Releases the arena.
+  EXPECT_EQ("<root a=\"1\" b=\"2\">text<child c=\"3\"><heap/></child></root>",
+            copy->Str());
+  delete copy;
+}
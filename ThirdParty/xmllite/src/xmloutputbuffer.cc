@@ -0,0 +1,134 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "xmloutputbuffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/common.h"
+
+namespace buzz {
+
+XmlOutputBuffer::XmlOutputBuffer(size_t chunk_size)
+    : chunk_size_(chunk_size),
+      offset_(0),
+      length_(0) {
+  ASSERT(chunk_size_ > 0);
+}
+
+XmlOutputBuffer::~XmlOutputBuffer() {
+  for (size_t i = 0; i < blocks_.size(); ++i)
+    delete[] blocks_[i].data;
+}
+
+void XmlOutputBuffer::Append(const char* data, size_t length) {
+  length_ += length;
+  while (length > 0) {
+    if (blocks_.empty() || blocks_.back().length == blocks_.back().capacity) {
+      Block block;
+      block.capacity = std::max(chunk_size_, length);
+      block.data = new char[block.capacity];
+      block.length = 0;
+      blocks_.push_back(block);
+    }
+    Block& block = blocks_.back();
+    size_t count = std::min(length, block.capacity - block.length);
+    memcpy(block.data + block.length, data, count);
+    block.length += count;
+    data += count;
+    length -= count;
+  }
+}
+
+size_t XmlOutputBuffer::chunk_count() const {
+  // Only the last block can be empty, and only right after Clear().
+  if (blocks_.empty() || length_ == 0)
+    return 0;
+  return blocks_.size();
+}
+
+XmlOutputBuffer::Chunk XmlOutputBuffer::chunk(size_t index) const {
+  ASSERT(index < chunk_count());
+  Chunk chunk;
+  size_t skip = (index == 0) ? offset_ : 0;
+  chunk.data = blocks_[index].data + skip;
+  chunk.length = blocks_[index].length - skip;
+  return chunk;
+}
+
+void XmlOutputBuffer::Consume(size_t length) {
+  ASSERT(length <= length_);
+  length = std::min(length, length_);
+  length_ -= length;
+  while (length > 0) {
+    Block& front = blocks_.front();
+    size_t available = front.length - offset_;
+    if (length < available) {
+      offset_ += length;
+      return;
+    }
+    length -= available;
+    offset_ = 0;
+    if (blocks_.size() == 1) {
+      front.length = 0;
+    } else {
+      delete[] front.data;
+      blocks_.erase(blocks_.begin());
+    }
+  }
+  if (length_ == 0)
+    Clear();
+}
+
+void XmlOutputBuffer::Clear() {
+  // Keep one regular-sized block for reuse; oversized ones came from a
+  // single large append and aren't worth holding on to.
+  size_t keep =
+      (!blocks_.empty() && blocks_[0].capacity == chunk_size_) ? 1 : 0;
+  for (size_t i = keep; i < blocks_.size(); ++i)
+    delete[] blocks_[i].data;
+  blocks_.resize(keep);
+  if (keep)
+    blocks_[0].length = 0;
+  offset_ = 0;
+  length_ = 0;
+}
+
+std::string XmlOutputBuffer::Str() const {
+  std::string result;
+  result.reserve(length_);
+  for (size_t i = 0; i < chunk_count(); ++i) {
+    Chunk c = chunk(i);
+    result.append(c.data, c.length);
+  }
+  return result;
+}
+
+}  // namespace buzz
@@ -0,0 +1,97 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "xmloutputbuffer.h"
+
+#include <string>
+
+#include "base/gunit.h"
+
+using buzz::XmlOutputBuffer;
+
+TEST(XmlOutputBufferTest, TestAppend) {
+  XmlOutputBuffer buffer(8);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0U, buffer.chunk_count());
+
+  buffer.Append("<iq ");
+  buffer.Append(std::string("type=\"get\""));
+  buffer.Append('>');
+  EXPECT_EQ(15U, buffer.length());
+  EXPECT_EQ("<iq type=\"get\">", buffer.Str());
+
+  // Appends fill the current chunk before starting a new one.
+  ASSERT_EQ(2U, buffer.chunk_count());
+  EXPECT_EQ(8U, buffer.chunk(0).length);
+  EXPECT_EQ(7U, buffer.chunk(1).length);
+  EXPECT_EQ("<iq type", std::string(buffer.chunk(0).data,
+                                    buffer.chunk(0).length));
+}
+
+TEST(XmlOutputBufferTest, TestConsume) {
+  XmlOutputBuffer buffer(4);
+  buffer.Append("abc");
+  buffer.Append("defgh");
+  buffer.Append("ij");
+  ASSERT_EQ(3U, buffer.chunk_count());
+
+  buffer.Consume(2);
+  EXPECT_EQ("cdefghij", buffer.Str());
+  EXPECT_EQ(2U, buffer.chunk(0).length);
+
+  buffer.Consume(2);
+  EXPECT_EQ("efghij", buffer.Str());
+  EXPECT_EQ(2U, buffer.chunk_count());
+
+  buffer.Consume(6);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0U, buffer.chunk_count());
+
+  buffer.Append("xyz");
+  EXPECT_EQ("xyz", buffer.Str());
+  EXPECT_EQ(1U, buffer.chunk_count());
+}
+
+TEST(XmlOutputBufferTest, TestClear) {
+  XmlOutputBuffer buffer(4);
+  buffer.Append("0123");
+  buffer.Append("4567");
+  buffer.Clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ("", buffer.Str());
+
+  buffer.Append("abcdef");
+  EXPECT_EQ("abcdef", buffer.Str());
+
+  // A large append into an empty buffer goes into a single chunk.
+  XmlOutputBuffer big_buffer(4);
+  std::string big(100, 'x');
+  big_buffer.Append(big);
+  EXPECT_EQ(big, big_buffer.Str());
+  EXPECT_EQ(1U, big_buffer.chunk_count());
+}
@@ -27,6 +27,8 @@
 
 #include "xmlprinter.h"
 
+#include <string.h>
+
 #include <sstream>
 #include <string>
 #include <vector>
@@ -34,19 +36,29 @@
 #include "xmlconstants.h"
 #include "xmlelement.h"
 #include "xmlnsstack.h"
+#include "xmloutputbuffer.h"
 
 namespace buzz {
 
 class XmlPrinterImpl {
 public:
   XmlPrinterImpl(std::ostream* pout, XmlnsStack* ns_stack);
+  XmlPrinterImpl(XmlOutputBuffer* out, XmlnsStack* ns_stack);
   void PrintElement(const XmlElement* element);
   void PrintQuotedValue(const std::string& text);
   void PrintBodyText(const std::string& text);
   void PrintCDATAText(const std::string& text);
 
 private:
+  void PrintEscaped(const std::string& text, const char* unsafe_chars);
+  void Write(const char* data, size_t length);
+  void Write(const std::string& text) { Write(text.data(), text.length()); }
+  void Write(const char* text) { Write(text, strlen(text)); }
+  void Write(char c) { Write(&c, 1); }
+
+  // Exactly one of these is set.
   std::ostream *pout_;
+  XmlOutputBuffer* out_;
   XmlnsStack* ns_stack_;
 };
 
@@ -61,11 +73,31 @@ void XmlPrinter::PrintXml(std::ostream* pout, const XmlElement* element,
   printer.PrintElement(element);
 }
 
+void XmlPrinter::PrintXml(XmlOutputBuffer* out, const XmlElement* element,
+                          XmlnsStack* ns_stack) {
+  XmlPrinterImpl printer(out, ns_stack);
+  printer.PrintElement(element);
+}
+
 XmlPrinterImpl::XmlPrinterImpl(std::ostream* pout, XmlnsStack* ns_stack)
     : pout_(pout),
+      out_(NULL),
+      ns_stack_(ns_stack) {
+}
+
+XmlPrinterImpl::XmlPrinterImpl(XmlOutputBuffer* out, XmlnsStack* ns_stack)
+    : pout_(NULL),
+      out_(out),
       ns_stack_(ns_stack) {
 }
 
+void XmlPrinterImpl::Write(const char* data, size_t length) {
+  if (out_)
+    out_->Append(data, length);
+  else
+    pout_->write(data, length);
+}
+
 void XmlPrinterImpl::PrintElement(const XmlElement* element) {
   ns_stack_->PushFrame();
 
@@ -98,23 +130,30 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
   }
 
   // print the element name
-  *pout_ << '<' << ns_stack_->FormatQName(element->Name(), false);
+  Write('<');
+  Write(ns_stack_->FormatQName(element->Name(), false));
 
   // and the attributes
   for (attr = element->FirstAttr(); attr; attr = attr->NextAttr()) {
-    *pout_ << ' ' << ns_stack_->FormatQName(attr->Name(), true) << "=\"";
+    Write(' ');
+    Write(ns_stack_->FormatQName(attr->Name(), true));
+    Write("=\"");
     PrintQuotedValue(attr->Value());
-    *pout_ << '"';
+    Write('"');
   }
 
   // and the extra xmlns declarations
   std::vector<std::string>::iterator i(new_ns.begin());
   while (i < new_ns.end()) {
     if (*i == STR_EMPTY) {
-      *pout_ << " xmlns=\"" << *(i + 1) << '"';
+      Write(" xmlns=\"");
     } else {
-      *pout_ << " xmlns:" << *i << "=\"" << *(i + 1) << '"';
+      Write(" xmlns:");
+      Write(*i);
+      Write("=\"");
     }
+    Write(*(i + 1));
+    Write('"');
     i += 2;
   }
 
@@ -122,9 +161,9 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
   const XmlChild* child = element->FirstChild();
 
   if (child == NULL)
-    *pout_ << "/>";
+    Write("/>");
   else {
-    *pout_ << '>';
+    Write('>');
     while (child) {
       if (child->IsText()) {
         if (element->IsCDATA()) {
@@ -137,46 +176,43 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
       }
       child = child->NextChild();
     }
-    *pout_ << "</" << ns_stack_->FormatQName(element->Name(), false) << '>';
+    Write("</");
+    Write(ns_stack_->FormatQName(element->Name(), false));
+    Write('>');
   }
 
   ns_stack_->PopFrame();
 }
 
 void XmlPrinterImpl::PrintQuotedValue(const std::string& text) {
-  size_t safe = 0;
-  for (;;) {
-    size_t unsafe = text.find_first_of("<>&\"", safe);
-    if (unsafe == std::string::npos)
-      unsafe = text.length();
-    *pout_ << text.substr(safe, unsafe - safe);
-    if (unsafe == text.length())
-      return;
-    switch (text[unsafe]) {
-      case '<': *pout_ << "&lt;"; break;
-      case '>': *pout_ << "&gt;"; break;
-      case '&': *pout_ << "&amp;"; break;
-      case '"': *pout_ << "&quot;"; break;
-    }
-    safe = unsafe + 1;
-    if (safe == text.length())
-      return;
-  }
+  PrintEscaped(text, "<>&\"");
 }
 
 void XmlPrinterImpl::PrintBodyText(const std::string& text) {
+  PrintEscaped(text, "<>&");
+}
+
+void XmlPrinterImpl::PrintCDATAText(const std::string& text) {
+  Write("<![CDATA[");
+  Write(text);
+  Write("]]>");
+}
+
+void XmlPrinterImpl::PrintEscaped(const std::string& text,
+                                  const char* unsafe_chars) {
   size_t safe = 0;
   for (;;) {
-    size_t unsafe = text.find_first_of("<>&", safe);
+    size_t unsafe = text.find_first_of(unsafe_chars, safe);
     if (unsafe == std::string::npos)
       unsafe = text.length();
-    *pout_ << text.substr(safe, unsafe - safe);
+    Write(text.data() + safe, unsafe - safe);
     if (unsafe == text.length())
       return;
     switch (text[unsafe]) {
-      case '<': *pout_ << "&lt;"; break;
-      case '>': *pout_ << "&gt;"; break;
-      case '&': *pout_ << "&amp;"; break;
+      case '<': Write("&lt;"); break;
+      case '>': Write("&gt;"); break;
+      case '&': Write("&amp;"); break;
+      case '"': Write("&quot;"); break;
     }
     safe = unsafe + 1;
     if (safe == text.length())
@@ -184,8 +220,4 @@ void XmlPrinterImpl::PrintBodyText(const std::string& text) {
   }
 }
 
-void XmlPrinterImpl::PrintCDATAText(const std::string& text) {
-  *pout_ << "<![CDATA[" << text << "]]>";
-}
-
 }  // namespace buzz
@@ -35,10 +35,12 @@
 #include "qname.h"
 #include "xmlelement.h"
 #include "xmlnsstack.h"
+#include "xmloutputbuffer.h"
 
 using buzz::QName;
 using buzz::XmlElement;
 using buzz::XmlnsStack;
+using buzz::XmlOutputBuffer;
 using buzz::XmlPrinter;
 
 TEST(XmlPrinterTest, TestBasicPrinting) {
@@ -60,3 +62,25 @@ TEST(XmlPrinterTest, TestNamespacedPrinting) {
   XmlPrinter::PrintXml(&ss, &elt, &ns_stack);
   EXPECT_EQ("<gg:first><second/></gg:first>", ss.str());
 }
+
+TEST(XmlPrinterTest, TestPrintToBuffer) {
+  XmlElement elt(QName("google:test", "first"));
+  elt.AddAttr(QName("", "attr"), "a\"b<c");
+  XmlElement* child = new XmlElement(QName("google:test", "second"));
+  child->AddText("x & y > z");
+  elt.AddElement(child);
+
+  std::stringstream ss;
+  XmlnsStack ss_stack;
+  XmlPrinter::PrintXml(&ss, &elt, &ss_stack);
+
+  XmlOutputBuffer buffer(16);
+  XmlnsStack buffer_stack;
+  XmlPrinter::PrintXml(&buffer, &elt, &buffer_stack);
+
+  EXPECT_EQ("<test:first attr=\"a&quot;b&lt;c\" xmlns:test=\"google:test\">"
+            "<test:second>x &amp; y &gt; z</test:second></test:first>",
+            ss.str());
+  EXPECT_EQ(ss.str(), buffer.Str());
+  EXPECT_LT(1U, buffer.chunk_count());
+}
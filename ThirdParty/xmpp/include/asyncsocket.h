@@ -29,6 +29,7 @@
 #define _ASYNCSOCKET_H_
 
 #include "base/sigslot.h"
+#include "xmloutputbuffer.h"
 
 namespace talk_base {
   class SocketAddress;
@@ -67,6 +68,16 @@ public:
   virtual bool Connect(const talk_base::SocketAddress& addr) = 0;
   virtual bool Read(char * data, size_t len, size_t* len_read) = 0;
   virtual bool Write(const char * data, size_t len) = 0;
+  // Writes every chunk of |data| in order. Sockets that can send straight
+  // from the chunks should override this to avoid copying them.
+  virtual bool WriteChunks(const XmlOutputBuffer& data) {
+    for (size_t i = 0; i < data.chunk_count(); ++i) {
+      XmlOutputBuffer::Chunk chunk = data.chunk(i);
+      if (!Write(chunk.data, chunk.length))
+        return false;
+    }
+    return true;
+  }
   virtual bool Close() = 0;
 #if defined(FEATURE_ENABLE_SSL)
   // We allow matching any passed domain.  This allows us to avoid
@@ -92,7 +92,8 @@ class FakeXmppClient : public XmppTaskParentInterface,
   }
 
   virtual void RemoveXmppTask(XmppTask* task) {
-    std::remove(tasks_.begin(), tasks_.end(), task);
+    tasks_.erase(std::remove(tasks_.begin(), tasks_.end(), task),
+                 tasks_.end());
   }
 
   // As FakeXmppClient
@@ -120,6 +120,8 @@ public:
                                            XmppStanzaError code,
                                            const std::string & text);
   virtual void AddXmppTask(XmppTask *, XmppEngine::HandlerLevel);
+  virtual void AddXmppTask(XmppTask *, XmppEngine::HandlerLevel,
+                           const XmppStanzaFilter&);
   virtual void RemoveXmppTask(XmppTask *);
 
  private:
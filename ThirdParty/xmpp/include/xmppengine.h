@@ -32,6 +32,7 @@
 #include "jid.h"
 #include "qname.h"
 #include "xmlelement.h"
+#include "xmloutputbuffer.h"
 
 
 namespace buzz {
@@ -96,6 +97,16 @@ public:
   //! Deliver the specified bytes to the XMPP socket.
   virtual void WriteOutput(const char * bytes, size_t len) = 0;
 
+  //! Deliver everything the engine has buffered since the last flush.
+  //! The default hands each chunk to WriteOutput; handlers that can
+  //! send the chunks in place should override this.
+  virtual void WriteOutputChunks(const XmlOutputBuffer& output) {
+    for (size_t i = 0; i < output.chunk_count(); ++i) {
+      XmlOutputBuffer::Chunk chunk = output.chunk(i);
+      WriteOutput(chunk.data, chunk.length);
+    }
+  }
+
   //! Initiate TLS encryption on the socket.
   //! The implementation must verify that the SSL
   //! certificate matches the given domainname.
@@ -127,6 +138,41 @@ public:
   virtual bool HandleStanza(const XmlElement * stanza) = 0;
 };
 
+//! Describes which stanzas an XmppStanzaHandler wants to see.
+//! Empty fields match anything.  The engine uses the filter to index
+//! handlers so that a stanza is only offered to handlers that could
+//! possibly want it; handlers must still check the stanza themselves.
+class XmppStanzaFilter {
+public:
+  XmppStanzaFilter() {}
+  explicit XmppStanzaFilter(const QName& name) : name_(name) {}
+
+  //! Matches iq stanzas carrying the given id, i.e. responses to
+  //! a request sent with that id.
+  static XmppStanzaFilter IqResponse(const std::string& id);
+
+  const QName& name() const { return name_; }
+  void set_name(const QName& name) { name_ = name; }
+  //! Value of the 'type' attribute.
+  const std::string& type() const { return type_; }
+  void set_type(const std::string& type) { type_ = type; }
+  //! Value of the 'id' attribute.
+  const std::string& id() const { return id_; }
+  void set_id(const std::string& id) { id_ = id; }
+  //! Namespace of at least one direct child element.
+  const std::string& child_ns() const { return child_ns_; }
+  void set_child_ns(const std::string& ns) { child_ns_ = ns; }
+
+  bool IsEmpty() const;
+  bool Matches(const XmlElement* stanza) const;
+
+private:
+  QName name_;
+  std::string type_;
+  std::string id_;
+  std::string child_ns_;
+};
+
 //! Callback to deliver iq responses (results and errors).
 //! Register while sending an iq via XmppEngine.SendIq.
 //! Iq responses are routed to matching XmppIqHandlers in preference
@@ -276,6 +322,11 @@ public:
   //! return 'true' is the last to get each stanza.
   virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler, HandlerLevel level = HL_PEEK) = 0;
 
+  //! Adds a listener that is only offered stanzas matching the filter.
+  virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
+                                            const XmppStanzaFilter& filter,
+                                            HandlerLevel level) = 0;
+
   //! Removes a listener for session events.
   virtual XmppReturnStatus RemoveStanzaHandler(XmppStanzaHandler* handler) = 0;
 
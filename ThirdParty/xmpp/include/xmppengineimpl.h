@@ -37,6 +37,7 @@ namespace buzz {
 
 class XmppLoginTask;
 class XmppEngine;
+class XmppStanzaDispatcher;
 class XmppIqEntry;
 class SaslHandler;
 class SaslMechanism;
@@ -146,6 +147,11 @@ class XmppEngineImpl : public XmppEngine {
   virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
                                             XmppEngine::HandlerLevel level);
 
+  //! Adds a listener that is only offered stanzas matching the filter.
+  virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
+                                            const XmppStanzaFilter& filter,
+                                            XmppEngine::HandlerLevel level);
+
   //! Removes a listener for session events.
   virtual XmppReturnStatus RemoveStanzaHandler(XmppStanzaHandler* handler);
 
@@ -268,15 +274,14 @@ class XmppEngineImpl : public XmppEngine {
 
   XmlnsStack xmlns_stack_;
 
-  typedef std::vector<XmppStanzaHandler*> StanzaHandlerVector;
-  talk_base::scoped_ptr<StanzaHandlerVector> stanza_handlers_[HL_COUNT];
+  talk_base::scoped_ptr<XmppStanzaDispatcher> stanza_handlers_[HL_COUNT];
 
   typedef std::vector<XmppIqEntry*> IqEntryVector;
   talk_base::scoped_ptr<IqEntryVector> iq_entries_;
 
   talk_base::scoped_ptr<SaslHandler> sasl_handler_;
 
-  talk_base::scoped_ptr<std::stringstream> output_;
+  talk_base::scoped_ptr<XmlOutputBuffer> output_;
 };
 
 }  // namespace buzz
@@ -58,6 +58,7 @@ public:
   virtual bool Connect(const talk_base::SocketAddress& addr);
   virtual bool Read(char * data, size_t len, size_t* len_read);
   virtual bool Write(const char * data, size_t len);
+  virtual bool WriteChunks(const XmlOutputBuffer& data);
   virtual bool Close();
   virtual bool StartTls(const std::string & domainname);
 
@@ -65,6 +66,9 @@ public:
 
 private:
   void CreateCricketSocket(int family);
+  // Sends as much of |data| as the socket takes without blocking, and
+  // returns the number of bytes sent.
+  size_t SendNow(const char* data, size_t len);
 #ifndef USE_SSLSTREAM
   void OnReadEvent(talk_base::AsyncSocket * socket);
   void OnWriteEvent(talk_base::AsyncSocket * socket);
@@ -0,0 +1,94 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef TALK_XMPP_XMPPSTANZADISPATCHER_H_
+#define TALK_XMPP_XMPPSTANZADISPATCHER_H_
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "xmppengine.h"
+
+namespace buzz {
+
+// Holds the stanza handlers registered at one XmppEngine::HandlerLevel and
+// offers incoming stanzas to them.  Each handler is indexed by the most
+// selective field of its XmppStanzaFilter (id, then child namespace, then
+// stanza name), so dispatching a stanza only touches the handlers that
+// could match it instead of every registered handler.  Handlers are still
+// called in the order they were added.
+//
+// Handlers may add or remove handlers (including themselves) from within
+// HandleStanza; removed handlers are not called again.
+class XmppStanzaDispatcher {
+ public:
+  XmppStanzaDispatcher();
+  ~XmppStanzaDispatcher();
+
+  void AddHandler(XmppStanzaHandler* handler, const XmppStanzaFilter& filter);
+  // Returns false if the handler was not registered.
+  bool RemoveHandler(XmppStanzaHandler* handler);
+
+  // Offers |stanza| to every matching handler.  If |stop_when_handled| is
+  // true, stops at the first handler that returns true.  Returns true if any
+  // handler returned true.
+  bool Dispatch(const XmlElement* stanza, bool stop_when_handled);
+
+  size_t size() const { return handlers_.size(); }
+
+ private:
+  struct Entry;
+  typedef std::vector<Entry*> EntryList;
+  typedef std::unordered_map<std::string, EntryList> EntryIndex;
+  typedef std::vector<std::pair<QName, EntryList> > NameIndex;
+  typedef std::unordered_map<XmppStanzaHandler*, EntryList> HandlerMap;
+
+  static bool EntryBefore(const Entry* a, const Entry* b);
+  EntryList* BucketFor(const Entry* entry, bool create);
+  void Unlink(Entry* entry);
+  void PurgeRemoved();
+
+  EntryIndex by_id_;
+  EntryIndex by_child_ns_;
+  NameIndex by_name_;
+  EntryList unfiltered_;
+  HandlerMap handlers_;
+  EntryList removed_;
+  uint32 next_seq_;
+  int dispatch_depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmppStanzaDispatcher);
+};
+
+}  // namespace buzz
+
+#endif  // TALK_XMPP_XMPPSTANZADISPATCHER_H_
@@ -81,6 +81,12 @@ class XmppClientInterface {
                                            XmppStanzaError error_code,
                                            const std::string& message) = 0;
   virtual void AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level) = 0;
+  // Like AddXmppTask, but the task only needs to see stanzas matching
+  // |filter|.  Implementations that don't index handlers may ignore it.
+  virtual void AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level,
+                           const XmppStanzaFilter& filter) {
+    AddXmppTask(task, level);
+  }
   virtual void RemoveXmppTask(XmppTask* task) = 0;
   sigslot::signal0<> SignalDisconnected;
 
@@ -155,6 +161,11 @@ class XmppTask : public XmppTaskBase,
   virtual void QueueStanza(const XmlElement* stanza);
   const XmlElement* NextStanza();
 
+  // Narrows the stanzas the client offers to this task.  HandleStanza must
+  // still do its own matching; the filter only lets the client skip tasks
+  // that can't possibly want a stanza.
+  void SetStanzaFilter(const XmppStanzaFilter& filter);
+
   bool MatchStanzaFrom(const XmlElement* stanza, const Jid& match_jid);
 
   bool MatchResponseIq(const XmlElement* stanza, const Jid& to,
@@ -175,6 +186,7 @@ private:
   void StopImpl();
 
   bool stopped_;
+  XmppEngine::HandlerLevel level_;
   std::deque<XmlElement*> stanza_queue_;
   talk_base::scoped_ptr<XmlElement> next_stanza_;
   std::string id_;
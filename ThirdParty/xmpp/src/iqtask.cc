@@ -42,6 +42,7 @@ IqTask::IqTask(XmppTaskParentInterface* parent,
       to_(to),
       stanza_(MakeIq(verb, to_, task_id())) {
   stanza_->AddElement(el);
+  SetStanzaFilter(XmppStanzaFilter::IqResponse(task_id()));
   set_timeout_seconds(kDefaultIqTimeoutSecs);
 }
 
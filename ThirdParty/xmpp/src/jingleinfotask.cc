@@ -38,7 +38,9 @@ class JingleInfoTask::JingleInfoGetTask : public XmppTask {
  public:
   explicit JingleInfoGetTask(XmppTaskParentInterface* parent)
       : XmppTask(parent, XmppEngine::HL_SINGLE),
-        done_(false) {}
+        done_(false) {
+    SetStanzaFilter(XmppStanzaFilter::IqResponse(task_id()));
+  }
 
   virtual int ProcessStart() {
     talk_base::scoped_ptr<XmlElement> get(
@@ -20,6 +20,7 @@ PingTask::PingTask(buzz::XmppTaskParentInterface* parent,
       next_ping_time_(0),
       ping_response_deadline_(0) {
   ASSERT(ping_period_millis >= ping_timeout_millis);
+  SetStanzaFilter(buzz::XmppStanzaFilter::IqResponse(task_id()));
 }
 
 bool PingTask::HandleStanza(const buzz::XmlElement* stanza) {
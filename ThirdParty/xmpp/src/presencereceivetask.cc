@@ -39,6 +39,7 @@ static bool IsUtf8FirstByte(int c) {
 
 PresenceReceiveTask::PresenceReceiveTask(XmppTaskParentInterface* parent)
  : XmppTask(parent, XmppEngine::HL_TYPE) {
+  SetStanzaFilter(XmppStanzaFilter(QN_PRESENCE));
 }
 
 PresenceReceiveTask::~PresenceReceiveTask() {
@@ -91,6 +91,7 @@ public:
   // implementations of interfaces
   void OnStateChange(int state);
   void WriteOutput(const char* bytes, size_t len);
+  void WriteOutputChunks(const XmlOutputBuffer& output);
   void StartTls(const std::string& domainname);
   void CloseConnection();
 
@@ -410,6 +411,21 @@ void XmppClient::Private::WriteOutput(const char* bytes, size_t len) {
   // TODO: deal with error information
 }
 
+void XmppClient::Private::WriteOutputChunks(const XmlOutputBuffer& output) {
+  // Log the whole flush at once, like WriteOutput does, so that stanzas are
+  // never split across log lines. Only a multi-chunk flush needs a copy.
+  if (output.chunk_count() == 1) {
+    XmlOutputBuffer::Chunk chunk = output.chunk(0);
+    client_->SignalLogOutput(chunk.data, static_cast<int>(chunk.length));
+  } else if (output.chunk_count() > 1 && !client_->SignalLogOutput.is_empty()) {
+    std::string bytes = output.Str();
+    client_->SignalLogOutput(bytes.data(), static_cast<int>(bytes.length()));
+  }
+
+  socket_->WriteChunks(output);
+  // TODO: deal with error information
+}
+
 void XmppClient::Private::StartTls(const std::string& domain) {
 #if defined(FEATURE_ENABLE_SSL)
   socket_->StartTls(domain);
@@ -424,6 +440,11 @@ void XmppClient::AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level) {
   d_->engine_->AddStanzaHandler(task, level);
 }
 
+void XmppClient::AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level,
+                             const XmppStanzaFilter& filter) {
+  d_->engine_->AddStanzaHandler(task, filter, level);
+}
+
 void XmppClient::RemoveXmppTask(XmppTask* task) {
   d_->engine_->RemoveStanzaHandler(task);
 }
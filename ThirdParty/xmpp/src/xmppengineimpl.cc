@@ -37,6 +37,7 @@
 #include "constants.h"
 #include "saslhandler.h"
 #include "xmpplogintask.h"
+#include "xmppstanzadispatcher.h"
 
 namespace buzz {
 
@@ -64,9 +65,9 @@ XmppEngineImpl::XmppEngineImpl()
       session_handler_(NULL),
       iq_entries_(new IqEntryVector()),
       sasl_handler_(NULL),
-      output_(new std::stringstream()) {
+      output_(new XmlOutputBuffer()) {
   for (int i = 0; i < HL_COUNT; i+= 1) {
-    stanza_handlers_[i].reset(new StanzaHandlerVector());
+    stanza_handlers_[i].reset(new XmppStanzaDispatcher());
   }
 
   // Add XMPP namespaces to XML namespaces stack.
@@ -186,10 +187,17 @@ const std::string& XmppEngineImpl::GetRequestedResource() {
 XmppReturnStatus XmppEngineImpl::AddStanzaHandler(
     XmppStanzaHandler* stanza_handler,
     XmppEngine::HandlerLevel level) {
+  return AddStanzaHandler(stanza_handler, XmppStanzaFilter(), level);
+}
+
+XmppReturnStatus XmppEngineImpl::AddStanzaHandler(
+    XmppStanzaHandler* stanza_handler,
+    const XmppStanzaFilter& filter,
+    XmppEngine::HandlerLevel level) {
   if (state_ == STATE_CLOSED)
     return XMPP_RETURN_BADSTATE;
 
-  stanza_handlers_[level]->push_back(stanza_handler);
+  stanza_handlers_[level]->AddHandler(stanza_handler, filter);
 
   return XMPP_RETURN_OK;
 }
@@ -199,15 +207,8 @@ XmppReturnStatus XmppEngineImpl::RemoveStanzaHandler(
   bool found = false;
 
   for (int level = 0; level < HL_COUNT; level += 1) {
-    StanzaHandlerVector::iterator new_end =
-      std::remove(stanza_handlers_[level]->begin(),
-      stanza_handlers_[level]->end(),
-      stanza_handler);
-
-    if (new_end != stanza_handlers_[level]->end()) {
-      stanza_handlers_[level]->erase(new_end, stanza_handlers_[level]->end());
+    if (stanza_handlers_[level]->RemoveHandler(stanza_handler))
       found = true;
-    }
   }
 
   if (!found)
@@ -256,7 +257,7 @@ XmppReturnStatus XmppEngineImpl::SendRaw(const std::string& text) {
 
   EnterExit ee(this);
 
-  (*output_) << text;
+  output_->Append(text);
 
   return XMPP_RETURN_OK;
 }
@@ -271,7 +272,7 @@ XmppReturnStatus XmppEngineImpl::Disconnect() {
   if (state_ != STATE_CLOSED) {
     EnterExit ee(this);
     if (state_ == STATE_OPEN)
-      *output_ << "</stream:stream>";
+      output_->Append("</stream:stream>");
     state_ = STATE_CLOSED;
   }
 
@@ -309,17 +310,13 @@ void XmppEngineImpl::IncomingStanza(const XmlElement* stanza) {
   } else if (HandleIqResponse(stanza)) {
     // iq is handled by above call
   } else {
-    // give every "peek" handler a shot at all stanzas
-    for (size_t i = 0; i < stanza_handlers_[HL_PEEK]->size(); i += 1) {
-      (*stanza_handlers_[HL_PEEK])[i]->HandleStanza(stanza);
-    }
+    // give every matching "peek" handler a shot at all stanzas
+    stanza_handlers_[HL_PEEK]->Dispatch(stanza, false);
 
     // give other handlers a shot in precedence order, stopping after handled
     for (int level = HL_SINGLE; level <= HL_ALL; level += 1) {
-      for (size_t i = 0; i < stanza_handlers_[level]->size(); i += 1) {
-        if ((*stanza_handlers_[level])[i]->HandleStanza(stanza))
-          return;
-      }
+      if (stanza_handlers_[level]->Dispatch(stanza, true))
+        return;
     }
 
     // If nobody wants to handle a stanza then send back an error.
@@ -353,11 +350,13 @@ void XmppEngineImpl::InternalSendStart(const std::string& to) {
   // send stream-beginning
   // note, we put a \r\n at tne end fo the first line to cause non-XMPP
   // line-oriented servers (e.g., Apache) to reveal themselves more quickly.
-  *output_ << "<stream:stream to=\"" << hostname << "\" "
-           << "xml:lang=\"" << lang << "\" "
-           << "version=\"1.0\" "
-           << "xmlns:stream=\"http://etherx.jabber.org/streams\" "
-           << "xmlns=\"jabber:client\">\r\n";
+  output_->Append("<stream:stream to=\"");
+  output_->Append(hostname);
+  output_->Append("\" xml:lang=\"");
+  output_->Append(lang);
+  output_->Append("\" version=\"1.0\" "
+                  "xmlns:stream=\"http://etherx.jabber.org/streams\" "
+                  "xmlns=\"jabber:client\">\r\n");
 }
 
 void XmppEngineImpl::InternalSendStanza(const XmlElement* element) {
@@ -433,10 +432,9 @@ XmppEngineImpl::EnterExit::~EnterExit()  {
  bool flushing = closing || (engine->engine_entered_ == 0);
 
  if (engine->output_handler_ && flushing) {
-   std::string output = engine->output_->str();
-   if (output.length() > 0)
-     engine->output_handler_->WriteOutput(output.c_str(), output.length());
-   engine->output_->str("");
+   if (!engine->output_->empty())
+     engine->output_handler_->WriteOutputChunks(*engine->output_);
+   engine->output_->Clear();
 
    if (closing) {
      engine->output_handler_->CloseConnection();
@@ -218,6 +218,57 @@ bool XmppSocket::Write(const char * data, size_t len) {
   return true;
 }
 
+bool XmppSocket::WriteChunks(const XmlOutputBuffer& data) {
+  // While nothing is queued, send straight from the chunks and only copy
+  // whatever the socket doesn't take right away.
+  size_t index = 0;
+  size_t offset = 0;
+  if (buffer_.Length() == 0) {
+    for (; index < data.chunk_count(); ++index) {
+      XmlOutputBuffer::Chunk chunk = data.chunk(index);
+      size_t written = SendNow(chunk.data, chunk.length);
+      if (written < chunk.length) {
+        offset = written;
+        break;
+      }
+    }
+  }
+  for (; index < data.chunk_count(); ++index) {
+    XmlOutputBuffer::Chunk chunk = data.chunk(index);
+    buffer_.WriteBytes(chunk.data + offset, chunk.length - offset);
+    offset = 0;
+  }
+  return true;
+}
+
+size_t XmppSocket::SendNow(const char* data, size_t len) {
+  size_t sent = 0;
+  while (sent < len) {
+#ifndef USE_SSLSTREAM
+    int written = cricket_socket_->Send(data + sent, len - sent);
+    if (written <= 0) {
+      if (!cricket_socket_->IsBlocking())
+        LOG(LS_ERROR) << "Send error: " << cricket_socket_->GetError();
+      break;
+    }
+    sent += written;
+#else  // USE_SSLSTREAM
+    size_t written;
+    int error;
+    talk_base::StreamResult result =
+        stream_->Write(data + sent, len - sent, &written, &error);
+    if (result == talk_base::SR_ERROR) {
+      LOG(LS_ERROR) << "Send error: " << error;
+      break;
+    }
+    if (result != talk_base::SR_SUCCESS || written == 0)
+      break;
+    sent += written;
+#endif  // USE_SSLSTREAM
+  }
+  return sent;
+}
+
 bool XmppSocket::Close() {
   if (state_ != buzz::AsyncSocket::STATE_OPEN)
     return false;
@@ -0,0 +1,257 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "xmppstanzadispatcher.h"
+
+#include <algorithm>
+
+#include "base/common.h"
+#include "constants.h"
+#include "xmlelement.h"
+
+namespace buzz {
+
+namespace {
+
+// Like XmlElement::Attr, but without copying the value.
+const std::string* FindAttr(const XmlElement* stanza, const StaticQName& name) {
+  for (const XmlAttr* attr = stanza->FirstAttr(); attr != NULL;
+       attr = attr->NextAttr()) {
+    if (attr->Name() == name)
+      return &attr->Value();
+  }
+  return NULL;
+}
+
+bool AttrEquals(const XmlElement* stanza, const StaticQName& name,
+                const std::string& value) {
+  const std::string* attr = FindAttr(stanza, name);
+  return attr != NULL ? *attr == value : value.empty();
+}
+
+}  // namespace
+
+XmppStanzaFilter XmppStanzaFilter::IqResponse(const std::string& id) {
+  XmppStanzaFilter filter(QN_IQ);
+  filter.set_id(id);
+  return filter;
+}
+
+bool XmppStanzaFilter::IsEmpty() const {
+  return name_.IsEmpty() && type_.empty() && id_.empty() && child_ns_.empty();
+}
+
+bool XmppStanzaFilter::Matches(const XmlElement* stanza) const {
+  if (!name_.IsEmpty() && stanza->Name() != name_)
+    return false;
+  if (!type_.empty() && !AttrEquals(stanza, QN_TYPE, type_))
+    return false;
+  if (!id_.empty() && !AttrEquals(stanza, QN_ID, id_))
+    return false;
+  if (!child_ns_.empty() && stanza->FirstWithNamespace(child_ns_) == NULL)
+    return false;
+  return true;
+}
+
+struct XmppStanzaDispatcher::Entry {
+  Entry(XmppStanzaHandler* handler, const XmppStanzaFilter& filter, uint32 seq)
+      : handler(handler), filter(filter), seq(seq), removed(false) {}
+
+  XmppStanzaHandler* handler;
+  XmppStanzaFilter filter;
+  uint32 seq;
+  bool removed;
+};
+
+bool XmppStanzaDispatcher::EntryBefore(const Entry* a, const Entry* b) {
+  return a->seq < b->seq;
+}
+
+XmppStanzaDispatcher::XmppStanzaDispatcher()
+    : next_seq_(0),
+      dispatch_depth_(0) {
+}
+
+XmppStanzaDispatcher::~XmppStanzaDispatcher() {
+  ASSERT(dispatch_depth_ == 0);
+  for (HandlerMap::iterator it = handlers_.begin(); it != handlers_.end();
+       ++it) {
+    for (size_t i = 0; i < it->second.size(); ++i)
+      delete it->second[i];
+  }
+  for (size_t i = 0; i < removed_.size(); ++i)
+    delete removed_[i];
+}
+
+void XmppStanzaDispatcher::AddHandler(XmppStanzaHandler* handler,
+                                      const XmppStanzaFilter& filter) {
+  Entry* entry = new Entry(handler, filter, next_seq_++);
+  BucketFor(entry, true)->push_back(entry);
+  handlers_[handler].push_back(entry);
+}
+
+bool XmppStanzaDispatcher::RemoveHandler(XmppStanzaHandler* handler) {
+  HandlerMap::iterator it = handlers_.find(handler);
+  if (it == handlers_.end())
+    return false;
+
+  for (size_t i = 0; i < it->second.size(); ++i) {
+    Entry* entry = it->second[i];
+    entry->removed = true;
+    if (dispatch_depth_ > 0) {
+      // A dispatch further up the stack may still hold a pointer to the
+      // entry; free it once the outermost dispatch finishes.
+      removed_.push_back(entry);
+    } else {
+      Unlink(entry);
+    }
+  }
+  handlers_.erase(it);
+  return true;
+}
+
+bool XmppStanzaDispatcher::Dispatch(const XmlElement* stanza,
+                                    bool stop_when_handled) {
+  if (handlers_.empty())
+    return false;
+
+  // Collect every handler whose most selective key matches the stanza.
+  EntryList candidates;
+  size_t sources = 0;
+  if (!by_id_.empty()) {
+    const std::string* id = FindAttr(stanza, QN_ID);
+    if (id != NULL) {
+      EntryIndex::const_iterator it = by_id_.find(*id);
+      if (it != by_id_.end()) {
+        candidates.insert(candidates.end(), it->second.begin(),
+                          it->second.end());
+        ++sources;
+      }
+    }
+  }
+  if (!by_child_ns_.empty()) {
+    for (const XmlElement* child = stanza->FirstElement(); child != NULL;
+         child = child->NextElement()) {
+      EntryIndex::const_iterator it =
+          by_child_ns_.find(child->Name().Namespace());
+      if (it != by_child_ns_.end()) {
+        candidates.insert(candidates.end(), it->second.begin(),
+                          it->second.end());
+        ++sources;
+      }
+    }
+  }
+  for (NameIndex::const_iterator it = by_name_.begin(); it != by_name_.end();
+       ++it) {
+    if (it->first == stanza->Name()) {
+      candidates.insert(candidates.end(), it->second.begin(),
+                        it->second.end());
+      ++sources;
+      break;
+    }
+  }
+  if (!unfiltered_.empty()) {
+    candidates.insert(candidates.end(), unfiltered_.begin(), unfiltered_.end());
+    ++sources;
+  }
+
+  // Every bucket is already in registration order; only merge when the
+  // candidates came from more than one of them.
+  if (sources > 1) {
+    std::sort(candidates.begin(), candidates.end(), EntryBefore);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+  }
+
+  bool handled = false;
+  ++dispatch_depth_;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    Entry* entry = candidates[i];
+    if (entry->removed || !entry->filter.Matches(stanza))
+      continue;
+    if (entry->handler->HandleStanza(stanza)) {
+      handled = true;
+      if (stop_when_handled)
+        break;
+    }
+  }
+  if (--dispatch_depth_ == 0 && !removed_.empty())
+    PurgeRemoved();
+
+  return handled;
+}
+
+XmppStanzaDispatcher::EntryList* XmppStanzaDispatcher::BucketFor(
+    const Entry* entry, bool create) {
+  const XmppStanzaFilter& filter = entry->filter;
+  if (!filter.id().empty()) {
+    if (create)
+      return &by_id_[filter.id()];
+    EntryIndex::iterator it = by_id_.find(filter.id());
+    return it != by_id_.end() ? &it->second : NULL;
+  }
+  if (!filter.child_ns().empty()) {
+    if (create)
+      return &by_child_ns_[filter.child_ns()];
+    EntryIndex::iterator it = by_child_ns_.find(filter.child_ns());
+    return it != by_child_ns_.end() ? &it->second : NULL;
+  }
+  if (!filter.name().IsEmpty()) {
+    for (NameIndex::iterator it = by_name_.begin(); it != by_name_.end();
+         ++it) {
+      if (it->first == filter.name())
+        return &it->second;
+    }
+    if (!create)
+      return NULL;
+    by_name_.push_back(std::make_pair(filter.name(), EntryList()));
+    return &by_name_.back().second;
+  }
+  return &unfiltered_;
+}
+
+void XmppStanzaDispatcher::Unlink(Entry* entry) {
+  EntryList* bucket = BucketFor(entry, false);
+  ASSERT(bucket != NULL);
+  if (bucket != NULL) {
+    bucket->erase(std::find(bucket->begin(), bucket->end(), entry));
+    // Ids are usually unique per request; don't let their buckets pile up.
+    if (bucket->empty() && !entry->filter.id().empty())
+      by_id_.erase(entry->filter.id());
+  }
+  delete entry;
+}
+
+void XmppStanzaDispatcher::PurgeRemoved() {
+  EntryList removed;
+  removed.swap(removed_);
+  for (size_t i = 0; i < removed.size(); ++i)
+    Unlink(removed[i]);
+}
+
+}  // namespace buzz
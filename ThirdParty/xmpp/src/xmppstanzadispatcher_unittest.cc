@@ -0,0 +1,193 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <string>
+#include <vector>
+
+#include "base/gunit.h"
+#include "base/scoped_ptr.h"
+#include "constants.h"
+#include "xmlelement.h"
+#include "xmppstanzadispatcher.h"
+
+using buzz::QName;
+using buzz::XmlElement;
+using buzz::XmppStanzaDispatcher;
+using buzz::XmppStanzaFilter;
+using buzz::XmppStanzaHandler;
+
+// Records the stanzas it sees and optionally claims them.
+class RecordingHandler : public XmppStanzaHandler {
+ public:
+  RecordingHandler(const std::string& name, std::string* log, bool claim)
+      : name_(name), log_(log), claim_(claim), dispatcher_(NULL),
+        remove_(NULL) {}
+
+  // When set, removes |handler| from |dispatcher| on the next stanza.
+  void RemoveOnStanza(XmppStanzaDispatcher* dispatcher,
+                      XmppStanzaHandler* handler) {
+    dispatcher_ = dispatcher;
+    remove_ = handler;
+  }
+
+  virtual bool HandleStanza(const XmlElement* stanza) {
+    *log_ += "[" + name_ + "]";
+    if (remove_ != NULL) {
+      dispatcher_->RemoveHandler(remove_);
+      remove_ = NULL;
+    }
+    return claim_;
+  }
+
+ private:
+  std::string name_;
+  std::string* log_;
+  bool claim_;
+  XmppStanzaDispatcher* dispatcher_;
+  XmppStanzaHandler* remove_;
+};
+
+static XmlElement* MakeIq(const std::string& type, const std::string& id) {
+  XmlElement* iq = new XmlElement(buzz::QN_IQ);
+  iq->AddAttr(buzz::QN_TYPE, type);
+  iq->AddAttr(buzz::QN_ID, id);
+  return iq;
+}
+
+TEST(XmppStanzaFilterTest, TestMatches) {
+  talk_base::scoped_ptr<XmlElement> iq(MakeIq("result", "7"));
+  iq->AddElement(new XmlElement(QName("urn:test", "query")));
+
+  EXPECT_TRUE(XmppStanzaFilter().IsEmpty());
+  EXPECT_TRUE(XmppStanzaFilter().Matches(iq.get()));
+  EXPECT_TRUE(XmppStanzaFilter::IqResponse("7").Matches(iq.get()));
+  EXPECT_FALSE(XmppStanzaFilter::IqResponse("8").Matches(iq.get()));
+  EXPECT_FALSE(XmppStanzaFilter(buzz::QN_PRESENCE).Matches(iq.get()));
+
+  XmppStanzaFilter filter(buzz::QN_IQ);
+  filter.set_type("result");
+  filter.set_child_ns("urn:test");
+  EXPECT_FALSE(filter.IsEmpty());
+  EXPECT_TRUE(filter.Matches(iq.get()));
+  filter.set_child_ns("urn:other");
+  EXPECT_FALSE(filter.Matches(iq.get()));
+  filter.set_child_ns("");
+  filter.set_type("set");
+  EXPECT_FALSE(filter.Matches(iq.get()));
+}
+
+TEST(XmppStanzaDispatcherTest, TestOnlyMatchingHandlersCalled) {
+  std::string log;
+  RecordingHandler any("any", &log, false);
+  RecordingHandler iq1("iq1", &log, false);
+  RecordingHandler iq2("iq2", &log, false);
+  RecordingHandler presence("presence", &log, false);
+  RecordingHandler query("query", &log, false);
+
+  XmppStanzaDispatcher dispatcher;
+  dispatcher.AddHandler(&iq1, XmppStanzaFilter::IqResponse("1"));
+  dispatcher.AddHandler(&any, XmppStanzaFilter());
+  dispatcher.AddHandler(&presence, XmppStanzaFilter(buzz::QN_PRESENCE));
+  XmppStanzaFilter query_filter;
+  query_filter.set_child_ns("urn:test");
+  dispatcher.AddHandler(&query, query_filter);
+  dispatcher.AddHandler(&iq2, XmppStanzaFilter::IqResponse("2"));
+  EXPECT_EQ(5U, dispatcher.size());
+
+  talk_base::scoped_ptr<XmlElement> stanza(MakeIq("result", "2"));
+  EXPECT_FALSE(dispatcher.Dispatch(stanza.get(), false));
+  EXPECT_EQ("[any][iq2]", log);
+
+  // Handlers from several buckets are still called in registration order.
+  log.clear();
+  stanza.reset(MakeIq("result", "1"));
+  stanza->AddElement(new XmlElement(QName("urn:test", "a")));
+  stanza->AddElement(new XmlElement(QName("urn:test", "b")));
+  EXPECT_FALSE(dispatcher.Dispatch(stanza.get(), false));
+  EXPECT_EQ("[iq1][any][query]", log);
+
+  log.clear();
+  stanza.reset(new XmlElement(buzz::QN_PRESENCE));
+  EXPECT_FALSE(dispatcher.Dispatch(stanza.get(), false));
+  EXPECT_EQ("[any][presence]", log);
+
+  // Once removed, the id bucket is dropped and the handler isn't called.
+  EXPECT_TRUE(dispatcher.RemoveHandler(&iq2));
+  EXPECT_FALSE(dispatcher.RemoveHandler(&iq2));
+  log.clear();
+  stanza.reset(MakeIq("result", "2"));
+  dispatcher.Dispatch(stanza.get(), false);
+  EXPECT_EQ("[any]", log);
+  EXPECT_EQ(4U, dispatcher.size());
+}
+
+TEST(XmppStanzaDispatcherTest, TestStopWhenHandled) {
+  std::string log;
+  RecordingHandler first("first", &log, true);
+  RecordingHandler second("second", &log, true);
+
+  XmppStanzaDispatcher dispatcher;
+  dispatcher.AddHandler(&first, XmppStanzaFilter::IqResponse("1"));
+  dispatcher.AddHandler(&second, XmppStanzaFilter());
+
+  talk_base::scoped_ptr<XmlElement> stanza(MakeIq("result", "1"));
+  EXPECT_TRUE(dispatcher.Dispatch(stanza.get(), true));
+  EXPECT_EQ("[first]", log);
+
+  log.clear();
+  EXPECT_TRUE(dispatcher.Dispatch(stanza.get(), false));
+  EXPECT_EQ("[first][second]", log);
+}
+
+TEST(XmppStanzaDispatcherTest, TestRemoveDuringDispatch) {
+  std::string log;
+  RecordingHandler first("first", &log, false);
+  RecordingHandler second("second", &log, false);
+  RecordingHandler third("third", &log, false);
+
+  XmppStanzaDispatcher dispatcher;
+  dispatcher.AddHandler(&first, XmppStanzaFilter());
+  dispatcher.AddHandler(&second, XmppStanzaFilter::IqResponse("1"));
+  dispatcher.AddHandler(&third, XmppStanzaFilter());
+
+  // |first| removes |second| and itself; neither is called afterwards.
+  first.RemoveOnStanza(&dispatcher, &second);
+  talk_base::scoped_ptr<XmlElement> stanza(MakeIq("result", "1"));
+  dispatcher.Dispatch(stanza.get(), false);
+  EXPECT_EQ("[first][third]", log);
+  EXPECT_EQ(2U, dispatcher.size());
+
+  first.RemoveOnStanza(&dispatcher, &first);
+  log.clear();
+  dispatcher.Dispatch(stanza.get(), false);
+  EXPECT_EQ("[first][third]", log);
+  log.clear();
+  dispatcher.Dispatch(stanza.get(), false);
+  EXPECT_EQ("[third]", log);
+  EXPECT_EQ(1U, dispatcher.size());
+}
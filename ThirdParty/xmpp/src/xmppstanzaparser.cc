@@ -44,6 +44,9 @@ XmppStanzaParser::XmppStanzaParser(XmppStanzaParseHandler *psph) :
   parser_(&innerHandler_),
   depth_(0),
   builder_() {
+  // Stanzas are only lent to the handlers, which copy anything they keep,
+  // so each one can be built in an arena and released in one shot.
+  builder_.set_use_arena(true);
 }
 
 void
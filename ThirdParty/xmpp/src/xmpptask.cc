@@ -40,7 +40,7 @@ XmppClientInterface::~XmppClientInterface() {
 
 XmppTask::XmppTask(XmppTaskParentInterface* parent,
                    XmppEngine::HandlerLevel level)
-    : XmppTaskBase(parent), stopped_(false) {
+    : XmppTaskBase(parent), stopped_(false), level_(level) {
 #ifdef _DEBUG
   debug_force_timeout_ = false;
 #endif
@@ -96,6 +96,13 @@ void XmppTask::QueueStanza(const XmlElement* stanza) {
   Wake();
 }
 
+void XmppTask::SetStanzaFilter(const XmppStanzaFilter& filter) {
+  if (stopped_ || level_ == XmppEngine::HL_NONE)
+    return;
+  GetClient()->RemoveXmppTask(this);
+  GetClient()->AddXmppTask(this, level_, filter);
+}
+
 const XmlElement* XmppTask::NextStanza() {
   XmlElement* result = NULL;
   if (!stanza_queue_.empty()) {
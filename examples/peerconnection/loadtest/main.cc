@@ -0,0 +1,490 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Load test for the peerconnection signaling server. Signs in a number of
+// peers, keeps a long-poll outstanding for each, and has them send small
+// messages to random other peers. Every message carries the time it was
+// sent, so the latency reported covers the POST, the relay through the
+// server and the answer to the recipient's long-poll.
+//
+// Every long-poll answer costs a new connection, and while sign ins are
+// announced there are peers * (peers - 1) / 2 of them. From a single client
+// address that exhausts the ephemeral port range long before the server
+// runs out of anything, so to load the server with many thousands of peers
+// run several of these from different machines.
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef POSIX
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/asyncsocket.h"
+#include "base/flags.h"
+#include "base/helpers.h"
+#include "base/messagehandler.h"
+#include "base/physicalsocketserver.h"
+#include "base/scoped_ptr.h"
+#include "base/sigslot.h"
+#include "base/socketaddress.h"
+#include "base/stringutils.h"
+#include "base/thread.h"
+#include "base/timeutils.h"
+
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_string(server, "127.0.0.1", "The server to connect to.");
+DEFINE_int(port, 8888, "The port the server listens on.");
+DEFINE_int(peers, 300, "Number of peers to sign in.");
+DEFINE_int(sign_in_rate, 1000, "Peers signed in per second.");
+DEFINE_int(interval, 1000, "Milliseconds between messages from each peer.");
+DEFINE_int(duration, 10000,
+           "How long to send messages once everyone is in, in milliseconds.");
+
+// How often sign ins and messages are started.
+static const int kTickMs = 10;
+// How long answers are waited for after the last message is sent.
+static const int kDrainMs = 2000;
+// How long sign in notifications may take to reach everyone before messages
+// are sent regardless.
+static const int kMaxSettleMs = 60000;
+
+static const char kPeerIdHeader[] = "\r\nPragma: ";
+
+enum {
+  MSG_TICK,
+  MSG_STOP,
+};
+
+// One request on a connection of its own; the server closes every
+// connection once it has answered.
+class HttpExchange : public sigslot::has_slots<> {
+ public:
+  explicit HttpExchange(const std::string& request)
+      : request_(request), sent_(0), status_(0), peer_id_(0) {
+  }
+
+  bool Start(const talk_base::SocketAddress& server) {
+    talk_base::SocketServer* ss = talk_base::Thread::Current()->socketserver();
+    socket_.reset(ss->CreateAsyncSocket(server.family(), SOCK_STREAM));
+    if (!socket_)
+      return false;
+    socket_->SignalConnectEvent.connect(this, &HttpExchange::OnWriteEvent);
+    socket_->SignalWriteEvent.connect(this, &HttpExchange::OnWriteEvent);
+    socket_->SignalReadEvent.connect(this, &HttpExchange::OnReadEvent);
+    socket_->SignalCloseEvent.connect(this, &HttpExchange::OnCloseEvent);
+    return socket_->Connect(server) == 0 || socket_->IsBlocking();
+  }
+
+  int status() const { return status_; }
+  // The peer id the server put in the Pragma header, or 0.
+  int peer_id() const { return peer_id_; }
+  const std::string& body() const { return body_; }
+
+  // Signalled once, with whether a response was received. Dispose of the
+  // exchange from here.
+  sigslot::signal2<HttpExchange*, bool> SignalDone;
+
+ private:
+  void OnWriteEvent(talk_base::AsyncSocket* socket) {
+    while (sent_ < request_.length()) {
+      int sent = socket_->Send(request_.data() + sent_,
+                               request_.length() - sent_);
+      if (sent < 0) {
+        if (!socket_->IsBlocking())
+          Finish();
+        return;
+      }
+      sent_ += sent;
+    }
+  }
+
+  void OnReadEvent(talk_base::AsyncSocket* socket) {
+    char buffer[4096];
+    int read = socket_->Recv(buffer, sizeof(buffer));
+    if (read > 0)
+      response_.append(buffer, read);
+  }
+
+  void OnCloseEvent(talk_base::AsyncSocket* socket, int err) {
+    // The response may still be waiting to be read.
+    OnReadEvent(socket);
+    Finish();
+  }
+
+  void Finish() {
+    socket_->Close();
+    talk_base::Thread::Current()->Dispose(socket_.release());
+    SignalDone(this, Parse());
+  }
+
+  bool Parse() {
+    size_t end_of_headers = response_.find("\r\n\r\n");
+    if (end_of_headers == std::string::npos ||
+        response_.compare(0, 9, "HTTP/1.1 ") != 0)
+      return false;
+    status_ = atoi(response_.c_str() + 9);
+    size_t header = response_.find(kPeerIdHeader);
+    if (header != std::string::npos && header < end_of_headers)
+      peer_id_ = atoi(response_.c_str() + header + sizeof(kPeerIdHeader) - 1);
+    body_ = response_.substr(end_of_headers + 4);
+    return true;
+  }
+
+  talk_base::scoped_ptr<talk_base::AsyncSocket> socket_;
+  std::string request_;
+  size_t sent_;
+  std::string response_;
+  int status_;
+  int peer_id_;
+  std::string body_;
+};
+
+class LoadTest;
+
+// A simulated peer: signs in, then keeps a long-poll open and counts what
+// arrives on it.
+class LoadPeer : public sigslot::has_slots<> {
+ public:
+  LoadPeer(LoadTest* test, int index) : test_(test), index_(index), id_(0) {}
+
+  int id() const { return id_; }
+
+  void SignIn();
+  void SendMessage(int to);
+
+ private:
+  bool Start(const std::string& request,
+             void (LoadPeer::*done)(HttpExchange*, bool));
+  void Wait();
+  void OnSignedIn(HttpExchange* exchange, bool ok);
+  void OnWaitDone(HttpExchange* exchange, bool ok);
+  void OnMessageSent(HttpExchange* exchange, bool ok);
+
+  LoadTest* test_;
+  int index_;
+  int id_;
+  uint64 sign_in_start_ns_;
+};
+
+// Drives the peers and collects what they see.
+class LoadTest : public talk_base::MessageHandler {
+ public:
+  LoadTest(const talk_base::SocketAddress& server, int num_peers)
+      : server_(server), phase_(SIGNING_IN), stopping_(false),
+        next_peer_(0), messages_due_(0.0), sign_ins_(0), sign_in_failures_(0),
+        messages_sent_(0), message_failures_(0), messages_received_(0),
+        notifications_(0), wait_failures_(0) {
+    for (int i = 0; i < num_peers; ++i)
+      peers_.push_back(new LoadPeer(this, i));
+  }
+
+  ~LoadTest() {
+    for (size_t i = 0; i < peers_.size(); ++i)
+      delete peers_[i];
+  }
+
+  const talk_base::SocketAddress& server() const { return server_; }
+  bool stopping() const { return stopping_; }
+
+  void Run() {
+    start_ns_ = talk_base::TimeNanos();
+    talk_base::Thread::Current()->Post(this, MSG_TICK);
+    talk_base::Thread::Current()->Run();
+  }
+
+  void Report() {
+    printf("signed in %d of %d peers in %d ms, %d failed\n", sign_ins_,
+           static_cast<int>(peers_.size()), sign_in_ms_, sign_in_failures_);
+    printf("sign in latency ms: %s\n", Percentiles(&sign_in_us_, 1000).c_str());
+    printf("messages sent %d, failed %d, received %d\n", messages_sent_,
+           message_failures_, messages_received_);
+    printf("notifications %d, failed long-polls %d\n", notifications_,
+           wait_failures_);
+    printf("message latency us: %s\n", Percentiles(&latency_us_, 1).c_str());
+  }
+
+  // Called by the peers.
+  void OnSignedIn(LoadPeer* peer, uint64 elapsed_ns) {
+    ++sign_ins_;
+    signed_in_.push_back(peer);
+    sign_in_us_.push_back(static_cast<uint32>(elapsed_ns / 1000));
+  }
+  void OnSignInFailed() { ++sign_in_failures_; }
+  void OnMessageSent(bool ok) { ok ? ++messages_sent_ : ++message_failures_; }
+  void OnMessageReceived(uint64 sent_us) {
+    ++messages_received_;
+    uint64 now_us = talk_base::TimeNanos() / 1000;
+    latency_us_.push_back(static_cast<uint32>(now_us - sent_us));
+  }
+  void OnNotification() { ++notifications_; }
+  void OnWaitFailed() { ++wait_failures_; }
+
+ private:
+  enum Phase {
+    SIGNING_IN,
+    SETTLING,
+    SENDING,
+    DRAINING,
+  };
+
+  virtual void OnMessage(talk_base::Message* msg) {
+    talk_base::Thread* thread = talk_base::Thread::Current();
+    if (msg->message_id == MSG_STOP) {
+      if (phase_ == SENDING) {
+        // Give the last messages a chance to arrive.
+        phase_ = DRAINING;
+        thread->PostDelayed(kDrainMs, this, MSG_STOP);
+      } else {
+        stopping_ = true;
+        thread->Quit();
+      }
+      return;
+    }
+
+    if (phase_ == SIGNING_IN) {
+      SignInSome();
+    } else if (phase_ == SETTLING) {
+      Settle();
+    } else if (phase_ == SENDING) {
+      SendSome();
+    }
+    thread->PostDelayed(kTickMs, this, MSG_TICK);
+  }
+
+  void SignInSome() {
+    int batch = std::max(1, FLAG_sign_in_rate * kTickMs / 1000);
+    for (int i = 0; i < batch && next_peer_ < peers_.size(); ++i)
+      peers_[next_peer_++]->SignIn();
+    if (next_peer_ == peers_.size() &&
+        sign_ins_ + sign_in_failures_ == static_cast<int>(peers_.size())) {
+      uint64 now_ns = talk_base::TimeNanos();
+      sign_in_ms_ = static_cast<int>(
+          (now_ns - start_ns_) / talk_base::kNumNanosecsPerMillisec);
+      if (signed_in_.size() < 2) {
+        printf("Not enough peers signed in to send messages\n");
+        phase_ = DRAINING;
+        talk_base::Thread::Current()->Post(this, MSG_STOP);
+        return;
+      }
+      phase_ = SETTLING;
+      settle_start_ns_ = now_ns;
+    }
+  }
+
+  // Each peer is told about every one that signed in after it, one long-poll
+  // at a time, and messages would queue behind that. Measure them once it
+  // is over.
+  void Settle() {
+    int expected = sign_ins_ * (sign_ins_ - 1) / 2;
+    uint64 now_ns = talk_base::TimeNanos();
+    int elapsed_ms = static_cast<int>(
+        (now_ns - settle_start_ns_) / talk_base::kNumNanosecsPerMillisec);
+    if (notifications_ < expected && elapsed_ms < kMaxSettleMs)
+      return;
+    printf("delivered %d of %d sign in notifications in %d ms\n",
+           notifications_, expected, elapsed_ms);
+    phase_ = SENDING;
+    last_tick_ns_ = now_ns;
+    talk_base::Thread::Current()->PostDelayed(FLAG_duration, this, MSG_STOP);
+  }
+
+  void SendSome() {
+    // Every peer sends once per interval on average. Ticks run late when
+    // we're busy, so go by the clock rather than count them.
+    uint64 now_ns = talk_base::TimeNanos();
+    messages_due_ += static_cast<double>(signed_in_.size()) *
+        (now_ns - last_tick_ns_) / talk_base::kNumNanosecsPerMillisec /
+        FLAG_interval;
+    last_tick_ns_ = now_ns;
+    for (; messages_due_ >= 1.0; messages_due_ -= 1.0) {
+      size_t from = talk_base::CreateRandomId() % signed_in_.size();
+      size_t to = talk_base::CreateRandomId() % (signed_in_.size() - 1);
+      if (to >= from)
+        ++to;
+      signed_in_[from]->SendMessage(signed_in_[to]->id());
+    }
+  }
+
+  // Formats p50/p90/p99/max of |values|, divided by |scale|.
+  static std::string Percentiles(std::vector<uint32>* values, uint32 scale) {
+    if (values->empty())
+      return "none";
+    std::sort(values->begin(), values->end());
+    size_t n = values->size();
+    char buffer[128];
+    talk_base::sprintfn(buffer, sizeof(buffer),
+                        "p50 %u, p90 %u, p99 %u, max %u",
+                        (*values)[n / 2] / scale,
+                        (*values)[n * 9 / 10] / scale,
+                        (*values)[n * 99 / 100] / scale,
+                        (*values)[n - 1] / scale);
+    return buffer;
+  }
+
+  talk_base::SocketAddress server_;
+  std::vector<LoadPeer*> peers_;
+  std::vector<LoadPeer*> signed_in_;
+  Phase phase_;
+  bool stopping_;
+  size_t next_peer_;
+  double messages_due_;
+  uint64 start_ns_;
+  uint64 settle_start_ns_;
+  uint64 last_tick_ns_;
+  int sign_in_ms_;
+  int sign_ins_;
+  int sign_in_failures_;
+  int messages_sent_;
+  int message_failures_;
+  int messages_received_;
+  int notifications_;
+  int wait_failures_;
+  std::vector<uint32> sign_in_us_;
+  std::vector<uint32> latency_us_;
+};
+
+void LoadPeer::SignIn() {
+  sign_in_start_ns_ = talk_base::TimeNanos();
+  char request[128];
+  talk_base::sprintfn(request, sizeof(request),
+                      "GET /sign_in?load_%d HTTP/1.0\r\n\r\n", index_);
+  if (!Start(request, &LoadPeer::OnSignedIn))
+    test_->OnSignInFailed();
+}
+
+void LoadPeer::SendMessage(int to) {
+  char body[32];
+  int body_len = talk_base::sprintfn(body, sizeof(body), "%llu",
+      static_cast<unsigned long long>(talk_base::TimeNanos() / 1000));
+  char request[256];
+  talk_base::sprintfn(request, sizeof(request),
+                      "POST /message?peer_id=%d&to=%d HTTP/1.0\r\n"
+                      "Content-Type: text/plain\r\n"
+                      "Content-Length: %d\r\n\r\n%s",
+                      id_, to, body_len, body);
+  if (!Start(request, &LoadPeer::OnMessageSent))
+    test_->OnMessageSent(false);
+}
+
+bool LoadPeer::Start(const std::string& request,
+                     void (LoadPeer::*done)(HttpExchange*, bool)) {
+  HttpExchange* exchange = new HttpExchange(request);
+  exchange->SignalDone.connect(this, done);
+  if (!exchange->Start(test_->server())) {
+    delete exchange;
+    return false;
+  }
+  return true;
+}
+
+void LoadPeer::Wait() {
+  char request[64];
+  talk_base::sprintfn(request, sizeof(request),
+                      "GET /wait?peer_id=%d HTTP/1.0\r\n\r\n", id_);
+  if (!Start(request, &LoadPeer::OnWaitDone))
+    test_->OnWaitFailed();
+}
+
+void LoadPeer::OnSignedIn(HttpExchange* exchange, bool ok) {
+  if (ok && exchange->status() == 200 && exchange->peer_id() != 0) {
+    id_ = exchange->peer_id();
+    test_->OnSignedIn(this, talk_base::TimeNanos() - sign_in_start_ns_);
+    Wait();
+  } else {
+    test_->OnSignInFailed();
+  }
+  talk_base::Thread::Current()->Dispose(exchange);
+}
+
+void LoadPeer::OnWaitDone(HttpExchange* exchange, bool ok) {
+  if (!ok || exchange->status() != 200) {
+    test_->OnWaitFailed();
+  } else if (exchange->peer_id() == id_) {
+    // The server tells us about our own id when another peer comes or goes.
+    test_->OnNotification();
+  } else {
+    test_->OnMessageReceived(strtoull(exchange->body().c_str(), NULL, 10));
+  }
+  talk_base::Thread::Current()->Dispose(exchange);
+  if (ok && !test_->stopping())
+    Wait();
+}
+
+void LoadPeer::OnMessageSent(HttpExchange* exchange, bool ok) {
+  test_->OnMessageSent(ok && exchange->status() == 200);
+  talk_base::Thread::Current()->Dispose(exchange);
+}
+
+#ifdef POSIX
+// Every peer holds a connection open while it waits.
+static void RaiseDescriptorLimit() {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+#endif
+
+int main(int argc, char** argv) {
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help) {
+    FlagList::Print(NULL, false);
+    return 0;
+  }
+  if (FLAG_peers < 2 || FLAG_sign_in_rate < 1 || FLAG_interval < 1) {
+    printf("--peers must be at least 2, --sign_in_rate and --interval "
+           "positive\n");
+    return -1;
+  }
+
+  talk_base::SocketAddress server(FLAG_server, FLAG_port);
+  if (server.IsUnresolvedIP()) {
+    printf("--server must be an IP address\n");
+    return -1;
+  }
+
+#ifdef POSIX
+  RaiseDescriptorLimit();
+#endif
+
+  talk_base::PhysicalSocketServer socket_server;
+#ifdef LINUX
+  socket_server.EnableEpoll();
+#endif
+  talk_base::SocketServerScope scope(&socket_server);
+
+  LoadTest test(server, FLAG_peers);
+  test.Run();
+  test.Report();
+  return 0;
+}
@@ -30,15 +30,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#if defined(POSIX)
-#include <unistd.h>
-#endif
 
+#include "base/thread.h"
 #include "peerconnection/server/utils.h"
 
 static const char kHeaderTerminator[] = "\r\n\r\n";
 static const int kHeaderTerminatorLength = sizeof(kHeaderTerminator) - 1;
 
+// Pending connections the kernel may queue while we're busy. Peers reconnect
+// for every request, so this has to absorb bursts.
+static const int kListenBacklog = 1024;
+
 // static
 const char DataSocket::kCrossOriginAllowHeaders[] =
     "Access-Control-Allow-Origin: *\r\n"
@@ -48,42 +50,62 @@ const char DataSocket::kCrossOriginAllowHeaders[] =
         "Content-Length, Connection, Cache-Control\r\n"
     "Access-Control-Expose-Headers: Content-Length, X-Peer-Id\r\n";
 
-#if defined(WIN32)
-class WinsockInitializer {
-  static WinsockInitializer singleton;
-
-  WinsockInitializer() {
-    WSADATA data;
-    WSAStartup(MAKEWORD(1, 0), &data);
-  }
-
- public:
-  ~WinsockInitializer() { WSACleanup(); }
-};
-WinsockInitializer WinsockInitializer::singleton;
-#endif
+// See peer_channel.cc for why this is "Pragma".
+static const char kPeerIdHeader[] = "Pragma: ";
 
 //
-// SocketBase
+// PreparedResponse
 //
 
-bool SocketBase::Create() {
-  assert(!valid());
-  socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
-  return valid();
+PreparedResponse::PreparedResponse(const std::string& status,
+                                   bool connection_close,
+                                   const std::string& content_type,
+                                   const std::string& data) {
+  assert(!status.empty());
+  head_.reserve(128);
+  head_.append("HTTP/1.1 ").append(status).append("\r\n");
+  head_.append("Server: PeerConnectionTestServer/0.1\r\n"
+               "Cache-Control: no-cache\r\n");
+  if (connection_close)
+    head_.append("Connection: close\r\n");
+  if (!content_type.empty())
+    head_.append("Content-Type: ").append(content_type).append("\r\n");
+  head_.append("Content-Length: ").append(size_t2str(data.size()))
+       .append("\r\n");
+
+  tail_.reserve(sizeof(DataSocket::kCrossOriginAllowHeaders) + 2 +
+                data.size());
+  tail_.append(DataSocket::kCrossOriginAllowHeaders);
+  tail_.append("\r\n");
+  tail_.append(data);
 }
 
-void SocketBase::Close() {
-  if (socket_ != INVALID_SOCKET) {
-    closesocket(socket_);
-    socket_ = INVALID_SOCKET;
-  }
+PreparedResponsePtr PrepareResponse(const std::string& status,
+                                    bool connection_close,
+                                    const std::string& content_type,
+                                    const std::string& data) {
+  return new talk_base::RefCountedObject<PreparedResponse>(
+      status, connection_close, content_type, data);
 }
 
 //
 // DataSocket
 //
 
+DataSocket::DataSocket(talk_base::AsyncSocket* socket)
+    : socket_(socket),
+      method_(INVALID),
+      content_length_(0),
+      output_pos_(0),
+      close_when_sent_(false) {
+  socket_->SignalReadEvent.connect(this, &DataSocket::OnReadEvent);
+  socket_->SignalWriteEvent.connect(this, &DataSocket::OnWriteEvent);
+  socket_->SignalCloseEvent.connect(this, &DataSocket::OnCloseEvent);
+}
+
+DataSocket::~DataSocket() {
+}
+
 std::string DataSocket::request_arguments() const {
   size_t args = request_path_.find('?');
   if (args != std::string::npos)
@@ -94,21 +116,22 @@ std::string DataSocket::request_arguments() const {
 bool DataSocket::PathEquals(const char* path) const {
   assert(path);
   size_t args = request_path_.find('?');
-  if (args != std::string::npos)
-    return request_path_.substr(0, args).compare(path) == 0;
-  return request_path_.compare(path) == 0;
+  size_t len = (args != std::string::npos) ? args : request_path_.length();
+  return request_path_.compare(0, len, path) == 0;
 }
 
 bool DataSocket::OnDataAvailable(bool* close_socket) {
   assert(valid());
-  char buffer[0xfff] = {0};
-  int bytes = recv(socket_, buffer, sizeof(buffer), 0);
-  if (bytes == SOCKET_ERROR || bytes == 0) {
+  char buffer[0xfff];
+  int bytes = socket_->Recv(buffer, sizeof(buffer));
+  if (bytes == 0 || (bytes < 0 && !socket_->IsBlocking())) {
     *close_socket = true;
     return false;
   }
 
   *close_socket = false;
+  if (bytes < 0)
+    return true;
 
   bool ret = true;
   if (headers_received()) {
@@ -119,8 +142,13 @@ bool DataSocket::OnDataAvailable(bool* close_socket) {
       data_.append(buffer, bytes);
     }
   } else {
+    // Only the new bytes, plus enough before them to catch a terminator
+    // that straddles two reads, need to be searched.
+    size_t search_from = request_headers_.length();
+    search_from = (search_from > kHeaderTerminatorLength - 1) ?
+        search_from - (kHeaderTerminatorLength - 1) : 0;
     request_headers_.append(buffer, bytes);
-    size_t found = request_headers_.find(kHeaderTerminator);
+    size_t found = request_headers_.find(kHeaderTerminator, search_from);
     if (found != std::string::npos) {
       data_ = request_headers_.substr(found + kHeaderTerminatorLength);
       request_headers_.resize(found + kHeaderTerminatorLength);
@@ -130,40 +158,78 @@ bool DataSocket::OnDataAvailable(bool* close_socket) {
   return ret;
 }
 
-bool DataSocket::Send(const std::string& data) const {
-  return send(socket_, data.data(), data.length(), 0) != SOCKET_ERROR;
+bool DataSocket::Send(const std::string& data) {
+  assert(valid());
+  output_.append(data);
+  return Flush();
 }
 
 bool DataSocket::Send(const std::string& status, bool connection_close,
                       const std::string& content_type,
                       const std::string& extra_headers,
-                      const std::string& data) const {
+                      const std::string& data) {
   assert(valid());
   assert(!status.empty());
-  std::string buffer("HTTP/1.1 " + status + "\r\n");
+  // Formatted straight into the output buffer; there is nothing to share.
+  output_.append("HTTP/1.1 ").append(status).append("\r\n");
 
-  buffer += "Server: PeerConnectionTestServer/0.1\r\n"
-            "Cache-Control: no-cache\r\n";
+  output_.append("Server: PeerConnectionTestServer/0.1\r\n"
+                 "Cache-Control: no-cache\r\n");
 
   if (connection_close)
-    buffer += "Connection: close\r\n";
+    output_.append("Connection: close\r\n");
 
   if (!content_type.empty())
-    buffer += "Content-Type: " + content_type + "\r\n";
+    output_.append("Content-Type: ").append(content_type).append("\r\n");
 
-  buffer += "Content-Length: " + int2str(data.size()) + "\r\n";
+  output_.append("Content-Length: ").append(size_t2str(data.size()))
+         .append("\r\n");
 
-  if (!extra_headers.empty()) {
-    buffer += extra_headers;
-    // Extra headers are assumed to have a separator per header.
-  }
+  // Extra headers are assumed to have a separator per header.
+  output_.append(extra_headers);
+
+  output_.append(kCrossOriginAllowHeaders);
 
-  buffer += kCrossOriginAllowHeaders;
+  output_.append("\r\n");
+  output_.append(data);
 
-  buffer += "\r\n";
-  buffer += data;
+  close_when_sent_ = close_when_sent_ || connection_close;
+  return Flush();
+}
+
+bool DataSocket::Send(const PreparedResponse& response, int peer_id) {
+  assert(valid());
+  output_.append(response.head());
+  if (peer_id != 0) {
+    char header[sizeof(kPeerIdHeader) + 16];
+    int len = snprintf(header, sizeof(header), "%s%d\r\n", kPeerIdHeader,
+                       peer_id);
+    output_.append(header, len);
+  }
+  output_.append(response.tail());
+  // Prepared responses are only used for the long-poll answers, which always
+  // end the connection.
+  close_when_sent_ = true;
+  return Flush();
+}
 
-  return Send(buffer);
+bool DataSocket::Flush() {
+  while (output_pos_ < output_.length()) {
+    int sent = socket_->Send(output_.data() + output_pos_,
+                             output_.length() - output_pos_);
+    if (sent < 0) {
+      if (socket_->IsBlocking())
+        return true;  // OnWriteEvent picks it up from here.
+      Close();
+      return false;
+    }
+    output_pos_ += sent;
+  }
+  output_.clear();
+  output_pos_ = 0;
+  if (close_when_sent_)
+    Close();
+  return true;
 }
 
 void DataSocket::Clear() {
@@ -175,6 +241,40 @@ void DataSocket::Clear() {
   data_.clear();
 }
 
+void DataSocket::Close() {
+  if (!valid())
+    return;
+  socket_->Close();
+  // We may be inside one of the socket's callbacks, so it can't be deleted
+  // yet. Closing it doesn't raise its close event; we raise our own.
+  talk_base::Thread* thread = talk_base::Thread::Current();
+  thread->Dispose(socket_.release());
+  thread->Post(this);
+}
+
+void DataSocket::OnMessage(talk_base::Message* msg) {
+  SignalClosed(this);
+}
+
+void DataSocket::OnReadEvent(talk_base::AsyncSocket* socket) {
+  bool close_socket = false;
+  bool was_received = request_received();
+  if (!OnDataAvailable(&close_socket)) {
+    Close();
+    return;
+  }
+  if (!was_received && request_received())
+    SignalRequestReceived(this);
+}
+
+void DataSocket::OnWriteEvent(talk_base::AsyncSocket* socket) {
+  Flush();
+}
+
+void DataSocket::OnCloseEvent(talk_base::AsyncSocket* socket, int err) {
+  Close();
+}
+
 bool DataSocket::ParseHeaders() {
   assert(!request_headers_.empty());
   assert(method_ == INVALID);
@@ -278,29 +378,31 @@ bool DataSocket::ParseContentLengthAndType(const char* headers, size_t length) {
 //
 
 bool ListeningSocket::Listen(unsigned short port) {
-  assert(valid());
-  int enabled = 1;
-  setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR,
-      reinterpret_cast<const char*>(&enabled), sizeof(enabled));
-  struct sockaddr_in addr = {0};
-  addr.sin_family = AF_INET;
-  addr.sin_addr.s_addr = htonl(INADDR_ANY);
-  addr.sin_port = htons(port);
-  if (bind(socket_, reinterpret_cast<const sockaddr*>(&addr),
-           sizeof(addr)) == SOCKET_ERROR) {
+  talk_base::SocketServer* ss = talk_base::Thread::Current()->socketserver();
+  socket_.reset(ss->CreateAsyncSocket(AF_INET, SOCK_STREAM));
+  if (!socket_) {
+    printf("Failed to create server socket\n");
+    return false;
+  }
+  socket_->SetOption(talk_base::Socket::OPT_REUSEADDR, 1);
+  if (socket_->Bind(talk_base::SocketAddress(talk_base::IPAddress(INADDR_ANY),
+                                             port)) < 0) {
     printf("bind failed\n");
     return false;
   }
-  return listen(socket_, 5) != SOCKET_ERROR;
+  socket_->SignalReadEvent.connect(this, &ListeningSocket::OnReadEvent);
+  return socket_->Listen(kListenBacklog) >= 0;
 }
 
-DataSocket* ListeningSocket::Accept() const {
-  assert(valid());
-  struct sockaddr_in addr = {0};
-  socklen_t size = sizeof(addr);
-  int client = accept(socket_, reinterpret_cast<sockaddr*>(&addr), &size);
-  if (client == INVALID_SOCKET)
-    return NULL;
+void ListeningSocket::Close() {
+  socket_.reset();
+}
 
-  return new DataSocket(client);
+void ListeningSocket::OnReadEvent(talk_base::AsyncSocket* socket) {
+  // Take everything that is waiting; under load many connections arrive
+  // between two wakeups.
+  while (talk_base::AsyncSocket* client = socket_->Accept(NULL)) {
+    client->SetOption(talk_base::Socket::OPT_NODELAY, 1);
+    SignalNewConnection(new DataSocket(client));
+  }
 }
@@ -25,48 +25,56 @@
  * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #ifndef TALK_EXAMPLES_PEERCONNECTION_SERVER_DATA_SOCKET_H_
 #define TALK_EXAMPLES_PEERCONNECTION_SERVER_DATA_SOCKET_H_
 #pragma once
 
-#ifdef WIN32
-#include <winsock2.h>
-typedef int socklen_t;
-#else
-#include <netinet/in.h>
-#include <sys/select.h>
-#include <sys/socket.h>
-#define closesocket close
-#endif
-
 #include <string>
 
-#ifndef SOCKET_ERROR
-#define SOCKET_ERROR (-1)
-#endif
-
-#ifndef INVALID_SOCKET
-#define INVALID_SOCKET  static_cast<int>(~0)
-#endif
-
-class SocketBase {
+#include "base/asyncsocket.h"
+#include "base/messagehandler.h"
+#include "base/refcount.h"
+#include "base/scoped_ptr.h"
+#include "base/scoped_ref_ptr.h"
+#include "base/sigslot.h"
+
+// An HTTP response that is formatted once and can then be sent on any
+// number of sockets. Notifications that go to every peer share one of these
+// instead of being formatted again for each recipient. The only header that
+// differs between recipients, the peer id, is added when it is sent.
+class PreparedResponse : public talk_base::RefCountInterface {
  public:
-  SocketBase() : socket_(INVALID_SOCKET) { }
-  explicit SocketBase(int socket) : socket_(socket) { }
-  ~SocketBase() { Close(); }
+  // See DataSocket::Send for the meaning of the arguments.
+  PreparedResponse(const std::string& status, bool connection_close,
+                   const std::string& content_type, const std::string& data);
 
-  int socket() const { return socket_; }
-  bool valid() const { return socket_ != INVALID_SOCKET; }
-
-  bool Create();
-  void Close();
+  // Status line and headers that come before the peer id.
+  const std::string& head() const { return head_; }
+  // Remaining headers, the blank line and the body.
+  const std::string& tail() const { return tail_; }
 
  protected:
-  int socket_;
+  virtual ~PreparedResponse() {}
+
+ private:
+  std::string head_;
+  std::string tail_;
 };
 
-// Represents an HTTP server socket.
-class DataSocket : public SocketBase {
+typedef talk_base::scoped_refptr<PreparedResponse> PreparedResponsePtr;
+
+// Creates a PreparedResponse.
+PreparedResponsePtr PrepareResponse(const std::string& status,
+                                    bool connection_close,
+                                    const std::string& content_type,
+                                    const std::string& data);
+
+// Represents an HTTP server socket. Reads and writes are non-blocking and
+// driven by the socket server; output that doesn't fit in the socket is kept
+// until it can be written.
+class DataSocket : public talk_base::MessageHandler,
+                   public sigslot::has_slots<> {
  public:
   enum RequestMethod {
     INVALID,
@@ -75,17 +83,14 @@ class DataSocket : public SocketBase {
     OPTIONS,
   };
 
-  explicit DataSocket(int socket)
-      : SocketBase(socket),
-        method_(INVALID),
-        content_length_(0) {
-  }
-
-  ~DataSocket() {
-  }
+  // Takes ownership of |socket|.
+  explicit DataSocket(talk_base::AsyncSocket* socket);
+  ~DataSocket();
 
   static const char kCrossOriginAllowHeaders[];
 
+  bool valid() const { return socket_.get() != NULL; }
+
   bool headers_received() const { return method_ != INVALID; }
 
   RequestMethod method() const { return method_; }
@@ -110,17 +115,14 @@ class DataSocket : public SocketBase {
   // Checks if the request path (minus arguments) matches a given path.
   bool PathEquals(const char* path) const;
 
-  // Called when we have received some data from clients.
-  // Returns false if an error occurred.
-  bool OnDataAvailable(bool* close_socket);
-
   // Send a raw buffer of bytes.
-  bool Send(const std::string& data) const;
+  bool Send(const std::string& data);
 
   // Send an HTTP response.  The |status| should start with a valid HTTP
   // response code, followed by a string.  E.g. "200 OK".
   // If |connection_close| is set to true, an extra "Connection: close" HTTP
-  // header will be included.  |content_type| is the mime content type, not
+  // header will be included and the socket is closed once the response has
+  // been written.  |content_type| is the mime content type, not
   // including the "Content-Type: " string.
   // |extra_headers| should be either empty or a list of headers where each
   // header terminates with "\r\n".
@@ -128,12 +130,43 @@ class DataSocket : public SocketBase {
   // a "Content-Length" header.
   bool Send(const std::string& status, bool connection_close,
             const std::string& content_type,
-            const std::string& extra_headers, const std::string& data) const;
+            const std::string& extra_headers, const std::string& data);
+
+  // Send a prepared response, with a peer id header for |peer_id| unless it
+  // is 0. Whether the socket is closed afterwards was decided when the
+  // response was prepared.
+  bool Send(const PreparedResponse& response, int peer_id);
 
   // Clears all held state and prepares the socket for receiving a new request.
   void Clear();
 
+  // Closes the socket now, dropping any output that hasn't been written.
+  void Close();
+
+  // Signalled once a complete request has been received.
+  sigslot::signal1<DataSocket*> SignalRequestReceived;
+  // Signalled when the socket has closed, either because the client went
+  // away, because of an error or after a response that closes the
+  // connection. This always comes from a message of its own, never from
+  // inside Send, so a response can be sent while iterating over peers
+  // without the receiver tearing things down underneath. Use Thread::Dispose
+  // to delete the DataSocket from here.
+  sigslot::signal1<DataSocket*> SignalClosed;
+
  protected:
+  // Called when we have received some data from clients.
+  // Returns false if an error occurred.
+  bool OnDataAvailable(bool* close_socket);
+
+  // Writes as much buffered output as the socket takes. Returns false if the
+  // socket failed.
+  bool Flush();
+
+  void OnReadEvent(talk_base::AsyncSocket* socket);
+  void OnWriteEvent(talk_base::AsyncSocket* socket);
+  void OnCloseEvent(talk_base::AsyncSocket* socket, int err);
+  virtual void OnMessage(talk_base::Message* msg);
+
   // A fairly relaxed HTTP header parser.  Parses the method, path and
   // content length (POST only) of a request.
   // Returns true if a valid request was received and no errors occurred.
@@ -147,22 +180,37 @@ class DataSocket : public SocketBase {
   bool ParseContentLengthAndType(const char* headers, size_t length);
 
  protected:
+  talk_base::scoped_ptr<talk_base::AsyncSocket> socket_;
   RequestMethod method_;
   size_t content_length_;
   std::string content_type_;
   std::string request_path_;
   std::string request_headers_;
   std::string data_;
+  // Output not yet taken by the socket, starting at |output_pos_|.
+  std::string output_;
+  size_t output_pos_;
+  bool close_when_sent_;
 };
 
 // The server socket.  Accepts connections and generates DataSocket instances
 // for each new connection.
-class ListeningSocket : public SocketBase {
+class ListeningSocket : public sigslot::has_slots<> {
  public:
   ListeningSocket() {}
 
+  bool valid() const { return socket_.get() != NULL; }
+
   bool Listen(unsigned short port);
-  DataSocket* Accept() const;
+  void Close();
+
+  // Signalled for every connection accepted. The receiver takes ownership.
+  sigslot::signal1<DataSocket*> SignalNewConnection;
+
+ private:
+  void OnReadEvent(talk_base::AsyncSocket* socket);
+
+  talk_base::scoped_ptr<talk_base::AsyncSocket> socket_;
 };
 
 #endif  // TALK_EXAMPLES_PEERCONNECTION_SERVER_DATA_SOCKET_H_
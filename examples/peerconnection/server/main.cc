@@ -28,43 +28,147 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef POSIX
+#include <sys/resource.h>
+#endif
 
-#include <vector>
+#include <unordered_set>
 
 #include "base/flags.h"
+#include "base/logging.h"
+#include "base/physicalsocketserver.h"
+#include "base/thread.h"
 #include "peerconnection/server/data_socket.h"
 #include "peerconnection/server/peer_channel.h"
 #include "peerconnection/server/utils.h"
 
 DEFINE_bool(help, false, "Prints this message");
 DEFINE_int(port, 8888, "The port on which to listen.");
+DEFINE_bool(verbose, false, "Logs every sign in, sign out and message.");
+
+// How often peers that stopped polling are looked for.
+static const int kTimeoutCheckIntervalMs = 1000;
+
+// Accepts connections and routes requests to the PeerChannel. Sockets are
+// serviced by the thread's socket server, so the number of connections is
+// only limited by the descriptors the process may open.
+class SignalingServer : public talk_base::MessageHandler,
+                        public sigslot::has_slots<> {
+ public:
+  SignalingServer() {
+    listener_.SignalNewConnection.connect(this,
+                                          &SignalingServer::OnNewConnection);
+  }
+
+  ~SignalingServer() {
+    for (SocketSet::iterator i = sockets_.begin(); i != sockets_.end(); ++i)
+      delete (*i);
+  }
+
+  bool Listen(unsigned short port) {
+    if (!listener_.Listen(port))
+      return false;
+    talk_base::Thread::Current()->PostDelayed(kTimeoutCheckIntervalMs, this);
+    return true;
+  }
+
+ private:
+  typedef std::unordered_set<DataSocket*> SocketSet;
 
-static const size_t kMaxConnections = (FD_SETSIZE - 2);
-
-void HandleBrowserRequest(DataSocket* ds, bool* quit) {
-  assert(ds && ds->valid());
-  assert(quit);
-
-  const std::string& path = ds->request_path();
-
-  *quit = (path.compare("/quit") == 0);
-
-  if (*quit) {
-    ds->Send("200 OK", true, "text/html", "",
-             "<html><body>Quitting...</body></html>");
-  } else if (ds->method() == DataSocket::OPTIONS) {
-    // We'll get this when a browsers do cross-resource-sharing requests.
-    // The headers to allow cross-origin script support will be set inside
-    // Send.
-    ds->Send("200 OK", true, "", "", "");
-  } else {
-    // Here we could write some useful output back to the browser depending on
-    // the path.
-    printf("Received an invalid request: %s\n", ds->request_path().c_str());
-    ds->Send("500 Sorry", true, "text/html", "",
-             "<html><body>Sorry, not yet implemented</body></html>");
+  void OnNewConnection(DataSocket* ds) {
+    ds->SignalRequestReceived.connect(this, &SignalingServer::OnRequest);
+    ds->SignalClosed.connect(this, &SignalingServer::OnSocketClosed);
+    sockets_.insert(ds);
+    LOG(LS_VERBOSE) << "New connection (total=" << sockets_.size() << ")";
+  }
+
+  void OnRequest(DataSocket* s) {
+    ChannelMember* member = clients_.Lookup(s);
+    if (member || PeerChannel::IsPeerConnection(s)) {
+      if (!member) {
+        if (s->PathEquals("/sign_in")) {
+          clients_.AddMember(s);
+        } else {
+          LOG(LS_WARNING) << "No member found for: " << s->request_path();
+          s->Send("500 Error", true, "text/plain", "",
+                  "Peer most likely gone.");
+        }
+      } else if (member->is_wait_request(s)) {
+        // no need to do anything.
+      } else {
+        ChannelMember* target = clients_.IsTargetedRequest(s);
+        if (target) {
+          member->ForwardRequestToPeer(s, target);
+        } else if (s->PathEquals("/sign_out")) {
+          s->Send("200 OK", true, "text/plain", "", "");
+        } else {
+          LOG(LS_WARNING) << "Couldn't find target for request: "
+                          << s->request_path();
+          s->Send("500 Error", true, "text/plain", "",
+                  "Peer most likely gone.");
+        }
+      }
+    } else {
+      HandleBrowserRequest(s);
+    }
+  }
+
+  void HandleBrowserRequest(DataSocket* ds) {
+    assert(ds && ds->valid());
+
+    const std::string& path = ds->request_path();
+
+    if (path.compare("/quit") == 0) {
+      ds->Send("200 OK", true, "text/html", "",
+               "<html><body>Quitting...</body></html>");
+      printf("Quitting...\n");
+      listener_.Close();
+      clients_.CloseAll();
+      talk_base::Thread::Current()->Quit();
+    } else if (ds->method() == DataSocket::OPTIONS) {
+      // We'll get this when a browsers do cross-resource-sharing requests.
+      // The headers to allow cross-origin script support will be set inside
+      // Send.
+      ds->Send("200 OK", true, "", "", "");
+    } else {
+      // Here we could write some useful output back to the browser depending
+      // on the path.
+      printf("Received an invalid request: %s\n", path.c_str());
+      ds->Send("500 Sorry", true, "text/html", "",
+               "<html><body>Sorry, not yet implemented</body></html>");
+    }
+  }
+
+  void OnSocketClosed(DataSocket* ds) {
+    LOG(LS_VERBOSE) << "Disconnecting socket";
+    clients_.OnClosing(ds);
+    sockets_.erase(ds);
+    // Still inside its SignalClosed.
+    talk_base::Thread::Current()->Dispose(ds);
+  }
+
+  virtual void OnMessage(talk_base::Message* msg) {
+    clients_.CheckForTimeout();
+    talk_base::Thread::Current()->PostDelayed(kTimeoutCheckIntervalMs, this);
+  }
+
+  ListeningSocket listener_;
+  PeerChannel clients_;
+  SocketSet sockets_;
+};
+
+#ifdef POSIX
+// Every peer holds a connection open while it waits, so the default limit on
+// descriptors would cap the number of peers.
+static void RaiseDescriptorLimit() {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
   }
 }
+#endif
 
 int main(int argc, char** argv) {
   FlagList::SetFlagsFromCommandLine(&argc, argv, true);
@@ -80,111 +184,30 @@ int main(int argc, char** argv) {
     return -1;
   }
 
-  ListeningSocket listener;
-  if (!listener.Create()) {
-    printf("Failed to create server socket\n");
-    return -1;
-  } else if (!listener.Listen(FLAG_port)) {
+  if (FLAG_verbose)
+    talk_base::LogMessage::LogToDebug(talk_base::LS_VERBOSE);
+
+#ifdef POSIX
+  RaiseDescriptorLimit();
+#endif
+
+  talk_base::PhysicalSocketServer socket_server;
+#ifdef LINUX
+  if (!socket_server.EnableEpoll())
+    printf("epoll is not available; using select\n");
+#endif
+  talk_base::Thread* thread = talk_base::Thread::Current();
+  talk_base::SocketServerScope scope(&socket_server);
+
+  SignalingServer server;
+  if (!server.Listen(FLAG_port)) {
     printf("Failed to listen on server socket\n");
     return -1;
   }
 
   printf("Server listening on port %i\n", FLAG_port);
 
-  PeerChannel clients;
-  typedef std::vector<DataSocket*> SocketArray;
-  SocketArray sockets;
-  bool quit = false;
-  while (!quit) {
-    fd_set socket_set;
-    FD_ZERO(&socket_set);
-    if (listener.valid())
-      FD_SET(listener.socket(), &socket_set);
-
-    for (SocketArray::iterator i = sockets.begin(); i != sockets.end(); ++i)
-      FD_SET((*i)->socket(), &socket_set);
-
-    struct timeval timeout = { 10, 0 };
-    if (select(FD_SETSIZE, &socket_set, NULL, NULL, &timeout) == SOCKET_ERROR) {
-      printf("select failed\n");
-      break;
-    }
-
-    for (SocketArray::iterator i = sockets.begin(); i != sockets.end(); ++i) {
-      DataSocket* s = *i;
-      bool socket_done = true;
-      if (FD_ISSET(s->socket(), &socket_set)) {
-        if (s->OnDataAvailable(&socket_done) && s->request_received()) {
-          ChannelMember* member = clients.Lookup(s);
-          if (member || PeerChannel::IsPeerConnection(s)) {
-            if (!member) {
-              if (s->PathEquals("/sign_in")) {
-                clients.AddMember(s);
-              } else {
-                printf("No member found for: %s\n",
-                    s->request_path().c_str());
-                s->Send("500 Error", true, "text/plain", "",
-                        "Peer most likely gone.");
-              }
-            } else if (member->is_wait_request(s)) {
-              // no need to do anything.
-              socket_done = false;
-            } else {
-              ChannelMember* target = clients.IsTargetedRequest(s);
-              if (target) {
-                member->ForwardRequestToPeer(s, target);
-              } else if (s->PathEquals("/sign_out")) {
-                s->Send("200 OK", true, "text/plain", "", "");
-              } else {
-                printf("Couldn't find target for request: %s\n",
-                    s->request_path().c_str());
-                s->Send("500 Error", true, "text/plain", "",
-                        "Peer most likely gone.");
-              }
-            }
-          } else {
-            HandleBrowserRequest(s, &quit);
-            if (quit) {
-              printf("Quitting...\n");
-              FD_CLR(listener.socket(), &socket_set);
-              listener.Close();
-              clients.CloseAll();
-            }
-          }
-        }
-      } else {
-        socket_done = false;
-      }
-
-      if (socket_done) {
-        printf("Disconnecting socket\n");
-        clients.OnClosing(s);
-        assert(s->valid());  // Close must not have been called yet.
-        FD_CLR(s->socket(), &socket_set);
-        delete (*i);
-        i = sockets.erase(i);
-        if (i == sockets.end())
-          break;
-      }
-    }
-
-    clients.CheckForTimeout();
-
-    if (FD_ISSET(listener.socket(), &socket_set)) {
-      DataSocket* s = listener.Accept();
-      if (sockets.size() >= kMaxConnections) {
-        delete s;  // sorry, that's all we can take.
-        printf("Connection limit reached\n");
-      } else {
-        sockets.push_back(s);
-        printf("New connection...\n");
-      }
-    }
-  }
-
-  for (SocketArray::iterator i = sockets.begin(); i != sockets.end(); ++i)
-    delete (*i);
-  sockets.clear();
+  thread->Run();
 
   return 0;
 }
@@ -33,6 +33,7 @@
 
 #include <algorithm>
 
+#include "base/logging.h"
 #include "peerconnection/server/data_socket.h"
 #include "peerconnection/server/utils.h"
 
@@ -93,10 +94,9 @@ std::string ChannelMember::GetPeerIdHeader() const {
   return ret;
 }
 
-bool ChannelMember::NotifyOfOtherMember(const ChannelMember& other) {
-  assert(&other != this);
-  QueueResponse("200 OK", "text/plain", GetPeerIdHeader(),
-                other.GetEntry());
+bool ChannelMember::NotifyOfOtherMember(
+    const PreparedResponsePtr& notification) {
+  QueueResponse(notification, id_);
   return true;
 }
 
@@ -111,16 +111,14 @@ void ChannelMember::ForwardRequestToPeer(DataSocket* ds, ChannelMember* peer) {
   assert(peer);
   assert(ds);
 
-  std::string extra_headers(GetPeerIdHeader());
-
   if (peer == this) {
-    ds->Send("200 OK", true, ds->content_type(), extra_headers,
+    ds->Send("200 OK", true, ds->content_type(), GetPeerIdHeader(),
              ds->data());
   } else {
-    printf("Client %s sending to %s\n",
-        name_.c_str(), peer->name().c_str());
-    peer->QueueResponse("200 OK", ds->content_type(), extra_headers,
-                        ds->data());
+    LOG(LS_VERBOSE) << "Client " << name_ << " sending to " << peer->name();
+    peer->QueueResponse(PrepareResponse("200 OK", true, ds->content_type(),
+                                        ds->data()),
+                        id_);
     ds->Send("200 OK", true, "text/plain", "", "");
   }
 }
@@ -132,27 +130,19 @@ void ChannelMember::OnClosing(DataSocket* ds) {
   }
 }
 
-void ChannelMember::QueueResponse(const std::string& status,
-                                  const std::string& content_type,
-                                  const std::string& extra_headers,
-                                  const std::string& data) {
+void ChannelMember::QueueResponse(const PreparedResponsePtr& response,
+                                  int peer_id) {
   if (waiting_socket_) {
     assert(queue_.size() == 0);
     assert(waiting_socket_->method() == DataSocket::GET);
-    bool ok = waiting_socket_->Send(status, true, content_type, extra_headers,
-                                    data);
+    bool ok = waiting_socket_->Send(*response, peer_id);
     if (!ok) {
-      printf("Failed to deliver data to waiting socket\n");
+      LOG(LS_WARNING) << "Failed to deliver data to waiting socket";
     }
     waiting_socket_ = NULL;
     timestamp_ = time(NULL);
   } else {
-    QueuedResponse qr;
-    qr.status = status;
-    qr.content_type = content_type;
-    qr.extra_headers = extra_headers;
-    qr.data = data;
-    queue_.push(qr);
+    queue_.push(QueuedResponse(response, peer_id));
   }
 }
 
@@ -160,9 +150,8 @@ void ChannelMember::SetWaitingSocket(DataSocket* ds) {
   assert(ds->method() == DataSocket::GET);
   if (ds && !queue_.empty()) {
     assert(waiting_socket_ == NULL);
-    const QueuedResponse& response = queue_.front();
-    ds->Send(response.status, true, response.content_type,
-             response.extra_headers, response.data);
+    const QueuedResponse& queued = queue_.front();
+    ds->Send(*queued.response, queued.peer_id);
     queue_.pop();
   } else {
     waiting_socket_ = ds;
@@ -181,6 +170,19 @@ bool PeerChannel::IsPeerConnection(const DataSocket* ds) {
          (ds->method() == DataSocket::GET && ds->PathEquals("/sign_in"));
 }
 
+// static
+int PeerChannel::GetPeerId(const DataSocket* ds) {
+  const std::string& path = ds->request_path();
+  size_t args = path.find('?');
+  if (args == std::string::npos)
+    return 0;
+  static const char kPeerId[] = "peer_id=";
+  size_t found = path.find(kPeerId, args);
+  if (found == std::string::npos)
+    return 0;
+  return atoi(&path[found + ARRAYSIZE(kPeerId) - 1]);
+}
+
 ChannelMember* PeerChannel::Lookup(DataSocket* ds) const {
   assert(ds);
 
@@ -196,25 +198,16 @@ ChannelMember* PeerChannel::Lookup(DataSocket* ds) const {
   if (i == ARRAYSIZE(kRequestPaths))
     return NULL;
 
-  std::string args(ds->request_arguments());
-  static const char kPeerId[] = "peer_id=";
-  size_t found = args.find(kPeerId);
-  if (found == std::string::npos)
+  Members::const_iterator iter = members_.find(GetPeerId(ds));
+  if (iter == members_.end())
     return NULL;
 
-  int id = atoi(&args[found + ARRAYSIZE(kPeerId) - 1]);
-  Members::const_iterator iter = members_.begin();
-  for (; iter != members_.end(); ++iter) {
-    if (id == (*iter)->id()) {
-      if (i == kWait)
-        (*iter)->SetWaitingSocket(ds);
-      if (i == kSignOut)
-        (*iter)->set_disconnected();
-      return *iter;
-    }
-  }
-
-  return NULL;
+  ChannelMember* member = iter->second;
+  if (i == kWait)
+    member->SetWaitingSocket(ds);
+  if (i == kSignOut)
+    member->set_disconnected();
+  return member;
 }
 
 ChannelMember* PeerChannel::IsTargetedRequest(const DataSocket* ds) const {
@@ -238,25 +231,20 @@ ChannelMember* PeerChannel::IsTargetedRequest(const DataSocket* ds) const {
     args = found + ARRAYSIZE(kTargetPeerIdParam) - 1;
   } while (true);
   int id = atoi(&path[found]);
-  Members::const_iterator i = members_.begin();
-  for (; i != members_.end(); ++i) {
-    if ((*i)->id() == id) {
-      return *i;
-    }
-  }
-  return NULL;
+  Members::const_iterator i = members_.find(id);
+  return (i != members_.end()) ? i->second : NULL;
 }
 
 bool PeerChannel::AddMember(DataSocket* ds) {
   assert(IsPeerConnection(ds));
   ChannelMember* new_guy = new ChannelMember(ds);
-  Members failures;
+  MemberList failures;
   BroadcastChangedState(*new_guy, &failures);
   HandleDeliveryFailures(&failures);
-  members_.push_back(new_guy);
+  members_[new_guy->id()] = new_guy;
 
-  printf("New member added (total=%s): %s\n",
-      size_t2str(members_.size()).c_str(), new_guy->name().c_str());
+  LOG(LS_VERBOSE) << "New member added (total=" << members_.size() << "): "
+                  << new_guy->name();
 
   // Let the newly connected peer know about other members of the channel.
   std::string content_type;
@@ -267,84 +255,86 @@ bool PeerChannel::AddMember(DataSocket* ds) {
 }
 
 void PeerChannel::CloseAll() {
-  Members::const_iterator i = members_.begin();
-  for (; i != members_.end(); ++i) {
-    (*i)->QueueResponse("200 OK", "text/plain", "", "Server shutting down");
-  }
+  PreparedResponsePtr response =
+      PrepareResponse("200 OK", true, "text/plain", "Server shutting down");
+  for (Members::const_iterator i = members_.begin(); i != members_.end(); ++i)
+    i->second->QueueResponse(response, 0);
   DeleteAll();
 }
 
 void PeerChannel::OnClosing(DataSocket* ds) {
-  for (Members::iterator i = members_.begin(); i != members_.end(); ++i) {
-    ChannelMember* m = (*i);
-    m->OnClosing(ds);
-    if (!m->connected()) {
-      i = members_.erase(i);
-      Members failures;
-      BroadcastChangedState(*m, &failures);
-      HandleDeliveryFailures(&failures);
-      delete m;
-      if (i == members_.end())
-        break;
-    }
+  // Only the member named by the request can be waiting on |ds| or be
+  // signing out through it, so there is no need to visit the others.
+  Members::iterator i = members_.find(GetPeerId(ds));
+  if (i == members_.end())
+    return;
+  ChannelMember* m = i->second;
+  m->OnClosing(ds);
+  if (!m->connected()) {
+    members_.erase(i);
+    MemberList failures;
+    BroadcastChangedState(*m, &failures);
+    HandleDeliveryFailures(&failures);
+    delete m;
+    LOG(LS_VERBOSE) << "Total connected: " << members_.size();
   }
-  printf("Total connected: %s\n", size_t2str(members_.size()).c_str());
 }
 
 void PeerChannel::CheckForTimeout() {
-  for (Members::iterator i = members_.begin(); i != members_.end(); ++i) {
-    ChannelMember* m = (*i);
+  MemberList timed_out;
+  for (Members::iterator i = members_.begin(); i != members_.end(); ) {
+    ChannelMember* m = i->second;
     if (m->TimedOut()) {
-      printf("Timeout: %s\n", m->name().c_str());
+      LOG(LS_INFO) << "Timeout: " << m->name();
       m->set_disconnected();
       i = members_.erase(i);
-      Members failures;
-      BroadcastChangedState(*m, &failures);
-      HandleDeliveryFailures(&failures);
-      delete m;
-      if (i == members_.end())
-        break;
+      timed_out.push_back(m);
+    } else {
+      ++i;
     }
   }
+  // The members that are left hear about each of them.
+  HandleDeliveryFailures(&timed_out);
 }
 
 void PeerChannel::DeleteAll() {
   for (Members::iterator i = members_.begin(); i != members_.end(); ++i)
-    delete (*i);
+    delete i->second;
   members_.clear();
 }
 
 void PeerChannel::BroadcastChangedState(const ChannelMember& member,
-                                        Members* delivery_failures) {
+                                        MemberList* delivery_failures) {
   // This function should be called prior to DataSocket::Close().
   assert(delivery_failures);
 
   if (!member.connected()) {
-    printf("Member disconnected: %s\n", member.name().c_str());
+    LOG(LS_VERBOSE) << "Member disconnected: " << member.name();
   }
 
+  // Everybody gets the same notification, so it is only formatted once.
+  PreparedResponsePtr notification =
+      PrepareResponse("200 OK", true, "text/plain", member.GetEntry());
   Members::iterator i = members_.begin();
-  for (; i != members_.end(); ++i) {
-    if (&member != (*i)) {
-      if (!(*i)->NotifyOfOtherMember(member)) {
-        (*i)->set_disconnected();
-        delivery_failures->push_back(*i);
-        i = members_.erase(i);
-        if (i == members_.end())
-          break;
-      }
+  while (i != members_.end()) {
+    ChannelMember* other = i->second;
+    if (&member != other && !other->NotifyOfOtherMember(notification)) {
+      other->set_disconnected();
+      delivery_failures->push_back(other);
+      i = members_.erase(i);
+    } else {
+      ++i;
     }
   }
 }
 
-void PeerChannel::HandleDeliveryFailures(Members* failures) {
+void PeerChannel::HandleDeliveryFailures(MemberList* failures) {
   assert(failures);
 
   while (!failures->empty()) {
-    Members::iterator i = failures->begin();
-    ChannelMember* member = *i;
+    ChannelMember* member = failures->back();
     assert(!member->connected());
-    failures->erase(i);
+    failures->pop_back();
     BroadcastChangedState(*member, failures);
     delete member;
   }
@@ -359,9 +349,9 @@ std::string PeerChannel::BuildResponseForNewMember(const ChannelMember& member,
   // The peer itself will always be the first entry.
   std::string response(member.GetEntry());
   for (Members::iterator i = members_.begin(); i != members_.end(); ++i) {
-    if (member.id() != (*i)->id()) {
-      assert((*i)->connected());
-      response += (*i)->GetEntry();
+    if (member.id() != i->second->id()) {
+      assert(i->second->connected());
+      response += i->second->GetEntry();
     }
   }
 
@@ -33,9 +33,10 @@
 
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-class DataSocket;
+#include "peerconnection/server/data_socket.h"
 
 // Represents a single peer connected to the server.
 class ChannelMember {
@@ -53,7 +54,8 @@ class ChannelMember {
 
   std::string GetPeerIdHeader() const;
 
-  bool NotifyOfOtherMember(const ChannelMember& other);
+  // Queues |notification|, which describes another member, for this one.
+  bool NotifyOfOtherMember(const PreparedResponsePtr& notification);
 
   // Returns a string in the form "name,id\n".
   std::string GetEntry() const;
@@ -62,14 +64,19 @@ class ChannelMember {
 
   void OnClosing(DataSocket* ds);
 
-  void QueueResponse(const std::string& status, const std::string& content_type,
-                     const std::string& extra_headers, const std::string& data);
+  // Sends |response| on the waiting socket, or queues it until the member
+  // comes back with one. The peer id header names |peer_id|, or is left out
+  // if it is 0.
+  void QueueResponse(const PreparedResponsePtr& response, int peer_id);
 
   void SetWaitingSocket(DataSocket* ds);
 
  protected:
   struct QueuedResponse {
-    std::string status, content_type, extra_headers, data;
+    QueuedResponse(const PreparedResponsePtr& response, int peer_id)
+        : response(response), peer_id(peer_id) {}
+    PreparedResponsePtr response;
+    int peer_id;
   };
 
   DataSocket* waiting_socket_;
@@ -84,7 +91,9 @@ class ChannelMember {
 // Manages all currently connected peers.
 class PeerChannel {
  public:
-  typedef std::vector<ChannelMember*> Members;
+  // Members are found by id for every request, so they are hashed.
+  typedef std::unordered_map<int, ChannelMember*> Members;
+  typedef std::vector<ChannelMember*> MemberList;
 
   PeerChannel() {
   }
@@ -123,13 +132,16 @@ class PeerChannel {
  protected:
   void DeleteAll();
   void BroadcastChangedState(const ChannelMember& member,
-                             Members* delivery_failures);
-  void HandleDeliveryFailures(Members* failures);
+                             MemberList* delivery_failures);
+  void HandleDeliveryFailures(MemberList* failures);
 
   // Builds a simple list of "name,id\n" entries for each member.
   std::string BuildResponseForNewMember(const ChannelMember& member,
                                         std::string* content_type);
 
+  // Returns the "peer_id" argument of the request, or 0 if there is none.
+  static int GetPeerId(const DataSocket* ds);
+
  protected:
   Members members_;
 };
@@ -40,6 +40,10 @@
 
 #include "base/timing.h"
 
+namespace cricket {
+class BaseChannel;
+}  // namespace cricket
+
 namespace webrtc {
 
 class StatsCollector {
@@ -74,12 +78,15 @@ class StatsCollector {
 
   void ExtractVoiceInfo();
   void ExtractVideoInfo();
+  void ExtractChannelInfo(cricket::BaseChannel* channel);
   double GetTimeNow();
 
   // |track_reports_| contain the last gathered stats for all tracks.
   // The reason for this is so that GetStats can return statistics about a track
   // even if it no longer is active.
   std::map<std::string, webrtc::StatsReport> track_reports_;
+  // Per-channel packet counters, keyed by content name.
+  std::map<std::string, webrtc::StatsReport> channel_reports_;
   // Raw pointer to the session the statistics are gathered from.
   WebRtcSession* session_;
   double stats_gathering_started_;
@@ -40,18 +40,40 @@
 namespace webrtc {
 
 // StatsElement contains a time stamped list of name/value pairs.
+// Value names are interned: every name is one of the kStatsValueName*
+// constants below or a pointer returned by InternName(), so two values with
+// the same name always share a |name| pointer and can be matched without a
+// string compare.
 class StatsElement {
  public:
   struct Value {
-    std::string name;
+    Value() : name(NULL), int_value(0), has_int_value(false) {}
+
+    const char* name;
     std::string value;
+    // Integer values are kept in typed form as well; |value| holds the same
+    // number in decimal for consumers that only look at strings.
+    int64 int_value;
+    bool has_int_value;
   };
 
   StatsElement() : timestamp(0) { }
 
+  // |name| must already be interned.
+  void AddValue(const char* name, const std::string& value);
+  void AddValue(const char* name, int64 value);
+  // Arbitrary names are interned first.
   void AddValue(const std::string& name, const std::string& value);
   void AddValue(const std::string& name, int64 value);
 
+  // Returns the value with the interned |name|, or NULL.
+  const Value* FindValue(const char* name) const;
+
+  // Returns the canonical pointer for |name|. Known names map to their
+  // kStatsValueName* constant; others are added to a process-wide table
+  // that lives as long as the process.
+  static const char* InternName(const std::string& name);
+
   double timestamp;  // Time since 1970-01-01T00:00:00Z in milliseconds.
   typedef std::vector<Value> Values;
   Values values;
@@ -78,6 +100,9 @@ class StatsElement {
   static const char kStatsValueNameNacksReceived[];
   static const char kStatsValueNameNacksSent[];
   static const char kStatsValueNameRtt[];
+  static const char kStatsValueNameRtcpPacketsSent[];
+  static const char kStatsValueNameRtcpPacketsReceived[];
+  static const char kStatsValueNamePacketsDiscarded[];
 };
 
 // StatsReport contains local and remote StatsElements that pertain to the same
@@ -91,6 +116,9 @@ struct StatsReport {
   // StatsReport of |type| = "ssrc" is statistics for a specific rtp stream.
   // The |id| field is the SSRC in decimal form of the rtp stream.
   static const char kStatsReportTypeSsrc[];
+  // StatsReport of |type| = "googChannel" holds the packet counters of a
+  // whole media channel. The |id| field is the channel's content name.
+  static const char kStatsReportTypeChannel[];
 };
 
 typedef std::vector<StatsReport> StatsReports;
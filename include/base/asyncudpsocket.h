@@ -47,6 +47,12 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   // asynchronous socket from the given factory.
   static AsyncUDPSocket* Create(SocketFactory* factory,
                                 const SocketAddress& bind_address);
+  // Like Create(), but sets Socket::OPT_REUSEPORT before binding so that
+  // several sockets, typically one per thread, can share |bind_address| and
+  // have the kernel spread incoming datagrams between them. Returns NULL if
+  // the option is not supported.
+  static AsyncUDPSocket* CreateShared(SocketFactory* factory,
+                                      const SocketAddress& bind_address);
   explicit AsyncUDPSocket(AsyncSocket* socket);
   virtual ~AsyncUDPSocket();
 
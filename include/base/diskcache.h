@@ -28,8 +28,9 @@
 #ifndef TALK_BASE_DISKCACHE_H__
 #define TALK_BASE_DISKCACHE_H__
 
-#include <map>
+#include <list>
 #include <string>
+#include <unordered_map>
 
 #ifdef WIN32
 #undef UnlockResource
@@ -49,6 +50,11 @@ class StreamInterface;
 // DiskCache is designed to persist across executions of the program.  It is
 // safe for use from an arbitrary number of users on a single thread, but not
 // from multiple threads or other processes.
+//
+// Entries are kept in least-recently-used order, so eviction does not scan
+// the whole cache.  On a clean shutdown the entries are saved to an index file
+// in the cache folder, which lets the next Initialize skip rescanning the
+// folder.  Reads are served from a memory-mapped view of the file.
 ///////////////////////////////////////////////////////////////////////////////
 
 class DiskCache {
@@ -77,18 +83,34 @@ public:
   virtual bool DeleteFile(const std::string& filename) const = 0;
 
   enum LockState { LS_UNLOCKED, LS_LOCKED, LS_UNLOCKING };
+  // Resource ids, least recently used first.
+  typedef std::list<std::string> LruList;
   struct Entry {
     LockState lock_state;
     mutable size_t accessors;
     size_t size;
     size_t streams;
     time_t last_modified;
+    LruList::iterator lru_position;
   };
-  typedef std::map<std::string, Entry> EntryMap;
+  typedef std::unordered_map<std::string, Entry> EntryMap;
   friend class DiskCacheAdapter;
 
   bool CheckLimit();
 
+  // Moves |entry| to the most recently used end of the list.
+  void TouchEntry(const Entry* entry) const;
+  // Orders the list by last_modified, for entries found by
+  // InitializeEntries.
+  void SortEntriesByLastModified();
+
+  std::string IndexFilename() const;
+  // Loads the index written at the last clean shutdown, and removes it so a
+  // crash before the next save causes a rescan. Returns false if there is no
+  // usable index.
+  bool LoadIndex();
+  bool SaveIndex() const;
+
   std::string IdToFilename(const std::string& id, size_t index) const;
   bool FilenameToId(const std::string& filename, std::string* id,
                     size_t* index) const;
@@ -103,6 +125,7 @@ public:
   std::string folder_;
   size_t max_cache_, total_size_;
   EntryMap map_;
+  mutable LruList lru_;
   mutable size_t total_accessors_;
 };
 
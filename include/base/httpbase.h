@@ -33,6 +33,7 @@
 #define TALK_BASE_HTTPBASE_H__
 
 #include "base/httpcommon.h"
+#include "base/messagehandler.h"
 
 namespace talk_base {
 
@@ -43,6 +44,8 @@ class StreamInterface;
 // generates events for:
 //  Structural Elements: Leader, Headers, Document Data
 //  Events: End of Headers, End of Document, Errors
+// Lines are parsed in place in the caller's buffer.  A partial line is not
+// searched again from its start when more data arrives.
 ///////////////////////////////////////////////////////////////////////////////
 
 class HttpParser {
@@ -82,6 +85,9 @@ private:
   } state_;
   bool chunked_;
   size_t data_size_;
+  // Bytes of the partial line at the start of the next buffer which have
+  // already been searched for its end.
+  size_t line_scanned_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -106,10 +112,15 @@ public:
 // moving data from the HTTP stream to the HttpData object and vice versa.
 // However, it can also operate in stream mode, in which case the user of the
 // stream interface drives I/O via calls to Read().
+// Received data is kept across transactions, so requests pipelined behind the
+// current one are not lost while its response is sent.  A document which
+// exposes a file descriptor is sent with StreamInterface::SendFile when the
+// HTTP stream supports it.
 ///////////////////////////////////////////////////////////////////////////////
 
 class HttpBase
 : private HttpParser,
+  public MessageHandler,
   public sigslot::has_slots<>
 {
 public:
@@ -159,8 +170,14 @@ protected:
   void read_and_process_data();
   void flush_data();
   bool queue_headers();
+  // Sends the document with SendFile.  Returns false when flush_data should
+  // stop, because the stream blocked or the send completed.
+  bool send_file_data();
   void do_complete(HttpError err = HE_NONE);
 
+  // MessageHandler Interface
+  virtual void OnMessage(Message* msg);
+
   void OnHttpStreamEvent(StreamInterface* stream, int events, int error);
   void OnDocumentEvent(StreamInterface* stream, int events, int error);
 
@@ -187,10 +204,14 @@ private:
   IHttpNotify* notify_;
   StreamInterface* http_stream_;
   DocumentStream* doc_stream_;
+  // Outgoing data.
   char buffer_[kBufferSize];
   size_t len_;
+  // Received data not yet parsed starts recv_pos_ bytes into recv_buffer_.
+  char recv_buffer_[kBufferSize];
+  size_t recv_pos_, recv_len_;
 
-  bool ignore_data_, chunk_data_;
+  bool ignore_data_, chunk_data_, send_file_;
   HttpData::const_iterator header_;
 };
 
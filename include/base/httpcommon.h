@@ -313,6 +313,9 @@ struct HttpData {
                         bool overwrite = true) {
     changeHeader(name, value, overwrite ? HC_REPLACE : HC_NEW);
   }
+  // Same as addHeader(name, value), for a header parsed in place.
+  void addHeader(const char* name, size_t nlen,
+                 const char* value, size_t vlen);
   // Returns count of erased headers
   size_t clearHeader(const std::string& name);
   // Returns iterator to next header
@@ -0,0 +1,100 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_BASE_MAPPEDFILE_H_
+#define TALK_BASE_MAPPEDFILE_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "base/scoped_ptr.h"
+#include "base/stream.h"
+
+namespace talk_base {
+
+// Read-only view of a whole file. On POSIX systems the file is mapped into
+// memory with mmap(), so pages are only read when they are touched and are
+// shared with the page cache. Elsewhere the file is read into a heap buffer,
+// which gives the same interface at the cost of one copy.
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  // Maps |filename|. Any previously mapped file is released first. Returns
+  // false if the file cannot be opened or mapped; an empty file maps
+  // successfully with a NULL data() and size() of zero.
+  bool Open(const std::string& filename);
+  void Close();
+
+  bool is_open() const { return open_; }
+  const uint8* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  bool open_;
+  const uint8* data_;
+  size_t size_;
+  // Holds the file contents when mmap() is not available.
+  scoped_array<uint8> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+// Read-only stream over a MappedFile. GetReadData() hands out the mapping
+// itself, so callers that use it never copy the contents. Writes fail.
+class MappedFileStream : public StreamInterface {
+ public:
+  MappedFileStream();
+  virtual ~MappedFileStream();
+
+  bool Open(const std::string& filename);
+
+  virtual StreamState GetState() const;
+  virtual StreamResult Read(void* buffer, size_t buffer_len,
+                            size_t* read, int* error);
+  virtual StreamResult Write(const void* data, size_t data_len,
+                             size_t* written, int* error);
+  virtual void Close();
+  virtual const void* GetReadData(size_t* data_len);
+  virtual void ConsumeReadData(size_t used);
+  virtual bool SetPosition(size_t position);
+  virtual bool GetPosition(size_t* position) const;
+  virtual bool GetSize(size_t* size) const;
+  virtual bool GetAvailable(size_t* size) const;
+
+ private:
+  MappedFile file_;
+  size_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFileStream);
+};
+
+}  // namespace talk_base
+
+#endif  // TALK_BASE_MAPPEDFILE_H_
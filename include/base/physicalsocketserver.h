@@ -28,6 +28,8 @@
 #ifndef TALK_BASE_PHYSICALSOCKETSERVER_H__
 #define TALK_BASE_PHYSICALSOCKETSERVER_H__
 
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "base/asyncfile.h"
@@ -93,6 +95,18 @@ class PhysicalSocketServer : public SocketServer {
 
   void Add(Dispatcher* dispatcher);
   void Remove(Dispatcher* dispatcher);
+  // Dispatchers call this when their requested events change, so that only
+  // the ones that changed are looked at again before the next wait.
+  void Update(Dispatcher* dispatcher);
+
+#ifdef LINUX
+  // Switches Wait() from select() to epoll. There is no FD_SETSIZE limit on
+  // the descriptors that can be waited on, and a wakeup only visits the
+  // dispatchers that are actually ready. Returns false, leaving select() in
+  // use, if an epoll instance can't be created.
+  bool EnableEpoll();
+  bool epoll_enabled() const { return epoll_fd_ != -1; }
+#endif
 
 #ifdef POSIX
   AsyncFile* CreateFile(int fd);
@@ -121,6 +135,25 @@ class PhysicalSocketServer : public SocketServer {
   static bool InstallSignal(int signum, void (*handler)(int));
 
   scoped_ptr<PosixSignalDispatcher> signal_dispatcher_;
+#endif
+#ifdef LINUX
+  // What a dispatcher is registered for in the epoll set. |events| is in
+  // epoll terms; 0 means the descriptor is not in the set.
+  struct EpollEntry {
+    EpollEntry() : fd(-1), events(0) {}
+    int fd;
+    uint32 events;
+  };
+  typedef std::unordered_map<Dispatcher*, EpollEntry> EpollMap;
+  typedef std::unordered_set<Dispatcher*> DispatcherSet;
+
+  bool WaitEpoll(int cms, bool process_io);
+  void UpdateEpoll(Dispatcher* dispatcher);
+
+  int epoll_fd_;
+  EpollMap epoll_entries_;
+  // Dispatchers whose registration may be out of date.
+  DispatcherSet epoll_dirty_;
 #endif
   DispatcherList dispatchers_;
   IteratorList iterators_;
@@ -0,0 +1,61 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_BASE_SIMULATEDCLOCK_H_
+#define TALK_BASE_SIMULATEDCLOCK_H_
+
+#include <atomic>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "base/timeutils.h"
+
+namespace talk_base {
+
+// A clock that only moves when told to. Install it with SetClock() to make
+// Time(), delayed messages and anything else built on them follow simulated
+// time.
+class SimulatedClock : public ClockInterface {
+ public:
+  explicit SimulatedClock(uint64 start_nanos) : now_nanos_(start_nanos) {}
+
+  virtual uint64 TimeNanos() const { return now_nanos_; }
+
+  void AdvanceTimeNanos(uint64 nanos) { now_nanos_ += nanos; }
+  void AdvanceTime(uint32 ms) {
+    AdvanceTimeNanos(static_cast<uint64>(ms) * kNumNanosecsPerMillisec);
+  }
+
+ private:
+  std::atomic<uint64> now_nanos_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedClock);
+};
+
+}  // namespace talk_base
+
+#endif  // TALK_BASE_SIMULATEDCLOCK_H_
@@ -167,6 +167,15 @@ class Socket {
   virtual void SetError(int error) = 0;
   inline bool IsBlocking() const { return IsBlockingError(GetError()); }
 
+  // Sends up to |length| bytes of the open file |fd|, starting at |offset|,
+  // without copying them through user space.  Returns the number of bytes
+  // sent, or -1 with the error set as for Send.  Sockets that can't do this
+  // fail with EOPNOTSUPP, and the caller should Send the data itself.
+  virtual int SendFile(int fd, size_t offset, size_t length) {
+    SetError(EOPNOTSUPP);
+    return -1;
+  }
+
   enum ConnState {
     CS_CLOSED,
     CS_CONNECTING,
@@ -184,7 +193,11 @@ class Socket {
     OPT_RCVBUF,      // receive buffer size
     OPT_SNDBUF,      // send buffer size
     OPT_NODELAY,     // whether Nagle algorithm is enabled
-    OPT_IPV6_V6ONLY  // Whether the socket is IPv6 only.
+    OPT_IPV6_V6ONLY,  // Whether the socket is IPv6 only.
+    OPT_REUSEPORT,   // Lets several sockets bind the same address and port;
+                     // must be set before Bind().
+    OPT_REUSEADDR    // Lets a listener bind while old connections to its
+                     // address linger in TIME_WAIT; set before Bind().
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
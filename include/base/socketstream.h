@@ -54,6 +54,9 @@ class SocketStream : public StreamInterface, public sigslot::has_slots<> {
   virtual StreamResult Write(const void* data, size_t data_len,
                              size_t* written, int* error);
 
+  virtual StreamResult SendFile(int fd, size_t offset, size_t length,
+                                size_t* written, int* error);
+
   virtual void Close();
 
  private:
@@ -177,6 +177,24 @@ class StreamInterface : public MessageHandler {
   //  return false;
   //}
 
+  // The following two methods let file data be written to a stream without
+  // being read into memory first.
+
+  // GetFileDescriptor returns the descriptor of the file behind a readable
+  // stream.  Callers that read through it directly, instead of with Read, must
+  // advance the stream with SetPosition.  Returns false if the stream is not
+  // backed by a file.
+  virtual bool GetFileDescriptor(int* fd) const { return false; }
+
+  // SendFile writes up to length bytes of the file fd, starting at offset,
+  // like Write does with a buffer.  Streams which can't do this without a copy
+  // return SR_ERROR, and the caller should fall back to Write.
+  virtual StreamResult SendFile(int fd, size_t offset, size_t length,
+                                size_t* written, int* error) {
+    if (error) *error = -1;
+    return SR_ERROR;
+  }
+
   // Seek to a byte offset from the beginning of the stream.  Returns false if
   // the stream does not support seeking, or cannot seek to the specified
   // position.
@@ -450,6 +468,8 @@ class FileStream : public StreamInterface {
   virtual bool Flush();
 
 #if defined(POSIX)
+  virtual bool GetFileDescriptor(int* fd) const;
+
   // Tries to aquire an exclusive lock on the file.
   // Use OpenShare(...) on win32 to get similar functionality.
   bool TryLock();
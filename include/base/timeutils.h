@@ -44,13 +44,32 @@ static const int64 kNumMicrosecsPerMillisec = kNumMicrosecsPerSec /
     kNumMillisecsPerSec;
 static const int64 kNumNanosecsPerMillisec =  kNumNanosecsPerSec /
     kNumMillisecsPerSec;
+static const int64 kNumNanosecsPerMicrosec = kNumNanosecsPerSec /
+    kNumMicrosecsPerSec;
 
 typedef uint32 TimeStamp;
 
+// A source of time for Time() and TimeNanos(). Simulations install one to run
+// the message loop and the network on simulated rather than wall-clock time.
+class ClockInterface {
+ public:
+  virtual ~ClockInterface() {}
+  virtual uint64 TimeNanos() const = 0;
+};
+
+// Makes |clock| the source of time for the whole process, or restores the
+// system clock if |clock| is NULL. Returns the previously installed clock.
+// The clock is read without locking, so it should be installed before other
+// threads that read the time are started.
+ClockInterface* SetClock(ClockInterface* clock);
+
 // Returns the current time in milliseconds.
 uint32 Time();
 // Returns the current time in nanoseconds.
 uint64 TimeNanos();
+// Returns the monotonic system time in nanoseconds, ignoring any installed
+// clock.
+uint64 SystemTimeNanos();
 
 // Returns a future timestamp, 'elapsed' milliseconds from now.
 uint32 TimeAfter(int32 elapsed);
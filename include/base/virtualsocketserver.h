@@ -33,6 +33,8 @@
 #include <map>
 
 #include "base/messagequeue.h"
+#include "base/scoped_ptr.h"
+#include "base/simulatedclock.h"
 #include "base/socketserver.h"
 
 namespace talk_base {
@@ -103,6 +105,20 @@ class VirtualSocketServer : public SocketServer, public sigslot::has_slots<> {
     drop_prob_ = drop_prob;
   }
 
+  // Runs on simulated instead of wall-clock time. While enabled, Time(),
+  // delayed messages and network delays follow a SimulatedClock that starts
+  // at the current time, and Wait() advances it straight to the next pending
+  // event instead of sleeping; only an indefinite Wait() blocks in real time.
+  // Simulations then run as fast as their events can be processed, and
+  // deterministically given a fixed seed for rand(). The clock is installed
+  // process-wide, so this is meant for simulations where every thread
+  // reading the time uses this server. Disabling it returns to wall-clock
+  // time, which is normally behind the simulated time.
+  void SetVirtualTime(bool enable);
+  bool virtual_time() const { return clock_.get() != NULL; }
+  // Moves the simulated clock forward. Only valid with virtual time enabled.
+  void AdvanceTime(uint32 ms);
+
   // SocketFactory:
   virtual Socket* CreateSocket(int type);
   virtual Socket* CreateSocket(int family, int type);
@@ -242,6 +258,15 @@ class VirtualSocketServer : public SocketServer, public sigslot::has_slots<> {
   CriticalSection delay_crit_;
 
   double drop_prob_;
+
+  // Non-NULL while running on virtual time.
+  scoped_ptr<SimulatedClock> clock_;
+  ClockInterface* prev_clock_;
+  // Set by WakeUp(), so that a virtual-time Wait() that was woken up doesn't
+  // advance the clock past the work that woke it.
+  bool wakeup_pending_;
+  CriticalSection wakeup_crit_;
+
   DISALLOW_EVIL_CONSTRUCTORS(VirtualSocketServer);
 };
 
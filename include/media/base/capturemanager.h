@@ -100,6 +100,12 @@ class CaptureManager : public sigslot::has_slots<> {
 
   virtual bool AddVideoRenderer(VideoCapturer* video_capturer,
                                 VideoRenderer* video_renderer);
+  // Feeds |video_renderer| frames scaled to |width| x |height|. Each size is
+  // scaled once per frame however many renderers and send channels of the
+  // capturer ask for it.
+  virtual bool AddVideoRenderer(VideoCapturer* video_capturer,
+                                VideoRenderer* video_renderer,
+                                int width, int height);
   virtual bool RemoveVideoRenderer(VideoCapturer* video_capturer,
                                    VideoRenderer* video_renderer);
 
@@ -52,17 +52,25 @@ class CaptureRenderAdapter : public sigslot::has_slots<> {
   ~CaptureRenderAdapter();
 
   bool AddRenderer(VideoRenderer* video_renderer);
+  // Adds a renderer that is fed frames scaled to |width| x |height|. Renderers
+  // asking for the same size share one scaled frame.
+  bool AddRenderer(VideoRenderer* video_renderer, int width, int height);
   bool RemoveRenderer(VideoRenderer* video_renderer);
 
   VideoCapturer* video_capturer() { return video_capturer_; }
  private:
   struct VideoRendererInfo {
-    explicit VideoRendererInfo(VideoRenderer* r)
+    VideoRendererInfo(VideoRenderer* r, int width, int height)
         : renderer(r),
+          desired_width(width),
+          desired_height(height),
           render_width(0),
           render_height(0) {
     }
     VideoRenderer* renderer;
+    // Size the renderer asked for, or 0x0 for the captured size.
+    size_t desired_width;
+    size_t desired_height;
     size_t render_width;
     size_t render_height;
   };
@@ -76,7 +84,7 @@ class CaptureRenderAdapter : public sigslot::has_slots<> {
   // Callback for frames received from the capturer.
   void OnVideoFrame(VideoCapturer* capturer, const VideoFrame* video_frame);
 
-  void MaybeSetRenderingSize(const VideoFrame* frame);
+  void MaybeSetRenderingSize(VideoRendererInfo* info, const VideoFrame* frame);
 
   bool IsRendererRegistered(const VideoRenderer& video_renderer) const;
 
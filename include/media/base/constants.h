@@ -85,6 +85,10 @@ extern const char* kCodecParamMaxBitrate;
 extern const char* kCodecParamMinBitrate;
 extern const char* kCodecParamMaxQuantization;
 
+// Extension header for audio levels, as defined in
+// http://tools.ietf.org/html/draft-ietf-avtext-client-to-mixer-audio-level-03
+extern const char* kRtpAudioLevelHeaderExtension;
+
 }  // namespace cricket
 
 #endif  // TALK_MEDIA_BASE_CONSTANTS_H_
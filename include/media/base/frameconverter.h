@@ -0,0 +1,170 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_MEDIA_BASE_FRAMECONVERTER_H_
+#define TALK_MEDIA_BASE_FRAMECONVERTER_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/criticalsection.h"
+#include "base/event.h"
+#include "base/messagehandler.h"
+
+namespace talk_base {
+class Thread;
+}
+
+namespace cricket {
+
+struct CapturedFrame;
+
+// FrameConverter turns a captured frame into an I420 frame at its final size
+// in one pass. Rather than converting the whole cropped frame to I420 and then
+// scaling that, it converts a block of source rows into a small scratch buffer
+// and scales the block into the output while it is still in cache. The blocks
+// are shared out as horizontal stripes between the calling thread and a small
+// pool of worker threads.
+//
+// Blocks are only used where they give the same result as scaling the whole
+// frame: uncompressed, unrotated, upright sources that are kept at their
+// height, box-filtered down to less than half of it, or scaled by 1/2 or 3/4,
+// with blocks starting on exact source/output row pairs. Anything else (MJPG,
+// rotated or bottom-up frames, upscales, downscales by less than 2x, or
+// scales with no exact row pair inside the frame) is converted whole on the
+// calling thread.
+//
+// Convert() must not be called concurrently; GetStats() may be called from any
+// thread.
+class FrameConverter : public talk_base::MessageHandler {
+ public:
+  // Time spent in each stage. convert_time_ns and scale_time_ns are summed
+  // over all threads; total_time_ns is the wall-clock time of Convert().
+  struct Stats {
+    Stats()
+        : frames(0),
+          striped_frames(0),
+          convert_time_ns(0),
+          scale_time_ns(0),
+          total_time_ns(0) {
+    }
+    int frames;             // Frames converted.
+    int striped_frames;     // Frames split between more than one thread.
+    int64 convert_time_ns;  // Time converting source rows to I420.
+    int64 scale_time_ns;    // Time scaling I420 to the output size.
+    int64 total_time_ns;
+  };
+
+  // |num_workers| threads, in addition to the caller, are started the first
+  // time a frame is large enough to be worth splitting.
+  explicit FrameConverter(int num_workers);
+  virtual ~FrameConverter();
+
+  // Returns a worker count suited to the number of CPUs on this machine.
+  static int DefaultNumWorkers();
+
+  int num_workers() const { return num_workers_; }
+
+  // Converts the centred |crop_width| x |crop_height| region of |frame| to
+  // I420 at |width| x |height| and writes it to the given planes. The crop
+  // size is in the orientation of the sample and the output size in the
+  // orientation after rotation. Returns false if the sample can't be
+  // converted.
+  bool Convert(const CapturedFrame* frame, int crop_width, int crop_height,
+               uint8* y, int y_pitch, uint8* u, int u_pitch,
+               uint8* v, int v_pitch, int width, int height);
+
+  Stats GetStats() const;
+  void ResetStats();
+
+ private:
+  // A run of consecutive blocks handled by one thread, and its scratch space.
+  struct Stripe {
+    Stripe()
+        : first_block(0),
+          end_block(0),
+          convert_time_ns(0),
+          scale_time_ns(0),
+          ok(true) {
+    }
+    size_t first_block;
+    size_t end_block;
+    std::vector<uint8> scratch;
+    int64 convert_time_ns;
+    int64 scale_time_ns;
+    bool ok;
+  };
+
+  virtual void OnMessage(talk_base::Message* msg);
+
+  bool ConvertInBlocks(int* num_stripes, int64* convert_time_ns,
+                       int64* scale_time_ns);
+  bool ConvertWhole(int crop_height, int rotation, int64* convert_time_ns,
+                    int64* scale_time_ns);
+  void ConvertStripe(Stripe* stripe);
+  bool ConvertBlock(Stripe* stripe, size_t block);
+  void StartWorkers();
+
+  const int num_workers_;
+  std::vector<talk_base::Thread*> workers_;
+  std::vector<Stripe> stripes_;
+  std::vector<uint8> whole_scratch_;
+
+  // The conversion in progress. Set by Convert() before any stripe is handed
+  // out and read-only while the workers run.
+  const uint8* sample_;
+  size_t sample_size_;
+  uint32 fourcc_;
+  int src_width_;
+  int src_height_;
+  int crop_x_;
+  int crop_y_;
+  int crop_width_;
+  uint8* dst_y_;
+  uint8* dst_u_;
+  uint8* dst_v_;
+  int dst_y_pitch_;
+  int dst_u_pitch_;
+  int dst_v_pitch_;
+  int dst_width_;
+  int dst_height_;
+  // Block boundaries: block i covers output rows [dst_rows_[i],
+  // dst_rows_[i + 1]) and cropped source rows [src_rows_[i], src_rows_[i + 1]).
+  std::vector<int> dst_rows_;
+  std::vector<int> src_rows_;
+
+  mutable talk_base::CriticalSection crit_;
+  int pending_stripes_;
+  talk_base::Event stripes_done_;
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameConverter);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_MEDIA_BASE_FRAMECONVERTER_H_
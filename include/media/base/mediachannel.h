@@ -205,6 +205,14 @@ struct AudioOptions {
   Settable<int> adjust_agc_delta;
 };
 
+// Trades encoder speed for quality. Slower presets spend more cpu per frame.
+enum VideoEncoderPreset {
+  VIDEO_PRESET_FASTEST,
+  VIDEO_PRESET_FAST,
+  VIDEO_PRESET_QUALITY,
+  VIDEO_PRESET_BEST_QUALITY
+};
+
 // Options that can be applied to a VideoMediaChannel or a VideoMediaEngine.
 // Used to be flags, but that makes it hard to selectively apply options.
 // We are moving all of the setting of options to structs like this,
@@ -229,6 +237,9 @@ struct VideoOptions {
     system_high_adaptation_threshhold.SetFrom(
         change.system_high_adaptation_threshhold);
     buffered_mode_latency.SetFrom(change.buffered_mode_latency);
+    video_encoder_threads.SetFrom(change.video_encoder_threads);
+    video_token_partitions.SetFrom(change.video_token_partitions);
+    video_encoder_preset.SetFrom(change.video_encoder_preset);
   }
 
   bool operator==(const VideoOptions& o) const {
@@ -243,7 +254,10 @@ struct VideoOptions {
             o.system_low_adaptation_threshhold &&
         system_high_adaptation_threshhold ==
             o.system_high_adaptation_threshhold &&
-        buffered_mode_latency == o.buffered_mode_latency;
+        buffered_mode_latency == o.buffered_mode_latency &&
+        video_encoder_threads == o.video_encoder_threads &&
+        video_token_partitions == o.video_token_partitions &&
+        video_encoder_preset == o.video_encoder_preset;
   }
 
   virtual std::string ToString() const {
@@ -259,6 +273,9 @@ struct VideoOptions {
     ost << ToStringIfSet("low", system_low_adaptation_threshhold);
     ost << ToStringIfSet("high", system_high_adaptation_threshhold);
     ost << ToStringIfSet("buffered mode latency", buffered_mode_latency);
+    ost << ToStringIfSet("encoder threads", video_encoder_threads);
+    ost << ToStringIfSet("token partitions", video_token_partitions);
+    ost << ToStringIfSet("encoder preset", video_encoder_preset);
     ost << "}";
     return ost.str();
   }
@@ -283,6 +300,13 @@ struct VideoOptions {
   SettablePercent system_high_adaptation_threshhold;
   // Specify buffered mode latency in milliseconds.
   Settable<int> buffered_mode_latency;
+  // Number of encoder threads. Unset or 0 scales with cores and resolution.
+  Settable<int> video_encoder_threads;
+  // Number of VP8 token partitions (1, 2, 4 or 8). Unset or 0 uses one per
+  // encoder thread.
+  Settable<int> video_token_partitions;
+  // Encoder speed/quality trade-off, one of VideoEncoderPreset.
+  Settable<int> video_encoder_preset;
 };
 
 // A class for playing out soundclips.
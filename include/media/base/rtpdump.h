@@ -34,6 +34,7 @@
 
 #include "base/basictypes.h"
 #include "base/bytebuffer.h"
+#include "base/mappedfile.h"
 #include "base/stream.h"
 
 namespace cricket {
@@ -101,6 +102,23 @@ struct RtpDumpPacket {
                              // packet was recorded.
 };
 
+// An RTP or RTCP packet inside an rtpdump file, referenced in place. The view
+// is only valid while the memory it points into is.
+struct RtpDumpPacketView {
+  RtpDumpPacketView()
+      : data(NULL), size(0), original_data_len(0), elapsed_time(0) {
+  }
+
+  bool is_rtcp() const { return original_data_len == 0; }
+  bool IsValidRtpPacket() const;
+  bool IsValidRtcpPacket() const;
+
+  const uint8* data;         // The recorded RTP or RTCP packet.
+  size_t size;               // Number of bytes recorded at |data|.
+  size_t original_data_len;  // See RtpDumpPacket::original_data_len.
+  uint32 elapsed_time;       // Milliseconds since the start of recording.
+};
+
 class RtpDumpReader {
  public:
   explicit RtpDumpReader(talk_base::StreamInterface* stream)
@@ -135,6 +153,41 @@ class RtpDumpReader {
   DISALLOW_COPY_AND_ASSIGN(RtpDumpReader);
 };
 
+// Reads an rtpdump file in place, either from a memory-mapped file or from a
+// caller-owned buffer. Unlike RtpDumpReader, ReadPacket() neither copies nor
+// allocates: the returned views point into the mapping and remain valid until
+// the reader is closed, reopened or destroyed.
+class RtpDumpMappedReader {
+ public:
+  RtpDumpMappedReader();
+
+  // Maps |filename| and validates its file header.
+  bool Open(const std::string& filename);
+  // Reads from |data|, which must outlive the reader.
+  bool Init(const void* data, size_t size);
+  void Close();
+
+  // Returns SR_EOS after the last packet and SR_ERROR on a truncated or
+  // malformed record.
+  talk_base::StreamResult ReadPacket(RtpDumpPacketView* packet);
+  // Positions the reader at the first packet again.
+  void Rewind() { pos_ = first_packet_pos_; }
+
+  uint32 start_time_ms() const { return start_time_ms_; }
+
+ private:
+  bool ReadFileHeader();
+
+  talk_base::MappedFile file_;
+  const uint8* data_;
+  size_t size_;
+  size_t first_packet_pos_;
+  size_t pos_;
+  uint32 start_time_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(RtpDumpMappedReader);
+};
+
 // RtpDumpLoopReader reads RTP dump packets from the input stream and rewinds
 // the stream when it ends. RtpDumpLoopReader maintains the elapsed time, the
 // RTP sequence number and the RTP timestamp properly. RtpDumpLoopReader can
@@ -201,6 +254,10 @@ class RtpDumpWriter {
     return WritePacket(&packet.data[0], packet.data.size(), packet.elapsed_time,
                        packet.is_rtcp());
   }
+  // Write a packet stamped with |elapsed| instead of the current time, for
+  // callers that queue packets and write them later.
+  talk_base::StreamResult WritePacket(const void* data, size_t data_len,
+                                      uint32 elapsed, bool rtcp);
   uint32 GetElapsedTime() const;
 
   bool GetDumpSize(size_t* size) {
@@ -213,8 +270,6 @@ class RtpDumpWriter {
   talk_base::StreamResult WriteFileHeader();
 
  private:
-  talk_base::StreamResult WritePacket(const void* data, size_t data_len,
-                                      uint32 elapsed, bool rtcp);
   size_t FilterPacket(const void* data, size_t data_len, bool rtcp);
   talk_base::StreamResult WriteToStream(const void* data, size_t data_len);
 
@@ -0,0 +1,191 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// RtpReplayEngine replays rtpdump recordings as a load generator. A single
+// thread drives any number of streams, each replaying a shared recording with
+// its own SSRC. Streams are kept on a timer wheel with one millisecond ticks,
+// so the cost of each tick is proportional to the packets that are due rather
+// than to the number of streams.
+
+#ifndef TALK_MEDIA_BASE_RTPREPLAY_H_
+#define TALK_MEDIA_BASE_RTPREPLAY_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/criticalsection.h"
+#include "base/event.h"
+#include "base/scoped_ptr.h"
+#include "base/thread.h"
+#include "media/base/rtpdump.h"
+
+namespace cricket {
+
+// A parsed rtpdump recording that any number of replay streams can share. The
+// packet index references the mapped file; packet data is never copied.
+class RtpReplaySource {
+ public:
+  RtpReplaySource();
+
+  // Maps and indexes |filename|.
+  bool Open(const std::string& filename);
+  // Indexes an rtpdump image in |data|, which must outlive the source.
+  bool Init(const void* data, size_t size);
+
+  size_t packet_count() const { return packets_.size(); }
+  const RtpDumpPacketView& packet(size_t index) const {
+    return packets_[index];
+  }
+  // Elapsed time of the first packet; replay starts there.
+  uint32 first_elapsed_time() const { return first_elapsed_time_; }
+  // How much to advance the elapsed time, RTP sequence number and RTP
+  // timestamp on each loop, computed the same way as RtpDumpLoopReader.
+  uint32 elapsed_time_increase() const { return elapsed_time_increase_; }
+  int rtp_seq_num_increase() const { return rtp_seq_num_increase_; }
+  uint32 rtp_timestamp_increase() const { return rtp_timestamp_increase_; }
+
+ private:
+  bool BuildIndex();
+
+  RtpDumpMappedReader reader_;
+  std::vector<RtpDumpPacketView> packets_;
+  uint32 first_elapsed_time_;
+  uint32 elapsed_time_increase_;
+  int rtp_seq_num_increase_;
+  uint32 rtp_timestamp_increase_;
+
+  DISALLOW_COPY_AND_ASSIGN(RtpReplaySource);
+};
+
+// Receives the replayed packets, on the engine's thread.
+class RtpReplaySink {
+ public:
+  virtual ~RtpReplaySink() {}
+  // |stream| is the id returned by RtpReplayEngine::AddStream(). |data| is
+  // only valid for the duration of the call.
+  virtual void OnReplayPacket(int stream, const void* data, size_t len,
+                              bool rtcp) = 0;
+};
+
+struct RtpReplayStats {
+  RtpReplayStats()
+      : packets_sent(0),
+        bytes_sent(0),
+        elapsed_us(0),
+        late_packets(0),
+        total_timing_error_us(0),
+        max_timing_error_us(0),
+        active_streams(0) {
+  }
+
+  // Achieved send rate over the run so far.
+  double packets_per_second() const {
+    return elapsed_us > 0 ? packets_sent * 1000000.0 / elapsed_us : 0.0;
+  }
+  double mean_timing_error_us() const {
+    return packets_sent > 0 ?
+        static_cast<double>(total_timing_error_us) / packets_sent : 0.0;
+  }
+
+  uint64 packets_sent;
+  uint64 bytes_sent;
+  int64 elapsed_us;
+  // Packets sent more than one tick after their scheduled time.
+  uint64 late_packets;
+  // How long after its scheduled time each packet was handed to the sink.
+  uint64 total_timing_error_us;
+  int64 max_timing_error_us;
+  int active_streams;
+};
+
+class RtpReplayEngine : public talk_base::Runnable {
+ public:
+  explicit RtpReplayEngine(RtpReplaySink* sink);
+  virtual ~RtpReplayEngine();
+
+  // Adds a stream replaying |source| with the SSRC of its RTP packets and of
+  // the first report in its RTCP packets rewritten to |ssrc|. The stream
+  // starts |start_delay_ms| after the engine starts, which lets callers
+  // spread many streams over time. A looping stream replays the recording
+  // forever with continuous sequence numbers and timestamps; otherwise it
+  // ends after one pass. Streams must be added before the engine starts.
+  // Returns the stream id passed to the sink.
+  int AddStream(const RtpReplaySource* source, uint32 ssrc,
+                uint32 start_delay_ms, bool loop);
+
+  // Replays on a dedicated thread in real time until Stop() is called or
+  // every stream has ended.
+  bool Start();
+  void Stop();
+  bool running() const;
+
+  // Sends every packet due at or before |now_us|, measured from the start of
+  // the replay. The engine's thread calls this from Run(); tests may call it
+  // directly with a simulated clock instead of calling Start().
+  void ProcessUntil(int64 now_us);
+  // Time of the next tick with something to send, or -1 if every stream has
+  // ended.
+  int64 NextDueUs() const;
+
+  RtpReplayStats GetStats() const;
+
+  // talk_base::Runnable implementation.
+  virtual void Run(talk_base::Thread* thread);
+
+ private:
+  struct Stream;
+
+  void Schedule(int id);
+  void SendDuePackets(Stream* stream, int id, int64 now_us);
+  void SendPacket(const Stream& stream, int id,
+                  const RtpDumpPacketView& packet);
+
+  RtpReplaySink* sink_;
+  std::vector<Stream> streams_;
+  // Heads of the per-slot intrusive lists of stream ids, or -1 if empty.
+  std::vector<int> wheel_;
+  int64 current_tick_;
+  int active_streams_;
+  // Scratch buffer used to rewrite the RTP header of the packet being sent.
+  std::vector<uint8> scratch_;
+  // Updated by ProcessUntil() and published to |stats_| once per call.
+  RtpReplayStats local_stats_;
+
+  mutable talk_base::CriticalSection crit_;
+  RtpReplayStats stats_;
+  bool stopping_;
+  bool running_;
+  talk_base::Event wake_;
+  talk_base::Thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(RtpReplayEngine);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_MEDIA_BASE_RTPREPLAY_H_
@@ -61,6 +61,15 @@ bool GetRtpHeaderLen(const void* data, size_t len, size_t* value);
 bool GetRtcpType(const void* data, size_t len, int* value);
 bool GetRtcpSsrc(const void* data, size_t len, uint32* value);
 bool GetRtpHeader(const void* data, size_t len, RtpHeader* header);
+// Finds the RFC 5285 one-byte header extension element with the given |id|.
+// On success |value| points into |data| and |value_len| is 1 to 16.
+bool GetRtpHeaderExtension(const void* data, size_t len, int id,
+                           const uint8** value, size_t* value_len);
+// Reads the RFC 6464 client-to-mixer audio level carried in extension |id|.
+// |level| is the level in -dBov (0 is loudest, 127 is silence), and |voice|
+// is the sender's voice activity flag.
+bool GetRtpAudioLevel(const void* data, size_t len, int id,
+                      int* level, bool* voice);
 
 // Assumes marker bit is 0.
 bool SetRtpHeaderFlags(
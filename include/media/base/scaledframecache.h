@@ -0,0 +1,88 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_MEDIA_BASE_SCALEDFRAMECACHE_H_
+#define TALK_MEDIA_BASE_SCALEDFRAMECACHE_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/criticalsection.h"
+
+namespace cricket {
+
+class VideoFrame;
+
+// ScaledFrameCache hands out scaled versions of a capturer's current frame to
+// the consumers sharing that capturer. Each distinct size is scaled once per
+// frame, the first time a consumer asks for it, and every later request for
+// that size gets the same frame. A consumer that needs a frame beyond its
+// callback should Copy() it, which shares the reference-counted buffer rather
+// than the pixels.
+// The cache's own state is guarded by a lock, but the frames it returns are
+// not: passing in a new source frame deletes the frames scaled from the old
+// one. Requests for a new source frame must therefore not race with users of
+// frames returned earlier, which is why the cache is used from the capture
+// thread only, within the frame callback.
+class ScaledFrameCache {
+ public:
+  ScaledFrameCache();
+  ~ScaledFrameCache();
+
+  // Returns |frame| scaled to |width| x |height|, cropping to that aspect
+  // ratio first, or |frame| itself if it already has that size. Returns NULL
+  // if the frame could not be scaled. The returned frame stays valid until a
+  // different source frame is passed in or the cache is destroyed; Copy() it
+  // to keep it any longer.
+  const VideoFrame* GetScaledFrame(const VideoFrame* frame,
+                                   size_t width, size_t height);
+
+  // Number of frames scaled and number of requests served from the cache.
+  int scale_count() const;
+  int hit_count() const;
+
+ private:
+  typedef std::vector<VideoFrame*> ScaledFrames;
+
+  void Clear();
+
+  // Identity of the source frame the cached frames were scaled from. Frames
+  // are often on the capturer's stack, so the pointer alone is not enough.
+  const VideoFrame* source_;
+  int64 source_elapsed_time_;
+  int64 source_time_stamp_;
+  ScaledFrames scaled_frames_;
+  int scale_count_;
+  int hit_count_;
+  mutable talk_base::CriticalSection crit_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScaledFrameCache);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_MEDIA_BASE_SCALEDFRAMECACHE_H_
@@ -46,6 +46,7 @@ namespace cricket {
 
 extern const char kFecSsrcGroupSemantics[];
 extern const char kFidSsrcGroupSemantics[];
+extern const char kSimSsrcGroupSemantics[];
 
 struct SsrcGroup {
   SsrcGroup(const std::string& usage, const std::vector<uint32>& ssrcs)
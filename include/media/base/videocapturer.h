@@ -37,6 +37,8 @@
 #include "base/scoped_ptr.h"
 #include "base/sigslot.h"
 #include "base/thread.h"
+#include "media/base/frameconverter.h"
+#include "media/base/scaledframecache.h"
 #include "media/base/videocommon.h"
 #include "media/devices/devicemanager.h"
 
@@ -211,6 +213,20 @@ class VideoCapturer
   // The fourcc component is ignored.
   void ConstrainSupportedFormats(const VideoFormat& max_format);
 
+  // Sets the number of worker threads, besides the capture thread, that share
+  // the conversion of large frames. Negative means one per spare CPU, up to a
+  // small limit, which is the default. Must be set before capturing starts.
+  void SetConversionThreads(int threads);
+  // Returns the time spent converting and scaling captured frames so far.
+  FrameConverter::Stats GetConversionStats() const {
+    return converter_->GetStats();
+  }
+
+  // Scaled versions of the frame being signalled, shared by every consumer of
+  // this capturer that wants the same size. Only use it from SignalVideoFrame
+  // handlers; see ScaledFrameCache for how long its frames stay valid.
+  ScaledFrameCache* scaled_frames() { return &scaled_frames_; }
+
   void set_enable_camera_list(bool enable_camera_list) {
     enable_camera_list_ = enable_camera_list;
   }
@@ -297,6 +313,9 @@ class VideoCapturer
   talk_base::CriticalSection crit_;
   VideoProcessors video_processors_;
 
+  talk_base::scoped_ptr<FrameConverter> converter_;
+  ScaledFrameCache scaled_frames_;
+
   DISALLOW_COPY_AND_ASSIGN(VideoCapturer);
 };
 
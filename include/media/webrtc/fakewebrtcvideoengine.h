@@ -162,6 +162,7 @@ class FakeWebRtcVideoEngine
       : inited_(false),
         last_channel_(kViEChannelIdBase - 1),
         fail_create_channel_(false),
+        fail_local_ssrc_(0),
         last_capturer_(kViECaptureIdBase - 1),
         fail_alloc_capturer_(false),
         codecs_(codecs),
@@ -194,6 +195,10 @@ class FakeWebRtcVideoEngine
   void set_fail_create_channel(bool fail_create_channel) {
     fail_create_channel_ = fail_create_channel;
   }
+  // Makes SetLocalSSRC() fail for |ssrc|; 0 turns this off.
+  void set_fail_local_ssrc(unsigned int ssrc) {
+    fail_local_ssrc_ = ssrc;
+  }
 
   int GetLastCapturer() const { return last_capturer_; }
   int GetNumCapturers() const { return capturers_.size(); }
@@ -610,6 +615,10 @@ class FakeWebRtcVideoEngine
                              const webrtc::StreamType usage,
                              const unsigned char idx)) {
     WEBRTC_CHECK_CHANNEL(channel);
+    if (fail_local_ssrc_ != 0 && ssrc == fail_local_ssrc_) {
+      return -1;
+    }
+    channels_[channel]->ssrcs_[idx] = ssrc;
     return 0;
   }
   WEBRTC_STUB_CONST(SetRemoteSSRCType, (const int,
@@ -798,6 +807,7 @@ class FakeWebRtcVideoEngine
   int last_channel_;
   std::map<int, Channel*> channels_;
   bool fail_create_channel_;
+  unsigned int fail_local_ssrc_;
   int last_capturer_;
   std::map<int, Capturer*> capturers_;
   bool fail_alloc_capturer_;
@@ -296,6 +296,12 @@ class WebRtcVideoMediaChannel : public talk_base::MessageHandler,
   bool MaybeResetVieSendCodec(WebRtcVideoChannelSendInfo* send_channel,
                               int new_width, int new_height, bool is_screencast,
                               bool* reset);
+  // Returns |frame| downscaled to the send codec size of |send_channel|, taken
+  // from the capturer's shared cache, or |frame| itself when it already fits.
+  // Screencasts keep their size, except on lower simulcast layers.
+  const VideoFrame* GetFrameForSendCodec(
+      WebRtcVideoChannelSendInfo* send_channel, VideoCapturer* capturer,
+      const VideoFrame* frame);
   // Helper function for starting the sending of media on all channels or
   // |channel_id|. Note that these two function do not change |sending_|.
   bool StartSend();
@@ -308,6 +314,22 @@ class WebRtcVideoMediaChannel : public talk_base::MessageHandler,
 
   // Send with one local SSRC. Normal case.
   bool IsOneSsrcStream(const StreamParams& sp);
+  // Send with an SSRC group of SIM semantics, one SSRC per layer.
+  bool IsSimulcastStream(const StreamParams& sp);
+  // Creates a send channel for each lower layer of the simulcast stream |sp|
+  // sent on |send_channel|. The layer channels are keyed by their SSRC. On
+  // failure, none of the layer channels are left behind.
+  bool AddSimulcastLayers(WebRtcVideoChannelSendInfo* send_channel,
+                          const StreamParams& sp);
+  bool AddSimulcastLayer(WebRtcVideoChannelSendInfo* send_channel,
+                         const StreamParams& sp, int layer);
+  void RemoveSimulcastLayers(WebRtcVideoChannelSendInfo* send_channel);
+  void GetSimulcastLayerChannels(
+      WebRtcVideoChannelSendInfo* send_channel,
+      std::vector<WebRtcVideoChannelSendInfo*>* layers);
+  // Layers follow the capturer of the full resolution stream.
+  void SetSimulcastLayerCapturer(WebRtcVideoChannelSendInfo* send_channel,
+                                 VideoCapturer* capturer);
 
   bool HasReadySendChannels();
 
@@ -316,7 +338,6 @@ class WebRtcVideoMediaChannel : public talk_base::MessageHandler,
   // If the local ssrc correspond to that of the default channel the key is 0.
   // For all other channels the returned key will be the same as the local ssrc.
   bool GetSendChannelKey(uint32 local_ssrc, uint32* key);
-  WebRtcVideoChannelSendInfo* GetSendChannel(VideoCapturer* video_capturer);
   WebRtcVideoChannelSendInfo* GetSendChannel(uint32 local_ssrc);
   // Creates a new unique key that can be used for inserting a new send channel
   // into |send_channels_|
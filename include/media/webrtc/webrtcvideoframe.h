@@ -38,6 +38,7 @@
 namespace cricket {
 
 struct CapturedFrame;
+class FrameConverter;
 
 // Class that takes ownership of the frame passed to it.
 class FrameBuffer {
@@ -78,6 +79,11 @@ class WebRtcVideoFrame : public VideoFrame {
 
   bool Init(const CapturedFrame* frame, int dw, int dh);
 
+  // Creates a frame from "frame" cropped to "dw" x "dh" and scaled to
+  // "sw" x "sh" (after rotation) in a single pass by "converter".
+  bool Init(const CapturedFrame* frame, int dw, int dh, int sw, int sh,
+            FrameConverter* converter);
+
   bool InitToBlack(int w, int h, size_t pixel_width, size_t pixel_height,
                    int64 elapsed_time, int64 time_stamp);
 
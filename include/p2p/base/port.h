@@ -194,6 +194,12 @@ class Port : public PortInterface, public talk_base::MessageHandler,
   const std::string username_fragment() const;
   const std::string& password() const { return password_; }
 
+  // Replaces the ICE credentials of a port that was allocated before it was
+  // given to its session (see PortPool). The candidates gathered so far are
+  // updated to match, along with the current component and generation.
+  void SetIceParameters(const std::string& ice_ufrag,
+                        const std::string& ice_pwd);
+
   // PrepareAddress will attempt to get an address for this port that other
   // clients can send to.  It may take some time before the address is read.
   // Once it is ready, we will send SignalAddressReady.  If errors are
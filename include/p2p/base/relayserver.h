@@ -33,6 +33,7 @@
 #include <map>
 
 #include "base/asyncudpsocket.h"
+#include "base/criticalsection.h"
 #include "base/socketaddresspair.h"
 #include "base/thread.h"
 #include "base/timeutils.h"
@@ -41,6 +42,7 @@
 
 namespace cricket {
 
+class RelayBindingDirectory;
 class RelayServerBinding;
 class RelayServerConnection;
 
@@ -79,6 +81,19 @@ class RelayServer : public talk_base::MessageHandler,
   // Removes this server socket from the list.
   void RemoveInternalServerSocket(talk_base::AsyncSocket* socket);
 
+  // Makes this server one of several that share an internal address (see
+  // RelayServerGroup). Bindings are then claimed in |directory| under
+  // |index|, and allocations for a binding owned by another server are handed
+  // over to that server.
+  void SetBindingDirectory(RelayBindingDirectory* directory, int index);
+
+  // Processes a packet that another server sharing the same directory
+  // received on its internal socket for a binding owned by this server.
+  // Replies go out on this server's first internal socket, whose local
+  // address is the same as the one the packet arrived on.
+  void HandleForwardedPacket(const char* bytes, size_t size,
+                             const talk_base::SocketAddress& remote_addr);
+
   // Methods for testing and debuging.
   int GetConnectionCount() const;
   talk_base::SocketAddressPair GetConnection(int connection) const;
@@ -91,6 +106,14 @@ class RelayServer : public talk_base::MessageHandler,
   typedef std::map<std::string, RelayServerBinding*> BindingMap;
   typedef std::map<talk_base::SocketAddressPair,
                    RelayServerConnection*> ConnectionMap;
+  // Internal clients whose binding is owned by another server in the
+  // directory, keyed like |connections_|.
+  struct ForwardedConnection {
+    int owner;
+    std::string username;
+  };
+  typedef std::map<talk_base::SocketAddressPair,
+                   ForwardedConnection> ForwardMap;
 
   talk_base::Thread* thread_;
   bool log_bindings_;
@@ -99,11 +122,25 @@ class RelayServer : public talk_base::MessageHandler,
   ServerSocketMap server_sockets_;
   BindingMap bindings_;
   ConnectionMap connections_;
+  RelayBindingDirectory* directory_;
+  int directory_index_;
+  ForwardMap forwards_;
+  size_t next_forward_sweep_;
 
   // Called when a packet is received by the server on one of its sockets.
   void OnInternalPacket(talk_base::AsyncPacketSocket* socket,
                         const char* bytes, size_t size,
                         const talk_base::SocketAddress& remote_addr);
+  void ProcessInternalPacket(talk_base::AsyncPacketSocket* socket,
+                             const char* bytes, size_t size,
+                             const talk_base::SocketAddress& remote_addr,
+                             bool forwarded);
+  // Hands the packet to the server that owns the binding for |ap|, if that is
+  // not this one. Returns false if the packet should be handled here.
+  bool MaybeForwardInternalPacket(const char* bytes, size_t size,
+                                  const talk_base::SocketAddressPair& ap);
+  // Drops forwarding entries whose binding has gone away.
+  void SweepForwards();
   void OnExternalPacket(talk_base::AsyncPacketSocket* socket,
                         const char* bytes, size_t size,
                         const talk_base::SocketAddress& remote_addr);
@@ -117,7 +154,8 @@ class RelayServer : public talk_base::MessageHandler,
                   std::string* username, StunMessage* msg);
   void HandleStunAllocate(const char* bytes, size_t size,
                           const talk_base::SocketAddressPair& ap,
-                          talk_base::AsyncPacketSocket* socket);
+                          talk_base::AsyncPacketSocket* socket,
+                          bool forwarded);
   void HandleStun(RelayServerConnection* int_conn, const char* bytes,
                   size_t size);
   void HandleStunAllocate(RelayServerConnection* int_conn,
@@ -244,6 +282,83 @@ class RelayServerBinding : public talk_base::MessageHandler {
   // TODO: bandwidth
 };
 
+// Tracks which of several RelayServers sharing an internal address owns each
+// binding. All connections of a binding must live on one server, since the
+// server relays between them without locking.
+class RelayBindingDirectory {
+ public:
+  virtual ~RelayBindingDirectory() {}
+
+  // Returns the index of the server that owns |username|, making it |index|
+  // if no server does yet.
+  virtual int ClaimBinding(const std::string& username, int index) = 0;
+  // Gives up ownership of |username| if |index| holds it.
+  virtual void ReleaseBinding(const std::string& username, int index) = 0;
+  // Returns the index of the server that owns |username|, or -1.
+  virtual int GetBindingOwner(const std::string& username) = 0;
+  // Passes an internal packet to server |owner|, on that server's thread.
+  virtual void ForwardInternalPacket(
+      int owner, const char* bytes, size_t size,
+      const talk_base::SocketAddress& remote_addr) = 0;
+};
+
+// Runs a RelayServer on each of several threads. The internal UDP sockets of
+// all servers are bound to one address with Socket::OPT_REUSEPORT; each
+// server has its own external socket, so external traffic always arrives at
+// the server that advertised it. Binding ownership is kept in a map sharded
+// by username, so threads only contend when they touch the same shard.
+// TCP and SSL-TCP internal sockets are not supported by the group.
+class RelayServerGroup : public RelayBindingDirectory {
+ public:
+  RelayServerGroup();
+  virtual ~RelayServerGroup();
+
+  // Indicates whether the servers will log the number of bindings. Takes
+  // effect on the next Start().
+  void set_log_bindings(bool log_bindings) { log_bindings_ = log_bindings; }
+
+  // Starts |num_threads| servers. The internal sockets share
+  // |internal_address|; if its port is 0, the first socket picks one. Server
+  // i binds its external socket to |external_address| with the port
+  // incremented by i, or to an ephemeral port if the port is 0.
+  bool Start(const talk_base::SocketAddress& internal_address,
+             const talk_base::SocketAddress& external_address,
+             int num_threads);
+  // Stops all threads and destroys their servers.
+  void Stop();
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+  const talk_base::SocketAddress& internal_address() const {
+    return internal_address_;
+  }
+  talk_base::SocketAddress external_address(int index) const;
+
+  // RelayBindingDirectory implementation. These may be called on any thread.
+  virtual int ClaimBinding(const std::string& username, int index);
+  virtual void ReleaseBinding(const std::string& username, int index);
+  virtual int GetBindingOwner(const std::string& username);
+  virtual void ForwardInternalPacket(
+      int owner, const char* bytes, size_t size,
+      const talk_base::SocketAddress& remote_addr);
+
+ private:
+  class Worker;
+  struct Shard {
+    talk_base::CriticalSection crit;
+    std::map<std::string, int> owners;
+  };
+  static const int kNumShards = 16;
+
+  Shard* GetShard(const std::string& username);
+
+  bool log_bindings_;
+  talk_base::SocketAddress internal_address_;
+  std::vector<Worker*> workers_;
+  Shard shards_[kNumShards];
+
+  DISALLOW_COPY_AND_ASSIGN(RelayServerGroup);
+};
+
 }  // namespace cricket
 
 #endif  // TALK_P2P_BASE_RELAYSERVER_H_
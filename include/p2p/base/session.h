@@ -200,6 +200,7 @@ class BaseSession : public sigslot::has_slots<>,
     MSG_TIMEOUT = 0,
     MSG_ERROR,
     MSG_STATE,
+    MSG_SEND_CANDIDATES,
   };
 
   enum State {
@@ -512,6 +513,14 @@ class Session : public BaseSession {
     current_protocol_ = protocol;
   }
 
+  // Candidates gathered within this many milliseconds of the first pending
+  // one are coalesced into a single transport-info message.  0, the
+  // default, sends each batch as soon as the transport reports it.
+  int candidate_batch_interval() const { return candidate_batch_interval_; }
+  void set_candidate_batch_interval(int interval_ms) {
+    candidate_batch_interval_ = interval_ms;
+  }
+
   // Updates the error state, signaling if necessary.
   virtual void SetError(Error error);
 
@@ -594,6 +603,14 @@ class Session : public BaseSession {
   bool SendTransportInfoMessage(const TransportProxy* transproxy,
                                 const Candidates& candidates,
                                 SessionError* error);
+  bool SendTransportInfoMessage(const TransportInfos& tinfos,
+                                SessionError* error);
+
+  // Queues candidates until the batching window closes.
+  void BatchCandidates(const TransportProxy* transproxy,
+                       const Candidates& candidates);
+  // Sends everything queued by BatchCandidates in one message.
+  bool SendBatchedCandidates(SessionError* error);
 
   bool ResendAllTransportInfoMessages(SessionError* error);
   bool SendAllUnsentTransportInfoMessages(SessionError* error);
@@ -631,6 +648,9 @@ class Session : public BaseSession {
   bool WriteSessionAction(SignalingProtocol protocol,
                           const TransportInfo& tinfo,
                           XmlElements* elems, WriteError* error);
+  bool WriteSessionAction(SignalingProtocol protocol,
+                          const TransportInfos& tinfos,
+                          XmlElements* elems, WriteError* error);
   bool WriteSessionAction(SignalingProtocol protocol,
                           const SessionTerminate& term,
                           XmlElements* elems, WriteError* error);
@@ -686,6 +706,9 @@ class Session : public BaseSession {
   TransportParser* transport_parser_;
   // Keeps track of what protocol we are speaking.
   SignalingProtocol current_protocol_;
+  int candidate_batch_interval_;
+  // Candidates waiting for the batching window to close, by content name.
+  std::map<std::string, Candidates> batched_candidates_;
 
   friend class SessionManager;  // For access to constructor, destructor,
                                 // and signaling related methods.
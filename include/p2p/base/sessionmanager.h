@@ -30,6 +30,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -63,6 +64,13 @@ class SessionManager : public sigslot::has_slots<> {
   int session_timeout() const { return timeout_; }
   void set_session_timeout(int timeout) { timeout_ = timeout; }
 
+  // Batching window, in milliseconds, given to sessions created from now on.
+  // See Session::set_candidate_batch_interval.
+  int candidate_batch_interval() const { return candidate_batch_interval_; }
+  void set_candidate_batch_interval(int interval_ms) {
+    candidate_batch_interval_ = interval_ms;
+  }
+
   // Set what transport protocol we want to default to.
   void set_transport_protocol(TransportProtocol proto) {
      transport_desc_factory_.set_protocol(proto);
@@ -144,7 +152,9 @@ class SessionManager : public sigslot::has_slots<> {
   sigslot::signal0<> SignalDestroyed;
 
  private:
-  typedef std::map<std::string, Session*> SessionMap;
+  // Every incoming session message looks its session up by sid, so keep
+  // this hashed; there can be a great many of them on a gateway.
+  typedef std::unordered_map<std::string, Session*> SessionMap;
   typedef std::map<std::string, SessionClient*> ClientMap;
 
   // Helper function for CreateSession.  This is also invoked when we receive
@@ -197,6 +207,7 @@ class SessionManager : public sigslot::has_slots<> {
   talk_base::Thread *signaling_thread_;
   talk_base::Thread *worker_thread_;
   int timeout_;
+  int candidate_batch_interval_;
   TransportDescriptionFactory transport_desc_factory_;
   SessionMap session_map_;
   ClientMap client_map_;
@@ -0,0 +1,112 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_P2P_BASE_STUNLOADGENERATOR_H_
+#define TALK_P2P_BASE_STUNLOADGENERATOR_H_
+
+#include <vector>
+
+#include "base/asyncudpsocket.h"
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "base/sigslot.h"
+#include "base/socketaddress.h"
+
+namespace talk_base {
+class Thread;
+}
+
+namespace cricket {
+
+// The outcome of a StunLoadGenerator run. Latencies are in microseconds and
+// only cover requests that were answered before timing out.
+struct StunLoadStats {
+  StunLoadStats()
+      : requests_sent(0), responses_received(0), timeouts(0), elapsed_us(0),
+        latency_p50_us(0), latency_p90_us(0), latency_p99_us(0),
+        latency_max_us(0) {
+  }
+
+  // Answered requests per second over the whole run.
+  double requests_per_second() const {
+    return elapsed_us > 0 ?
+        responses_received * 1000000.0 / elapsed_us : 0.0;
+  }
+
+  int requests_sent;
+  int responses_received;
+  int timeouts;
+  int64 elapsed_us;
+  int64 latency_p50_us;
+  int64 latency_p90_us;
+  int64 latency_p99_us;
+  int64 latency_max_us;
+};
+
+// Drives a STUN server with binding requests from a number of local UDP
+// sockets, each keeping a fixed window of requests outstanding, and measures
+// throughput and latency. Requests are built and matched by hand rather than
+// through StunMessage so that the generator stays cheaper than the server it
+// is measuring. Everything runs on the given thread.
+class StunLoadGenerator : public sigslot::has_slots<> {
+ public:
+  StunLoadGenerator(talk_base::Thread* thread,
+                    const talk_base::SocketAddress& server_addr);
+  ~StunLoadGenerator();
+
+  // Binds |num_sockets| sockets to ephemeral ports on |local_ip|, each of
+  // which will keep |window| requests in flight.
+  bool Init(const talk_base::IPAddress& local_ip, int num_sockets,
+            int window);
+
+  // Sends requests for |duration_ms|, then waits for the stragglers. A
+  // request not answered within |timeout_ms| is counted as a timeout and,
+  // while the run lasts, replaced by a new one.
+  StunLoadStats Run(int duration_ms, int timeout_ms);
+
+ private:
+  struct Client;
+
+  void SendRequest(Client* client, size_t slot);
+  void CheckTimeouts(int64 now_ns, int64 timeout_ns);
+  void OnPacket(talk_base::AsyncPacketSocket* socket, const char* buf,
+                size_t size, const talk_base::SocketAddress& remote_addr);
+
+  talk_base::Thread* thread_;
+  talk_base::SocketAddress server_addr_;
+  std::vector<Client*> clients_;
+  bool sending_;
+  int in_flight_;
+  StunLoadStats stats_;
+  std::vector<uint32> latencies_us_;
+
+  DISALLOW_COPY_AND_ASSIGN(StunLoadGenerator);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_P2P_BASE_STUNLOADGENERATOR_H_
@@ -28,10 +28,17 @@
 #ifndef TALK_P2P_BASE_STUNSERVER_H_
 #define TALK_P2P_BASE_STUNSERVER_H_
 
+#include <vector>
+
 #include "base/asyncudpsocket.h"
+#include "base/constructormagic.h"
 #include "base/scoped_ptr.h"
 #include "p2p/base/stun.h"
 
+namespace talk_base {
+class Thread;
+}
+
 namespace cricket {
 
 const int STUN_SERVER_PORT = 3478;
@@ -72,6 +79,35 @@ class StunServer : public sigslot::has_slots<> {
   talk_base::scoped_ptr<talk_base::AsyncUDPSocket> socket_;
 };
 
+// Runs a StunServer on each of several threads. Every thread has its own
+// socket bound to the same address with Socket::OPT_REUSEPORT, so the kernel
+// spreads incoming requests across them. Binding requests need no state, so
+// the threads share nothing and throughput scales with the number of cores.
+class StunServerGroup {
+ public:
+  StunServerGroup();
+  ~StunServerGroup();
+
+  // Binds |num_threads| sockets to |address| and starts a server thread for
+  // each. If the port is 0, the first socket picks one and the others share
+  // it. Returns false if any socket could not be bound.
+  bool Start(const talk_base::SocketAddress& address, int num_threads);
+  // Stops all threads and closes their sockets.
+  void Stop();
+
+  // The address that all of the servers are listening on.
+  const talk_base::SocketAddress& address() const { return address_; }
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  struct Worker;
+
+  std::vector<Worker*> workers_;
+  talk_base::SocketAddress address_;
+
+  DISALLOW_COPY_AND_ASSIGN(StunServerGroup);
+};
+
 }  // namespace cricket
 
 #endif  // TALK_P2P_BASE_STUNSERVER_H_
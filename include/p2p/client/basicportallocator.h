@@ -34,6 +34,7 @@
 #include "base/messagequeue.h"
 #include "base/network.h"
 #include "base/scoped_ptr.h"
+#include "base/scoped_ref_ptr.h"
 #include "base/thread.h"
 #include "p2p/base/port.h"
 #include "p2p/base/portallocator.h"
@@ -52,6 +53,8 @@ struct RelayCredentials {
   std::string password;
 };
 
+class PortPool;
+
 typedef std::vector<ProtocolAddress> PortList;
 struct RelayServerConfig {
   RelayServerConfig(RelayType type) : type(type) {}
@@ -115,6 +118,26 @@ class BasicPortAllocator : public PortAllocator {
     allow_tcp_listen_ = allow_tcp_listen;
   }
 
+  // Gets/Sets the delay, in milliseconds, between the allocation steps that
+  // follow the initial UDP/STUN one (relay, then TCP, then SSLTCP). A delay
+  // of 0 starts all of them together as soon as StartGetAllPorts() is
+  // called; they are still issued in that order, so host and server
+  // reflexive candidates come before relay ones.
+  uint32 step_delay() const { return step_delay_; }
+  void set_step_delay(uint32 step_delay) { step_delay_ = step_delay; }
+
+  // Gets/Sets how many STUN and UDP TURN ports to keep allocated ahead of
+  // time for each network and server, for sessions to take (see PortPool).
+  // The default of 0 disables pooling. Takes effect when the pool is created,
+  // by the first session that gathers candidates.
+  int port_pool_size() const { return port_pool_size_; }
+  void set_port_pool_size(int size) { port_pool_size_ = size; }
+
+  // Returns the pool shared by this allocator's sessions, creating it on
+  // |thread| if needed. Returns NULL if pooling is disabled, or if the pool
+  // already lives on another thread.
+  PortPool* GetPortPool(talk_base::Thread* thread);
+
  private:
   void Construct();
 
@@ -124,6 +147,9 @@ class BasicPortAllocator : public PortAllocator {
   std::vector<RelayServerConfig> relays_;
   int best_writable_phase_;
   bool allow_tcp_listen_;
+  uint32 step_delay_;
+  int port_pool_size_;
+  talk_base::scoped_refptr<PortPool> port_pool_;
 };
 
 struct PortConfiguration;
@@ -142,12 +168,20 @@ class BasicPortAllocatorSession : public PortAllocatorSession,
   virtual BasicPortAllocator* allocator() { return allocator_; }
   talk_base::Thread* network_thread() { return network_thread_; }
   talk_base::PacketSocketFactory* socket_factory() { return socket_factory_; }
+  // The allocator's port pool, or NULL if pooling is disabled.
+  PortPool* port_pool() { return port_pool_.get(); }
 
   virtual void GetInitialPorts();
   virtual void StartGetAllPorts();
   virtual void StopGetAllPorts();
   virtual bool IsGettingAllPorts() { return running_; }
 
+  // Milliseconds from GetInitialPorts() until the first candidate was
+  // signaled, and until SignalCandidatesAllocationDone was sent. Both are -1
+  // until the event happens.
+  int time_to_first_candidate() const;
+  int time_to_complete() const;
+
  protected:
   // Starts the process of getting the port configurations.
   virtual void GetPortConfigurations();
@@ -200,7 +234,10 @@ class BasicPortAllocatorSession : public PortAllocatorSession,
                                PortConfiguration* config, uint32* flags);
   void AddAllocatedPort(Port* port, AllocationSequence* seq,
                         bool prepare_address = true);
+  // Takes over a port from the pool, whose address is already ready.
+  void AdoptPooledPort(Port* port, AllocationSequence* seq);
   void OnCandidateReady(Port* port, const Candidate& c);
+  void SignalCandidates(const std::vector<Candidate>& candidates);
   void OnPortReady(Port* port);
   void OnProtocolEnabled(AllocationSequence* seq, ProtocolType proto);
   void OnPortDestroyed(PortInterface* port);
@@ -216,6 +253,7 @@ class BasicPortAllocatorSession : public PortAllocatorSession,
   talk_base::Thread* network_thread_;
   talk_base::scoped_ptr<talk_base::PacketSocketFactory> owned_socket_factory_;
   talk_base::PacketSocketFactory* socket_factory_;
+  talk_base::scoped_refptr<PortPool> port_pool_;
   bool configuration_done_;
   bool allocation_started_;
   bool network_manager_started_;
@@ -224,6 +262,13 @@ class BasicPortAllocatorSession : public PortAllocatorSession,
   std::vector<PortConfiguration*> configs_;
   std::vector<AllocationSequence*> sequences_;
   std::vector<PortData> ports_;
+  // Times at which gathering started, the first candidate was signaled and
+  // gathering completed; the last two are valid only if the flags are set.
+  uint32 start_time_;
+  uint32 first_candidate_time_;
+  uint32 complete_time_;
+  bool first_candidate_signaled_;
+  bool complete_signaled_;
 
   friend class AllocationSequence;
 };
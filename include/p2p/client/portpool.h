@@ -0,0 +1,157 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_P2P_CLIENT_PORTPOOL_H_
+#define TALK_P2P_CLIENT_PORTPOOL_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/messagehandler.h"
+#include "base/refcount.h"
+#include "base/scoped_ptr.h"
+#include "base/sigslot.h"
+#include "base/socketaddress.h"
+#include "p2p/client/basicportallocator.h"
+
+namespace talk_base {
+class Network;
+class PacketSocketFactory;
+class Thread;
+}
+
+namespace cricket {
+
+class Port;
+
+// Keeps STUN and TURN ports allocated ahead of time, per network and server,
+// so that a new session can start with server reflexive and relayed
+// candidates that would otherwise take one or more round trips to the
+// server. A session takes a ready port, gives it its own ICE credentials
+// with Port::SetIceParameters() and owns it from then on; the pool starts a
+// replacement right away. Pooled STUN ports keep their NAT binding alive and
+// pooled TURN ports refresh their allocation, as they would in a session.
+//
+// The pool is reference counted. BasicPortAllocator and every session that
+// uses it hold a reference, so it outlives whichever goes first. All other
+// methods must be called on |thread|.
+class PortPool : public talk_base::RefCountInterface,
+                 public talk_base::MessageHandler,
+                 public sigslot::has_slots<> {
+ public:
+  // Ports are created on |thread| with |factory|, or with a factory owned by
+  // the pool if |factory| is NULL.
+  PortPool(talk_base::Thread* thread,
+           talk_base::PacketSocketFactory* factory);
+
+  talk_base::Thread* thread() { return thread_; }
+
+  // The number of ready (or pending) ports kept for each network and server.
+  int target_size() const { return target_size_; }
+  void set_target_size(int size) { target_size_ = size; }
+
+  // Sets the port range used for the pooled ports' sockets.
+  void SetPortRange(int min_port, int max_port) {
+    min_port_ = min_port;
+    max_port_ = max_port;
+  }
+
+  // Returns a port whose address is ready, for the STUN server |server| on
+  // |network|, or NULL if there is none. The caller takes ownership. Either
+  // way, the pool then tops itself up for that network and server.
+  Port* TakeStunPort(talk_base::Network* network,
+                     const talk_base::SocketAddress& server);
+  // Same for a UDP TURN allocation on |server| with |credentials|.
+  Port* TakeTurnPort(talk_base::Network* network,
+                     const talk_base::SocketAddress& server,
+                     const RelayCredentials& credentials);
+
+  // Counts for tests and stats. A hit is a Take*() call that returned a port.
+  int ready_port_count() const;
+  int pending_port_count() const;
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+  // MessageHandler
+  virtual void OnMessage(talk_base::Message* msg);
+
+ protected:
+  virtual ~PortPool();
+
+ private:
+  enum PortKind {
+    KIND_STUN,
+    KIND_TURN,
+  };
+
+  struct Key {
+    Key(PortKind kind, talk_base::Network* network,
+        const talk_base::SocketAddress& server,
+        const RelayCredentials& credentials);
+    bool operator<(const Key& other) const;
+
+    PortKind kind;
+    talk_base::Network* network;
+    talk_base::IPAddress ip;
+    talk_base::SocketAddress server;
+    std::string username;
+    std::string password;
+  };
+
+  struct Entry {
+    std::vector<Port*> ready;
+    std::vector<Port*> pending;
+  };
+  typedef std::map<Key, Entry> EntryMap;
+
+  Port* Take(const Key& key);
+  void Fill(const Key& key, Entry* entry);
+  Port* CreatePort(const Key& key);
+  Entry* FindEntry(Port* port, bool* pending);
+
+  void OnPortReady(Port* port);
+  void OnPortError(Port* port);
+
+  talk_base::Thread* thread_;
+  talk_base::scoped_ptr<talk_base::PacketSocketFactory> owned_factory_;
+  talk_base::PacketSocketFactory* factory_;
+  int target_size_;
+  int min_port_;
+  int max_port_;
+  EntryMap entries_;
+  // Failed ports, deleted once they have finished signaling.
+  std::vector<Port*> doomed_;
+  int hits_;
+  int misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(PortPool);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_P2P_CLIENT_PORTPOOL_H_
@@ -44,6 +44,9 @@ class SessionManagerTask : public buzz::XmppTask {
                      SessionManager* session_manager)
       : buzz::XmppTask(parent, buzz::XmppEngine::HL_SINGLE),
         session_manager_(session_manager) {
+    buzz::XmppStanzaFilter filter(buzz::QN_IQ);
+    filter.set_type(buzz::STR_SET);
+    SetStanzaFilter(filter);
   }
 
   ~SessionManagerTask() {
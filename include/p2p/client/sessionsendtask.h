@@ -79,6 +79,7 @@ class SessionSendTask : public buzz::XmppTask {
     } else {
       stanza_->SetAttr(buzz::QN_ID, task_id());
     }
+    SetStanzaFilter(buzz::XmppStanzaFilter::IqResponse(task_id()));
   }
 
   void OnSessionManagerDestroyed() {
@@ -0,0 +1,84 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Tracks the audio level of every remote stream of a voice channel from the
+// RFC 6464 audio level header extension, so that the loudest streams can be
+// found on the packet path without decoding or polling the voice engine.
+
+#ifndef TALK_SESSION_MEDIA_AUDIOLEVELTRACKER_H_
+#define TALK_SESSION_MEDIA_AUDIOLEVELTRACKER_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "session/media/audiomonitor.h"
+
+namespace cricket {
+
+// Keeps one smoothed level per SSRC in a flat array, which stays small and
+// cache friendly for the handful of streams a channel receives. Levels are
+// reported on the same 0-9 scale the voice engine uses for AudioInfo. Not
+// thread safe; BaseChannel uses it on the worker thread only.
+class AudioLevelTracker {
+ public:
+  // A stream that sent no packet for this long (e.g. because of DTX) is
+  // reported as silent.
+  static const uint32 kStaleStreamMs = 200;
+  // A stream that sent no packet for this long is forgotten.
+  static const uint32 kExpireStreamMs = 10000;
+
+  AudioLevelTracker();
+
+  // Records a packet from |ssrc| carrying |dbov|, the level in -dBov from the
+  // header extension, received at |now| (talk_base::Time()).
+  void OnPacket(uint32 ssrc, int dbov, uint32 now);
+  // Fills |streams| with the streams whose level at |now| is above zero, and
+  // forgets streams that have expired.
+  void GetActiveStreams(uint32 now, AudioInfo::StreamList* streams);
+  void RemoveSsrc(uint32 ssrc);
+  void Clear();
+  size_t size() const { return streams_.size(); }
+
+  // Maps an RFC 6464 level to the voice engine's 0-9 scale.
+  static int DbovToLevel(int dbov);
+
+ private:
+  struct StreamLevel {
+    uint32 ssrc;
+    int level_q8;  // 0-9 in Q8.
+    uint32 last_packet_time;
+  };
+
+  std::vector<StreamLevel> streams_;
+
+  DISALLOW_COPY_AND_ASSIGN(AudioLevelTracker);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SESSION_MEDIA_AUDIOLEVELTRACKER_H_
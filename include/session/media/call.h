@@ -80,6 +80,13 @@ class Call : public talk_base::MessageHandler, public sigslot::has_slots<> {
   void StartAudioMonitor(Session* session, int cms);
   void StopAudioMonitor(Session* session);
   bool IsAudioMonitorRunning(Session* session);
+  // Reports remote audio levels from the audio level header extension of
+  // received packets rather than from the decoder. If this is running when
+  // StartSpeakerMonitor is called, the speaker monitor uses it instead of
+  // starting the audio monitor.
+  void StartRtpAudioLevelMonitor(Session* session, int cms);
+  void StopRtpAudioLevelMonitor(Session* session);
+  bool IsRtpAudioLevelMonitorRunning(Session* session);
   void StartSpeakerMonitor(Session* session);
   void StopSpeakerMonitor(Session* session);
   void Mute(bool mute);
@@ -43,7 +43,9 @@
 #include "media/base/videocapturer.h"
 #include "p2p/base/session.h"
 #include "p2p/client/socketmonitor.h"
+#include "session/media/audioleveltracker.h"
 #include "session/media/audiomonitor.h"
+#include "session/media/channelstats.h"
 #include "session/media/mediamonitor.h"
 #include "session/media/mediasession.h"
 #include "session/media/rtcpmuxfilter.h"
@@ -137,8 +139,13 @@ class BaseChannel
       return;
     }
     content_name_ = content_name;
+    counters_.set_content_name(content_name);
   }
 
+  // Packet and byte counters maintained on the packet path. Safe to read
+  // from any thread; see ChannelCounters.
+  const ChannelCounters& counters() const { return counters_; }
+
   template <class T>
   void RegisterSendSink(T* sink,
                         void (T::*OnPacket)(const void*, size_t, bool),
@@ -259,6 +266,9 @@ class BaseChannel
                     size_t len);
   bool SendPacket(bool rtcp, talk_base::Buffer* packet);
   void HandlePacket(bool rtcp, talk_base::Buffer* packet);
+  // Called from HandlePacket for every received RTP packet that carries the
+  // negotiated audio level header extension. |dbov| is the level in -dBov.
+  virtual void OnRtpAudioLevel_w(uint32 ssrc, int dbov) {}
 
   // Setting the send codec based on the remote description.
   void OnSessionState(BaseSession* session, BaseSession::State state);
@@ -326,6 +336,9 @@ class BaseChannel
   std::vector<StreamParams> remote_streams_;
 
   std::string content_name_;
+  ChannelCounters counters_;
+  // Id of the audio level header extension on received RTP, or 0.
+  int rtp_audio_level_extension_id_;
   bool rtcp_;
   TransportChannel* transport_channel_;
   TransportChannel* rtcp_transport_channel_;
@@ -395,6 +408,14 @@ class VoiceChannel : public BaseChannel {
   void StartAudioMonitor(int cms);
   void StopAudioMonitor();
   bool IsAudioMonitorRunning() const;
+  // Like the audio monitor, but reports the remote streams from the audio
+  // level header extension of received packets instead of polling the voice
+  // engine. Only the active streams and the output level are filled in.
+  // Updates are sent on SignalAudioMonitor every |cms| milliseconds, so that
+  // streams that stop sending drop out.
+  void StartRtpAudioLevelMonitor(int cms);
+  void StopRtpAudioLevelMonitor();
+  bool IsRtpAudioLevelMonitorRunning() const;
   sigslot::signal2<VoiceChannel*, const AudioInfo&> SignalAudioMonitor;
 
   void StartTypingMonitor(const TypingMonitorOptions& settings);
@@ -433,6 +454,9 @@ class VoiceChannel : public BaseChannel {
   bool InsertDtmf_w(uint32 ssrc, int event, int duration, int flags);
   bool SetOutputScaling_w(uint32 ssrc, double left, double right);
   bool GetStats_w(VoiceMediaInfo* stats);
+  void SetRtpAudioLevelRate_w(int cms);
+  virtual void OnRtpAudioLevel_w(uint32 ssrc, int dbov);
+  void ReportRtpAudioLevels_w();
 
   virtual void OnMessage(talk_base::Message* pmsg);
   virtual void GetSrtpCiphers(std::vector<std::string>* ciphers) const;
@@ -452,6 +476,11 @@ class VoiceChannel : public BaseChannel {
   talk_base::scoped_ptr<VoiceMediaMonitor> media_monitor_;
   talk_base::scoped_ptr<AudioMonitor> audio_monitor_;
   talk_base::scoped_ptr<TypingMonitor> typing_monitor_;
+  // Written on the signaling thread, read by IsRtpAudioLevelMonitorRunning.
+  bool rtp_audio_level_monitoring_;
+  // The fields below are only used on the worker thread.
+  AudioLevelTracker rtp_audio_levels_;
+  int rtp_audio_level_rate_;
 };
 
 // VideoChannel is a specialization for video.
@@ -0,0 +1,148 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Lock-free per-channel packet counters. The packet path bumps the counters
+// with relaxed atomics; any thread can take a snapshot of one channel or of
+// every live channel without posting to the worker thread.
+
+#ifndef TALK_SESSION_MEDIA_CHANNELSTATS_H_
+#define TALK_SESSION_MEDIA_CHANNELSTATS_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "base/criticalsection.h"
+
+namespace cricket {
+
+// Plain copy of a ChannelCounters block, taken at |timestamp|.
+struct ChannelStatsSnapshot {
+  ChannelStatsSnapshot()
+      : timestamp(0),
+        bytes_sent(0),
+        packets_sent(0),
+        rtcp_packets_sent(0),
+        bytes_rcvd(0),
+        packets_rcvd(0),
+        rtcp_packets_rcvd(0),
+        packets_discarded(0) {
+  }
+
+  std::string content_name;
+  uint32 timestamp;  // talk_base::Time() when the snapshot was taken.
+  uint64 bytes_sent;
+  uint64 packets_sent;
+  uint64 rtcp_packets_sent;
+  uint64 bytes_rcvd;
+  uint64 packets_rcvd;
+  uint64 rtcp_packets_rcvd;
+  // Packets dropped by the channel itself (bad size, SRTP failure).
+  uint64 packets_discarded;
+};
+
+// Counters owned by a BaseChannel. Writers are expected to be the channel's
+// worker thread only, but since every field is a relaxed atomic the block may
+// be read concurrently from any thread. Fields are not updated as a group, so
+// a snapshot may be off by the packet that is in flight while it is taken.
+class ChannelCounters {
+ public:
+  explicit ChannelCounters(const std::string& content_name);
+  ~ChannelCounters();
+
+  void OnPacketSent(size_t len, bool rtcp) {
+    Bump(&bytes_sent_, len);
+    Bump(rtcp ? &rtcp_packets_sent_ : &packets_sent_, 1);
+  }
+  void OnPacketReceived(size_t len, bool rtcp) {
+    Bump(&bytes_rcvd_, len);
+    Bump(rtcp ? &rtcp_packets_rcvd_ : &packets_rcvd_, 1);
+  }
+  void OnPacketDiscarded() {
+    Bump(&packets_discarded_, 1);
+  }
+
+  // The content name is only read under the registry lock, so renaming is
+  // routed through here rather than exposed as a plain member.
+  void set_content_name(const std::string& content_name);
+
+  void GetSnapshot(ChannelStatsSnapshot* snapshot) const;
+
+ private:
+  typedef std::atomic<uint64> Counter;
+
+  static void Bump(Counter* counter, uint64 value) {
+    counter->fetch_add(value, std::memory_order_relaxed);
+  }
+  static uint64 Read(const Counter& counter) {
+    return counter.load(std::memory_order_relaxed);
+  }
+  // Requires the registry lock, which guards |content_name_|.
+  void GetSnapshot_l(uint32 now, ChannelStatsSnapshot* snapshot) const;
+
+  std::string content_name_;
+  Counter bytes_sent_;
+  Counter packets_sent_;
+  Counter rtcp_packets_sent_;
+  Counter bytes_rcvd_;
+  Counter packets_rcvd_;
+  Counter rtcp_packets_rcvd_;
+  Counter packets_discarded_;
+
+  friend class ChannelStatsRegistry;
+  DISALLOW_COPY_AND_ASSIGN(ChannelCounters);
+};
+
+// Process-wide list of live ChannelCounters. Counters register themselves on
+// construction and unregister on destruction; the lock is only taken then and
+// while snapshotting, never on the packet path.
+class ChannelStatsRegistry {
+ public:
+  static ChannelStatsRegistry* Instance();
+
+  // Appends one snapshot per live channel to |snapshots|.
+  void GetSnapshots(std::vector<ChannelStatsSnapshot>* snapshots) const;
+  size_t size() const;
+
+ private:
+  ChannelStatsRegistry() {}
+
+  void Register(ChannelCounters* counters);
+  void Unregister(ChannelCounters* counters);
+
+  mutable talk_base::CriticalSection crit_;
+  std::vector<ChannelCounters*> counters_;
+
+  friend class ChannelCounters;
+  DISALLOW_COPY_AND_ASSIGN(ChannelStatsRegistry);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SESSION_MEDIA_CHANNELSTATS_H_
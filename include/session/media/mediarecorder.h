@@ -49,8 +49,25 @@ class VideoChannel;
 class VoiceChannel;
 class RtpDumpWriter;
 
+// Settings for recording asynchronously, see RtpDumpSink::SetAsync().
+struct AsyncRecordingOptions {
+  AsyncRecordingOptions()
+      : ring_size(1024 * 1024),
+        write_size(64 * 1024),
+        reserve_size(0) {
+  }
+
+  // Bytes of packets that can be queued before new packets are dropped.
+  size_t ring_size;
+  // Queued bytes collected into each write to the stream.
+  size_t write_size;
+  // If non-zero, stream space reserved up front when recording starts.
+  size_t reserve_size;
+};
+
 // RtpDumpSink implements MediaSinkInterface by dumping the RTP/RTCP packets to
-// a file.
+// a file. RTCP packets are recorded too, in both the synchronous and the
+// asynchronous mode, unless the packet filter leaves out PF_RTCPPACKET.
 class RtpDumpSink : public MediaSinkInterface, public sigslot::has_slots<> {
  public:
   // Takes ownership of stream.
@@ -65,13 +82,29 @@ class RtpDumpSink : public MediaSinkInterface, public sigslot::has_slots<> {
   int packet_filter() const { return packet_filter_; }
   void Flush();
 
+  // Switches the sink to asynchronous recording. OnPacket() then only copies
+  // the packet into a lock-free ring and a dedicated thread writes the ring
+  // to the stream in large chunks, so a slow disk never stalls the media
+  // path. When the ring is full, packets are dropped and counted instead.
+  // Must be called before the sink is first enabled.
+  bool SetAsync(const AsyncRecordingOptions& options);
+  bool async() const { return async_options_.get() != NULL; }
+  // The number of packets dropped because the ring was full.
+  uint32 dropped_packets() const;
+
  private:
+  class AsyncWriter;
+
   size_t max_size_;
   bool recording_;
   int packet_filter_;
   talk_base::scoped_ptr<talk_base::StreamInterface> stream_;
   talk_base::scoped_ptr<RtpDumpWriter> writer_;
-  talk_base::CriticalSection critical_section_;
+  talk_base::scoped_ptr<AsyncRecordingOptions> async_options_;
+  talk_base::scoped_ptr<AsyncWriter> async_writer_;
+  // Bytes queued for the stream so far, checked against |max_size_|.
+  size_t queued_size_;
+  mutable talk_base::CriticalSection critical_section_;
 
   DISALLOW_COPY_AND_ASSIGN(RtpDumpSink);
 };
@@ -94,6 +127,13 @@ class MediaRecorder {
                      SinkType type);
   void FlushSinks();
 
+  // Makes the sinks of channels added from now on record asynchronously.
+  void EnableAsyncRecording(const AsyncRecordingOptions& options);
+  // Gets the packets the channel's sinks dropped because they couldn't keep
+  // up. Returns false if the channel isn't recorded.
+  bool GetDroppedPackets(BaseChannel* channel, uint32* send_dropped,
+                         uint32* recv_dropped);
+
  private:
   struct SinkPair {
     bool video_channel;
@@ -109,6 +149,7 @@ class MediaRecorder {
                           int filter);
 
   std::map<BaseChannel*, SinkPair*> sinks_;
+  talk_base::scoped_ptr<AsyncRecordingOptions> async_options_;
   talk_base::CriticalSection critical_section_;
 
   DISALLOW_COPY_AND_ASSIGN(MediaRecorder);
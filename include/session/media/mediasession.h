@@ -95,6 +95,11 @@ struct MediaSessionOptions {
   void AddStream(MediaType type,
                  const std::string& name,
                  const std::string& sync_label);
+  // Adds a video stream sent as |num_sim_layers| simulcast layers. The layers
+  // are offered as one StreamParams with an SSRC group of SIM semantics.
+  void AddVideoStream(const std::string& name,
+                      const std::string& sync_label,
+                      int num_sim_layers);
   void RemoveStream(MediaType type, const std::string& name);
 
   bool has_audio;
@@ -112,11 +117,19 @@ struct MediaSessionOptions {
     Stream(MediaType type,
            const std::string& name,
            const std::string& sync_label)
-        : type(type), name(name), sync_label(sync_label) {
+        : type(type), name(name), sync_label(sync_label), num_sim_layers(1) {
+    }
+    Stream(MediaType type,
+           const std::string& name,
+           const std::string& sync_label,
+           int num_sim_layers)
+        : type(type), name(name), sync_label(sync_label),
+          num_sim_layers(num_sim_layers) {
     }
     MediaType type;
     std::string name;
     std::string sync_label;
+    int num_sim_layers;
   };
 
   typedef std::vector<Stream> Streams;
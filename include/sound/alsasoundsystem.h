@@ -91,21 +91,24 @@ class AlsaSoundSystem : public SoundSystemInterface {
           size_t frame_size,
           int wait_timeout_ms,
           int flags,
-          int freq));
+          int freq,
+          size_t ring_size));
 
   SoundOutputStreamInterface *StartOutputStream(
       snd_pcm_t *handle,
       size_t frame_size,
       int wait_timeout_ms,
       int flags,
-      int freq);
+      int freq,
+      size_t ring_size);
 
   SoundInputStreamInterface *StartInputStream(
       snd_pcm_t *handle,
       size_t frame_size,
       int wait_timeout_ms,
       int flags,
-      int freq);
+      int freq,
+      size_t ring_size);
 
   const char *GetError(int err);
 
@@ -153,6 +153,7 @@ class PulseAudioSoundSystem : public SoundSystemInterface {
           int flags,
           pa_stream_flags_t pa_flags,
           int latency,
+          size_t ring_size,
           const pa_sample_spec &spec));
 
   SoundOutputStreamInterface *ConnectOutputStream(
@@ -161,6 +162,7 @@ class PulseAudioSoundSystem : public SoundSystemInterface {
       int flags,
       pa_stream_flags_t pa_flags,
       int latency,
+      size_t ring_size,
       const pa_sample_spec &spec);
 
   SoundInputStreamInterface *ConnectInputStream(
@@ -169,6 +171,7 @@ class PulseAudioSoundSystem : public SoundSystemInterface {
       int flags,
       pa_stream_flags_t pa_flags,
       int latency,
+      size_t ring_size,
       const pa_sample_spec &spec);
 
   bool FinishOperation(pa_operation *op);
@@ -33,6 +33,8 @@
 
 namespace cricket {
 
+struct SoundStreamStats;
+
 // Interface for consuming an input stream from a recording device.
 // Semantics and thread-safety of StartReading()/StopReading() are the same as
 // for talk_base::Worker.
@@ -64,6 +66,20 @@ class SoundInputStreamInterface {
   // Get the latency of the stream.
   virtual int LatencyUsecs() = 0;
 
+  // For streams opened with SoundSystemInterface::FLAG_RING_BUFFER, copies up
+  // to |size| bytes of captured samples into |buffer| and returns the number
+  // of bytes copied. Never blocks. While reading, this may be called from any
+  // one thread other than the reading thread.
+  virtual size_t ReadSamples(void *buffer, size_t size) {
+    return 0;
+  }
+
+  // Retrieves the ring buffer counters, for streams opened with
+  // SoundSystemInterface::FLAG_RING_BUFFER.
+  virtual bool GetStats(SoundStreamStats *stats) {
+    return false;
+  }
+
   // Notifies the consumer of new data read from the device.
   // The first parameter is a pointer to the data read, and is only valid for
   // the duration of the call.
@@ -33,6 +33,8 @@
 
 namespace cricket {
 
+struct SoundStreamStats;
+
 // Interface for outputting a stream to a playback device.
 // Semantics and thread-safety of EnableBufferMonitoring()/
 // DisableBufferMonitoring() are the same as for talk_base::Worker.
@@ -46,7 +48,10 @@ class SoundOutputStreamInterface {
   virtual bool DisableBufferMonitoring() = 0;
 
   // Write the given samples to the devices. If currently monitoring then this
-  // may only be called from the monitoring thread.
+  // may only be called from the monitoring thread. For streams opened with
+  // SoundSystemInterface::FLAG_RING_BUFFER, the samples are queued without
+  // blocking from any one thread other than the monitoring thread, and false
+  // means that they did not fit.
   virtual bool WriteSamples(const void *sample_data,
                             size_t size) = 0;
 
@@ -69,6 +74,12 @@ class SoundOutputStreamInterface {
   // Get the latency of the stream.
   virtual int LatencyUsecs() = 0;
 
+  // Retrieves the ring buffer counters, for streams opened with
+  // SoundSystemInterface::FLAG_RING_BUFFER.
+  virtual bool GetStats(SoundStreamStats *stats) {
+    return false;
+  }
+
   // Notifies the producer of the available buffer space for writes.
   // It fires continuously as long as the space is greater than zero.
   // The first parameter is the amount of buffer space available for data to
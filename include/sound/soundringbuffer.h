@@ -0,0 +1,137 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_SOUND_SOUNDRINGBUFFER_H_
+#define TALK_SOUND_SOUNDRINGBUFFER_H_
+
+#include <atomic>
+
+#include "base/basictypes.h"
+#include "base/constructormagic.h"
+#include "base/scoped_ptr.h"
+
+namespace cricket {
+
+// Counters for a stream opened with SoundSystemInterface::FLAG_RING_BUFFER.
+struct SoundStreamStats {
+  SoundStreamStats()
+      : callbacks(0),
+        underruns(0),
+        overruns(0),
+        buffered_bytes(0),
+        capacity_bytes(0),
+        mean_callback_interval_usecs(0),
+        max_callback_interval_usecs(0),
+        callback_jitter_usecs(0) {
+  }
+
+  // Number of times the device side serviced the ring.
+  uint64 callbacks;
+  // Number of times playback needed samples but the ring ran dry, and filled
+  // the gap with silence. Always 0 for capture, which can only overrun.
+  uint64 underruns;
+  // Number of times samples were dropped because the ring was full.
+  uint64 overruns;
+  // Bytes queued in the ring when the stats were taken.
+  size_t buffered_bytes;
+  size_t capacity_bytes;
+  // Time between device callbacks. The jitter is the smoothed difference
+  // between consecutive intervals, as RFC 3550 computes it for packets.
+  int mean_callback_interval_usecs;
+  int max_callback_interval_usecs;
+  int callback_jitter_usecs;
+};
+
+// Single-producer, single-consumer byte ring. Write() and Read() never block
+// or take locks, so the device thread can hand samples to and from the
+// consumer without waiting on it. Write() may be called from one thread and
+// Read() from another; everything else may be called from either.
+class SoundRingBuffer {
+ public:
+  explicit SoundRingBuffer(size_t capacity);
+
+  size_t capacity() const { return capacity_; }
+  // Bytes that can be read. Exact on the consumer thread, a lower bound
+  // elsewhere.
+  size_t Size() const;
+  // Bytes that can be written. Exact on the producer thread, a lower bound
+  // elsewhere.
+  size_t Space() const;
+
+  // Producer. Copies all of |data| into the ring, or nothing if it doesn't
+  // fit, so that whole frames are never split by a full ring.
+  bool Write(const void *data, size_t size);
+  // Consumer. Copies up to |size| bytes into |data| and returns the number of
+  // bytes copied.
+  size_t Read(void *data, size_t size);
+
+ private:
+  const size_t capacity_;
+  talk_base::scoped_array<char> buffer_;
+  // Total bytes ever written and read; the difference is what's queued.
+  // 64 bits even on 32-bit builds, where a size_t would wrap after 4 GiB and
+  // break the offsets of a capacity that is not a power of two.
+  std::atomic<uint64> write_pos_;
+  std::atomic<uint64> read_pos_;
+
+  DISALLOW_COPY_AND_ASSIGN(SoundRingBuffer);
+};
+
+// Keeps the SoundStreamStats of one stream. OnCallback() must only be called
+// from the device thread; the other methods may be called from any thread.
+class SoundStreamMonitor {
+ public:
+  SoundStreamMonitor();
+
+  // Records a device callback at |now_ns|, in talk_base::SystemTimeNanos().
+  void OnCallback(uint64 now_ns);
+  void OnUnderrun();
+  void OnOverrun();
+
+  // Fills everything but the buffer sizes.
+  void GetStats(SoundStreamStats *stats) const;
+
+ private:
+  std::atomic<uint64> callbacks_;
+  std::atomic<uint64> underruns_;
+  std::atomic<uint64> overruns_;
+  std::atomic<int> mean_interval_usecs_;
+  std::atomic<int> max_interval_usecs_;
+  std::atomic<int> jitter_usecs_;
+  // Device thread only.
+  uint64 last_callback_ns_;
+  int last_interval_usecs_;
+  // Sums in Q4, for the smoothed averages.
+  int mean_interval_q4_;
+  int jitter_q4_;
+
+  DISALLOW_COPY_AND_ASSIGN(SoundStreamMonitor);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SOUND_SOUNDRINGBUFFER_H_
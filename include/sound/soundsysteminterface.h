@@ -28,6 +28,8 @@
 #ifndef TALK_SOUND_SOUNDSYSTEMINTERFACE_H_
 #define TALK_SOUND_SOUNDSYSTEMINTERFACE_H_
 
+#include <stddef.h>
+
 #include <vector>
 
 #include "base/constructormagic.h"
@@ -59,6 +61,13 @@ class SoundSystemInterface {
     // Enable reporting the current stream latency in
     // Sound(Input|Output)StreamInterface. See those classes for more details.
     FLAG_REPORT_LATENCY = (1 << 0),
+    // Move samples between the device and the consumer through a lock-free
+    // ring buffer instead of signals on a worker thread. Captured samples are
+    // fetched with SoundInputStreamInterface::ReadSamples() while reading.
+    // SoundOutputStreamInterface::WriteSamples() only queues samples, which
+    // the device pulls while buffer monitoring is enabled. Neither stream
+    // emits its signal in this mode.
+    FLAG_RING_BUFFER = (1 << 1),
   };
 
   struct OpenParams {
@@ -72,6 +81,10 @@ class SoundSystemInterface {
     int flags;
     // Desired latency, measured as number of bytes of sample data
     int latency;
+    // Size of the ring buffer for FLAG_RING_BUFFER, in bytes of sample data.
+    // This bounds the latency the ring can add on top of |latency|. Use 0 for
+    // kDefaultRingBufferMsecs worth of samples.
+    int ring_buffer_size;
   };
 
   // Special values for the "latency" field of OpenParams.
@@ -83,6 +96,9 @@ class SoundSystemInterface {
   // a slightly higher one in the event that the true minimum requires an
   // undesirable trade-off.
   static const int kLowLatency = 0;
+
+  // Default duration of the ring buffer for FLAG_RING_BUFFER.
+  static const int kDefaultRingBufferMsecs = 100;
  
   // Max value for the volume parameters for Sound(Input|Output)StreamInterface.
   static const int kMaxVolume = 255;
@@ -92,6 +108,10 @@ class SoundSystemInterface {
   // Helper for clearing a locator list and deleting the entries.
   static void ClearSoundDeviceLocatorList(SoundDeviceLocatorList *devices);
 
+  // Returns the ring buffer size in bytes to use for |params|, or 0 if the
+  // stream should not use a ring buffer.
+  static size_t RingBufferSize(const OpenParams &params);
+
   virtual ~SoundSystemInterface() {}
 
   virtual bool Init() = 0;
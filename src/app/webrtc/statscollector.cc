@@ -30,6 +30,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/criticalsection.h"
 #include "session/media/channel.h"
 
 namespace webrtc {
@@ -58,19 +59,112 @@ const char StatsElement::kStatsValueNameJitterReceived[] = "googJitterReceived";
 const char StatsElement::kStatsValueNameNacksReceived[] = "googNacksReceived";
 const char StatsElement::kStatsValueNameNacksSent[] = "googNacksSent";
 const char StatsElement::kStatsValueNameRtt[] = "googRtt";
+const char StatsElement::kStatsValueNameRtcpPacketsSent[] =
+    "googRtcpPacketsSent";
+const char StatsElement::kStatsValueNameRtcpPacketsReceived[] =
+    "googRtcpPacketsReceived";
+const char StatsElement::kStatsValueNamePacketsDiscarded[] =
+    "googPacketsDiscarded";
 
 const char StatsReport::kStatsReportTypeSsrc[] = "ssrc";
+const char StatsReport::kStatsReportTypeChannel[] = "googChannel";
+
+namespace {
+
+// Maps a value name to its canonical pointer. The map is seeded with the
+// predefined names so that interning "bytesSent" yields
+// kStatsValueNameBytesSent; names outside that list point into the map's own
+// keys, which are never erased.
+class StatsNameTable {
+ public:
+  StatsNameTable() {
+    static const char* const kKnownNames[] = {
+      StatsElement::kStatsValueNameAudioOutputLevel,
+      StatsElement::kStatsValueNameAudioInputLevel,
+      StatsElement::kStatsValueNameBytesSent,
+      StatsElement::kStatsValueNamePacketsSent,
+      StatsElement::kStatsValueNameBytesReceived,
+      StatsElement::kStatsValueNamePacketsReceived,
+      StatsElement::kStatsValueNamePacketsLost,
+      StatsElement::kStatsValueNameFirsReceived,
+      StatsElement::kStatsValueNameFirsSent,
+      StatsElement::kStatsValueNameFrameHeightReceived,
+      StatsElement::kStatsValueNameFrameHeightSent,
+      StatsElement::kStatsValueNameFrameRateReceived,
+      StatsElement::kStatsValueNameFrameRateSent,
+      StatsElement::kStatsValueNameFrameWidthReceived,
+      StatsElement::kStatsValueNameFrameWidthSent,
+      StatsElement::kStatsValueNameJitterReceived,
+      StatsElement::kStatsValueNameNacksReceived,
+      StatsElement::kStatsValueNameNacksSent,
+      StatsElement::kStatsValueNameRtt,
+      StatsElement::kStatsValueNameRtcpPacketsSent,
+      StatsElement::kStatsValueNameRtcpPacketsReceived,
+      StatsElement::kStatsValueNamePacketsDiscarded,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(kKnownNames); ++i) {
+      names_[kKnownNames[i]] = kKnownNames[i];
+    }
+  }
+
+  const char* Intern(const std::string& name) {
+    talk_base::CritScope cs(&crit_);
+    NameMap::iterator it = names_.find(name);
+    if (it == names_.end()) {
+      it = names_.insert(std::make_pair(name, static_cast<const char*>(NULL)))
+          .first;
+      it->second = it->first.c_str();
+    }
+    return it->second;
+  }
+
+ private:
+  typedef std::map<std::string, const char*> NameMap;
+  talk_base::CriticalSection crit_;
+  NameMap names_;
+};
+
+}  // namespace
 
 // Implementations of functions in statstypes.h
-void StatsElement::AddValue(const std::string& name, const std::string& value) {
-  Value temp;
+void StatsElement::AddValue(const char* name, const std::string& value) {
+  ASSERT(name == InternName(name));
+  values.push_back(Value());
+  Value& temp = values.back();
   temp.name = name;
   temp.value = value;
-  values.push_back(temp);
+}
+
+void StatsElement::AddValue(const char* name, int64 value) {
+  ASSERT(name == InternName(name));
+  values.push_back(Value());
+  Value& temp = values.back();
+  temp.name = name;
+  temp.value = talk_base::ToString<int64>(value);
+  temp.int_value = value;
+  temp.has_int_value = true;
+}
+
+void StatsElement::AddValue(const std::string& name, const std::string& value) {
+  AddValue(InternName(name), value);
 }
 
 void StatsElement::AddValue(const std::string& name, int64 value) {
-  AddValue(name, talk_base::ToString<int64>(value));
+  AddValue(InternName(name), value);
+}
+
+const StatsElement::Value* StatsElement::FindValue(const char* name) const {
+  for (Values::const_iterator it = values.begin(); it != values.end(); ++it) {
+    if (it->name == name) {
+      return &(*it);
+    }
+  }
+  return NULL;
+}
+
+const char* StatsElement::InternName(const std::string& name) {
+  LIBJINGLE_DEFINE_STATIC_LOCAL(StatsNameTable, table, ());
+  return table.Intern(name);
 }
 
 namespace {
@@ -163,6 +257,24 @@ void ExtractStats(const cricket::VideoSenderInfo& info, StatsReport* report) {
   report->remote.AddValue(StatsElement::kStatsValueNameRtt, info.rtt_ms);
 }
 
+void ExtractStats(const cricket::ChannelStatsSnapshot& info,
+                  StatsReport* report) {
+  report->local.AddValue(StatsElement::kStatsValueNameBytesSent,
+                         static_cast<int64>(info.bytes_sent));
+  report->local.AddValue(StatsElement::kStatsValueNamePacketsSent,
+                         static_cast<int64>(info.packets_sent));
+  report->local.AddValue(StatsElement::kStatsValueNameRtcpPacketsSent,
+                         static_cast<int64>(info.rtcp_packets_sent));
+  report->local.AddValue(StatsElement::kStatsValueNameBytesReceived,
+                         static_cast<int64>(info.bytes_rcvd));
+  report->local.AddValue(StatsElement::kStatsValueNamePacketsReceived,
+                         static_cast<int64>(info.packets_rcvd));
+  report->local.AddValue(StatsElement::kStatsValueNameRtcpPacketsReceived,
+                         static_cast<int64>(info.rtcp_packets_rcvd));
+  report->local.AddValue(StatsElement::kStatsValueNamePacketsDiscarded,
+                         static_cast<int64>(info.packets_discarded));
+}
+
 uint32 ExtractSsrc(const cricket::VoiceReceiverInfo& info) {
   return info.ssrc;
 }
@@ -236,6 +348,9 @@ bool StatsCollector::GetStats(MediaStreamTrackInterface* track,
   for (; it != track_reports_.end(); ++it) {
     reports->push_back(it->second);
   }
+  for (it = channel_reports_.begin(); it != channel_reports_.end(); ++it) {
+    reports->push_back(it->second);
+  }
 
   return true;
 }
@@ -253,6 +368,8 @@ void StatsCollector::UpdateStats() {
   if (session_) {
     ExtractVoiceInfo();
     ExtractVideoInfo();
+    ExtractChannelInfo(session_->voice_channel());
+    ExtractChannelInfo(session_->video_channel());
   }
 }
 
@@ -303,6 +420,23 @@ void StatsCollector::ExtractVideoInfo() {
   ExtractStatsFromList(video_info.senders, this);
 }
 
+// Unlike the media engine stats above, the channel counters are read
+// directly from this thread; no call is marshalled to the worker thread.
+void StatsCollector::ExtractChannelInfo(cricket::BaseChannel* channel) {
+  if (!channel) {
+    return;
+  }
+  cricket::ChannelStatsSnapshot snapshot;
+  channel->counters().GetSnapshot(&snapshot);
+
+  StatsReport* report = &channel_reports_[snapshot.content_name];
+  report->id = snapshot.content_name;
+  report->type = StatsReport::kStatsReportTypeChannel;
+  report->local.values.clear();
+  report->local.timestamp = stats_gathering_started_;
+  ExtractStats(snapshot, report);
+}
+
 double StatsCollector::GetTimeNow() {
   return timing_.WallTimeNow() * talk_base::kNumMillisecsPerSec;
 }
@@ -29,6 +29,7 @@
 
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
 #include <string>
 #include <vector>
@@ -185,6 +186,12 @@ static const char kApplicationSpecificMaximum[] = "AS";
 
 static const int kDefaultVideoClockrate = 90000;
 
+// Rough serialized sizes used to reserve the output buffer once.
+static const size_t kSdpSessionSizeHint = 256;
+static const size_t kSdpMediaSizeHint = 1536;
+static const size_t kSdpSsrcSizeHint = 256;
+static const size_t kSdpCandidateSizeHint = 128;
+
 // http://tools.ietf.org/html/draft-spittka-payload-rtp-opus-03
 static const char kOpusRtpMap[] = "opus/48000/2";
 
@@ -368,13 +375,10 @@ static bool GetLine(const std::string& message,
   if (line_end == std::string::npos) {
     return false;
   }
-  // Update the new start position
-  *pos = line_end + 1;
-  if (line_end > 0 && (message.at(line_end - 1) == '\r')) {
+  size_t next_pos = line_end + 1;
+  if (line_end > line_begin && (message[line_end - 1] == '\r')) {
     --line_end;
   }
-  *line = message.substr(line_begin, (line_end - line_begin));
-  const char* cline = line->c_str();
   // RFC 4566
   // An SDP session description consists of a number of lines of text of
   // the form:
@@ -382,35 +386,64 @@ static bool GetLine(const std::string& message,
   // where <type> MUST be exactly one case-significant character and
   // <value> is structured text whose format depends on <type>.
   // Whitespace MUST NOT be used on either side of the "=" sign.
-  if (cline[0] == kSdpDelimiterSpace ||
+  // Validate in place so that a rejected line is never copied out.
+  const size_t length = line_end - line_begin;
+  const char* cline = message.data() + line_begin;
+  if (length < kLinePrefixLength ||
+      cline[0] == kSdpDelimiterSpace ||
       cline[1] != kSdpDelimiterEqual ||
-      cline[2] == kSdpDelimiterSpace) {
-    *pos = line_begin;
+      (length > kLinePrefixLength && cline[2] == kSdpDelimiterSpace)) {
     return false;
   }
+  // assign() reuses the capacity |line| already has, so walking a message
+  // line by line doesn't allocate once the buffer has grown to fit.
+  line->assign(cline, length);
+  *pos = next_pos;
   return true;
 }
 
-// Init the |os| to "|type|=|value|".
+// Appends the decimal form of |value| to |str|. Used instead of streaming
+// through an ostringstream when building SDP lines.
+static void AppendInt(int64 value, std::string* str) {
+  char buf[24];
+  char* end = buf + sizeof(buf);
+  char* p = end;
+  uint64 magnitude = value < 0 ? 0 - static_cast<uint64>(value) :
+                                 static_cast<uint64>(value);
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    *--p = '-';
+  }
+  str->append(p, end - p);
+}
+
+// Init the |line| to "|type|=|value|". The capacity of |line| is kept, so
+// reusing one buffer for consecutive lines doesn't reallocate.
 static void InitLine(const char type,
                      const std::string& value,
-                     std::ostringstream* os) {
-  os->str("");
-  *os << type << kSdpDelimiterEqual << value;
+                     std::string* line) {
+  line->clear();
+  line->push_back(type);
+  line->push_back(kSdpDelimiterEqual);
+  line->append(value);
 }
 
-// Init the |os| to "a=|attribute|".
-static void InitAttrLine(const std::string& attribute, std::ostringstream* os) {
-  InitLine(kLineTypeAttributes, attribute, os);
+// Init the |line| to "a=|attribute|".
+static void InitAttrLine(const std::string& attribute, std::string* line) {
+  InitLine(kLineTypeAttributes, attribute, line);
 }
 
 // Writes a SDP attribute line based on |attribute| and |value| to |message|.
 static void AddAttributeLine(const std::string& attribute, int value,
                              std::string* message) {
-  std::ostringstream os;
-  InitAttrLine(attribute, &os);
-  os << kSdpDelimiterColon << value;
-  AddLine(os.str(), message);
+  std::string line;
+  InitAttrLine(attribute, &line);
+  line.push_back(kSdpDelimiterColon);
+  AppendInt(value, &line);
+  AddLine(line, message);
 }
 
 // Returns the first line of the message without the line breaker.
@@ -475,11 +508,21 @@ static bool AddSsrcLine(uint32 ssrc_id, const std::string& attribute,
                         const std::string& value, std::string* message) {
   // RFC 5576
   // a=ssrc:<ssrc-id> <attribute>:<value>
-  std::ostringstream os;
-  InitAttrLine(kAttributeSsrc, &os);
-  os << kSdpDelimiterColon << ssrc_id << kSdpDelimiterSpace
-     << attribute << kSdpDelimiterColon << value;
-  return AddLine(os.str(), message);
+  if (!message)
+    return false;
+
+  // Written straight into |message|; this runs four times per ssrc.
+  message->push_back(kLineTypeAttributes);
+  message->push_back(kSdpDelimiterEqual);
+  message->append(kAttributeSsrc);
+  message->push_back(kSdpDelimiterColon);
+  AppendInt(ssrc_id, message);
+  message->push_back(kSdpDelimiterSpace);
+  message->append(attribute);
+  message->push_back(kSdpDelimiterColon);
+  message->append(value);
+  message->append(kLineBreak);
+  return true;
 }
 
 // Split the message into two parts by the first delimiter.
@@ -514,6 +557,154 @@ static bool GetValue(const std::string& message, const std::string& attribute,
   return true;
 }
 
+// A non-owning view of a field inside an SDP line. The parser splits hot
+// lines (candidates, ssrcs) into these instead of into copied strings.
+struct SdpField {
+  SdpField() : data(NULL), length(0) {}
+  SdpField(const char* d, size_t l) : data(d), length(l) {}
+
+  bool Equals(const char* str) const {
+    return strlen(str) == length && memcmp(data, str, length) == 0;
+  }
+  std::string ToString() const { return std::string(data, length); }
+
+  const char* data;
+  size_t length;
+};
+typedef std::vector<SdpField> SdpFields;
+
+// Same as talk_base::split on |source| from |start|, but without copying.
+// The fields point into |source| and are only valid while it is.
+static size_t SplitFields(const std::string& source, size_t start,
+                          const char delimiter, SdpFields* fields) {
+  ASSERT(fields != NULL);
+  fields->clear();
+  const char* begin = source.data() + std::min(start, source.size());
+  const char* end = source.data() + source.size();
+  const char* last = begin;
+  for (const char* p = begin; p != end; ++p) {
+    if (*p == delimiter) {
+      fields->push_back(SdpField(last, p - last));
+      last = p + 1;
+    }
+  }
+  fields->push_back(SdpField(last, end - last));
+  return fields->size();
+}
+
+// Parses the leading decimal digits of |field|, like FromString<uint32>
+// does for the well-formed numbers SDP carries, without a stringstream.
+static uint32 FieldToUint(const SdpField& field) {
+  uint32 value = 0;
+  for (size_t i = 0; i < field.length; ++i) {
+    const char c = field.data[i];
+    if (c < '0' || c > '9')
+      break;
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
+
+// Get value only from <attribute>:<value> held in |field|.
+static bool GetValue(const SdpField& field, const std::string& attribute,
+                     std::string* value, SdpParseError* error) {
+  const char* colon = static_cast<const char*>(
+      memchr(field.data, kSdpDelimiterColon, field.length));
+  const size_t left_length = colon ? colon - field.data : 0;
+  if (!colon || left_length < attribute.length() ||
+      attribute.compare(0, attribute.length(),
+                        colon - attribute.length(),
+                        attribute.length()) != 0) {
+    return ParseFailedGetValue(field.ToString(), attribute, error);
+  }
+  value->assign(colon + 1, field.length - left_length - 1);
+  return true;
+}
+
+// The "a=" attributes the parser acts on.
+enum SdpAttributeType {
+  SDP_ATTR_UNKNOWN,
+  SDP_ATTR_CANDIDATE,
+  SDP_ATTR_CRYPTO,
+  SDP_ATTR_EXTMAP,
+  SDP_ATTR_FINGERPRINT,
+  SDP_ATTR_FMTP,
+  SDP_ATTR_GROUP,
+  SDP_ATTR_ICE_OPTIONS,
+  SDP_ATTR_ICE_PWD,
+  SDP_ATTR_ICE_UFRAG,
+  SDP_ATTR_INACTIVE,
+  SDP_ATTR_MAXPTIME,
+  SDP_ATTR_MID,
+  SDP_ATTR_MSID_SEMANTICS,
+  SDP_ATTR_PTIME,
+  SDP_ATTR_RECVONLY,
+  SDP_ATTR_RTCP_MUX,
+  SDP_ATTR_RTPMAP,
+  SDP_ATTR_SENDONLY,
+  SDP_ATTR_SENDRECV,
+  SDP_ATTR_SSRC,
+  SDP_ATTR_SSRC_GROUP,
+};
+
+// Classifies the "a=" |line| by its attribute name, i.e. the text up to the
+// first ':' or ' '. Switching on the first character leaves at most four
+// exact compares per line, instead of trying every known attribute in turn.
+static SdpAttributeType GetAttributeType(const std::string& line) {
+  if (line.size() <= static_cast<size_t>(kLinePrefixLength)) {
+    return SDP_ATTR_UNKNOWN;
+  }
+  const char* begin = line.data() + kLinePrefixLength;
+  const char* end = line.data() + line.size();
+  const char* p = begin;
+  while (p != end && *p != kSdpDelimiterColon && *p != kSdpDelimiterSpace) {
+    ++p;
+  }
+  const SdpField name(begin, p - begin);
+  switch (name.data[0]) {
+    case 'c':
+      if (name.Equals(kAttributeCandidate)) return SDP_ATTR_CANDIDATE;
+      if (name.Equals(kAttributeCrypto)) return SDP_ATTR_CRYPTO;
+      break;
+    case 'e':
+      if (name.Equals(kAttributeExtmap)) return SDP_ATTR_EXTMAP;
+      break;
+    case 'f':
+      if (name.Equals(kAttributeFingerprint)) return SDP_ATTR_FINGERPRINT;
+      if (name.Equals(kAttributeFmtp)) return SDP_ATTR_FMTP;
+      break;
+    case 'g':
+      if (name.Equals(kAttributeGroup)) return SDP_ATTR_GROUP;
+      break;
+    case 'i':
+      if (name.Equals(kAttributeIceUfrag)) return SDP_ATTR_ICE_UFRAG;
+      if (name.Equals(kAttributeIcePwd)) return SDP_ATTR_ICE_PWD;
+      if (name.Equals(kAttributeIceOption)) return SDP_ATTR_ICE_OPTIONS;
+      if (name.Equals(kAttributeInactive)) return SDP_ATTR_INACTIVE;
+      break;
+    case 'm':
+      if (name.Equals(kAttributeMid)) return SDP_ATTR_MID;
+      if (name.Equals(kAttributeMsidSemantics)) return SDP_ATTR_MSID_SEMANTICS;
+      if (name.Equals(kCodecParamMaxPTime)) return SDP_ATTR_MAXPTIME;
+      break;
+    case 'p':
+      if (name.Equals(kCodecParamPTime)) return SDP_ATTR_PTIME;
+      break;
+    case 'r':
+      if (name.Equals(kAttributeRtpmap)) return SDP_ATTR_RTPMAP;
+      if (name.Equals(kAttributeRtcpMux)) return SDP_ATTR_RTCP_MUX;
+      if (name.Equals(kAttributeRecvOnly)) return SDP_ATTR_RECVONLY;
+      break;
+    case 's':
+      if (name.Equals(kAttributeSsrc)) return SDP_ATTR_SSRC;
+      if (name.Equals(kAttributeSsrcGroup)) return SDP_ATTR_SSRC_GROUP;
+      if (name.Equals(kAttributeSendRecv)) return SDP_ATTR_SENDRECV;
+      if (name.Equals(kAttributeSendOnly)) return SDP_ATTR_SENDONLY;
+      break;
+  }
+  return SDP_ATTR_UNKNOWN;
+}
+
 void CreateTracksFromSsrcInfos(const SsrcInfoVec& ssrc_infos,
                                StreamParamsVec* tracks) {
   ASSERT(tracks != NULL);
@@ -627,7 +818,7 @@ static bool GetDefaultDestination(const std::vector<Candidate>& candidates,
 // Update the media default destination.
 static void UpdateMediaDefaultDestination(
     const std::vector<Candidate>& candidates, std::string* mline) {
-  std::ostringstream os;
+  std::string line;
   std::string rtp_port, rtp_ip;
   if (GetDefaultDestination(candidates, ICE_CANDIDATE_COMPONENT_RTP,
                             &rtp_port, &rtp_ip)) {
@@ -656,9 +847,12 @@ static void UpdateMediaDefaultDestination(
     // Add the c line.
     // RFC 4566
     // c=<nettype> <addrtype> <connection-address>
-    InitLine(kLineTypeConnection, kConnectionNettype, &os);
-    os << " " << kConnectionAddrtype << " " << rtp_ip;
-    AddLine(os.str(), mline);
+    InitLine(kLineTypeConnection, kConnectionNettype, &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(kConnectionAddrtype);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(rtp_ip);
+    AddLine(line, mline);
   }
 
   std::string rtcp_port, rtcp_ip;
@@ -672,14 +866,38 @@ static void UpdateMediaDefaultDestination(
     // RFC 3605
     // rtcp-attribute =  "a=rtcp:" port  [nettype space addrtype space
     // connection-address] CRLF
-    InitAttrLine(kAttributeRtcp, &os);
-    os << kSdpDelimiterColon
-       << rtcp_port << " "
-       << kConnectionNettype << " "
-       << kConnectionAddrtype << " "
-       << rtcp_ip;
-    AddLine(os.str(), mline);
+    InitAttrLine(kAttributeRtcp, &line);
+    line.push_back(kSdpDelimiterColon);
+    line.append(rtcp_port);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(kConnectionNettype);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(kConnectionAddrtype);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(rtcp_ip);
+    AddLine(line, mline);
+  }
+}
+
+// Returns a guess of the serialized size of |desc| without candidates, used
+// to size the output buffer up front.
+static size_t EstimateSdpSize(const cricket::SessionDescription* desc) {
+  size_t size = kSdpSessionSizeHint;
+  for (cricket::ContentInfos::const_iterator content =
+           desc->contents().begin();
+       content != desc->contents().end(); ++content) {
+    size += kSdpMediaSizeHint;
+    const MediaContentDescription* media_desc =
+        static_cast<const MediaContentDescription*>(content->description);
+    if (!media_desc) {
+      continue;
+    }
+    for (StreamParamsVec::const_iterator track = media_desc->streams().begin();
+         track != media_desc->streams().end(); ++track) {
+      size += track->ssrcs.size() * kSdpSsrcSizeHint;
+    }
   }
+  return size;
 }
 
 // Get candidates according to the mline index from SessionDescriptionInterface.
@@ -699,7 +917,15 @@ static void GetCandidatesByMindex(const SessionDescriptionInterface& desci,
 std::string SdpSerialize(const JsepSessionDescription& jdesc) {
   std::string sdp = SdpSerializeSessionDescription(jdesc);
 
+  // Reserve once for the session description plus every candidate line, so
+  // that splicing the candidates in doesn't keep regrowing the output.
+  size_t candidate_count = 0;
+  for (size_t i = 0; i < jdesc.number_of_mediasections(); ++i) {
+    candidate_count += jdesc.candidates(i)->count();
+  }
   std::string sdp_with_candidates;
+  sdp_with_candidates.reserve(sdp.size() +
+                              candidate_count * kSdpCandidateSizeHint);
   size_t pos = 0;
   std::string line;
   int mline_index = -1;
@@ -720,9 +946,8 @@ std::string SdpSerialize(const JsepSessionDescription& jdesc) {
       AddLine(line, &sdp_with_candidates);
     }
   }
-  sdp = sdp_with_candidates;
 
-  return sdp;
+  return sdp_with_candidates;
 }
 
 std::string SdpSerializeSessionDescription(
@@ -733,6 +958,7 @@ std::string SdpSerializeSessionDescription(
   }
 
   std::string message;
+  message.reserve(EstimateSdpSize(desc));
 
   // Session Description.
   AddLine(kSessionVersion, &message);
@@ -740,16 +966,23 @@ std::string SdpSerializeSessionDescription(
   // RFC 4566
   // o=<username> <sess-id> <sess-version> <nettype> <addrtype>
   // <unicast-address>
-  std::ostringstream os;
-  InitLine(kLineTypeOrigin, kSessionOriginUsername, &os);
+  std::string line;
+  InitLine(kLineTypeOrigin, kSessionOriginUsername, &line);
   const std::string session_id = jdesc.session_id().empty() ?
       kSessionOriginSessionId : jdesc.session_id();
   const std::string session_version = jdesc.session_version().empty() ?
       kSessionOriginSessionVersion : jdesc.session_version();
-  os << " " << session_id << " " << session_version << " "
-     << kSessionOriginNettype << " " << kSessionOriginAddrtype << " "
-     << kSessionOriginAddress;
-  AddLine(os.str(), &message);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(session_id);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(session_version);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(kSessionOriginNettype);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(kSessionOriginAddrtype);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(kSessionOriginAddress);
+  AddLine(line, &message);
   AddLine(kSessionName, &message);
 
   // Time Description.
@@ -771,8 +1004,10 @@ std::string SdpSerializeSessionDescription(
   }
 
   // MediaStream semantics
-  InitAttrLine(kAttributeMsidSemantics, &os);
-  os << kSdpDelimiterColon << " " << kMediaStreamSematic;
+  InitAttrLine(kAttributeMsidSemantics, &line);
+  line.push_back(kSdpDelimiterColon);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(kMediaStreamSematic);
   std::set<std::string> media_stream_labels;
   const ContentInfo* audio_content = GetFirstAudioContent(desc);
   if (audio_content)
@@ -782,9 +1017,10 @@ std::string SdpSerializeSessionDescription(
     GetMediaStreamLabels(video_content, &media_stream_labels);
   for (std::set<std::string>::const_iterator it =
       media_stream_labels.begin(); it != media_stream_labels.end(); ++it) {
-    os << " " << *it;
+    line.push_back(kSdpDelimiterSpace);
+    line.append(*it);
   }
-  AddLine(os.str(), &message);
+  AddLine(line, &message);
 
   if (audio_content) {
     BuildMediaDescription(audio_content,
@@ -904,9 +1140,10 @@ bool ParseCandidate(const std::string& message, Candidate* candidate,
     }
   }
 
-  std::vector<std::string> fields;
-  talk_base::split(first_line.substr(start_pos),
-                   kSdpDelimiterSpace, &fields);
+  // Candidate lines dominate large descriptions, so the fields are looked
+  // at in place and only the ones we keep are copied out.
+  SdpFields fields;
+  SplitFields(first_line, start_pos, kSdpDelimiterSpace, &fields);
   // RFC 5245
   // a=candidate:<foundation> <component-id> <transport> <priority>
   // <connection-address> <port> typ <candidate-types>
@@ -914,18 +1151,18 @@ bool ParseCandidate(const std::string& message, Candidate* candidate,
   // *(SP extension-att-name SP extension-att-value)
   const size_t expected_min_fields = 8;
   if (fields.size() < expected_min_fields ||
-      (fields[6] != kAttributeCandidateTyp)) {
+      !fields[6].Equals(kAttributeCandidateTyp)) {
     return ParseFailedExpectMinFieldNum(first_line, expected_min_fields, error);
   }
   std::string foundation;
   if (!GetValue(fields[0], kAttributeCandidate, &foundation, error)) {
     return false;
   }
-  const int component_id = talk_base::FromString<int>(fields[1]);
-  const std::string transport = fields[2];
-  const uint32 priority = talk_base::FromString<uint32>(fields[3]);
-  const std::string connection_address = fields[4];
-  const int port = talk_base::FromString<int>(fields[5]);
+  const int component_id = FieldToUint(fields[1]);
+  const std::string transport = fields[2].ToString();
+  const uint32 priority = FieldToUint(fields[3]);
+  const std::string connection_address = fields[4].ToString();
+  const int port = FieldToUint(fields[5]);
   SocketAddress address(connection_address, port);
 
   cricket::ProtocolType protocol;
@@ -934,12 +1171,12 @@ bool ParseCandidate(const std::string& message, Candidate* candidate,
   }
 
   std::string candidate_type;
-  const std::string type = fields[7];
-  if (type == kCandidateHost) {
+  const SdpField& type = fields[7];
+  if (type.Equals(kCandidateHost)) {
     candidate_type = cricket::LOCAL_PORT_TYPE;
-  } else if (type == kCandidateSrflx) {
+  } else if (type.Equals(kCandidateSrflx)) {
     candidate_type = cricket::STUN_PORT_TYPE;
-  } else if (type == kCandidateRelay) {
+  } else if (type.Equals(kCandidateRelay)) {
     candidate_type = cricket::RELAY_PORT_TYPE;
   } else {
     return ParseFailed(first_line, "Unsupported candidate type.", error);
@@ -950,14 +1187,13 @@ bool ParseCandidate(const std::string& message, Candidate* candidate,
   // The 2 optional fields for related address
   // [raddr <connection-address>] [rport <port>]
   if (fields.size() >= (current_position + 2) &&
-      fields[current_position] == kAttributeCandidateRaddr) {
-    related_address.SetIP(fields[++current_position]);
+      fields[current_position].Equals(kAttributeCandidateRaddr)) {
+    related_address.SetIP(fields[++current_position].ToString());
     ++current_position;
   }
   if (fields.size() >= (current_position + 2) &&
-      fields[current_position] == kAttributeCandidateRport) {
-    related_address.SetPort(
-        talk_base::FromString<int>(fields[++current_position]));
+      fields[current_position].Equals(kAttributeCandidateRport)) {
+    related_address.SetPort(FieldToUint(fields[++current_position]));
     ++current_position;
   }
 
@@ -972,12 +1208,12 @@ bool ParseCandidate(const std::string& message, Candidate* candidate,
   for (size_t i = current_position; i + 1 < fields.size(); ++i) {
     // RFC 5245
     // *(SP extension-att-name SP extension-att-value)
-    if (fields[i] == kAttributeCandidateGeneration) {
-      generation = talk_base::FromString<uint32>(fields[++i]);
-    } else if (fields[i] == kAttributeCandidateUsername) {
-      username = fields[++i];
-    } else if (fields[i] == kAttributeCandidatePassword) {
-      password = fields[++i];
+    if (fields[i].Equals(kAttributeCandidateGeneration)) {
+      generation = FieldToUint(fields[++i]);
+    } else if (fields[i].Equals(kAttributeCandidateUsername)) {
+      username = fields[++i].ToString();
+    } else if (fields[i].Equals(kAttributeCandidatePassword)) {
+      password = fields[++i].ToString();
     } else {
       // Skip the unknown extension.
       ++i;
@@ -1042,11 +1278,9 @@ void BuildMediaDescription(const ContentInfo* content_info,
   if (content_info == NULL || message == NULL) {
     return;
   }
-  // TODO: Rethink if we should use sprintfn instead of stringstream.
-  // According to the style guide, streams should only be used for logging.
-  // http://google-styleguide.googlecode.com/svn/
-  // trunk/cppguide.xml?showone=Streams#Streams
-  std::ostringstream os;
+  // Lines are built by appending into one reused buffer rather than through
+  // a stream; streams should only be used for logging.
+  std::string line;
   const MediaContentDescription* media_desc =
       static_cast<const MediaContentDescription*> (
           content_info->description);
@@ -1106,9 +1340,13 @@ void BuildMediaDescription(const ContentInfo* content_info,
   talk_base::SSLFingerprint* fp = (transport_info) ?
       transport_info->description.identity_fingerprint.get() : NULL;
 
-  InitLine(kLineTypeMedia, type, &os);
-  os << " " << port << " " << media_desc->protocol() << fmt;
-  AddLine(os.str(), message);
+  InitLine(kLineTypeMedia, type, &line);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(port);
+  line.push_back(kSdpDelimiterSpace);
+  line.append(media_desc->protocol());
+  line.append(fmt);
+  AddLine(line, message);
 
   // Use the transport_info to build the media level ice-ufrag and ice-pwd.
   if (transport_info) {
@@ -1116,13 +1354,15 @@ void BuildMediaDescription(const ContentInfo* content_info,
     // ice-pwd-att           = "ice-pwd" ":" password
     // ice-ufrag-att         = "ice-ufrag" ":" ufrag
     // ice-ufrag
-    InitAttrLine(kAttributeIceUfrag, &os);
-    os << kSdpDelimiterColon << transport_info->description.ice_ufrag;
-    AddLine(os.str(), message);
+    InitAttrLine(kAttributeIceUfrag, &line);
+    line.push_back(kSdpDelimiterColon);
+    line.append(transport_info->description.ice_ufrag);
+    AddLine(line, message);
     // ice-pwd
-    InitAttrLine(kAttributeIcePwd, &os);
-    os << kSdpDelimiterColon << transport_info->description.ice_pwd;
-    AddLine(os.str(), message);
+    InitAttrLine(kAttributeIcePwd, &line);
+    line.push_back(kSdpDelimiterColon);
+    line.append(transport_info->description.ice_pwd);
+    AddLine(line, message);
 
     // draft-petithuguenin-mmusic-ice-attributes-level-03
     BuildIceOptions(transport_info->description.transport_options, message);
@@ -1132,12 +1372,13 @@ void BuildMediaDescription(const ContentInfo* content_info,
     //   "fingerprint" ":" hash-func SP fingerprint
     if (fp) {
       // Insert the fingerprint attribute.
-      InitAttrLine(kAttributeFingerprint, &os);
-      os << kSdpDelimiterColon
-         << fp->algorithm << kSdpDelimiterSpace
-         << fp->GetRfc4752Fingerprint();
+      InitAttrLine(kAttributeFingerprint, &line);
+      line.push_back(kSdpDelimiterColon);
+      line.append(fp->algorithm);
+      line.push_back(kSdpDelimiterSpace);
+      line.append(fp->GetRfc4752Fingerprint());
 
-      AddLine(os.str(), message);
+      AddLine(line, message);
     }
   }
 
@@ -1146,11 +1387,12 @@ void BuildMediaDescription(const ContentInfo* content_info,
   // The definitions MUST be either all session level or all media level. This
   // implementation uses all media level.
   for (size_t i = 0; i < media_desc->rtp_header_extensions().size(); ++i) {
-    std::ostringstream os;
-    InitAttrLine(kAttributeExtmap, &os);
-    os << kSdpDelimiterColon << media_desc->rtp_header_extensions()[i].id
-       << kSdpDelimiterSpace << media_desc->rtp_header_extensions()[i].uri;
-    AddLine(os.str(), message);
+    InitAttrLine(kAttributeExtmap, &line);
+    line.push_back(kSdpDelimiterColon);
+    AppendInt(media_desc->rtp_header_extensions()[i].id, &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(media_desc->rtp_header_extensions()[i].uri);
+    AddLine(line, message);
   }
 
   // RFC 3264
@@ -1163,42 +1405,44 @@ void BuildMediaDescription(const ContentInfo* content_info,
 
   switch (direction) {
     case cricket::MD_INACTIVE:
-      InitAttrLine(kAttributeInactive, &os);
+      InitAttrLine(kAttributeInactive, &line);
       break;
     case cricket::MD_SENDONLY:
-      InitAttrLine(kAttributeSendOnly, &os);
+      InitAttrLine(kAttributeSendOnly, &line);
       break;
     case cricket::MD_RECVONLY:
-      InitAttrLine(kAttributeRecvOnly, &os);
+      InitAttrLine(kAttributeRecvOnly, &line);
       break;
     case cricket::MD_SENDRECV:
     default:
-      InitAttrLine(kAttributeSendRecv, &os);
+      InitAttrLine(kAttributeSendRecv, &line);
       break;
   }
-  AddLine(os.str(), message);
+  AddLine(line, message);
 
   // RFC 3388
   // mid-attribute      = "a=mid:" identification-tag
   // identification-tag = token
   // Use the content name as the mid identification-tag.
-  InitAttrLine(kAttributeMid, &os);
-  os << kSdpDelimiterColon << content_info->name;
-  AddLine(os.str(), message);
+  InitAttrLine(kAttributeMid, &line);
+  line.push_back(kSdpDelimiterColon);
+  line.append(content_info->name);
+  AddLine(line, message);
 
   // RFC 4566
   // b=AS:<bandwidth>
   if (media_desc->bandwidth() >= 1000) {
-    InitLine(kLineTypeSessionBandwidth, kApplicationSpecificMaximum, &os);
-    os << kSdpDelimiterColon << (media_desc->bandwidth() / 1000);
-    AddLine(os.str(), message);
+    InitLine(kLineTypeSessionBandwidth, kApplicationSpecificMaximum, &line);
+    line.push_back(kSdpDelimiterColon);
+    AppendInt(media_desc->bandwidth() / 1000, &line);
+    AddLine(line, message);
   }
 
   // RFC 5761
   // a=rtcp-mux
   if (media_desc->rtcp_mux()) {
-    InitAttrLine(kAttributeRtcpMux, &os);
-    AddLine(os.str(), message);
+    InitAttrLine(kAttributeRtcpMux, &line);
+    AddLine(line, message);
   }
 
   // RFC 4568
@@ -1206,13 +1450,18 @@ void BuildMediaDescription(const ContentInfo* content_info,
   for (std::vector<CryptoParams>::const_iterator it =
            media_desc->cryptos().begin();
        it != media_desc->cryptos().end(); ++it) {
-    InitAttrLine(kAttributeCrypto, &os);
-    os << kSdpDelimiterColon << it->tag << " " << it->cipher_suite << " "
-       << it->key_params;
+    InitAttrLine(kAttributeCrypto, &line);
+    line.push_back(kSdpDelimiterColon);
+    AppendInt(it->tag, &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(it->cipher_suite);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(it->key_params);
     if (!it->session_params.empty()) {
-      os << " " << it->session_params;
+      line.push_back(kSdpDelimiterSpace);
+      line.append(it->session_params);
     }
-    AddLine(os.str(), message);
+    AddLine(line, message);
   }
 
   // RFC 4566
@@ -1236,15 +1485,16 @@ void BuildMediaDescription(const ContentInfo* content_info,
       if (track->ssrc_groups[i].ssrcs.empty()) {
         continue;
       }
-      std::ostringstream os;
-      InitAttrLine(kAttributeSsrcGroup, &os);
-      os << kSdpDelimiterColon << track->ssrc_groups[i].semantics;
+      InitAttrLine(kAttributeSsrcGroup, &line);
+      line.push_back(kSdpDelimiterColon);
+      line.append(track->ssrc_groups[i].semantics);
       std::vector<uint32>::const_iterator ssrc =
           track->ssrc_groups[i].ssrcs.begin();
       for (; ssrc != track->ssrc_groups[i].ssrcs.end(); ++ssrc) {
-        os << kSdpDelimiterSpace << talk_base::ToString<uint32>(*ssrc);
+        line.push_back(kSdpDelimiterSpace);
+        AppendInt(*ssrc, &line);
       }
-      AddLine(os.str(), message);
+      AddLine(line, message);
     }
     // Build the ssrc lines for each ssrc.
     for (size_t i = 0; i < track->ssrcs.size(); ++i) {
@@ -1259,12 +1509,8 @@ void BuildMediaDescription(const ContentInfo* content_info,
       // The appdata consists of the "id" attribute of a MediaStreamTrack, which
       // is corresponding to the "name" attribute of StreamParams.
       std::string appdata = track->name;
-      std::ostringstream os;
-      InitAttrLine(kAttributeSsrc, &os);
-      os << kSdpDelimiterColon << ssrc << kSdpDelimiterSpace
-         << kSsrcAttributeMsid << kSdpDelimiterColon << track->sync_label
-         << kSdpDelimiterSpace << appdata;
-      AddLine(os.str(), message);
+      AddSsrcLine(ssrc, kSsrcAttributeMsid,
+                  track->sync_label + kSdpDelimiterSpace + appdata, message);
 
       // TODO(ronghuawu): Remove below code which is for backward compatibility.
       // draft-alvestrand-rtcweb-mid-01
@@ -1277,31 +1523,34 @@ void BuildMediaDescription(const ContentInfo* content_info,
   }
 }
 
-void WriteFmtpHeader(int payload_type, std::ostringstream* os) {
+void WriteFmtpHeader(int payload_type, std::string* line) {
   // fmtp header: a=fmtp:|payload_type| <parameters>
   // Add a=fmtp
-  InitAttrLine(kAttributeFmtp, os);
+  InitAttrLine(kAttributeFmtp, line);
   // Add :|payload_type|
-  *os << kSdpDelimiterColon << payload_type;
+  line->push_back(kSdpDelimiterColon);
+  AppendInt(payload_type, line);
 }
 
 void WriteFmtpParameter(const std::string& parameter_name,
                         const std::string& parameter_value,
-                        std::ostringstream* os) {
+                        std::string* line) {
   // fmtp parameters: |parameter_name|=|parameter_value|
-  *os << parameter_name << kSdpDelimiterEqual << parameter_value;
+  line->append(parameter_name);
+  line->push_back(kSdpDelimiterEqual);
+  line->append(parameter_value);
 }
 
 void WriteFmtpParameters(const cricket::CodecParameterMap& parameters,
-                         std::ostringstream* os) {
+                         std::string* line) {
   for (cricket::CodecParameterMap::const_iterator fmtp = parameters.begin();
        fmtp != parameters.end(); ++fmtp) {
     // Each new parameter, except the first one starts with ";" and " ".
     if (fmtp != parameters.begin()) {
-      *os << kSdpDelimiterSemicolon;
+      line->push_back(kSdpDelimiterSemicolon);
     }
-    *os << kSdpDelimiterSpace;
-    WriteFmtpParameter(fmtp->first, fmtp->second, os);
+    line->push_back(kSdpDelimiterSpace);
+    WriteFmtpParameter(fmtp->first, fmtp->second, line);
   }
 }
 
@@ -1339,10 +1588,10 @@ void AddFmtpLine(const T& codec, std::string* message) {
     // No need to add an fmtp if it will have no (optional) parameters.
     return;
   }
-  std::ostringstream os;
-  WriteFmtpHeader(codec.id, &os);
-  WriteFmtpParameters(fmtp_parameters, &os);
-  AddLine(os.str(), message);
+  std::string line;
+  WriteFmtpHeader(codec.id, &line);
+  WriteFmtpParameters(fmtp_parameters, &line);
+  AddLine(line, message);
   return;
 }
 
@@ -1372,7 +1621,7 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
                  std::string* message) {
   ASSERT(message != NULL);
   ASSERT(media_desc != NULL);
-  std::ostringstream os;
+  std::string line;
   if (media_type == cricket::MEDIA_TYPE_VIDEO) {
     const VideoContentDescription* video_desc =
         static_cast<const VideoContentDescription*>(media_desc);
@@ -1382,10 +1631,14 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // RFC 4566
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
-      InitAttrLine(kAttributeRtpmap, &os);
-      os << kSdpDelimiterColon << it->id << " " << it->name
-         << "/" << kDefaultVideoClockrate;
-      AddLine(os.str(), message);
+      InitAttrLine(kAttributeRtpmap, &line);
+      line.push_back(kSdpDelimiterColon);
+      AppendInt(it->id, &line);
+      line.push_back(kSdpDelimiterSpace);
+      line.append(it->name);
+      line.push_back(kSdpDelimiterSlash);
+      AppendInt(kDefaultVideoClockrate, &line);
+      AddLine(line, message);
       AddFmtpLine(*it, message);
     }
   } else if (media_type == cricket::MEDIA_TYPE_AUDIO) {
@@ -1401,13 +1654,18 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // RFC 4566
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
-      InitAttrLine(kAttributeRtpmap, &os);
-      os << kSdpDelimiterColon << it->id << " ";
-      os << it->name << "/" << it->clockrate;
+      InitAttrLine(kAttributeRtpmap, &line);
+      line.push_back(kSdpDelimiterColon);
+      AppendInt(it->id, &line);
+      line.push_back(kSdpDelimiterSpace);
+      line.append(it->name);
+      line.push_back(kSdpDelimiterSlash);
+      AppendInt(it->clockrate, &line);
       if (it->channels != 1) {
-        os << "/" << it->channels;
+        line.push_back(kSdpDelimiterSlash);
+        AppendInt(it->channels, &line);
       }
-      AddLine(os.str(), message);
+      AddLine(line, message);
       AddFmtpLine(*it, message);
       int minptime = 0;
       if (GetParameter(kCodecParamMinPTime, it->params, &minptime)) {
@@ -1446,17 +1704,21 @@ void BuildRtpMap(const MediaContentDescription* media_desc,
       // RFC 4566
       // a=rtpmap:<payload type> <encoding name>/<clock rate>
       // [/<encodingparameters>]
-      InitAttrLine(kAttributeRtpmap, &os);
-      os << kSdpDelimiterColon << it->id << " "
-         << it->name << "/" << it->clockrate;
-      AddLine(os.str(), message);
+      InitAttrLine(kAttributeRtpmap, &line);
+      line.push_back(kSdpDelimiterColon);
+      AppendInt(it->id, &line);
+      line.push_back(kSdpDelimiterSpace);
+      line.append(it->name);
+      line.push_back(kSdpDelimiterSlash);
+      AppendInt(it->clockrate, &line);
+      AddLine(line, message);
     }
   }
 }
 
 void BuildCandidate(const std::vector<Candidate>& candidates,
                     std::string* message) {
-  std::ostringstream os;
+  std::string line;
 
   for (std::vector<Candidate>::const_iterator it = candidates.begin();
        it != candidates.end(); ++it) {
@@ -1477,39 +1739,58 @@ void BuildCandidate(const std::vector<Candidate>& candidates,
       ASSERT(false);
     }
 
-    InitAttrLine(kAttributeCandidate, &os);
-    os << kSdpDelimiterColon
-       << it->foundation() << " " << it->component() << " "
-       << it->protocol() << " " << it->priority() << " "
-       << it->address().ipaddr().ToString() << " "
-       << it->address().PortAsString() << " "
-       << kAttributeCandidateTyp << " " << type << " ";
+    InitAttrLine(kAttributeCandidate, &line);
+    line.push_back(kSdpDelimiterColon);
+    line.append(it->foundation());
+    line.push_back(kSdpDelimiterSpace);
+    AppendInt(it->component(), &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(it->protocol());
+    line.push_back(kSdpDelimiterSpace);
+    AppendInt(it->priority(), &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(it->address().ipaddr().ToString());
+    line.push_back(kSdpDelimiterSpace);
+    AppendInt(it->address().port(), &line);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(kAttributeCandidateTyp);
+    line.push_back(kSdpDelimiterSpace);
+    line.append(type);
+    line.push_back(kSdpDelimiterSpace);
 
     // Related address
     if (!it->related_address().IsNil()) {
-      os << kAttributeCandidateRaddr << " "
-         << it->related_address().ipaddr().ToString() << " "
-         << kAttributeCandidateRport << " "
-         << it->related_address().PortAsString() << " ";
+      line.append(kAttributeCandidateRaddr);
+      line.push_back(kSdpDelimiterSpace);
+      line.append(it->related_address().ipaddr().ToString());
+      line.push_back(kSdpDelimiterSpace);
+      line.append(kAttributeCandidateRport);
+      line.push_back(kSdpDelimiterSpace);
+      AppendInt(it->related_address().port(), &line);
+      line.push_back(kSdpDelimiterSpace);
     }
 
     // Extensions
-    os << kAttributeCandidateGeneration << " " << it->generation();
+    line.append(kAttributeCandidateGeneration);
+    line.push_back(kSdpDelimiterSpace);
+    AppendInt(it->generation(), &line);
 
-    AddLine(os.str(), message);
+    AddLine(line, message);
   }
 }
 
 void BuildIceOptions(const std::vector<std::string>& transport_options,
                      std::string* message) {
   if (!transport_options.empty()) {
-    std::ostringstream os;
-    InitAttrLine(kAttributeIceOption, &os);
-    os << kSdpDelimiterColon << transport_options[0];
+    std::string line;
+    InitAttrLine(kAttributeIceOption, &line);
+    line.push_back(kSdpDelimiterColon);
+    line.append(transport_options[0]);
     for (size_t i = 1; i < transport_options.size(); ++i) {
-      os << kSdpDelimiterSpace << transport_options[i];
+      line.push_back(kSdpDelimiterSpace);
+      line.append(transport_options[i]);
     }
-    AddLine(os.str(), message);
+    AddLine(line, message);
   }
 }
 
@@ -1614,47 +1895,60 @@ bool ParseSessionDescription(const std::string& message, size_t* pos,
   // RFC 4566
   // a=* (zero or more session attribute lines)
   while (GetLineWithType(message, pos, &line, kLineTypeAttributes)) {
-    if (HasAttribute(line, kAttributeGroup)) {
-      if (!ParseGroupAttribute(line, desc, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIceUfrag)) {
-      if (!GetValue(line, kAttributeIceUfrag,
-                    &(session_td->ice_ufrag), error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIcePwd)) {
-      if (!GetValue(line, kAttributeIcePwd, &(session_td->ice_pwd), error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIceOption)) {
-      if (!ParseIceOptions(line, &(session_td->transport_options), error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeFingerprint)) {
-      if (session_td->identity_fingerprint.get()) {
-        return ParseFailed(
-            line,
-            "Can't have multiple fingerprint attributes at the same level.",
-            error);
-      }
-      talk_base::SSLFingerprint* fingerprint = NULL;
-      if (!ParseFingerprintAttribute(line, &fingerprint, error)) {
-        return false;
+    switch (GetAttributeType(line)) {
+      case SDP_ATTR_GROUP:
+        if (!ParseGroupAttribute(line, desc, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_UFRAG:
+        if (!GetValue(line, kAttributeIceUfrag,
+                      &(session_td->ice_ufrag), error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_PWD:
+        if (!GetValue(line, kAttributeIcePwd, &(session_td->ice_pwd), error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_OPTIONS:
+        if (!ParseIceOptions(line, &(session_td->transport_options), error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_FINGERPRINT: {
+        if (session_td->identity_fingerprint.get()) {
+          return ParseFailed(
+              line,
+              "Can't have multiple fingerprint attributes at the same level.",
+              error);
+        }
+        talk_base::SSLFingerprint* fingerprint = NULL;
+        if (!ParseFingerprintAttribute(line, &fingerprint, error)) {
+          return false;
+        }
+        session_td->identity_fingerprint.reset(fingerprint);
+        break;
       }
-      session_td->identity_fingerprint.reset(fingerprint);
-    } else if (HasAttribute(line, kAttributeMsidSemantics)) {
-      std::string semantics;
-      if (!GetValue(line, kAttributeMsidSemantics, &semantics, error)) {
-        return false;
+      case SDP_ATTR_MSID_SEMANTICS: {
+        std::string semantics;
+        if (!GetValue(line, kAttributeMsidSemantics, &semantics, error)) {
+          return false;
+        }
+        *supports_msid = (semantics == kMediaStreamSematic);
+        break;
       }
-      *supports_msid = (semantics == kMediaStreamSematic);
-    } else if (HasAttribute(line, kAttributeExtmap)) {
-      RtpHeaderExtension extmap;
-      if (!ParseExtmap(line, &extmap, error)) {
-        return false;
+      case SDP_ATTR_EXTMAP: {
+        RtpHeaderExtension extmap;
+        if (!ParseExtmap(line, &extmap, error)) {
+          return false;
+        }
+        session_extmaps->push_back(extmap);
+        break;
       }
-      session_extmaps->push_back(extmap);
+      default:
+        break;
     }
   }
 
@@ -1952,90 +2246,114 @@ bool ParseContent(const std::string& message,
       continue;
     }
 
-    if (HasAttribute(line, kAttributeMid)) {
-      // RFC 3388
-      // mid-attribute      = "a=mid:" identification-tag
-      // identification-tag = token
-      // Use the mid identification-tag as the content name.
-      if (!GetValue(line, kAttributeMid, &mline_id, error)) {
-        return false;
-      }
-      *content_name = mline_id;
-      continue;
-    } else if (HasAttribute(line, kAttributeRtcpMux)) {
-      media_desc->set_rtcp_mux(true);
-    } else if (HasAttribute(line, kAttributeSsrcGroup)) {
-      if (!ParseSsrcGroupAttribute(line, &ssrc_groups, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeSsrc)) {
-      if (!ParseSsrcAttribute(line, &ssrc_infos, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeCrypto)) {
-      if (!ParseCryptoAttribute(line, media_desc, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeCandidate)) {
-      Candidate candidate;
-      if (!ParseCandidate(line, &candidate, error, false)) {
-        return false;
-      }
-      candidates_orig.push_back(candidate);
-    } else if (HasAttribute(line, kAttributeRtpmap)) {
-      if (!ParseRtpmapAttribute(line, media_type, codec_preference,
-                                media_desc, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeFmtp)) {
-      if (!ParseFmtpAttributes(line, media_type, media_desc, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kCodecParamMaxPTime)) {
-      if (!GetValue(line, kCodecParamMaxPTime, &maxptime_as_string, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kCodecParamPTime)) {
-      if (!GetValue(line, kCodecParamPTime, &ptime_as_string, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIceUfrag)) {
-      if (!GetValue(line, kAttributeIceUfrag, &transport->ice_ufrag, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIcePwd)) {
-      if (!GetValue(line, kAttributeIcePwd, &transport->ice_pwd, error)) {
-        return false;
-      }
-    } else if (HasAttribute(line, kAttributeIceOption)) {
-      if (!ParseIceOptions(line, &transport->transport_options, error)) {
-        return false;
+    switch (GetAttributeType(line)) {
+      case SDP_ATTR_MID:
+        // RFC 3388
+        // mid-attribute      = "a=mid:" identification-tag
+        // identification-tag = token
+        // Use the mid identification-tag as the content name.
+        if (!GetValue(line, kAttributeMid, &mline_id, error)) {
+          return false;
+        }
+        *content_name = mline_id;
+        break;
+      case SDP_ATTR_RTCP_MUX:
+        media_desc->set_rtcp_mux(true);
+        break;
+      case SDP_ATTR_SSRC_GROUP:
+        if (!ParseSsrcGroupAttribute(line, &ssrc_groups, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_SSRC:
+        if (!ParseSsrcAttribute(line, &ssrc_infos, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_CRYPTO:
+        if (!ParseCryptoAttribute(line, media_desc, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_CANDIDATE: {
+        Candidate candidate;
+        if (!ParseCandidate(line, &candidate, error, false)) {
+          return false;
+        }
+        candidates_orig.push_back(candidate);
+        break;
       }
-    } else if (HasAttribute(line, kAttributeSendOnly)) {
-      media_desc->set_direction(cricket::MD_SENDONLY);
-    } else if (HasAttribute(line, kAttributeRecvOnly)) {
-      media_desc->set_direction(cricket::MD_RECVONLY);
-    } else if (HasAttribute(line, kAttributeInactive)) {
-      media_desc->set_direction(cricket::MD_INACTIVE);
-    } else if (HasAttribute(line, kAttributeSendRecv)) {
-      media_desc->set_direction(cricket::MD_SENDRECV);
-    } else if (HasAttribute(line, kAttributeFingerprint)) {
-      talk_base::SSLFingerprint* fingerprint = NULL;
-
-      if (!ParseFingerprintAttribute(line, &fingerprint, error)) {
-        return false;
+      case SDP_ATTR_RTPMAP:
+        if (!ParseRtpmapAttribute(line, media_type, codec_preference,
+                                  media_desc, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_FMTP:
+        if (!ParseFmtpAttributes(line, media_type, media_desc, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_MAXPTIME:
+        if (!GetValue(line, kCodecParamMaxPTime, &maxptime_as_string,
+                      error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_PTIME:
+        if (!GetValue(line, kCodecParamPTime, &ptime_as_string, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_UFRAG:
+        if (!GetValue(line, kAttributeIceUfrag, &transport->ice_ufrag,
+                      error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_PWD:
+        if (!GetValue(line, kAttributeIcePwd, &transport->ice_pwd, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_ICE_OPTIONS:
+        if (!ParseIceOptions(line, &transport->transport_options, error)) {
+          return false;
+        }
+        break;
+      case SDP_ATTR_SENDONLY:
+        media_desc->set_direction(cricket::MD_SENDONLY);
+        break;
+      case SDP_ATTR_RECVONLY:
+        media_desc->set_direction(cricket::MD_RECVONLY);
+        break;
+      case SDP_ATTR_INACTIVE:
+        media_desc->set_direction(cricket::MD_INACTIVE);
+        break;
+      case SDP_ATTR_SENDRECV:
+        media_desc->set_direction(cricket::MD_SENDRECV);
+        break;
+      case SDP_ATTR_FINGERPRINT: {
+        talk_base::SSLFingerprint* fingerprint = NULL;
+
+        if (!ParseFingerprintAttribute(line, &fingerprint, error)) {
+          return false;
+        }
+        transport->identity_fingerprint.reset(fingerprint);
+        break;
       }
-      transport->identity_fingerprint.reset(fingerprint);
-    } else if (HasAttribute(line, kAttributeExtmap)) {
-      RtpHeaderExtension extmap;
-      if (!ParseExtmap(line, &extmap, error)) {
-        return false;
+      case SDP_ATTR_EXTMAP: {
+        RtpHeaderExtension extmap;
+        if (!ParseExtmap(line, &extmap, error)) {
+          return false;
+        }
+        media_desc->AddRtpHeaderExtension(extmap);
+        break;
       }
-      media_desc->AddRtpHeaderExtension(extmap);
-    } else {
-      // Only parse lines that we are interested of.
-      LOG(LS_INFO) << "Ignored line: " << line;
-      continue;
+      default:
+        // Only parse lines that we are interested of.
+        LOG(LS_INFO) << "Ignored line: " << line;
+        break;
     }
   }
 
@@ -2095,38 +2413,44 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
   // RFC 5576
   // a=ssrc:<ssrc-id> <attribute>
   // a=ssrc:<ssrc-id> <attribute>:<value>
-  std::string field1, field2;
-  if (!SplitByDelimiter(line.substr(kLinePrefixLength),
-                        kSdpDelimiterSpace,
-                        &field1,
-                        &field2)) {
+  const size_t space = line.find(kSdpDelimiterSpace, kLinePrefixLength);
+  if (space == std::string::npos) {
     const size_t expected_fields = 2;
     return ParseFailedExpectFieldNum(line, expected_fields, error);
   }
 
   // ssrc:<ssrc-id>
   std::string ssrc_id_s;
-  if (!GetValue(field1, kAttributeSsrc, &ssrc_id_s, error)) {
+  if (!GetValue(SdpField(line.data() + kLinePrefixLength,
+                         space - kLinePrefixLength),
+                kAttributeSsrc, &ssrc_id_s, error)) {
     return false;
   }
   uint32 ssrc_id = talk_base::FromString<uint32>(ssrc_id_s);
 
-  std::string attribute;
-  std::string value;
-  if (!SplitByDelimiter(field2, kSdpDelimiterColon,
-                        &attribute, &value)) {
+  const size_t colon = line.find(kSdpDelimiterColon, space + 1);
+  if (colon == std::string::npos) {
     std::ostringstream description;
-    description << "Failed to get the ssrc attribute value from " << field2
+    description << "Failed to get the ssrc attribute value from "
+                << line.substr(space + 1)
                 << ". Expected format <attribute>:<value>.";
     return ParseFailed(line, description.str(), error);
   }
+  const SdpField attribute(line.data() + space + 1, colon - space - 1);
+  const std::string value = line.substr(colon + 1);
 
   // Check if there's already an item for this |ssrc_id|. Create a new one if
-  // there isn't.
-  SsrcInfoVec::iterator ssrc_info = ssrc_infos->begin();
-  for (; ssrc_info != ssrc_infos->end(); ++ssrc_info) {
-    if (ssrc_info->ssrc_id == ssrc_id) {
-      break;
+  // there isn't. The lines of one ssrc are normally adjacent, so the last
+  // item is tried first to keep long ssrc lists from going quadratic.
+  SsrcInfoVec::iterator ssrc_info = ssrc_infos->end();
+  if (!ssrc_infos->empty() && ssrc_infos->back().ssrc_id == ssrc_id) {
+    ssrc_info = ssrc_infos->end() - 1;
+  } else {
+    for (ssrc_info = ssrc_infos->begin(); ssrc_info != ssrc_infos->end();
+         ++ssrc_info) {
+      if (ssrc_info->ssrc_id == ssrc_id) {
+        break;
+      }
     }
   }
   if (ssrc_info == ssrc_infos->end()) {
@@ -2137,11 +2461,11 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
   }
 
   // Store the info to the |ssrc_info|.
-  if (attribute == kSsrcAttributeCname) {
+  if (attribute.Equals(kSsrcAttributeCname)) {
     // RFC 5576
     // cname:<value>
     ssrc_info->cname = value;
-  } else if (attribute == kSsrcAttributeMsid) {
+  } else if (attribute.Equals(kSsrcAttributeMsid)) {
     // draft-alvestrand-mmusic-msid-00
     // "msid:" identifier [ " " appdata ]
     std::vector<std::string> fields;
@@ -2155,11 +2479,11 @@ bool ParseSsrcAttribute(const std::string& line, SsrcInfoVec* ssrc_infos,
     if (fields.size() == 2) {
       ssrc_info->msid_appdata = fields[1];
     }
-  } else if (attribute == kSsrcAttributeMslabel) {
+  } else if (attribute.Equals(kSsrcAttributeMslabel)) {
     // draft-alvestrand-rtcweb-mid-01
     // mslabel:<value>
     ssrc_info->mslabel = value;
-  } else if (attribute == kSSrcAttributeLabel) {
+  } else if (attribute.Equals(kSSrcAttributeLabel)) {
     // The label isn't defined.
     // label:<value>
     ssrc_info->label = value;
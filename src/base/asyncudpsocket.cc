@@ -52,6 +52,21 @@ AsyncUDPSocket* AsyncUDPSocket::Create(SocketFactory* factory,
   return Create(socket, bind_address);
 }
 
+AsyncUDPSocket* AsyncUDPSocket::CreateShared(
+    SocketFactory* factory, const SocketAddress& bind_address) {
+  AsyncSocket* socket =
+      factory->CreateAsyncSocket(bind_address.family(), SOCK_DGRAM);
+  if (!socket)
+    return NULL;
+  if (socket->SetOption(Socket::OPT_REUSEPORT, 1) < 0) {
+    LOG(LS_ERROR) << "Failed to set OPT_REUSEPORT, error "
+                  << socket->GetError();
+    delete socket;
+    return NULL;
+  }
+  return Create(socket, bind_address);
+}
+
 AsyncUDPSocket::AsyncUDPSocket(AsyncSocket* socket)
     : socket_(socket) {
   ASSERT(socket_);
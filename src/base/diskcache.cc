@@ -27,6 +27,10 @@
 
 #include <time.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #ifdef WIN32
 #include "base/win32.h"
 #endif
@@ -34,6 +38,7 @@
 #include "base/common.h"
 #include "base/diskcache.h"
 #include "base/fileutils.h"
+#include "base/mappedfile.h"
 #include "base/pathutils.h"
 #include "base/stream.h"
 #include "base/stringencode.h"
@@ -49,6 +54,13 @@ namespace talk_base {
 
 class DiskCache;
 
+// Lives in the cache folder; the extension keeps FilenameToId from taking it
+// for a resource.
+static const char kIndexFilename[] = "diskcache.idx";
+static const char kIndexHeader[] = "DiskCacheIndex 1";
+// Characters escaped in ids written to the index, besides the escape itself.
+static const char kIndexUnsafeCharacters[] = " \t\r\n";
+
 ///////////////////////////////////////////////////////////////////////////////
 // DiskCacheAdapter
 ///////////////////////////////////////////////////////////////////////////////
@@ -64,6 +76,14 @@ public:
     cache_->ReleaseResource(id_, index_);
   }
 
+  // Reads are served from a mapping, so let callers see it directly.
+  virtual const void* GetReadData(size_t* data_len) {
+    return stream()->GetReadData(data_len);
+  }
+  virtual void ConsumeReadData(size_t used) {
+    stream()->ConsumeReadData(used);
+  }
+
 private:
   const DiskCache* cache_;
   std::string id_;
@@ -79,6 +99,8 @@ DiskCache::DiskCache() : max_cache_(0), total_size_(0), total_accessors_(0) {
 
 DiskCache::~DiskCache() {
   ASSERT(0 == total_accessors_);
+  if (!folder_.empty())
+    SaveIndex();
 }
 
 bool DiskCache::Initialize(const std::string& folder, size_t size) {
@@ -89,8 +111,11 @@ bool DiskCache::Initialize(const std::string& folder, size_t size) {
   max_cache_ = size;
   ASSERT(0 == total_size_);
 
-  if (!InitializeEntries())
-    return false;
+  if (!LoadIndex()) {
+    if (!InitializeEntries())
+      return false;
+    SortEntriesByLastModified();
+  }
 
   return CheckLimit();
 }
@@ -108,6 +133,8 @@ bool DiskCache::Purge() {
     return false;
 
   map_.clear();
+  lru_.clear();
+  total_size_ = 0;
   return true;
 }
 
@@ -163,6 +190,7 @@ bool DiskCache::UnlockResource(const std::string& id) {
   } else {
     entry->lock_state = LS_UNLOCKED;
     entry->last_modified = time(0);
+    TouchEntry(entry);
     CheckLimit();
   }
   return true;
@@ -171,15 +199,16 @@ bool DiskCache::UnlockResource(const std::string& id) {
 StreamInterface* DiskCache::ReadResource(const std::string& id,
                                          size_t index) const {
   const Entry* entry = GetEntry(id);
-  if (LS_UNLOCKED != entry->lock_state)
+  if (!entry || (LS_UNLOCKED != entry->lock_state))
     return NULL;
   if (index >= entry->streams)
     return NULL;
 
-  scoped_ptr<FileStream> file(new FileStream);
-  if (!file->Open(IdToFilename(id, index), "rb", NULL))
+  scoped_ptr<MappedFileStream> file(new MappedFileStream);
+  if (!file->Open(IdToFilename(id, index)))
     return NULL;
 
+  TouchEntry(entry);
   entry->accessors += 1;
   total_accessors_ += 1;
   return new DiskCacheAdapter(this, id, index, file.release());
@@ -222,6 +251,7 @@ bool DiskCache::DeleteResource(const std::string& id) {
   }
 
   total_size_ -= entry->size;
+  lru_.erase(entry->lru_position);
   map_.erase(id);
   return success;
 }
@@ -236,26 +266,23 @@ bool DiskCache::CheckLimit() {
   ASSERT(cache_size == total_size_);
 #endif  // _DEBUG
 
-  // TODO: Replace this with a non-brain-dead algorithm for clearing out the
-  // oldest resources... something that isn't O(n^2)
+  // Evict from the least recently used end, stepping over resources that are
+  // locked or open.
+  LruList::iterator it = lru_.begin();
   while (total_size_ > max_cache_) {
-    EntryMap::iterator oldest = map_.end();
-    for (EntryMap::iterator it = map_.begin(); it != map_.end(); ++it) {
-      if ((LS_UNLOCKED != it->second.lock_state) || (it->second.accessors > 0))
-        continue;
-      oldest = it;
-      break;
+    while (it != lru_.end()) {
+      const Entry* entry = GetEntry(*it);
+      if ((LS_UNLOCKED == entry->lock_state) && (0 == entry->accessors))
+        break;
+      ++it;
     }
-    if (oldest == map_.end()) {
+    if (it == lru_.end()) {
       LOG_F(LS_WARNING) << "All resources are locked!";
       return false;
     }
-    for (EntryMap::iterator it = oldest++; it != map_.end(); ++it) {
-      if (it->second.last_modified < oldest->second.last_modified) {
-        oldest = it;
-      }
-    }
-    if (!DeleteResource(oldest->first)) {
+    // DeleteResource removes the node |it| points at.
+    std::string id(*it++);
+    if (!DeleteResource(id)) {
       LOG_F(LS_ERROR) << "Couldn't delete from cache!";
       return false;
     }
@@ -263,6 +290,115 @@ bool DiskCache::CheckLimit() {
   return true;
 }
 
+void DiskCache::TouchEntry(const Entry* entry) const {
+  lru_.splice(lru_.end(), lru_, entry->lru_position);
+}
+
+void DiskCache::SortEntriesByLastModified() {
+  std::vector<std::pair<time_t, std::string> > order;
+  order.reserve(map_.size());
+  for (EntryMap::iterator it = map_.begin(); it != map_.end(); ++it) {
+    order.push_back(std::make_pair(it->second.last_modified, it->first));
+  }
+  std::sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); ++i) {
+    TouchEntry(GetEntry(order[i].second));
+  }
+}
+
+std::string DiskCache::IndexFilename() const {
+  Pathname pathname;
+  pathname.SetFolder(folder_);
+  pathname.SetFilename(kIndexFilename);
+  return pathname.pathname();
+}
+
+bool DiskCache::LoadIndex() {
+  std::string filename(IndexFilename());
+  MappedFile index;
+  if (!Filesystem::IsFile(filename) || !index.Open(filename))
+    return false;
+
+  std::vector<std::string> lines;
+  tokenize(std::string(reinterpret_cast<const char*>(index.data()),
+                       index.size()), '\n', &lines);
+  index.Close();
+  // The index is only valid until the cache changes; it is written again on
+  // a clean shutdown.
+  Filesystem::DeleteFile(filename);
+
+  bool success = !lines.empty() && (lines[0] == kIndexHeader);
+  for (size_t i = 1; success && (i < lines.size()); ++i) {
+    std::vector<std::string> fields;
+    size_t streams, size;
+    unsigned long last_modified;
+    if ((4 != tokenize(lines[i], ' ', &fields)) ||
+        !FromString(fields[1], &streams) ||
+        !FromString(fields[2], &size) ||
+        !FromString(fields[3], &last_modified)) {
+      success = false;
+      break;
+    }
+    std::string id(fields[0].length() + 1, '\0');
+    id.resize(decode(&id[0], id.length(), fields[0].data(),
+                     fields[0].length(), '%'));
+    Entry* entry = GetOrCreateEntry(id, true);
+    entry->streams = streams;
+    entry->size = size;
+    entry->last_modified = static_cast<time_t>(last_modified);
+    total_size_ += size;
+  }
+
+  if (!success) {
+    LOG_F(LS_WARNING) << "Ignoring malformed cache index";
+    map_.clear();
+    lru_.clear();
+    total_size_ = 0;
+  }
+  return success;
+}
+
+bool DiskCache::SaveIndex() const {
+  for (EntryMap::const_iterator it = map_.begin(); it != map_.end(); ++it) {
+    // Files of a resource that is still being written may be partial, so
+    // leave the next Initialize to scan the folder.
+    if (LS_UNLOCKED != it->second.lock_state)
+      return false;
+  }
+
+  FileStream file;
+  if (!file.Open(IndexFilename(), "wb", NULL)) {
+    LOG_F(LS_ERROR) << "Couldn't create cache index";
+    return false;
+  }
+  std::string line(kIndexHeader);
+  line.append("\n");
+  bool success = (SR_SUCCESS == file.WriteAll(line.data(), line.length(),
+                                              NULL, NULL));
+  for (LruList::const_iterator it = lru_.begin();
+       success && (it != lru_.end()); ++it) {
+    const Entry* entry = GetEntry(*it);
+    size_t buffer_size = it->length() * 3 + 1;
+    scoped_array<char> buffer(new char[buffer_size]);
+    encode(buffer.get(), buffer_size, it->data(), it->length(),
+           kIndexUnsafeCharacters, '%');
+    line.assign(buffer.get());
+    line.append(" ").append(ToString(entry->streams));
+    line.append(" ").append(ToString(entry->size));
+    line.append(" ").append(ToString(
+        static_cast<unsigned long>(entry->last_modified)));
+    line.append("\n");
+    success = (SR_SUCCESS == file.WriteAll(line.data(), line.length(),
+                                           NULL, NULL));
+  }
+  file.Close();
+  if (!success) {
+    LOG_F(LS_ERROR) << "Couldn't write cache index";
+    Filesystem::DeleteFile(IndexFilename());
+  }
+  return success;
+}
+
 std::string DiskCache::IdToFilename(const std::string& id, size_t index) const {
 #ifdef TRANSPARENT_CACHE_NAMES
   // This escapes colons and other filesystem characters, so the user can't open
@@ -324,6 +460,7 @@ DiskCache::Entry* DiskCache::GetOrCreateEntry(const std::string& id,
   e.size = 0;
   e.streams = 0;
   e.last_modified = time(0);
+  e.lru_position = lru_.insert(lru_.end(), id);
   it = map_.insert(EntryMap::value_type(id, e)).first;
   return &it->second;
 }
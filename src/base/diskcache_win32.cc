@@ -44,8 +44,7 @@
 namespace talk_base {
 
 bool DiskCacheWin32::InitializeEntries() {
-  // Note: We could store the cache information in a separate file, for faster
-  // initialization.  Figuring it out empirically works, too.
+  // Only called when DiskCache has no index from a clean shutdown.
 
   std::wstring path16 = ToUtf16(folder_);
   path16.append(1, '*');
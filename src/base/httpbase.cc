@@ -74,6 +74,7 @@ HttpParser::reset() {
   state_ = ST_LEADER;
   chunked_ = false;
   data_size_ = SIZE_UNKNOWN;
+  line_scanned_ = 0;
 }
 
 HttpParser::ProcessResult
@@ -89,13 +90,17 @@ HttpParser::Process(const char* buffer, size_t len, size_t* processed,
 
   while (true) {
     if (state_ < ST_DATA) {
-      size_t pos = *processed;
-      while ((pos < len) && (buffer[pos] != '\n')) {
-        pos += 1;
+      size_t pos = *processed + line_scanned_;
+      if (pos < len) {
+        const void* eol = memchr(buffer + pos, '\n', len - pos);
+        pos = eol ? static_cast<const char*>(eol) - buffer : len;
       }
       if (pos >= len) {
-        break;  // don't have a full header
+        // don't have a full header; remember how far we looked
+        line_scanned_ = len - *processed;
+        break;
       }
+      line_scanned_ = 0;
       const char* line = buffer + *processed;
       size_t len = (pos - *processed);
       *processed = pos + 1;
@@ -373,7 +378,9 @@ private:
 //////////////////////////////////////////////////////////////////////
 
 HttpBase::HttpBase() : mode_(HM_NONE), data_(NULL), notify_(NULL),
-                       http_stream_(NULL), doc_stream_(NULL) {
+                       http_stream_(NULL), doc_stream_(NULL), len_(0),
+                       recv_pos_(0), recv_len_(0), ignore_data_(false),
+                       chunk_data_(false), send_file_(false) {
 }
 
 HttpBase::~HttpBase() {
@@ -392,6 +399,7 @@ HttpBase::attach(StreamInterface* stream) {
     return false;
   }
   http_stream_ = stream;
+  recv_pos_ = recv_len_ = 0;
   http_stream_->SignalEvent.connect(this, &HttpBase::OnHttpStreamEvent);
   mode_ = (http_stream_->GetState() == SS_OPENING) ? HM_CONNECT : HM_NONE;
   return true;
@@ -405,6 +413,7 @@ HttpBase::detach() {
   }
   StreamInterface* stream = http_stream_;
   http_stream_ = NULL;
+  recv_pos_ = recv_len_ = 0;
   if (stream) {
     stream->SignalEvent.disconnect(this);
   }
@@ -424,7 +433,7 @@ HttpBase::send(HttpData* data) {
   mode_ = HM_SEND;
   data_ = data;
   len_ = 0;
-  ignore_data_ = chunk_data_ = false;
+  ignore_data_ = chunk_data_ = send_file_ = false;
 
   if (data_->document) {
     data_->document->SignalEvent.connect(this, &HttpBase::OnDocumentEvent);
@@ -436,6 +445,13 @@ HttpBase::send(HttpData* data) {
     chunk_data_ = true;
   }
 
+  int fd;
+  if (!chunk_data_ && data_->document &&
+      data_->document->GetFileDescriptor(&fd)) {
+    // Try to hand the file to the network stack once the headers are out.
+    send_file_ = true;
+  }
+
   len_ = data_->formatLeader(buffer_, sizeof(buffer_));
   len_ += strcpyn(buffer_ + len_, sizeof(buffer_) - len_, "\r\n");
 
@@ -461,11 +477,15 @@ HttpBase::recv(HttpData* data) {
   mode_ = HM_RECV;
   data_ = data;
   len_ = 0;
-  ignore_data_ = chunk_data_ = false;
+  ignore_data_ = chunk_data_ = send_file_ = false;
 
   reset();
   if (doc_stream_) {
     doc_stream_->SignalEvent(doc_stream_, SE_OPEN | SE_READ, 0);
+  } else if (recv_len_ > 0) {
+    // A pipelined message is already buffered.  Parse it from the message
+    // loop, since we may be inside the completion of the previous one.
+    Thread::Current()->Post(this, MSG_READ);
   } else {
     read_and_process_data();
   }
@@ -524,17 +544,23 @@ bool HttpBase::DoReceiveLoop(HttpError* error) {
     // on http_stream_.  Therefore, we optimize by attempting to read from the
     // network first (as opposed to processing existing data first).
 
-    if (len_ < sizeof(buffer_)) {
+    if (recv_len_ < sizeof(recv_buffer_)) {
+      if (recv_pos_ + recv_len_ == sizeof(recv_buffer_)) {
+        // Out of room at the end; move the unparsed data to the front.
+        memmove(recv_buffer_, recv_buffer_ + recv_pos_, recv_len_);
+        recv_pos_ = 0;
+      }
       // Attempt to buffer more data.
+      size_t end = recv_pos_ + recv_len_;
       size_t read;
       int read_error;
-      StreamResult read_result = http_stream_->Read(buffer_ + len_,
-                                                    sizeof(buffer_) - len_,
+      StreamResult read_result = http_stream_->Read(recv_buffer_ + end,
+                                                    sizeof(recv_buffer_) - end,
                                                     &read, &read_error);
       switch (read_result) {
       case SR_SUCCESS:
-        ASSERT(len_ + read <= sizeof(buffer_));
-        len_ += read;
+        ASSERT(end + read <= sizeof(recv_buffer_));
+        recv_len_ += read;
         break;
       case SR_BLOCK:
         if (process_requires_more_data) {
@@ -565,11 +591,12 @@ bool HttpBase::DoReceiveLoop(HttpError* error) {
     // necessary to call Process with an empty buffer, since the state machine
     // may have interrupted state transitions to complete.
     size_t processed;
-    ProcessResult process_result = Process(buffer_, len_, &processed,
-                                            error);
-    ASSERT(processed <= len_);
-    len_ -= processed;
-    memmove(buffer_, buffer_ + processed, len_);
+    ProcessResult process_result = Process(recv_buffer_ + recv_pos_,
+                                           recv_len_, &processed, error);
+    ASSERT(processed <= recv_len_);
+    recv_len_ -= processed;
+    // Later messages on the connection stay where they are until parsed.
+    recv_pos_ = (recv_len_ > 0) ? recv_pos_ + processed : 0;
     switch (process_result) {
     case PR_CONTINUE:
       // We need more data to make progress.
@@ -619,7 +646,18 @@ HttpBase::flush_data() {
       send_required = queue_headers();
     }
 
-    if (!send_required && data_->document) {
+    if (!send_required && send_file_ && (header_ == data_->end())) {
+      if (len_ > 0) {
+        // The headers have to go out before the file.
+        send_required = true;
+      } else if (!send_file_data()) {
+        return;
+      } else {
+        continue;
+      }
+    }
+
+    if (!send_required && data_->document && !send_file_) {
       // Next, attempt to queue document data.
 
       const size_t kChunkDigits = 8;
@@ -716,6 +754,46 @@ HttpBase::flush_data() {
   ASSERT(false);
 }
 
+bool
+HttpBase::send_file_data() {
+  ASSERT(HM_SEND == mode_);
+  ASSERT(0 == len_);
+  StreamInterface* document = data_->document.get();
+  int fd;
+  size_t position, size;
+  if (!document->GetFileDescriptor(&fd) || !document->GetPosition(&position)
+      || !document->GetSize(&size)) {
+    send_file_ = false;
+    return true;
+  }
+  if (position >= size) {
+    do_complete();
+    return false;
+  }
+
+  size_t written;
+  int error;
+  StreamResult result = http_stream_->SendFile(fd, position, size - position,
+                                               &written, &error);
+  if (result == SR_SUCCESS && written > 0) {
+    document->SetPosition(position + written);
+    return true;
+  } else if (result == SR_SUCCESS) {
+    // Nothing was sent although the file should have more data, e.g. because
+    // it was truncated.  The copy path handles a short document properly.
+    LOG_F(LS_WARNING) << "SendFile made no progress, copying the document";
+    send_file_ = false;
+    return true;
+  } else if (result == SR_BLOCK) {
+    return false;
+  }
+  // The stream can't send files.  Any real network error will show up again
+  // on the next Write.
+  LOG_F(LS_VERBOSE) << "Falling back to copying the document: " << error;
+  send_file_ = false;
+  return true;
+}
+
 bool
 HttpBase::queue_headers() {
   ASSERT(HM_SEND == mode_);
@@ -760,6 +838,14 @@ HttpBase::do_complete(HttpError err) {
   }
 }
 
+void
+HttpBase::OnMessage(Message* msg) {
+  ASSERT(MSG_READ == msg->message_id);
+  if ((HM_RECV == mode_) && !doc_stream_) {
+    read_and_process_data();
+  }
+}
+
 //
 // Stream Signals
 //
@@ -832,8 +918,7 @@ HttpBase::ProcessLeader(const char* line, size_t len, HttpError* error) {
 HttpParser::ProcessResult
 HttpBase::ProcessHeader(const char* name, size_t nlen, const char* value,
                         size_t vlen, HttpError* error) {
-  std::string sname(name, nlen), svalue(value, vlen);
-  data_->addHeader(sname, svalue);
+  data_->addHeader(name, nlen, value, vlen);
   return PR_CONTINUE;
 }
 
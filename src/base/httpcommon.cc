@@ -212,6 +212,20 @@ bool HttpHeaderIsCollapsible(HttpHeader header) {
   }
 }
 
+// Matches HttpHeaderIsCollapsible, for a name which may not be a known
+// header, without looking it up in the header table.
+static bool IsCollapsibleHeader(const char* name, size_t len) {
+  static const HttpHeader kNonCollapsible[] = {
+    HH_SET_COOKIE, HH_PROXY_AUTHENTICATE, HH_WWW_AUTHENTICATE
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(kNonCollapsible); ++i) {
+    const char* header = ToString(kNonCollapsible[i]);
+    if ((strlen(header) == len) && (_strnicmp(name, header, len) == 0))
+      return false;
+  }
+  return true;
+}
+
 bool HttpShouldKeepAlive(const HttpData& data) {
   std::string connection;
   if ((data.hasHeader(HH_PROXY_CONNECTION, &connection)
@@ -458,6 +472,19 @@ HttpData::changeHeader(const std::string& name, const std::string& value,
   headers_.insert(HeaderMap::value_type(name, value));
 }
 
+void
+HttpData::addHeader(const char* name, size_t nlen,
+                    const char* value, size_t vlen) {
+  std::string key(name, nlen);
+  HeaderMap::iterator it = headers_.find(key);
+  if ((it != headers_.end()) && IsCollapsibleHeader(name, nlen)) {
+    it->second.append(",");
+    it->second.append(value, vlen);
+    return;
+  }
+  headers_.insert(HeaderMap::value_type(key, std::string(value, vlen)));
+}
+
 size_t HttpData::clearHeader(const std::string& name) {
   return headers_.erase(name);
 }
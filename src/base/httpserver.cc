@@ -34,10 +34,14 @@
 #include "base/httpserver.h"
 #include "base/logging.h"
 #include "base/socketstream.h"
+#include "base/stringencode.h"
 #include "base/thread.h"
 
 namespace talk_base {
 
+// Enough pending connections for a burst of clients on a status endpoint.
+static const int kListenBacklog = 128;
+
 ///////////////////////////////////////////////////////////////////////////////
 // HttpServer
 ///////////////////////////////////////////////////////////////////////////////
@@ -169,6 +173,23 @@ HttpServer::Connection::Respond(HttpServerTransaction* transaction) {
     current_->response.set_error(HC_INTERNAL_SERVER_ERROR);
   }
   bool keep_alive = HttpShouldKeepAlive(current_->request);
+  // The client can only find the end of the response without a close if it
+  // has a length or is chunked.
+  HttpResponseData& response = current_->response;
+  if (!response.hasHeader(HH_CONTENT_LENGTH, NULL) &&
+      !response.hasHeader(HH_TRANSFER_ENCODING, NULL)) {
+    size_t length = 0;
+    if (!response.document) {
+      if (HttpCodeHasBody(response.scode))
+        response.setHeader(HH_CONTENT_LENGTH, "0");
+    } else if (response.document->GetAvailable(&length)) {
+      response.setHeader(HH_CONTENT_LENGTH, ToString(length));
+    } else if (current_->request.version >= HVER_1_1) {
+      response.setHeader(HH_TRANSFER_ENCODING, "chunked");
+    } else {
+      keep_alive = false;
+    }
+  }
   current_->response.setHeader(HH_CONNECTION,
                                keep_alive ? "Keep-Alive" : "Close",
                                false);
@@ -264,7 +285,7 @@ int HttpListenServer::Listen(const SocketAddress& address) {
   listener_.reset(sock);
   listener_->SignalReadEvent.connect(this, &HttpListenServer::OnReadEvent);
   if ((listener_->Bind(address) != SOCKET_ERROR) &&
-      (listener_->Listen(5) != SOCKET_ERROR))
+      (listener_->Listen(kListenBacklog) != SOCKET_ERROR))
     return 0;
   return listener_->GetError();
 }
@@ -288,6 +309,9 @@ void HttpListenServer::OnReadEvent(AsyncSocket* socket) {
   ASSERT(listener_);
   AsyncSocket* incoming = listener_->Accept(NULL);
   if (incoming) {
+    // Responses are small and often pipelined; don't let Nagle hold them
+    // back waiting for the client's delayed ACK.
+    incoming->SetOption(Socket::OPT_NODELAY, 1);
     StreamInterface* stream = new SocketStream(incoming);
     //stream = new LoggingAdapter(stream, LS_VERBOSE, "HttpServer", false);
     HandleConnection(stream);
@@ -0,0 +1,220 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/mappedfile.h"
+
+#include <string.h>
+
+#ifdef POSIX
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "base/common.h"
+#include "base/logging.h"
+#include "base/stream.h"
+
+namespace talk_base {
+
+MappedFile::MappedFile()
+    : open_(false),
+      data_(NULL),
+      size_(0) {
+}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef POSIX
+
+bool MappedFile::Open(const std::string& filename) {
+  Close();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERR(LS_WARNING) << "Failed to open " << filename;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    LOG_ERR(LS_WARNING) << "Failed to stat " << filename;
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size > 0) {
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      LOG_ERR(LS_WARNING) << "Failed to map " << filename;
+      close(fd);
+      return false;
+    }
+    // The whole file is normally consumed front to back.
+    madvise(data, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8*>(data);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  size_ = size;
+  open_ = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ && !buffer_) {
+    munmap(const_cast<uint8*>(data_), size_);
+  }
+  buffer_.reset();
+  data_ = NULL;
+  size_ = 0;
+  open_ = false;
+}
+
+#else  // !POSIX
+
+bool MappedFile::Open(const std::string& filename) {
+  Close();
+  FileStream file;
+  size_t size = 0;
+  if (!file.Open(filename, "rb", NULL) || !file.GetSize(&size)) {
+    LOG(LS_WARNING) << "Failed to open " << filename;
+    return false;
+  }
+  if (size > 0) {
+    buffer_.reset(new uint8[size]);
+    if (file.ReadAll(buffer_.get(), size, NULL, NULL) != SR_SUCCESS) {
+      LOG(LS_WARNING) << "Failed to read " << filename;
+      buffer_.reset();
+      return false;
+    }
+    data_ = buffer_.get();
+  }
+  size_ = size;
+  open_ = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  buffer_.reset();
+  data_ = NULL;
+  size_ = 0;
+  open_ = false;
+}
+
+#endif  // POSIX
+
+MappedFileStream::MappedFileStream() : position_(0) {
+}
+
+MappedFileStream::~MappedFileStream() {
+}
+
+bool MappedFileStream::Open(const std::string& filename) {
+  position_ = 0;
+  return file_.Open(filename);
+}
+
+StreamState MappedFileStream::GetState() const {
+  return file_.is_open() ? SS_OPEN : SS_CLOSED;
+}
+
+StreamResult MappedFileStream::Read(void* buffer, size_t buffer_len,
+                                    size_t* read, int* error) {
+  if (!file_.is_open())
+    return SR_ERROR;
+  if (position_ >= file_.size())
+    return SR_EOS;
+  size_t available = file_.size() - position_;
+  size_t copied = (buffer_len < available) ? buffer_len : available;
+  memcpy(buffer, file_.data() + position_, copied);
+  position_ += copied;
+  if (read)
+    *read = copied;
+  return SR_SUCCESS;
+}
+
+StreamResult MappedFileStream::Write(const void* data, size_t data_len,
+                                     size_t* written, int* error) {
+  if (error)
+    *error = -1;
+  return SR_ERROR;
+}
+
+void MappedFileStream::Close() {
+  file_.Close();
+  position_ = 0;
+}
+
+const void* MappedFileStream::GetReadData(size_t* data_len) {
+  if (!file_.is_open() || position_ >= file_.size()) {
+    *data_len = 0;
+    return NULL;
+  }
+  *data_len = file_.size() - position_;
+  return file_.data() + position_;
+}
+
+void MappedFileStream::ConsumeReadData(size_t used) {
+  ASSERT(position_ + used <= file_.size());
+  position_ += used;
+}
+
+bool MappedFileStream::SetPosition(size_t position) {
+  if (!file_.is_open() || position > file_.size())
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool MappedFileStream::GetPosition(size_t* position) const {
+  if (!file_.is_open())
+    return false;
+  if (position)
+    *position = position_;
+  return true;
+}
+
+bool MappedFileStream::GetSize(size_t* size) const {
+  if (!file_.is_open())
+    return false;
+  if (size)
+    *size = file_.size();
+  return true;
+}
+
+bool MappedFileStream::GetAvailable(size_t* size) const {
+  if (!file_.is_open())
+    return false;
+  if (size)
+    *size = file_.size() - position_;
+  return true;
+}
+
+}  // namespace talk_base
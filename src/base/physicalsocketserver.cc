@@ -72,12 +72,28 @@
 typedef void* SockOptArg;
 #endif  // POSIX
 
+#ifdef LINUX
+#include <poll.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#endif  // LINUX
+
 #ifdef WIN32
 typedef char* SockOptArg;
 #endif
 
 namespace talk_base {
 
+#ifdef LINUX
+// Keeps the byte count of one SendFile within the int it returns.
+static const size_t kMaxSendFileLength = 1 << 30;
+
+// Ready descriptors collected per epoll_wait. Any beyond this stay ready and
+// are picked up on the next pass, since the set is level-triggered.
+static const int kMaxEpollEvents = 128;
+#endif  // LINUX
+
 // Standard MTUs, from RFC 1191
 const uint16 PACKET_MAXIMUMS[] = {
   65535,    // Theoretical maximum, Hyperchannel
@@ -141,7 +157,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     udp_ = (SOCK_DGRAM == type);
     UpdateLastError();
     if (udp_)
-      enabled_events_ = DE_READ | DE_WRITE;
+      SetEnabledEvents(DE_READ | DE_WRITE);
     return s_ != INVALID_SOCKET;
   }
 
@@ -224,12 +240,12 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
       state_ = CS_CONNECTED;
     } else if (IsBlockingError(error_)) {
       state_ = CS_CONNECTING;
-      enabled_events_ |= DE_CONNECT;
+      EnableEvents(DE_CONNECT);
     } else {
       return SOCKET_ERROR;
     }
 
-    enabled_events_ |= DE_READ | DE_WRITE;
+    EnableEvents(DE_READ | DE_WRITE);
     return 0;
   }
 
@@ -290,11 +306,35 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     // We have seen minidumps where this may be false.
     ASSERT(sent <= static_cast<int>(cb));
     if ((sent < 0) && IsBlockingError(error_)) {
-      enabled_events_ |= DE_WRITE;
+      EnableEvents(DE_WRITE);
     }
     return sent;
   }
 
+#ifdef LINUX
+  virtual int SendFile(int fd, size_t offset, size_t length) {
+    // Unlike send(), sendfile() has no MSG_NOSIGNAL.  Keep SIGPIPE blocked
+    // on this thread for the call, and swallow the one a closed peer raises.
+    sigset_t pipe_set, old_set;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+    off_t file_offset = static_cast<off_t>(offset);
+    ssize_t sent = ::sendfile(s_, fd, &file_offset,
+                              std::min(length, kMaxSendFileLength));
+    UpdateLastError();
+    if ((sent < 0) && (error_ == EPIPE) && !sigismember(&old_set, SIGPIPE)) {
+      struct timespec zero = { 0, 0 };
+      sigtimedwait(&pipe_set, NULL, &zero);
+    }
+    pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+    if ((sent < 0) && IsBlockingError(error_)) {
+      EnableEvents(DE_WRITE);
+    }
+    return static_cast<int>(sent);
+  }
+#endif  // LINUX
+
   int SendTo(const void* buffer, size_t length, const SocketAddress& addr) {
     sockaddr_storage saddr;
     size_t len = addr.ToSockAddrStorage(&saddr);
@@ -311,7 +351,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     // We have seen minidumps where this may be false.
     ASSERT(sent <= static_cast<int>(length));
     if ((sent < 0) && IsBlockingError(error_)) {
-      enabled_events_ |= DE_WRITE;
+      EnableEvents(DE_WRITE);
     }
     return sent;
   }
@@ -326,14 +366,14 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
       LOG(LS_WARNING) << "EOF from socket; deferring close event";
       // Must turn this back on so that the select() loop will notice the close
       // event.
-      enabled_events_ |= DE_READ;
+      EnableEvents(DE_READ);
       error_ = EWOULDBLOCK;
       return SOCKET_ERROR;
     }
     UpdateLastError();
     bool success = (received >= 0) || IsBlockingError(error_);
     if (udp_ || success) {
-      enabled_events_ |= DE_READ;
+      EnableEvents(DE_READ);
     }
     if (!success) {
       LOG_F(LS_VERBOSE) << "Error = " << error_;
@@ -352,7 +392,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
       SocketAddressFromSockAddrStorage(addr_storage, out_addr);
     bool success = (received >= 0) || IsBlockingError(error_);
     if (udp_ || success) {
-      enabled_events_ |= DE_READ;
+      EnableEvents(DE_READ);
     }
     if (!success) {
       LOG_F(LS_VERBOSE) << "Error = " << error_;
@@ -365,7 +405,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     UpdateLastError();
     if (err == 0) {
       state_ = CS_CONNECTING;
-      enabled_events_ |= DE_ACCEPT;
+      EnableEvents(DE_ACCEPT);
 #ifdef _DEBUG
       dbg_addr_ = "Listening @ ";
       dbg_addr_.append(GetLocalAddress().ToString());
@@ -382,7 +422,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     UpdateLastError();
     if (s == INVALID_SOCKET)
       return NULL;
-    enabled_events_ |= DE_ACCEPT;
+    EnableEvents(DE_ACCEPT);
     if (out_addr != NULL)
       SocketAddressFromSockAddrStorage(addr_storage, out_addr);
     return ss_->WrapSocket(s);
@@ -395,7 +435,7 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     UpdateLastError();
     s_ = INVALID_SOCKET;
     state_ = CS_CLOSED;
-    enabled_events_ = 0;
+    SetEnabledEvents(0);
     if (resolver_) {
       resolver_->Destroy(false);
       resolver_ = NULL;
@@ -488,6 +528,17 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
     error_ = LAST_SYSTEM_ERROR;
   }
 
+  void EnableEvents(uint8 events) {
+    SetEnabledEvents(enabled_events_ | events);
+  }
+  void DisableEvents(uint8 events) {
+    SetEnabledEvents(enabled_events_ & ~events);
+  }
+  // Dispatchers override this to tell the server what they now wait for.
+  virtual void SetEnabledEvents(uint8 events) {
+    enabled_events_ = events;
+  }
+
   static int TranslateOption(Option opt, int* slevel, int* sopt) {
     switch (opt) {
       case OPT_DONTFRAGMENT:
@@ -515,6 +566,19 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
         *slevel = IPPROTO_TCP;
         *sopt = TCP_NODELAY;
         break;
+      case OPT_REUSEPORT:
+#ifdef SO_REUSEPORT
+        *slevel = SOL_SOCKET;
+        *sopt = SO_REUSEPORT;
+        break;
+#else
+        LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+        return -1;
+#endif
+      case OPT_REUSEADDR:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_REUSEADDR;
+        break;
       default:
         ASSERT(false);
         return -1;
@@ -855,6 +919,13 @@ class SocketDispatcher : public Dispatcher, public PhysicalSocket {
     return enabled_events_;
   }
 
+  virtual void SetEnabledEvents(uint8 events) {
+    if (events == enabled_events_)
+      return;
+    PhysicalSocket::SetEnabledEvents(events);
+    ss_->Update(this);
+  }
+
   virtual void OnPreEvent(uint32 ff) {
     if ((ff & DE_CONNECT) != 0)
       state_ = CS_CONNECTED;
@@ -866,24 +937,24 @@ class SocketDispatcher : public Dispatcher, public PhysicalSocket {
     // Make sure we deliver connect/accept first. Otherwise, consumers may see
     // something like a READ followed by a CONNECT, which would be odd.
     if ((ff & DE_CONNECT) != 0) {
-      enabled_events_ &= ~DE_CONNECT;
+      DisableEvents(DE_CONNECT);
       SignalConnectEvent(this);
     }
     if ((ff & DE_ACCEPT) != 0) {
-      enabled_events_ &= ~DE_ACCEPT;
+      DisableEvents(DE_ACCEPT);
       SignalReadEvent(this);
     }
     if ((ff & DE_READ) != 0) {
-      enabled_events_ &= ~DE_READ;
+      DisableEvents(DE_READ);
       SignalReadEvent(this);
     }
     if ((ff & DE_WRITE) != 0) {
-      enabled_events_ &= ~DE_WRITE;
+      DisableEvents(DE_WRITE);
       SignalWriteEvent(this);
     }
     if ((ff & DE_CLOSE) != 0) {
       // The socket is now dead to us, so stop checking it.
-      enabled_events_ = 0;
+      SetEnabledEvents(0);
       SignalCloseEvent(this, err);
     }
   }
@@ -943,6 +1014,7 @@ class FileDispatcher: public Dispatcher, public AsyncFile {
 
   virtual void set_readable(bool value) {
     flags_ = value ? (flags_ | DE_READ) : (flags_ & ~DE_READ);
+    ss_->Update(this);
   }
 
   virtual bool writable() {
@@ -951,6 +1023,7 @@ class FileDispatcher: public Dispatcher, public AsyncFile {
 
   virtual void set_writable(bool value) {
     flags_ = value ? (flags_ | DE_WRITE) : (flags_ & ~DE_WRITE);
+    ss_->Update(this);
   }
 
  private:
@@ -1175,6 +1248,9 @@ PhysicalSocketServer::PhysicalSocketServer()
     : fWait_(false),
       last_tick_tracked_(0),
       last_tick_dispatch_count_(0) {
+#ifdef LINUX
+  epoll_fd_ = -1;
+#endif
   signal_wakeup_ = new Signaler(this, &fWait_);
 #ifdef WIN32
   socket_ev_ = WSACreateEvent();
@@ -1190,6 +1266,10 @@ PhysicalSocketServer::~PhysicalSocketServer() {
 #endif
   delete signal_wakeup_;
   ASSERT(dispatchers_.empty());
+#ifdef LINUX
+  if (epoll_fd_ != -1)
+    close(epoll_fd_);
+#endif
 }
 
 void PhysicalSocketServer::WakeUp() {
@@ -1243,6 +1323,10 @@ void PhysicalSocketServer::Add(Dispatcher *pdispatcher) {
   if (pos != dispatchers_.end())
     return;
   dispatchers_.push_back(pdispatcher);
+#ifdef LINUX
+  if (epoll_fd_ != -1)
+    epoll_dirty_.insert(pdispatcher);
+#endif
 }
 
 void PhysicalSocketServer::Remove(Dispatcher *pdispatcher) {
@@ -1259,10 +1343,39 @@ void PhysicalSocketServer::Remove(Dispatcher *pdispatcher) {
       --**it;
     }
   }
+#ifdef LINUX
+  // Dispatchers are removed before their descriptor is closed, so the one
+  // we registered is still the one to take out of the set.
+  EpollMap::iterator entry = epoll_entries_.find(pdispatcher);
+  if (entry != epoll_entries_.end()) {
+    if (entry->second.events != 0)
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry->second.fd, NULL);
+    epoll_entries_.erase(entry);
+  }
+  epoll_dirty_.erase(pdispatcher);
+#endif
+}
+
+void PhysicalSocketServer::Update(Dispatcher *pdispatcher) {
+#ifdef LINUX
+  if (epoll_fd_ == -1)
+    return;
+  CritScope cs(&crit_);
+  // Ignore dispatchers that aren't registered (any more), e.g. a socket that
+  // clears its events while closing after it was removed. Those that were
+  // just added are already marked.
+  if (epoll_entries_.find(pdispatcher) != epoll_entries_.end())
+    epoll_dirty_.insert(pdispatcher);
+#endif
 }
 
 #ifdef POSIX
 bool PhysicalSocketServer::Wait(int cmsWait, bool process_io) {
+#ifdef LINUX
+  if (epoll_fd_ != -1)
+    return WaitEpoll(cmsWait, process_io);
+#endif
+
   // Calculate timing information
 
   struct timeval *ptvWait = NULL;
@@ -1413,6 +1526,172 @@ bool PhysicalSocketServer::Wait(int cmsWait, bool process_io) {
   return true;
 }
 
+#ifdef LINUX
+bool PhysicalSocketServer::EnableEpoll() {
+  if (epoll_fd_ != -1)
+    return true;
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ == -1) {
+    LOG_E(LS_WARNING, EN, errno) << "epoll_create1";
+    return false;
+  }
+  // Registration happens lazily in WaitEpoll; the dispatchers that are
+  // already here just need to be looked at once.
+  CritScope cs(&crit_);
+  epoll_dirty_.insert(dispatchers_.begin(), dispatchers_.end());
+  return true;
+}
+
+void PhysicalSocketServer::UpdateEpoll(Dispatcher* pdispatcher) {
+  uint32 ff = pdispatcher->GetRequestedEvents();
+  uint32 events = 0;
+  if (ff & (DE_READ | DE_ACCEPT))
+    events |= EPOLLIN | EPOLLRDHUP;
+  if (ff & (DE_WRITE | DE_CONNECT))
+    events |= EPOLLOUT;
+  int fd = pdispatcher->GetDescriptor();
+
+  EpollEntry& entry = epoll_entries_[pdispatcher];
+  if (entry.events != 0 && entry.fd != fd) {
+    // Closed and recreated under the same dispatcher.
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry.fd, NULL);
+    entry.events = 0;
+  }
+  entry.fd = fd;
+  if (entry.events == events)
+    return;
+
+  // A dispatcher that wants nothing is taken out of the set, otherwise
+  // EPOLLHUP and EPOLLERR, which can't be masked, would keep waking us up.
+  int op;
+  if (events == 0) {
+    op = EPOLL_CTL_DEL;
+  } else if (entry.events == 0) {
+    op = EPOLL_CTL_ADD;
+  } else {
+    op = EPOLL_CTL_MOD;
+  }
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = events;
+  event.data.ptr = pdispatcher;
+  if (epoll_ctl(epoll_fd_, op, fd, &event) < 0) {
+    LOG_E(LS_WARNING, EN, errno) << "epoll_ctl";
+  }
+  entry.events = events;
+}
+
+bool PhysicalSocketServer::WaitEpoll(int cmsWait, bool process_io) {
+  uint32 stop = (cmsWait != kForever) ? TimeAfter(cmsWait) : 0;
+  int cms = cmsWait;
+
+  fWait_ = true;
+
+  while (fWait_) {
+    struct epoll_event events[kMaxEpollEvents];
+    int n;
+    if (process_io) {
+      {
+        // Bring the set up to date for the dispatchers whose requested events
+        // changed since the last wait. This only costs a syscall for the ones
+        // that really moved.
+        CritScope cr(&crit_);
+        for (DispatcherSet::iterator it = epoll_dirty_.begin();
+             it != epoll_dirty_.end(); ++it)
+          UpdateEpoll(*it);
+        epoll_dirty_.clear();
+      }
+      n = epoll_wait(epoll_fd_, events, kMaxEpollEvents, cms);
+    } else {
+      // Only the wakeup matters. Waiting on the whole set would spin on
+      // sockets that are ready but that we aren't allowed to service.
+      struct pollfd wakeup;
+      wakeup.fd = signal_wakeup_->GetDescriptor();
+      wakeup.events = POLLIN;
+      wakeup.revents = 0;
+      n = poll(&wakeup, 1, cms);
+      if (n > 0) {
+        events[0].events = EPOLLIN;
+        events[0].data.ptr = signal_wakeup_;
+      }
+    }
+
+    if (n < 0) {
+      if (errno != EINTR) {
+        LOG_E(LS_ERROR, EN, errno) << "epoll_wait";
+        return false;
+      }
+      // Else ignore the error and keep going, as in the select() loop.
+    } else if (n == 0) {
+      // If timeout, return success
+      return true;
+    } else {
+      CritScope cr(&crit_);
+      for (int i = 0; i < n; ++i) {
+        Dispatcher* pdispatcher = static_cast<Dispatcher*>(events[i].data.ptr);
+        // A handler earlier in this batch may have removed it.
+        if ((pdispatcher != signal_wakeup_) &&
+            (epoll_entries_.find(pdispatcher) == epoll_entries_.end()))
+          continue;
+
+        uint32 requested = pdispatcher->GetRequestedEvents();
+        uint32 revents = events[i].events;
+        bool failed = (revents & (EPOLLERR | EPOLLHUP)) != 0;
+        uint32 ff = 0;
+        int errcode = 0;
+
+        // Errors are only worth a getsockopt when epoll says there is one.
+        if (failed) {
+          socklen_t len = sizeof(errcode);
+          ::getsockopt(pdispatcher->GetDescriptor(), SOL_SOCKET, SO_ERROR,
+                       &errcode, &len);
+        }
+
+        // Same interpretation as the select() loop. The peek for a closed
+        // descriptor is skipped unless epoll reports a hangup.
+        if ((requested & (DE_READ | DE_ACCEPT)) &&
+            (failed || (revents & (EPOLLIN | EPOLLRDHUP)))) {
+          if (requested & DE_ACCEPT) {
+            ff |= DE_ACCEPT;
+          } else if (errcode ||
+                     ((revents & (EPOLLRDHUP | EPOLLHUP)) &&
+                      pdispatcher->IsDescriptorClosed())) {
+            ff |= DE_CLOSE;
+          } else {
+            ff |= DE_READ;
+          }
+        }
+
+        if ((requested & (DE_WRITE | DE_CONNECT)) &&
+            (failed || (revents & EPOLLOUT))) {
+          if (requested & DE_CONNECT) {
+            if (!errcode) {
+              ff |= DE_CONNECT;
+            } else {
+              ff |= DE_CLOSE;
+            }
+          } else {
+            ff |= DE_WRITE;
+          }
+        }
+
+        // Tell the descriptor about the event.
+        if (ff != 0) {
+          pdispatcher->OnPreEvent(ff);
+          pdispatcher->OnEvent(ff, errcode);
+        }
+      }
+    }
+
+    if (cmsWait != kForever) {
+      cms = _max<int32>(TimeUntil(stop), 0);
+    }
+  }
+
+  return true;
+}
+#endif  // LINUX
+
 static void GlobalSignalHandler(int signum) {
   PosixSignalHandler::Instance()->OnPosixSignalReceived(signum);
 }
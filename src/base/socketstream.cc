@@ -109,6 +109,22 @@ StreamResult SocketStream::Write(const void* data, size_t data_len,
   return SR_SUCCESS;
 }
 
+StreamResult SocketStream::SendFile(int fd, size_t offset, size_t length,
+                                    size_t* written, int* error) {
+  ASSERT(socket_ != NULL);
+  int result = socket_->SendFile(fd, offset, length);
+  if (result < 0) {
+    if (socket_->IsBlocking())
+      return SR_BLOCK;
+    if (error)
+      *error = socket_->GetError();
+    return SR_ERROR;
+  }
+  if (written)
+    *written = result;
+  return SR_SUCCESS;
+}
+
 void SocketStream::Close() {
   ASSERT(socket_ != NULL);
   socket_->Close();
@@ -28,6 +28,9 @@
 #if defined(POSIX)
 #include <sys/file.h>
 #endif  // POSIX
+#if defined(LINUX)
+#include <fcntl.h>
+#endif  // LINUX
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
@@ -474,8 +477,21 @@ bool FileStream::GetAvailable(size_t* size) const {
 }
 
 bool FileStream::ReserveSize(size_t size) {
+#if defined(LINUX)
+  // Allocate the blocks up front so that a long sequential write neither
+  // fragments the file nor runs out of space halfway through. The file size,
+  // and so what readers see, is left alone.
+  if (!file_)
+    return false;
+  if (fallocate(fileno(file_), FALLOC_FL_KEEP_SIZE, 0, size) != 0) {
+    // Not every file system can preallocate; that isn't an error.
+    return (errno == EOPNOTSUPP || errno == ENOSYS);
+  }
+  return true;
+#else
   // TODO: extend the file to the proper length
   return true;
+#endif
 }
 
 bool FileStream::GetSize(const std::string& filename, size_t* size) {
@@ -497,6 +513,16 @@ bool FileStream::Flush() {
 
 #if defined(POSIX)
 
+bool FileStream::GetFileDescriptor(int* fd) const {
+  if (file_ == NULL)
+    return false;
+  // Reads through the descriptor bypass the stdio buffer, so there must not
+  // be any unwritten data in it.
+  fflush(file_);
+  *fd = fileno(file_);
+  return true;
+}
+
 bool FileStream::TryLock() {
   if (file_ == NULL) {
     // Stream not open.
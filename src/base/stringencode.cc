@@ -136,10 +136,8 @@ const char* unsafe_filename_characters() {
 #ifdef WIN32
   return "\\/:*?\"<>|";
 #else  // !WIN32
-  // TODO
-  ASSERT(false);
-  return "";
-#endif  // !WIN23
+  return "/";
+#endif  // !WIN32
 }
 
 const unsigned char URL_UNSAFE  = 0x1; // 0-33 "#$%&+,/:;<=>?@[\]^`{|} 127
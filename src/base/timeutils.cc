@@ -48,7 +48,22 @@ namespace talk_base {
 const uint32 LAST = 0xFFFFFFFF;
 const uint32 HALF = 0x80000000;
 
+static ClockInterface* g_clock = NULL;
+
+ClockInterface* SetClock(ClockInterface* clock) {
+  ClockInterface* prev = g_clock;
+  g_clock = clock;
+  return prev;
+}
+
 uint64 TimeNanos() {
+  if (g_clock) {
+    return g_clock->TimeNanos();
+  }
+  return SystemTimeNanos();
+}
+
+uint64 SystemTimeNanos() {
   int64 ticks = 0;
 #if defined(OSX) || defined(IOS)
   static mach_timebase_info_data_t timebase;
@@ -560,7 +560,8 @@ VirtualSocketServer::VirtualSocketServer(SocketServer* ss)
       send_buffer_capacity_(kDefaultTcpBufferSize),
       recv_buffer_capacity_(kDefaultTcpBufferSize),
       delay_mean_(0), delay_stddev_(0), delay_samples_(NUM_SAMPLES),
-      delay_dist_(NULL), drop_prob_(0.0) {
+      delay_dist_(NULL), drop_prob_(0.0), prev_clock_(NULL),
+      wakeup_pending_(false) {
   if (!server_) {
     server_ = new PhysicalSocketServer();
     server_owned_ = true;
@@ -569,6 +570,7 @@ VirtualSocketServer::VirtualSocketServer(SocketServer* ss)
 }
 
 VirtualSocketServer::~VirtualSocketServer() {
+  SetVirtualTime(false);
   delete bindings_;
   delete connections_;
   delete delay_dist_;
@@ -630,15 +632,60 @@ void VirtualSocketServer::SetMessageQueue(MessageQueue* msg_queue) {
   }
 }
 
+void VirtualSocketServer::SetVirtualTime(bool enable) {
+  if (enable == virtual_time()) {
+    return;
+  }
+  if (enable) {
+    clock_.reset(new SimulatedClock(TimeNanos()));
+    prev_clock_ = SetClock(clock_.get());
+  } else {
+    SetClock(prev_clock_);
+    prev_clock_ = NULL;
+    clock_.reset();
+  }
+}
+
+void VirtualSocketServer::AdvanceTime(uint32 ms) {
+  ASSERT(virtual_time());
+  if (clock_) {
+    clock_->AdvanceTime(ms);
+  }
+}
+
 bool VirtualSocketServer::Wait(int cmsWait, bool process_io) {
   ASSERT(msg_queue_ == Thread::Current());
   if (stop_on_idle_ && Thread::Current()->empty()) {
     return false;
   }
+  if (clock_ && cmsWait != kForever) {
+    // The message queue only waits when nothing is ready, and |cmsWait| is
+    // never past its next delayed message, so nothing can happen before then
+    // in simulated time. Pick up wake-ups from other threads and jump ahead,
+    // unless one of them may have posted a message that is due sooner; the
+    // queue then looks again and waits for the new deadline.
+    if (!socketserver()->Wait(0, process_io)) {
+      return false;
+    }
+    bool woken_up;
+    {
+      CritScope cs(&wakeup_crit_);
+      woken_up = wakeup_pending_;
+      wakeup_pending_ = false;
+    }
+    if (!woken_up) {
+      clock_->AdvanceTime(cmsWait);
+    }
+    return true;
+  }
   return socketserver()->Wait(cmsWait, process_io);
 }
 
 void VirtualSocketServer::WakeUp() {
+  {
+    CritScope cs(&wakeup_crit_);
+    wakeup_pending_ = true;
+  }
   socketserver()->WakeUp();
 }
 
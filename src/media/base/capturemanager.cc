@@ -174,6 +174,12 @@ bool CaptureManager::StopVideoCapture(VideoCapturer* video_capturer,
 
 bool CaptureManager::AddVideoRenderer(VideoCapturer* video_capturer,
                                       VideoRenderer* video_renderer) {
+  return AddVideoRenderer(video_capturer, video_renderer, 0, 0);
+}
+
+bool CaptureManager::AddVideoRenderer(VideoCapturer* video_capturer,
+                                      VideoRenderer* video_renderer,
+                                      int width, int height) {
   if (!video_capturer || !video_renderer) {
     return false;
   }
@@ -181,7 +187,7 @@ bool CaptureManager::AddVideoRenderer(VideoCapturer* video_capturer,
   if (!adapter) {
     return false;
   }
-  return adapter->AddRenderer(video_renderer);
+  return adapter->AddRenderer(video_renderer, width, height);
 }
 
 bool CaptureManager::RemoveVideoRenderer(VideoCapturer* video_capturer,
@@ -57,14 +57,20 @@ CaptureRenderAdapter* CaptureRenderAdapter::Create(
 }
 
 bool CaptureRenderAdapter::AddRenderer(VideoRenderer* video_renderer) {
-  if (!video_renderer) {
+  return AddRenderer(video_renderer, 0, 0);
+}
+
+bool CaptureRenderAdapter::AddRenderer(VideoRenderer* video_renderer,
+                                       int width, int height) {
+  if (!video_renderer || width < 0 || height < 0) {
     return false;
   }
   talk_base::CritScope cs(&capture_crit_);
   if (IsRendererRegistered(*video_renderer)) {
     return false;
   }
-  video_renderers_.push_back(VideoRendererInfo(video_renderer));
+  video_renderers_.push_back(
+      VideoRendererInfo(video_renderer, width, height));
   return true;
 }
 
@@ -95,29 +101,34 @@ void CaptureRenderAdapter::OnVideoFrame(VideoCapturer* capturer,
   if (video_renderers_.empty()) {
     return;
   }
-  MaybeSetRenderingSize(video_frame);
 
   for (VideoRenderers::iterator iter = video_renderers_.begin();
        iter != video_renderers_.end(); ++iter) {
-    VideoRenderer* video_renderer = iter->renderer;
-    video_renderer->RenderFrame(video_frame);
+    const VideoFrame* frame = video_frame;
+    if (iter->desired_width && iter->desired_height) {
+      frame = capturer->scaled_frames()->GetScaledFrame(
+          video_frame, iter->desired_width, iter->desired_height);
+      if (!frame) {
+        continue;
+      }
+    }
+    MaybeSetRenderingSize(&*iter, frame);
+    iter->renderer->RenderFrame(frame);
   }
 }
 
 // The renderer_crit_ lock needs to be taken when calling this function.
-void CaptureRenderAdapter::MaybeSetRenderingSize(const VideoFrame* frame) {
-  for (VideoRenderers::iterator iter = video_renderers_.begin();
-       iter != video_renderers_.end(); ++iter) {
-    const bool new_resolution = iter->render_width != frame->GetWidth() ||
-        iter->render_height != frame->GetHeight();
-    if (new_resolution) {
-      if (iter->renderer->SetSize(frame->GetWidth(), frame->GetHeight(), 0)) {
-        iter->render_width = frame->GetWidth();
-        iter->render_height = frame->GetHeight();
-      } else {
-        LOG(LS_ERROR) << "Captured frame size not supported by renderer: " <<
-            frame->GetWidth() << " x " << frame->GetHeight();
-      }
+void CaptureRenderAdapter::MaybeSetRenderingSize(VideoRendererInfo* info,
+                                                 const VideoFrame* frame) {
+  const bool new_resolution = info->render_width != frame->GetWidth() ||
+      info->render_height != frame->GetHeight();
+  if (new_resolution) {
+    if (info->renderer->SetSize(frame->GetWidth(), frame->GetHeight(), 0)) {
+      info->render_width = frame->GetWidth();
+      info->render_height = frame->GetHeight();
+    } else {
+      LOG(LS_ERROR) << "Captured frame size not supported by renderer: " <<
+          frame->GetWidth() << " x " << frame->GetHeight();
     }
   }
 }
@@ -72,4 +72,7 @@ const char* kCodecParamMaxBitrate = "x-google-max-bitrate";
 const char* kCodecParamMinBitrate = "x-google-min-bitrate";
 const char* kCodecParamMaxQuantization = "x-google-max-quantization";
 
+const char* kRtpAudioLevelHeaderExtension =
+    "urn:ietf:params:rtp-hdrext:ssrc-audio-level";
+
 }  // namespace cricket
@@ -0,0 +1,460 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "media/base/frameconverter.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#ifdef HAVE_YUV
+#include "libyuv/convert.h"
+#include "libyuv/scale.h"
+#endif
+
+#include "base/logging.h"
+#include "base/messagequeue.h"
+#include "base/systeminfo.h"
+#include "base/thread.h"
+#include "base/timeutils.h"
+#include "media/base/videocapturer.h"
+#include "media/base/videocommon.h"
+
+namespace cricket {
+
+enum {
+  MSG_CONVERT_STRIPE = 1
+};
+
+typedef talk_base::TypedMessageData<size_t> StripeMessageData;
+
+// Scratch budget for one block of converted source rows, small enough for the
+// block to still be in L2 when it is scaled.
+static const int kBlockBytes = 256 * 1024;
+// Source pixels per stripe below which handing work to another thread costs
+// more than it saves.
+static const int kMinStripePixels = 640 * 360;
+static const int kMaxWorkers = 3;
+
+static int GreatestCommonDivisor(int a, int b) {
+  while (b) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Bytes of I420 for |rows| rows of |width| pixels.
+static size_t I420Size(int width, int rows) {
+  return static_cast<size_t>(width) * rows +
+      static_cast<size_t>((width + 1) / 2) * ((rows + 1) / 2) * 2;
+}
+
+// Returns true if libyuv can convert a band of rows of a |fourcc| sample on
+// its own, by cropping, which is what block conversion relies on.
+static bool CanConvertInBlocks(uint32 fourcc) {
+  switch (fourcc) {
+    case FOURCC_I420:
+    case FOURCC_YV12:
+    case FOURCC_NV12:
+    case FOURCC_NV21:
+    case FOURCC_YUY2:
+    case FOURCC_UYVY:
+    case FOURCC_ARGB:
+    case FOURCC_BGRA:
+    case FOURCC_ABGR:
+    case FOURCC_24BG:
+    case FOURCC_RAW:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if scaling |src_width| x |src_height| to |dst_width| x
+// |dst_height| in bands of rows gives the same output as scaling it whole.
+// That holds when each output row is made from its own source rows only: no
+// vertical scaling, a box filter (libyuv's kFilterBox only boxes below half
+// height), or libyuv's 1/2 and 3/4 kernels. Bilinear filtering, used for
+// upscales and for downscales by less than 2x, reads the row past the end of
+// a band and would leave a seam there.
+static bool ScalesInExactBlocks(int src_width, int src_height,
+                                int dst_width, int dst_height) {
+  return dst_height == src_height ||
+      dst_height * 2 < src_height ||
+      (dst_width * 2 == src_width && dst_height * 2 == src_height) ||
+      (dst_width * 4 == src_width * 3 && dst_height * 4 == src_height * 3);
+}
+
+FrameConverter::FrameConverter(int num_workers)
+    : num_workers_(std::max(num_workers, 0)),
+      stripes_(num_workers_ + 1),
+      sample_(NULL),
+      sample_size_(0),
+      fourcc_(0),
+      src_width_(0),
+      src_height_(0),
+      crop_x_(0),
+      crop_y_(0),
+      crop_width_(0),
+      dst_y_(NULL),
+      dst_u_(NULL),
+      dst_v_(NULL),
+      dst_y_pitch_(0),
+      dst_u_pitch_(0),
+      dst_v_pitch_(0),
+      dst_width_(0),
+      dst_height_(0),
+      pending_stripes_(0),
+      stripes_done_(false, false) {
+}
+
+FrameConverter::~FrameConverter() {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->Clear(this);
+    workers_[i]->Stop();
+    delete workers_[i];
+  }
+}
+
+int FrameConverter::DefaultNumWorkers() {
+  talk_base::SystemInfo info;
+  return std::min(std::max(info.GetMaxCpus() - 1, 0), kMaxWorkers);
+}
+
+FrameConverter::Stats FrameConverter::GetStats() const {
+  talk_base::CritScope cs(&crit_);
+  return stats_;
+}
+
+void FrameConverter::ResetStats() {
+  talk_base::CritScope cs(&crit_);
+  stats_ = Stats();
+}
+
+bool FrameConverter::Convert(const CapturedFrame* frame,
+                             int crop_width, int crop_height,
+                             uint8* y, int y_pitch, uint8* u, int u_pitch,
+                             uint8* v, int v_pitch, int width, int height) {
+#ifdef HAVE_YUV
+  if (!frame || !frame->data || crop_width <= 0 || crop_height <= 0 ||
+      width <= 0 || height <= 0) {
+    return false;
+  }
+  uint64 start = talk_base::SystemTimeNanos();
+  sample_ = static_cast<const uint8*>(frame->data);
+  sample_size_ = frame->data_size;
+  fourcc_ = CanonicalFourCC(frame->fourcc);
+  src_width_ = frame->width;
+  src_height_ = frame->height;
+  // Centre the crop, keeping it on even pixels for the chroma planes.
+  crop_x_ = ((frame->width - crop_width) / 2) & ~1;
+  crop_y_ = ((abs(frame->height) - crop_height) / 2) & ~1;
+  crop_width_ = crop_width;
+  dst_y_ = y;
+  dst_u_ = u;
+  dst_v_ = v;
+  dst_y_pitch_ = y_pitch;
+  dst_u_pitch_ = u_pitch;
+  dst_v_pitch_ = v_pitch;
+  dst_width_ = width;
+  dst_height_ = height;
+
+  int num_stripes = 1;
+  int64 convert_time_ns = 0;
+  int64 scale_time_ns = 0;
+  bool ok;
+  int block_dst_rows = 0;
+  if (frame->rotation == 0 && frame->height > 0 &&
+      CanConvertInBlocks(fourcc_) &&
+      ScalesInExactBlocks(crop_width, crop_height, width, height)) {
+    // Block boundaries depend only on the sizes, so the output is the same
+    // whatever the number of stripes. Each block of 2q output rows for a
+    // scale of p/q starts on an exact, even source row and is scaled with
+    // the same ratio as the whole frame.
+    int row_bytes = crop_width + (crop_width + 1) / 2;
+    int block_src_rows = std::max(2, (kBlockBytes / row_bytes) & ~1);
+    int gcd = GreatestCommonDivisor(crop_height, height);
+    int unit_src_rows = 2 * (crop_height / gcd);
+    int unit_dst_rows = 2 * (height / gcd);
+    if (unit_src_rows <= block_src_rows) {
+      block_dst_rows = block_src_rows / unit_src_rows * unit_dst_rows;
+    } else if (unit_src_rows < crop_height) {
+      // Bigger than the cache budget, but still exact.
+      block_dst_rows = unit_dst_rows;
+    }
+    // Otherwise there are no exact row pairs inside the frame, and blocks
+    // with their own rounded ratio would leave seams; convert it whole.
+  }
+  if (block_dst_rows > 0) {
+    dst_rows_.clear();
+    src_rows_.clear();
+    for (int dst_row = 0; dst_row < height; dst_row += block_dst_rows) {
+      int src_row = static_cast<int>(
+          static_cast<int64>(dst_row) * crop_height / height) & ~1;
+      if (!src_rows_.empty() && src_row == src_rows_.back()) {
+        continue;  // Upscaling; fold into the previous block.
+      }
+      dst_rows_.push_back(dst_row);
+      src_rows_.push_back(src_row);
+    }
+    dst_rows_.push_back(height);
+    src_rows_.push_back(crop_height);
+    ok = ConvertInBlocks(&num_stripes, &convert_time_ns, &scale_time_ns);
+  } else {
+    ok = ConvertWhole(crop_height, frame->rotation,
+                      &convert_time_ns, &scale_time_ns);
+  }
+  sample_ = NULL;
+  dst_y_ = dst_u_ = dst_v_ = NULL;
+  if (!ok) {
+    LOG(LS_ERROR) << "Failed to convert " << GetFourccName(fourcc_) << " "
+                  << frame->width << "x" << frame->height << " to "
+                  << width << "x" << height;
+  }
+
+  talk_base::CritScope cs(&crit_);
+  ++stats_.frames;
+  if (num_stripes > 1) {
+    ++stats_.striped_frames;
+  }
+  stats_.convert_time_ns += convert_time_ns;
+  stats_.scale_time_ns += scale_time_ns;
+  stats_.total_time_ns += talk_base::SystemTimeNanos() - start;
+  return ok;
+#else
+  return false;
+#endif
+}
+
+bool FrameConverter::ConvertInBlocks(int* num_stripes,
+                                     int64* convert_time_ns,
+                                     int64* scale_time_ns) {
+  size_t num_blocks = dst_rows_.size() - 1;
+  bool scale = crop_width_ != dst_width_ ||
+      src_rows_.back() != dst_rows_.back();
+  size_t scratch_size = 0;
+  if (scale) {
+    int max_rows = 0;
+    for (size_t i = 0; i < num_blocks; ++i) {
+      max_rows = std::max(max_rows, src_rows_[i + 1] - src_rows_[i]);
+    }
+    scratch_size = I420Size(crop_width_, max_rows);
+  }
+
+  int pixels = crop_width_ * (src_rows_.back() - src_rows_.front());
+  int stripes = std::min(static_cast<int>(stripes_.size()),
+                         std::max(pixels / kMinStripePixels, 1));
+  stripes = std::min(stripes, static_cast<int>(num_blocks));
+  for (int i = 0; i < stripes; ++i) {
+    Stripe* stripe = &stripes_[i];
+    stripe->first_block = num_blocks * i / stripes;
+    stripe->end_block = num_blocks * (i + 1) / stripes;
+    stripe->convert_time_ns = 0;
+    stripe->scale_time_ns = 0;
+    stripe->ok = true;
+    if (stripe->scratch.size() < scratch_size) {
+      stripe->scratch.resize(scratch_size);
+    }
+  }
+
+  if (stripes > 1) {
+    StartWorkers();
+    {
+      talk_base::CritScope cs(&crit_);
+      pending_stripes_ = stripes - 1;
+    }
+    for (int i = 1; i < stripes; ++i) {
+      workers_[i - 1]->Post(this, MSG_CONVERT_STRIPE,
+                            new StripeMessageData(i));
+    }
+  }
+  ConvertStripe(&stripes_[0]);
+  if (stripes > 1) {
+    stripes_done_.Wait(talk_base::kForever);
+  }
+
+  bool ok = true;
+  for (int i = 0; i < stripes; ++i) {
+    *convert_time_ns += stripes_[i].convert_time_ns;
+    *scale_time_ns += stripes_[i].scale_time_ns;
+    ok = ok && stripes_[i].ok;
+  }
+  *num_stripes = stripes;
+  return ok;
+}
+
+void FrameConverter::ConvertStripe(Stripe* stripe) {
+  for (size_t i = stripe->first_block; i < stripe->end_block; ++i) {
+    if (!ConvertBlock(stripe, i)) {
+      stripe->ok = false;
+      return;
+    }
+  }
+}
+
+bool FrameConverter::ConvertBlock(Stripe* stripe, size_t block) {
+#ifdef HAVE_YUV
+  int dst_row = dst_rows_[block];
+  int dst_rows = dst_rows_[block + 1] - dst_row;
+  int src_row = src_rows_[block];
+  int src_rows = src_rows_[block + 1] - src_row;
+  uint8* dst_y = dst_y_ + dst_row * dst_y_pitch_;
+  uint8* dst_u = dst_u_ + dst_row / 2 * dst_u_pitch_;
+  uint8* dst_v = dst_v_ + dst_row / 2 * dst_v_pitch_;
+
+  uint64 start = talk_base::SystemTimeNanos();
+  if (crop_width_ == dst_width_ && src_row == dst_row &&
+      src_rows == dst_rows) {
+    // Same size; convert straight into the output.
+    int r = libyuv::ConvertToI420(sample_, sample_size_,
+                                  dst_y, dst_y_pitch_,
+                                  dst_u, dst_u_pitch_,
+                                  dst_v, dst_v_pitch_,
+                                  crop_x_, crop_y_ + src_row,
+                                  src_width_, src_height_,
+                                  crop_width_, src_rows,
+                                  libyuv::kRotate0, fourcc_);
+    stripe->convert_time_ns += talk_base::SystemTimeNanos() - start;
+    return r == 0;
+  }
+
+  int half_width = (crop_width_ + 1) / 2;
+  uint8* y = &stripe->scratch[0];
+  uint8* u = y + crop_width_ * src_rows;
+  uint8* v = u + half_width * ((src_rows + 1) / 2);
+  int r = libyuv::ConvertToI420(sample_, sample_size_,
+                                y, crop_width_,
+                                u, half_width,
+                                v, half_width,
+                                crop_x_, crop_y_ + src_row,
+                                src_width_, src_height_,
+                                crop_width_, src_rows,
+                                libyuv::kRotate0, fourcc_);
+  uint64 converted = talk_base::SystemTimeNanos();
+  stripe->convert_time_ns += converted - start;
+  if (r) {
+    return false;
+  }
+  r = libyuv::I420Scale(y, crop_width_, u, half_width, v, half_width,
+                        crop_width_, src_rows,
+                        dst_y, dst_y_pitch_,
+                        dst_u, dst_u_pitch_,
+                        dst_v, dst_v_pitch_,
+                        dst_width_, dst_rows,
+                        libyuv::kFilterBox);
+  stripe->scale_time_ns += talk_base::SystemTimeNanos() - converted;
+  return r == 0;
+#else
+  return false;
+#endif
+}
+
+bool FrameConverter::ConvertWhole(int crop_height, int rotation,
+                                  int64* convert_time_ns,
+                                  int64* scale_time_ns) {
+#ifdef HAVE_YUV
+  // Conversion functions expect negative height to flip the image.
+  int signed_crop_height = (src_height_ < 0) ? -crop_height : crop_height;
+  int converted_width = crop_width_;
+  int converted_height = crop_height;
+  if (rotation == 90 || rotation == 270) {
+    std::swap(converted_width, converted_height);
+  }
+  libyuv::RotationMode mode = static_cast<libyuv::RotationMode>(rotation);
+
+  uint64 start = talk_base::SystemTimeNanos();
+  if (converted_width == dst_width_ && converted_height == dst_height_) {
+    int r = libyuv::ConvertToI420(sample_, sample_size_,
+                                  dst_y_, dst_y_pitch_,
+                                  dst_u_, dst_u_pitch_,
+                                  dst_v_, dst_v_pitch_,
+                                  crop_x_, crop_y_,
+                                  src_width_, src_height_,
+                                  crop_width_, signed_crop_height,
+                                  mode, fourcc_);
+    *convert_time_ns += talk_base::SystemTimeNanos() - start;
+    return r == 0;
+  }
+
+  size_t scratch_size = I420Size(converted_width, converted_height);
+  if (whole_scratch_.size() < scratch_size) {
+    whole_scratch_.resize(scratch_size);
+  }
+  int half_width = (converted_width + 1) / 2;
+  uint8* y = &whole_scratch_[0];
+  uint8* u = y + converted_width * converted_height;
+  uint8* v = u + half_width * ((converted_height + 1) / 2);
+  int r = libyuv::ConvertToI420(sample_, sample_size_,
+                                y, converted_width,
+                                u, half_width,
+                                v, half_width,
+                                crop_x_, crop_y_,
+                                src_width_, src_height_,
+                                crop_width_, signed_crop_height,
+                                mode, fourcc_);
+  uint64 converted = talk_base::SystemTimeNanos();
+  *convert_time_ns += converted - start;
+  if (r) {
+    return false;
+  }
+  r = libyuv::I420Scale(y, converted_width, u, half_width, v, half_width,
+                        converted_width, converted_height,
+                        dst_y_, dst_y_pitch_,
+                        dst_u_, dst_u_pitch_,
+                        dst_v_, dst_v_pitch_,
+                        dst_width_, dst_height_,
+                        libyuv::kFilterBox);
+  *scale_time_ns += talk_base::SystemTimeNanos() - converted;
+  return r == 0;
+#else
+  return false;
+#endif
+}
+
+void FrameConverter::StartWorkers() {
+  while (workers_.size() < static_cast<size_t>(num_workers_)) {
+    talk_base::Thread* worker = new talk_base::Thread();
+    worker->SetName("FrameConverter", this);
+    worker->Start();
+    workers_.push_back(worker);
+  }
+}
+
+void FrameConverter::OnMessage(talk_base::Message* msg) {
+  ASSERT(msg->message_id == MSG_CONVERT_STRIPE);
+  talk_base::scoped_ptr<StripeMessageData> data(
+      static_cast<StripeMessageData*>(msg->pdata));
+  ConvertStripe(&stripes_[data->data()]);
+  talk_base::CritScope cs(&crit_);
+  if (--pending_stripes_ == 0) {
+    stripes_done_.Set();
+  }
+}
+
+}  // namespace cricket
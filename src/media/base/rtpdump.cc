@@ -28,6 +28,7 @@
 #include "media/base/rtpdump.h"
 
 #include <ctype.h>
+#include <string.h>
 
 #include <string>
 
@@ -39,6 +40,21 @@
 namespace {
 static const int kRtpSsrcOffset = 8;
 const int  kWarnSlowWritesDelayMs = 50;
+
+// Check if |first_line| matches "#!rtpplay1.0 address/port".
+bool IsRtpDumpFirstLine(const std::string& first_line) {
+  bool matched = (0 == first_line.find("#!rtpplay1.0 "));
+
+  // The address could be IP or hostname. We do not check it here. Instead, we
+  // check the port at the end.
+  size_t pos = first_line.find('/');
+  matched &= (pos != std::string::npos && pos < first_line.size() - 1);
+  for (++pos; pos < first_line.size() && matched; ++pos) {
+    matched &= (0 != isdigit(first_line[pos]));
+  }
+
+  return matched;
+}
 }  // namespace
 
 namespace cricket {
@@ -103,6 +119,14 @@ bool RtpDumpPacket::GetRtcpType(int* type) const {
       cricket::GetRtcpType(&data[0], data.size(), type);
 }
 
+bool RtpDumpPacketView::IsValidRtpPacket() const {
+  return original_data_len >= size && size >= kMinRtpPacketLen;
+}
+
+bool RtpDumpPacketView::IsValidRtcpPacket() const {
+  return original_data_len == 0 && size >= kMinRtcpPacketLen;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of RtpDumpReader.
 ///////////////////////////////////////////////////////////////////////////
@@ -187,18 +211,95 @@ talk_base::StreamResult RtpDumpReader::ReadFileHeader() {
 }
 
 bool RtpDumpReader::CheckFirstLine(const std::string& first_line) {
-  // The first line is like "#!rtpplay1.0 address/port"
-  bool matched = (0 == first_line.find("#!rtpplay1.0 "));
+  return IsRtpDumpFirstLine(first_line);
+}
 
-  // The address could be IP or hostname. We do not check it here. Instead, we
-  // check the port at the end.
-  size_t pos = first_line.find('/');
-  matched &= (pos != std::string::npos && pos < first_line.size() - 1);
-  for (++pos; pos < first_line.size() && matched; ++pos) {
-    matched &= (0 != isdigit(first_line[pos]));
+///////////////////////////////////////////////////////////////////////////
+// Implementation of RtpDumpMappedReader.
+///////////////////////////////////////////////////////////////////////////
+RtpDumpMappedReader::RtpDumpMappedReader()
+    : data_(NULL),
+      size_(0),
+      first_packet_pos_(0),
+      pos_(0),
+      start_time_ms_(0) {
+}
+
+bool RtpDumpMappedReader::Open(const std::string& filename) {
+  Close();
+  if (!file_.Open(filename)) {
+    return false;
+  }
+  data_ = file_.data();
+  size_ = file_.size();
+  if (!ReadFileHeader()) {
+    LOG(LS_WARNING) << filename << " is not an rtpdump file";
+    Close();
+    return false;
   }
+  return true;
+}
 
-  return matched;
+bool RtpDumpMappedReader::Init(const void* data, size_t size) {
+  Close();
+  data_ = static_cast<const uint8*>(data);
+  size_ = size;
+  if (!ReadFileHeader()) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void RtpDumpMappedReader::Close() {
+  file_.Close();
+  data_ = NULL;
+  size_ = 0;
+  first_packet_pos_ = 0;
+  pos_ = 0;
+  start_time_ms_ = 0;
+}
+
+talk_base::StreamResult RtpDumpMappedReader::ReadPacket(
+    RtpDumpPacketView* packet) {
+  if (!packet || !data_) return talk_base::SR_ERROR;
+  if (pos_ == size_) return talk_base::SR_EOS;
+  if (size_ - pos_ < RtpDumpPacket::kHeaderLength) {
+    return talk_base::SR_ERROR;
+  }
+
+  // The record header holds the full record length, the original packet
+  // length and the elapsed time, all in network byte order.
+  const uint8* header = data_ + pos_;
+  size_t dump_packet_len = talk_base::GetBE16(header);
+  if (dump_packet_len < RtpDumpPacket::kHeaderLength ||
+      dump_packet_len > size_ - pos_) {
+    return talk_base::SR_ERROR;
+  }
+  packet->data = header + RtpDumpPacket::kHeaderLength;
+  packet->size = dump_packet_len - RtpDumpPacket::kHeaderLength;
+  packet->original_data_len = talk_base::GetBE16(header + 2);
+  packet->elapsed_time = talk_base::GetBE32(header + 4);
+  pos_ += dump_packet_len;
+  return talk_base::SR_SUCCESS;
+}
+
+bool RtpDumpMappedReader::ReadFileHeader() {
+  if (!data_) return false;
+  const uint8* end = static_cast<const uint8*>(memchr(data_, '\n', size_));
+  if (!end) return false;
+  size_t first_line_len = end - data_;
+  std::string first_line(reinterpret_cast<const char*>(data_), first_line_len);
+  if (!IsRtpDumpFirstLine(first_line)) return false;
+
+  size_t header_pos = first_line_len + 1;
+  if (size_ - header_pos < RtpDumpFileHeader::kHeaderLength) return false;
+  uint32 start_sec = talk_base::GetBE32(data_ + header_pos);
+  uint32 start_usec = talk_base::GetBE32(data_ + header_pos + 4);
+  start_time_ms_ = start_sec * 1000 + start_usec / 1000;
+  first_packet_pos_ = header_pos + RtpDumpFileHeader::kHeaderLength;
+  pos_ = first_packet_pos_;
+  return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,360 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "media/base/rtpreplay.h"
+
+#include <string.h>
+
+#include "base/byteorder.h"
+#include "base/logging.h"
+#include "base/timeutils.h"
+#include "media/base/rtputils.h"
+
+namespace cricket {
+
+// The wheel covers about one second; streams due further ahead wait in their
+// slot for the following revolutions.
+static const int kWheelSlots = 1024;
+static const int kWheelMask = kWheelSlots - 1;
+static const int kTickUs = 1000;
+// Same default as RtpDumpLoopReader for recordings with a single packet.
+static const uint32 kDefaultTimeIncrease = 30;
+static const size_t kRtcpSsrcOffset = 4;
+
+///////////////////////////////////////////////////////////////////////////
+// Implementation of RtpReplaySource.
+///////////////////////////////////////////////////////////////////////////
+RtpReplaySource::RtpReplaySource()
+    : first_elapsed_time_(0),
+      elapsed_time_increase_(0),
+      rtp_seq_num_increase_(0),
+      rtp_timestamp_increase_(0) {
+}
+
+bool RtpReplaySource::Open(const std::string& filename) {
+  return reader_.Open(filename) && BuildIndex();
+}
+
+bool RtpReplaySource::Init(const void* data, size_t size) {
+  return reader_.Init(data, size) && BuildIndex();
+}
+
+bool RtpReplaySource::BuildIndex() {
+  packets_.clear();
+  RtpDumpPacketView packet;
+  talk_base::StreamResult res;
+  while ((res = reader_.ReadPacket(&packet)) == talk_base::SR_SUCCESS) {
+    packets_.push_back(packet);
+  }
+  if (res != talk_base::SR_EOS) {
+    LOG(LS_WARNING) << "Truncated rtpdump record after " << packets_.size()
+                    << " packets";
+    packets_.clear();
+    return false;
+  }
+  if (packets_.empty()) {
+    return false;
+  }
+
+  // Collect the same statistics as RtpDumpLoopReader does on its first loop.
+  uint32 rtp_packet_count = 0;
+  uint32 frame_count = 0;
+  int first_seq_num = 0, last_seq_num = 0;
+  uint32 first_timestamp = 0, last_timestamp = 0;
+  for (size_t i = 0; i < packets_.size(); ++i) {
+    const RtpDumpPacketView& view = packets_[i];
+    int seq_num;
+    uint32 timestamp;
+    if (!view.IsValidRtpPacket() ||
+        !GetRtpSeqNum(view.data, view.size, &seq_num) ||
+        !GetRtpTimestamp(view.data, view.size, &timestamp)) {
+      continue;
+    }
+    if (0 == rtp_packet_count++) {
+      first_seq_num = seq_num;
+      first_timestamp = timestamp;
+      ++frame_count;
+    } else if (timestamp != last_timestamp) {
+      ++frame_count;
+    }
+    last_seq_num = seq_num;
+    last_timestamp = timestamp;
+  }
+
+  uint32 packet_count = static_cast<uint32>(packets_.size());
+  first_elapsed_time_ = packets_.front().elapsed_time;
+  uint32 last_elapsed_time = packets_.back().elapsed_time;
+  // The products overflow 32 bits on long recordings, so scale in 64 bits.
+  elapsed_time_increase_ = packet_count <= 1 ? kDefaultTimeIncrease :
+      static_cast<uint32>(
+          static_cast<uint64>(last_elapsed_time - first_elapsed_time_) *
+          packet_count / (packet_count - 1));
+  // A recording whose packets share one timestamp still needs to advance.
+  if (elapsed_time_increase_ == 0) {
+    elapsed_time_increase_ = kDefaultTimeIncrease;
+  }
+  rtp_seq_num_increase_ = last_seq_num - first_seq_num + 1;
+  rtp_timestamp_increase_ = frame_count <= 1 ? kDefaultTimeIncrease :
+      static_cast<uint32>(
+          static_cast<uint64>(last_timestamp - first_timestamp) *
+          frame_count / (frame_count - 1));
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Implementation of RtpReplayEngine.
+///////////////////////////////////////////////////////////////////////////
+struct RtpReplayEngine::Stream {
+  const RtpReplaySource* source;
+  uint32 ssrc;
+  bool loop;
+  int64 start_tick;
+  // The next packet to send and how many times the recording has wrapped.
+  size_t index;
+  uint32 loop_count;
+  int64 due_tick;
+  // Next stream in the same wheel slot, or -1.
+  int next;
+};
+
+RtpReplayEngine::RtpReplayEngine(RtpReplaySink* sink)
+    : sink_(sink),
+      wheel_(kWheelSlots, -1),
+      current_tick_(0),
+      active_streams_(0),
+      stopping_(false),
+      running_(false),
+      wake_(false, false) {
+}
+
+RtpReplayEngine::~RtpReplayEngine() {
+  Stop();
+}
+
+int RtpReplayEngine::AddStream(const RtpReplaySource* source, uint32 ssrc,
+                               uint32 start_delay_ms, bool loop) {
+  ASSERT(!running());
+  if (!source || source->packet_count() == 0) {
+    LOG(LS_WARNING) << "Cannot replay an empty rtpdump source";
+    return -1;
+  }
+  Stream stream;
+  stream.source = source;
+  stream.ssrc = ssrc;
+  stream.loop = loop;
+  stream.start_tick = current_tick_ + start_delay_ms;
+  stream.index = 0;
+  stream.loop_count = 0;
+  stream.due_tick = stream.start_tick;
+  stream.next = -1;
+  int id = static_cast<int>(streams_.size());
+  streams_.push_back(stream);
+  ++active_streams_;
+  Schedule(id);
+  return id;
+}
+
+bool RtpReplayEngine::Start() {
+  {
+    talk_base::CritScope cs(&crit_);
+    if (running_) return false;
+    running_ = true;
+    stopping_ = false;
+  }
+  thread_.SetName("RtpReplayEngine", this);
+  if (!thread_.Start(this)) {
+    talk_base::CritScope cs(&crit_);
+    running_ = false;
+    return false;
+  }
+  return true;
+}
+
+void RtpReplayEngine::Stop() {
+  {
+    talk_base::CritScope cs(&crit_);
+    stopping_ = true;
+  }
+  wake_.Set();
+  thread_.Stop();
+}
+
+bool RtpReplayEngine::running() const {
+  talk_base::CritScope cs(&crit_);
+  return running_;
+}
+
+void RtpReplayEngine::Run(talk_base::Thread* thread) {
+  uint64 start_ns = talk_base::TimeNanos();
+  for (;;) {
+    ProcessUntil(static_cast<int64>(talk_base::TimeNanos() - start_ns) / 1000);
+    int64 next_us = NextDueUs();
+    {
+      talk_base::CritScope cs(&crit_);
+      if (stopping_ || next_us < 0) {
+        running_ = false;
+        break;
+      }
+    }
+    // Event::Wait() has millisecond resolution; rounding up keeps us from
+    // spinning until the tick arrives, at the cost of up to a tick of
+    // lateness, which shows up in the timing error statistics.
+    int64 now_us = static_cast<int64>(talk_base::TimeNanos() - start_ns) / 1000;
+    if (next_us > now_us) {
+      wake_.Wait(static_cast<int>((next_us - now_us + kTickUs - 1) / kTickUs));
+    }
+  }
+}
+
+void RtpReplayEngine::Schedule(int id) {
+  Stream& stream = streams_[id];
+  int slot = static_cast<int>(stream.due_tick & kWheelMask);
+  stream.next = wheel_[slot];
+  wheel_[slot] = id;
+}
+
+void RtpReplayEngine::ProcessUntil(int64 now_us) {
+  int64 now_tick = now_us / kTickUs;
+  while (current_tick_ <= now_tick) {
+    if (active_streams_ == 0) {
+      current_tick_ = now_tick + 1;
+      break;
+    }
+    int slot = static_cast<int>(current_tick_ & kWheelMask);
+    int id = wheel_[slot];
+    wheel_[slot] = -1;
+    while (id != -1) {
+      Stream* stream = &streams_[id];
+      int next = stream->next;
+      if (stream->due_tick <= current_tick_) {
+        SendDuePackets(stream, id, now_us);
+      } else {
+        // Due on a later revolution of the wheel.
+        stream->next = wheel_[slot];
+        wheel_[slot] = id;
+      }
+      id = next;
+    }
+    ++current_tick_;
+  }
+
+  local_stats_.elapsed_us = now_us;
+  local_stats_.active_streams = active_streams_;
+  talk_base::CritScope cs(&crit_);
+  stats_ = local_stats_;
+}
+
+int64 RtpReplayEngine::NextDueUs() const {
+  if (active_streams_ == 0) {
+    return -1;
+  }
+  // Every active stream sits in some slot, so this finds one within a
+  // revolution. A stream found there may be due on a later revolution, in
+  // which case the caller just wakes up early.
+  for (int i = 0; i < kWheelSlots; ++i) {
+    int64 tick = current_tick_ + i;
+    if (wheel_[tick & kWheelMask] != -1) {
+      return tick * kTickUs;
+    }
+  }
+  ASSERT(false);
+  return current_tick_ * kTickUs;
+}
+
+void RtpReplayEngine::SendDuePackets(Stream* stream, int id, int64 now_us) {
+  const RtpReplaySource* source = stream->source;
+  while (stream->due_tick <= current_tick_) {
+    SendPacket(*stream, id, source->packet(stream->index));
+
+    int64 error_us = now_us - stream->due_tick * kTickUs;
+    if (error_us > 0) {
+      local_stats_.total_timing_error_us += error_us;
+      if (error_us > local_stats_.max_timing_error_us) {
+        local_stats_.max_timing_error_us = error_us;
+      }
+      if (error_us >= kTickUs) {
+        ++local_stats_.late_packets;
+      }
+    }
+
+    if (++stream->index == source->packet_count()) {
+      if (!stream->loop) {
+        --active_streams_;
+        return;
+      }
+      stream->index = 0;
+      ++stream->loop_count;
+    }
+    stream->due_tick = stream->start_tick +
+        (source->packet(stream->index).elapsed_time -
+         source->first_elapsed_time()) +
+        static_cast<int64>(stream->loop_count) *
+            source->elapsed_time_increase();
+  }
+  Schedule(id);
+}
+
+void RtpReplayEngine::SendPacket(const Stream& stream, int id,
+                                 const RtpDumpPacketView& packet) {
+  const void* data = packet.data;
+  if (packet.IsValidRtpPacket() || packet.IsValidRtcpPacket()) {
+    // Only the header changes, but the recording is shared and read-only, so
+    // the packet is assembled in a scratch buffer.
+    if (scratch_.size() < packet.size) {
+      scratch_.resize(packet.size);
+    }
+    uint8* buf = &scratch_[0];
+    memcpy(buf, packet.data, packet.size);
+    if (packet.is_rtcp()) {
+      talk_base::SetBE32(buf + kRtcpSsrcOffset, stream.ssrc);
+    } else {
+      SetRtpSsrc(buf, packet.size, stream.ssrc);
+      if (stream.loop_count > 0) {
+        const RtpReplaySource* source = stream.source;
+        int seq_num = 0;
+        uint32 timestamp = 0;
+        GetRtpSeqNum(buf, packet.size, &seq_num);
+        GetRtpTimestamp(buf, packet.size, &timestamp);
+        SetRtpSeqNum(buf, packet.size, (seq_num + stream.loop_count *
+            source->rtp_seq_num_increase()) & 0xFFFF);
+        SetRtpTimestamp(buf, packet.size, timestamp + stream.loop_count *
+            source->rtp_timestamp_increase());
+      }
+    }
+    data = buf;
+  }
+  sink_->OnReplayPacket(id, data, packet.size, packet.is_rtcp());
+  ++local_stats_.packets_sent;
+  local_stats_.bytes_sent += packet.size;
+}
+
+RtpReplayStats RtpReplayEngine::GetStats() const {
+  talk_base::CritScope cs(&crit_);
+  return stats_;
+}
+
+}  // namespace cricket
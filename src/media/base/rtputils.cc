@@ -36,6 +36,7 @@ static const size_t kRtpSeqNumOffset = 2;
 static const size_t kRtpTimestampOffset = 4;
 static const size_t kRtpSsrcOffset = 8;
 static const size_t kRtcpPayloadTypeOffset = 1;
+static const int kRtpOneByteExtensionProfile = 0xBEDE;
 
 bool GetUint8(const void* data, size_t offset, int* value) {
   if (!data || !value) {
@@ -149,6 +150,56 @@ bool GetRtpHeader(const void* data, size_t len, RtpHeader* header) {
           GetRtpSsrc(data, len, &(header->ssrc)));
 }
 
+bool GetRtpHeaderExtension(const void* data, size_t len, int id,
+                           const uint8** value, size_t* value_len) {
+  if (!data || len < kMinRtpPacketLen || !value || !value_len) return false;
+  // Ids 0 and 15 are reserved by RFC 5285.
+  if (id <= 0 || id >= 15) return false;
+  const uint8* header = static_cast<const uint8*>(data);
+  if (!(header[0] & 0x10)) return false;
+  size_t pos = kMinRtpPacketLen + (header[0] & 0xF) * sizeof(uint32);
+  if (len < pos + sizeof(uint32)) return false;
+  if (talk_base::GetBE16(header + pos) != kRtpOneByteExtensionProfile) {
+    return false;
+  }
+  size_t end = pos + sizeof(uint32) +
+      talk_base::GetBE16(header + pos + 2) * sizeof(uint32);
+  if (len < end) return false;
+  pos += sizeof(uint32);
+  while (pos < end) {
+    // Zero bytes are padding between elements.
+    if (header[pos] == 0) {
+      ++pos;
+      continue;
+    }
+    int element_id = header[pos] >> 4;
+    // Id 15 ends processing of the extension block.
+    if (element_id == 15) return false;
+    size_t element_len = (header[pos] & 0xF) + 1;
+    if (pos + 1 + element_len > end) return false;
+    if (element_id == id) {
+      *value = header + pos + 1;
+      *value_len = element_len;
+      return true;
+    }
+    pos += 1 + element_len;
+  }
+  return false;
+}
+
+bool GetRtpAudioLevel(const void* data, size_t len, int id,
+                      int* level, bool* voice) {
+  if (!level || !voice) return false;
+  const uint8* value;
+  size_t value_len;
+  if (!GetRtpHeaderExtension(data, len, id, &value, &value_len)) {
+    return false;
+  }
+  *voice = (value[0] & 0x80) != 0;
+  *level = value[0] & 0x7F;
+  return true;
+}
+
 bool GetRtcpType(const void* data, size_t len, int* value) {
   if (len < kMinRtcpPacketLen) {
     return false;
@@ -0,0 +1,104 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "media/base/scaledframecache.h"
+
+#include "base/logging.h"
+#include "media/base/videoframe.h"
+
+namespace cricket {
+
+ScaledFrameCache::ScaledFrameCache()
+    : source_(NULL),
+      source_elapsed_time_(0),
+      source_time_stamp_(0),
+      scale_count_(0),
+      hit_count_(0) {
+}
+
+ScaledFrameCache::~ScaledFrameCache() {
+  Clear();
+}
+
+const VideoFrame* ScaledFrameCache::GetScaledFrame(const VideoFrame* frame,
+                                                   size_t width,
+                                                   size_t height) {
+  if (!frame || !width || !height) {
+    return NULL;
+  }
+  if (frame->GetWidth() == width && frame->GetHeight() == height) {
+    return frame;
+  }
+
+  talk_base::CritScope cs(&crit_);
+  if (frame != source_ ||
+      frame->GetElapsedTime() != source_elapsed_time_ ||
+      frame->GetTimeStamp() != source_time_stamp_) {
+    // A new frame; the scaled copies of the previous one are stale.
+    Clear();
+    source_ = frame;
+    source_elapsed_time_ = frame->GetElapsedTime();
+    source_time_stamp_ = frame->GetTimeStamp();
+  }
+  for (ScaledFrames::const_iterator it = scaled_frames_.begin();
+       it != scaled_frames_.end(); ++it) {
+    if ((*it)->GetWidth() == width && (*it)->GetHeight() == height) {
+      ++hit_count_;
+      return *it;
+    }
+  }
+
+  VideoFrame* scaled = frame->Stretch(width, height, true, true);
+  if (!scaled) {
+    LOG(LS_WARNING) << "Failed to scale frame to " << width << "x" << height;
+    return NULL;
+  }
+  scaled_frames_.push_back(scaled);
+  ++scale_count_;
+  return scaled;
+}
+
+int ScaledFrameCache::scale_count() const {
+  talk_base::CritScope cs(&crit_);
+  return scale_count_;
+}
+
+int ScaledFrameCache::hit_count() const {
+  talk_base::CritScope cs(&crit_);
+  return hit_count_;
+}
+
+void ScaledFrameCache::Clear() {
+  for (ScaledFrames::iterator it = scaled_frames_.begin();
+       it != scaled_frames_.end(); ++it) {
+    delete *it;
+  }
+  scaled_frames_.clear();
+  source_ = NULL;
+}
+
+}  // namespace cricket
@@ -29,9 +29,6 @@
 
 #include <algorithm>
 
-#if defined(HAVE_YUV)
-#include "libyuv/scale_argb.h"
-#endif
 #include "base/logging.h"
 #include "media/base/videoprocessor.h"
 
@@ -88,6 +85,7 @@ void VideoCapturer::Construct() {
   ClearAspectRatio();
   enable_camera_list_ = false;
   capture_state_ = CS_STOPPED;
+  SetConversionThreads(-1);
   SignalFrameCaptured.connect(this, &VideoCapturer::OnFrameCaptured);
 }
 
@@ -183,6 +181,13 @@ bool VideoCapturer::RemoveVideoProcessor(VideoProcessor* video_processor) {
   return true;
 }
 
+void VideoCapturer::SetConversionThreads(int threads) {
+  if (threads < 0) {
+    threads = FrameConverter::DefaultNumWorkers();
+  }
+  converter_.reset(new FrameConverter(threads));
+}
+
 void VideoCapturer::ConstrainSupportedFormats(const VideoFormat& max_format) {
   max_format_.reset(new VideoFormat(max_format));
   UpdateFilteredSupportedFormats();
@@ -213,33 +218,6 @@ void VideoCapturer::OnFrameCaptured(VideoCapturer*,
 #define VIDEO_FRAME_NAME WebRtcVideoFrame
 #endif
 #if defined(VIDEO_FRAME_NAME)
-#if defined(HAVE_YUV)
-  if (IsScreencast()) {
-    int scaled_width, scaled_height;
-    ComputeScale(captured_frame->width, captured_frame->height,
-                 &scaled_width, &scaled_height);
-    if (FOURCC_ARGB == captured_frame->fourcc &&
-        (scaled_width != captured_frame->height ||
-         scaled_height != captured_frame->height)) {
-      CapturedFrame* scaled_frame = const_cast<CapturedFrame*>(captured_frame);
-      // Compute new width such that width * height is less than maximum but
-      // maintains original captured frame aspect ratio.
-      // Round down width to multiple of 4 so odd width won't round up beyond
-      // maximum, and so chroma channel is even width to simplify spatial
-      // resampling.
-      libyuv::ARGBScale(reinterpret_cast<const uint8*>(captured_frame->data),
-                        captured_frame->width * 4, captured_frame->width,
-                        captured_frame->height,
-                        reinterpret_cast<uint8*>(scaled_frame->data),
-                        scaled_width * 4,
-                        scaled_width, scaled_height,
-                        libyuv::kFilterBilinear);
-      scaled_frame->width = scaled_width;
-      scaled_frame->height = scaled_height;
-      scaled_frame->data_size = scaled_width * 4 * scaled_height;
-    }
-  }
-#endif  // HAVE_YUV
   // Size to crop captured frame to.  This adjusts the captured frames
   // aspect ratio to match the final view aspect ratio, considering pixel
   // aspect ratio and rotation.  The final size may be scaled down by video
@@ -247,7 +225,7 @@ void VideoCapturer::OnFrameCaptured(VideoCapturer*,
   // Note that abs() of frame height is passed in, because source may be
   // inverted, but output will be positive.
   int desired_width = captured_frame->width;
-  int desired_height = captured_frame->height;
+  int desired_height = abs(captured_frame->height);
   if (!IsScreencast()) {
     ComputeCrop(ratio_w_, ratio_h_,
                 captured_frame->width, abs(captured_frame->height),
@@ -255,12 +233,26 @@ void VideoCapturer::OnFrameCaptured(VideoCapturer*,
                 captured_frame->rotation, &desired_width, &desired_height);
   }
 
+  // Size to scale the cropped frame to, after rotation. Screencasts are
+  // limited to what the encoder accepts. Cropping, conversion and scaling
+  // are then done in one pass.
+  int scaled_width = desired_width;
+  int scaled_height = desired_height;
+  if (captured_frame->rotation == 90 || captured_frame->rotation == 270) {
+    std::swap(scaled_width, scaled_height);
+  }
+  if (IsScreencast()) {
+    ComputeScale(scaled_width, scaled_height, &scaled_width, &scaled_height);
+  }
+
   VIDEO_FRAME_NAME i420_frame;
-  if (!i420_frame.Init(captured_frame, desired_width, desired_height)) {
+  if (!i420_frame.Init(captured_frame, desired_width, desired_height,
+                       scaled_width, scaled_height, converter_.get())) {
     // TODO(fbarchard): LOG more information about captured frame attributes.
     LOG(LS_ERROR) << "Couldn't convert to I420! "
                   << "From " << ToString(captured_frame)
-                  << " To " << desired_width << " x " << desired_height;
+                  << " To " << desired_width << " x " << desired_height
+                  << " scaled to " << scaled_width << " x " << scaled_height;
     return;
   }
   if (!ApplyProcessors(&i420_frame)) {
@@ -77,6 +77,10 @@ static const char kFecPayloadName[] = "ulpfec";
 
 static const int kDefaultNumberOfTemporalLayers = 1;  // 1:1
 
+// Streams sent with an SSRC group of SIM semantics are encoded once per SSRC,
+// each layer with half the width and height of the one before it.
+static const int kMaxSimulcastLayers = 3;
+
 static void LogMultiline(talk_base::LoggingSeverity sev, char* text) {
   const char* delim = "\r\n";
   // TODO(fbarchard): Fix strtok lint warning.
@@ -328,6 +332,8 @@ class WebRtcVideoChannelSendInfo  {
         capture_id_(capture_id),
         sending_(false),
         muted_(false),
+        simulcast_layer_(0),
+        num_simulcast_layers_(1),
         video_capturer_(NULL),
         encoder_observer_(channel_id),
         external_capture_(external_capture),
@@ -347,6 +353,14 @@ class WebRtcVideoChannelSendInfo  {
   bool sending() const { return sending_; }
   void set_muted(bool on) { muted_ = on; }
   bool muted() {return muted_; }
+  // Layer 0 is the full resolution stream, the one whose StreamParams carry
+  // the SIM group. Streams without simulcast have a single layer.
+  int simulcast_layer() const { return simulcast_layer_; }
+  int num_simulcast_layers() const { return num_simulcast_layers_; }
+  void set_simulcast_layer(int layer, int num_layers) {
+    simulcast_layer_ = layer;
+    num_simulcast_layers_ = num_layers;
+  }
 
   WebRtcEncoderObserver* encoder_observer() { return &encoder_observer_; }
   webrtc::ViEExternalCapture* external_capture() { return external_capture_; }
@@ -457,6 +471,8 @@ class WebRtcVideoChannelSendInfo  {
   int capture_id_;
   bool sending_;
   bool muted_;
+  int simulcast_layer_;
+  int num_simulcast_layers_;
   VideoCapturer* video_capturer_;
   WebRtcEncoderObserver encoder_observer_;
   webrtc::ViEExternalCapture* external_capture_;
@@ -530,6 +546,51 @@ static void UpdateVideoCodec(const cricket::VideoFormat& video_format,
       video_format.interval);
 }
 
+// Shares |bitrate| between |num_layers| simulcast layers in proportion to
+// their pixel counts.
+static unsigned int GetSimulcastLayerBitrate(unsigned int bitrate, int layer,
+                                             int num_layers) {
+  unsigned int total_weight = 0;
+  for (int i = 0; i < num_layers; ++i) {
+    total_weight += 1 << (2 * i);
+  }
+  const unsigned int weight = 1 << (2 * (num_layers - 1 - layer));
+  return bitrate * weight / total_weight;
+}
+
+// Turns the codec of a full resolution stream into the codec of simulcast
+// layer |layer|. Every layer keeps the minimum bitrate so the bitrate
+// controller of the channel group never starves one; the estimate above the
+// minimums is spread over the layers up to their share of the maximum.
+static void UpdateSimulcastCodec(int layer, int num_layers,
+                                 webrtc::VideoCodec* target_codec) {
+  if (num_layers <= 1) {
+    return;
+  }
+  target_codec->width = (target_codec->width >> layer) & ~1;
+  target_codec->height = (target_codec->height >> layer) & ~1;
+  target_codec->maxBitrate = talk_base::_max(
+      target_codec->minBitrate,
+      GetSimulcastLayerBitrate(target_codec->maxBitrate, layer, num_layers));
+  target_codec->startBitrate = talk_base::_max(
+      target_codec->minBitrate,
+      GetSimulcastLayerBitrate(target_codec->startBitrate, layer,
+                               num_layers));
+}
+
+static webrtc::VideoCodecComplexity GetVp8Complexity(int preset) {
+  switch (preset) {
+    case VIDEO_PRESET_FAST:
+      return webrtc::kComplexityHigh;
+    case VIDEO_PRESET_QUALITY:
+      return webrtc::kComplexityHigher;
+    case VIDEO_PRESET_BEST_QUALITY:
+      return webrtc::kComplexityMax;
+    default:
+      return webrtc::kComplexityNormal;
+  }
+}
+
 WebRtcVideoEngine::WebRtcVideoEngine() {
   Construct(new ViEWrapper(), new ViETraceWrapper(), NULL);
 }
@@ -1349,6 +1410,17 @@ bool WebRtcVideoMediaChannel::SetSendStreamFormat(uint32 ssrc,
     send_channel->set_video_format(old_format);
     return false;
   }
+  // Simulcast layers are derived from the format of the full resolution
+  // stream.
+  std::vector<WebRtcVideoChannelSendInfo*> layers;
+  GetSimulcastLayerChannels(send_channel, &layers);
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i]->set_video_format(format);
+    if (!SetSendCodec(layers[i], *send_codec_.get(), send_min_bitrate_,
+                      send_start_bitrate_, send_max_bitrate_)) {
+      return false;
+    }
+  }
   LogSendCodecChange("SetSendStreamFormat()");
   return true;
 }
@@ -1415,12 +1487,19 @@ bool WebRtcVideoMediaChannel::SetSend(bool send) {
 bool WebRtcVideoMediaChannel::AddSendStream(const StreamParams& sp) {
   LOG(LS_INFO) << "AddSendStream " << sp.ToString();
 
-  if (!IsOneSsrcStream(sp)) {
+  const bool simulcast = IsSimulcastStream(sp);
+  if (!IsOneSsrcStream(sp) && !simulcast) {
       LOG(LS_ERROR) << "AddSendStream: bad local stream parameters";
       return false;
   }
 
   uint32 ssrc_key;
+  for (size_t i = 1; i < sp.ssrcs.size(); ++i) {
+    if (GetSendChannelKey(sp.ssrcs[i], &ssrc_key)) {
+      LOG(LS_ERROR) << "Trying to register duplicate ssrc: " << sp.ssrcs[i];
+      return false;
+    }
+  }
   if (!CreateSendChannelKey(sp.first_ssrc(), &ssrc_key)) {
     LOG(LS_ERROR) << "Trying to register duplicate ssrc: " << sp.first_ssrc();
     return false;
@@ -1471,7 +1550,14 @@ bool WebRtcVideoMediaChannel::AddSendStream(const StreamParams& sp) {
     }
   }
 
+  // The layers are added before |sp| is set since the SSRCs in it would
+  // otherwise already count as being in use.
+  if (simulcast && !AddSimulcastLayers(send_channel, sp)) {
+    LOG(LS_ERROR) << "AddSendStream: unable to add simulcast layers";
+    return false;
+  }
   send_channel->set_stream_params(sp);
+  send_channel->set_simulcast_layer(0, static_cast<int>(sp.ssrcs.size()));
 
   // Reset send codec after stream parameters changed.
   if (send_codec_) {
@@ -1502,6 +1588,12 @@ bool WebRtcVideoMediaChannel::RemoveSendStream(uint32 ssrc) {
     // there is no stream to remove.
     return false;
   }
+  if (send_channel->simulcast_layer() != 0) {
+    LOG(LS_WARNING) << "Simulcast layer " << ssrc << " can only be removed "
+                    << "together with its stream.";
+    return false;
+  }
+  RemoveSimulcastLayers(send_channel);
   if (sending_) {
     StopSend(send_channel);
   }
@@ -1723,6 +1815,131 @@ bool WebRtcVideoMediaChannel::IsOneSsrcStream(const StreamParams& sp) {
   return (sp.ssrcs.size() == 1 && sp.ssrc_groups.size() == 0);
 }
 
+bool WebRtcVideoMediaChannel::IsSimulcastStream(const StreamParams& sp) {
+  if (sp.ssrc_groups.size() != 1 || sp.ssrcs.size() < 2 ||
+      sp.ssrcs.size() > static_cast<size_t>(kMaxSimulcastLayers)) {
+    return false;
+  }
+  const SsrcGroup* group = sp.get_ssrc_group(kSimSsrcGroupSemantics);
+  return group != NULL && group->ssrcs == sp.ssrcs;
+}
+
+bool WebRtcVideoMediaChannel::AddSimulcastLayers(
+    WebRtcVideoChannelSendInfo* send_channel, const StreamParams& sp) {
+  const int num_layers = static_cast<int>(sp.ssrcs.size());
+  int layer = 1;
+  while (layer < num_layers && AddSimulcastLayer(send_channel, sp, layer)) {
+    ++layer;
+  }
+  if (layer == num_layers) {
+    return true;
+  }
+  // |sp| is not set on |send_channel| yet, so RemoveSimulcastLayers() would
+  // not find the layers created so far; delete them here.
+  for (; layer >= 1; --layer) {
+    SendChannelMap::iterator iter = send_channels_.find(sp.ssrcs[layer]);
+    if (iter == send_channels_.end()) {
+      continue;
+    }
+    if (sending_) {
+      StopSend(iter->second);
+    }
+    iter->second->set_video_capturer(NULL);
+    DeleteSendChannel(sp.ssrcs[layer]);
+  }
+  return false;
+}
+
+bool WebRtcVideoMediaChannel::AddSimulcastLayer(
+    WebRtcVideoChannelSendInfo* send_channel, const StreamParams& sp,
+    int layer) {
+  const int num_layers = static_cast<int>(sp.ssrcs.size());
+  const uint32 ssrc = sp.ssrcs[layer];
+  // The SSRC is used as key directly; the default channel is never free
+  // here since it carries the full resolution stream or another stream.
+  int channel_id = -1;
+  if (!CreateChannel(ssrc, MD_SEND, &channel_id)) {
+    return false;
+  }
+  WebRtcVideoChannelSendInfo* layer_channel = send_channels_[ssrc];
+  if (engine()->vie()->rtp()->SetLocalSSRC(channel_id, ssrc) != 0) {
+    LOG_RTCERR2(SetLocalSSRC, channel_id, ssrc);
+    return false;
+  }
+  if (engine()->vie()->rtp()->SetRTCPCName(channel_id,
+                                           sp.cname.c_str()) != 0) {
+    LOG_RTCERR2(SetRTCPCName, channel_id, sp.cname.c_str());
+    return false;
+  }
+  StreamParams layer_sp;
+  layer_sp.name = sp.name;
+  layer_sp.cname = sp.cname;
+  layer_sp.sync_label = sp.sync_label;
+  layer_sp.ssrcs.push_back(ssrc);
+  layer_channel->set_stream_params(layer_sp);
+  layer_channel->set_simulcast_layer(layer, num_layers);
+  layer_channel->set_video_format(send_channel->video_format());
+  layer_channel->set_video_capturer(send_channel->video_capturer());
+  if (send_codec_ &&
+      !SetSendCodec(layer_channel, *send_codec_, send_min_bitrate_,
+                    send_start_bitrate_, send_max_bitrate_)) {
+    return false;
+  }
+  if (sending_ && !StartSend(layer_channel)) {
+    return false;
+  }
+  return true;
+}
+
+void WebRtcVideoMediaChannel::RemoveSimulcastLayers(
+    WebRtcVideoChannelSendInfo* send_channel) {
+  std::vector<WebRtcVideoChannelSendInfo*> layers;
+  GetSimulcastLayerChannels(send_channel, &layers);
+  for (size_t i = 0; i < layers.size(); ++i) {
+    if (sending_) {
+      StopSend(layers[i]);
+    }
+    // The capturer is shared with the full resolution stream and must stay
+    // connected to this channel.
+    layers[i]->set_video_capturer(NULL);
+    DeleteSendChannel(layers[i]->stream_params()->first_ssrc());
+  }
+}
+
+void WebRtcVideoMediaChannel::GetSimulcastLayerChannels(
+    WebRtcVideoChannelSendInfo* send_channel,
+    std::vector<WebRtcVideoChannelSendInfo*>* layers) {
+  const StreamParams* sp = send_channel->stream_params();
+  if (!sp || send_channel->num_simulcast_layers() <= 1 ||
+      send_channel->simulcast_layer() != 0) {
+    return;
+  }
+  for (size_t i = 1; i < sp->ssrcs.size(); ++i) {
+    SendChannelMap::iterator iter = send_channels_.find(sp->ssrcs[i]);
+    if (iter != send_channels_.end()) {
+      layers->push_back(iter->second);
+    }
+  }
+}
+
+void WebRtcVideoMediaChannel::SetSimulcastLayerCapturer(
+    WebRtcVideoChannelSendInfo* send_channel, VideoCapturer* capturer) {
+  std::vector<WebRtcVideoChannelSendInfo*> layers;
+  GetSimulcastLayerChannels(send_channel, &layers);
+  for (size_t i = 0; i < layers.size(); ++i) {
+    WebRtcVideoChannelSendInfo* layer_channel = layers[i];
+    // Channels without a capturer take frames from the engine.
+    if (layer_channel->sending()) {
+      if (!layer_channel->video_capturer() && capturer) {
+        engine_->DecrementFrameListeners();
+      } else if (layer_channel->video_capturer() && !capturer) {
+        engine_->IncrementFrameListeners();
+      }
+    }
+    layer_channel->set_video_capturer(capturer);
+  }
+}
+
 bool WebRtcVideoMediaChannel::HasReadySendChannels() {
   return !send_channels_.empty() &&
       ((send_channels_.size() > 1) ||
@@ -1760,18 +1977,6 @@ bool WebRtcVideoMediaChannel::GetSendChannelKey(uint32 local_ssrc,
   return true;
 }
 
-WebRtcVideoChannelSendInfo* WebRtcVideoMediaChannel::GetSendChannel(
-    VideoCapturer* video_capturer) {
-  for (SendChannelMap::iterator iter = send_channels_.begin();
-       iter != send_channels_.end(); ++iter) {
-    WebRtcVideoChannelSendInfo* send_channel = iter->second;
-    if (send_channel->video_capturer() == video_capturer) {
-      return send_channel;
-    }
-  }
-  return NULL;
-}
-
 WebRtcVideoChannelSendInfo* WebRtcVideoMediaChannel::GetSendChannel(
     uint32 local_ssrc) {
   uint32 key;
@@ -1861,6 +2066,7 @@ bool WebRtcVideoMediaChannel::RemoveCapturer(uint32 ssrc) {
   }
   capturer->SignalVideoFrame.disconnect(this);
   send_channel->set_video_capturer(NULL);
+  SetSimulcastLayerCapturer(send_channel, NULL);
   if (send_channel->sending()) {
     engine_->IncrementFrameListeners();
   }
@@ -2098,6 +2304,7 @@ bool WebRtcVideoMediaChannel::SetCapturer(uint32 ssrc,
   }
 
   send_channel->set_video_capturer(capturer);
+  SetSimulcastLayerCapturer(send_channel, capturer);
   capturer->SignalVideoFrame.connect(
       this,
       &WebRtcVideoMediaChannel::SendFrame);
@@ -2180,6 +2387,11 @@ bool WebRtcVideoMediaChannel::MuteStream(uint32 ssrc, bool on) {
     return false;
   }
   send_channel->set_muted(on);
+  std::vector<WebRtcVideoChannelSendInfo*> layers;
+  GetSimulcastLayerChannels(send_channel, &layers);
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i]->set_muted(on);
+  }
   return true;
 }
 
@@ -2297,6 +2509,11 @@ bool WebRtcVideoMediaChannel::SetOptions(const VideoOptions &options) {
   bool denoiser_changed =
       (options_.video_noise_reduction != options.video_noise_reduction);
 
+  bool encoder_changed =
+      (options_.video_encoder_threads != options.video_encoder_threads ||
+       options_.video_token_partitions != options.video_token_partitions ||
+       options_.video_encoder_preset != options.video_encoder_preset);
+
   bool leaky_bucket_changed =
       (options_.video_leaky_bucket != options.video_leaky_bucket);
 
@@ -2312,7 +2529,8 @@ bool WebRtcVideoMediaChannel::SetOptions(const VideoOptions &options) {
       conf_max_bitrate : kMaxVideoBitrate;
 
   if (send_codec_ &&
-      (send_max_bitrate_ != expected_bitrate || denoiser_changed)) {
+      (send_max_bitrate_ != expected_bitrate || denoiser_changed ||
+       encoder_changed)) {
     // On success, SetSendCodec() will reset send_max_bitrate_ to
     // expected_bitrate.
     if (!SetSendCodec(*send_codec_,
@@ -2405,12 +2623,23 @@ bool WebRtcVideoMediaChannel::GetRenderer(uint32 ssrc,
 // TODO(zhurunz): Add unittests to test this function.
 void WebRtcVideoMediaChannel::SendFrame(VideoCapturer* capturer,
                                         const VideoFrame* frame) {
-  // If there's send channel registers to the |capturer|, then only send the
-  // frame to that channel and return. Otherwise send the frame to the default
-  // channel, which currently taking frames from the engine.
-  WebRtcVideoChannelSendInfo* send_channel = GetSendChannel(capturer);
-  if (send_channel) {
-    SendFrame(send_channel, frame, capturer->IsScreencast());
+  // If there are send channels registered to the |capturer|, then only send
+  // the frame to those channels and return. There is one for each simulcast
+  // layer; they scale from the same frame and encode on their own vie capture
+  // threads. Otherwise send the frame to the default channel, which currently
+  // taking frames from the engine.
+  bool sent = false;
+  for (SendChannelMap::iterator iter = send_channels_.begin();
+       iter != send_channels_.end(); ++iter) {
+    WebRtcVideoChannelSendInfo* send_channel = iter->second;
+    if (send_channel->video_capturer() == capturer) {
+      SendFrame(send_channel,
+                GetFrameForSendCodec(send_channel, capturer, frame),
+                capturer->IsScreencast());
+      sent = true;
+    }
+  }
+  if (sent) {
     return;
   }
   // TODO(hellner): Remove below for loop once the captured frame no longer
@@ -2419,7 +2648,9 @@ void WebRtcVideoMediaChannel::SendFrame(VideoCapturer* capturer,
        iter != send_channels_.end(); ++iter) {
     WebRtcVideoChannelSendInfo* send_channel = iter->second;
     if (send_channel->video_capturer() == NULL) {
-      SendFrame(send_channel, frame, capturer->IsScreencast());
+      SendFrame(send_channel,
+                GetFrameForSendCodec(send_channel, capturer, frame),
+                capturer->IsScreencast());
     }
   }
 }
@@ -2830,11 +3061,23 @@ bool WebRtcVideoMediaChannel::SetSendCodec(
     bool enable_denoising =
         options_.video_noise_reduction.GetWithDefaultIfUnset(false);
     target_codec.codecSpecific.VP8.denoisingOn = enable_denoising;
+
+    // Zero lets the encoder scale threads and token partitions with the
+    // number of cores and the frame size.
+    target_codec.codecSpecific.VP8.numberOfThreads =
+        options_.video_encoder_threads.GetWithDefaultIfUnset(0);
+    target_codec.codecSpecific.VP8.numberOfTokenPartitions =
+        options_.video_token_partitions.GetWithDefaultIfUnset(0);
+    target_codec.codecSpecific.VP8.complexity = GetVp8Complexity(
+        options_.video_encoder_preset.GetWithDefaultIfUnset(
+            VIDEO_PRESET_FASTEST));
   }
 
   // Resolution and framerate may vary for different send channels.
   const VideoFormat& video_format = send_channel->video_format();
   UpdateVideoCodec(video_format, &target_codec);
+  UpdateSimulcastCodec(send_channel->simulcast_layer(),
+                       send_channel->num_simulcast_layers(), &target_codec);
 
   if (target_codec.width == 0 && target_codec.height == 0) {
     const uint32 ssrc = send_channel->stream_params()->first_ssrc();
@@ -2919,6 +3162,57 @@ int WebRtcVideoMediaChannel::GetRecvChannelNum(uint32 ssrc) {
   return (it != recv_channels_.end()) ? it->second->channel_id() : -1;
 }
 
+// Channels sending the same capture at the same size share one downscaled
+// frame instead of each having vie scale its own copy.
+const VideoFrame* WebRtcVideoMediaChannel::GetFrameForSendCodec(
+    WebRtcVideoChannelSendInfo* send_channel,
+    VideoCapturer* capturer,
+    const VideoFrame* frame) {
+  if (!send_codec_) {
+    return frame;
+  }
+  const int frame_width = static_cast<int>(frame->GetWidth());
+  const int frame_height = static_cast<int>(frame->GetHeight());
+  int width;
+  int height;
+  if (capturer->IsScreencast()) {
+    // Screencasts are sent at their captured size rather than the codec's,
+    // so each simulcast layer halves the frame itself.
+    const int layer = send_channel->simulcast_layer();
+    if (layer == 0) {
+      return frame;
+    }
+    width = (frame_width >> layer) & ~1;
+    height = (frame_height >> layer) & ~1;
+  } else {
+    webrtc::VideoCodec target_codec = *send_codec_.get();
+    UpdateVideoCodec(send_channel->video_format(), &target_codec);
+    UpdateSimulcastCodec(send_channel->simulcast_layer(),
+                         send_channel->num_simulcast_layers(), &target_codec);
+    if (target_codec.width <= 0 || target_codec.height <= 0 ||
+        frame_width <= 0 || frame_height <= 0 ||
+        (frame_width <= target_codec.width &&
+         frame_height <= target_codec.height)) {
+      return frame;
+    }
+    // Fit the frame into the codec size without changing its aspect ratio.
+    width = target_codec.width;
+    height = frame_height * width / frame_width;
+    if (height > target_codec.height) {
+      height = target_codec.height;
+      width = frame_width * height / frame_height;
+    }
+    width &= ~1;
+    height &= ~1;
+  }
+  if (width <= 0 || height <= 0) {
+    return frame;
+  }
+  const VideoFrame* scaled = capturer->scaled_frames()->GetScaledFrame(
+      frame, width, height);
+  return scaled ? scaled : frame;
+}
+
 // If the new frame size is different from the send codec size we set on vie,
 // we need to reset the send codec on vie.
 // The new send codec size should not exceed send_codec_ which is controlled
@@ -2939,6 +3233,8 @@ bool WebRtcVideoMediaChannel::MaybeResetVieSendCodec(
   webrtc::VideoCodec target_codec = *send_codec_.get();
   const VideoFormat& video_format = send_channel->video_format();
   UpdateVideoCodec(video_format, &target_codec);
+  UpdateSimulcastCodec(send_channel->simulcast_layer(),
+                       send_channel->num_simulcast_layers(), &target_codec);
 
   // Vie send codec size should not exceed target_codec.
   int target_width = new_width;
@@ -31,6 +31,7 @@
 #include "libyuv/convert_from.h"
 #include "libyuv/planar_functions.h"
 #include "base/logging.h"
+#include "media/base/frameconverter.h"
 #include "media/base/videocapturer.h"
 #include "media/base/videocommon.h"
 
@@ -117,6 +118,25 @@ bool WebRtcVideoFrame::Init(const CapturedFrame* frame, int dw, int dh) {
                frame->elapsed_time, frame->time_stamp, frame->rotation);
 }
 
+bool WebRtcVideoFrame::Init(const CapturedFrame* frame, int dw, int dh,
+                            int sw, int sh, FrameConverter* converter) {
+  if (!Validate(frame->fourcc, frame->width, frame->height,
+                static_cast<uint8*>(frame->data), frame->data_size)) {
+    return false;
+  }
+  // Round sizes down to multiple of 4, as Reset() does.
+  dw = (dw > 4) ? (dw & ~3) : dw;
+  dh = (dh > 4) ? (dh & ~3) : dh;
+  sw = (sw > 4) ? (sw & ~3) : sw;
+  sh = (sh > 4) ? (sh & ~3) : sh;
+  InitToEmptyBuffer(sw, sh, frame->pixel_width, frame->pixel_height,
+                    frame->elapsed_time, frame->time_stamp);
+  return converter->Convert(frame, dw, dh,
+                            GetYPlane(), GetYPitch(),
+                            GetUPlane(), GetUPitch(),
+                            GetVPlane(), GetVPitch(), sw, sh);
+}
+
 bool WebRtcVideoFrame::InitToBlack(int w, int h,
                                    size_t pixel_width, size_t pixel_height,
                                    int64 elapsed_time, int64 time_stamp) {
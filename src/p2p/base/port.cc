@@ -266,6 +266,23 @@ void Port::AddAddress(const talk_base::SocketAddress& address,
   }
 }
 
+void Port::SetIceParameters(const std::string& ice_ufrag,
+                            const std::string& ice_pwd) {
+  ice_username_fragment_ = ice_ufrag;
+  password_ = ice_pwd;
+  for (size_t i = 0; i < candidates_.size(); ++i) {
+    Candidate& c = candidates_[i];
+    // The type preference is the top byte of the priority; the component is
+    // part of the rest.
+    uint32 type_preference = c.priority() >> 24;
+    c.set_component(component_);
+    c.set_priority(c.GetPriority(type_preference));
+    c.set_username(username_fragment());
+    c.set_password(password_);
+    c.set_generation(generation_);
+  }
+}
+
 void Port::AddConnection(Connection* conn) {
   connections_[conn->remote_candidate().address()] = conn;
   conn->SignalDestroyed.connect(this, &Port::OnConnectionDestroyed);
@@ -48,6 +48,10 @@ const uint32 USERNAME_LENGTH = 16;
 
 static const uint32 kMessageAcceptConnection = 1;
 
+// Stale entries in the forwarding map are swept once it has grown past this
+// size (and then past twice its size after each sweep).
+static const size_t kMinForwardSweepSize = 1024;
+
 // Calls SendTo on the given socket and logs any bad results.
 void Send(talk_base::AsyncPacketSocket* socket, const char* bytes, size_t size,
           const talk_base::SocketAddress& addr) {
@@ -97,7 +101,8 @@ void SendStunError(const StunMessage& msg, talk_base::AsyncPacketSocket* socket,
 }
 
 RelayServer::RelayServer(talk_base::Thread* thread)
-  : thread_(thread), log_bindings_(true) {
+  : thread_(thread), log_bindings_(true), directory_(NULL),
+    directory_index_(-1), next_forward_sweep_(kMinForwardSweepSize) {
 }
 
 RelayServer::~RelayServer() {
@@ -161,6 +166,20 @@ void RelayServer::RemoveInternalServerSocket(
   socket->SignalReadEvent.disconnect(this);
 }
 
+void RelayServer::SetBindingDirectory(RelayBindingDirectory* directory,
+                                      int index) {
+  ASSERT(bindings_.empty());
+  directory_ = directory;
+  directory_index_ = index;
+}
+
+void RelayServer::HandleForwardedPacket(
+    const char* bytes, size_t size,
+    const talk_base::SocketAddress& remote_addr) {
+  ASSERT(!internal_sockets_.empty());
+  ProcessInternalPacket(internal_sockets_[0], bytes, size, remote_addr, true);
+}
+
 int RelayServer::GetConnectionCount() const {
   return connections_.size();
 }
@@ -195,16 +214,24 @@ void RelayServer::OnReadEvent(talk_base::AsyncSocket* socket) {
 void RelayServer::OnInternalPacket(
     talk_base::AsyncPacketSocket* socket, const char* bytes, size_t size,
     const talk_base::SocketAddress& remote_addr) {
+  ProcessInternalPacket(socket, bytes, size, remote_addr, false);
+}
+
+void RelayServer::ProcessInternalPacket(
+    talk_base::AsyncPacketSocket* socket, const char* bytes, size_t size,
+    const talk_base::SocketAddress& remote_addr, bool forwarded) {
 
   // Get the address of the connection we just received on.
   talk_base::SocketAddressPair ap(remote_addr, socket->GetLocalAddress());
   ASSERT(!ap.destination().IsNil());
 
   // If this did not come from an existing connection, it should be a STUN
-  // allocate request.
+  // allocate request, unless it belongs to a binding on another server.
   ConnectionMap::iterator piter = connections_.find(ap);
   if (piter == connections_.end()) {
-    HandleStunAllocate(bytes, size, ap, socket);
+    if (!forwarded && MaybeForwardInternalPacket(bytes, size, ap))
+      return;
+    HandleStunAllocate(bytes, size, ap, socket, forwarded);
     return;
   }
 
@@ -332,9 +359,43 @@ bool RelayServer::HandleStun(
   return true;
 }
 
+bool RelayServer::MaybeForwardInternalPacket(
+    const char* bytes, size_t size, const talk_base::SocketAddressPair& ap) {
+  if (!directory_ || forwards_.empty())
+    return false;
+
+  ForwardMap::iterator fiter = forwards_.find(ap);
+  if (fiter == forwards_.end())
+    return false;
+
+  // The owner may have timed the binding out since we last looked; if so,
+  // the client starts over here.
+  if (directory_->GetBindingOwner(fiter->second.username) !=
+      fiter->second.owner) {
+    forwards_.erase(fiter);
+    return false;
+  }
+
+  directory_->ForwardInternalPacket(fiter->second.owner, bytes, size,
+                                    ap.source());
+  return true;
+}
+
+void RelayServer::SweepForwards() {
+  for (ForwardMap::iterator it = forwards_.begin(); it != forwards_.end();) {
+    if (directory_->GetBindingOwner(it->second.username) != it->second.owner) {
+      forwards_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  next_forward_sweep_ = talk_base::_max(kMinForwardSweepSize,
+                                        2 * forwards_.size());
+}
+
 void RelayServer::HandleStunAllocate(
     const char* bytes, size_t size, const talk_base::SocketAddressPair& ap,
-    talk_base::AsyncPacketSocket* socket) {
+    talk_base::AsyncPacketSocket* socket, bool forwarded) {
 
   // Make sure this is a valid STUN request.
   RelayMessage request;
@@ -363,6 +424,23 @@ void RelayServer::HandleStunAllocate(
   if (biter != bindings_.end()) {
     binding = biter->second;
   } else {
+    // When sharing the internal address with other servers, the binding may
+    // already live on one of them, in which case the whole connection is
+    // handed over. A packet that was already forwarded once stays here, so
+    // a race with a binding timing out can not bounce it around.
+    if (directory_) {
+      int owner = directory_->ClaimBinding(username, directory_index_);
+      if (owner != directory_index_ && !forwarded) {
+        if (forwards_.size() >= next_forward_sweep_)
+          SweepForwards();
+        ForwardedConnection& forward = forwards_[ap];
+        forward.owner = owner;
+        forward.username = username;
+        directory_->ForwardInternalPacket(owner, bytes, size, ap.source());
+        return;
+      }
+    }
+
     // NOTE: In the future, bindings will be created by the bot only.  This
     //       else-branch will then disappear.
 
@@ -533,6 +611,8 @@ void RelayServer::RemoveBinding(RelayServerBinding* binding) {
   BindingMap::iterator iter = bindings_.find(binding->username());
   ASSERT(iter != bindings_.end());
   bindings_.erase(iter);
+  if (directory_)
+    directory_->ReleaseBinding(binding->username(), directory_index_);
 
   if (log_bindings_) {
     LOG(LS_INFO) << "Removed binding " << binding->username() << ", "
@@ -753,4 +833,156 @@ void RelayServerBinding::OnMessage(talk_base::Message *pmsg) {
   }
 }
 
+// Owns the thread and server at one index of a RelayServerGroup, and
+// delivers packets forwarded to it by the other servers.
+class RelayServerGroup::Worker : public talk_base::MessageHandler {
+ public:
+  enum { MSG_FORWARDED_PACKET = 1 };
+
+  struct ForwardedPacket : public talk_base::MessageData {
+    ForwardedPacket(const char* bytes, size_t size,
+                    const talk_base::SocketAddress& remote_addr)
+        : data(bytes, size), remote_addr(remote_addr) {
+    }
+    std::string data;
+    talk_base::SocketAddress remote_addr;
+  };
+
+  Worker() : server(&thread) {}
+
+  virtual void OnMessage(talk_base::Message* pmsg) {
+    ASSERT(pmsg->message_id == MSG_FORWARDED_PACKET);
+    ForwardedPacket* packet = static_cast<ForwardedPacket*>(pmsg->pdata);
+    server.HandleForwardedPacket(packet->data.data(), packet->data.size(),
+                                 packet->remote_addr);
+    delete packet;
+  }
+
+  talk_base::Thread thread;
+  RelayServer server;
+  talk_base::SocketAddress external_address;
+};
+
+RelayServerGroup::RelayServerGroup() : log_bindings_(true) {
+}
+
+RelayServerGroup::~RelayServerGroup() {
+  Stop();
+}
+
+bool RelayServerGroup::Start(
+    const talk_base::SocketAddress& internal_address,
+    const talk_base::SocketAddress& external_address, int num_threads) {
+  ASSERT(workers_.empty());
+  ASSERT(num_threads > 0);
+  internal_address_ = internal_address;
+
+  // As with StunServerGroup, all sockets are bound up front so that failures
+  // are reported here rather than on the worker threads.
+  for (int i = 0; i < num_threads; ++i) {
+    Worker* worker = new Worker;
+    workers_.push_back(worker);
+    worker->server.set_log_bindings(log_bindings_);
+    worker->server.SetBindingDirectory(this, i);
+    talk_base::SocketServer* ss = worker->thread.socketserver();
+
+    talk_base::AsyncUDPSocket* int_socket = (num_threads == 1) ?
+        talk_base::AsyncUDPSocket::Create(ss, internal_address_) :
+        talk_base::AsyncUDPSocket::CreateShared(ss, internal_address_);
+    if (!int_socket) {
+      LOG(LS_ERROR) << "Failed to bind relay internal socket " << i << " to "
+                    << internal_address_.ToString();
+      Stop();
+      return false;
+    }
+    internal_address_ = int_socket->GetLocalAddress();
+    worker->server.AddInternalSocket(int_socket);
+
+    talk_base::SocketAddress ext_addr(external_address);
+    if (ext_addr.port() != 0)
+      ext_addr.SetPort(ext_addr.port() + i);
+    talk_base::AsyncUDPSocket* ext_socket =
+        talk_base::AsyncUDPSocket::Create(ss, ext_addr);
+    if (!ext_socket) {
+      LOG(LS_ERROR) << "Failed to bind relay external socket " << i << " to "
+                    << ext_addr.ToString();
+      Stop();
+      return false;
+    }
+    worker->server.AddExternalSocket(ext_socket);
+    worker->external_address = ext_socket->GetLocalAddress();
+  }
+
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.Start();
+  }
+  LOG(LS_INFO) << "Started " << workers_.size() << " relay server threads on "
+               << internal_address_.ToString();
+  return true;
+}
+
+void RelayServerGroup::Stop() {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.Stop();
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    // Drop packets that were forwarded but never delivered.
+    workers_[i]->thread.Clear(workers_[i]);
+  }
+  // Servers release their bindings in the directory as they are destroyed.
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    delete workers_[i];
+  }
+  workers_.clear();
+}
+
+talk_base::SocketAddress RelayServerGroup::external_address(int index) const {
+  ASSERT(index >= 0 && index < num_threads());
+  return workers_[index]->external_address;
+}
+
+int RelayServerGroup::ClaimBinding(const std::string& username, int index) {
+  Shard* shard = GetShard(username);
+  talk_base::CritScope cs(&shard->crit);
+  std::pair<std::map<std::string, int>::iterator, bool> result =
+      shard->owners.insert(std::make_pair(username, index));
+  return result.first->second;
+}
+
+void RelayServerGroup::ReleaseBinding(const std::string& username,
+                                      int index) {
+  Shard* shard = GetShard(username);
+  talk_base::CritScope cs(&shard->crit);
+  std::map<std::string, int>::iterator it = shard->owners.find(username);
+  if (it != shard->owners.end() && it->second == index)
+    shard->owners.erase(it);
+}
+
+int RelayServerGroup::GetBindingOwner(const std::string& username) {
+  Shard* shard = GetShard(username);
+  talk_base::CritScope cs(&shard->crit);
+  std::map<std::string, int>::const_iterator it = shard->owners.find(username);
+  return (it != shard->owners.end()) ? it->second : -1;
+}
+
+void RelayServerGroup::ForwardInternalPacket(
+    int owner, const char* bytes, size_t size,
+    const talk_base::SocketAddress& remote_addr) {
+  ASSERT(owner >= 0 && owner < num_threads());
+  Worker* worker = workers_[owner];
+  worker->thread.Post(worker, Worker::MSG_FORWARDED_PACKET,
+                      new Worker::ForwardedPacket(bytes, size, remote_addr));
+}
+
+RelayServerGroup::Shard* RelayServerGroup::GetShard(
+    const std::string& username) {
+  // FNV-1a; usernames are random, so any cheap hash spreads them evenly.
+  uint32 hash = 2166136261U;
+  for (size_t i = 0; i < username.size(); ++i) {
+    hash ^= static_cast<uint8>(username[i]);
+    hash *= 16777619U;
+  }
+  return &shards_[hash % kNumShards];
+}
+
 }  // namespace cricket
@@ -27,14 +27,25 @@
 
 #include <iostream>  // NOLINT
 
+#include "base/flags.h"
 #include "base/thread.h"
 #include "base/scoped_ptr.h"
 #include "p2p/base/relayserver.h"
 
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_int(threads, 1, "Number of server threads sharing the internal "
+           "address. Thread i listens externally on the external port + i.");
+
 int main(int argc, char **argv) {
-  if (argc != 3) {
-    std::cerr << "usage: relayserver internal-address external-address"
-              << std::endl;
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help || argc != 3) {
+    std::cerr << "usage: relayserver [--threads N] internal-address "
+              << "external-address" << std::endl;
+    FlagList::Print(NULL, false);
+    return FLAG_help ? 0 : 1;
+  }
+  if (FLAG_threads < 1) {
+    std::cerr << "Invalid thread count: " << FLAG_threads << std::endl;
     return 1;
   }
 
@@ -52,6 +63,23 @@ int main(int argc, char **argv) {
 
   talk_base::Thread *pthMain = talk_base::Thread::Current();
 
+  if (FLAG_threads > 1) {
+    cricket::RelayServerGroup group;
+    if (!group.Start(int_addr, ext_addr, FLAG_threads)) {
+      std::cerr << "Failed to start " << FLAG_threads << " relay threads"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Listening internally at "
+              << group.internal_address().ToString() << std::endl;
+    for (int i = 0; i < group.num_threads(); ++i) {
+      std::cout << "Listening externally at "
+                << group.external_address(i).ToString() << std::endl;
+    }
+    pthMain->Run();
+    return 0;
+  }
+
   talk_base::scoped_ptr<talk_base::AsyncUDPSocket> int_socket(
       talk_base::AsyncUDPSocket::Create(pthMain->socketserver(), int_addr));
   if (!int_socket) {
@@ -763,6 +763,7 @@ Session::Session(SessionManager* session_manager,
   client_ = client;
   initiate_acked_ = false;
   current_protocol_ = PROTOCOL_HYBRID;
+  candidate_batch_interval_ = 0;
 }
 
 Session::~Session() {
@@ -1010,6 +1011,10 @@ void Session::OnTransportProxyCandidatesReady(TransportProxy* transproxy,
       if (!transproxy->negotiated()) {
         transproxy->AddSentCandidates(candidates);
       }
+      if (candidate_batch_interval_ > 0) {
+        BatchCandidates(transproxy, candidates);
+        return;
+      }
       SessionError error;
       if (!SendTransportInfoMessage(transproxy, candidates, &error)) {
         LOG(LS_ERROR) << "Could not send transport info message: "
@@ -1372,6 +1377,15 @@ void Session::OnMessage(talk_base::Message* pmsg) {
     TerminateWithReason(STR_TERMINATE_ERROR);
     break;
 
+  case MSG_SEND_CANDIDATES: {
+    SessionError error;
+    if (!SendBatchedCandidates(&error)) {
+      LOG(LS_ERROR) << "Could not send batched transport info message: "
+                    << error.text;
+    }
+    break;
+  }
+
   case MSG_STATE:
     switch (orig_state) {
     case STATE_SENTREJECT:
@@ -1456,17 +1470,67 @@ bool Session::SendTransportInfoMessage(const TransportProxy* transproxy,
       TransportDescription(transproxy->type(), candidates)), error);
 }
 
+bool Session::SendTransportInfoMessage(const TransportInfos& tinfos,
+                                       SessionError* error) {
+  return SendMessage(ACTION_TRANSPORT_INFO, tinfos, error);
+}
+
 bool Session::WriteSessionAction(SignalingProtocol protocol,
                                  const TransportInfo& tinfo,
                                  XmlElements* elems, WriteError* error) {
   TransportInfos tinfos;
   tinfos.push_back(tinfo);
+  return WriteSessionAction(protocol, tinfos, elems, error);
+}
+
+bool Session::WriteSessionAction(SignalingProtocol protocol,
+                                 const TransportInfos& tinfos,
+                                 XmlElements* elems, WriteError* error) {
   return WriteTransportInfos(protocol, tinfos,
                              GetTransportParsers(), GetCandidateTranslators(),
                              elems, error);
 }
 
+void Session::BatchCandidates(const TransportProxy* transproxy,
+                              const Candidates& candidates) {
+  if (batched_candidates_.empty()) {
+    signaling_thread()->PostDelayed(candidate_batch_interval_, this,
+                                    MSG_SEND_CANDIDATES);
+  }
+  Candidates& batch = batched_candidates_[transproxy->content_name()];
+  batch.insert(batch.end(), candidates.begin(), candidates.end());
+}
+
+bool Session::SendBatchedCandidates(SessionError* error) {
+  signaling_thread()->Clear(this, MSG_SEND_CANDIDATES);
+  if (batched_candidates_.empty())
+    return true;
+
+  TransportInfos tinfos;
+  for (std::map<std::string, Candidates>::const_iterator iter =
+           batched_candidates_.begin();
+       iter != batched_candidates_.end(); ++iter) {
+    // The content may have gone away while its candidates were queued.
+    TransportProxy* transproxy = GetTransportProxy(iter->first);
+    if (transproxy == NULL)
+      continue;
+    tinfos.push_back(TransportInfo(iter->first,
+        TransportDescription(transproxy->type(), iter->second)));
+  }
+  batched_candidates_.clear();
+  if (tinfos.empty())
+    return true;
+  return SendTransportInfoMessage(tinfos, error);
+}
+
 bool Session::ResendAllTransportInfoMessages(SessionError* error) {
+  // Everything queued for a proxy that isn't negotiated yet is also in its
+  // sent candidates, and goes out below.
+  for (TransportMap::const_iterator iter = transport_proxies().begin();
+       iter != transport_proxies().end(); ++iter) {
+    if (!iter->second->negotiated())
+      batched_candidates_.erase(iter->second->content_name());
+  }
   for (TransportMap::const_iterator iter = transport_proxies().begin();
        iter != transport_proxies().end(); ++iter) {
     TransportProxy* transproxy = iter->second;
@@ -50,6 +50,7 @@ SessionManager::SessionManager(PortAllocator *allocator,
     worker_thread_ = worker;
   }
   timeout_ = 50;
+  candidate_batch_interval_ = 0;
 }
 
 SessionManager::~SessionManager() {
@@ -94,6 +95,7 @@ Session* SessionManager::CreateSession(
   Session* session = new Session(this, local_name, initiator_name,
                                  sid, content_type, client);
   session->set_identity(transport_desc_factory_.identity());
+  session->set_candidate_batch_interval(candidate_batch_interval_);
   session_map_[session->id()] = session;
   session->SignalRequestSignaling.connect(
       this, &SessionManager::OnRequestSignaling);
@@ -142,7 +144,10 @@ Session* SessionManager::FindSession(const std::string& sid,
     return NULL;
 
   Session* session = iter->second;
-  if (buzz::Jid(remote_name) != buzz::Jid(session->remote_name()))
+  // Names normally arrive exactly as we stored them; only fall back to
+  // parsing both JIDs when the strings differ.
+  if (remote_name != session->remote_name() &&
+      buzz::Jid(remote_name) != buzz::Jid(session->remote_name()))
     return NULL;
 
   return session;
@@ -0,0 +1,80 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>  // NOLINT
+
+#include "base/flags.h"
+#include "base/thread.h"
+#include "p2p/base/stunloadgenerator.h"
+
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_int(sockets, 16, "Number of client sockets.");
+DEFINE_int(window, 8, "Requests kept in flight per socket.");
+DEFINE_int(duration, 10000, "How long to send requests, in milliseconds.");
+DEFINE_int(timeout, 1000, "When to give up on a request, in milliseconds.");
+
+// Measures a STUN server's throughput and tail latency. A single generator
+// runs on one thread; to load a multi-threaded server, run several.
+int main(int argc, char **argv) {
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help || argc != 2) {
+    std::cerr << "usage: stunloadgen [flags] server-address" << std::endl;
+    FlagList::Print(NULL, false);
+    return FLAG_help ? 0 : 1;
+  }
+  if (FLAG_sockets < 1 || FLAG_window < 1) {
+    std::cerr << "--sockets and --window must be positive" << std::endl;
+    return 1;
+  }
+
+  talk_base::SocketAddress server_addr;
+  if (!server_addr.FromString(argv[1])) {
+    std::cerr << "Unable to parse IP address: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  talk_base::Thread* thread = talk_base::Thread::Current();
+  cricket::StunLoadGenerator generator(thread, server_addr);
+  talk_base::IPAddress local_ip = (server_addr.family() == AF_INET6) ?
+      talk_base::IPAddress(in6addr_any) : talk_base::IPAddress(INADDR_ANY);
+  if (!generator.Init(local_ip, FLAG_sockets, FLAG_window)) {
+    std::cerr << "Failed to create client sockets" << std::endl;
+    return 1;
+  }
+
+  cricket::StunLoadStats stats =
+      generator.Run(FLAG_duration, FLAG_timeout);
+  std::cout << "sent " << stats.requests_sent
+            << ", received " << stats.responses_received
+            << ", timed out " << stats.timeouts << std::endl;
+  std::cout << "requests/sec " << stats.requests_per_second() << std::endl;
+  std::cout << "latency us: p50 " << stats.latency_p50_us
+            << ", p90 " << stats.latency_p90_us
+            << ", p99 " << stats.latency_p99_us
+            << ", max " << stats.latency_max_us << std::endl;
+  return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "p2p/base/stunloadgenerator.h"
+
+#include <algorithm>
+
+#include "base/byteorder.h"
+#include "base/logging.h"
+#include "base/thread.h"
+#include "base/timeutils.h"
+#include "p2p/base/stun.h"
+
+namespace cricket {
+
+// How long Run() lets the thread process I/O between timeout checks.
+static const int kPollIntervalMs = 5;
+
+// The transaction ID of every request is the client index followed by a
+// per-client sequence number, so responses can be matched without a lookup.
+// Sequence number n always lives in slot n % window.
+struct StunLoadGenerator::Client {
+  struct Slot {
+    Slot() : seq(0), sent_ns(0), in_flight(false) {}
+    uint64 seq;
+    int64 sent_ns;
+    bool in_flight;
+  };
+
+  Client(uint32 index, talk_base::AsyncUDPSocket* socket, int window)
+      : index(index), socket(socket), slots(window) {
+    for (size_t i = 0; i < slots.size(); ++i) {
+      slots[i].seq = i;
+    }
+  }
+  ~Client() { delete socket; }
+
+  uint32 index;
+  talk_base::AsyncUDPSocket* socket;
+  std::vector<Slot> slots;
+};
+
+StunLoadGenerator::StunLoadGenerator(
+    talk_base::Thread* thread, const talk_base::SocketAddress& server_addr)
+    : thread_(thread), server_addr_(server_addr), sending_(false),
+      in_flight_(0) {
+}
+
+StunLoadGenerator::~StunLoadGenerator() {
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    delete clients_[i];
+  }
+}
+
+bool StunLoadGenerator::Init(const talk_base::IPAddress& local_ip,
+                             int num_sockets, int window) {
+  ASSERT(clients_.empty());
+  ASSERT(num_sockets > 0 && window > 0);
+  for (int i = 0; i < num_sockets; ++i) {
+    talk_base::AsyncUDPSocket* socket = talk_base::AsyncUDPSocket::Create(
+        thread_->socketserver(), talk_base::SocketAddress(local_ip, 0));
+    if (!socket) {
+      LOG(LS_ERROR) << "Failed to create load generator socket " << i;
+      return false;
+    }
+    socket->SignalReadPacket.connect(this, &StunLoadGenerator::OnPacket);
+    clients_.push_back(new Client(i, socket, window));
+  }
+  return true;
+}
+
+StunLoadStats StunLoadGenerator::Run(int duration_ms, int timeout_ms) {
+  ASSERT(talk_base::Thread::Current() == thread_);
+  stats_ = StunLoadStats();
+  latencies_us_.clear();
+  in_flight_ = 0;
+
+  const int64 timeout_ns =
+      static_cast<int64>(timeout_ms) * talk_base::kNumNanosecsPerMillisec;
+  const int64 start_ns = talk_base::TimeNanos();
+  const int64 stop_sending_ns = start_ns +
+      static_cast<int64>(duration_ms) * talk_base::kNumNanosecsPerMillisec;
+
+  sending_ = true;
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    for (size_t j = 0; j < clients_[i]->slots.size(); ++j) {
+      SendRequest(clients_[i], j);
+    }
+  }
+
+  int64 now_ns = start_ns;
+  while (true) {
+    thread_->ProcessMessages(kPollIntervalMs);
+    now_ns = talk_base::TimeNanos();
+    if (sending_ && now_ns >= stop_sending_ns)
+      sending_ = false;
+    CheckTimeouts(now_ns, timeout_ns);
+    if (!sending_ && in_flight_ == 0)
+      break;
+  }
+
+  stats_.elapsed_us =
+      (now_ns - start_ns) / talk_base::kNumNanosecsPerMicrosec;
+  if (!latencies_us_.empty()) {
+    std::sort(latencies_us_.begin(), latencies_us_.end());
+    size_t n = latencies_us_.size();
+    stats_.latency_p50_us = latencies_us_[n * 50 / 100];
+    stats_.latency_p90_us = latencies_us_[n * 90 / 100];
+    stats_.latency_p99_us = latencies_us_[n * 99 / 100];
+    stats_.latency_max_us = latencies_us_[n - 1];
+  }
+  return stats_;
+}
+
+void StunLoadGenerator::SendRequest(Client* client, size_t slot) {
+  Client::Slot& s = client->slots[slot];
+  char request[kStunHeaderSize];
+  talk_base::SetBE16(request, STUN_BINDING_REQUEST);
+  talk_base::SetBE16(request + 2, 0);
+  talk_base::SetBE32(request + 4, kStunMagicCookie);
+  talk_base::SetBE32(request + 8, client->index);
+  talk_base::SetBE64(request + 12, s.seq);
+
+  s.sent_ns = talk_base::TimeNanos();
+  s.in_flight = true;
+  ++in_flight_;
+  ++stats_.requests_sent;
+  if (client->socket->SendTo(request, sizeof(request), server_addr_) < 0) {
+    // Treat a failed send like a lost packet; the timeout will retire it.
+    LOG_ERR(LS_WARNING) << "sendto";
+  }
+}
+
+void StunLoadGenerator::CheckTimeouts(int64 now_ns, int64 timeout_ns) {
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    Client* client = clients_[i];
+    for (size_t j = 0; j < client->slots.size(); ++j) {
+      Client::Slot& s = client->slots[j];
+      if (!s.in_flight || now_ns - s.sent_ns < timeout_ns)
+        continue;
+      s.in_flight = false;
+      --in_flight_;
+      ++stats_.timeouts;
+      s.seq += client->slots.size();
+      if (sending_)
+        SendRequest(client, j);
+    }
+  }
+}
+
+void StunLoadGenerator::OnPacket(
+    talk_base::AsyncPacketSocket* socket, const char* buf, size_t size,
+    const talk_base::SocketAddress& remote_addr) {
+  if (size < kStunHeaderSize ||
+      talk_base::GetBE16(buf) != STUN_BINDING_RESPONSE ||
+      talk_base::GetBE32(buf + 4) != kStunMagicCookie) {
+    return;
+  }
+
+  uint32 index = talk_base::GetBE32(buf + 8);
+  if (index >= clients_.size() || clients_[index]->socket != socket)
+    return;
+  Client* client = clients_[index];
+
+  // Late responses to requests that already timed out no longer match the
+  // sequence number in their slot and are ignored.
+  uint64 seq = talk_base::GetBE64(buf + 12);
+  size_t slot = static_cast<size_t>(seq % client->slots.size());
+  Client::Slot& s = client->slots[slot];
+  if (!s.in_flight || s.seq != seq)
+    return;
+
+  int64 latency_ns = talk_base::TimeNanos() - s.sent_ns;
+  latencies_us_.push_back(
+      static_cast<uint32>(latency_ns / talk_base::kNumNanosecsPerMicrosec));
+  s.in_flight = false;
+  --in_flight_;
+  ++stats_.responses_received;
+  s.seq += client->slots.size();
+  if (sending_)
+    SendRequest(client, slot);
+}
+
+}  // namespace cricket
@@ -29,6 +29,7 @@
 
 #include "base/bytebuffer.h"
 #include "base/logging.h"
+#include "base/thread.h"
 
 namespace cricket {
 
@@ -106,4 +107,64 @@ void StunServer::SendResponse(
     LOG_ERR(LS_ERROR) << "sendto";
 }
 
+struct StunServerGroup::Worker {
+  talk_base::Thread thread;
+  talk_base::scoped_ptr<StunServer> server;
+};
+
+StunServerGroup::StunServerGroup() {
+}
+
+StunServerGroup::~StunServerGroup() {
+  Stop();
+}
+
+bool StunServerGroup::Start(const talk_base::SocketAddress& address,
+                            int num_threads) {
+  ASSERT(workers_.empty());
+  ASSERT(num_threads > 0);
+  address_ = address;
+
+  // The sockets are created here, before their threads start, so that a bind
+  // failure can be reported synchronously. Each socket belongs to the socket
+  // server of the thread that will service it.
+  for (int i = 0; i < num_threads; ++i) {
+    Worker* worker = new Worker;
+    workers_.push_back(worker);
+    talk_base::SocketServer* ss = worker->thread.socketserver();
+    talk_base::AsyncUDPSocket* socket = (num_threads == 1) ?
+        talk_base::AsyncUDPSocket::Create(ss, address_) :
+        talk_base::AsyncUDPSocket::CreateShared(ss, address_);
+    if (!socket) {
+      LOG(LS_ERROR) << "Failed to bind STUN socket " << i << " to "
+                    << address_.ToString();
+      Stop();
+      return false;
+    }
+    // Once the first socket has picked a port, the rest must share it.
+    address_ = socket->GetLocalAddress();
+    worker->server.reset(new StunServer(socket));
+  }
+
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.Start();
+  }
+  LOG(LS_INFO) << "Started " << workers_.size() << " STUN server threads on "
+               << address_.ToString();
+  return true;
+}
+
+void StunServerGroup::Stop() {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.Stop();
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    // The server is destroyed while its thread is stopped, so it can not be
+    // signalled mid-teardown.
+    workers_[i]->server.reset();
+    delete workers_[i];
+  }
+  workers_.clear();
+}
+
 }  // namespace cricket
@@ -31,15 +31,25 @@
 
 #include <iostream>
 
+#include "base/flags.h"
 #include "base/host.h"
 #include "base/thread.h"
 #include "p2p/base/stunserver.h"
 
 using namespace cricket;
 
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_int(threads, 1, "Number of server threads sharing the address.");
+
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    std::cerr << "usage: stunserver address" << std::endl;
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help || argc != 2) {
+    std::cerr << "usage: stunserver [--threads N] address" << std::endl;
+    FlagList::Print(NULL, false);
+    return FLAG_help ? 0 : 1;
+  }
+  if (FLAG_threads < 1) {
+    std::cerr << "Invalid thread count: " << FLAG_threads << std::endl;
     return 1;
   }
 
@@ -51,6 +61,21 @@ int main(int argc, char* argv[]) {
 
   talk_base::Thread *pthMain = talk_base::Thread::Current();
 
+  // With more than one thread, every thread runs its own server and the main
+  // thread just waits.
+  if (FLAG_threads > 1) {
+    StunServerGroup group;
+    if (!group.Start(server_addr, FLAG_threads)) {
+      std::cerr << "Failed to create " << FLAG_threads << " shared UDP sockets"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Listening at " << group.address().ToString() << " on "
+              << FLAG_threads << " threads" << std::endl;
+    pthMain->Run();
+    return 0;
+  }
+
   talk_base::AsyncUDPSocket* server_socket =
       talk_base::AsyncUDPSocket::Create(pthMain->socketserver(), server_addr);
   if (!server_socket) {
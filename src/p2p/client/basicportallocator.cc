@@ -35,6 +35,7 @@
 #include "base/helpers.h"
 #include "base/host.h"
 #include "base/logging.h"
+#include "base/timeutils.h"
 #include "p2p/base/common.h"
 #include "p2p/base/port.h"
 #include "p2p/base/relayport.h"
@@ -42,6 +43,7 @@
 #include "p2p/base/tcpport.h"
 #include "p2p/base/turnport.h"
 #include "p2p/base/udpport.h"
+#include "p2p/client/portpool.h"
 
 using talk_base::CreateRandomId;
 using talk_base::CreateRandomString;
@@ -253,6 +255,8 @@ BasicPortAllocator::BasicPortAllocator(
 void BasicPortAllocator::Construct() {
   best_writable_phase_ = -1;
   allow_tcp_listen_ = true;
+  step_delay_ = ALLOCATION_STEP_DELAY;
+  port_pool_size_ = 0;
 }
 
 BasicPortAllocator::~BasicPortAllocator() {
@@ -275,6 +279,22 @@ PortAllocatorSession *BasicPortAllocator::CreateSessionInternal(
                                        ice_ufrag, ice_pwd);
 }
 
+PortPool* BasicPortAllocator::GetPortPool(talk_base::Thread* thread) {
+  if (port_pool_size_ <= 0)
+    return NULL;
+  if (!port_pool_) {
+    port_pool_ = new talk_base::RefCountedObject<PortPool>(thread,
+                                                           socket_factory_);
+    port_pool_->set_target_size(port_pool_size_);
+    port_pool_->SetPortRange(min_port(), max_port());
+  }
+  if (port_pool_->thread() != thread) {
+    LOG(LS_WARNING) << "Not pooling ports for a session on another thread";
+    return NULL;
+  }
+  return port_pool_.get();
+}
+
 void BasicPortAllocator::AddWritablePhase(int phase) {
   if ((best_writable_phase_ == -1) || (phase < best_writable_phase_))
     best_writable_phase_ = phase;
@@ -295,7 +315,12 @@ BasicPortAllocatorSession::BasicPortAllocatorSession(
       allocation_started_(false),
       network_manager_started_(false),
       running_(false),
-      allocation_sequences_created_(false) {
+      allocation_sequences_created_(false),
+      start_time_(0),
+      first_candidate_time_(0),
+      complete_time_(0),
+      first_candidate_signaled_(false),
+      complete_signaled_(false) {
   allocator_->network_manager()->SignalNetworksChanged.connect(
       this, &BasicPortAllocatorSession::OnNetworksChanged);
   allocator_->network_manager()->StartUpdating();
@@ -319,11 +344,13 @@ BasicPortAllocatorSession::~BasicPortAllocatorSession() {
 
 void BasicPortAllocatorSession::GetInitialPorts() {
   network_thread_ = talk_base::Thread::Current();
+  start_time_ = talk_base::Time();
   if (!socket_factory_) {
     owned_socket_factory_.reset(
         new talk_base::BasicPacketSocketFactory(network_thread_));
     socket_factory_ = owned_socket_factory_.get();
   }
+  port_pool_ = allocator_->GetPortPool(network_thread_);
 
   network_thread_->Post(this, MSG_CONFIG_START);
 
@@ -351,6 +378,18 @@ void BasicPortAllocatorSession::StopGetAllPorts() {
   network_thread_->Post(this, MSG_CONFIG_STOP);
 }
 
+int BasicPortAllocatorSession::time_to_first_candidate() const {
+  if (!first_candidate_signaled_)
+    return -1;
+  return talk_base::TimeDiff(first_candidate_time_, start_time_);
+}
+
+int BasicPortAllocatorSession::time_to_complete() const {
+  if (!complete_signaled_)
+    return -1;
+  return talk_base::TimeDiff(complete_time_, start_time_);
+}
+
 void BasicPortAllocatorSession::OnMessage(talk_base::Message *message) {
   switch (message->message_id) {
   case MSG_CONFIG_START:
@@ -580,6 +619,27 @@ void BasicPortAllocatorSession::AddAllocatedPort(Port* port,
     port->Start();
 }
 
+void BasicPortAllocatorSession::AdoptPooledPort(Port* port,
+                                                AllocationSequence* seq) {
+  AddAllocatedPort(port, seq, false);
+  // Like a freshly created port, make up credentials if the session has none.
+  if (username().empty()) {
+    port->SetIceParameters(
+        talk_base::CreateRandomString(ICE_UFRAG_LENGTH),
+        talk_base::CreateRandomString(ICE_PWD_LENGTH));
+  } else {
+    port->SetIceParameters(username(), password());
+  }
+  LOG_J(LS_INFO, port) << "Took port from the pool";
+
+  // The port gathered its candidates before we were listening, so replay
+  // what it signaled back then.
+  std::vector<Candidate> candidates = port->Candidates();
+  for (size_t i = 0; i < candidates.size(); ++i)
+    OnCandidateReady(port, candidates[i]);
+  OnPortReady(port);
+}
+
 void BasicPortAllocatorSession::OnAllocationSequenceObjectsCreated() {
   allocation_sequences_created_ = true;
   // Send candidate allocation complete signal if we have no sequences.
@@ -605,10 +665,19 @@ void BasicPortAllocatorSession::OnCandidateReady(
   }
 
   if (!candidates.empty()) {
-    SignalCandidatesReady(this, candidates);
+    SignalCandidates(candidates);
   }
 }
 
+void BasicPortAllocatorSession::SignalCandidates(
+    const std::vector<Candidate>& candidates) {
+  if (!first_candidate_signaled_) {
+    first_candidate_signaled_ = true;
+    first_candidate_time_ = talk_base::Time();
+  }
+  SignalCandidatesReady(this, candidates);
+}
+
 void BasicPortAllocatorSession::OnPortReady(Port* port) {
   ASSERT(talk_base::Thread::Current() == network_thread_);
   PortData* data = FindPort(port);
@@ -656,7 +725,7 @@ void BasicPortAllocatorSession::OnProtocolEnabled(AllocationSequence* seq,
   }
 
   if (!candidates.empty()) {
-    SignalCandidatesReady(this, candidates);
+    SignalCandidates(candidates);
   }
 }
 
@@ -687,8 +756,14 @@ void BasicPortAllocatorSession::MaybeSignalCandidatesAllocationDone() {
     if (!it->complete())
       return;
   }
+  if (!complete_signaled_) {
+    complete_signaled_ = true;
+    complete_time_ = talk_base::Time();
+  }
   LOG(LS_INFO) << "All candidates gathered for " << content_name_ << ":"
-               << component_ << ":" << generation();
+               << component_ << ":" << generation() << " in "
+               << time_to_complete() << " ms (first candidate after "
+               << time_to_first_candidate() << " ms)";
   SignalCandidatesAllocationDone(this);
 }
 
@@ -776,11 +851,16 @@ AllocationSequence::AllocationSequence(BasicPortAllocatorSession* session,
       udp_socket_(NULL) {
   // All of the phases up until the best-writable phase so far run in step 0.
   // The other phases follow sequentially in the steps after that.  If there is
-  // no best-writable so far, then only phase 0 occurs in step 0.
+  // no best-writable so far, then only phase 0 occurs in step 0.  Without a
+  // step delay, all of the later phases share step 1 instead.
   int last_phase_in_step_zero =
       talk_base::_max(0, session->allocator()->best_writable_phase());
-  for (int phase = 0; phase < kNumPhases; ++phase)
+  bool paced = session->allocator()->step_delay() > 0;
+  for (int phase = 0; phase < kNumPhases; ++phase) {
     step_of_phase_[phase] = talk_base::_max(0, phase - last_phase_in_step_zero);
+    if (!paced)
+      step_of_phase_[phase] = talk_base::_min(1, step_of_phase_[phase]);
+  }
 }
 
 bool AllocationSequence::Init() {
@@ -842,10 +922,13 @@ void AllocationSequence::DisableEquivalentPhases(talk_base::Network* network,
 }
 
 void AllocationSequence::Start() {
+  // Every phase may already have run in step 0, in which case there is
+  // nothing left to schedule.
+  if (state_ == kCompleted)
+    return;
   state_ = kRunning;
-  session_->network_thread()->PostDelayed(ALLOCATION_STEP_DELAY,
-                                          this,
-                                          MSG_ALLOCATION_PHASE);
+  session_->network_thread()->PostDelayed(
+      session_->allocator()->step_delay(), this, MSG_ALLOCATION_PHASE);
 }
 
 void AllocationSequence::Stop() {
@@ -910,9 +993,8 @@ void AllocationSequence::OnMessage(talk_base::Message* msg) {
 
   step_ += 1;
   if (state() == kRunning) {
-    session_->network_thread()->PostDelayed(ALLOCATION_STEP_DELAY,
-                                            this,
-                                            MSG_ALLOCATION_PHASE);
+    session_->network_thread()->PostDelayed(
+        session_->allocator()->step_delay(), this, MSG_ALLOCATION_PHASE);
   }
 }
 
@@ -1015,6 +1097,15 @@ void AllocationSequence::CreateStunPorts() {
     return;
   }
 
+  if (session_->port_pool()) {
+    Port* pooled = session_->port_pool()->TakeStunPort(network_,
+                                                       config_->stun_address);
+    if (pooled) {
+      session_->AdoptPooledPort(pooled, this);
+      return;
+    }
+  }
+
   StunPort* port = StunPort::Create(session_->network_thread(),
                                 session_->socket_factory(),
                                 network_, ip_,
@@ -1093,6 +1184,14 @@ void AllocationSequence::CreateTurnPort(const RelayServerConfig& config) {
   for (relay_port = config.ports.begin();
        relay_port != config.ports.end(); ++relay_port) {
     if (relay_port->proto == PROTO_UDP) {
+      if (session_->port_pool()) {
+        Port* pooled = session_->port_pool()->TakeTurnPort(
+            network_, relay_port->address, config.credentials);
+        if (pooled) {
+          session_->AdoptPooledPort(pooled, this);
+          continue;
+        }
+      }
       TurnPort* port = TurnPort::Create(session_->network_thread(),
                                         session_->socket_factory(),
                                         network_, ip_,
@@ -0,0 +1,238 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "p2p/client/portpool.h"
+
+#include <algorithm>
+
+#include "base/basicpacketsocketfactory.h"
+#include "base/helpers.h"
+#include "base/logging.h"
+#include "base/network.h"
+#include "base/thread.h"
+#include "p2p/base/common.h"
+#include "p2p/base/constants.h"
+#include "p2p/base/port.h"
+#include "p2p/base/stunport.h"
+#include "p2p/base/turnport.h"
+
+namespace cricket {
+
+namespace {
+
+const uint32 MSG_DESTROY_DOOMED_PORTS = 1;
+
+}  // namespace
+
+PortPool::Key::Key(PortKind kind, talk_base::Network* network,
+                   const talk_base::SocketAddress& server,
+                   const RelayCredentials& credentials)
+    : kind(kind), network(network), ip(network->ip()), server(server),
+      username(credentials.username), password(credentials.password) {
+}
+
+bool PortPool::Key::operator<(const Key& other) const {
+  if (kind != other.kind)
+    return kind < other.kind;
+  if (network != other.network)
+    return network < other.network;
+  if (ip != other.ip)
+    return ip < other.ip;
+  if (server != other.server)
+    return server < other.server;
+  if (username != other.username)
+    return username < other.username;
+  return password < other.password;
+}
+
+PortPool::PortPool(talk_base::Thread* thread,
+                   talk_base::PacketSocketFactory* factory)
+    : thread_(thread),
+      factory_(factory),
+      target_size_(1),
+      min_port_(0),
+      max_port_(0),
+      hits_(0),
+      misses_(0) {
+  if (!factory_) {
+    owned_factory_.reset(new talk_base::BasicPacketSocketFactory(thread_));
+    factory_ = owned_factory_.get();
+  }
+}
+
+PortPool::~PortPool() {
+  thread_->Clear(this);
+
+  // The last reference may be dropped on another thread (by the allocator);
+  // the ports' sockets must still be closed on the pool's own thread.
+  bool on_thread = (talk_base::Thread::Current() == thread_);
+  std::vector<Port*> ports(doomed_);
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+    ports.insert(ports.end(), it->second.ready.begin(),
+                 it->second.ready.end());
+    ports.insert(ports.end(), it->second.pending.begin(),
+                 it->second.pending.end());
+  }
+  for (size_t i = 0; i < ports.size(); ++i) {
+    ports[i]->SignalAddressReady.disconnect(this);
+    ports[i]->SignalAddressError.disconnect(this);
+    if (on_thread) {
+      delete ports[i];
+    } else {
+      thread_->Dispose(ports[i]);
+    }
+  }
+}
+
+Port* PortPool::TakeStunPort(talk_base::Network* network,
+                             const talk_base::SocketAddress& server) {
+  return Take(Key(KIND_STUN, network, server, RelayCredentials()));
+}
+
+Port* PortPool::TakeTurnPort(talk_base::Network* network,
+                             const talk_base::SocketAddress& server,
+                             const RelayCredentials& credentials) {
+  return Take(Key(KIND_TURN, network, server, credentials));
+}
+
+int PortPool::ready_port_count() const {
+  int count = 0;
+  for (EntryMap::const_iterator it = entries_.begin();
+       it != entries_.end(); ++it) {
+    count += static_cast<int>(it->second.ready.size());
+  }
+  return count;
+}
+
+int PortPool::pending_port_count() const {
+  int count = 0;
+  for (EntryMap::const_iterator it = entries_.begin();
+       it != entries_.end(); ++it) {
+    count += static_cast<int>(it->second.pending.size());
+  }
+  return count;
+}
+
+Port* PortPool::Take(const Key& key) {
+  ASSERT(talk_base::Thread::Current() == thread_);
+  Entry* entry = &entries_[key];
+  Port* port = NULL;
+  if (!entry->ready.empty()) {
+    // Hand out the oldest port first; it has been kept warm the longest.
+    port = entry->ready.front();
+    entry->ready.erase(entry->ready.begin());
+    port->SignalAddressReady.disconnect(this);
+    port->SignalAddressError.disconnect(this);
+    ++hits_;
+  } else {
+    ++misses_;
+  }
+  Fill(key, entry);
+  return port;
+}
+
+void PortPool::Fill(const Key& key, Entry* entry) {
+  while (static_cast<int>(entry->ready.size() + entry->pending.size()) <
+         target_size_) {
+    Port* port = CreatePort(key);
+    if (!port)
+      return;
+    entry->pending.push_back(port);
+    port->SignalAddressReady.connect(this, &PortPool::OnPortReady);
+    port->SignalAddressError.connect(this, &PortPool::OnPortError);
+    port->PrepareAddress();
+  }
+}
+
+Port* PortPool::CreatePort(const Key& key) {
+  // The credentials are placeholders until a session takes the port.
+  std::string ufrag = talk_base::CreateRandomString(ICE_UFRAG_LENGTH);
+  std::string pwd = talk_base::CreateRandomString(ICE_PWD_LENGTH);
+  if (key.kind == KIND_STUN) {
+    return StunPort::Create(thread_, factory_, key.network, key.ip,
+                            min_port_, max_port_, ufrag, pwd, key.server);
+  }
+  ASSERT(key.kind == KIND_TURN);
+  return TurnPort::Create(thread_, factory_, key.network, key.ip,
+                          min_port_, max_port_, ufrag, pwd, key.server,
+                          RelayCredentials(key.username, key.password));
+}
+
+PortPool::Entry* PortPool::FindEntry(Port* port, bool* pending) {
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+    Entry* entry = &it->second;
+    if (std::find(entry->pending.begin(), entry->pending.end(), port) !=
+        entry->pending.end()) {
+      *pending = true;
+      return entry;
+    }
+    if (std::find(entry->ready.begin(), entry->ready.end(), port) !=
+        entry->ready.end()) {
+      *pending = false;
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+void PortPool::OnPortReady(Port* port) {
+  bool pending;
+  Entry* entry = FindEntry(port, &pending);
+  if (!entry || !pending)
+    return;
+  entry->pending.erase(
+      std::find(entry->pending.begin(), entry->pending.end(), port));
+  entry->ready.push_back(port);
+  LOG_J(LS_INFO, port) << "Port is ready in the pool";
+}
+
+void PortPool::OnPortError(Port* port) {
+  bool pending;
+  Entry* entry = FindEntry(port, &pending);
+  if (!entry)
+    return;
+  std::vector<Port*>* ports = pending ? &entry->pending : &entry->ready;
+  ports->erase(std::find(ports->begin(), ports->end(), port));
+  LOG_J(LS_WARNING, port) << "Dropping port from the pool";
+  // The next Take*() for this key tries again. Deleting a port from within
+  // its own signal is not safe, so that waits for the next message.
+  port->SignalAddressReady.disconnect(this);
+  port->SignalAddressError.disconnect(this);
+  if (doomed_.empty())
+    thread_->Post(this, MSG_DESTROY_DOOMED_PORTS);
+  doomed_.push_back(port);
+}
+
+void PortPool::OnMessage(talk_base::Message* msg) {
+  ASSERT(msg->message_id == MSG_DESTROY_DOOMED_PORTS);
+  std::vector<Port*> doomed;
+  doomed.swap(doomed_);
+  for (size_t i = 0; i < doomed.size(); ++i)
+    delete doomed[i];
+}
+
+}  // namespace cricket
@@ -0,0 +1,121 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "session/media/audioleveltracker.h"
+
+#include "base/common.h"
+#include "base/timeutils.h"
+
+namespace cricket {
+
+// The voice engine level is based on the peak sample, while RFC 6464 carries
+// the RMS level. Assuming a 10 dB crest factor for speech, these are the
+// largest -dBov values that reach levels 1 to 9.
+static const int kLevelThresholds[] = {
+  52, 34, 30, 28, 24, 20, 16, 14, 13
+};
+
+// Levels rise immediately and fall by 1/8 of the difference per packet,
+// which is roughly 150 ms for 20 ms packets.
+static const int kDecayShift = 3;
+
+const uint32 AudioLevelTracker::kStaleStreamMs;
+const uint32 AudioLevelTracker::kExpireStreamMs;
+
+AudioLevelTracker::AudioLevelTracker() {
+}
+
+int AudioLevelTracker::DbovToLevel(int dbov) {
+  int level = 0;
+  while (level < ARRAY_SIZE(kLevelThresholds) &&
+         dbov <= kLevelThresholds[level]) {
+    ++level;
+  }
+  return level;
+}
+
+void AudioLevelTracker::OnPacket(uint32 ssrc, int dbov, uint32 now) {
+  int target_q8 = DbovToLevel(dbov) << 8;
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    StreamLevel& stream = streams_[i];
+    if (stream.ssrc != ssrc) {
+      continue;
+    }
+    if (talk_base::TimeDiff(now, stream.last_packet_time) >
+        static_cast<int>(kStaleStreamMs)) {
+      // Start over after a gap rather than decaying from a stale level.
+      stream.level_q8 = target_q8;
+    } else if (target_q8 >= stream.level_q8) {
+      stream.level_q8 = target_q8;
+    } else {
+      stream.level_q8 -= (stream.level_q8 - target_q8) >> kDecayShift;
+    }
+    stream.last_packet_time = now;
+    return;
+  }
+  StreamLevel stream;
+  stream.ssrc = ssrc;
+  stream.level_q8 = target_q8;
+  stream.last_packet_time = now;
+  streams_.push_back(stream);
+}
+
+void AudioLevelTracker::GetActiveStreams(uint32 now,
+                                         AudioInfo::StreamList* streams) {
+  streams->clear();
+  size_t i = 0;
+  while (i < streams_.size()) {
+    const StreamLevel& stream = streams_[i];
+    int age = talk_base::TimeDiff(now, stream.last_packet_time);
+    if (age > static_cast<int>(kExpireStreamMs)) {
+      streams_[i] = streams_.back();
+      streams_.pop_back();
+      continue;
+    }
+    int level = (stream.level_q8 + 128) >> 8;
+    if (age <= static_cast<int>(kStaleStreamMs) && level > 0) {
+      streams->push_back(std::make_pair(stream.ssrc, level));
+    }
+    ++i;
+  }
+}
+
+void AudioLevelTracker::RemoveSsrc(uint32 ssrc) {
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    if (streams_[i].ssrc == ssrc) {
+      streams_[i] = streams_.back();
+      streams_.pop_back();
+      return;
+    }
+  }
+}
+
+void AudioLevelTracker::Clear() {
+  streams_.clear();
+}
+
+}  // namespace cricket
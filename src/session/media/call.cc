@@ -665,7 +665,10 @@ void Call::StopConnectionMonitor(Session* session) {
 void Call::StartAudioMonitor(Session* session, int cms) {
   VoiceChannel* voice_channel = GetVoiceChannel(session);
   if (voice_channel) {
-    voice_channel->SignalAudioMonitor.connect(this, &Call::OnAudioMonitor);
+    // Both audio monitors report on the same signal.
+    if (!voice_channel->IsRtpAudioLevelMonitorRunning()) {
+      voice_channel->SignalAudioMonitor.connect(this, &Call::OnAudioMonitor);
+    }
     voice_channel->StartAudioMonitor(cms);
   }
 }
@@ -674,7 +677,9 @@ void Call::StopAudioMonitor(Session* session) {
   VoiceChannel* voice_channel = GetVoiceChannel(session);
   if (voice_channel) {
     voice_channel->StopAudioMonitor();
-    voice_channel->SignalAudioMonitor.disconnect(this);
+    if (!voice_channel->IsRtpAudioLevelMonitorRunning()) {
+      voice_channel->SignalAudioMonitor.disconnect(this);
+    }
   }
 }
 
@@ -687,9 +692,40 @@ bool Call::IsAudioMonitorRunning(Session* session) {
   }
 }
 
+void Call::StartRtpAudioLevelMonitor(Session* session, int cms) {
+  VoiceChannel* voice_channel = GetVoiceChannel(session);
+  if (voice_channel) {
+    if (!voice_channel->IsAudioMonitorRunning() &&
+        !voice_channel->IsRtpAudioLevelMonitorRunning()) {
+      voice_channel->SignalAudioMonitor.connect(this, &Call::OnAudioMonitor);
+    }
+    voice_channel->StartRtpAudioLevelMonitor(cms);
+  }
+}
+
+void Call::StopRtpAudioLevelMonitor(Session* session) {
+  VoiceChannel* voice_channel = GetVoiceChannel(session);
+  if (voice_channel) {
+    voice_channel->StopRtpAudioLevelMonitor();
+    if (!voice_channel->IsAudioMonitorRunning()) {
+      voice_channel->SignalAudioMonitor.disconnect(this);
+    }
+  }
+}
+
+bool Call::IsRtpAudioLevelMonitorRunning(Session* session) {
+  VoiceChannel* voice_channel = GetVoiceChannel(session);
+  if (voice_channel) {
+    return voice_channel->IsRtpAudioLevelMonitorRunning();
+  } else {
+    return false;
+  }
+}
+
 void Call::StartSpeakerMonitor(Session* session) {
   if (speaker_monitor_map_.find(session->id()) == speaker_monitor_map_.end()) {
-    if (!IsAudioMonitorRunning(session)) {
+    if (!IsAudioMonitorRunning(session) &&
+        !IsRtpAudioLevelMonitorRunning(session)) {
       StartAudioMonitor(session, kAudioMonitorPollPeriodMillis);
     }
     CurrentSpeakerMonitor* speaker_monitor =
@@ -31,6 +31,7 @@
 #include "base/byteorder.h"
 #include "base/common.h"
 #include "base/logging.h"
+#include "base/timeutils.h"
 #include "media/base/rtputils.h"
 #include "p2p/base/transportchannel.h"
 #include "session/media/channelmanager.h"
@@ -78,6 +79,9 @@ enum {
   MSG_SETSCREENCASTFACTORY,
   MSG_FIRSTPACKETRECEIVED,
   MSG_SESSION_ERROR,
+  MSG_SETRTPAUDIOLEVELRATE,
+  MSG_RTPAUDIOLEVELS,
+  MSG_REPORTRTPAUDIOLEVELS,
 };
 
 // Value specified in RFC 5764.
@@ -140,6 +144,8 @@ struct PlayRingbackToneMessageData : public talk_base::MessageData {
   bool result;
 };
 typedef talk_base::TypedMessageData<bool> BoolMessageData;
+typedef talk_base::TypedMessageData<int> IntMessageData;
+typedef talk_base::TypedMessageData<AudioInfo> AudioInfoMessageData;
 struct DtmfMessageData : public talk_base::MessageData {
   DtmfMessageData(uint32 ssrc, int event, int duration, int flags)
       : ssrc(ssrc),
@@ -415,6 +421,8 @@ BaseChannel::BaseChannel(talk_base::Thread* thread,
       session_(session),
       media_channel_(media_channel),
       content_name_(content_name),
+      counters_(content_name),
+      rtp_audio_level_extension_id_(0),
       rtcp_(rtcp),
       transport_channel_(NULL),
       rtcp_transport_channel_(NULL),
@@ -655,6 +663,7 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
     LOG(LS_ERROR) << "Dropping outgoing " << content_name_ << " "
                   << PacketType(rtcp) << " packet: wrong size="
                   << packet->length();
+    counters_.OnPacketDiscarded();
     return false;
   }
 
@@ -679,6 +688,7 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
         LOG(LS_ERROR) << "Failed to protect " << content_name_
                       << " RTP packet: size=" << len
                       << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+        counters_.OnPacketDiscarded();
         return false;
       }
     } else {
@@ -688,6 +698,7 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
         GetRtcpType(data, len, &type);
         LOG(LS_ERROR) << "Failed to protect " << content_name_
                       << " RTCP packet: size=" << len << ", type=" << type;
+        counters_.OnPacketDiscarded();
         return false;
       }
     }
@@ -709,9 +720,13 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
   }
 
   // Bon voyage.
-  return (channel->SendPacket(packet->data(), packet->length(),
+  if (channel->SendPacket(packet->data(), packet->length(),
       (secure() && secure_dtls()) ? PF_SRTP_BYPASS : 0)
-      == static_cast<int>(packet->length()));
+      != static_cast<int>(packet->length())) {
+    return false;
+  }
+  counters_.OnPacketSent(packet->length(), rtcp);
+  return true;
 }
 
 void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
@@ -725,6 +740,7 @@ void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
     LOG(LS_ERROR) << "Dropping incoming " << content_name_ << " "
                   << PacketType(rtcp) << " packet: wrong size="
                   << packet->length();
+    counters_.OnPacketDiscarded();
     return;
   }
 
@@ -736,6 +752,10 @@ void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
     return;
   }
 
+  // Count the packet as it arrived on the wire, before SRTP is removed, so
+  // that the byte counts match the send side.
+  counters_.OnPacketReceived(packet->length(), rtcp);
+
   // Signal to the media sink before unprotecting the packet.
   {
     talk_base::CritScope cs(&signal_recv_packet_cs_);
@@ -757,6 +777,7 @@ void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
         LOG(LS_ERROR) << "Failed to unprotect " << content_name_
                       << " RTP packet: size=" << len
                       << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+        counters_.OnPacketDiscarded();
         return;
       }
     } else {
@@ -766,6 +787,7 @@ void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
         GetRtcpType(data, len, &type);
         LOG(LS_ERROR) << "Failed to unprotect " << content_name_
                       << " RTCP packet: size=" << len << ", type=" << type;
+        counters_.OnPacketDiscarded();
         return;
       }
     }
@@ -785,6 +807,18 @@ void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
     SignalRecvPacketPreCrypto(packet->data(), packet->length(), rtcp);
   }
 
+  // Pick up the sender's audio level without waiting for the decoder.
+  if (!rtcp && rtp_audio_level_extension_id_ != 0) {
+    uint32 ssrc;
+    int dbov;
+    bool voice;
+    if (GetRtpSsrc(packet->data(), packet->length(), &ssrc) &&
+        GetRtpAudioLevel(packet->data(), packet->length(),
+                         rtp_audio_level_extension_id_, &dbov, &voice)) {
+      OnRtpAudioLevel_w(ssrc, dbov);
+    }
+  }
+
   // Push it down to the media channel.
   if (!rtcp) {
     media_channel_->OnPacketReceived(packet);
@@ -1254,6 +1288,9 @@ bool BaseChannel::SetBaseLocalContent_w(const MediaContentDescription* content,
   if (content->rtp_header_extensions_set()) {
     ret &= media_channel()->SetRecvRtpHeaderExtensions(
         content->rtp_header_extensions());
+    const RtpHeaderExtension* audio_level = FindHeaderExtension(
+        content->rtp_header_extensions(), kRtpAudioLevelHeaderExtension);
+    rtp_audio_level_extension_id_ = audio_level ? audio_level->id : 0;
   }
   set_local_content_direction(content->direction());
   return ret;
@@ -1379,10 +1416,13 @@ VoiceChannel::VoiceChannel(talk_base::Thread* thread,
                            bool rtcp)
     : BaseChannel(thread, media_engine, media_channel, session, content_name,
                   rtcp),
-      received_media_(false) {
+      received_media_(false),
+      rtp_audio_level_monitoring_(false),
+      rtp_audio_level_rate_(0) {
 }
 
 VoiceChannel::~VoiceChannel() {
+  StopRtpAudioLevelMonitor();
   StopAudioMonitor();
   StopMediaMonitor();
   // this can't be done in the base class, since it calls a virtual
@@ -1498,6 +1538,24 @@ bool VoiceChannel::IsAudioMonitorRunning() const {
   return (audio_monitor_.get() != NULL);
 }
 
+void VoiceChannel::StartRtpAudioLevelMonitor(int cms) {
+  rtp_audio_level_monitoring_ = true;
+  IntMessageData data(cms);
+  Send(MSG_SETRTPAUDIOLEVELRATE, &data);
+}
+
+void VoiceChannel::StopRtpAudioLevelMonitor() {
+  if (rtp_audio_level_monitoring_) {
+    rtp_audio_level_monitoring_ = false;
+    IntMessageData data(0);
+    Send(MSG_SETRTPAUDIOLEVELRATE, &data);
+  }
+}
+
+bool VoiceChannel::IsRtpAudioLevelMonitorRunning() const {
+  return rtp_audio_level_monitoring_;
+}
+
 void VoiceChannel::StartTypingMonitor(const TypingMonitorOptions& settings) {
   typing_monitor_.reset(new TypingMonitor(this, worker_thread(), settings));
   SignalAutoMuted.repeat(typing_monitor_->SignalMuted);
@@ -1693,6 +1751,39 @@ bool VoiceChannel::SetChannelOptions_w(const AudioOptions& options) {
   return media_channel()->SetOptions(options);
 }
 
+void VoiceChannel::SetRtpAudioLevelRate_w(int cms) {
+  Clear(MSG_REPORTRTPAUDIOLEVELS);
+  rtp_audio_level_rate_ = cms;
+  rtp_audio_levels_.Clear();
+  if (rtp_audio_level_rate_ > 0) {
+    PostDelayed(rtp_audio_level_rate_, MSG_REPORTRTPAUDIOLEVELS);
+  }
+}
+
+void VoiceChannel::OnRtpAudioLevel_w(uint32 ssrc, int dbov) {
+  if (rtp_audio_level_rate_ > 0) {
+    rtp_audio_levels_.OnPacket(ssrc, dbov, talk_base::Time());
+  }
+}
+
+void VoiceChannel::ReportRtpAudioLevels_w() {
+  // The levels are tracked at packet rate, but reported on a timer at the
+  // rate of the polling audio monitor: listeners such as the
+  // CurrentSpeakerMonitor count updates to time their state changes, and
+  // need updates after every stream has gone quiet.
+  AudioInfoMessageData* data = new AudioInfoMessageData(AudioInfo());
+  AudioInfo& info = data->data();
+  info.input_level = 0;
+  info.output_level = 0;
+  rtp_audio_levels_.GetActiveStreams(talk_base::Time(), &info.active_streams);
+  for (size_t i = 0; i < info.active_streams.size(); ++i) {
+    info.output_level = talk_base::_max(info.output_level,
+                                        info.active_streams[i].second);
+  }
+  signaling_thread()->Post(this, MSG_RTPAUDIOLEVELS, data);
+  PostDelayed(rtp_audio_level_rate_, MSG_REPORTRTPAUDIOLEVELS);
+}
+
 void VoiceChannel::OnMessage(talk_base::Message *pmsg) {
   switch (pmsg->message_id) {
     case MSG_SETRINGBACKTONE: {
@@ -1748,6 +1839,21 @@ void VoiceChannel::OnMessage(talk_base::Message *pmsg) {
       data->result = SetChannelOptions_w(data->options);
       break;
     }
+    case MSG_SETRTPAUDIOLEVELRATE: {
+      IntMessageData* data = static_cast<IntMessageData*>(pmsg->pdata);
+      SetRtpAudioLevelRate_w(data->data());
+      break;
+    }
+    case MSG_REPORTRTPAUDIOLEVELS:
+      ReportRtpAudioLevels_w();
+      break;
+    case MSG_RTPAUDIOLEVELS: {
+      AudioInfoMessageData* data =
+          static_cast<AudioInfoMessageData*>(pmsg->pdata);
+      SignalAudioMonitor(this, data->data());
+      delete data;
+      break;
+    }
     default:
       BaseChannel::OnMessage(pmsg);
       break;
@@ -0,0 +1,114 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "session/media/channelstats.h"
+
+#include <algorithm>
+
+#include "base/common.h"
+#include "base/timeutils.h"
+
+namespace cricket {
+
+ChannelCounters::ChannelCounters(const std::string& content_name)
+    : content_name_(content_name),
+      bytes_sent_(0),
+      packets_sent_(0),
+      rtcp_packets_sent_(0),
+      bytes_rcvd_(0),
+      packets_rcvd_(0),
+      rtcp_packets_rcvd_(0),
+      packets_discarded_(0) {
+  ChannelStatsRegistry::Instance()->Register(this);
+}
+
+ChannelCounters::~ChannelCounters() {
+  ChannelStatsRegistry::Instance()->Unregister(this);
+}
+
+void ChannelCounters::set_content_name(const std::string& content_name) {
+  talk_base::CritScope cs(&ChannelStatsRegistry::Instance()->crit_);
+  content_name_ = content_name;
+}
+
+void ChannelCounters::GetSnapshot(ChannelStatsSnapshot* snapshot) const {
+  talk_base::CritScope cs(&ChannelStatsRegistry::Instance()->crit_);
+  GetSnapshot_l(talk_base::Time(), snapshot);
+}
+
+void ChannelCounters::GetSnapshot_l(uint32 now,
+                                    ChannelStatsSnapshot* snapshot) const {
+  snapshot->content_name = content_name_;
+  snapshot->timestamp = now;
+  snapshot->bytes_sent = Read(bytes_sent_);
+  snapshot->packets_sent = Read(packets_sent_);
+  snapshot->rtcp_packets_sent = Read(rtcp_packets_sent_);
+  snapshot->bytes_rcvd = Read(bytes_rcvd_);
+  snapshot->packets_rcvd = Read(packets_rcvd_);
+  snapshot->rtcp_packets_rcvd = Read(rtcp_packets_rcvd_);
+  snapshot->packets_discarded = Read(packets_discarded_);
+}
+
+ChannelStatsRegistry* ChannelStatsRegistry::Instance() {
+  LIBJINGLE_DEFINE_STATIC_LOCAL(ChannelStatsRegistry, registry, ());
+  return &registry;
+}
+
+void ChannelStatsRegistry::GetSnapshots(
+    std::vector<ChannelStatsSnapshot>* snapshots) const {
+  talk_base::CritScope cs(&crit_);
+  uint32 now = talk_base::Time();
+  size_t first = snapshots->size();
+  snapshots->resize(first + counters_.size());
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    counters_[i]->GetSnapshot_l(now, &(*snapshots)[first + i]);
+  }
+}
+
+size_t ChannelStatsRegistry::size() const {
+  talk_base::CritScope cs(&crit_);
+  return counters_.size();
+}
+
+void ChannelStatsRegistry::Register(ChannelCounters* counters) {
+  talk_base::CritScope cs(&crit_);
+  counters_.push_back(counters);
+}
+
+void ChannelStatsRegistry::Unregister(ChannelCounters* counters) {
+  talk_base::CritScope cs(&crit_);
+  std::vector<ChannelCounters*>::iterator it =
+      std::find(counters_.begin(), counters_.end(), counters);
+  ASSERT(it != counters_.end());
+  if (it != counters_.end()) {
+    // Order is not meaningful; swap with the back to keep removal O(1).
+    *it = counters_.back();
+    counters_.pop_back();
+  }
+}
+
+}  // namespace cricket
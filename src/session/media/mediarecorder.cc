@@ -28,28 +28,324 @@
 #include "session/media/mediarecorder.h"
 
 #include <limits.h>
+#include <string.h>
 
+#include <atomic>
 #include <string>
 
+#include "base/event.h"
 #include "base/fileutils.h"
 #include "base/logging.h"
 #include "base/pathutils.h"
+#include "base/stream.h"
+#include "base/thread.h"
+#include "base/timeutils.h"
 #include "media/base/rtpdump.h"
 
 
 namespace cricket {
 
+// How often the writer thread writes out what is queued, even if less than
+// AsyncRecordingOptions::write_size has accumulated.
+static const int kAsyncWriteIntervalMs = 100;
+// How long Flush() waits for the writer thread to catch up.
+static const int kAsyncFlushTimeoutMs = 1000;
+
+///////////////////////////////////////////////////////////////////////////
+// RtpPacketRing is a single-producer, single-consumer ring of variable
+// length packet records. The producer side is serialized by the sink's lock
+// and the consumer is the writer thread; neither ever waits for the other.
+///////////////////////////////////////////////////////////////////////////
+class RtpPacketRing {
+ public:
+  struct Record {
+    const char* data;
+    size_t length;
+    uint32 elapsed;
+    bool rtcp;
+    int filter;
+  };
+
+  explicit RtpPacketRing(size_t capacity)
+      : capacity_(AlignedCapacity(capacity)),
+        buffer_(new char[capacity_]),
+        write_pos_(0),
+        read_pos_(0),
+        front_size_(0) {
+  }
+
+  size_t capacity() const { return capacity_; }
+  size_t used() const {
+    return static_cast<size_t>(write_pos_.load(std::memory_order_acquire) -
+                               read_pos_.load(std::memory_order_acquire));
+  }
+
+  // Producer. Returns false, leaving the ring unchanged, if there is no room.
+  bool Push(const void* data, size_t length, uint32 elapsed, bool rtcp,
+            int filter) {
+    const size_t needed = RecordSize(length);
+    uint64 write = write_pos_.load(std::memory_order_relaxed);
+    const uint64 read = read_pos_.load(std::memory_order_acquire);
+    size_t offset = static_cast<size_t>(write % capacity_);
+    // A record never wraps; if it doesn't fit before the end of the buffer,
+    // the rest of the buffer is skipped.
+    const size_t to_end = capacity_ - offset;
+    const size_t skip = (to_end < needed) ? to_end : 0;
+    if (skip + needed > capacity_ - static_cast<size_t>(write - read)) {
+      return false;
+    }
+    if (skip) {
+      if (skip >= sizeof(Header)) {
+        const uint32 marker = kWrapMarker;
+        memcpy(buffer_.get() + offset, &marker, sizeof(marker));
+      }
+      write += skip;
+      offset = 0;
+    }
+    Header header;
+    header.length = static_cast<uint32>(length);
+    header.elapsed = elapsed;
+    header.rtcp = rtcp ? 1 : 0;
+    header.filter = static_cast<uint16>(filter);
+    memcpy(buffer_.get() + offset, &header, sizeof(header));
+    memcpy(buffer_.get() + offset + sizeof(header), data, length);
+    write_pos_.store(write + needed, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer. Gets the oldest record without removing it.
+  bool Front(Record* record) {
+    uint64 read = read_pos_.load(std::memory_order_relaxed);
+    const uint64 write = write_pos_.load(std::memory_order_acquire);
+    while (read != write) {
+      const size_t offset = static_cast<size_t>(read % capacity_);
+      const size_t to_end = capacity_ - offset;
+      Header header;
+      if (to_end >= sizeof(header)) {
+        memcpy(&header, buffer_.get() + offset, sizeof(header));
+      }
+      if (to_end < sizeof(header) || header.length == kWrapMarker) {
+        read += to_end;
+        read_pos_.store(read, std::memory_order_release);
+        continue;
+      }
+      record->data = buffer_.get() + offset + sizeof(header);
+      record->length = header.length;
+      record->elapsed = header.elapsed;
+      record->rtcp = (header.rtcp != 0);
+      record->filter = header.filter;
+      front_size_ = RecordSize(header.length);
+      return true;
+    }
+    return false;
+  }
+
+  // Consumer. Removes the record last returned by Front().
+  void Pop() {
+    ASSERT(front_size_ != 0);
+    read_pos_.store(read_pos_.load(std::memory_order_relaxed) + front_size_,
+                    std::memory_order_release);
+    front_size_ = 0;
+  }
+
+ private:
+  struct Header {
+    uint32 length;
+    uint32 elapsed;
+    uint16 rtcp;
+    uint16 filter;
+  };
+  static const size_t kAlignment = 4;
+  static const uint32 kWrapMarker = 0xFFFFFFFF;
+
+  static size_t AlignedCapacity(size_t capacity) {
+    const size_t aligned = capacity & ~(kAlignment - 1);
+    return aligned ? aligned : kAlignment;
+  }
+  static size_t RecordSize(size_t length) {
+    return (sizeof(Header) + length + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  const size_t capacity_;
+  talk_base::scoped_array<char> buffer_;
+  // Total bytes ever pushed and popped; the difference is what's queued.
+  // 64 bits even on 32-bit builds, since the capacity is not a power of two
+  // and the offsets would jump when a size_t wrapped.
+  std::atomic<uint64> write_pos_;
+  std::atomic<uint64> read_pos_;
+  size_t front_size_;  // Consumer only.
+
+  DISALLOW_COPY_AND_ASSIGN(RtpPacketRing);
+};
+
+///////////////////////////////////////////////////////////////////////////
+// RtpDumpSink::AsyncWriter owns the ring and the thread that drains it. The
+// dump is formatted into a memory buffer and written to the stream in
+// chunks of AsyncRecordingOptions::write_size.
+///////////////////////////////////////////////////////////////////////////
+class RtpDumpSink::AsyncWriter : public talk_base::Runnable {
+ public:
+  AsyncWriter(talk_base::StreamInterface* stream,
+              const AsyncRecordingOptions& options)
+      : stream_(stream),
+        options_(options),
+        ring_(options.ring_size),
+        writer_(&staging_),
+        filter_(PF_ALL),
+        start_time_ms_(talk_base::Time()),
+        wake_(false, false),
+        flushed_(false, false),
+        stopping_(false),
+        wake_pending_(false),
+        flush_requested_(false),
+        dropped_packets_(0),
+        congested_(false) {
+    writer_.set_packet_filter(filter_);
+  }
+
+  virtual ~AsyncWriter() {
+    // The thread writes out everything still queued before it exits.
+    stopping_.store(true);
+    wake_.Set();
+    thread_.Stop();
+  }
+
+  bool Start() {
+    if (options_.reserve_size && !stream_->ReserveSize(options_.reserve_size)) {
+      LOG(LS_WARNING) << "Failed to reserve " << options_.reserve_size
+                      << " bytes for the RTP dump.";
+    }
+    thread_.SetName("RtpDumpWriter", this);
+    return thread_.Start(this);
+  }
+
+  // Called with the sink's lock held. Never blocks on the writer thread.
+  bool Push(const void* data, size_t size, bool rtcp, int filter) {
+    if (!ring_.Push(data, size, talk_base::TimeSince(start_time_ms_), rtcp,
+                    filter)) {
+      dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+      if (!congested_) {
+        congested_ = true;
+        LOG(LS_WARNING) << "RTP dump can't keep up; dropping packets.";
+      }
+      WakeWriter();
+      return false;
+    }
+    congested_ = false;
+    if (ring_.used() >= options_.write_size) {
+      WakeWriter();
+    }
+    return true;
+  }
+
+  // Asks the thread to write out and flush the stream soon.
+  void RequestFlush() {
+    flushed_.Reset();
+    flush_requested_.store(true);
+    wake_.Set();
+  }
+
+  // Blocks until everything queued so far has reached the stream.
+  void Flush() {
+    RequestFlush();
+    if (!flushed_.Wait(kAsyncFlushTimeoutMs)) {
+      LOG(LS_WARNING) << "Timed out flushing the RTP dump.";
+    }
+  }
+
+  uint32 dropped_packets() const {
+    return dropped_packets_.load(std::memory_order_relaxed);
+  }
+
+  virtual void Run(talk_base::Thread* thread) {
+    while (!stopping_.load()) {
+      wake_.Wait(kAsyncWriteIntervalMs);
+      wake_pending_.store(false);
+      WriteQueued();
+      if (flush_requested_.exchange(false)) {
+        WriteStaging();
+        stream_->Flush();
+        flushed_.Set();
+      }
+    }
+    WriteQueued();
+    WriteStaging();
+    stream_->Flush();
+  }
+
+ private:
+  void WakeWriter() {
+    if (!wake_pending_.exchange(true)) {
+      wake_.Set();
+    }
+  }
+
+  // Formats the queued packets into |staging_|, writing it out whenever it
+  // reaches the write size.
+  void WriteQueued() {
+    RtpPacketRing::Record record;
+    while (ring_.Front(&record)) {
+      if (record.filter != filter_) {
+        filter_ = record.filter;
+        writer_.set_packet_filter(filter_);
+      }
+      writer_.WritePacket(record.data, record.length, record.elapsed,
+                          record.rtcp);
+      ring_.Pop();
+      size_t staged = 0;
+      if (staging_.GetPosition(&staged) && staged >= options_.write_size) {
+        WriteStaging();
+      }
+    }
+  }
+
+  void WriteStaging() {
+    size_t staged = 0;
+    if (!staging_.GetPosition(&staged) || staged == 0) {
+      return;
+    }
+    if (stream_->WriteAll(staging_.GetBuffer(), staged, NULL, NULL) !=
+        talk_base::SR_SUCCESS) {
+      LOG(LS_ERROR) << "Failed to write " << staged << " bytes of RTP dump.";
+    }
+    staging_.SetPosition(0);
+  }
+
+  talk_base::StreamInterface* stream_;
+  const AsyncRecordingOptions options_;
+  RtpPacketRing ring_;
+  talk_base::MemoryStream staging_;
+  RtpDumpWriter writer_;  // Writes into |staging_|.
+  int filter_;
+  uint32 start_time_ms_;
+  talk_base::Thread thread_;
+  talk_base::Event wake_;
+  talk_base::Event flushed_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> wake_pending_;
+  std::atomic<bool> flush_requested_;
+  std::atomic<uint32> dropped_packets_;
+  bool congested_;  // Producer only.
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncWriter);
+};
+
+
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of RtpDumpSink.
 ///////////////////////////////////////////////////////////////////////////
 RtpDumpSink::RtpDumpSink(talk_base::StreamInterface* stream)
     : max_size_(INT_MAX),
       recording_(false),
-      packet_filter_(PF_NONE) {
+      packet_filter_(PF_NONE),
+      queued_size_(0) {
   stream_.reset(stream);
 }
 
-RtpDumpSink::~RtpDumpSink() {}
+RtpDumpSink::~RtpDumpSink() {
+  // Let the writer thread finish before the stream goes away.
+  async_writer_.reset();
+}
 
 void RtpDumpSink::SetMaxSize(size_t size) {
   talk_base::CritScope cs(&critical_section_);
@@ -61,6 +357,26 @@ bool RtpDumpSink::Enable(bool enable) {
 
   recording_ = enable;
 
+  if (async_options_) {
+    // Start the writer thread if we have not done yet.
+    if (recording_ && !async_writer_) {
+      if (!stream_) {
+        return false;
+      }
+      async_writer_.reset(new AsyncWriter(stream_.get(), *async_options_));
+      queued_size_ = strlen(RtpDumpFileHeader::kFirstLine) +
+          RtpDumpFileHeader::kHeaderLength;
+      if (!async_writer_->Start()) {
+        async_writer_.reset();
+        return false;
+      }
+    } else if (!recording_ && async_writer_) {
+      // Don't wait here; OnPacket() would be stuck behind the lock.
+      async_writer_->RequestFlush();
+    }
+    return true;
+  }
+
   // Create a file and the RTP writer if we have not done yet.
   if (recording_ && !writer_) {
     if (!stream_) {
@@ -74,17 +390,42 @@ bool RtpDumpSink::Enable(bool enable) {
   return true;
 }
 
+bool RtpDumpSink::SetAsync(const AsyncRecordingOptions& options) {
+  talk_base::CritScope cs(&critical_section_);
+  if (writer_ || async_writer_ || options.write_size == 0) {
+    return false;
+  }
+  async_options_.reset(new AsyncRecordingOptions(options));
+  return true;
+}
+
+uint32 RtpDumpSink::dropped_packets() const {
+  talk_base::CritScope cs(&critical_section_);
+  return async_writer_ ? async_writer_->dropped_packets() : 0;
+}
+
 void RtpDumpSink::OnPacket(const void* data, size_t size, bool rtcp) {
   talk_base::CritScope cs(&critical_section_);
 
-  if (recording_ && writer_) {
+  if (recording_ && async_writer_) {
+    // Skip packets the filter would drop anyway rather than queue them.
+    const int wanted = rtcp ? PF_RTCPPACKET : PF_RTPHEADER;
+    if ((packet_filter_ & wanted) == 0 || size == 0) {
+      return;
+    }
+    // The stream position isn't known here, so the full packet is counted.
+    if (queued_size_ + RtpDumpPacket::kHeaderLength + size <= max_size_ &&
+        async_writer_->Push(data, size, rtcp, packet_filter_)) {
+      queued_size_ += RtpDumpPacket::kHeaderLength + size;
+    }
+  } else if (recording_ && writer_) {
     size_t current_size;
     if (writer_->GetDumpSize(&current_size) &&
         current_size + RtpDumpPacket::kHeaderLength + size <= max_size_) {
       if (!rtcp) {
         writer_->WriteRtpPacket(data, size);
       } else {
-        // TODO(whyuan): Enable recording RTCP.
+        writer_->WriteRtcpPacket(data, size);
       }
     }
   }
@@ -99,10 +440,19 @@ void RtpDumpSink::set_packet_filter(int filter) {
 }
 
 void RtpDumpSink::Flush() {
-  talk_base::CritScope cs(&critical_section_);
-  if (stream_) {
-    stream_->Flush();
+  AsyncWriter* async_writer = NULL;
+  {
+    talk_base::CritScope cs(&critical_section_);
+    if (!async_writer_) {
+      if (stream_) {
+        stream_->Flush();
+      }
+      return;
+    }
+    async_writer = async_writer_.get();
   }
+  // Wait without the lock, so that OnPacket() keeps queueing meanwhile.
+  async_writer->Flush();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -154,6 +504,10 @@ bool MediaRecorder::InternalAddChannel(BaseChannel* channel,
   sink_pair->send_sink->set_packet_filter(filter);
   sink_pair->recv_sink.reset(new RtpDumpSink(recv_stream));
   sink_pair->recv_sink->set_packet_filter(filter);
+  if (async_options_) {
+    sink_pair->send_sink->SetAsync(*async_options_);
+    sink_pair->recv_sink->SetAsync(*async_options_);
+  }
   sinks_[channel] = sink_pair;
 
   return true;
@@ -221,4 +575,27 @@ void MediaRecorder::FlushSinks() {
   }
 }
 
+void MediaRecorder::EnableAsyncRecording(
+    const AsyncRecordingOptions& options) {
+  talk_base::CritScope cs(&critical_section_);
+  async_options_.reset(new AsyncRecordingOptions(options));
+}
+
+bool MediaRecorder::GetDroppedPackets(BaseChannel* channel,
+                                      uint32* send_dropped,
+                                      uint32* recv_dropped) {
+  talk_base::CritScope cs(&critical_section_);
+  std::map<BaseChannel*, SinkPair*>::iterator itr = sinks_.find(channel);
+  if (sinks_.end() == itr) {
+    return false;
+  }
+  if (send_dropped) {
+    *send_dropped = itr->second->send_sink->dropped_packets();
+  }
+  if (recv_dropped) {
+    *recv_dropped = itr->second->recv_sink->dropped_packets();
+  }
+  return true;
+}
+
 }  // namespace cricket
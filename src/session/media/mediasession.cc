@@ -226,14 +226,12 @@ static bool GenerateCname(const StreamParamsVec& params_vec,
   return true;
 }
 
-// Generate random SSRC values that are not already present in |params_vec|.
-// Either 2 or 1 ssrcs will be generated based on |include_rtx_stream| being
-// true or false. The generated values are added to |ssrcs|.
+// Generate |num_ssrcs| random SSRC values that are not already present in
+// |params_vec|. The generated values are added to |ssrcs|.
 static void GenerateSsrcs(const StreamParamsVec& params_vec,
-                          bool include_rtx_stream,
+                          int num_ssrcs,
                           std::vector<uint32>& ssrcs) {
-  unsigned int num_ssrcs = include_rtx_stream ? 2 : 1;
-  for (unsigned int i = 0; i < num_ssrcs; i++) {
+  for (int i = 0; i < num_ssrcs; i++) {
     uint32 candidate;
     do {
       candidate = talk_base::CreateRandomNonZeroId();
@@ -394,7 +392,7 @@ static bool AddStreamParams(
   if (streams.empty() && add_legacy_stream) {
     // TODO(perkj): Remove this legacy stream when all apps use StreamParams.
     std::vector<uint32> ssrcs;
-    GenerateSsrcs(*current_streams, include_rtx_stream, ssrcs);
+    GenerateSsrcs(*current_streams, include_rtx_stream ? 2 : 1, ssrcs);
     if (include_rtx_stream) {
       content_description->AddLegacyStream(ssrcs[0], ssrcs[1]);
       content_description->set_multistream(true);
@@ -423,14 +421,23 @@ static bool AddStreamParams(
         return false;
       }
 
-      std::vector<uint32> ssrcs;
-      GenerateSsrcs(*current_streams, include_rtx_stream, ssrcs);
       StreamParams stream_param;
       stream_param.name = stream_it->name;
-      stream_param.ssrcs.push_back(ssrcs[0]);
-      if (include_rtx_stream) {
-        stream_param.AddFidSsrc(ssrcs[0], ssrcs[1]);
+      std::vector<uint32> ssrcs;
+      if (stream_it->num_sim_layers > 1) {
+        // One SSRC per simulcast layer. RTX is not offered for the layers.
+        GenerateSsrcs(*current_streams, stream_it->num_sim_layers, ssrcs);
+        stream_param.ssrcs = ssrcs;
+        stream_param.ssrc_groups.push_back(
+            SsrcGroup(kSimSsrcGroupSemantics, ssrcs));
         content_description->set_multistream(true);
+      } else {
+        GenerateSsrcs(*current_streams, include_rtx_stream ? 2 : 1, ssrcs);
+        stream_param.ssrcs.push_back(ssrcs[0]);
+        if (include_rtx_stream) {
+          stream_param.AddFidSsrc(ssrcs[0], ssrcs[1]);
+          content_description->set_multistream(true);
+        }
       }
       stream_param.cname = cname;
       stream_param.sync_label = stream_it->sync_label;
@@ -792,6 +799,14 @@ void MediaSessionOptions::AddStream(MediaType type,
     has_data = true;
 }
 
+void MediaSessionOptions::AddVideoStream(const std::string& name,
+                                         const std::string& sync_label,
+                                         int num_sim_layers) {
+  streams.push_back(Stream(MEDIA_TYPE_VIDEO, name, sync_label,
+                           num_sim_layers));
+  has_video = true;
+}
+
 void MediaSessionOptions::RemoveStream(MediaType type,
                                        const std::string& name) {
   Streams::iterator stream_it = streams.begin();
@@ -27,6 +27,8 @@
 
 #include "sound/alsasoundsystem.h"
 
+#include <string.h>
+
 #include "base/common.h"
 #include "base/logging.h"
 #include "base/scoped_ptr.h"
@@ -36,6 +38,7 @@
 #include "sound/sounddevicelocator.h"
 #include "sound/soundinputstreaminterface.h"
 #include "sound/soundoutputstreaminterface.h"
+#include "sound/soundringbuffer.h"
 
 namespace cricket {
 
@@ -253,9 +256,13 @@ class AlsaInputStream :
                   size_t frame_size,
                   int wait_timeout_ms,
                   int flags,
-                  int freq)
+                  int freq,
+                  size_t ring_size)
       : stream_(alsa, handle, frame_size, wait_timeout_ms, flags, freq),
         buffer_size_(0) {
+    if (ring_size > 0) {
+      ring_.reset(new SoundRingBuffer(ring_size));
+    }
   }
 
   virtual ~AlsaInputStream() {
@@ -290,6 +297,24 @@ class AlsaInputStream :
     return stream_.CurrentDelayUsecs();
   }
 
+  virtual size_t ReadSamples(void *buffer, size_t size) {
+    if (!ring_) {
+      return 0;
+    }
+    // An empty ring just means no new samples yet; capture can only overrun.
+    return ring_->Read(buffer, size);
+  }
+
+  virtual bool GetStats(SoundStreamStats *stats) {
+    if (!ring_) {
+      return false;
+    }
+    monitor_.GetStats(stats);
+    stats->buffered_bytes = ring_->Size();
+    stats->capacity_bytes = ring_->capacity();
+    return true;
+  }
+
  private:
   // Inherited from Worker.
   virtual void OnStart() {
@@ -320,6 +345,12 @@ class AlsaInputStream :
         // Docs say this shouldn't happen.
         ASSERT(false);
         LOG(LS_ERROR) << "No data?";
+      } else if (ring_) {
+        // The consumer picks the data up with ReadSamples().
+        monitor_.OnCallback(talk_base::SystemTimeNanos());
+        if (!ring_->Write(buffer_.get(), read * stream_.frame_size())) {
+          monitor_.OnOverrun();
+        }
       } else {
         // Got data. Pass it off to the app.
         SignalSamplesRead(buffer_.get(),
@@ -344,6 +375,9 @@ class AlsaInputStream :
   AlsaStream stream_;
   talk_base::scoped_array<char> buffer_;
   size_t buffer_size_;
+  // Only used with FLAG_RING_BUFFER.
+  talk_base::scoped_ptr<SoundRingBuffer> ring_;
+  SoundStreamMonitor monitor_;
 
   DISALLOW_COPY_AND_ASSIGN(AlsaInputStream);
 };
@@ -359,8 +393,14 @@ class AlsaOutputStream :
                    size_t frame_size,
                    int wait_timeout_ms,
                    int flags,
-                   int freq)
-      : stream_(alsa, handle, frame_size, wait_timeout_ms, flags, freq) {
+                   int freq,
+                   size_t ring_size)
+      : stream_(alsa, handle, frame_size, wait_timeout_ms, flags, freq),
+        buffer_size_(0),
+        ring_started_(false) {
+    if (ring_size > 0) {
+      ring_.reset(new SoundRingBuffer(ring_size));
+    }
   }
 
   virtual ~AlsaOutputStream() {
@@ -387,22 +427,15 @@ class AlsaOutputStream :
       LOG(LS_ERROR) << "Writes with fractional frames are not supported";
       return false;
     }
-    snd_pcm_uframes_t frames = size / stream_.frame_size();
-    snd_pcm_sframes_t written = stream_.symbol_table()->snd_pcm_writei()(
-        stream_.handle(),
-        sample_data,
-        frames);
-    if (written < 0) {
-      LOG(LS_ERROR) << "snd_pcm_writei(): " << GetError(written);
-      stream_.Recover(written);
-      return false;
-    } else if (static_cast<snd_pcm_uframes_t>(written) < frames) {
-      // Shouldn't happen. Drop the rest of the data.
-      LOG(LS_ERROR) << "Stream wrote only " << written << " of " << frames
-                    << " frames!";
-      return false;
+    if (ring_) {
+      // The worker thread writes it to the device when there is space.
+      if (!ring_->Write(sample_data, size)) {
+        monitor_.OnOverrun();
+        return false;
+      }
+      return true;
     }
-    return true;
+    return WriteFrames(sample_data, size / stream_.frame_size());
   }
 
   virtual bool GetVolume(int *volume) {
@@ -423,7 +456,59 @@ class AlsaOutputStream :
     return stream_.CurrentDelayUsecs();
   }
 
+  virtual bool GetStats(SoundStreamStats *stats) {
+    if (!ring_) {
+      return false;
+    }
+    monitor_.GetStats(stats);
+    stats->buffered_bytes = ring_->Size();
+    stats->capacity_bytes = ring_->capacity();
+    return true;
+  }
+
  private:
+  bool WriteFrames(const void *sample_data, snd_pcm_uframes_t frames) {
+    snd_pcm_sframes_t written = stream_.symbol_table()->snd_pcm_writei()(
+        stream_.handle(),
+        sample_data,
+        frames);
+    if (written < 0) {
+      LOG(LS_ERROR) << "snd_pcm_writei(): " << GetError(written);
+      stream_.Recover(written);
+      return false;
+    } else if (static_cast<snd_pcm_uframes_t>(written) < frames) {
+      // Shouldn't happen. Drop the rest of the data.
+      LOG(LS_ERROR) << "Stream wrote only " << written << " of " << frames
+                    << " frames!";
+      return false;
+    }
+    return true;
+  }
+
+  // Fills all of |space| from the ring so that the device never starves;
+  // whatever the ring can't supply is played as silence. The ring only ever
+  // holds whole frames, so the read does too.
+  void WriteFromRing(size_t space) {
+    monitor_.OnCallback(talk_base::SystemTimeNanos());
+    if (space > buffer_size_) {
+      // Must increase buffer size.
+      buffer_.reset(new char[space]);
+      buffer_size_ = space;
+    }
+    size_t read = ring_->Read(buffer_.get(), space);
+    if (read < space) {
+      // Silence before the first samples arrive is not an underrun.
+      if (ring_started_) {
+        monitor_.OnUnderrun();
+      }
+      memset(buffer_.get() + read, 0, space - read);
+    }
+    if (read > 0) {
+      ring_started_ = true;
+    }
+    WriteFrames(buffer_.get(), space / stream_.frame_size());
+  }
+
   // Inherited from Worker.
   virtual void OnStart() {
     HaveWork();
@@ -434,7 +519,11 @@ class AlsaOutputStream :
     snd_pcm_uframes_t avail = stream_.Wait();
     if (avail > 0) {
       size_t space = avail * stream_.frame_size();
-      SignalBufferSpace(space, this);
+      if (ring_) {
+        WriteFromRing(space);
+      } else {
+        SignalBufferSpace(space, this);
+      }
     }
     HaveWork();
   }
@@ -449,6 +538,13 @@ class AlsaOutputStream :
   }
 
   AlsaStream stream_;
+  // Only used with FLAG_RING_BUFFER.
+  talk_base::scoped_ptr<SoundRingBuffer> ring_;
+  SoundStreamMonitor monitor_;
+  // Worker thread only.
+  talk_base::scoped_array<char> buffer_;
+  size_t buffer_size_;
+  bool ring_started_;
 
   DISALLOW_COPY_AND_ASSIGN(AlsaOutputStream);
 };
@@ -639,7 +735,8 @@ StreamInterface *AlsaSoundSystem::OpenDevice(
         size_t frame_size,
         int wait_timeout_ms,
         int flags,
-        int freq)) {
+        int freq,
+        size_t ring_size)) {
 
   if (!IsInitialized()) {
     return NULL;
@@ -710,7 +807,8 @@ StreamInterface *AlsaSoundSystem::OpenDevice(
       // timeouts should be rare.
       2 * latency / talk_base::kNumMicrosecsPerMillisec,
       params.flags,
-      params.freq);
+      params.freq,
+      RingBufferSize(params));
   if (stream) {
     return stream;
   }
@@ -729,10 +827,11 @@ SoundOutputStreamInterface *AlsaSoundSystem::StartOutputStream(
     size_t frame_size,
     int wait_timeout_ms,
     int flags,
-    int freq) {
+    int freq,
+    size_t ring_size) {
   // Nothing to do here but instantiate the stream.
   return new AlsaOutputStream(
-      this, handle, frame_size, wait_timeout_ms, flags, freq);
+      this, handle, frame_size, wait_timeout_ms, flags, freq, ring_size);
 }
 
 SoundInputStreamInterface *AlsaSoundSystem::StartInputStream(
@@ -740,7 +839,8 @@ SoundInputStreamInterface *AlsaSoundSystem::StartInputStream(
     size_t frame_size,
     int wait_timeout_ms,
     int flags,
-    int freq) {
+    int freq,
+    size_t ring_size) {
   // Output streams start automatically once enough data has been written, but
   // input streams must be started manually or else snd_pcm_wait() will never
   // return true.
@@ -751,7 +851,7 @@ SoundInputStreamInterface *AlsaSoundSystem::StartInputStream(
     return NULL;
   }
   return new AlsaInputStream(
-      this, handle, frame_size, wait_timeout_ms, flags, freq);
+      this, handle, frame_size, wait_timeout_ms, flags, freq, ring_size);
 }
 
 inline const char *AlsaSoundSystem::GetError(int err) {
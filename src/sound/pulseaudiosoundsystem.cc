@@ -29,6 +29,10 @@
 
 #ifdef HAVE_LIBPULSE
 
+#include <string.h>
+
+#include <vector>
+
 #include "base/common.h"
 #include "base/fileutils.h"  // for GetApplicationName()
 #include "base/logging.h"
@@ -37,6 +41,7 @@
 #include "sound/sounddevicelocator.h"
 #include "sound/soundinputstreaminterface.h"
 #include "sound/soundoutputstreaminterface.h"
+#include "sound/soundringbuffer.h"
 
 namespace cricket {
 
@@ -244,10 +249,14 @@ class PulseAudioInputStream :
  public:
   PulseAudioInputStream(PulseAudioSoundSystem *pulse,
                         pa_stream *stream,
-                        int flags)
+                        int flags,
+                        size_t ring_size)
       : stream_(pulse, stream, flags),
         temp_sample_data_(NULL),
         temp_sample_data_size_(0) {
+    if (ring_size > 0) {
+      ring_.reset(new SoundRingBuffer(ring_size));
+    }
     // This callback seems to never be issued, but let's set it anyways.
     symbol_table()->pa_stream_set_overflow_callback()(stream, &OverflowCallback,
         NULL);
@@ -260,10 +269,25 @@ class PulseAudioInputStream :
   }
 
   virtual bool StartReading() {
+    if (ring_) {
+      // The mainloop thread fills the ring directly; no worker is needed.
+      Lock();
+      EnableReadCallback();
+      Unlock();
+      return true;
+    }
     return StartWork();
   }
 
   virtual bool StopReading() {
+    if (ring_) {
+      if (!stream_.IsClosed()) {
+        Lock();
+        DisableReadCallback();
+        Unlock();
+      }
+      return true;
+    }
     return StopWork();
   }
 
@@ -399,6 +423,24 @@ class PulseAudioInputStream :
     return stream_.LatencyUsecs();
   }
 
+  virtual size_t ReadSamples(void *buffer, size_t size) {
+    if (!ring_) {
+      return 0;
+    }
+    // An empty ring just means no new samples yet; capture can only overrun.
+    return ring_->Read(buffer, size);
+  }
+
+  virtual bool GetStats(SoundStreamStats *stats) {
+    if (!ring_) {
+      return false;
+    }
+    monitor_.GetStats(stats);
+    stats->buffered_bytes = ring_->Size();
+    stats->capacity_bytes = ring_->capacity();
+    return true;
+  }
+
  private:
   void Lock() {
     stream_.Lock();
@@ -435,6 +477,10 @@ class PulseAudioInputStream :
   }
 
   void OnReadCallback() {
+    if (ring_) {
+      ReadIntoRing();
+      return;
+    }
     // We get the data pointer and size now in order to save one Lock/Unlock
     // on OnMessage.
     if (symbol_table()->pa_stream_peek()(stream_.stream(),
@@ -450,6 +496,35 @@ class PulseAudioInputStream :
     HaveWork();
   }
 
+  // Called on the mainloop thread, which holds the lock. Moves everything
+  // that is readable into the ring, so the read callback stays enabled and
+  // never waits for the consumer.
+  void ReadIntoRing() {
+    monitor_.OnCallback(talk_base::SystemTimeNanos());
+    while (symbol_table()->pa_stream_readable_size()(stream_.stream()) > 0) {
+      const void *sample_data;
+      size_t sample_data_size;
+      if (symbol_table()->pa_stream_peek()(stream_.stream(),
+                                           &sample_data,
+                                           &sample_data_size) != 0) {
+        LOG(LS_ERROR) << "Can't read data!";
+        return;
+      }
+      if (sample_data_size == 0) {
+        break;
+      }
+      // A NULL pointer with a size is a hole in the stream, which only needs
+      // to be dropped.
+      if (sample_data && !ring_->Write(sample_data, sample_data_size)) {
+        monitor_.OnOverrun();
+      }
+      if (symbol_table()->pa_stream_drop()(stream_.stream()) != 0) {
+        LOG(LS_ERROR) << "Can't ack read data";
+        return;
+      }
+    }
+  }
+
   // Inherited from Worker.
   virtual void OnStart() {
     Lock();
@@ -585,6 +660,9 @@ class PulseAudioInputStream :
   // Temporary storage for passing data between threads.
   const void *temp_sample_data_;
   size_t temp_sample_data_size_;
+  // Only used with FLAG_RING_BUFFER.
+  talk_base::scoped_ptr<SoundRingBuffer> ring_;
+  SoundStreamMonitor monitor_;
 
   DISALLOW_COPY_AND_ASSIGN(PulseAudioInputStream);
 };
@@ -604,10 +682,15 @@ class PulseAudioOutputStream :
   PulseAudioOutputStream(PulseAudioSoundSystem *pulse,
                          pa_stream *stream,
                          int flags,
-                         int latency)
+                         int latency,
+                         size_t ring_size)
       : stream_(pulse, stream, flags),
         configured_latency_(latency),
-        temp_buffer_space_(0) {
+        temp_buffer_space_(0),
+        ring_started_(false) {
+    if (ring_size > 0) {
+      ring_.reset(new SoundRingBuffer(ring_size));
+    }
     symbol_table()->pa_stream_set_underflow_callback()(stream,
                                                        &UnderflowCallbackThunk,
                                                        this);
@@ -620,15 +703,37 @@ class PulseAudioOutputStream :
   }
 
   virtual bool EnableBufferMonitoring() {
+    if (ring_) {
+      // The mainloop thread drains the ring directly; no worker is needed.
+      Lock();
+      EnableRingWriteCallback();
+      Unlock();
+      return true;
+    }
     return StartWork();
   }
 
   virtual bool DisableBufferMonitoring() {
+    if (ring_) {
+      if (!stream_.IsClosed()) {
+        Lock();
+        DisableWriteCallback();
+        Unlock();
+      }
+      return true;
+    }
     return StopWork();
   }
 
   virtual bool WriteSamples(const void *sample_data,
                             size_t size) {
+    if (ring_) {
+      if (!ring_->Write(sample_data, size)) {
+        monitor_.OnOverrun();
+        return false;
+      }
+      return true;
+    }
     bool ret = true;
     Lock();
     if (symbol_table()->pa_stream_write()(stream_.stream(),
@@ -746,6 +851,16 @@ class PulseAudioOutputStream :
     return stream_.LatencyUsecs();
   }
 
+  virtual bool GetStats(SoundStreamStats *stats) {
+    if (!ring_) {
+      return false;
+    }
+    monitor_.GetStats(stats);
+    stats->buffered_bytes = ring_->Size();
+    stats->capacity_bytes = ring_->capacity();
+    return true;
+  }
+
 #if 0
   // TODO: Versions 0.9.16 and later of Pulse have a new API for
   // zero-copy writes, but Hardy is not new enough to have that so we can't
@@ -839,6 +954,60 @@ class PulseAudioOutputStream :
     instance->OnWriteCallback(buffer_space);
   }
 
+  void EnableRingWriteCallback() {
+    symbol_table()->pa_stream_set_write_callback()(
+         stream_.stream(),
+         &RingWriteCallbackThunk,
+         this);
+    pa_stream_state_t state = symbol_table()->pa_stream_get_state()(
+        stream_.stream());
+    if (state == PA_STREAM_READY) {
+      // As above, space that is already available won't trigger a callback.
+      size_t buffer_space = symbol_table()->pa_stream_writable_size()(
+          stream_.stream());
+      if (buffer_space > 0) {
+        WriteFromRing(buffer_space);
+      }
+    }
+  }
+
+  static void RingWriteCallbackThunk(pa_stream *unused,
+                                     size_t buffer_space,
+                                     void *userdata) {
+    PulseAudioOutputStream *instance =
+        static_cast<PulseAudioOutputStream *>(userdata);
+    instance->WriteFromRing(buffer_space);
+  }
+
+  // Called on the mainloop thread, which holds the lock. Always fills all of
+  // |buffer_space| so that Pulse keeps calling back at the device rate;
+  // whatever the ring can't supply is played as silence.
+  void WriteFromRing(size_t buffer_space) {
+    monitor_.OnCallback(talk_base::SystemTimeNanos());
+    if (ring_buffer_.size() < buffer_space) {
+      ring_buffer_.resize(buffer_space);
+    }
+    size_t read = ring_->Read(&ring_buffer_[0], buffer_space);
+    if (read < buffer_space) {
+      // Silence before the first samples arrive is not an underrun.
+      if (ring_started_) {
+        monitor_.OnUnderrun();
+      }
+      memset(&ring_buffer_[read], 0, buffer_space - read);
+    }
+    if (read > 0) {
+      ring_started_ = true;
+    }
+    if (symbol_table()->pa_stream_write()(stream_.stream(),
+                                          &ring_buffer_[0],
+                                          buffer_space,
+                                          NULL,
+                                          0,
+                                          PA_SEEK_RELATIVE) != 0) {
+      LOG(LS_ERROR) << "Unable to write";
+    }
+  }
+
   void OnWriteCallback(size_t buffer_space) {
     temp_buffer_space_ = buffer_space;
     // Since we write the data asynchronously on a different thread, we have
@@ -969,6 +1138,12 @@ class PulseAudioOutputStream :
   int configured_latency_;
   // Temporary storage for passing data between threads.
   size_t temp_buffer_space_;
+  // Only used with FLAG_RING_BUFFER.
+  talk_base::scoped_ptr<SoundRingBuffer> ring_;
+  SoundStreamMonitor monitor_;
+  // Mainloop thread only.
+  std::vector<char> ring_buffer_;
+  bool ring_started_;
 
   DISALLOW_COPY_AND_ASSIGN(PulseAudioOutputStream);
 };
@@ -1379,6 +1554,7 @@ StreamInterface *PulseAudioSoundSystem::OpenDevice(
         int flags,
         pa_stream_flags_t pa_flags,
         int latency,
+        size_t ring_size,
         const pa_sample_spec &spec)) {
   if (!IsInitialized()) {
     return NULL;
@@ -1434,6 +1610,7 @@ StreamInterface *PulseAudioSoundSystem::OpenDevice(
       params.flags,
       static_cast<pa_stream_flags_t>(pa_flags),
       params.latency,
+      RingBufferSize(params),
       spec);
   if (!stream_interface) {
     LOG(LS_ERROR) << "Can't connect stream to " << dev;
@@ -1452,6 +1629,7 @@ SoundOutputStreamInterface *PulseAudioSoundSystem::ConnectOutputStream(
     int flags,
     pa_stream_flags_t pa_flags,
     int latency,
+    size_t ring_size,
     const pa_sample_spec &spec) {
   pa_buffer_attr attr = {0};
   pa_buffer_attr *pattr = NULL;
@@ -1477,7 +1655,8 @@ SoundOutputStreamInterface *PulseAudioSoundSystem::ConnectOutputStream(
           NULL) != 0) {
     return NULL;
   }
-  return new PulseAudioOutputStream(this, stream, flags, latency);
+  return new PulseAudioOutputStream(this, stream, flags, latency,
+                                    ring_size);
 }
 
 // Must be called with the lock held.
@@ -1487,6 +1666,7 @@ SoundInputStreamInterface *PulseAudioSoundSystem::ConnectInputStream(
     int flags,
     pa_stream_flags_t pa_flags,
     int latency,
+    size_t ring_size,
     const pa_sample_spec &spec) {
   pa_buffer_attr attr = {0};
   pa_buffer_attr *pattr = NULL;
@@ -1511,7 +1691,7 @@ SoundInputStreamInterface *PulseAudioSoundSystem::ConnectInputStream(
                                                pa_flags) != 0) {
     return NULL;
   }
-  return new PulseAudioInputStream(this, stream, flags);
+  return new PulseAudioInputStream(this, stream, flags, ring_size);
 }
 
 // Must be called with the lock held.
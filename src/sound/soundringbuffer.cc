@@ -0,0 +1,147 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sound/soundringbuffer.h"
+
+#include <string.h>
+
+#include "base/common.h"
+#include "base/timeutils.h"
+
+namespace cricket {
+
+// Smoothing of the callback interval and jitter: each callback moves the
+// estimate by 1/16 of the error.
+static const int kSmoothingShift = 4;
+
+SoundRingBuffer::SoundRingBuffer(size_t capacity)
+    : capacity_(capacity),
+      buffer_(new char[capacity]),
+      write_pos_(0),
+      read_pos_(0) {
+  ASSERT(capacity_ > 0);
+}
+
+size_t SoundRingBuffer::Size() const {
+  return static_cast<size_t>(write_pos_.load(std::memory_order_acquire) -
+                             read_pos_.load(std::memory_order_acquire));
+}
+
+size_t SoundRingBuffer::Space() const {
+  return capacity_ - Size();
+}
+
+bool SoundRingBuffer::Write(const void *data, size_t size) {
+  const uint64 write_pos = write_pos_.load(std::memory_order_relaxed);
+  const uint64 read_pos = read_pos_.load(std::memory_order_acquire);
+  if (size > capacity_ - static_cast<size_t>(write_pos - read_pos)) {
+    return false;
+  }
+  const size_t offset = static_cast<size_t>(write_pos % capacity_);
+  const size_t first = talk_base::_min(size, capacity_ - offset);
+  memcpy(buffer_.get() + offset, data, first);
+  memcpy(buffer_.get(), static_cast<const char *>(data) + first, size - first);
+  // Publish the bytes only after they are in place.
+  write_pos_.store(write_pos + size, std::memory_order_release);
+  return true;
+}
+
+size_t SoundRingBuffer::Read(void *data, size_t size) {
+  const uint64 read_pos = read_pos_.load(std::memory_order_relaxed);
+  const uint64 write_pos = write_pos_.load(std::memory_order_acquire);
+  size = talk_base::_min(size, static_cast<size_t>(write_pos - read_pos));
+  const size_t offset = static_cast<size_t>(read_pos % capacity_);
+  const size_t first = talk_base::_min(size, capacity_ - offset);
+  memcpy(data, buffer_.get() + offset, first);
+  memcpy(static_cast<char *>(data) + first, buffer_.get(), size - first);
+  // Hand the space back only after the bytes have been copied out.
+  read_pos_.store(read_pos + size, std::memory_order_release);
+  return size;
+}
+
+SoundStreamMonitor::SoundStreamMonitor()
+    : callbacks_(0),
+      underruns_(0),
+      overruns_(0),
+      mean_interval_usecs_(0),
+      max_interval_usecs_(0),
+      jitter_usecs_(0),
+      last_callback_ns_(0),
+      last_interval_usecs_(-1),
+      mean_interval_q4_(0),
+      jitter_q4_(0) {
+}
+
+void SoundStreamMonitor::OnCallback(uint64 now_ns) {
+  const uint64 callbacks = callbacks_.load(std::memory_order_relaxed);
+  callbacks_.store(callbacks + 1, std::memory_order_relaxed);
+  if (callbacks == 0) {
+    last_callback_ns_ = now_ns;
+    return;
+  }
+  const int interval = static_cast<int>(
+      (now_ns - last_callback_ns_) / talk_base::kNumNanosecsPerMicrosec);
+  last_callback_ns_ = now_ns;
+  if (last_interval_usecs_ < 0) {
+    // The first interval seeds the mean.
+    mean_interval_q4_ = interval << kSmoothingShift;
+  } else {
+    mean_interval_q4_ += interval - (mean_interval_q4_ >> kSmoothingShift);
+    const int delta = interval > last_interval_usecs_ ?
+        interval - last_interval_usecs_ : last_interval_usecs_ - interval;
+    jitter_q4_ += delta - (jitter_q4_ >> kSmoothingShift);
+  }
+  last_interval_usecs_ = interval;
+  mean_interval_usecs_.store(mean_interval_q4_ >> kSmoothingShift,
+                             std::memory_order_relaxed);
+  jitter_usecs_.store(jitter_q4_ >> kSmoothingShift,
+                      std::memory_order_relaxed);
+  if (interval > max_interval_usecs_.load(std::memory_order_relaxed)) {
+    max_interval_usecs_.store(interval, std::memory_order_relaxed);
+  }
+}
+
+void SoundStreamMonitor::OnUnderrun() {
+  underruns_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SoundStreamMonitor::OnOverrun() {
+  overruns_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SoundStreamMonitor::GetStats(SoundStreamStats *stats) const {
+  stats->callbacks = callbacks_.load(std::memory_order_relaxed);
+  stats->underruns = underruns_.load(std::memory_order_relaxed);
+  stats->overruns = overruns_.load(std::memory_order_relaxed);
+  stats->mean_callback_interval_usecs =
+      mean_interval_usecs_.load(std::memory_order_relaxed);
+  stats->max_callback_interval_usecs =
+      max_interval_usecs_.load(std::memory_order_relaxed);
+  stats->callback_jitter_usecs = jitter_usecs_.load(std::memory_order_relaxed);
+}
+
+}  // namespace cricket
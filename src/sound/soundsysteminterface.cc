@@ -27,6 +27,7 @@
 
 #include "sound/soundsysteminterface.h"
 
+#include "base/basictypes.h"
 #include "sound/sounddevicelocator.h"
 
 namespace cricket {
@@ -43,4 +44,16 @@ void SoundSystemInterface::ClearSoundDeviceLocatorList(
   devices->clear();
 }
 
+size_t SoundSystemInterface::RingBufferSize(const OpenParams &params) {
+  if (!(params.flags & FLAG_RING_BUFFER)) {
+    return 0;
+  }
+  if (params.ring_buffer_size > 0) {
+    return params.ring_buffer_size;
+  }
+  // Only FORMAT_S16LE exists, so a sample is two bytes.
+  return params.freq * params.channels * sizeof(int16) *
+      kDefaultRingBufferMsecs / 1000;
+}
+
 }  // namespace cricket
@@ -133,4 +133,27 @@ TEST(StatsCollector, BytesCounterHandles64Bits) {
   EXPECT_EQ(kBytesSentString, result);
 }
 
+// Value names are interned so they can be matched by pointer; names built at
+// runtime must resolve to the predefined constants.
+TEST(StatsCollector, ValueNamesAreInterned) {
+  EXPECT_EQ(webrtc::StatsElement::kStatsValueNameBytesSent,
+            webrtc::StatsElement::InternName("bytesSent"));
+  const char* custom = webrtc::StatsElement::InternName("customName");
+  EXPECT_EQ(custom, webrtc::StatsElement::InternName(std::string("customName")));
+
+  webrtc::StatsElement element;
+  element.AddValue(std::string("bytesSent"), 42);
+  element.AddValue(custom, "value");
+  const webrtc::StatsElement::Value* value =
+      element.FindValue(webrtc::StatsElement::kStatsValueNameBytesSent);
+  ASSERT_TRUE(value != NULL);
+  EXPECT_TRUE(value->has_int_value);
+  EXPECT_EQ(42, value->int_value);
+  EXPECT_EQ("42", value->value);
+  value = element.FindValue(custom);
+  ASSERT_TRUE(value != NULL);
+  EXPECT_FALSE(value->has_int_value);
+  EXPECT_EQ("value", value->value);
+}
+
 }  // namespace
@@ -38,6 +38,7 @@
 #include "base/sslfingerprint.h"
 #include "base/stringencode.h"
 #include "base/stringutils.h"
+#include "base/timeutils.h"
 #include "media/base/constants.h"
 #include "p2p/base/constants.h"
 #include "session/media/mediasession.h"
@@ -1800,3 +1801,57 @@ TEST_F(WebRtcSdpTest, SerializeVideoFmtp) {
               &sdp_with_fmtp);
   EXPECT_EQ(sdp_with_fmtp, message);
 }
+
+// Times serializing and parsing a description shaped like a large
+// conference offer: many ssrcs per m line and a long candidate list.
+TEST_F(WebRtcSdpTest, SerializeAndDeserializeLargeSdpPerformance) {
+  const int kNumStreams = 64;
+  const int kNumCandidates = 64;
+  const int kIterations = 100;
+
+  VideoContentDescription* vcd = static_cast<VideoContentDescription*>(
+      GetFirstVideoContent(&desc_)->description);
+  for (int i = 0; i < kNumStreams; ++i) {
+    StreamParams stream;
+    stream.name = "video_track_" + talk_base::ToString(i);
+    stream.cname = kStream1Cname;
+    stream.sync_label = kStreamLabel1;
+    stream.ssrcs.push_back(1000 + i);
+    vcd->AddStream(stream);
+  }
+  ASSERT_TRUE(jdesc_.Initialize(desc_.Copy(),
+                                jdesc_.session_id(),
+                                jdesc_.session_version()));
+  for (int i = 0; i < kNumCandidates; ++i) {
+    talk_base::SocketAddress address("10.0.0.1", 10000 + i);
+    Candidate candidate(
+        "", ICE_CANDIDATE_COMPONENT_RTP, "udp", address, kCandidatePriority,
+        "", "", LOCAL_PORT_TYPE, "", kCandidateGeneration,
+        kCandidateFoundation1);
+    JsepIceCandidate jice(kVideoContentName, 1, candidate);
+    ASSERT_TRUE(jdesc_.AddCandidate(&jice));
+  }
+
+  const std::string message = webrtc::SdpSerialize(jdesc_);
+  JsepSessionDescription jdesc_output(kDummyString);
+  ASSERT_TRUE(SdpDeserialize(message, &jdesc_output));
+  EXPECT_TRUE(CompareSessionDescription(jdesc_, jdesc_output));
+
+  uint32 start = talk_base::Time();
+  for (int i = 0; i < kIterations; ++i) {
+    std::string sdp = webrtc::SdpSerialize(jdesc_);
+    EXPECT_EQ(message.size(), sdp.size());
+  }
+  const uint32 serialize_ms = talk_base::TimeSince(start);
+
+  start = talk_base::Time();
+  for (int i = 0; i < kIterations; ++i) {
+    JsepSessionDescription jdesc(kDummyString);
+    EXPECT_TRUE(webrtc::SdpDeserialize(message, &jdesc, NULL));
+  }
+  const uint32 deserialize_ms = talk_base::TimeSince(start);
+
+  LOG(LS_INFO) << kIterations << " x " << message.size() << " byte SDP: "
+               << "serialize " << serialize_ms << " ms, "
+               << "deserialize " << deserialize_ms << " ms";
+}
@@ -0,0 +1,214 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+
+#include "base/diskcache.h"
+#include "base/fileutils.h"
+#include "base/gunit.h"
+#include "base/pathutils.h"
+#include "base/scoped_ptr.h"
+#include "base/stream.h"
+
+namespace talk_base {
+
+// DiskCache over the portable Filesystem calls, counting folder scans.
+class TestDiskCache : public DiskCache {
+ public:
+  TestDiskCache() : scans_(0) {}
+
+  int scans() const { return scans_; }
+
+ protected:
+  virtual bool InitializeEntries() {
+    ++scans_;
+    DirectoryIterator it;
+    if (!it.Iterate(Pathname(folder_)))
+      return true;
+    do {
+      size_t index;
+      std::string id;
+      if (it.IsDirectory() || !FilenameToId(it.Name(), &id, &index))
+        continue;
+      Entry* entry = GetOrCreateEntry(id, true);
+      entry->size += it.FileSize();
+      total_size_ += it.FileSize();
+      entry->streams = _max(entry->streams, index + 1);
+      entry->last_modified = it.FileModifyTime();
+    } while (it.Next());
+    return true;
+  }
+  virtual bool PurgeFiles() {
+    return Filesystem::DeleteFolderContents(Pathname(folder_));
+  }
+  virtual bool FileExists(const std::string& filename) const {
+    return Filesystem::IsFile(Pathname(filename));
+  }
+  virtual bool DeleteFile(const std::string& filename) const {
+    return Filesystem::DeleteFile(Pathname(filename));
+  }
+
+ private:
+  int scans_;
+};
+
+class DiskCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(Filesystem::GetTemporaryFolder(folder_, true, NULL));
+    folder_.AppendFolder("diskcache_unittest");
+    Filesystem::DeleteFolderAndContents(folder_);
+  }
+  virtual void TearDown() {
+    Filesystem::DeleteFolderAndContents(folder_);
+  }
+
+  static bool Write(DiskCache* cache, const std::string& id,
+                    const std::string& data) {
+    CacheLock lock(cache, id, true);
+    if (!lock.IsLocked())
+      return false;
+    scoped_ptr<StreamInterface> stream(cache->WriteResource(id, 0));
+    if (!stream || SR_SUCCESS != stream->WriteAll(data.data(), data.length(),
+                                                  NULL, NULL))
+      return false;
+    stream.reset();
+    lock.Commit();
+    return true;
+  }
+
+  static std::string Read(DiskCache* cache, const std::string& id) {
+    scoped_ptr<StreamInterface> stream(cache->ReadResource(id, 0));
+    if (!stream)
+      return std::string();
+    size_t length = 0;
+    const void* data = stream->GetReadData(&length);
+    return std::string(static_cast<const char*>(data), length);
+  }
+
+  Pathname folder_;
+};
+
+TEST_F(DiskCacheTest, EvictsLeastRecentlyUsed) {
+  TestDiskCache cache;
+  ASSERT_TRUE(cache.Initialize(folder_.pathname(), 10));
+  EXPECT_TRUE(Write(&cache, "a", "aaaa"));
+  EXPECT_TRUE(Write(&cache, "b", "bbbb"));
+  // Reading "a" makes "b" the least recently used resource.
+  EXPECT_EQ("aaaa", Read(&cache, "a"));
+  EXPECT_TRUE(Write(&cache, "c", "cccc"));
+  EXPECT_TRUE(cache.HasResource("a"));
+  EXPECT_FALSE(cache.HasResource("b"));
+  EXPECT_TRUE(cache.HasResource("c"));
+}
+
+TEST_F(DiskCacheTest, SkipsOpenResourcesWhenEvicting) {
+  TestDiskCache cache;
+  ASSERT_TRUE(cache.Initialize(folder_.pathname(), 10));
+  EXPECT_TRUE(Write(&cache, "a", "aaaa"));
+  EXPECT_TRUE(Write(&cache, "b", "bbbb"));
+  scoped_ptr<StreamInterface> reader(cache.ReadResource("a", 0));
+  ASSERT_TRUE(reader);
+  // "b" is now the oldest; with it open too, nothing can go.
+  scoped_ptr<StreamInterface> reader2(cache.ReadResource("b", 0));
+  ASSERT_TRUE(reader2);
+  EXPECT_TRUE(Write(&cache, "c", "cccc"));
+  EXPECT_TRUE(cache.HasResource("a"));
+  EXPECT_TRUE(cache.HasResource("b"));
+  reader2.reset();
+  EXPECT_TRUE(Write(&cache, "d", "dddd"));
+  EXPECT_TRUE(cache.HasResource("a"));
+  EXPECT_FALSE(cache.HasResource("b"));
+  reader.reset();
+}
+
+TEST_F(DiskCacheTest, ReadsMappedData) {
+  TestDiskCache cache;
+  ASSERT_TRUE(cache.Initialize(folder_.pathname(), 1024));
+  EXPECT_TRUE(Write(&cache, "id", "hello world"));
+  scoped_ptr<StreamInterface> stream(cache.ReadResource("id", 0));
+  ASSERT_TRUE(stream);
+  size_t size = 0;
+  EXPECT_TRUE(stream->GetSize(&size));
+  EXPECT_EQ(11U, size);
+  size_t length = 0;
+  const char* data = static_cast<const char*>(stream->GetReadData(&length));
+  ASSERT_TRUE(data != NULL);
+  EXPECT_EQ("hello world", std::string(data, length));
+  stream->ConsumeReadData(6);
+  char buffer[16];
+  size_t read = 0;
+  EXPECT_EQ(SR_SUCCESS, stream->Read(buffer, sizeof(buffer), &read, NULL));
+  EXPECT_EQ("world", std::string(buffer, read));
+  EXPECT_EQ(SR_EOS, stream->Read(buffer, sizeof(buffer), &read, NULL));
+  EXPECT_EQ(SR_ERROR, stream->Write("x", 1, NULL, NULL));
+  EXPECT_TRUE(cache.ReadResource("missing", 0) == NULL);
+}
+
+TEST_F(DiskCacheTest, RestoresFromIndex) {
+  {
+    TestDiskCache cache;
+    ASSERT_TRUE(cache.Initialize(folder_.pathname(), 12));
+    EXPECT_EQ(1, cache.scans());
+    EXPECT_TRUE(Write(&cache, "a b", "aaaa"));
+    EXPECT_TRUE(Write(&cache, "c%d", "cccc"));
+    EXPECT_EQ("aaaa", Read(&cache, "a b"));
+  }
+  {
+    TestDiskCache cache;
+    ASSERT_TRUE(cache.Initialize(folder_.pathname(), 12));
+    EXPECT_EQ(0, cache.scans());
+    EXPECT_TRUE(cache.HasResourceStream("a b", 0));
+    EXPECT_TRUE(cache.HasResourceStream("c%d", 0));
+    // The saved order still has "c%d" as least recently used.
+    EXPECT_TRUE(Write(&cache, "e", "eeee"));
+    EXPECT_TRUE(Write(&cache, "f", "ffff"));
+    EXPECT_TRUE(cache.HasResource("a b"));
+    EXPECT_FALSE(cache.HasResource("c%d"));
+  }
+}
+
+TEST_F(DiskCacheTest, RescansWithoutCleanShutdown) {
+  {
+    TestDiskCache cache;
+    ASSERT_TRUE(cache.Initialize(folder_.pathname(), 1024));
+    EXPECT_TRUE(Write(&cache, "a", "aaaa"));
+  }
+  {
+    // Loading the index removes it until the next clean shutdown, so a
+    // second cache on the same folder has to look at the files.
+    TestDiskCache cache;
+    ASSERT_TRUE(cache.Initialize(folder_.pathname(), 1024));
+    EXPECT_EQ(0, cache.scans());
+    TestDiskCache cache2;
+    ASSERT_TRUE(cache2.Initialize(folder_.pathname(), 1024));
+    EXPECT_EQ(1, cache2.scans());
+    EXPECT_TRUE(cache2.HasResource("a"));
+  }
+}
+
+}  // namespace talk_base
@@ -2,9 +2,15 @@
 // All Rights Reserved.
 
 
+#include <string>
+
+#include "base/fileutils.h"
 #include "base/gunit.h"
 #include "base/httpserver.h"
+#include "base/logging.h"
+#include "base/pathutils.h"
 #include "base/testutils.h"
+#include "base/timeutils.h"
 
 using namespace testing;
 
@@ -22,6 +28,67 @@ namespace {
     "Content-Length: 0\r\n"
     "\r\n";
 
+  const char* const kFileRequest =
+    "GET /file HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
+  const char* const kResponseBody = "hello";
+
+  // Answers every request straight away, keeping the connection open. Asks
+  // for /file get the contents of |file|, read through a FileStream.
+  struct HttpResponder : public sigslot::has_slots<> {
+    HttpServer* server;
+    std::string file;
+    int requests;
+
+    explicit HttpResponder(HttpServer* server) : server(server), requests(0) {
+      server->SignalHttpRequest.connect(this, &HttpResponder::OnRequest);
+    }
+    void OnRequest(HttpServer*, HttpServerTransaction* t) {
+      ++requests;
+      StreamInterface* document;
+      if (!file.empty() && t->request.path == "/file") {
+        FileStream* stream = new FileStream;
+        EXPECT_TRUE(stream->Open(file, "rb", NULL));
+        document = stream;
+      } else {
+        document = new MemoryStream(kResponseBody);
+      }
+      // Leave the framing headers to the server.
+      t->response.scode = HC_OK;
+      t->response.setHeader(HH_CONTENT_TYPE, "text/plain");
+      t->response.document.reset(document);
+      server->Respond(t);
+    }
+  };
+
+  // A connection whose SendFile claims success without sending anything, as
+  // sendfile(2) does when the file was truncated after its size was taken.
+  class ZeroSendFileStream : public StreamSource {
+   public:
+    ZeroSendFileStream() : send_file_calls(0) {}
+    virtual StreamResult SendFile(int fd, size_t offset, size_t length,
+                                  size_t* written, int* error) {
+      // Give up eventually, so that a regression fails instead of hanging.
+      if (++send_file_calls > 100) {
+        return StreamSource::SendFile(fd, offset, length, written, error);
+      }
+      *written = 0;
+      return SR_SUCCESS;
+    }
+    int send_file_calls;
+  };
+
+  size_t CountOccurrences(const std::string& data, const std::string& what) {
+    size_t count = 0;
+    for (size_t pos = data.find(what); pos != std::string::npos;
+         pos = data.find(what, pos + what.size())) {
+      ++count;
+    }
+    return count;
+  }
+
   struct HttpServerMonitor : public sigslot::has_slots<> {
     HttpServerTransaction* transaction;
     bool server_closed, connection_closed;
@@ -127,4 +194,144 @@ TEST(HttpServer, SignalsCloseAfterForcedCloseAll) {
   EXPECT_TRUE(monitor.connection_closed);
 }
 
+TEST(HttpServer, AnswersPipelinedRequestsInOrder) {
+  HttpServer server;
+  HttpResponder responder(&server);
+  StreamSource* client = new StreamSource;
+  client->SetState(SS_OPEN);
+  server.HandleConnection(client);
+  // Both requests arrive in one read; the second must survive the first
+  // response going out.
+  std::string requests = std::string(kRequest) + kRequest + kRequest;
+  client->QueueString(requests.c_str());
+  EXPECT_EQ_WAIT(3, responder.requests, 1000);
+  std::string responses = client->ReadData();
+  EXPECT_EQ(3U, CountOccurrences(responses, "HTTP/1.1 200"));
+  EXPECT_EQ(3U, CountOccurrences(responses, "Content-Length: 5\r\n"));
+  EXPECT_EQ(3U, CountOccurrences(responses, "Connection: Keep-Alive\r\n"));
+  EXPECT_EQ(0U, CountOccurrences(responses, "Transfer-Encoding"));
+}
+
+TEST(HttpServer, SendsFileDocumentOverSocket) {
+  Pathname path;
+  ASSERT_TRUE(Filesystem::GetTemporaryFolder(path, true, NULL));
+  path.SetPathname(Filesystem::TempFilename(path, "ut"));
+  const size_t kFileSize = 1024 * 1024;
+  std::string contents(kFileSize, '\0');
+  for (size_t i = 0; i < kFileSize; ++i) {
+    contents[i] = static_cast<char>('a' + i % 26);
+  }
+  {
+    FileStream file;
+    ASSERT_TRUE(file.Open(path.pathname(), "wb", NULL));
+    ASSERT_EQ(SR_SUCCESS, file.WriteAll(contents.data(), contents.size(),
+                                        NULL, NULL));
+  }
+
+  HttpListenServer server;
+  HttpResponder responder(&server);
+  responder.file = path.pathname();
+  ASSERT_EQ(0, server.Listen(SocketAddress("127.0.0.1", 0)));
+  SocketAddress address;
+  ASSERT_TRUE(server.GetAddress(&address));
+
+  SocketTestClient client(address);
+  client.QueueString(kFileRequest);
+  client.QueueString(kRequest);
+  std::string received;
+  size_t expected = 0;
+  for (uint32 start = Time(); TimeSince(start) < 5000; ) {
+    Thread::Current()->ProcessMessages(10);
+    received.append(client.ReadData());
+    size_t end_of_headers = received.find("\r\n\r\n");
+    if ((end_of_headers != std::string::npos) && (expected == 0)) {
+      expected = end_of_headers + 4 + kFileSize;
+    }
+    if ((expected > 0) && (received.size() > expected) &&
+        (received.find(kResponseBody, expected) != std::string::npos)) {
+      break;
+    }
+  }
+  ASSERT_LT(0U, expected);
+  ASSERT_LT(expected, received.size());
+  EXPECT_NE(std::string::npos, received.find("Content-Length: 1048576\r\n"));
+  EXPECT_TRUE(received.compare(expected - kFileSize, kFileSize, contents) == 0);
+  // The connection stayed usable for the request behind the file.
+  EXPECT_EQ(2, responder.requests);
+  EXPECT_EQ(0U, received.compare(expected, 8, "HTTP/1.1"));
+
+  Filesystem::DeleteFile(path);
+}
+
+TEST(HttpServer, FallsBackWhenSendFileMakesNoProgress) {
+  Pathname path;
+  ASSERT_TRUE(Filesystem::GetTemporaryFolder(path, true, NULL));
+  path.SetPathname(Filesystem::TempFilename(path, "ut"));
+  {
+    FileStream file;
+    ASSERT_TRUE(file.Open(path.pathname(), "wb", NULL));
+    ASSERT_EQ(SR_SUCCESS, file.WriteAll(kResponseBody, strlen(kResponseBody),
+                                        NULL, NULL));
+  }
+
+  HttpServer server;
+  HttpResponder responder(&server);
+  responder.file = path.pathname();
+  ZeroSendFileStream* client = new ZeroSendFileStream;
+  client->SetState(SS_OPEN);
+  server.HandleConnection(client);
+  client->QueueString(kFileRequest);
+  EXPECT_EQ(1, responder.requests);
+  // The document was copied instead, after a single SendFile attempt.
+  EXPECT_EQ(1, client->send_file_calls);
+  std::string response = client->ReadData();
+  EXPECT_NE(std::string::npos, response.find("Content-Length: 5\r\n"));
+  EXPECT_NE(std::string::npos, response.find(std::string("\r\n\r\n") +
+                                             kResponseBody));
+
+  Filesystem::DeleteFile(path);
+}
+
+// Test the time required to answer pipelined requests on one keep-alive
+// connection.
+TEST(HttpServer, PipelinedThroughput) {
+  HttpListenServer server;
+  HttpResponder responder(&server);
+  ASSERT_EQ(0, server.Listen(SocketAddress("127.0.0.1", 0)));
+  SocketAddress address;
+  ASSERT_TRUE(server.GetAddress(&address));
+
+  const int kRequests = 5000;
+  const int kBatch = 100;
+  const std::string kBodyMarker = std::string("\r\n\r\n") + kResponseBody;
+  SocketTestClient client(address);
+  std::string batch;
+  for (int i = 0; i < kBatch; ++i) {
+    batch.append(kRequest);
+  }
+
+  uint32 start = Time();
+  std::string received;
+  size_t responses = 0;
+  for (int sent = 0; sent < kRequests; sent += kBatch) {
+    client.QueueData(batch.data(), batch.size());
+    size_t target = sent + kBatch;
+    for (uint32 batch_start = Time();
+         (responses < target) && (TimeSince(batch_start) < 5000); ) {
+      Thread::Current()->ProcessMessages(1);
+      received.append(client.ReadData());
+      responses += CountOccurrences(received, kBodyMarker);
+      // Keep just too little to hold a whole marker, in case one was split
+      // between reads.
+      size_t keep = kBodyMarker.size() - 1;
+      received.erase(0, received.size() > keep ? received.size() - keep : 0);
+    }
+  }
+  uint32 elapsed = TimeSince(start);
+
+  EXPECT_EQ(static_cast<size_t>(kRequests), responses);
+  EXPECT_EQ(kRequests, responder.requests);
+  LOG(LS_INFO) << kRequests << " pipelined requests in " << elapsed << " ms";
+}
+
 } // namespace talk_base
@@ -164,6 +164,68 @@ TEST_F(PhysicalSocketTest, TestGetSetOptionsIPv6) {
   SocketTest::TestGetSetOptionsIPv6();
 }
 
+#ifdef LINUX
+
+// Runs the socket tests against a PhysicalSocketServer waiting with epoll.
+class PhysicalSocketEpollTest : public SocketTest {
+ protected:
+  virtual void SetUp() {
+    server_.reset(new PhysicalSocketServer);
+    ASSERT_TRUE(server_->EnableEpoll());
+    scope_.reset(new SocketServerScope(server_.get()));
+    SocketTest::SetUp();
+  }
+  virtual void TearDown() {
+    scope_.reset();
+    server_.reset();
+  }
+
+  scoped_ptr<PhysicalSocketServer> server_;
+  scoped_ptr<SocketServerScope> scope_;
+};
+
+TEST_F(PhysicalSocketEpollTest, TestConnectIPv4) {
+  SocketTest::TestConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectFailIPv4) {
+  SocketTest::TestConnectFailIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectWithClosedSocketIPv4) {
+  SocketTest::TestConnectWithClosedSocketIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestServerCloseDuringConnectIPv4) {
+  SocketTest::TestServerCloseDuringConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestClientCloseDuringConnectIPv4) {
+  SocketTest::TestClientCloseDuringConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestServerCloseIPv4) {
+  SocketTest::TestServerCloseIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestCloseInClosedCallbackIPv4) {
+  SocketTest::TestCloseInClosedCallbackIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestSocketServerWaitIPv4) {
+  SocketTest::TestSocketServerWaitIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestTcpIPv4) {
+  SocketTest::TestTcpIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestUdpIPv4) {
+  SocketTest::TestUdpIPv4();
+}
+
+#endif  // LINUX
+
 #ifdef POSIX
 
 class PosixSignalDeliveryTest : public testing::Test {
@@ -251,6 +313,18 @@ TEST_F(PosixSignalDeliveryTest, SignalDuringWait) {
   EXPECT_TRUE(ExpectNone());
 }
 
+#ifdef LINUX
+// Test that signals still reach us when the server waits with epoll.
+TEST_F(PosixSignalDeliveryTest, SignalDuringEpollWait) {
+  ASSERT_TRUE(ss_->EnableEpoll());
+  ss_->SetPosixSignalHandler(SIGALRM, &RecordSignal);
+  alarm(1);
+  EXPECT_TRUE(ss_->Wait(1500, true));
+  EXPECT_TRUE(ExpectSignal(SIGALRM));
+  EXPECT_TRUE(ExpectNone());
+}
+#endif
+
 class RaiseSigTermRunnable : public Runnable {
   void Run(Thread *thread) {
     thread->socketserver()->Wait(1000, false);
@@ -699,6 +699,38 @@ class VirtualSocketServerTest : public testing::Test {
     ss_->UpdateDelayDistribution();
   }
 
+  // Runs a lossy, jittery UDP flow for |duration| ms and collects what the
+  // receiver saw.
+  void SoakTest(const SocketAddress& initial_addr, uint32 duration,
+                uint32* samples, double* delay_sum, size_t* bytes) {
+    ss_->set_delay_mean(100);
+    ss_->set_delay_stddev(20);
+    ss_->UpdateDelayDistribution();
+
+    AsyncSocket* send_socket =
+        ss_->CreateAsyncSocket(initial_addr.family(), SOCK_DGRAM);
+    AsyncSocket* recv_socket =
+        ss_->CreateAsyncSocket(initial_addr.family(), SOCK_DGRAM);
+    ASSERT_EQ(0, send_socket->Bind(initial_addr));
+    ASSERT_EQ(0, recv_socket->Bind(initial_addr));
+    ASSERT_EQ(0, send_socket->Connect(recv_socket->GetLocalAddress()));
+
+    Thread* pthMain = Thread::Current();
+    Sender sender(pthMain, send_socket, 20 * 1024);
+    Receiver receiver(pthMain, recv_socket, 0);
+    pthMain->ProcessMessages(duration);
+    sender.done = receiver.done = true;
+    ss_->ProcessMessagesUntilIdle();
+
+    *samples = receiver.samples;
+    *delay_sum = receiver.sum;
+    *bytes = receiver.count;
+
+    ss_->set_delay_mean(0);
+    ss_->set_delay_stddev(0);
+    ss_->UpdateDelayDistribution();
+  }
+
   // Test cross-family communication between a client bound to client_addr and a
   // server bound to server_addr. shouldSucceed indicates if communication is
   // expected to work or not.
@@ -783,6 +815,7 @@ class VirtualSocketServerTest : public testing::Test {
     Thread::Current()->set_socketserver(ss_);
   }
   virtual void TearDown() {
+    ss_->SetVirtualTime(false);
     Thread::Current()->set_socketserver(NULL);
   }
 
@@ -869,6 +902,70 @@ TEST_F(VirtualSocketServerTest, delay_v6) {
   DelayTest(ipv6_test_addr);
 }
 
+TEST_F(VirtualSocketServerTest, bandwidth_v4_virtual_time) {
+  ss_->SetVirtualTime(true);
+  uint64 start = SystemTimeNanos();
+  SocketAddress ipv4_test_addr(IPAddress(INADDR_ANY), 1000);
+  BandwidthTest(ipv4_test_addr);
+  // Ten simulated seconds should take a small fraction of that.
+  EXPECT_LT(SystemTimeNanos() - start, 2 * kNumNanosecsPerSec);
+}
+
+TEST_F(VirtualSocketServerTest, delay_v4_virtual_time) {
+  ss_->SetVirtualTime(true);
+  uint64 start = SystemTimeNanos();
+  SocketAddress ipv4_test_addr(IPAddress(INADDR_ANY), 1000);
+  DelayTest(ipv4_test_addr);
+  EXPECT_LT(SystemTimeNanos() - start, 2 * kNumNanosecsPerSec);
+}
+
+// Test that Wait() jumps straight to the next delayed message.
+TEST_F(VirtualSocketServerTest, VirtualTimeSkipsIdlePeriods) {
+  ss_->SetVirtualTime(true);
+  uint32 start = Time();
+  uint64 start_nanos = SystemTimeNanos();
+  Thread::Current()->ProcessMessages(60 * 60 * 1000);
+  EXPECT_EQ(60 * 60 * 1000, TimeSince(start));
+  EXPECT_LT(SystemTimeNanos() - start_nanos, kNumNanosecsPerSec);
+
+  ss_->AdvanceTime(500);
+  EXPECT_EQ(60 * 60 * 1000 + 500, TimeSince(start));
+}
+
+// Test that a wake-up, e.g. a message posted from another thread, stops
+// Wait() from advancing the clock past the work it signals.
+TEST_F(VirtualSocketServerTest, VirtualTimeDoesNotSkipWakeUps) {
+  ss_->SetVirtualTime(true);
+  uint32 start = Time();
+  ss_->WakeUp();
+  EXPECT_TRUE(ss_->Wait(1000, true));
+  EXPECT_EQ(0, TimeSince(start));
+  EXPECT_TRUE(ss_->Wait(1000, true));
+  EXPECT_EQ(1000, TimeSince(start));
+}
+
+// Test that a ten minute soak runs quickly and gives the same result every
+// time for the same seed.
+TEST_F(VirtualSocketServerTest, VirtualTimeSoakIsDeterministic) {
+  ss_->SetVirtualTime(true);
+  uint64 start = SystemTimeNanos();
+  SocketAddress ipv4_test_addr(IPAddress(INADDR_ANY), 1000);
+  uint32 samples[2];
+  double delay_sum[2];
+  size_t bytes[2];
+  for (int i = 0; i < 2; ++i) {
+    srand(1234);
+    SoakTest(ipv4_test_addr, 10 * 60 * 1000, &samples[i], &delay_sum[i],
+             &bytes[i]);
+  }
+  EXPECT_LT(SystemTimeNanos() - start, 10 * kNumNanosecsPerSec);
+  EXPECT_LT(1000u, samples[0]);
+  EXPECT_EQ(samples[0], samples[1]);
+  EXPECT_EQ(delay_sum[0], delay_sum[1]);
+  EXPECT_EQ(bytes[0], bytes[1]);
+  EXPECT_NEAR(100.0, delay_sum[0] / samples[0], 15.0);
+}
+
 // Works, receiving socket sees 127.0.0.2.
 TEST_F(VirtualSocketServerTest, CanConnectFromMappedIPv6ToIPv4Any) {
   CrossFamilyConnectionTest(SocketAddress("::ffff:127.0.0.2", 0),
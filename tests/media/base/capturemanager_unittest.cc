@@ -166,6 +166,42 @@ TEST_F(CaptureManagerTest, KeepFirstResolutionHigh) {
                                                  format_qvga_));
 }
 
+// Renderers asking for the same size share one scaled frame per capture.
+TEST_F(CaptureManagerTest, RenderersShareScaledFrames) {
+  cricket::FakeVideoRenderer small_renderer1;
+  cricket::FakeVideoRenderer small_renderer2;
+  EXPECT_TRUE(capture_manager_.StartVideoCapture(&video_capturer_,
+                                                 format_vga_));
+  EXPECT_EQ_WAIT(cricket::CS_RUNNING, capture_state(), kMsCallbackWait);
+  EXPECT_TRUE(capture_manager_.AddVideoRenderer(&video_capturer_,
+                                                &video_renderer_));
+  EXPECT_TRUE(capture_manager_.AddVideoRenderer(
+      &video_capturer_, &small_renderer1, format_qvga_.width,
+      format_qvga_.height));
+  EXPECT_TRUE(capture_manager_.AddVideoRenderer(
+      &video_capturer_, &small_renderer2, format_qvga_.width,
+      format_qvga_.height));
+  EXPECT_FALSE(capture_manager_.AddVideoRenderer(
+      &video_capturer_, &small_renderer1, -1, format_qvga_.height));
+
+  cricket::ScaledFrameCache* cache = video_capturer_.scaled_frames();
+  for (int i = 1; i <= 2; ++i) {
+    EXPECT_TRUE(video_capturer_.CaptureFrame());
+    EXPECT_EQ(i, NumFramesRendered());
+    EXPECT_EQ(i, small_renderer1.num_rendered_frames());
+    EXPECT_EQ(i, small_renderer2.num_rendered_frames());
+    // One scale per captured frame, the second renderer reuses it.
+    EXPECT_EQ(i, cache->scale_count());
+    EXPECT_EQ(i, cache->hit_count());
+  }
+  EXPECT_TRUE(WasRenderedResolution(format_vga_));
+  EXPECT_EQ(format_qvga_.width, small_renderer1.width());
+  EXPECT_EQ(format_qvga_.height, small_renderer1.height());
+  EXPECT_EQ(format_qvga_.width, small_renderer2.width());
+  EXPECT_EQ(format_qvga_.height, small_renderer2.height());
+  EXPECT_TRUE(capture_manager_.StopVideoCapture(&video_capturer_, format_vga_));
+}
+
 // Should pick the lowest resolution as the highest resolution is not chosen
 // until after capturing has started. This ensures that no particular resolution
 // is favored over others.
@@ -0,0 +1,206 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/gunit.h"
+#include "libyuv/scale.h"
+#include "media/base/frameconverter.h"
+#include "media/base/videocapturer.h"
+#include "media/base/videocommon.h"
+
+using cricket::CapturedFrame;
+using cricket::FrameConverter;
+
+// An I420 frame with a deterministic, non-uniform pattern.
+class TestSample {
+ public:
+  TestSample(int width, int height)
+      : data_(width * height + ((width + 1) / 2) * ((height + 1) / 2) * 2) {
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = static_cast<uint8>((i * 2654435761u) >> 24);
+    }
+    frame_.width = width;
+    frame_.height = height;
+    frame_.fourcc = cricket::FOURCC_I420;
+    frame_.pixel_width = 1;
+    frame_.pixel_height = 1;
+    frame_.data = &data_[0];
+    frame_.data_size = data_.size();
+  }
+  const CapturedFrame* frame() const { return &frame_; }
+  CapturedFrame* frame() { return &frame_; }
+  const uint8* y_plane() const { return &data_[0]; }
+
+ private:
+  std::vector<uint8> data_;
+  CapturedFrame frame_;
+};
+
+// An I420 output buffer.
+class TestOutput {
+ public:
+  TestOutput(int width, int height)
+      : width_(width),
+        height_(height),
+        half_width_((width + 1) / 2),
+        data_(width * height + half_width_ * ((height + 1) / 2) * 2) {
+  }
+  bool Convert(FrameConverter* converter, const CapturedFrame* frame,
+               int crop_width, int crop_height) {
+    uint8* y = &data_[0];
+    uint8* u = y + width_ * height_;
+    uint8* v = u + half_width_ * ((height_ + 1) / 2);
+    return converter->Convert(frame, crop_width, crop_height,
+                              y, width_, u, half_width_, v, half_width_,
+                              width_, height_);
+  }
+  const std::vector<uint8>& data() const { return data_; }
+
+ private:
+  int width_;
+  int height_;
+  int half_width_;
+  std::vector<uint8> data_;
+};
+
+// Without scaling, the output is the centre crop of the source.
+TEST(FrameConverterTest, CropsWithoutScaling) {
+  TestSample sample(1280, 720);
+  TestOutput output(960, 720);
+  FrameConverter converter(0);
+  ASSERT_TRUE(output.Convert(&converter, sample.frame(), 960, 720));
+  for (int row = 0; row < 720; ++row) {
+    EXPECT_EQ(0, memcmp(&output.data()[row * 960],
+                        sample.y_plane() + row * 1280 + 160, 960))
+        << "row " << row;
+  }
+  FrameConverter::Stats stats = converter.GetStats();
+  EXPECT_EQ(1, stats.frames);
+  EXPECT_EQ(0, stats.scale_time_ns);
+}
+
+// Splitting a frame between threads must not change the result.
+TEST(FrameConverterTest, StripesMatchSingleThread) {
+  TestSample sample(1920, 1080);
+  const int kSizes[][2] = {
+    { 1920, 1080 }, { 1440, 810 }, { 960, 540 }, { 632, 356 }, { 240, 132 }
+  };
+  FrameConverter single(0);
+  FrameConverter striped(3);
+  for (size_t i = 0; i < ARRAY_SIZE(kSizes); ++i) {
+    TestOutput expected(kSizes[i][0], kSizes[i][1]);
+    TestOutput actual(kSizes[i][0], kSizes[i][1]);
+    ASSERT_TRUE(expected.Convert(&single, sample.frame(), 1920, 1080));
+    ASSERT_TRUE(actual.Convert(&striped, sample.frame(), 1920, 1080));
+    EXPECT_TRUE(expected.data() == actual.data())
+        << kSizes[i][0] << "x" << kSizes[i][1];
+  }
+  EXPECT_EQ(0, single.GetStats().striped_frames);
+  EXPECT_EQ(static_cast<int>(ARRAY_SIZE(kSizes)),
+            striped.GetStats().striped_frames);
+}
+
+// Blocks must not scale differently from the whole frame when the scale is
+// not a simple fraction.
+TEST(FrameConverterTest, UnevenScaleMatchesWholeFrameScale) {
+  const int kSizes[][4] = {
+    { 1920, 1080, 632, 356 }, { 1366, 768, 680, 380 }
+  };
+  FrameConverter converter(3);
+  for (size_t i = 0; i < ARRAY_SIZE(kSizes); ++i) {
+    const int src_width = kSizes[i][0];
+    const int src_height = kSizes[i][1];
+    const int width = kSizes[i][2];
+    const int height = kSizes[i][3];
+    TestSample sample(src_width, src_height);
+    TestOutput actual(width, height);
+    ASSERT_TRUE(actual.Convert(&converter, sample.frame(),
+                               src_width, src_height));
+
+    const int src_half_width = (src_width + 1) / 2;
+    const int half_width = (width + 1) / 2;
+    const uint8* src_u = sample.y_plane() + src_width * src_height;
+    const uint8* src_v = src_u + src_half_width * ((src_height + 1) / 2);
+    std::vector<uint8> expected(actual.data().size());
+    uint8* y = &expected[0];
+    uint8* u = y + width * height;
+    uint8* v = u + half_width * ((height + 1) / 2);
+    ASSERT_EQ(0, libyuv::I420Scale(sample.y_plane(), src_width,
+                                   src_u, src_half_width,
+                                   src_v, src_half_width,
+                                   src_width, src_height,
+                                   y, width, u, half_width, v, half_width,
+                                   width, height, libyuv::kFilterBox));
+    EXPECT_TRUE(expected == actual.data()) << width << "x" << height;
+  }
+}
+
+// Bilinear scales read across block edges, so they are converted whole.
+TEST(FrameConverterTest, BilinearScalesAreConvertedWhole) {
+  const int kSizes[][4] = {
+    { 1920, 1080, 1276, 716 }, { 1280, 720, 1920, 1080 }
+  };
+  FrameConverter converter(3);
+  for (size_t i = 0; i < ARRAY_SIZE(kSizes); ++i) {
+    TestSample sample(kSizes[i][0], kSizes[i][1]);
+    TestOutput output(kSizes[i][2], kSizes[i][3]);
+    ASSERT_TRUE(output.Convert(&converter, sample.frame(),
+                               kSizes[i][0], kSizes[i][1]));
+  }
+  FrameConverter::Stats stats = converter.GetStats();
+  EXPECT_EQ(static_cast<int>(ARRAY_SIZE(kSizes)), stats.frames);
+  EXPECT_EQ(0, stats.striped_frames);
+}
+
+// Small frames are not worth handing to other threads.
+TEST(FrameConverterTest, SmallFramesAreNotStriped) {
+  TestSample sample(640, 360);
+  TestOutput output(320, 180);
+  FrameConverter converter(3);
+  ASSERT_TRUE(output.Convert(&converter, sample.frame(), 640, 360));
+  FrameConverter::Stats stats = converter.GetStats();
+  EXPECT_EQ(1, stats.frames);
+  EXPECT_EQ(0, stats.striped_frames);
+  converter.ResetStats();
+  EXPECT_EQ(0, converter.GetStats().frames);
+}
+
+// Rotated samples are converted whole on the calling thread.
+TEST(FrameConverterTest, RotatedFrameIsConvertedWhole) {
+  TestSample sample(1920, 1080);
+  sample.frame()->rotation = 90;
+  TestOutput output(540, 960);
+  FrameConverter converter(3);
+  ASSERT_TRUE(output.Convert(&converter, sample.frame(), 1920, 1080));
+  FrameConverter::Stats stats = converter.GetStats();
+  EXPECT_EQ(1, stats.frames);
+  EXPECT_EQ(0, stats.striped_frames);
+  EXPECT_GT(stats.total_time_ns, 0);
+}
@@ -28,6 +28,8 @@
 #include <string>
 
 #include "base/bytebuffer.h"
+#include "base/fileutils.h"
+#include "base/pathutils.h"
 #include "base/gunit.h"
 #include "base/thread.h"
 #include "media/base/rtpdump.h"
@@ -294,4 +296,102 @@ TEST(RtpDumpTest, LoopReadSingleRtcp) {
   EXPECT_EQ(talk_base::SR_SUCCESS, loop_reader.ReadPacket(&packet));
 }
 
+// Test that the mapped reader returns in place the packets that RtpDumpReader
+// copies out.
+TEST(RtpDumpTest, MappedReaderReadsSamePackets) {
+  talk_base::MemoryStream stream;
+  RtpDumpWriter writer(&stream);
+  ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+      RtpTestUtility::GetTestPacketCount(), false, kTestSsrc, &writer));
+  ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+      RtpTestUtility::GetTestPacketCount(), true, kTestSsrc, &writer));
+  size_t size = 0;
+  ASSERT_TRUE(stream.GetPosition(&size));
+
+  RtpDumpMappedReader mapped_reader;
+  ASSERT_TRUE(mapped_reader.Init(stream.GetBuffer(), size));
+  stream.Rewind();
+  RtpDumpReader reader(&stream);
+  RtpDumpPacket packet;
+  RtpDumpPacketView view;
+  for (size_t i = 0; i < 2 * RtpTestUtility::GetTestPacketCount(); ++i) {
+    ASSERT_EQ(talk_base::SR_SUCCESS, reader.ReadPacket(&packet));
+    ASSERT_EQ(talk_base::SR_SUCCESS, mapped_reader.ReadPacket(&view));
+    EXPECT_EQ(packet.elapsed_time, view.elapsed_time);
+    EXPECT_EQ(packet.original_data_len, view.original_data_len);
+    EXPECT_EQ(packet.is_rtcp(), view.is_rtcp());
+    EXPECT_EQ(packet.IsValidRtpPacket(), view.IsValidRtpPacket());
+    EXPECT_EQ(packet.IsValidRtcpPacket(), view.IsValidRtcpPacket());
+    ASSERT_EQ(packet.data.size(), view.size);
+    EXPECT_EQ(0, memcmp(&packet.data[0], view.data, view.size));
+    // The view points into the dump itself.
+    EXPECT_TRUE(view.data > reinterpret_cast<const uint8*>(stream.GetBuffer()));
+    EXPECT_TRUE(view.data + view.size <=
+                reinterpret_cast<const uint8*>(stream.GetBuffer()) + size);
+  }
+  EXPECT_EQ(talk_base::SR_EOS, reader.ReadPacket(&packet));
+  EXPECT_EQ(talk_base::SR_EOS, mapped_reader.ReadPacket(&view));
+
+  // Rewinding starts again from the first packet.
+  mapped_reader.Rewind();
+  ASSERT_EQ(talk_base::SR_SUCCESS, mapped_reader.ReadPacket(&view));
+  EXPECT_EQ(0U, view.elapsed_time);
+  EXPECT_FALSE(view.is_rtcp());
+}
+
+// Test that the mapped reader rejects bad headers and truncated records.
+TEST(RtpDumpTest, MappedReaderRejectsInvalidDump) {
+  talk_base::MemoryStream stream;
+  RtpDumpWriter writer(&stream);
+  ASSERT_TRUE(RtpTestUtility::WriteTestPackets(1, false, kTestSsrc, &writer));
+  size_t size = 0;
+  ASSERT_TRUE(stream.GetPosition(&size));
+
+  RtpDumpMappedReader reader;
+  RtpDumpPacketView view;
+  // Cut inside the only record.
+  ASSERT_TRUE(reader.Init(stream.GetBuffer(), size - 1));
+  EXPECT_EQ(talk_base::SR_ERROR, reader.ReadPacket(&view));
+  // Cut inside the file header.
+  EXPECT_FALSE(reader.Init(stream.GetBuffer(),
+                           strlen(RtpDumpFileHeader::kFirstLine) + 4));
+  EXPECT_EQ(talk_base::SR_ERROR, reader.ReadPacket(&view));
+
+  stream.Rewind();
+  const char bad_line[] = "#!rtpplaz1.0 0.0.0.0/0\n";
+  EXPECT_EQ(talk_base::SR_SUCCESS,
+            stream.WriteAll(bad_line, strlen(bad_line), NULL, NULL));
+  EXPECT_FALSE(reader.Init(stream.GetBuffer(), size));
+}
+
+// Test that the mapped reader reads a dump file through a mapping.
+TEST(RtpDumpTest, MappedReaderOpensFile) {
+  talk_base::Pathname path;
+  ASSERT_TRUE(talk_base::Filesystem::GetTemporaryFolder(path, true, NULL));
+  path.SetPathname(talk_base::Filesystem::TempFilename(path, "rtpdump-test-"));
+  {
+    talk_base::scoped_ptr<talk_base::StreamInterface> file(
+        talk_base::Filesystem::OpenFile(path, "wb"));
+    ASSERT_TRUE(file.get() != NULL);
+    RtpDumpWriter writer(file.get());
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+        RtpTestUtility::GetTestPacketCount(), false, kTestSsrc, &writer));
+  }
+
+  RtpDumpMappedReader reader;
+  ASSERT_TRUE(reader.Open(path.pathname()));
+  RtpDumpPacketView view;
+  for (size_t i = 0; i < RtpTestUtility::GetTestPacketCount(); ++i) {
+    ASSERT_EQ(talk_base::SR_SUCCESS, reader.ReadPacket(&view));
+    EXPECT_EQ(i * RtpTestUtility::kElapsedTimeInterval, view.elapsed_time);
+    uint32 ssrc;
+    EXPECT_TRUE(GetRtpSsrc(view.data, view.size, &ssrc));
+    EXPECT_EQ(kTestSsrc, ssrc);
+  }
+  EXPECT_EQ(talk_base::SR_EOS, reader.ReadPacket(&view));
+  reader.Close();
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(path));
+  EXPECT_FALSE(reader.Open(path.pathname()));
+}
+
 }  // namespace cricket
@@ -0,0 +1,249 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/criticalsection.h"
+#include "base/gunit.h"
+#include "base/stream.h"
+#include "media/base/rtpreplay.h"
+#include "media/base/rtputils.h"
+#include "media/base/testutils.h"
+
+namespace cricket {
+
+static const uint32 kTestSsrc = 1;
+
+class RtpReplayTest : public testing::Test, public RtpReplaySink {
+ public:
+  struct SentPacket {
+    int stream;
+    bool rtcp;
+    uint32 ssrc;
+    int seq_num;
+    uint32 timestamp;
+  };
+
+  // Writes the test packets into |stream_| and indexes them in |source_|.
+  void InitSource(bool rtcp) {
+    RtpDumpWriter writer(&stream_);
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+        RtpTestUtility::GetTestPacketCount(), rtcp, kTestSsrc, &writer));
+    size_t size = 0;
+    ASSERT_TRUE(stream_.GetPosition(&size));
+    ASSERT_TRUE(source_.Init(stream_.GetBuffer(), size));
+  }
+
+  virtual void OnReplayPacket(int stream, const void* data, size_t len,
+                              bool rtcp) {
+    SentPacket packet;
+    packet.stream = stream;
+    packet.rtcp = rtcp;
+    packet.ssrc = 0;
+    packet.seq_num = 0;
+    packet.timestamp = 0;
+    if (rtcp) {
+      packet.ssrc = talk_base::GetBE32(static_cast<const uint8*>(data) + 4);
+    } else {
+      GetRtpSsrc(data, len, &packet.ssrc);
+      GetRtpSeqNum(data, len, &packet.seq_num);
+      GetRtpTimestamp(data, len, &packet.timestamp);
+    }
+    talk_base::CritScope cs(&crit_);
+    sent_.push_back(packet);
+  }
+
+  size_t sent_count() {
+    talk_base::CritScope cs(&crit_);
+    return sent_.size();
+  }
+
+ protected:
+  talk_base::MemoryStream stream_;
+  RtpReplaySource source_;
+  talk_base::CriticalSection crit_;
+  std::vector<SentPacket> sent_;
+};
+
+// Test that the source indexes the dump and derives the loop increases the
+// same way RtpDumpLoopReader does.
+TEST_F(RtpReplayTest, SourceIndexesDump) {
+  InitSource(false);
+  ASSERT_EQ(RtpTestUtility::GetTestPacketCount(), source_.packet_count());
+  for (size_t i = 0; i < source_.packet_count(); ++i) {
+    EXPECT_EQ(i * RtpTestUtility::kElapsedTimeInterval,
+              source_.packet(i).elapsed_time);
+  }
+  EXPECT_EQ(0U, source_.first_elapsed_time());
+  // Four packets 10 ms apart, four sequence numbers and three frames.
+  EXPECT_EQ(40U, source_.elapsed_time_increase());
+  EXPECT_EQ(4, source_.rtp_seq_num_increase());
+  EXPECT_EQ(90U, source_.rtp_timestamp_increase());
+
+  RtpReplaySource empty;
+  EXPECT_FALSE(empty.Init(RtpDumpFileHeader::kFirstLine,
+                          strlen(RtpDumpFileHeader::kFirstLine)));
+}
+
+// Test that the loop increases of a long recording don't overflow 32 bits.
+TEST_F(RtpReplayTest, SourceIndexesLongDump) {
+  const uint32 kSpan = 0x40000000;
+  RtpDumpWriter writer(&stream_);
+  for (uint32 i = 0; i < 3; ++i) {
+    RawRtpPacket raw = RtpTestUtility::kTestRawRtpPackets[i];
+    raw.timestamp = i * kSpan;
+    talk_base::ByteBuffer buf;
+    raw.WriteToByteBuffer(kTestSsrc, &buf);
+    ASSERT_EQ(talk_base::SR_SUCCESS,
+              writer.WritePacket(buf.Data(), buf.Length(), i * kSpan, false));
+  }
+  size_t size = 0;
+  ASSERT_TRUE(stream_.GetPosition(&size));
+  ASSERT_TRUE(source_.Init(stream_.GetBuffer(), size));
+  // Two spans between three packets, scaled by 3/2.
+  EXPECT_EQ(3 * kSpan, source_.elapsed_time_increase());
+  EXPECT_EQ(3 * kSpan, source_.rtp_timestamp_increase());
+}
+
+// Test that packets go out at their recorded offsets with rewritten SSRCs.
+TEST_F(RtpReplayTest, ReplaysOnSchedule) {
+  InitSource(false);
+  RtpReplayEngine engine(this);
+  EXPECT_EQ(0, engine.AddStream(&source_, 100, 0, false));
+  EXPECT_EQ(1, engine.AddStream(&source_, 200, 5, false));
+  EXPECT_EQ(0, engine.NextDueUs());
+
+  engine.ProcessUntil(0);
+  ASSERT_EQ(1U, sent_.size());
+  EXPECT_EQ(0, sent_[0].stream);
+  EXPECT_EQ(100U, sent_[0].ssrc);
+  EXPECT_EQ(5000, engine.NextDueUs());
+
+  engine.ProcessUntil(4999);
+  EXPECT_EQ(1U, sent_.size());
+  engine.ProcessUntil(5000);
+  ASSERT_EQ(2U, sent_.size());
+  EXPECT_EQ(1, sent_[1].stream);
+  EXPECT_EQ(200U, sent_[1].ssrc);
+  EXPECT_EQ(0, sent_[1].seq_num);
+
+  engine.ProcessUntil(35000);
+  ASSERT_EQ(8U, sent_.size());
+  EXPECT_EQ(-1, engine.NextDueUs());
+  RtpReplayStats stats = engine.GetStats();
+  EXPECT_EQ(8U, stats.packets_sent);
+  EXPECT_EQ(0, stats.active_streams);
+  // The last step ran late for most of the packets it sent.
+  EXPECT_GT(stats.late_packets, 0U);
+  EXPECT_EQ(25000, stats.max_timing_error_us);
+}
+
+// Test that a looping stream keeps sequence numbers and timestamps going.
+TEST_F(RtpReplayTest, LoopsContinuously) {
+  InitSource(false);
+  RtpReplayEngine engine(this);
+  engine.AddStream(&source_, 100, 0, true);
+  for (int64 now_us = 0; now_us < 120000; now_us += 1000) {
+    engine.ProcessUntil(now_us);
+  }
+  ASSERT_EQ(12U, sent_.size());
+  for (size_t i = 0; i < sent_.size(); ++i) {
+    size_t loop = i / RtpTestUtility::GetTestPacketCount();
+    const RawRtpPacket& raw = RtpTestUtility::kTestRawRtpPackets[
+        i % RtpTestUtility::GetTestPacketCount()];
+    EXPECT_EQ(100U, sent_[i].ssrc);
+    EXPECT_EQ(static_cast<int>(raw.sequence_number + loop * 4),
+              sent_[i].seq_num);
+    EXPECT_EQ(raw.timestamp + loop * RtpTestUtility::kRtpTimestampIncrease,
+              sent_[i].timestamp);
+  }
+  RtpReplayStats stats = engine.GetStats();
+  EXPECT_EQ(1, stats.active_streams);
+  EXPECT_EQ(0, stats.max_timing_error_us);
+  EXPECT_EQ(0U, stats.late_packets);
+}
+
+// Test that RTCP packets carry the stream's SSRC as the sender SSRC.
+TEST_F(RtpReplayTest, RewritesRtcpSsrc) {
+  InitSource(true);
+  RtpReplayEngine engine(this);
+  engine.AddStream(&source_, 300, 0, false);
+  engine.ProcessUntil(100000);
+  ASSERT_EQ(RtpTestUtility::GetTestPacketCount(), sent_.size());
+  for (size_t i = 0; i < sent_.size(); ++i) {
+    EXPECT_TRUE(sent_[i].rtcp);
+    EXPECT_EQ(300U, sent_[i].ssrc);
+  }
+}
+
+// Test that streams starting further ahead than the wheel covers still go out
+// on time, and that many streams share the wheel.
+TEST_F(RtpReplayTest, ManyStreams) {
+  InitSource(false);
+  RtpReplayEngine engine(this);
+  const int kNumStreams = 500;
+  for (int i = 0; i < kNumStreams; ++i) {
+    EXPECT_EQ(i, engine.AddStream(&source_, 1000 + i, i * 7, false));
+  }
+  int64 last_us = (kNumStreams - 1) * 7000 + 30000;
+  for (int64 now_us = 0; now_us <= last_us; now_us += 1000) {
+    size_t before = sent_.size();
+    engine.ProcessUntil(now_us);
+    for (size_t i = before; i < sent_.size(); ++i) {
+      EXPECT_EQ(1000U + sent_[i].stream, sent_[i].ssrc);
+    }
+  }
+  RtpReplayStats stats = engine.GetStats();
+  EXPECT_EQ(kNumStreams * RtpTestUtility::GetTestPacketCount(),
+            stats.packets_sent);
+  EXPECT_EQ(0, stats.max_timing_error_us);
+  EXPECT_EQ(0, stats.active_streams);
+}
+
+// Test replay in real time on the engine's thread.
+TEST_F(RtpReplayTest, ReplaysOnThread) {
+  InitSource(false);
+  RtpReplayEngine engine(this);
+  for (int i = 0; i < 50; ++i) {
+    engine.AddStream(&source_, 1000 + i, i, false);
+  }
+  EXPECT_TRUE(engine.Start());
+  EXPECT_TRUE_WAIT(!engine.running(), 5000);
+  engine.Stop();
+  EXPECT_EQ(50 * RtpTestUtility::GetTestPacketCount(), sent_count());
+  RtpReplayStats stats = engine.GetStats();
+  EXPECT_EQ(sent_count(), stats.packets_sent);
+  EXPECT_GT(stats.packets_per_second(), 0.0);
+  LOG(LS_INFO) << "Replayed " << stats.packets_sent << " packets at "
+               << stats.packets_per_second() << " packets/s, mean timing error "
+               << stats.mean_timing_error_us() << " us, max "
+               << stats.max_timing_error_us << " us";
+}
+
+}  // namespace cricket
@@ -57,6 +57,19 @@ static const unsigned char kInvalidPacketWithCsrcAndExtension2[] = {
     0xBE, 0xDE, 0x00, 0x02, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77
 };
 
+// Extension (0xBEDE) with a padding byte, an audio level element (id 3,
+// V = 1, level = 42), an audio level element (id 5, V = 0, level = 127) and
+// trailing padding.
+static const unsigned char kRtpPacketWithAudioLevel[] = {
+    0x90, 0x80, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0xBE, 0xDE, 0x00, 0x02, 0x00, 0x30, 0xAA, 0x50, 0x7F, 0x00, 0x00, 0x00
+};
+// Same as above, but with a two-byte header extension profile.
+static const unsigned char kRtpPacketWithTwoByteExtension[] = {
+    0x90, 0x80, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x10, 0x00, 0x00, 0x02, 0x00, 0x30, 0xAA, 0x50, 0x7F, 0x00, 0x00, 0x00
+};
+
 // PT = 206, FMT = 1, Sender SSRC  = 0x1111, Media SSRC = 0x1111
 // No FCI information is needed for PLI.
 static const unsigned char kNonCompoundRtcpPliFeedbackPacket[] = {
@@ -168,6 +181,58 @@ TEST(RtpUtilsTest, GetRtpHeaderLen) {
                                &len));
 }
 
+TEST(RtpUtilsTest, GetRtpHeaderExtension) {
+  const uint8* value;
+  size_t value_len;
+  EXPECT_TRUE(GetRtpHeaderExtension(
+      kRtpPacketWithMarkerAndCsrcAndExtension,
+      sizeof(kRtpPacketWithMarkerAndCsrcAndExtension), 1, &value, &value_len));
+  EXPECT_EQ(2U, value_len);
+  EXPECT_EQ(0x22, value[0]);
+  EXPECT_EQ(0x33, value[1]);
+  // The element with id 4 runs past the end of the extension.
+  EXPECT_FALSE(GetRtpHeaderExtension(
+      kRtpPacketWithMarkerAndCsrcAndExtension,
+      sizeof(kRtpPacketWithMarkerAndCsrcAndExtension), 4, &value, &value_len));
+  EXPECT_FALSE(GetRtpHeaderExtension(
+      kInvalidPacketWithCsrcAndExtension2,
+      sizeof(kInvalidPacketWithCsrcAndExtension2), 1, &value, &value_len));
+  EXPECT_FALSE(GetRtpHeaderExtension(kPcmuFrame, sizeof(kPcmuFrame),
+                                     1, &value, &value_len));
+
+  EXPECT_TRUE(GetRtpHeaderExtension(kRtpPacketWithAudioLevel,
+                                    sizeof(kRtpPacketWithAudioLevel),
+                                    5, &value, &value_len));
+  EXPECT_EQ(1U, value_len);
+  EXPECT_EQ(0x7F, value[0]);
+  EXPECT_FALSE(GetRtpHeaderExtension(kRtpPacketWithAudioLevel,
+                                     sizeof(kRtpPacketWithAudioLevel),
+                                     2, &value, &value_len));
+  EXPECT_FALSE(GetRtpHeaderExtension(kRtpPacketWithAudioLevel,
+                                     sizeof(kRtpPacketWithAudioLevel),
+                                     15, &value, &value_len));
+}
+
+TEST(RtpUtilsTest, GetRtpAudioLevel) {
+  int level;
+  bool voice;
+  EXPECT_TRUE(GetRtpAudioLevel(kRtpPacketWithAudioLevel,
+                               sizeof(kRtpPacketWithAudioLevel),
+                               3, &level, &voice));
+  EXPECT_EQ(42, level);
+  EXPECT_TRUE(voice);
+  EXPECT_TRUE(GetRtpAudioLevel(kRtpPacketWithAudioLevel,
+                               sizeof(kRtpPacketWithAudioLevel),
+                               5, &level, &voice));
+  EXPECT_EQ(127, level);
+  EXPECT_FALSE(voice);
+  EXPECT_FALSE(GetRtpAudioLevel(kRtpPacketWithTwoByteExtension,
+                                sizeof(kRtpPacketWithTwoByteExtension),
+                                3, &level, &voice));
+  EXPECT_FALSE(GetRtpAudioLevel(kPcmuFrame, sizeof(kPcmuFrame),
+                                3, &level, &voice));
+}
+
 TEST(RtpUtilsTest, GetRtcp) {
   int pt;
   EXPECT_TRUE(GetRtcpType(kRtcpReport, sizeof(kRtcpReport), &pt));
@@ -63,6 +63,7 @@ static const unsigned int kMaxBandwidthKbps = 2000;
 static const unsigned int kNumberOfTemporalLayers = 1;
 
 static const uint32_t kSsrcs2[] = {1, 2};
+static const uint32_t kSsrcs3[] = {1, 2, 3};
 
 
 class FakeViEWrapper : public cricket::ViEWrapper {
@@ -346,6 +347,28 @@ TEST_F(WebRtcVideoEngineTestFake, ResetVieSendCodecOnNewFrameSize) {
   VerifyVP8SendCodec(channel_num, kVP8Codec.width, kVP8Codec.height);
 }
 
+// Test that a frame larger than the send codec is scaled to fit inside it
+// rather than cropped to the codec's aspect ratio.
+TEST_F(WebRtcVideoEngineTestFake, DownscaleKeepsFrameAspectRatio) {
+  EXPECT_TRUE(SetupEngine());
+  int channel_num = vie_.GetLastChannel();
+
+  std::vector<cricket::VideoCodec> codec_list;
+  codec_list.push_back(kVP8Codec);
+  EXPECT_TRUE(channel_->SetSendCodecs(codec_list));
+  EXPECT_TRUE(channel_->AddSendStream(
+      cricket::StreamParams::CreateLegacy(123)));
+  EXPECT_TRUE(channel_->SetSend(true));
+
+  // A 16:9 frame is scaled to the codec width.
+  SendI420Frame(1280, 720);
+  VerifyVP8SendCodec(channel_num, kVP8Codec.width, 360);
+
+  // A 4:3 frame is scaled to the codec height.
+  SendI420Frame(1024, 768);
+  VerifyVP8SendCodec(channel_num, 532, kVP8Codec.height);
+}
+
 // Test that we set our inbound codecs properly.
 TEST_F(WebRtcVideoEngineTestFake, SetRecvCodecs) {
   EXPECT_TRUE(SetupEngine());
@@ -854,6 +877,34 @@ TEST_F(WebRtcVideoEngineTestFake, SetOptionsWithDenoising) {
   EXPECT_FALSE(vie_.GetCaptureDenoising(capture_id));
 }
 
+// Test SetOptions with encoder threads, token partitions and preset.
+TEST_F(WebRtcVideoEngineTestFake, SetOptionsWithEncoderThreading) {
+  EXPECT_TRUE(SetupEngine());
+  int channel_num = vie_.GetLastChannel();
+  std::vector<cricket::VideoCodec> codecs;
+  codecs.push_back(kVP8Codec);
+  EXPECT_TRUE(channel_->SetSendCodecs(codecs));
+
+  // By default the encoder picks threads and partitions on its own.
+  webrtc::VideoCodec send_codec;
+  memset(&send_codec, 0, sizeof(send_codec));  // avoid uninitialized warning
+  EXPECT_EQ(0, vie_.GetSendCodec(channel_num, send_codec));
+  EXPECT_EQ(0, send_codec.codecSpecific.VP8.numberOfThreads);
+  EXPECT_EQ(0, send_codec.codecSpecific.VP8.numberOfTokenPartitions);
+  EXPECT_EQ(webrtc::kComplexityNormal, send_codec.codecSpecific.VP8.complexity);
+
+  cricket::VideoOptions options;
+  options.video_encoder_threads.Set(4);
+  options.video_token_partitions.Set(8);
+  options.video_encoder_preset.Set(cricket::VIDEO_PRESET_BEST_QUALITY);
+  EXPECT_TRUE(channel_->SetOptions(options));
+
+  EXPECT_EQ(0, vie_.GetSendCodec(channel_num, send_codec));
+  EXPECT_EQ(4, send_codec.codecSpecific.VP8.numberOfThreads);
+  EXPECT_EQ(8, send_codec.codecSpecific.VP8.numberOfTokenPartitions);
+  EXPECT_EQ(webrtc::kComplexityMax, send_codec.codecSpecific.VP8.complexity);
+}
+
 // Test that two different streams can have different formats.
 TEST_F(WebRtcVideoEngineTestFake, MultipleSendStreamsDifferentFormats) {
   EXPECT_TRUE(SetupEngine());
@@ -882,6 +933,130 @@ TEST_F(WebRtcVideoEngineTestFake, MultipleSendStreamsDifferentFormats) {
                      kVP8Codec.framerate / 2);
 }
 
+// Test that a stream with a SIM ssrc group is sent as one channel per layer,
+// each at half the size of the one above it and with its share of the
+// bitrate.
+TEST_F(WebRtcVideoEngineTestFake, SimulcastSendStream) {
+  EXPECT_TRUE(SetupEngine());
+  std::vector<cricket::VideoCodec> codecs;
+  codecs.push_back(kVP8Codec);
+  EXPECT_TRUE(channel_->SetSendCodecs(codecs));
+  const int num_channels = vie_.GetNumChannels();
+
+  cricket::StreamParams stream;
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    stream.ssrcs.push_back(kSsrcs3[i]);
+  }
+  stream.ssrc_groups.push_back(
+      cricket::SsrcGroup(cricket::kSimSsrcGroupSemantics, stream.ssrcs));
+  stream.cname = "cname";
+  EXPECT_TRUE(channel_->AddSendStream(stream));
+  EXPECT_EQ(num_channels + 2, vie_.GetNumChannels());
+
+  int layer_channels[ARRAY_SIZE(kSsrcs3)];
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    layer_channels[i] = vie_.GetChannelFromLocalSsrc(kSsrcs3[i]);
+    ASSERT_NE(-1, layer_channels[i]);
+    char rtcp_cname[256];
+    EXPECT_EQ(0, vie_.GetRTCPCName(layer_channels[i], rtcp_cname));
+    EXPECT_STREQ("cname", rtcp_cname);
+  }
+  // Bitrate is shared 16:4:1 between the layers; each keeps the minimum.
+  VerifyVP8SendCodec(layer_channels[0], kVP8Codec.width, kVP8Codec.height, 0,
+                     1523, kMinBandwidthKbps, 228);
+  VerifyVP8SendCodec(layer_channels[1], kVP8Codec.width / 2,
+                     kVP8Codec.height / 2, 0, 380, kMinBandwidthKbps, 57);
+  VerifyVP8SendCodec(layer_channels[2], kVP8Codec.width / 4,
+                     kVP8Codec.height / 4, 0, 95, kMinBandwidthKbps,
+                     kMinBandwidthKbps);
+
+  // One captured frame is scaled down for the lower layers.
+  EXPECT_TRUE(channel_->SetSend(true));
+  EXPECT_TRUE(SendI420Frame(kVP8Codec.width, kVP8Codec.height));
+  VerifyVP8SendCodec(layer_channels[1], kVP8Codec.width / 2,
+                     kVP8Codec.height / 2, 0, 380, kMinBandwidthKbps, 57);
+  VerifyVP8SendCodec(layer_channels[2], kVP8Codec.width / 4,
+                     kVP8Codec.height / 4, 0, 95, kMinBandwidthKbps,
+                     kMinBandwidthKbps);
+
+  // Layers go away with their stream only.
+  EXPECT_FALSE(channel_->RemoveSendStream(kSsrcs3[1]));
+  EXPECT_TRUE(channel_->RemoveSendStream(kSsrcs3[0]));
+  EXPECT_EQ(num_channels, vie_.GetNumChannels());
+  EXPECT_EQ(-1, vie_.GetChannelFromLocalSsrc(kSsrcs3[1]));
+  EXPECT_EQ(-1, vie_.GetChannelFromLocalSsrc(kSsrcs3[2]));
+}
+
+// A layer that cannot be set up must not leave the layers before it behind.
+TEST_F(WebRtcVideoEngineTestFake, SimulcastSendStreamFailsCleanly) {
+  EXPECT_TRUE(SetupEngine());
+  std::vector<cricket::VideoCodec> codecs;
+  codecs.push_back(kVP8Codec);
+  EXPECT_TRUE(channel_->SetSendCodecs(codecs));
+  const int num_channels = vie_.GetNumChannels();
+
+  cricket::StreamParams stream;
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    stream.ssrcs.push_back(kSsrcs3[i]);
+  }
+  stream.ssrc_groups.push_back(
+      cricket::SsrcGroup(cricket::kSimSsrcGroupSemantics, stream.ssrcs));
+  vie_.set_fail_local_ssrc(kSsrcs3[2]);
+  EXPECT_FALSE(channel_->AddSendStream(stream));
+  EXPECT_EQ(num_channels, vie_.GetNumChannels());
+  EXPECT_EQ(-1, vie_.GetChannelFromLocalSsrc(kSsrcs3[1]));
+
+  // The SSRCs of the layers are free again.
+  vie_.set_fail_local_ssrc(0);
+  EXPECT_TRUE(channel_->AddSendStream(stream));
+  EXPECT_EQ(num_channels + 2, vie_.GetNumChannels());
+  EXPECT_TRUE(channel_->RemoveSendStream(kSsrcs3[0]));
+  EXPECT_EQ(num_channels, vie_.GetNumChannels());
+}
+
+// Test that screencast simulcast layers are each half the size of the layer
+// above, starting from the captured size rather than the codec size.
+TEST_F(WebRtcVideoEngineTestFake, SimulcastScreencastScalesLayers) {
+  EXPECT_TRUE(SetupEngine());
+  std::vector<cricket::VideoCodec> codecs;
+  codecs.push_back(kVP8Codec);
+  EXPECT_TRUE(channel_->SetSendCodecs(codecs));
+
+  cricket::StreamParams stream;
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    stream.ssrcs.push_back(kSsrcs3[i]);
+  }
+  stream.ssrc_groups.push_back(
+      cricket::SsrcGroup(cricket::kSimSsrcGroupSemantics, stream.ssrcs));
+  EXPECT_TRUE(channel_->AddSendStream(stream));
+  EXPECT_TRUE(channel_->SetSend(true));
+
+  EXPECT_TRUE(SendI420ScreencastFrame(1280, 720));
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    int layer_channel = vie_.GetChannelFromLocalSsrc(kSsrcs3[i]);
+    ASSERT_NE(-1, layer_channel);
+    webrtc::VideoCodec gcodec;
+    EXPECT_EQ(0, vie_.GetSendCodec(layer_channel, gcodec));
+    EXPECT_EQ(1280 >> i, gcodec.width);
+    EXPECT_EQ(720 >> i, gcodec.height);
+    EXPECT_FALSE(gcodec.codecSpecific.VP8.automaticResizeOn);
+  }
+}
+
+// A SIM group must cover all the SSRCs of the stream.
+TEST_F(WebRtcVideoEngineTestFake, SimulcastSendStreamRejectsPartialGroup) {
+  EXPECT_TRUE(SetupEngine());
+  cricket::StreamParams stream;
+  for (unsigned int i = 0; i < ARRAY_SIZE(kSsrcs3); ++i) {
+    stream.ssrcs.push_back(kSsrcs3[i]);
+  }
+  std::vector<uint32> group_ssrcs(stream.ssrcs.begin(),
+                                  stream.ssrcs.begin() + 2);
+  stream.ssrc_groups.push_back(
+      cricket::SsrcGroup(cricket::kSimSsrcGroupSemantics, group_ssrcs));
+  EXPECT_FALSE(channel_->AddSendStream(stream));
+}
+
 TEST_F(WebRtcVideoEngineTestFake, SendReceiveBitratesStats) {
   EXPECT_TRUE(SetupEngine());
   cricket::VideoOptions options;
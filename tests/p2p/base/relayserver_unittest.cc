@@ -537,3 +537,63 @@ TEST_F(RelayServerTest, TestExpiration) {
   SendRaw2(msg2, std::strlen(msg2));
   EXPECT_TRUE(ReceiveRaw1().empty());
 }
+
+#ifdef POSIX
+// Clients sharing a username are spread over the threads of a group by the
+// kernel, but must all end up in the one binding: each is told the same
+// external address, and external traffic reaches the first of them.
+TEST_F(RelayServerTest, TestGroupSharesBindingAcrossThreads) {
+  RelayServerGroup group;
+  group.set_log_bindings(false);
+  ASSERT_TRUE(group.Start(SocketAddress("127.0.0.1", 0),
+                          SocketAddress("127.0.0.1", 0), 4));
+  EXPECT_EQ(-1, group.GetBindingOwner(username_));
+
+  static const int kNumClients = 8;
+  talk_base::scoped_ptr<talk_base::TestClient> clients[kNumClients];
+  SocketAddress mapped_addr;
+  for (int i = 0; i < kNumClients; ++i) {
+    clients[i].reset(new talk_base::TestClient(
+        talk_base::AsyncUDPSocket::Create(ss_, SocketAddress("127.0.0.1", 0))));
+
+    talk_base::scoped_ptr<StunMessage> req(
+        CreateStunMessage(STUN_ALLOCATE_REQUEST));
+    AddUsernameAttr(req.get(), username_);
+    AddLifetimeAttr(req.get(), LIFETIME);
+    talk_base::ByteBuffer buf;
+    req->Write(&buf);
+    Send(clients[i].get(), buf.Data(), buf.Length(), group.internal_address());
+
+    talk_base::scoped_ptr<StunMessage> res(Receive(clients[i].get()));
+    ASSERT_TRUE(res.get() != NULL);
+    EXPECT_EQ(STUN_ALLOCATE_RESPONSE, res->type());
+    const StunAddressAttribute* addr_attr =
+        res->GetAddress(STUN_ATTR_MAPPED_ADDRESS);
+    ASSERT_TRUE(addr_attr != NULL);
+    SocketAddress addr(addr_attr->ipaddr(), addr_attr->port());
+    if (i == 0) {
+      mapped_addr = addr;
+    } else {
+      EXPECT_EQ(mapped_addr, addr);
+    }
+  }
+
+  int owner = group.GetBindingOwner(username_);
+  ASSERT_LE(0, owner);
+  EXPECT_EQ(mapped_addr, group.external_address(owner));
+
+  talk_base::scoped_ptr<StunMessage> req(
+      CreateStunMessage(STUN_BINDING_REQUEST));
+  AddUsernameAttr(req.get(), username_);
+  talk_base::ByteBuffer buf;
+  req->Write(&buf);
+  Send(client2_.get(), buf.Data(), buf.Length(), mapped_addr);
+
+  talk_base::scoped_ptr<StunMessage> ind(Receive(clients[0].get()));
+  ASSERT_TRUE(ind.get() != NULL);
+  EXPECT_EQ(STUN_DATA_INDICATION, ind->type());
+
+  group.Stop();
+  EXPECT_EQ(-1, group.GetBindingOwner(username_));
+}
+#endif  // POSIX
@@ -2147,6 +2147,66 @@ class SessionTest : public testing::Test {
     initiator->ExpectSentStanza(
         IqSet("1", kInitiator, kResponder, description_info_xml));
   }
+
+  // Tests that candidates for several contents gathered within the batching
+  // window go out in a single transport-info message.
+  void TestBatchedCandidates() {
+    std::string content_type = cricket::NS_JINGLE_RTP;
+    std::string gingle_content_type = cricket::NS_GINGLE_VIDEO;
+    std::string content_name_a = cricket::CN_AUDIO;
+    std::string channel_name_a = "rtp";
+    std::string content_name_b = cricket::CN_VIDEO;
+    std::string channel_name_b = "video_rtp";
+
+    talk_base::scoped_ptr<cricket::PortAllocator> allocator(
+        new TestPortAllocator());
+    int next_message_id = 0;
+
+    talk_base::scoped_ptr<TestClient> initiator(
+        new TestClient(allocator.get(), &next_message_id,
+                       kInitiator, PROTOCOL_JINGLE,
+                       content_type,
+                       content_name_a, channel_name_a,
+                       content_name_b, channel_name_b));
+    talk_base::scoped_ptr<TestClient> responder(
+        new TestClient(allocator.get(), &next_message_id,
+                       kResponder, PROTOCOL_JINGLE,
+                       content_type,
+                       content_name_a, channel_name_a,
+                       content_name_b, channel_name_b));
+
+    initiator->CreateSession();
+    EXPECT_TRUE(initiator->session->Initiate(
+        kResponder, NewTestSessionDescription(gingle_content_type,
+                                              content_name_a, content_type,
+                                              content_name_b, content_type)));
+    initiator->ExpectSentStanza(
+        IqSet("0", kInitiator, kResponder,
+              InitiateXml(PROTOCOL_JINGLE, gingle_content_type,
+                          content_name_a, content_type,
+                          content_name_b, content_type)));
+
+    responder->DeliverStanza(initiator->stanza());
+    responder->ExpectSentStanza(
+        IqAck("0", kResponder, kInitiator));
+
+    responder->session->set_candidate_batch_interval(50);
+    responder->PrepareCandidates();
+    EXPECT_TRUE_WAIT(responder->sent_stanza_count() > 0, kEventTimeout);
+    responder->ExpectSentStanza(
+        IqSet("1", kResponder, kInitiator,
+              JingleActionXml(
+                  "transport-info",
+                  JingleTransportContentXml(
+                      content_name_a, kTransportType,
+                      P2pCandidateXml(channel_name_a, 0) +
+                      P2pCandidateXml(channel_name_a, 1)) +
+                  JingleTransportContentXml(
+                      content_name_b, kTransportType,
+                      P2pCandidateXml(channel_name_b, 2) +
+                      P2pCandidateXml(channel_name_b, 3)))));
+    EXPECT_EQ(0U, responder->sent_stanza_count());
+  }
 };
 
 // For each of these, "X => Y = Z" means "if a client with protocol X
@@ -2304,3 +2364,7 @@ TEST_F(SessionTest, TestTransportMux) {
 TEST_F(SessionTest, TestSendDescriptionInfo) {
   TestSendDescriptionInfo();
 }
+
+TEST_F(SessionTest, TestBatchedCandidates) {
+  TestBatchedCandidates();
+}
@@ -33,6 +33,7 @@
 #include "base/virtualsocketserver.h"
 #include "base/testclient.h"
 #include "base/thread.h"
+#include "p2p/base/stunloadgenerator.h"
 #include "p2p/base/stunserver.h"
 
 using namespace cricket;
@@ -118,3 +119,60 @@ TEST_F(StunServerTest, TestBad) {
   StunMessage* msg = Receive();
   ASSERT_TRUE(msg == NULL);
 }
+
+#ifdef POSIX
+// Several clients talk to a group of servers sharing one real address; every
+// one of them must get a correct answer, whichever thread serves it.
+TEST(StunServerGroupTest, TestBindingRequestsAcrossThreads) {
+  StunServerGroup group;
+  ASSERT_TRUE(group.Start(talk_base::SocketAddress("127.0.0.1", 0), 4));
+  EXPECT_EQ(4, group.num_threads());
+  EXPECT_NE(0, group.address().port());
+
+  talk_base::SocketServer* ss = talk_base::Thread::Current()->socketserver();
+  for (int i = 0; i < 16; ++i) {
+    talk_base::TestClient client(talk_base::AsyncUDPSocket::Create(
+        ss, talk_base::SocketAddress("127.0.0.1", 0)));
+
+    StunMessage req;
+    req.SetType(STUN_BINDING_REQUEST);
+    req.SetTransactionID("0123456789ab");
+    talk_base::ByteBuffer buf;
+    req.Write(&buf);
+    client.SendTo(buf.Data(), buf.Length(), group.address());
+
+    talk_base::TestClient::Packet* packet = client.NextPacket();
+    ASSERT_TRUE(packet != NULL);
+    talk_base::ByteBuffer read_buf(packet->buf, packet->size);
+    StunMessage res;
+    ASSERT_TRUE(res.Read(&read_buf));
+    delete packet;
+    EXPECT_EQ(STUN_BINDING_RESPONSE, res.type());
+    EXPECT_EQ(req.transaction_id(), res.transaction_id());
+    const StunAddressAttribute* mapped_addr =
+        res.GetAddress(STUN_ATTR_MAPPED_ADDRESS);
+    ASSERT_TRUE(mapped_addr != NULL);
+    EXPECT_EQ(client.address().port(), mapped_addr->port());
+  }
+
+  group.Stop();
+  EXPECT_EQ(0, group.num_threads());
+}
+
+TEST(StunServerGroupTest, TestLoadGenerator) {
+  StunServerGroup group;
+  ASSERT_TRUE(group.Start(talk_base::SocketAddress("127.0.0.1", 0), 2));
+
+  StunLoadGenerator generator(talk_base::Thread::Current(), group.address());
+  ASSERT_TRUE(generator.Init(talk_base::IPAddress(INADDR_LOOPBACK), 4, 4));
+  StunLoadStats stats = generator.Run(200, 2000);
+
+  EXPECT_LT(0, stats.responses_received);
+  EXPECT_EQ(0, stats.timeouts);
+  EXPECT_EQ(stats.requests_sent, stats.responses_received);
+  EXPECT_LT(0.0, stats.requests_per_second());
+  EXPECT_LE(stats.latency_p50_us, stats.latency_p90_us);
+  EXPECT_LE(stats.latency_p90_us, stats.latency_p99_us);
+  EXPECT_LE(stats.latency_p99_us, stats.latency_max_us);
+}
+#endif  // POSIX
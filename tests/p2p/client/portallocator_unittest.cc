@@ -42,6 +42,7 @@
 #include "p2p/base/teststunserver.h"
 #include "p2p/client/basicportallocator.h"
 #include "p2p/client/httpportallocator.h"
+#include "p2p/client/portpool.h"
 
 using talk_base::SocketAddress;
 using talk_base::Thread;
@@ -284,6 +285,85 @@ TEST_F(PortAllocatorTest, TestGetAllPorts) {
   session_->StopGetAllPorts();
 }
 
+// Tests that without a step delay all of the later phases start together
+// when gathering starts, still in priority order, and that the session
+// reports how long gathering took.
+TEST_F(PortAllocatorTest, TestGetAllPortsWithoutStepDelay) {
+  AddInterface(kClientAddr);
+  allocator().set_step_delay(0);
+  EXPECT_TRUE(CreateSession(cricket::ICE_CANDIDATE_COMPONENT_RTP));
+  cricket::BasicPortAllocatorSession* session =
+      static_cast<cricket::BasicPortAllocatorSession*>(session_.get());
+  EXPECT_EQ(-1, session->time_to_first_candidate());
+  EXPECT_EQ(-1, session->time_to_complete());
+  session_->GetInitialPorts();
+  session_->StartGetAllPorts();
+  // With the default one second delay this would take more than three.
+  ASSERT_EQ_WAIT(7U, candidates_.size(), 1000);
+  EXPECT_TRUE_WAIT(candidate_allocation_done_, 1000);
+  EXPECT_EQ(4U, ports_.size());
+  EXPECT_PRED5(CheckCandidate, candidates_[0],
+      cricket::ICE_CANDIDATE_COMPONENT_RTP, "local", "udp", kClientAddr);
+  // Host candidates come first, then server reflexive, then relayed.
+  size_t first_stun = candidates_.size();
+  size_t first_relay = candidates_.size();
+  size_t last_local = 0;
+  for (size_t i = 0; i < candidates_.size(); ++i) {
+    if (candidates_[i].type() == "local")
+      last_local = i;
+    else if (candidates_[i].type() == "stun")
+      first_stun = talk_base::_min(first_stun, i);
+    else if (candidates_[i].type() == "relay")
+      first_relay = talk_base::_min(first_relay, i);
+  }
+  EXPECT_LT(last_local, first_stun);
+  EXPECT_LT(first_stun, first_relay);
+  EXPECT_LE(0, session->time_to_first_candidate());
+  EXPECT_LE(session->time_to_first_candidate(), session->time_to_complete());
+  EXPECT_GT(1000, session->time_to_complete());
+  session_->StopGetAllPorts();
+}
+
+// Test that a second session picks up the server reflexive port the pool kept
+// warm after the first one, even though the STUN server is now unreachable.
+TEST_F(PortAllocatorTest, TestSessionReusesPooledStunPort) {
+  AddInterface(kClientAddr);
+  allocator().set_step_delay(0);
+  allocator().set_port_pool_size(1);
+  allocator().set_flags(allocator().flags() |
+                        cricket::PORTALLOCATOR_ENABLE_SHARED_UFRAG);
+  EXPECT_TRUE(CreateSession(cricket::ICE_CANDIDATE_COMPONENT_RTP));
+  session_->GetInitialPorts();
+  session_->StartGetAllPorts();
+  EXPECT_TRUE_WAIT(candidate_allocation_done_, 1000);
+  cricket::PortPool* pool = allocator().GetPortPool(Thread::Current());
+  ASSERT_TRUE(pool != NULL);
+  EXPECT_TRUE_WAIT(pool->ready_port_count() > 0, 1000);
+  EXPECT_EQ(0, pool->hits());
+  session_->StopGetAllPorts();
+
+  fss_->AddRule(false, talk_base::FP_UDP, talk_base::FD_ANY, kStunAddr);
+  candidates_.clear();
+  candidate_allocation_done_ = false;
+  EXPECT_TRUE(CreateSession(cricket::ICE_CANDIDATE_COMPONENT_RTCP));
+  session_->GetInitialPorts();
+  session_->StartGetAllPorts();
+  EXPECT_TRUE_WAIT(candidate_allocation_done_, 2000);
+  EXPECT_LE(1, pool->hits());
+  bool found_stun = false;
+  for (size_t i = 0; i < candidates_.size(); ++i) {
+    if (candidates_[i].type() != "stun")
+      continue;
+    found_stun = true;
+    EXPECT_EQ(cricket::ICE_CANDIDATE_COMPONENT_RTCP,
+              candidates_[i].component());
+    EXPECT_EQ(candidates_[0].username(), candidates_[i].username());
+    EXPECT_EQ(kIcePwd0, candidates_[i].password());
+  }
+  EXPECT_TRUE(found_stun);
+  session_->StopGetAllPorts();
+}
+
 TEST_F(PortAllocatorTest, TestSetupVideoRtpPortsWithNormalSendBuffers) {
   AddInterface(kClientAddr);
   EXPECT_TRUE(CreateSession(cricket::ICE_CANDIDATE_COMPONENT_RTP,
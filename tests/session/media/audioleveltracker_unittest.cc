@@ -0,0 +1,113 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/gunit.h"
+#include "session/media/audioleveltracker.h"
+
+using cricket::AudioInfo;
+using cricket::AudioLevelTracker;
+
+static int FindLevel(const AudioInfo::StreamList& streams, uint32 ssrc) {
+  for (size_t i = 0; i < streams.size(); ++i) {
+    if (streams[i].first == ssrc) {
+      return streams[i].second;
+    }
+  }
+  return 0;
+}
+
+TEST(AudioLevelTrackerTest, DbovToLevel) {
+  EXPECT_EQ(9, AudioLevelTracker::DbovToLevel(0));
+  EXPECT_EQ(9, AudioLevelTracker::DbovToLevel(13));
+  EXPECT_EQ(8, AudioLevelTracker::DbovToLevel(14));
+  EXPECT_EQ(5, AudioLevelTracker::DbovToLevel(24));
+  EXPECT_EQ(1, AudioLevelTracker::DbovToLevel(52));
+  EXPECT_EQ(0, AudioLevelTracker::DbovToLevel(53));
+  EXPECT_EQ(0, AudioLevelTracker::DbovToLevel(127));
+}
+
+TEST(AudioLevelTrackerTest, ReportsLoudStreams) {
+  AudioLevelTracker tracker;
+  tracker.OnPacket(1, 10, 1000);
+  tracker.OnPacket(2, 127, 1000);
+  tracker.OnPacket(3, 24, 1000);
+  EXPECT_EQ(3U, tracker.size());
+
+  AudioInfo::StreamList streams;
+  tracker.GetActiveStreams(1000, &streams);
+  EXPECT_EQ(2U, streams.size());
+  EXPECT_EQ(9, FindLevel(streams, 1));
+  EXPECT_EQ(5, FindLevel(streams, 3));
+
+  tracker.RemoveSsrc(1);
+  tracker.GetActiveStreams(1000, &streams);
+  EXPECT_EQ(1U, streams.size());
+  EXPECT_EQ(5, FindLevel(streams, 3));
+}
+
+TEST(AudioLevelTrackerTest, RisesImmediatelyAndDecaysSlowly) {
+  AudioLevelTracker tracker;
+  AudioInfo::StreamList streams;
+  uint32 now = 1000;
+  tracker.OnPacket(1, 127, now);
+  tracker.OnPacket(1, 0, now += 20);
+  tracker.GetActiveStreams(now, &streams);
+  EXPECT_EQ(9, FindLevel(streams, 1));
+
+  // One quiet packet does not silence the stream.
+  tracker.OnPacket(1, 127, now += 20);
+  tracker.GetActiveStreams(now, &streams);
+  EXPECT_EQ(8, FindLevel(streams, 1));
+
+  // A sustained quiet period does.
+  for (int i = 0; i < 50; ++i) {
+    tracker.OnPacket(1, 127, now += 20);
+  }
+  tracker.GetActiveStreams(now, &streams);
+  EXPECT_TRUE(streams.empty());
+}
+
+TEST(AudioLevelTrackerTest, SilencesAndExpiresStreamsWithoutPackets) {
+  AudioLevelTracker tracker;
+  AudioInfo::StreamList streams;
+  tracker.OnPacket(1, 0, 1000);
+  tracker.GetActiveStreams(1000 + AudioLevelTracker::kStaleStreamMs, &streams);
+  EXPECT_EQ(9, FindLevel(streams, 1));
+  tracker.GetActiveStreams(1001 + AudioLevelTracker::kStaleStreamMs, &streams);
+  EXPECT_TRUE(streams.empty());
+  EXPECT_EQ(1U, tracker.size());
+
+  // A stream that comes back after a gap starts from its new level.
+  tracker.OnPacket(1, 24, 2000);
+  tracker.GetActiveStreams(2000, &streams);
+  EXPECT_EQ(5, FindLevel(streams, 1));
+
+  tracker.GetActiveStreams(2001 + AudioLevelTracker::kExpireStreamMs,
+                           &streams);
+  EXPECT_TRUE(streams.empty());
+  EXPECT_EQ(0U, tracker.size());
+}
@@ -1819,7 +1819,77 @@ class VoiceChannelTest
   typedef ChannelTest<VoiceTraits>
   Base;
   VoiceChannelTest() : Base(kPcmuFrame, sizeof(kPcmuFrame),
-                            kRtcpReport, sizeof(kRtcpReport)) {
+                            kRtcpReport, sizeof(kRtcpReport)),
+                       audio_info_callbacks_(0) {
+  }
+
+  void OnAudioMonitor(cricket::VoiceChannel* channel,
+                      const cricket::AudioInfo& info) {
+    audio_info_ = info;
+    ++audio_info_callbacks_;
+  }
+
+  // Sends a PCMU packet from |ssrc| carrying |dbov| in the audio level header
+  // extension with id |id|.
+  bool SendAudioLevelRtp1(uint32 ssrc, int id, int dbov) {
+    const uint8 extension[] = {
+      0xBE, 0xDE, 0x00, 0x01, static_cast<uint8>(id << 4),
+      static_cast<uint8>(0x80 | dbov), 0x00, 0x00
+    };
+    std::string data(kPcmuFrame, kPcmuFrame + 12);
+    data.append(reinterpret_cast<const char*>(extension), sizeof(extension));
+    data.append(kPcmuFrame + 12, kPcmuFrame + sizeof(kPcmuFrame));
+    data[0] |= 0x10;
+    talk_base::SetBE32(const_cast<char*>(data.c_str()) + 8, ssrc);
+    return media_channel1_->SendRtp(data.c_str(), data.size());
+  }
+
+  void TestRtpAudioLevelMonitor() {
+    CreateChannels(0, 0);
+    // Only channel2 receives with the extension.
+    local_media_content2_.AddRtpHeaderExtension(cricket::RtpHeaderExtension(
+        cricket::kRtpAudioLevelHeaderExtension, 3));
+    EXPECT_TRUE(SendInitiate());
+    EXPECT_TRUE(SendAccept());
+    channel2_->SignalAudioMonitor.connect(
+        this, &VoiceChannelTest::OnAudioMonitor);
+
+    // Nothing is reported until the monitor is started.
+    EXPECT_TRUE(SendAudioLevelRtp1(1, 3, 10));
+    talk_base::Thread::Current()->ProcessMessages(0);
+    EXPECT_EQ(0, audio_info_callbacks_);
+
+    EXPECT_FALSE(channel2_->IsRtpAudioLevelMonitorRunning());
+    channel2_->StartRtpAudioLevelMonitor(20);
+    EXPECT_TRUE(channel2_->IsRtpAudioLevelMonitorRunning());
+    talk_base::Thread::SleepMs(25);
+    EXPECT_TRUE(SendAudioLevelRtp1(1, 3, 127));
+    talk_base::Thread::Current()->ProcessMessages(0);
+    EXPECT_EQ(1, audio_info_callbacks_);
+    EXPECT_TRUE(audio_info_.active_streams.empty());
+
+    // Levels keep being tracked between reports, while elements with another
+    // id are ignored.
+    EXPECT_TRUE(SendAudioLevelRtp1(2, 3, 10));
+    EXPECT_TRUE(SendAudioLevelRtp1(3, 4, 10));
+    talk_base::Thread::SleepMs(25);
+    EXPECT_TRUE(SendAudioLevelRtp1(1, 3, 24));
+    talk_base::Thread::Current()->ProcessMessages(0);
+    EXPECT_EQ(2, audio_info_callbacks_);
+    ASSERT_EQ(2U, audio_info_.active_streams.size());
+    EXPECT_EQ(9, audio_info_.output_level);
+
+    // Streams that stop sending drop out without any further packets.
+    EXPECT_TRUE_WAIT(audio_info_.active_streams.empty(), 1000);
+    EXPECT_EQ(0, audio_info_.output_level);
+
+    // Nothing is reported once the monitor is stopped.
+    channel2_->StopRtpAudioLevelMonitor();
+    EXPECT_FALSE(channel2_->IsRtpAudioLevelMonitorRunning());
+    const int callbacks = audio_info_callbacks_;
+    EXPECT_TRUE(SendAudioLevelRtp1(1, 3, 10));
+    talk_base::Thread::Current()->ProcessMessages(50);
+    EXPECT_EQ(callbacks, audio_info_callbacks_);
   }
 
   void TestSetChannelOptions() {
@@ -1845,6 +1915,10 @@ class VoiceChannelTest
     ASSERT_TRUE(media_channel2_->GetOptions(&actual_options));
     EXPECT_EQ(options2, actual_options);
   }
+
+ private:
+  cricket::AudioInfo audio_info_;
+  int audio_info_callbacks_;
 };
 
 // override to add NULL parameter
@@ -2083,6 +2157,11 @@ TEST_F(VoiceChannelTest, TestMediaMonitor) {
   Base::TestMediaMonitor();
 }
 
+// Test that received audio levels are reported from the header extension.
+TEST_F(VoiceChannelTest, TestRtpAudioLevelMonitor) {
+  TestRtpAudioLevelMonitor();
+}
+
 // Test that MuteStream properly forwards to the media channel and does
 // not signal.
 TEST_F(VoiceChannelTest, TestVoiceSpecificMuteStream) {
@@ -0,0 +1,128 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/gunit.h"
+#include "base/scoped_ptr.h"
+#include "base/thread.h"
+#include "session/media/channelstats.h"
+
+using cricket::ChannelCounters;
+using cricket::ChannelStatsRegistry;
+using cricket::ChannelStatsSnapshot;
+
+static bool FindSnapshot(const std::string& name,
+                         ChannelStatsSnapshot* snapshot) {
+  std::vector<ChannelStatsSnapshot> snapshots;
+  ChannelStatsRegistry::Instance()->GetSnapshots(&snapshots);
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    if (snapshots[i].content_name == name) {
+      *snapshot = snapshots[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(ChannelStatsTest, CountsPackets) {
+  ChannelCounters counters("audio");
+  counters.OnPacketSent(100, false);
+  counters.OnPacketSent(50, true);
+  counters.OnPacketReceived(200, false);
+  counters.OnPacketReceived(200, false);
+  counters.OnPacketReceived(60, true);
+  counters.OnPacketDiscarded();
+
+  ChannelStatsSnapshot snapshot;
+  counters.GetSnapshot(&snapshot);
+  EXPECT_EQ("audio", snapshot.content_name);
+  EXPECT_EQ(150U, snapshot.bytes_sent);
+  EXPECT_EQ(1U, snapshot.packets_sent);
+  EXPECT_EQ(1U, snapshot.rtcp_packets_sent);
+  EXPECT_EQ(460U, snapshot.bytes_rcvd);
+  EXPECT_EQ(2U, snapshot.packets_rcvd);
+  EXPECT_EQ(1U, snapshot.rtcp_packets_rcvd);
+  EXPECT_EQ(1U, snapshot.packets_discarded);
+}
+
+TEST(ChannelStatsTest, RegistryTracksLiveChannels) {
+  size_t initial = ChannelStatsRegistry::Instance()->size();
+  ChannelStatsSnapshot snapshot;
+  {
+    ChannelCounters audio("audio");
+    ChannelCounters video("video");
+    EXPECT_EQ(initial + 2, ChannelStatsRegistry::Instance()->size());
+
+    video.OnPacketReceived(1000, false);
+    ASSERT_TRUE(FindSnapshot("video", &snapshot));
+    EXPECT_EQ(1000U, snapshot.bytes_rcvd);
+    EXPECT_EQ(1U, snapshot.packets_rcvd);
+
+    video.set_content_name("video2");
+    EXPECT_FALSE(FindSnapshot("video", &snapshot));
+    EXPECT_TRUE(FindSnapshot("video2", &snapshot));
+  }
+  EXPECT_EQ(initial, ChannelStatsRegistry::Instance()->size());
+  EXPECT_FALSE(FindSnapshot("video2", &snapshot));
+}
+
+// Snapshots taken from another thread must see every update once the writer
+// has finished; no increments may be lost.
+class CounterWriter : public talk_base::Runnable {
+ public:
+  CounterWriter(ChannelCounters* counters, int count)
+      : counters_(counters), count_(count) {}
+  virtual void Run(talk_base::Thread* thread) {
+    for (int i = 0; i < count_; ++i) {
+      counters_->OnPacketSent(10, false);
+    }
+  }
+
+ private:
+  ChannelCounters* counters_;
+  int count_;
+};
+
+TEST(ChannelStatsTest, ConcurrentWriterAndReader) {
+  const int kPackets = 100000;
+  ChannelCounters counters("data");
+  CounterWriter writer(&counters, kPackets);
+  talk_base::Thread thread;
+  thread.Start(&writer);
+
+  ChannelStatsSnapshot snapshot;
+  uint64 last = 0;
+  do {
+    counters.GetSnapshot(&snapshot);
+    EXPECT_GE(snapshot.packets_sent, last);
+    last = snapshot.packets_sent;
+  } while (last < static_cast<uint64>(kPackets));
+  thread.Stop();
+
+  counters.GetSnapshot(&snapshot);
+  EXPECT_EQ(static_cast<uint64>(kPackets), snapshot.packets_sent);
+  EXPECT_EQ(static_cast<uint64>(kPackets) * 10, snapshot.bytes_sent);
+}
@@ -72,6 +72,20 @@ class RtpDumpSinkTest : public testing::Test {
     sink_->OnPacket(buf.Data(), buf.Length(), false);
   }
 
+  void OnRtcpPacket(const RawRtcpPacket& raw) {
+    talk_base::ByteBuffer buf;
+    raw.WriteToByteBuffer(&buf);
+    sink_->OnPacket(buf.Data(), buf.Length(), true);
+  }
+
+  bool VerifyRtcpPacket(const RtpDumpPacket& packet,
+                        const RawRtcpPacket& raw) {
+    talk_base::ByteBuffer buf;
+    raw.WriteToByteBuffer(&buf);
+    return packet.is_rtcp() && packet.data.size() == buf.Length() &&
+        memcmp(&packet.data[0], buf.Data(), buf.Length()) == 0;
+  }
+
   talk_base::StreamResult ReadPacket(RtpDumpPacket* packet) {
     if (!stream_.get()) {
       sink_.reset();  // This will close the file. So we can read it.
@@ -167,6 +181,72 @@ TEST_F(RtpDumpSinkTest, TestRtpDumpSinkFilter) {
   EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
 }
 
+TEST_F(RtpDumpSinkTest, TestRtpDumpSinkRtcp) {
+  sink_->set_packet_filter(PF_ALL);
+  EXPECT_TRUE(sink_->Enable(true));
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[0]);
+  OnRtcpPacket(RtpTestUtility::kTestRawRtcpPackets[0]);
+
+  // With PF_RTPPACKET, RTCP is not recorded.
+  sink_->set_packet_filter(PF_RTPPACKET);
+  OnRtcpPacket(RtpTestUtility::kTestRawRtcpPackets[1]);
+
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[0], false));
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(VerifyRtcpPacket(packet, RtpTestUtility::kTestRawRtcpPackets[0]));
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+}
+
+TEST_F(RtpDumpSinkTest, TestAsyncRtpDumpSink) {
+  EXPECT_TRUE(sink_->SetAsync(AsyncRecordingOptions()));
+  EXPECT_TRUE(sink_->async());
+  sink_->set_packet_filter(PF_ALL);
+  // Not recorded while disabled.
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[0]);
+
+  EXPECT_TRUE(sink_->Enable(true));
+  // Too late to change the mode once enabled.
+  EXPECT_FALSE(sink_->SetAsync(AsyncRecordingOptions()));
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[1]);
+  OnRtcpPacket(RtpTestUtility::kTestRawRtcpPackets[0]);
+  sink_->set_packet_filter(PF_RTPHEADER);
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[2]);
+  sink_->Flush();
+  EXPECT_EQ(0U, sink_->dropped_packets());
+
+  // Reading the file first deletes the sink, which writes out the rest.
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[1], false));
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(VerifyRtcpPacket(packet, RtpTestUtility::kTestRawRtcpPackets[0]));
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[2], true));
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+}
+
+TEST_F(RtpDumpSinkTest, TestAsyncRtpDumpSinkDropsWhenFull) {
+  // A ring too small for any packet: every packet is dropped, none blocks.
+  AsyncRecordingOptions options;
+  options.ring_size = 32;
+  EXPECT_TRUE(sink_->SetAsync(options));
+  sink_->set_packet_filter(PF_ALL);
+  EXPECT_TRUE(sink_->Enable(true));
+  for (int i = 0; i < ARRAY_SIZE(rtp_buf_); ++i) {
+    OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[i]);
+  }
+  EXPECT_EQ(static_cast<uint32>(ARRAY_SIZE(rtp_buf_)),
+            sink_->dropped_packets());
+
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+}
+
 /////////////////////////////////////////////////////////////////////////
 // Test MediaRecorder
 /////////////////////////////////////////////////////////////////////////
@@ -342,6 +422,44 @@ TEST(MediaRecorderTest, TestMediaRecorderVoiceChannel) {
   TestRecordHeaderAndMedia(&channel, NULL);
 }
 
+TEST(MediaRecorderTest, TestAsyncMediaRecorderVoiceChannel) {
+  FakeSession session(true);
+  FakeMediaEngine media_engine;
+  VoiceChannel channel(talk_base::Thread::Current(), &media_engine,
+                       new FakeVoiceMediaChannel(NULL), &session, "", false);
+  EXPECT_TRUE(channel.Init());
+
+  talk_base::scoped_ptr<MediaRecorder> recorder(new MediaRecorder);
+  recorder->EnableAsyncRecording(AsyncRecordingOptions());
+  uint32 send_dropped = 1, recv_dropped = 1;
+  EXPECT_FALSE(recorder->GetDroppedPackets(&channel, &send_dropped,
+                                           &recv_dropped));
+
+  talk_base::Pathname path;
+  EXPECT_TRUE(talk_base::Filesystem::GetTemporaryFolder(path, true, NULL));
+  path.SetFilename("send-async.rtpdump");
+  std::string send_file = path.pathname();
+  path.SetFilename("recv-async.rtpdump");
+  std::string recv_file = path.pathname();
+  EXPECT_TRUE(recorder->AddChannel(&channel, Open(send_file), Open(recv_file),
+                                   PF_ALL));
+  EXPECT_TRUE(recorder->EnableChannel(&channel, true, true, SINK_PRE_CRYPTO));
+  EXPECT_TRUE(channel.HasSendSinks(SINK_PRE_CRYPTO));
+  EXPECT_TRUE(channel.HasRecvSinks(SINK_PRE_CRYPTO));
+  recorder->FlushSinks();
+  EXPECT_TRUE(recorder->GetDroppedPackets(&channel, &send_dropped,
+                                          &recv_dropped));
+  EXPECT_EQ(0U, send_dropped);
+  EXPECT_EQ(0U, recv_dropped);
+
+  recorder->RemoveChannel(&channel, SINK_PRE_CRYPTO);
+  EXPECT_FALSE(channel.HasSendSinks(SINK_PRE_CRYPTO));
+  EXPECT_FALSE(channel.HasRecvSinks(SINK_PRE_CRYPTO));
+  recorder.reset();
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(send_file));
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(recv_file));
+}
+
 TEST(MediaRecorderTest, TestMediaRecorderVideoChannel) {
   // Create the video channel.
   FakeSession session(true);
@@ -58,6 +58,7 @@ using cricket::MediaSessionOptions;
 using cricket::MediaType;
 using cricket::SessionDescription;
 using cricket::SsrcGroup;
+using cricket::kSimSsrcGroupSemantics;
 using cricket::StreamParams;
 using cricket::StreamParamsVec;
 using cricket::TransportDescription;
@@ -992,6 +993,33 @@ TEST_F(MediaSessionDescriptionFactoryTest, TestCreateMultiStreamVideoOffer) {
   EXPECT_EQ(updated_data_streams[0].cname, updated_data_streams[1].cname);
 }
 
+// Create an offer with a video stream sent as three simulcast layers.
+TEST_F(MediaSessionDescriptionFactoryTest, TestCreateSimulcastVideoOffer) {
+  MediaSessionOptions opts;
+  const int num_sim_layers = 3;
+  opts.AddVideoStream(kVideoTrack1, kMediaStream1, num_sim_layers);
+  talk_base::scoped_ptr<SessionDescription> offer(f1_.CreateOffer(opts, NULL));
+
+  ASSERT_TRUE(offer.get() != NULL);
+  const ContentInfo* vc = offer->GetContentByName("video");
+  ASSERT_TRUE(vc != NULL);
+  const VideoContentDescription* vcd =
+      static_cast<const VideoContentDescription*>(vc->description);
+
+  const StreamParamsVec& video_streams = vcd->streams();
+  ASSERT_EQ(1U, video_streams.size());
+  EXPECT_EQ(kVideoTrack1, video_streams[0].name);
+  ASSERT_EQ(static_cast<size_t>(num_sim_layers),
+            video_streams[0].ssrcs.size());
+  const SsrcGroup* sim_group =
+      video_streams[0].get_ssrc_group(kSimSsrcGroupSemantics);
+  ASSERT_TRUE(sim_group != NULL);
+  EXPECT_EQ(video_streams[0].ssrcs, sim_group->ssrcs);
+  EXPECT_NE(video_streams[0].ssrcs[0], video_streams[0].ssrcs[1]);
+  EXPECT_NE(video_streams[0].ssrcs[1], video_streams[0].ssrcs[2]);
+  EXPECT_NE(video_streams[0].ssrcs[0], video_streams[0].ssrcs[2]);
+}
+
 // Create an audio and video answer to a standard video offer with:
 // - one video track
 // - two audio tracks
@@ -0,0 +1,170 @@
+/*
+ * libjingle
+ * Copyright 2013, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/gunit.h"
+#include "base/thread.h"
+#include "base/timeutils.h"
+#include "sound/soundringbuffer.h"
+
+namespace cricket {
+
+TEST(SoundRingBufferTest, WriteAndRead) {
+  SoundRingBuffer ring(8);
+  EXPECT_EQ(8u, ring.capacity());
+  EXPECT_EQ(0u, ring.Size());
+  EXPECT_EQ(8u, ring.Space());
+
+  char out[8];
+  EXPECT_EQ(0u, ring.Read(out, sizeof(out)));
+  EXPECT_TRUE(ring.Write("abcde", 5));
+  EXPECT_EQ(5u, ring.Size());
+  EXPECT_EQ(3u, ring.Space());
+  EXPECT_EQ(3u, ring.Read(out, 3));
+  EXPECT_EQ(0, memcmp("abc", out, 3));
+
+  // Wraps around the end of the storage.
+  EXPECT_TRUE(ring.Write("fghijk", 6));
+  EXPECT_EQ(8u, ring.Size());
+  EXPECT_EQ(8u, ring.Read(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp("defghijk", out, 8));
+  EXPECT_EQ(0u, ring.Size());
+}
+
+TEST(SoundRingBufferTest, WriteIsAllOrNothing) {
+  SoundRingBuffer ring(8);
+  EXPECT_TRUE(ring.Write("abcdef", 6));
+  EXPECT_FALSE(ring.Write("ghi", 3));
+  EXPECT_EQ(6u, ring.Size());
+  EXPECT_TRUE(ring.Write("gh", 2));
+  EXPECT_FALSE(ring.Write("i", 1));
+
+  char out[8];
+  EXPECT_EQ(8u, ring.Read(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp("abcdefgh", out, 8));
+}
+
+// Writes a counting sequence of 16-bit samples in blocks, retrying whenever
+// the ring is full.
+class SampleWriter : public talk_base::Runnable {
+ public:
+  SampleWriter(SoundRingBuffer* ring, int samples)
+      : ring_(ring), samples_(samples) {}
+  virtual void Run(talk_base::Thread* thread) {
+    const int kBlock = 37;
+    int16 block[kBlock];
+    int next = 0;
+    while (next < samples_) {
+      int count = talk_base::_min(kBlock, samples_ - next);
+      for (int i = 0; i < count; ++i) {
+        block[i] = static_cast<int16>(next + i);
+      }
+      if (ring_->Write(block, count * sizeof(int16))) {
+        next += count;
+      }
+    }
+  }
+
+ private:
+  SoundRingBuffer* ring_;
+  int samples_;
+};
+
+// The consumer must see every sample exactly once and in order.
+TEST(SoundRingBufferTest, ConcurrentWriterAndReader) {
+  const int kSamples = 100000;
+  // Not a multiple of the block size, so writes wrap at varying offsets.
+  SoundRingBuffer ring(1000);
+  SampleWriter writer(&ring, kSamples);
+  talk_base::Thread thread;
+  thread.Start(&writer);
+
+  std::vector<int16> samples(64);
+  int next = 0;
+  bool in_order = true;
+  while (next < kSamples && in_order) {
+    size_t read = ring.Read(&samples[0], samples.size() * sizeof(int16));
+    // Writes are whole samples, so reads of whole samples stay aligned.
+    ASSERT_EQ(0u, read % sizeof(int16));
+    for (size_t i = 0; i < read / sizeof(int16); ++i, ++next) {
+      if (samples[i] != static_cast<int16>(next)) {
+        in_order = false;
+        break;
+      }
+    }
+  }
+  thread.Stop();
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(kSamples, next);
+  EXPECT_EQ(0u, ring.Size());
+}
+
+TEST(SoundStreamMonitorTest, CallbackTiming) {
+  SoundStreamMonitor monitor;
+  SoundStreamStats stats;
+  monitor.GetStats(&stats);
+  EXPECT_EQ(0u, stats.callbacks);
+  EXPECT_EQ(0, stats.mean_callback_interval_usecs);
+
+  const uint64 kMs = talk_base::kNumNanosecsPerMillisec;
+  monitor.OnCallback(1000 * kMs);
+  monitor.OnCallback(1010 * kMs);
+  monitor.GetStats(&stats);
+  EXPECT_EQ(2u, stats.callbacks);
+  EXPECT_EQ(10000, stats.mean_callback_interval_usecs);
+  EXPECT_EQ(10000, stats.max_callback_interval_usecs);
+  EXPECT_EQ(0, stats.callback_jitter_usecs);
+
+  // A steady interval adds no jitter; a late callback moves the estimates by
+  // 1/16 of its error.
+  monitor.OnCallback(1020 * kMs);
+  monitor.OnCallback(1035 * kMs);
+  monitor.GetStats(&stats);
+  EXPECT_EQ(4u, stats.callbacks);
+  EXPECT_EQ(10000 + 5000 / 16, stats.mean_callback_interval_usecs);
+  EXPECT_EQ(15000, stats.max_callback_interval_usecs);
+  EXPECT_EQ(5000 / 16, stats.callback_jitter_usecs);
+}
+
+TEST(SoundStreamMonitorTest, UnderrunsAndOverruns) {
+  SoundStreamMonitor monitor;
+  monitor.OnUnderrun();
+  monitor.OnOverrun();
+  monitor.OnOverrun();
+  SoundStreamStats stats;
+  monitor.GetStats(&stats);
+  EXPECT_EQ(1u, stats.underruns);
+  EXPECT_EQ(2u, stats.overruns);
+  // The monitor leaves the buffer sizes to the stream.
+  EXPECT_EQ(0u, stats.buffered_bytes);
+  EXPECT_EQ(0u, stats.capacity_bytes);
+}
+
+}  // namespace cricket